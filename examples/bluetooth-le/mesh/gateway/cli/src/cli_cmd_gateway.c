@@ -12,6 +12,7 @@
 
 #include "types.h"
 #include "util_string.h"
+#include "cli_args.h"
 
 #include "cli.h"
 #include "shell.h"
@@ -57,6 +58,17 @@ typedef struct
     uint8_t      device_key[16];
 } prov_device;
 
+typedef struct
+{
+    uint16_t     address;
+    uint16_t     ele_address;
+    uint16_t     sub_address;
+    uint32_t     model;
+    uint32_t     key[4];
+    uint16_t     level;
+    uint8_t      value;
+} cli_mesh_args_t;
+
 //=============================================================================
 //                  Global Data Definition
 //=============================================================================
@@ -66,6 +78,58 @@ uint8_t auto_provision = false;
 unprov_device unprov_device_list[MAX_UNPROV_DEVICE_NUM];
 prov_device prov_device_list[MAX_PROV_DEVICE_NUM] = {0};
 
+static const cli_arg_t g_provision_args[] =
+{
+    CLI_ARG_NUM(cli_mesh_args_t, value, CLI_ARG_U8, 0, 1, "start"),
+};
+
+static const cli_arg_t g_devkey_args[] =
+{
+    CLI_ARG_NUM(cli_mesh_args_t, address, CLI_ARG_U16, 0x0001, 0x7FFF, "address"),
+    CLI_ARG_NUM(cli_mesh_args_t, key[0], CLI_ARG_U32, 0, 0xFFFFFFFF, "key"),
+    CLI_ARG_NUM(cli_mesh_args_t, key[1], CLI_ARG_U32, 0, 0xFFFFFFFF, "key"),
+    CLI_ARG_NUM(cli_mesh_args_t, key[2], CLI_ARG_U32, 0, 0xFFFFFFFF, "key"),
+    CLI_ARG_NUM(cli_mesh_args_t, key[3], CLI_ARG_U32, 0, 0xFFFFFFFF, "key"),
+};
+
+static const cli_arg_t g_compget_args[] =
+{
+    CLI_ARG_NUM(cli_mesh_args_t, address, CLI_ARG_U16, 0x0001, 0x7FFF, "address"),
+    CLI_ARG_NUM(cli_mesh_args_t, value, CLI_ARG_U8, 0, 0xFF, "page num"),
+};
+
+static const cli_arg_t g_subscribe_args[] =
+{
+    CLI_ARG_NUM(cli_mesh_args_t, address, CLI_ARG_U16, 0x0001, 0x7FFF, "dst address"),
+    CLI_ARG_NUM(cli_mesh_args_t, ele_address, CLI_ARG_U16, 0x0001, 0x7FFF, "element address"),
+    CLI_ARG_NUM(cli_mesh_args_t, sub_address, CLI_ARG_U16, 0x0000, 0xFFFF, "address"),
+    CLI_ARG_NUM(cli_mesh_args_t, model, CLI_ARG_U32, 0, 0xFFFFFFFF, "model ID"),
+};
+
+static const cli_arg_t g_node_args[] =
+{
+    CLI_ARG_NUM(cli_mesh_args_t, address, CLI_ARG_U16, 0x0001, 0x7FFF, "address"),
+};
+
+static const cli_arg_t g_model_bind_args[] =
+{
+    CLI_ARG_NUM(cli_mesh_args_t, address, CLI_ARG_U16, 0x0001, 0x7FFF, "address"),
+    CLI_ARG_NUM(cli_mesh_args_t, model, CLI_ARG_U32, 0, 0xFFFFFFFF, "model id"),
+};
+
+static const cli_arg_t g_onoff_args[] =
+{
+    CLI_ARG_NUM(cli_mesh_args_t, address, CLI_ARG_U16, 0x0001, 0xFFFF, "address"),
+    CLI_ARG_NUM(cli_mesh_args_t, value, CLI_ARG_U8, 0, 1, "onoffstatus"),
+};
+
+/* level is signed, taken as -32768..32767 or as its 16-bit pattern 0x8000..0x7fff */
+static const cli_arg_t g_level_args[] =
+{
+    CLI_ARG_NUM(cli_mesh_args_t, address, CLI_ARG_U16, 0x0001, 0xFFFF, "address"),
+    CLI_ARG_NUM(cli_mesh_args_t, level, CLI_ARG_U16, -32768, 0xFFFF, "levelstatus"),
+};
+
 //=============================================================================
 //                  Private Function Definition
 //=============================================================================
@@ -88,20 +152,15 @@ static void _memcpy_inv(uint8_t *pDst, uint8_t *pSrc, uint16_t len)
 
 static int _cli_cmd_provision_all_device(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
 {
-    uint8_t enable;
+    cli_mesh_args_t args;
 
     do
     {
-        if (argc < 2)
+        if (cli_args_parse(argc - 1, argv + 1, g_provision_args, CLI_ARGS_COUNT(g_provision_args), &args) != 0)
         {
-            printf("Invalid parameter\n");
             break;
         }
-
-        enable = (*(argv[1] + 1) == 'x')
-                 ? utility_strtox(argv[1] + 2, 0, 2)
-                 : utility_strtol(argv[1], 0);
-        if (enable)
+        if (args.value)
         {
             ble_mesh_find_unprov_device_start();
             auto_provision = true;
@@ -122,44 +181,23 @@ static int _cli_cmd_provision_all_device(int argc, char **argv, cb_shell_out_t l
 
 static int _cli_cmd_device_key_set(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
 {
-    uint16_t address, i;
-    uint32_t key1, key2, key3, key4;
+    cli_mesh_args_t args;
+    uint16_t i;
     do
     {
-        if (argc < 6)
+        if (cli_args_parse(argc - 1, argv + 1, g_devkey_args, CLI_ARGS_COUNT(g_devkey_args), &args) != 0)
         {
-            printf("Invalid parameter\n");
             break;
         }
-
-        address = (*(argv[1] + 1) == 'x')
-                  ? utility_strtox(argv[1] + 2, 0, 8)
-                  : utility_strtol(argv[1], 0);
-
-        key1 = (*(argv[2] + 1) == 'x')
-               ? utility_strtox(argv[2] + 2, 0, 8)
-               : utility_strtol(argv[2], 0);
-
-        key2 = (*(argv[3] + 1) == 'x')
-               ? utility_strtox(argv[3] + 2, 0, 8)
-               : utility_strtol(argv[3], 0);
-
-        key3 = (*(argv[4] + 1) == 'x')
-               ? utility_strtox(argv[4] + 2, 0, 8)
-               : utility_strtol(argv[4], 0);
-
-        key4 = (*(argv[5] + 1) == 'x')
-               ? utility_strtox(argv[5] + 2, 0, 8)
-               : utility_strtol(argv[5], 0);
         for (i = 0; i < MAX_PROV_DEVICE_NUM; i++)
         {
             if (prov_device_list[i].primary_addr == 0)
             {
-                prov_device_list[i].primary_addr = address;
-                _memcpy_inv(prov_device_list[i].device_key, (uint8_t *)&key1, sizeof(key1));
-                _memcpy_inv(prov_device_list[i].device_key + 4, (uint8_t *)&key2, sizeof(key2));
-                _memcpy_inv(prov_device_list[i].device_key + 8, (uint8_t *)&key3, sizeof(key3));
-                _memcpy_inv(prov_device_list[i].device_key + 12, (uint8_t *)&key4, sizeof(key4));
+                prov_device_list[i].primary_addr = args.address;
+                _memcpy_inv(prov_device_list[i].device_key, (uint8_t *)&args.key[0], sizeof(args.key[0]));
+                _memcpy_inv(prov_device_list[i].device_key + 4, (uint8_t *)&args.key[1], sizeof(args.key[0]));
+                _memcpy_inv(prov_device_list[i].device_key + 8, (uint8_t *)&args.key[2], sizeof(args.key[0]));
+                _memcpy_inv(prov_device_list[i].device_key + 12, (uint8_t *)&args.key[3], sizeof(args.key[0]));
                 printf("device key set success\n");
                 break;
             }
@@ -175,33 +213,24 @@ static int _cli_cmd_device_key_set(int argc, char **argv, cb_shell_out_t log_out
 
 static int _cli_cmd_device_composition_data_get(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
 {
-    uint16_t address, i;
-    uint8_t page_num;
+    cli_mesh_args_t args;
+    uint16_t i;
 
     do
     {
-        if (argc < 3)
+        if (cli_args_parse(argc - 1, argv + 1, g_compget_args, CLI_ARGS_COUNT(g_compget_args), &args) != 0)
         {
-            printf("Invalid parameter\n");
             break;
         }
 
-        address = (*(argv[1] + 1) == 'x')
-                  ? utility_strtox(argv[1] + 2, 0, 4)
-                  : utility_strtol(argv[1], 0);
-
-        page_num = (*(argv[2] + 1) == 'x')
-                   ? utility_strtox(argv[2] + 2, 0, 2)
-                   : utility_strtol(argv[2], 0);
-
-        printf("Get node 0x%04x composition data\n", address);
+        printf("Get node 0x%04x composition data\n", args.address);
         for (i = 0; i < MAX_PROV_DEVICE_NUM; i++)
         {
-            if (prov_device_list[i].primary_addr == address)
+            if (prov_device_list[i].primary_addr == args.address)
             {
                 pib_device_key_set(prov_device_list[i].device_key);
 
-                cfgmdl_client_send(CONFIG_COMPOSITION_DATA_GET, address, &page_num, sizeof(uint8_t));
+                cfgmdl_client_send(CONFIG_COMPOSITION_DATA_GET, args.address, &args.value, sizeof(uint8_t));
                 break;
             }
         }
@@ -217,49 +246,32 @@ static int _cli_cmd_device_composition_data_get(int argc, char **argv, cb_shell_
 
 static int _cli_cmd_device_subscribe_list_delete(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
 {
-    uint16_t primary_address, ele_address, address, i;
-    uint32_t model;
+    cli_mesh_args_t args;
+    uint16_t i;
     uint8_t sub_list_del[8], mdl_len = 2;
 
     do
     {
-        if (argc < 5)
+        if (cli_args_parse(argc - 1, argv + 1, g_subscribe_args, CLI_ARGS_COUNT(g_subscribe_args), &args) != 0)
         {
-            printf("Invalid parameter\n");
             break;
         }
 
-        primary_address = (*(argv[1] + 1) == 'x')
-                          ? utility_strtox(argv[1] + 2, 0, 4)
-                          : utility_strtol(argv[1], 0);
-
-        ele_address = (*(argv[2] + 1) == 'x')
-                      ? utility_strtox(argv[2] + 2, 0, 4)
-                      : utility_strtol(argv[2], 0);
-
-        address = (*(argv[3] + 1) == 'x')
-                  ? utility_strtox(argv[3] + 2, 0, 4)
-                  : utility_strtol(argv[3], 0);
-
-        model = (*(argv[4] + 1) == 'x')
-                ? utility_strtox(argv[4] + 2, 0, 8)
-                : utility_strtol(argv[4], 0);
-
-        if (model > 0xFFFF)
+        if (args.model > 0xFFFF)
         {
             mdl_len = 4;
         }
-        printf("Model 0x%08x of element 0x%04x delete subscribe address 0x%04x\n", model, ele_address, address);
-        memcpy(sub_list_del, (uint8_t *)&ele_address, sizeof(uint16_t));
-        memcpy(sub_list_del + 2, (uint8_t *)&address, sizeof(uint16_t));
-        memcpy(sub_list_del + 4, (uint8_t *)&model, mdl_len);
+        printf("Model 0x%08x of element 0x%04x delete subscribe address 0x%04x\n", args.model, args.ele_address, args.sub_address);
+        memcpy(sub_list_del, (uint8_t *)&args.ele_address, sizeof(uint16_t));
+        memcpy(sub_list_del + 2, (uint8_t *)&args.sub_address, sizeof(uint16_t));
+        memcpy(sub_list_del + 4, (uint8_t *)&args.model, mdl_len);
         for (i = 0; i < MAX_PROV_DEVICE_NUM; i++)
         {
-            if (prov_device_list[i].primary_addr == primary_address)
+            if (prov_device_list[i].primary_addr == args.address)
             {
                 pib_device_key_set(prov_device_list[i].device_key);
 
-                cfgmdl_client_send(CONFIG_MDL_SUBSCRIPTION_DELETE, primary_address, sub_list_del, 4 + mdl_len);
+                cfgmdl_client_send(CONFIG_MDL_SUBSCRIPTION_DELETE, args.address, sub_list_del, 4 + mdl_len);
                 break;
             }
         }
@@ -275,49 +287,32 @@ static int _cli_cmd_device_subscribe_list_delete(int argc, char **argv, cb_shell
 
 static int _cli_cmd_device_subscribe_list_add(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
 {
-    uint16_t primary_address, ele_address, address, i;
-    uint32_t model;
+    cli_mesh_args_t args;
+    uint16_t i;
     uint8_t sub_list_add[8], mdl_len = 2;
 
     do
     {
-        if (argc < 5)
+        if (cli_args_parse(argc - 1, argv + 1, g_subscribe_args, CLI_ARGS_COUNT(g_subscribe_args), &args) != 0)
         {
-            printf("Invalid parameter\n");
             break;
         }
 
-        primary_address = (*(argv[1] + 1) == 'x')
-                          ? utility_strtox(argv[1] + 2, 0, 4)
-                          : utility_strtol(argv[1], 0);
-
-        ele_address = (*(argv[2] + 1) == 'x')
-                      ? utility_strtox(argv[2] + 2, 0, 4)
-                      : utility_strtol(argv[2], 0);
-
-        address = (*(argv[3] + 1) == 'x')
-                  ? utility_strtox(argv[3] + 2, 0, 4)
-                  : utility_strtol(argv[3], 0);
-
-        model = (*(argv[4] + 1) == 'x')
-                ? utility_strtox(argv[4] + 2, 0, 8)
-                : utility_strtol(argv[4], 0);
-
-        if (model > 0xFFFF)
+        if (args.model > 0xFFFF)
         {
             mdl_len = 4;
         }
-        printf("Model 0x%08x of element 0x%04x add subscribe address 0x%04x\n", model, ele_address, address);
-        memcpy(sub_list_add, (uint8_t *)&ele_address, sizeof(uint16_t));
-        memcpy(sub_list_add + 2, (uint8_t *)&address, sizeof(uint16_t));
-        memcpy(sub_list_add + 4, (uint8_t *)&model, mdl_len);
+        printf("Model 0x%08x of element 0x%04x add subscribe address 0x%04x\n", args.model, args.ele_address, args.sub_address);
+        memcpy(sub_list_add, (uint8_t *)&args.ele_address, sizeof(uint16_t));
+        memcpy(sub_list_add + 2, (uint8_t *)&args.sub_address, sizeof(uint16_t));
+        memcpy(sub_list_add + 4, (uint8_t *)&args.model, mdl_len);
         for (i = 0; i < MAX_PROV_DEVICE_NUM; i++)
         {
-            if (prov_device_list[i].primary_addr == primary_address)
+            if (prov_device_list[i].primary_addr == args.address)
             {
                 pib_device_key_set(prov_device_list[i].device_key);
 
-                cfgmdl_client_send(CONFIG_MDL_SUBSCRIPTION_ADD, primary_address, sub_list_add, 4 + mdl_len);
+                cfgmdl_client_send(CONFIG_MDL_SUBSCRIPTION_ADD, args.address, sub_list_add, 4 + mdl_len);
                 break;
             }
         }
@@ -333,33 +328,29 @@ static int _cli_cmd_device_subscribe_list_add(int argc, char **argv, cb_shell_ou
 
 static int _cli_cmd_app_key_add(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
 {
-    uint16_t address, i;
+    cli_mesh_args_t args;
+    uint16_t i;
     uint32_t index = 0;
     uint8_t app_key_add[19];
 
     do
     {
-        if (argc < 2)
+        if (cli_args_parse(argc - 1, argv + 1, g_node_args, CLI_ARGS_COUNT(g_node_args), &args) != 0)
         {
-            printf("Invalid parameter\n");
             break;
         }
 
-        address = (*(argv[1] + 1) == 'x')
-                  ? utility_strtox(argv[1] + 2, 0, 4)
-                  : utility_strtol(argv[1], 0);
-
-        printf("add app key to node 0x%04x\n", address);
+        printf("add app key to node 0x%04x\n", args.address);
         for (i = 0; i < MAX_PROV_DEVICE_NUM; i++)
         {
-            if (prov_device_list[i].primary_addr == address)
+            if (prov_device_list[i].primary_addr == args.address)
             {
                 pib_device_key_set(prov_device_list[i].device_key);
 
                 if (pib_local_app_key_get_by_idx(index, &app_key_add[3]) == true)
                 {
                     memcpy(app_key_add, (uint8_t *)&index, 3);
-                    cfgmdl_client_send(CONFIG_APPKEY_ADD, address, app_key_add, sizeof(app_key_add));
+                    cfgmdl_client_send(CONFIG_APPKEY_ADD, args.address, app_key_add, sizeof(app_key_add));
                 }
                 else
                 {
@@ -383,44 +374,36 @@ static int _cli_cmd_app_key_add(int argc, char **argv, cb_shell_out_t log_out, v
 
 static int _cli_cmd_model_app_bind(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
 {
-    uint16_t address, i;
-    uint32_t index = 0, model_id;
+    cli_mesh_args_t args;
+    uint16_t i;
+    uint32_t index = 0;
     uint8_t *p_data, model_len = 2;
 
     do
     {
-        if (argc < 3)
+        if (cli_args_parse(argc - 1, argv + 1, g_model_bind_args, CLI_ARGS_COUNT(g_model_bind_args), &args) != 0)
         {
-            printf("Invalid parameter\n");
             break;
         }
 
-        address = (*(argv[1] + 1) == 'x')
-                  ? utility_strtox(argv[1] + 2, 0, 4)
-                  : utility_strtol(argv[1], 0);
-
-        model_id = (*(argv[2] + 1) == 'x')
-                   ? utility_strtox(argv[2] + 2, 0, 8)
-                   : utility_strtol(argv[2], 0);
-
-        if (model_id > 0xFFFF)
+        if (args.model > 0xFFFF)
         {
             model_len = 4;
         }
         p_data = pvPortMalloc(4 + model_len);
 
-        memcpy(p_data, (uint8_t *)&address, 2);
+        memcpy(p_data, (uint8_t *)&args.address, 2);
         memcpy(p_data + 2, (uint8_t *)&index, 2);
-        memcpy(p_data + 4, (uint8_t *)&model_id, model_len);
+        memcpy(p_data + 4, (uint8_t *)&args.model, model_len);
 
-        printf("bind device 0x%04x's app key to model 0x%04x\n", address, model_id);
+        printf("bind device 0x%04x's app key to model 0x%04x\n", args.address, args.model);
 
         for (i = 0; i < MAX_PROV_DEVICE_NUM; i++)
         {
-            if (prov_device_list[i].primary_addr == address)
+            if (prov_device_list[i].primary_addr == args.address)
             {
                 pib_device_key_set(prov_device_list[i].device_key);
-                cfgmdl_client_send(CONFIG_MDL_APP_BIND, address, p_data, 4 + model_len);
+                cfgmdl_client_send(CONFIG_MDL_APP_BIND, args.address, p_data, 4 + model_len);
                 break;
             }
         }
@@ -437,27 +420,18 @@ static int _cli_cmd_model_app_bind(int argc, char **argv, cb_shell_out_t log_out
 
 static int _cli_cmd_onoff_set(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
 {
-    uint16_t address;
-    uint8_t onoff, data[2], key_idx = 0;
+    cli_mesh_args_t args;
+    uint8_t data[2], key_idx = 0;
     static uint8_t tid = 1;
 
     do
     {
-        if (argc < 3)
+        if (cli_args_parse(argc - 1, argv + 1, g_onoff_args, CLI_ARGS_COUNT(g_onoff_args), &args) != 0)
         {
-            printf("Invalid parameter\n");
             break;
         }
 
-        address = (*(argv[1] + 1) == 'x')
-                  ? utility_strtox(argv[1] + 2, 0, 4)
-                  : utility_strtol(argv[1], 0);
-
-        onoff = (*(argv[2] + 1) == 'x')
-                ? utility_strtox(argv[2] + 2, 0, 2)
-                : utility_strtol(argv[2], 0);
-
-        data[0] = onoff;
+        data[0] = args.value;
         data[1] = tid;
         tid++;
         if (tid == 0)
@@ -465,8 +439,8 @@ static int _cli_cmd_onoff_set(int argc, char **argv, cb_shell_out_t log_out, voi
             tid = 1;
         }
 
-        printf("set onoff status %d to node 0x%04x\n", onoff, address);
-        mmdl_client_send(address, pib_primary_address_get(), BE2LE16(MMDL_GEN_ONOFF_SET_OPCODE), key_idx, sizeof(data), data);
+        printf("set onoff status %d to node 0x%04x\n", args.value, args.address);
+        mmdl_client_send(args.address, pib_primary_address_get(), BE2LE16(MMDL_GEN_ONOFF_SET_OPCODE), key_idx, sizeof(data), data);
     } while (0);
 
     return 0;
@@ -475,36 +449,27 @@ static int _cli_cmd_onoff_set(int argc, char **argv, cb_shell_out_t log_out, voi
 
 static int _cli_cmd_level_set(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
 {
-    uint16_t address, level;
+    cli_mesh_args_t args;
     uint8_t data[3], key_idx = 0;
     static uint8_t tid = 1;
 
     do
     {
-        if (argc < 3)
+        if (cli_args_parse(argc - 1, argv + 1, g_level_args, CLI_ARGS_COUNT(g_level_args), &args) != 0)
         {
-            printf("Invalid parameter\n");
             break;
         }
 
-        address = (*(argv[1] + 1) == 'x')
-                  ? utility_strtox(argv[1] + 2, 0, 4)
-                  : utility_strtol(argv[1], 0);
-
-        level = (*(argv[2] + 1) == 'x')
-                ? utility_strtox(argv[2] + 2, 0, 4)
-                : utility_strtol(argv[2], 0);
-
-        data[0] = (level & 0xFF);
-        data[1] = ((level >> 8) & 0xFF);
+        data[0] = (args.level & 0xFF);
+        data[1] = ((args.level >> 8) & 0xFF);
         data[2] = tid;
         tid++;
         if (tid == 0)
         {
             tid = 1;
         }
-        printf("set level status %d to node 0x%04x\n", level, address);
-        mmdl_client_send(address, pib_primary_address_get(), BE2LE16(MMDL_GEN_LEVEL_SET_OPCODE), key_idx, sizeof(data), data);
+        printf("set level status %d to node 0x%04x\n", (int16_t)args.level, args.address);
+        mmdl_client_send(args.address, pib_primary_address_get(), BE2LE16(MMDL_GEN_LEVEL_SET_OPCODE), key_idx, sizeof(data), data);
     } while (0);
 
     return 0;
@@ -513,28 +478,24 @@ static int _cli_cmd_level_set(int argc, char **argv, cb_shell_out_t log_out, voi
 
 static int _cli_cmd_node_reset(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
 {
-    uint16_t address, i;
+    cli_mesh_args_t args;
+    uint16_t i;
 
     do
     {
-        if (argc < 2)
+        if (cli_args_parse(argc - 1, argv + 1, g_node_args, CLI_ARGS_COUNT(g_node_args), &args) != 0)
         {
-            printf("Invalid parameter\n");
             break;
         }
 
-        address = (*(argv[1] + 1) == 'x')
-                  ? utility_strtox(argv[1] + 2, 0, 4)
-                  : utility_strtol(argv[1], 0);
-
-        printf("Node reset command send to 0x%04x\n", address);
+        printf("Node reset command send to 0x%04x\n", args.address);
         for (i = 0; i < MAX_PROV_DEVICE_NUM; i++)
         {
-            if (prov_device_list[i].primary_addr == address)
+            if (prov_device_list[i].primary_addr == args.address)
             {
                 pib_device_key_set(prov_device_list[i].device_key);
 
-                cfgmdl_client_send(CONFIG_NODE_RESET, address, NULL, 0);
+                cfgmdl_client_send(CONFIG_NODE_RESET, args.address, NULL, 0);
                 prov_device_list[i].primary_addr = 0;
                 break;
             }
@@ -19,6 +19,7 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "queue.h"
+#include "rtos_pool.h"
 #include "uart_handler.h"
 #include "hosal_uart.h"
 #include "mcu.h"
@@ -27,6 +28,7 @@
 //=============================================================================
 #define UART_HANDLER_RX_CACHE_SIZE          16
 #define MAX_UART_BUFFER_SIZE                256
+#define UART_HANDLER_RX_BLOCKS              10
 //=============================================================================
 //                Private ENUM
 //=============================================================================
@@ -43,7 +45,7 @@ typedef struct
 typedef struct
 {
     uint8_t len;
-    uint8_t data[8];
+    uint8_t data[UART_HANDLER_RX_CACHE_SIZE];
 } uart_rx_msg_t;
 //=============================================================================
 //                Private Function Declaration
@@ -56,6 +58,10 @@ static uart_handler_parm_t uart_parm;
 static uint8_t uart_buf[MAX_UART_BUFFER_SIZE] = { 0 };
 static QueueHandle_t uart_msg_q;
 static QueueHandle_t uart_rx_q;
+/* RX chunks are filled in the interrupt and passed to the task by pointer */
+static uint8_t uart_rx_storage[RTOS_POOL_STORAGE_SIZE(sizeof(uart_rx_msg_t), UART_HANDLER_RX_BLOCKS)] __attribute__((aligned(RTOS_POOL_ALIGN)));
+static rtos_pool_t uart_rx_pool_buf;
+static rtos_pool_t *uart_rx_pool;
 //=============================================================================
 //                Public Global Variables
 //=============================================================================
@@ -89,7 +95,7 @@ static void _uart_handler_recv(void)
     static uint16_t offset = 0;
     uint8_t rx_buf[UART_HANDLER_RX_CACHE_SIZE] = { 0 };
     int len;
-    uart_rx_msg_t uart_rx;
+    uart_rx_msg_t *uart_rx;
     uint16_t msgbufflen = 0;
     uint32_t parser_status = 0;
     int i = 0;
@@ -104,9 +110,13 @@ static void _uart_handler_recv(void)
         if (xQueueReceive(uart_rx_q, &uart_rx, 2) == pdTRUE)
         {
 
-            len = uart_rx.len;
-            //uart_buf[total_len] = uart_rx.data;
-            memcpy(uart_buf + total_len, uart_rx.data, len);
+            len = uart_rx->len;
+            if (total_len + len > MAX_UART_BUFFER_SIZE)
+            {
+                len = MAX_UART_BUFFER_SIZE - total_len;
+            }
+            memcpy(uart_buf + total_len, uart_rx->data, len);
+            rtos_pool_free(uart_rx_pool, uart_rx);
             total_len += len;
             for (i = 0; i < UART_HANDLER_PARSER_CB_NUM; i++)
             {
@@ -141,18 +151,7 @@ static void _uart_handler_recv(void)
 
                     if (total_len > 0)
                     {
-                        uint8_t *remainingdata = pvPortMalloc(total_len);
-                        if (!remainingdata)
-                        {
-                            break;
-                        }
-                        memcpy(remainingdata, uart_buf + offset, total_len);
-                        memcpy(uart_buf, remainingdata, total_len);
-
-                        if (remainingdata)
-                        {
-                            vPortFree(remainingdata);
-                        }
+                        memmove(uart_buf, uart_buf + offset, total_len);
                         break;
                     }
                     break;
@@ -185,12 +184,24 @@ static void _uart_handler_task(void *arg)
 
 static int uart1_rx_callback(void *p_arg)
 {
-    BaseType_t context_switch;
-    char ch;
-    uart_rx_msg_t uart_rx;
+    BaseType_t context_switch = pdFALSE;
+    uart_rx_msg_t *uart_rx;
+    uint8_t discard[UART_HANDLER_RX_CACHE_SIZE];
 
-    uart_rx.len = hosal_uart_receive(&app_uartstdio, uart_rx.data, 8);
-    xQueueSendToBackFromISR(uart_rx_q, &uart_rx, &context_switch);
+    uart_rx = rtos_pool_alloc(uart_rx_pool);
+    if (!uart_rx)
+    {
+        /* the task is behind, drain the FIFO so the interrupt clears */
+        hosal_uart_receive(&app_uartstdio, discard, sizeof(discard));
+        return 0;
+    }
+
+    uart_rx->len = hosal_uart_receive(&app_uartstdio, uart_rx->data, sizeof(uart_rx->data));
+    if (uart_rx->len == 0 || xQueueSendToBackFromISR(uart_rx_q, &uart_rx, &context_switch) != pdTRUE)
+    {
+        rtos_pool_free(uart_rx_pool, uart_rx);
+    }
+    portYIELD_FROM_ISR(context_switch);
 
     return 0;
 }
@@ -199,13 +210,15 @@ void uart_handler_init(uart_handler_parm_t *param, uint8_t priority)
 {
     TaskHandle_t t_thread;
 
+    uart_rx_pool = rtos_pool_create_static("uart_rx", sizeof(uart_rx_msg_t), UART_HANDLER_RX_BLOCKS,
+                                           uart_rx_storage, &uart_rx_pool_buf);
+    uart_rx_q = xQueueCreate(UART_HANDLER_RX_BLOCKS, sizeof(uart_rx_msg_t *));
     hosal_uart_init(&app_uartstdio);
     hosal_uart_callback_set(&app_uartstdio, HOSAL_UART_RX_CALLBACK, uart1_rx_callback, &app_uartstdio);
     /* Configure UART to interrupt mode */
     hosal_uart_ioctl(&app_uartstdio, HOSAL_UART_MODE_SET, (void *)HOSAL_UART_MODE_INT_RX);
     uart_msg_q = xQueueCreate(20, sizeof(uart_msg_t));
 
-    uart_rx_q = xQueueCreate(10, sizeof(uart_rx_msg_t));
     xTaskCreate(_uart_handler_task, "uart", 256, NULL, priority, &t_thread);
 
     memcpy(&uart_parm, param, sizeof(uart_handler_parm_t));
@@ -51,6 +51,9 @@
         X(AT_COMMAND_CANCEL_CONN,       "AT+CCCON",       "Cancel create connection.") \
         X(AT_COMMAND_DISCONN,           "AT+DISCON",      "Terminate the connection.") \
         X(AT_COMMAND_RF_PHY,            "AT+PHY",         "PHY. 1:BLE_PHY_1M; 2:BLE_PHY_2M; 3:BLE_PHY_CODED_S2; 4:BLE_PHY_CODED_S8.") \
+        X(AT_COMMAND_LINK_TARGET,       "AT+LINKTGT",     "Link target. =<id>,<latency ms>,<throughput bps>. latency 0 removes the link.") \
+        X(AT_COMMAND_SCHED,             "AT+SCHED",       "Compute the multi-link schedule and apply it.") \
+        X(AT_COMMAND_SCHED_REPORT,      "AT+SCHEDRPT",    "Show the link schedule, radio duty cycle and average current.") \
         X(AT_COMMAND_NONE,              "NONE",           "")
 
 
@@ -6,6 +6,7 @@
 #include "ble_app.h"
 #include "ble_security_manager.h"
 #include "ble_scan.h"
+#include "link_sched.h"
 
 /**************************************************************************
 * Private Functions
@@ -52,6 +53,13 @@ bool check_AT_Command_Length(CTRL_CMD_EValue cmd, uint8_t *data, uint16_t length
         }
         break;
 
+    case AT_COMMAND_LINK_TARGET:
+        if ((*(data + strlen(ctrl_cmd_table[cmd])) == AT_CMD_ASSIGN_PUNC) && (length > strlen(ctrl_cmd_table[cmd]) + 2)) // variable length parameter
+        {
+            return true;
+        }
+        break;
+
     default:
         if (strlen(ctrl_cmd_table[cmd]) == (length - 1))
         {
@@ -392,6 +400,64 @@ void handle_phy_command(uint8_t *param)
     }
 }
 
+/** handle link scheduler target setting AT commands. */
+void handle_link_target_command(uint8_t *param)
+{
+    unsigned int host_id, latency_ms;
+    unsigned long throughput_bps;
+
+    if (sscanf((char *)param, "%u,%u,%lu", &host_id, &latency_ms, &throughput_bps) != 3)
+    {
+        PRINT_CTRL_CMD_ERROR("invalid parameter");
+        return;
+    }
+
+    if ((host_id > 0xFF) || (latency_ms > 0xFFFF) ||
+            (link_sched_target_set((uint8_t)host_id, (uint16_t)latency_ms, (uint32_t)throughput_bps) == false))
+    {
+        PRINT_CTRL_CMD_ERROR("invalid parameter");
+        return;
+    }
+    PRINT_AT_CMD_OK();
+}
+
+/** handle link scheduler compute and apply AT commands. */
+void handle_sched_command(void)
+{
+    const link_sched_report_t *p_report;
+    uint8_t host_id;
+
+    link_sched_scan_set(appParam.app_param_c.scan_param.scan_interval, appParam.app_param_c.scan_param.scan_window);
+    if (link_sched_compute() == false)
+    {
+        link_sched_report_print();
+        PRINT_CTRL_CMD_ERROR("links collide");
+        return;
+    }
+    link_sched_report_print();
+
+    // scan window shrinks into the gap left by the connection events
+    p_report = link_sched_report_get();
+    if (p_report->scan_interval > 0)
+    {
+        appParam.app_param_c.scan_param.scan_interval = p_report->scan_interval;
+        appParam.app_param_c.scan_param.scan_window = p_report->scan_window;
+    }
+
+    // connected links are updated now, others pick the schedule up at connection creation
+    for (host_id = 0; host_id < max_num_conn_host; host_id++)
+    {
+        if ((link_sched_link_get(host_id) != NULL) && (ble_app_link_info[host_id].state == STATE_CONNECTED))
+        {
+            if (app_request_set(host_id, APP_REQUEST_CONN_UPDATE_PARAM, false) == false)
+            {
+                // No application queue buffer. Error.
+            }
+        }
+    }
+    PRINT_AT_CMD_OK();
+}
+
 /**************************************************************************
 * Public Functions
 **************************************************************************/
@@ -485,6 +551,19 @@ void handle_ctrl_cmd(uint8_t *data, int length)
         PRINT_AT_CMD_OK();
         break;
 
+    case AT_COMMAND_LINK_TARGET:
+        handle_link_target_command(data);
+        break;
+
+    case AT_COMMAND_SCHED:
+        handle_sched_command();
+        break;
+
+    case AT_COMMAND_SCHED_REPORT:
+        link_sched_report_print();
+        PRINT_AT_CMD_OK();
+        break;
+
     default:
         PRINT_CTRL_CMD_ERROR("this is not an AT command");
         break;
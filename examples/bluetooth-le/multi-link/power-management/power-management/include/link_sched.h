@@ -0,0 +1,151 @@
+/**************************************************************************//**
+* @file       link_sched.h
+* @brief      Provide the declarations that for multi-link connection scheduler.
+*
+* The scheduler takes a latency and throughput target for each host link and
+* derives connection interval, peripheral latency and supervision timeout so
+* that the connection events of all links (and the scan window) can be
+* placed without overlapping. Intervals are picked from a harmonic series
+* (LINK_SCHED_BASE_INTERVAL * 2^n) so that every pair of links repeats with
+* the period of the shorter one and anchor offsets only need to be checked
+* inside that period.
+*
+*****************************************************************************/
+
+#ifndef _LINK_SCHED_H_
+#define _LINK_SCHED_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**************************************************************************
+ * Scheduler Definitions
+ **************************************************************************/
+/** Smallest connection interval in the harmonic series, unit: 1.25ms. (6*1.25ms = 7.5ms) */
+#define LINK_SCHED_BASE_INTERVAL        6U
+
+/** Largest connection interval allowed by the specification, unit: 1.25ms. */
+#define LINK_SCHED_MAX_INTERVAL         3200U
+
+/** Largest peripheral latency allowed by the specification. */
+#define LINK_SCHED_MAX_LATENCY          499U
+
+/** Number of missed connection events tolerated before supervision timeout. */
+#define LINK_SCHED_SUPV_EVENTS          6U
+
+/** Link layer payload size used for throughput estimation, unit: byte. */
+#define LINK_SCHED_LL_PAYLOAD           251U
+
+/** Maximum number of data packets the scheduler budgets per connection event. */
+#define LINK_SCHED_MAX_PKTS_PER_EVENT   4U
+
+/** Guard time added to every connection event for window widening and scheduling slop, unit: us. */
+#define LINK_SCHED_GUARD_US             500U
+
+/** Anchor offset search step, unit: us. */
+#define LINK_SCHED_SLOT_STEP_US         1250U
+
+/** Minimum scan window that is still worth keeping, unit: 0.625ms. */
+#define LINK_SCHED_MIN_SCAN_WINDOW      4U
+
+/** Radio and system current model, unit: uA. Typical RT58x figures at 0dBm, calibrate per board. */
+#define LINK_SCHED_TX_CURRENT_UA        4900U
+#define LINK_SCHED_RX_CURRENT_UA        4600U
+#define LINK_SCHED_SLEEP_CURRENT_UA     3U
+#define LINK_SCHED_WAKEUP_CURRENT_UA    1500U
+
+/** Time spent waking up (XTAL settle, PLL lock) before every radio event, unit: us. */
+#define LINK_SCHED_WAKEUP_US            400U
+
+
+/**************************************************************************
+ * Scheduler Type Definitions
+ **************************************************************************/
+/** Link target set by the application. */
+typedef struct link_sched_target_s
+{
+    bool        enable;                 /**< Link takes part in the schedule. */
+    uint16_t    max_latency_ms;         /**< Worst-case one-way latency target, unit: ms. */
+    uint32_t    throughput_bps;         /**< Sustained application throughput target, unit: bit/s. */
+} link_sched_target_t;
+
+/** Per-link schedule result. */
+typedef struct link_sched_link_s
+{
+    bool        placed;                 /**< An anchor offset without collision was found. */
+    uint16_t    conn_interval;          /**< Connection interval, unit: 1.25ms. */
+    uint16_t    periph_latency;         /**< Peripheral latency, unit: connection events. */
+    uint16_t    supv_timeout;           /**< Supervision timeout, unit: 10ms. */
+    uint32_t    anchor_offset_us;       /**< Anchor offset relative to the schedule origin, unit: us. */
+    uint32_t    event_len_us;           /**< Reserved connection event length including guard time, unit: us. */
+    uint32_t    duty_ppm;               /**< Radio duty cycle of this link on the local side, unit: ppm. */
+} link_sched_link_t;
+
+/** Whole schedule report. */
+typedef struct link_sched_report_s
+{
+    bool        valid;                  /**< A collision free schedule has been computed, new connections use it. */
+    bool        collision_free;         /**< All links and the scan window were placed. */
+    uint16_t    scan_interval;          /**< Adjusted scan interval, unit: 0.625ms. 0 when scanning is not scheduled. */
+    uint16_t    scan_window;            /**< Adjusted scan window, unit: 0.625ms. */
+    uint32_t    duty_ppm;               /**< Predicted total radio duty cycle, unit: ppm. */
+    uint32_t    avg_current_ua;         /**< Predicted average current, unit: uA. */
+} link_sched_report_t;
+
+
+/**************************************************************************
+ * Scheduler Functions
+ **************************************************************************/
+/** Initialize the scheduler and clear all link targets.
+ *
+ * @return none
+ */
+void link_sched_init(void);
+
+/** Set the target of a link.
+ *
+ * @param[in] host_id : the host id.
+ * @param[in] max_latency_ms : worst-case latency target in ms, 0 to remove the link from the schedule.
+ * @param[in] throughput_bps : throughput target in bit/s.
+ *
+ * @retval true : target accepted.
+ * @retval false : invalid host id or latency out of range.
+ */
+bool link_sched_target_set(uint8_t host_id, uint16_t max_latency_ms, uint32_t throughput_bps);
+
+/** Set the requested scan parameters the schedule must leave room for.
+ *
+ * @param[in] scan_interval : scan interval in 0.625ms, 0 to disable scanning.
+ * @param[in] scan_window : scan window in 0.625ms.
+ *
+ * @return none
+ */
+void link_sched_scan_set(uint16_t scan_interval, uint16_t scan_window);
+
+/** Compute connection parameters and anchor offsets for all enabled links.
+ *
+ * @return true if every link and the scan window fit without collision.
+ */
+bool link_sched_compute(void);
+
+/** Get the scheduled connection parameters of a link.
+ *
+ * @param[in] host_id : the host id.
+ *
+ * @return a pointer to the link result, NULL if the link is not scheduled or the last schedule collides.
+ */
+const link_sched_link_t *link_sched_link_get(uint8_t host_id);
+
+/** Get the schedule report.
+ *
+ * @return a pointer to the report.
+ */
+const link_sched_report_t *link_sched_report_get(void);
+
+/** Print the schedule, duty cycle and predicted current.
+ *
+ * @return none
+ */
+void link_sched_report_print(void);
+
+#endif // _LINK_SCHED_H_
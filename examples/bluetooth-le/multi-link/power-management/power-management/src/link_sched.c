@@ -0,0 +1,509 @@
+/************************************************************************
+ *
+ * File Name  : link_sched.c
+ * Description: This file contains the multi-link connection scheduler and the
+ *              radio duty cycle / average current estimation for application.
+ *
+ *******************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "ble_app.h"
+#include "ble_profile.h"
+#include "link_sched.h"
+
+/**************************************************************************
+* Private Definitions
+**************************************************************************/
+/** Inter frame space, unit: us. */
+#define LINK_SCHED_T_IFS_US             150U
+
+/** 1.25ms connection interval unit to us. */
+#define LINK_SCHED_INTERVAL_TO_US(x)    ((uint32_t)(x) * 1250U)
+
+/** Reserved slot of a periodic radio activity. */
+typedef struct link_sched_slot_s
+{
+    uint32_t    period_us;
+    uint32_t    offset_us;
+    uint32_t    len_us;
+} link_sched_slot_t;
+
+/**************************************************************************
+* Private Variables
+**************************************************************************/
+static link_sched_target_t  g_sched_target[BLE_SUPPORT_NUM_CONN_MAX];
+static link_sched_link_t    g_sched_link[BLE_SUPPORT_NUM_CONN_MAX];
+static link_sched_report_t  g_sched_report;
+static bool                 g_sched_computed;   // g_sched_link and g_sched_report hold the last attempt
+static uint16_t             g_sched_scan_interval;
+static uint16_t             g_sched_scan_window;
+
+/**************************************************************************
+* Private Functions
+**************************************************************************/
+/** Air time of one packet with the given payload on the current PHY. */
+static uint32_t sched_pkt_air_time_us(uint32_t payload)
+{
+    switch (appParam.rf_phy)
+    {
+    case BLE_PHY_2M:
+        // preamble 2 + access address 4 + header 2 + CRC 3 bytes at 4us/byte
+        return (11U + payload) * 4U;
+
+    case BLE_PHY_CODED:
+        // preamble + access address + CI + TERM1 = 376us, then header + payload + CRC coded at S2 or S8
+        if (appParam.phy_option == BLE_CODED_PHY_S2)
+        {
+            return 376U + ((5U + payload) * 16U) + 6U;
+        }
+        return 376U + ((5U + payload) * 64U) + 24U;
+
+    case BLE_PHY_1M:
+    default:
+        // preamble 1 + access address 4 + header 2 + CRC 3 bytes at 8us/byte
+        return (10U + payload) * 8U;
+    }
+}
+
+/** Connection event length needed to move the given number of bytes, including guard time. */
+static uint32_t sched_event_len_us(uint32_t bytes)
+{
+    uint32_t empty_air = sched_pkt_air_time_us(0);
+    uint32_t pkts;
+    uint32_t last;
+    uint32_t len;
+
+    pkts = (bytes + LINK_SCHED_LL_PAYLOAD - 1U) / LINK_SCHED_LL_PAYLOAD;
+    if (pkts == 0U)
+    {
+        // an empty packet exchange keeps the link alive
+        return (2U * empty_air) + (2U * LINK_SCHED_T_IFS_US) + LINK_SCHED_GUARD_US;
+    }
+    if (pkts > LINK_SCHED_MAX_PKTS_PER_EVENT)
+    {
+        pkts = LINK_SCHED_MAX_PKTS_PER_EVENT;
+        bytes = pkts * LINK_SCHED_LL_PAYLOAD;
+    }
+
+    last = bytes - ((pkts - 1U) * LINK_SCHED_LL_PAYLOAD);
+    len = (pkts - 1U) * (sched_pkt_air_time_us(LINK_SCHED_LL_PAYLOAD) + empty_air + (2U * LINK_SCHED_T_IFS_US));
+    len += sched_pkt_air_time_us(last) + empty_air + (2U * LINK_SCHED_T_IFS_US);
+
+    return len + LINK_SCHED_GUARD_US;
+}
+
+/** Longest interval (unit: 1.25ms) that still meets the latency and throughput target. */
+static uint32_t sched_interval_limit(const link_sched_target_t *p_target)
+{
+    uint32_t limit;
+    uint32_t tp_limit;
+
+    limit = ((uint32_t)p_target->max_latency_ms * 4U) / 5U;
+    if (p_target->throughput_bps > 0U)
+    {
+        // interval at which one event carries LINK_SCHED_MAX_PKTS_PER_EVENT full packets, 1s = 800 * 1.25ms
+        tp_limit = (uint32_t)(((uint64_t)LINK_SCHED_MAX_PKTS_PER_EVENT * LINK_SCHED_LL_PAYLOAD * 8U * 800U) / p_target->throughput_bps);
+        if (tp_limit < limit)
+        {
+            limit = tp_limit;
+        }
+    }
+    return limit;
+}
+
+/** Check whether two periodic slots overlap, g is the common period of both. */
+static bool sched_slot_overlap(uint32_t a, uint32_t a_len, uint32_t b, uint32_t b_len, uint32_t g)
+{
+    uint32_t d;
+
+    a %= g;
+    b %= g;
+    d = (b + g - a) % g;    // start of b relative to start of a
+
+    if (d < a_len)
+    {
+        return true;
+    }
+    if (((g - d) % g) < b_len)
+    {
+        return true;
+    }
+    return false;
+}
+
+/** Find the first anchor offset of a new slot that does not collide with the placed ones. */
+static bool sched_slot_place(link_sched_slot_t *p_slot, const link_sched_slot_t *p_placed, uint8_t num_placed)
+{
+    uint32_t offset;
+    uint32_t g;
+    uint8_t i;
+    bool collide;
+
+    if (p_slot->len_us > p_slot->period_us)
+    {
+        return false;
+    }
+
+    for (offset = 0; offset < p_slot->period_us; offset += LINK_SCHED_SLOT_STEP_US)
+    {
+        collide = false;
+        for (i = 0; i < num_placed; i++)
+        {
+            // harmonic periods: the pair repeats with the shorter period
+            g = (p_slot->period_us < p_placed[i].period_us) ? p_slot->period_us : p_placed[i].period_us;
+            if (sched_slot_overlap(offset, p_slot->len_us, p_placed[i].offset_us, p_placed[i].len_us, g) == true)
+            {
+                collide = true;
+                break;
+            }
+        }
+        if (collide == false)
+        {
+            p_slot->offset_us = offset;
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Largest free gap inside one base period after projecting every slot onto it. */
+static uint32_t sched_free_gap_us(const link_sched_slot_t *p_placed, uint8_t num_placed, uint32_t period_us)
+{
+    uint32_t start[BLE_SUPPORT_NUM_CONN_MAX];
+    uint32_t end[BLE_SUPPORT_NUM_CONN_MAX];
+    uint32_t tmp;
+    uint32_t gap;
+    uint32_t max_gap;
+    uint32_t last_end;
+    uint8_t i, j;
+
+    if (num_placed == 0)
+    {
+        return period_us;
+    }
+
+    for (i = 0; i < num_placed; i++)
+    {
+        start[i] = p_placed[i].offset_us % period_us;
+        end[i] = start[i] + p_placed[i].len_us;
+    }
+
+    // insertion sort by start, the number of links is small
+    for (i = 1; i < num_placed; i++)
+    {
+        for (j = i; (j > 0) && (start[j - 1] > start[j]); j--)
+        {
+            tmp = start[j];
+            start[j] = start[j - 1];
+            start[j - 1] = tmp;
+            tmp = end[j];
+            end[j] = end[j - 1];
+            end[j - 1] = tmp;
+        }
+    }
+
+    max_gap = 0;
+    last_end = 0;
+    for (i = 0; i < num_placed; i++)
+    {
+        if (end[i] > last_end)
+        {
+            last_end = end[i];
+        }
+        // gap between the latest end so far and the start of the next slot (wrapping to the next period)
+        tmp = (i + 1 < num_placed) ? start[i + 1] : (start[0] + period_us);
+        gap = (tmp > last_end) ? (tmp - last_end) : 0;
+        if (gap > max_gap)
+        {
+            max_gap = gap;
+        }
+    }
+    return max_gap;
+}
+
+/**************************************************************************
+* Public Functions
+**************************************************************************/
+/** Initialize the scheduler. */
+void link_sched_init(void)
+{
+    memset(g_sched_target, 0, sizeof(g_sched_target));
+    memset(g_sched_link, 0, sizeof(g_sched_link));
+    memset(&g_sched_report, 0, sizeof(g_sched_report));
+    g_sched_computed = false;
+    g_sched_scan_interval = 0;
+    g_sched_scan_window = 0;
+}
+
+/** Set the target of a link. */
+bool link_sched_target_set(uint8_t host_id, uint16_t max_latency_ms, uint32_t throughput_bps)
+{
+    if ((host_id >= max_num_conn_host) || (host_id >= BLE_SUPPORT_NUM_CONN_MAX))
+    {
+        return false;
+    }
+
+    if (max_latency_ms == 0)
+    {
+        g_sched_target[host_id].enable = false;
+        g_sched_report.valid = false;
+        g_sched_computed = false;
+        return true;
+    }
+
+    // the shortest interval is 7.5ms and the longest is 4s
+    if ((max_latency_ms < 8) || (max_latency_ms > 4000))
+    {
+        return false;
+    }
+
+    g_sched_target[host_id].enable = true;
+    g_sched_target[host_id].max_latency_ms = max_latency_ms;
+    g_sched_target[host_id].throughput_bps = throughput_bps;
+    g_sched_report.valid = false;
+    g_sched_computed = false;
+
+    return true;
+}
+
+/** Set the requested scan parameters. */
+void link_sched_scan_set(uint16_t scan_interval, uint16_t scan_window)
+{
+    g_sched_scan_interval = scan_interval;
+    g_sched_scan_window = (scan_window > scan_interval) ? scan_interval : scan_window;
+    g_sched_report.valid = false;
+    g_sched_computed = false;
+}
+
+/** Compute connection parameters and anchor offsets for all enabled links. */
+bool link_sched_compute(void)
+{
+    link_sched_slot_t slot[BLE_SUPPORT_NUM_CONN_MAX];
+    link_sched_slot_t new_slot;
+    link_sched_link_t *p_link;
+    uint8_t order[BLE_SUPPORT_NUM_CONN_MAX];
+    uint8_t num_links;
+    uint8_t num_placed;
+    uint8_t i, j, tmp;
+    uint32_t limit;
+    uint32_t bytes;
+    uint32_t wake_period_us;
+    uint32_t base_period_us;
+    uint32_t base_units;
+    uint64_t duty_ppm;
+    uint64_t charge;
+    uint64_t current_ua;
+
+    memset(g_sched_link, 0, sizeof(g_sched_link));
+    memset(&g_sched_report, 0, sizeof(g_sched_report));
+
+    // derive connection parameters of each link
+    num_links = 0;
+    for (i = 0; (i < max_num_conn_host) && (i < BLE_SUPPORT_NUM_CONN_MAX); i++)
+    {
+        if (g_sched_target[i].enable == false)
+        {
+            continue;
+        }
+        p_link = &g_sched_link[i];
+        limit = sched_interval_limit(&g_sched_target[i]);
+
+        // longest harmonic interval within the limit
+        p_link->conn_interval = LINK_SCHED_BASE_INTERVAL;
+        while (((uint32_t)p_link->conn_interval << 1) <= limit && ((uint32_t)p_link->conn_interval << 1) <= LINK_SCHED_MAX_INTERVAL)
+        {
+            p_link->conn_interval <<= 1;
+        }
+
+        // spend the remaining slack of the harmonic rounding on peripheral latency
+        p_link->periph_latency = (limit > p_link->conn_interval) ? (uint16_t)((limit / p_link->conn_interval) - 1U) : 0;
+        if (p_link->periph_latency > LINK_SCHED_MAX_LATENCY)
+        {
+            p_link->periph_latency = LINK_SCHED_MAX_LATENCY;
+        }
+
+        // supervision timeout (10ms) tolerates LINK_SCHED_SUPV_EVENTS missed wake-ups, 1.25ms / 10ms = 1/8
+        while ((p_link->periph_latency > 0) &&
+                (((uint32_t)(p_link->periph_latency + 1U) * p_link->conn_interval * LINK_SCHED_SUPV_EVENTS) / 8U > 3200U))
+        {
+            p_link->periph_latency--;
+        }
+        p_link->supv_timeout = (uint16_t)(((uint32_t)(p_link->periph_latency + 1U) * p_link->conn_interval * LINK_SCHED_SUPV_EVENTS) / 8U);
+        if (p_link->supv_timeout < 10U)
+        {
+            p_link->supv_timeout = 10U;
+        }
+        if (p_link->supv_timeout > 3200U)
+        {
+            p_link->supv_timeout = 3200U;
+        }
+
+        // a peripheral skipping events moves the data of (latency + 1) intervals in one event
+        bytes = (uint32_t)(((uint64_t)g_sched_target[i].throughput_bps * p_link->conn_interval * (p_link->periph_latency + 1U) + 6399U) / 6400U);
+        p_link->event_len_us = sched_event_len_us(bytes);
+
+        order[num_links++] = i;
+    }
+
+    // most frequent links first, they are the hardest to place
+    for (i = 1; i < num_links; i++)
+    {
+        for (j = i; (j > 0) && (g_sched_link[order[j - 1]].conn_interval > g_sched_link[order[j]].conn_interval); j--)
+        {
+            tmp = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = tmp;
+        }
+    }
+
+    g_sched_report.collision_free = true;
+    num_placed = 0;
+    for (i = 0; i < num_links; i++)
+    {
+        p_link = &g_sched_link[order[i]];
+        new_slot.period_us = LINK_SCHED_INTERVAL_TO_US(p_link->conn_interval);
+        new_slot.len_us = p_link->event_len_us;
+        new_slot.offset_us = 0;
+
+        if (sched_slot_place(&new_slot, slot, num_placed) == true)
+        {
+            p_link->placed = true;
+            p_link->anchor_offset_us = new_slot.offset_us;
+            slot[num_placed++] = new_slot;
+        }
+        else
+        {
+            g_sched_report.collision_free = false;
+        }
+    }
+
+    // scanning: align the scan interval to the base period and shrink the window into the free gap
+    if (g_sched_scan_interval > 0)
+    {
+        g_sched_report.scan_interval = g_sched_scan_interval;
+        g_sched_report.scan_window = g_sched_scan_window;
+
+        if (num_placed > 0)
+        {
+            base_period_us = slot[0].period_us;
+            base_units = base_period_us / 625U;     // base period in 0.625ms units
+            limit = ((g_sched_scan_interval + base_units - 1U) / base_units) * base_units;
+            if (limit > 0x4000U)
+            {
+                limit = (0x4000U / base_units) * base_units;
+            }
+            g_sched_report.scan_interval = (uint16_t)limit;
+
+            limit = sched_free_gap_us(slot, num_placed, base_period_us) / 625U;
+            if (limit < g_sched_report.scan_window)
+            {
+                g_sched_report.scan_window = (uint16_t)limit;
+            }
+            if (g_sched_report.scan_window < LINK_SCHED_MIN_SCAN_WINDOW)
+            {
+                g_sched_report.collision_free = false;
+            }
+        }
+    }
+
+    // duty cycle and average current
+    duty_ppm = 0;
+    current_ua = (uint64_t)LINK_SCHED_SLEEP_CURRENT_UA * 1000000U;    // uA * 1s, in uA*us
+    for (i = 0; i < num_links; i++)
+    {
+        p_link = &g_sched_link[order[i]];
+
+        // the central attends every event, a peripheral wakes once every (latency + 1) events
+        wake_period_us = LINK_SCHED_INTERVAL_TO_US(p_link->conn_interval);
+        if (ble_app_link_info[order[i]].gap_role == BLE_GAP_ROLE_PERIPHERAL)
+        {
+            wake_period_us *= (p_link->periph_latency + 1U);
+        }
+
+        p_link->duty_ppm = (uint32_t)(((uint64_t)p_link->event_len_us * 1000000U) / wake_period_us);
+        duty_ppm += p_link->duty_ppm;
+
+        charge = ((uint64_t)p_link->event_len_us * (LINK_SCHED_TX_CURRENT_UA + LINK_SCHED_RX_CURRENT_UA)) / 2U;
+        charge += (uint64_t)LINK_SCHED_WAKEUP_US * LINK_SCHED_WAKEUP_CURRENT_UA;
+        current_ua += (charge * 1000000U) / wake_period_us;
+    }
+
+    if ((g_sched_report.scan_interval > 0) && (g_sched_report.scan_window > 0))
+    {
+        wake_period_us = (uint32_t)g_sched_report.scan_interval * 625U;
+        duty_ppm += ((uint64_t)g_sched_report.scan_window * 1000000U) / g_sched_report.scan_interval;
+
+        charge = (uint64_t)g_sched_report.scan_window * 625U * LINK_SCHED_RX_CURRENT_UA;
+        charge += (uint64_t)LINK_SCHED_WAKEUP_US * LINK_SCHED_WAKEUP_CURRENT_UA;
+        current_ua += (charge * 1000000U) / wake_period_us;
+    }
+
+    g_sched_report.duty_ppm = (duty_ppm > 1000000U) ? 1000000U : (uint32_t)duty_ppm;
+    g_sched_report.avg_current_ua = (uint32_t)(current_ua / 1000000U);
+
+    // a colliding schedule is only printed, new connections keep the default parameters
+    g_sched_report.valid = g_sched_report.collision_free;
+    g_sched_computed = true;
+
+    return g_sched_report.collision_free;
+}
+
+/** Get the scheduled connection parameters of a link. */
+const link_sched_link_t *link_sched_link_get(uint8_t host_id)
+{
+    if ((g_sched_report.valid == false) || (host_id >= BLE_SUPPORT_NUM_CONN_MAX) || (g_sched_target[host_id].enable == false))
+    {
+        return NULL;
+    }
+    return &g_sched_link[host_id];
+}
+
+/** Get the schedule report. */
+const link_sched_report_t *link_sched_report_get(void)
+{
+    return &g_sched_report;
+}
+
+/** Print the schedule. */
+void link_sched_report_print(void)
+{
+    const link_sched_link_t *p_link;
+    uint8_t i;
+
+    if (g_sched_computed == false)
+    {
+        printf("[SCHED] no schedule\n");
+        return;
+    }
+
+    for (i = 0; (i < max_num_conn_host) && (i < BLE_SUPPORT_NUM_CONN_MAX); i++)
+    {
+        if (g_sched_target[i].enable == false)
+        {
+            continue;
+        }
+        p_link = &g_sched_link[i];
+        printf("[SCHED] ID:%d %s interval(ms) = %lu.%02lu, latency = %d, timeout(ms) = %lu, anchor(us) = %lu, event(us) = %lu, duty(ppm) = %lu\n",
+               i,
+               (p_link->placed == true) ? "placed" : "COLLIDE",
+               (unsigned long)((p_link->conn_interval * 125U) / 100U),
+               (unsigned long)((p_link->conn_interval * 125U) % 100U),
+               p_link->periph_latency,
+               (unsigned long)(p_link->supv_timeout * 10U),
+               (unsigned long)p_link->anchor_offset_us,
+               (unsigned long)p_link->event_len_us,
+               (unsigned long)p_link->duty_ppm);
+    }
+
+    if (g_sched_report.scan_interval > 0)
+    {
+        printf("[SCHED] scan interval(ms) = %d, window(ms) = %d\n",
+               (g_sched_report.scan_interval * 5) >> 3, (g_sched_report.scan_window * 5) >> 3);
+    }
+
+    printf("[SCHED] %s, duty = %lu.%04lu%%, avg current(uA) = %lu\n",
+           (g_sched_report.collision_free == true) ? "collision free" : "collision, not applied",
+           (unsigned long)(g_sched_report.duty_ppm / 10000U),
+           (unsigned long)(g_sched_report.duty_ppm % 10000U),
+           (unsigned long)g_sched_report.avg_current_ua);
+}
@@ -23,6 +23,7 @@
 #include "ble_api.h"
 #include "ble_host_cmd.h"
 #include "ctrl_cmd.h"
+#include "link_sched.h"
 #include "hosal_rf.h"
 #include "hosal_uart.h"
 #include "hosal_gpio.h"
@@ -121,6 +122,7 @@ static void ble_app_main(app_req_param_t *p_param);
 static ble_err_t adv_start(uint8_t host_id);
 static ble_err_t scan_start(void);
 static ble_err_t conn_create(uint8_t host_id, ble_gap_addr_t *p_peer);
+static void conn_param_sched_apply(ble_gap_conn_param_update_param_t *p_conn_param);
 
 /**************************************************************************************************
  *    LOCAL FUNCTIONS
@@ -402,6 +404,7 @@ static void app_central_handler(app_req_param_t *p_param)
         conn_param.ble_conn_param.max_conn_interval = appParam.conn_param.ble_conn_param.max_conn_interval;
         conn_param.ble_conn_param.periph_latency = appParam.conn_param.ble_conn_param.periph_latency;
         conn_param.ble_conn_param.supv_timeout = appParam.conn_param.ble_conn_param.supv_timeout;
+        conn_param_sched_apply(&conn_param);
 
         status = ble_cmd_conn_param_update(&conn_param);
         if (status != BLE_ERR_OK)
@@ -481,6 +484,7 @@ static void app_peripheral_handler(app_req_param_t *p_param)
         conn_param.ble_conn_param.max_conn_interval = appParam.conn_param.ble_conn_param.max_conn_interval;
         conn_param.ble_conn_param.periph_latency = appParam.conn_param.ble_conn_param.periph_latency;
         conn_param.ble_conn_param.supv_timeout = appParam.conn_param.ble_conn_param.supv_timeout;
+        conn_param_sched_apply(&conn_param);
 
         status = ble_cmd_conn_param_update(&conn_param);
         if (status != BLE_ERR_OK)
@@ -686,6 +690,7 @@ static ble_err_t conn_create(uint8_t host_id, ble_gap_addr_t *p_peer)
     ble_err_t             status;
     ble_gap_create_conn_param_t  create_conn_param;
     ble_gap_addr_t addr_param;
+    const link_sched_link_t *p_link;
 
     ble_cmd_device_addr_get(&addr_param);
 
@@ -701,11 +706,36 @@ static ble_err_t conn_create(uint8_t host_id, ble_gap_addr_t *p_peer)
     create_conn_param.conn_param.periph_latency = appParam.conn_param.ble_conn_param.periph_latency;
     create_conn_param.conn_param.supv_timeout = appParam.conn_param.ble_conn_param.supv_timeout;
 
+    // use the scheduled parameters if the link has a target
+    p_link = link_sched_link_get(host_id);
+    if (p_link != NULL)
+    {
+        create_conn_param.conn_param.max_conn_interval = p_link->conn_interval;
+        create_conn_param.conn_param.min_conn_interval = p_link->conn_interval;
+        create_conn_param.conn_param.periph_latency = p_link->periph_latency;
+        create_conn_param.conn_param.supv_timeout = p_link->supv_timeout;
+    }
+
     status = ble_cmd_conn_create(&create_conn_param);
 
     return status;
 }
 
+static void conn_param_sched_apply(ble_gap_conn_param_update_param_t *p_conn_param)
+{
+    const link_sched_link_t *p_link;
+
+    // override the global connection parameters if the link has a target
+    p_link = link_sched_link_get(p_conn_param->host_id);
+    if (p_link != NULL)
+    {
+        p_conn_param->ble_conn_param.min_conn_interval = p_link->conn_interval;
+        p_conn_param->ble_conn_param.max_conn_interval = p_link->conn_interval;
+        p_conn_param->ble_conn_param.periph_latency = p_link->periph_latency;
+        p_conn_param->ble_conn_param.supv_timeout = p_link->supv_timeout;
+    }
+}
+
 static ble_err_t adv_init(void)
 {
     ble_err_t status;
@@ -1335,6 +1365,8 @@ static ble_err_t ble_init(void)
 
     appParam.rf_phy = BLE_PHY_1M;
     appParam.phy_option = BLE_CODED_PHY_NO_PREFERRED;
+
+    link_sched_init();
     // show AT CMD HELP
     print_ctrl_cmd_help();
 
@@ -0,0 +1,148 @@
+/**
+ * @file cli_args.h
+ * @brief Typed argument schemas for shell commands.
+ *
+ * A command describes its arguments once as a const table: name, type,
+ * destination field and allowed range, or a sorted keyword table for
+ * sub-commands and modes. cli_args_parse() converts the whole argv into
+ * the command's own struct in one pass and rejects a missing, malformed or
+ * out of range argument with a message naming it, so the handler only
+ * deals with valid values.
+ *
+ * Numbers are decimal, or hexadecimal with a 0x prefix. Keywords and
+ * sub-commands may be shortened to any unique prefix.
+ *
+ * Sub-commands are a sorted table of name and handler, found by binary
+ * search. The same tables drive completion of a partly typed word and the
+ * script runner, which executes a text of command lines in place without
+ * copying or allocating.
+ *
+ * Shared by the Zigbee gateway-module and the BLE mesh gateway.
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+
+#ifndef __CLI_ARGS_H
+#define __CLI_ARGS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    CLI_ARG_U8 = 0,
+    CLI_ARG_U16,
+    CLI_ARG_U32,
+    CLI_ARG_S8,
+    CLI_ARG_S16,
+    CLI_ARG_S32,
+    CLI_ARG_KEYWORD, /* one of a keyword table, stores the keyword id as uint8_t */
+    CLI_ARG_STR,     /* stores the argv pointer */
+} cli_arg_type_t;
+
+typedef struct {
+    const char *pName;
+    uint8_t id;
+} cli_keyword_t;
+
+typedef struct {
+    const char *pName;
+    uint8_t type;      /* cli_arg_type_t */
+    uint8_t optional;  /* field is left as is when the argument is missing */
+    uint8_t keyword_count;
+    uint16_t offset;   /* of the field in the output struct */
+    int64_t min;
+    int64_t max;
+    const cli_keyword_t *pKeywords; /* sorted by name */
+} cli_arg_t;
+
+#define CLI_ARG_NUM(st, field, type, min, max, name) \
+    { name, type, 0, 0, offsetof(st, field), min, max, NULL }
+
+#define CLI_ARG_NUM_OPT(st, field, type, min, max, name) \
+    { name, type, 1, 0, offsetof(st, field), min, max, NULL }
+
+#define CLI_ARG_KEY(st, field, table, name) \
+    { name, CLI_ARG_KEYWORD, 0, sizeof(table) / sizeof(table[0]), offsetof(st, field), 0, 0, table }
+
+#define CLI_ARG_STRING(st, field, name) \
+    { name, CLI_ARG_STR, 0, 0, offsetof(st, field), 0, 0, NULL }
+
+#define CLI_ARGS_COUNT(schema) (sizeof(schema) / sizeof(schema[0]))
+
+/**
+ * @brief Handler of a sub-command, or of a command run by a script
+ * @param argc, argv argv[0] is the sub-command name
+ * @return 0 on success
+ */
+typedef int (*cli_subcmd_exec_t)(int argc, char **argv, void *pCtx);
+
+typedef struct {
+    const char *pName;
+    cli_subcmd_exec_t exec;
+} cli_subcmd_t;
+
+/* Words of one script line, a comment starts with '#' */
+#define CLI_SCRIPT_ARGC_MAX 16
+
+/**
+ * @brief Parse argv against a schema into pOut
+ * @param argc, argv the arguments after the command name
+ * @return 0 on success, -1 after printing what is wrong
+ */
+int cli_args_parse(int argc, char **argv, const cli_arg_t *pSchema, uint8_t count, void *pOut);
+
+/**
+ * @brief Find a keyword in a table sorted by name
+ * @return the entry, NULL when there is none
+ */
+const cli_keyword_t *cli_keyword_find(const cli_keyword_t *pTable, uint8_t count, const char *pName);
+
+/**
+ * @brief Find a keyword by its name or a unique prefix of it
+ * @return the entry, NULL when there is none or the prefix is ambiguous
+ */
+const cli_keyword_t *cli_keyword_match(const cli_keyword_t *pTable, uint8_t count, const char *pName);
+
+/**
+ * @brief Run the sub-command named by argv[0], or a unique prefix of it
+ * @return the handler's result, -1 after printing the sub-commands when
+ *         argv[0] names none or several of them
+ */
+int cli_subcmd_run(int argc, char **argv, const cli_subcmd_t *pTable, uint8_t count, void *pCtx);
+
+/**
+ * @brief Complete a partly typed keyword or sub-command
+ * @param pPrefix the word typed so far
+ * @param pOut receives the characters every candidate shares after pPrefix,
+ *        an empty string when there is nothing to add
+ * @return the number of candidates
+ */
+uint8_t cli_keyword_complete(const cli_keyword_t *pTable, uint8_t count, const char *pPrefix, char *pOut, uint8_t out_size);
+uint8_t cli_subcmd_complete(const cli_subcmd_t *pTable, uint8_t count, const char *pPrefix, char *pOut, uint8_t out_size);
+
+/**
+ * @brief Complete the last word of argv against the schema
+ * @return the number of candidates, 0 when that argument is no keyword
+ */
+uint8_t cli_args_complete(int argc, char **argv, const cli_arg_t *pSchema, uint8_t count, char *pOut, uint8_t out_size);
+
+/**
+ * @brief Split a line in place into words at blanks
+ * @return the number of words, the rest of the line is ignored past max
+ */
+int cli_args_split(char *pLine, char **argv, int max);
+
+/**
+ * @brief Run a text of command lines through a command table
+ *
+ * The text is split in place. Blank lines and lines starting with '#' are
+ * skipped, the first line whose command is unknown or fails stops the run.
+ *
+ * @return 0 when every line ran, else the number of the failing line
+ */
+uint32_t cli_script_run(char *pText, const cli_subcmd_t *pTable, uint8_t count, void *pCtx);
+
+#endif // __CLI_ARGS_H
@@ -0,0 +1,282 @@
+/**
+ * @file cli_args.c
+ * @brief Typed argument schemas for shell commands, see cli_args.h
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+//=============================================================================
+//                Include
+//=============================================================================
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cli_args.h"
+
+//=============================================================================
+//                Macro Definition
+//=============================================================================
+/* Keyword and sub-command tables both start with the name */
+#define CLI_TABLE_NAME(pTable, stride, i) \
+    (*(const char *const *)((const uint8_t *)(pTable) + (size_t)(i) * (stride)))
+
+#define CLI_IS_BLANK(c) ((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\n')
+
+//=============================================================================
+//                Private Function
+//=============================================================================
+/* First entry not sorting before pName */
+static int cli_table_lower(const void *pTable, uint8_t count, size_t stride, const char *pName) {
+    int lo = 0, hi = count, mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (strcmp(CLI_TABLE_NAME(pTable, stride, mid), pName) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Entry named pName, or the only one starting with it: -1 none, -2 several */
+static int cli_table_match(const void *pTable, uint8_t count, size_t stride, const char *pName) {
+    size_t len = strlen(pName);
+    int i = cli_table_lower(pTable, count, stride, pName);
+
+    if (i >= count || strncmp(CLI_TABLE_NAME(pTable, stride, i), pName, len) != 0) {
+        return -1;
+    }
+    if (CLI_TABLE_NAME(pTable, stride, i)[len] == '\0') {
+        return i;
+    }
+    if (i + 1 < count && strncmp(CLI_TABLE_NAME(pTable, stride, i + 1), pName, len) == 0) {
+        return -2;
+    }
+    return i;
+}
+
+static uint8_t cli_table_complete(const void *pTable, uint8_t count, size_t stride, const char *pPrefix,
+                                  char *pOut, uint8_t out_size) {
+    const char *pFirst = NULL, *pName;
+    size_t len = strlen(pPrefix), common = 0, k;
+    uint8_t num = 0;
+    int i;
+
+    for (i = cli_table_lower(pTable, count, stride, pPrefix); i < count; i++) {
+        pName = CLI_TABLE_NAME(pTable, stride, i);
+        if (strncmp(pName, pPrefix, len) != 0) {
+            break;
+        }
+        if (!pFirst) {
+            pFirst = pName;
+            common = strlen(pName) - len;
+        } else {
+            for (k = 0; k < common && pName[len + k] == pFirst[len + k]; k++) {
+            }
+            common = k;
+        }
+        num++;
+    }
+
+    if (out_size) {
+        if (common >= out_size) {
+            common = out_size - 1;
+        }
+        if (common) {
+            memcpy(pOut, pFirst + len, common);
+        }
+        pOut[common] = '\0';
+    }
+    return num;
+}
+
+static void cli_table_print(const void *pTable, uint8_t count, size_t stride) {
+    uint8_t i;
+
+    for (i = 0; i < count; i++) {
+        printf(" %s", CLI_TABLE_NAME(pTable, stride, i));
+    }
+    printf("\n");
+}
+
+static bool cli_arg_number(const char *pStr, int64_t *pValue) {
+    char *pEnd;
+
+    if (pStr[0] == '0' && (pStr[1] == 'x' || pStr[1] == 'X')) {
+        if (pStr[2] == '\0') {
+            return false;
+        }
+        *pValue = (int64_t)strtoull(pStr + 2, &pEnd, 16);
+    } else {
+        *pValue = strtoll(pStr, &pEnd, 10);
+    }
+    return pEnd != pStr && *pEnd == '\0';
+}
+
+static void cli_arg_store(void *pField, uint8_t type, int64_t value) {
+    switch (type) {
+        case CLI_ARG_U8:
+        case CLI_ARG_S8:
+        case CLI_ARG_KEYWORD: *(uint8_t *)pField = (uint8_t)value; break;
+        case CLI_ARG_U16:
+        case CLI_ARG_S16: *(uint16_t *)pField = (uint16_t)value; break;
+        default: *(uint32_t *)pField = (uint32_t)value; break;
+    }
+}
+
+//=============================================================================
+//                Public Function
+//=============================================================================
+int cli_args_parse(int argc, char **argv, const cli_arg_t *pSchema, uint8_t count, void *pOut) {
+    const cli_arg_t *pArg;
+    const cli_keyword_t *pKey;
+    int64_t value;
+    uint8_t i;
+
+    for (i = 0; i < count; i++) {
+        pArg = &pSchema[i];
+        if (i >= argc) {
+            if (pArg->optional) {
+                continue;
+            }
+            printf("missing [%s]\n", pArg->pName);
+            return -1;
+        }
+
+        if (pArg->type == CLI_ARG_STR) {
+            *(char **)((uint8_t *)pOut + pArg->offset) = argv[i];
+            continue;
+        }
+
+        if (pArg->type == CLI_ARG_KEYWORD) {
+            pKey = cli_keyword_match(pArg->pKeywords, pArg->keyword_count, argv[i]);
+            if (!pKey) {
+                printf("invalid [%s] '%s', one of:", pArg->pName, argv[i]);
+                cli_table_print(pArg->pKeywords, pArg->keyword_count, sizeof(cli_keyword_t));
+                return -1;
+            }
+            value = pKey->id;
+        } else if (!cli_arg_number(argv[i], &value)) {
+            printf("invalid [%s] '%s'\n", pArg->pName, argv[i]);
+            return -1;
+        } else if (value < pArg->min || value > pArg->max) {
+            /* ranges fit in 32 bits, no 64-bit printf needed */
+            if (pArg->min < 0) {
+                printf("[%s] %s out of range %ld..%ld\n", pArg->pName, argv[i],
+                       (long)pArg->min, (long)pArg->max);
+            } else {
+                printf("[%s] %s out of range %lu..%lu\n", pArg->pName, argv[i],
+                       (unsigned long)pArg->min, (unsigned long)pArg->max);
+            }
+            return -1;
+        }
+        cli_arg_store((uint8_t *)pOut + pArg->offset, pArg->type, value);
+    }
+    return 0;
+}
+
+const cli_keyword_t *cli_keyword_find(const cli_keyword_t *pTable, uint8_t count, const char *pName) {
+    int lo = 0, hi = count - 1, mid, cmp;
+
+    while (lo <= hi) {
+        mid = (lo + hi) / 2;
+        cmp = strcmp(pName, pTable[mid].pName);
+        if (cmp == 0) {
+            return &pTable[mid];
+        }
+        if (cmp < 0) {
+            hi = mid - 1;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+const cli_keyword_t *cli_keyword_match(const cli_keyword_t *pTable, uint8_t count, const char *pName) {
+    int i = cli_table_match(pTable, count, sizeof(cli_keyword_t), pName);
+
+    return i < 0 ? NULL : &pTable[i];
+}
+
+int cli_subcmd_run(int argc, char **argv, const cli_subcmd_t *pTable, uint8_t count, void *pCtx) {
+    int i;
+
+    if (argc < 1) {
+        return -1;
+    }
+    i = cli_table_match(pTable, count, sizeof(cli_subcmd_t), argv[0]);
+    if (i < 0) {
+        printf("%s '%s', one of:", i == -2 ? "ambiguous" : "unknown", argv[0]);
+        cli_table_print(pTable, count, sizeof(cli_subcmd_t));
+        return -1;
+    }
+    return pTable[i].exec(argc, argv, pCtx);
+}
+
+uint8_t cli_keyword_complete(const cli_keyword_t *pTable, uint8_t count, const char *pPrefix, char *pOut, uint8_t out_size) {
+    return cli_table_complete(pTable, count, sizeof(cli_keyword_t), pPrefix, pOut, out_size);
+}
+
+uint8_t cli_subcmd_complete(const cli_subcmd_t *pTable, uint8_t count, const char *pPrefix, char *pOut, uint8_t out_size) {
+    return cli_table_complete(pTable, count, sizeof(cli_subcmd_t), pPrefix, pOut, out_size);
+}
+
+uint8_t cli_args_complete(int argc, char **argv, const cli_arg_t *pSchema, uint8_t count, char *pOut, uint8_t out_size) {
+    const cli_arg_t *pArg;
+
+    if (argc < 1 || argc > count || pSchema[argc - 1].type != CLI_ARG_KEYWORD) {
+        return 0;
+    }
+    pArg = &pSchema[argc - 1];
+    return cli_keyword_complete(pArg->pKeywords, pArg->keyword_count, argv[argc - 1], pOut, out_size);
+}
+
+int cli_args_split(char *pLine, char **argv, int max) {
+    int argc = 0;
+
+    while (argc < max) {
+        while (CLI_IS_BLANK(*pLine)) {
+            pLine++;
+        }
+        if (*pLine == '\0') {
+            break;
+        }
+        argv[argc++] = pLine;
+        while (*pLine != '\0' && !CLI_IS_BLANK(*pLine)) {
+            pLine++;
+        }
+        if (*pLine != '\0') {
+            *pLine++ = '\0';
+        }
+    }
+    return argc;
+}
+
+uint32_t cli_script_run(char *pText, const cli_subcmd_t *pTable, uint8_t count, void *pCtx) {
+    char *argv[CLI_SCRIPT_ARGC_MAX];
+    char *pLine = pText, *pNext;
+    uint32_t line = 0;
+    int argc;
+
+    while (pLine) {
+        line++;
+        pNext = strchr(pLine, '\n');
+        if (pNext) {
+            *pNext++ = '\0';
+        }
+        argc = cli_args_split(pLine, argv, CLI_SCRIPT_ARGC_MAX);
+        if (argc > 0 && argv[0][0] != '#' && cli_subcmd_run(argc, argv, pTable, count, pCtx) != 0) {
+            printf("script stopped at line %lu\n", (unsigned long)line);
+            return line;
+        }
+        pLine = pNext;
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file app_ot_job.h
+ * @brief Application work that calls OpenThread, run in the OpenThread task.
+ *
+ * Timer callbacks and application tasks must not call the stack directly.
+ * They post a job registered at init instead: a pending bit is set and one
+ * tasklet is posted, the tasklet runs every pending job in the OpenThread
+ * task. A job posted several times before it runs runs once.
+ *
+ * Shared by the mesh-it-up router and sleepy applications.
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+
+#ifndef __APP_OT_JOB_H
+#define __APP_OT_JOB_H
+
+#include <openthread/instance.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Jobs registered at once */
+#ifndef APP_OT_JOB_MAX
+#define APP_OT_JOB_MAX 8
+#endif
+
+typedef void (*app_ot_job_fn_t)(otInstance* instance);
+
+/* Called first from otrInitUser(), in the OpenThread task */
+void app_ot_job_init(otInstance* instance);
+
+/* Register a job, the id to post it with or -1 when the table is full */
+int app_ot_job_register(app_ot_job_fn_t fn);
+
+/* Run the job soon in the OpenThread task, from any task but not an ISR */
+void app_ot_job_post(int job);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __APP_OT_JOB_H
@@ -0,0 +1,98 @@
+/**
+ * @file app_ot_job.cpp
+ * @brief Application jobs run from one OpenThread tasklet.
+ *
+ * The pending bits are set in a critical section so any task may post. The
+ * tasklet itself is posted with the stack lock of the port held, which is
+ * also what wakes the OpenThread task.
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+
+#include "openthread-core-config.h"
+
+#include <miu_port.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "common/code_utils.hpp"
+#include "common/new.hpp"
+#include "common/tasklet.hpp"
+#if __has_include("instance/instance.hpp")
+#include "instance/instance.hpp"
+#else
+#include "common/instance.hpp"
+#endif
+
+#include "app_ot_job.h"
+
+static app_ot_job_fn_t sJobs[APP_OT_JOB_MAX];
+static uint8_t         sJobCount;
+static volatile uint32_t sPending;
+
+static ot::Tasklet *sTasklet;
+alignas(ot::Tasklet) static uint8_t sTaskletRaw[sizeof(ot::Tasklet)];
+
+static void HandleTasklet(ot::Tasklet &aTasklet)
+{
+    otInstance *instance = &aTasklet.GetInstance();
+    uint32_t    pending;
+    uint8_t     i;
+
+    taskENTER_CRITICAL();
+    pending  = sPending;
+    sPending = 0;
+    taskEXIT_CRITICAL();
+
+    for (i = 0; i < sJobCount; i++)
+    {
+        if (pending & (1UL << i))
+        {
+            sJobs[i](instance);
+        }
+    }
+}
+
+extern "C" void app_ot_job_init(otInstance *aInstance)
+{
+    ot::Instance *instance = static_cast<ot::Instance *>(aInstance);
+
+    VerifyOrExit(sTasklet == nullptr);
+    sTasklet = new (&sTaskletRaw) ot::Tasklet(*instance, HandleTasklet);
+
+exit:
+    return;
+}
+
+extern "C" int app_ot_job_register(app_ot_job_fn_t aFn)
+{
+    int job = -1;
+
+    VerifyOrExit(aFn != nullptr && sJobCount < APP_OT_JOB_MAX);
+    job        = sJobCount;
+    sJobs[job] = aFn;
+    sJobCount++;
+
+exit:
+    return job;
+}
+
+extern "C" void app_ot_job_post(int aJob)
+{
+    VerifyOrExit(aJob >= 0 && aJob < sJobCount && sTasklet != nullptr);
+
+    taskENTER_CRITICAL();
+    sPending |= 1UL << aJob;
+    taskEXIT_CRITICAL();
+
+    otrLock();
+    sTasklet->Post();
+    otrUnlock();
+
+exit:
+    return;
+}
@@ -0,0 +1,32 @@
+/**
+ * @file app_rmt.h
+ * @brief Authenticated remote commands over the application UDP socket of
+ *        the mesh-it-up devices, see app_rmt.c
+ *
+ * The service only runs with a key: the one provisioned with "rmt key",
+ * kept in flash, or else CONFIG_APP_RMT_KEY. There is no default key.
+ *
+ * Shared by the mesh-it-up router and sleepy applications.
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+
+#ifndef __APP_RMT_H
+#define __APP_RMT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <openthread/instance.h>
+#include <openthread/udp.h>
+
+/* Called from otrInitUser(), in the OpenThread task */
+void app_rmt_init(otInstance* instance);
+
+/* Queue p when it is a remote command frame, true when it was one */
+bool app_rmt_receive(const uint8_t* p, uint16_t len,
+                     const otMessageInfo* info);
+
+#endif // __APP_RMT_H
@@ -0,0 +1,109 @@
+/**
+ * @file rmt_proto.h
+ * @brief Remote command frames: a fixed header, a command line or its
+ *        output, and a truncated HMAC-SHA256 tag over both.
+ *
+ * Byte layout, little-endian:
+ *  - 0 magic, RMT_MAGIC
+ *  - 1 type, RMT_TYPE_*
+ *  - 2 request id, chosen by the sender and echoed in the response
+ *  - 4 sender id, the factory EUI-64 of the node that built the frame
+ *  - 12 sender counter, echoed in the response
+ *  - 16 status, RMT_STATUS_* in a response, 0 in a request
+ *  - 17 payload length
+ *  - 18 payload, then the first RMT_TAG_LEN bytes of
+ *    HMAC-SHA256(key, header | payload)
+ *
+ * A request counter is accepted once, and only within RMT_REPLAY_WINDOW of
+ * the highest counter seen from its sender id. The id is covered by the
+ * tag, the source address is not and plays no part. No OpenThread or RTOS
+ * dependency.
+ */
+
+#ifndef __RMT_PROTO_H
+#define __RMT_PROTO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* 0xB7 is the app_udp batch, ASCII the plain text commands, 0xA7 the
+ * frames without a sender id */
+#define RMT_MAGIC 0xA8
+
+#define RMT_HDR_LEN    18
+#define RMT_SENDER_LEN 8
+#define RMT_TAG_LEN    16
+
+/** Longest command line or command output carried */
+#ifndef RMT_PAYLOAD_MAX
+#define RMT_PAYLOAD_MAX 200
+#endif
+
+#define RMT_FRAME_MAX (RMT_HDR_LEN + RMT_PAYLOAD_MAX + RMT_TAG_LEN)
+
+/** Counters accepted behind the highest one seen, out of order */
+#define RMT_REPLAY_WINDOW 32
+
+/** Longest key kept */
+#define RMT_KEY_MAX 32
+
+#define RMT_TYPE_REQUEST  1
+#define RMT_TYPE_RESPONSE 2
+
+#define RMT_STATUS_OK      0
+#define RMT_STATUS_FAILED  1 /**< command returned an error */
+#define RMT_STATUS_UNKNOWN 2 /**< command not available remotely */
+#define RMT_STATUS_STALE   3 /**< counter replayed or too old, payload is
+                                  the next counter accepted */
+#define RMT_STATUS_TRUNCATED 0x80 /**< flag, output longer than the payload */
+
+#define RMT_ERR_FORMAT -1
+#define RMT_ERR_AUTH   -2
+
+typedef struct {
+    uint8_t type;
+    uint16_t id;
+    uint8_t sender[RMT_SENDER_LEN];
+    uint32_t counter;
+    uint8_t status;
+    uint8_t len;
+    const uint8_t* payload;
+} rmt_frame_t;
+
+typedef struct {
+    uint32_t top;  /**< highest counter accepted, 0 none */
+    uint32_t mask; /**< bit n set: top - n accepted */
+} rmt_replay_t;
+
+/**
+ * @brief Cheap checks before a frame is queued: magic, type and length
+ */
+bool rmt_is_frame(const uint8_t* buf, uint16_t len);
+
+/**
+ * @brief Build and sign a frame into buf, RMT_FRAME_MAX bytes. The payload
+ *        may already sit at buf + RMT_HDR_LEN.
+ * @return frame length, 0 when the payload is too long
+ */
+uint16_t rmt_encode(uint8_t* buf, const rmt_frame_t* frame, const uint8_t* key,
+                    uint8_t key_len);
+
+/**
+ * @brief Check the tag and parse, frame->payload points into buf
+ * @return 0, RMT_ERR_FORMAT or RMT_ERR_AUTH
+ */
+int rmt_decode(const uint8_t* buf, uint16_t len, const uint8_t* key,
+               uint8_t key_len, rmt_frame_t* frame);
+
+/**
+ * @return 0 and the counter recorded, -1 when replayed or too old
+ */
+int rmt_replay_accept(rmt_replay_t* window, uint32_t counter);
+
+/**
+ * @brief Start a window from a saved floor, every counter up to it counts
+ *        as seen
+ */
+void rmt_replay_restore(rmt_replay_t* window, uint32_t floor);
+
+#endif // __RMT_PROTO_H
@@ -0,0 +1,694 @@
+/**
+ * @file app_rmt.c
+ * @brief Authenticated remote commands over the application UDP socket.
+ *
+ * The OpenThread task only checks the framing and the rate, then copies the
+ * request into a bounded queue. A worker task verifies the tag and the
+ * replay window, runs the command through its sh_cmd_t handler with the
+ * output captured, and sends a signed response with the same request id
+ * to the address and port the request came from. Forged, replayed or
+ * excess requests cost no allocation and a forged one gets no answer.
+ *
+ * Replay windows are kept per sender id, which the tag covers. Each
+ * window's floor and the own request counter are saved in flash a step
+ * ahead of use, so a reboot skips counters rather than taking old ones
+ * again. A sender is never forgotten while the key stays: the first
+ * request of an unknown one is answered stale with a floor to exceed, and
+ * once the table is full new senders are refused until a new key is set.
+ *
+ * Without a key, provisioned or from Kconfig, the service does not start.
+ */
+
+#include <FreeRTOS.h>
+#include <queue.h>
+#include <semphr.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <task.h>
+#include <openthread/link.h>
+#include "EnhancedFlashDataset.h"
+#include "app_rmt.h"
+#include "cli.h"
+#include "log.h"
+#include "main.h"
+#include "rmt_proto.h"
+
+/* Requests waiting for the worker, more are dropped */
+#ifndef APP_RMT_QUEUE_LEN
+#define APP_RMT_QUEUE_LEN 8
+#endif
+
+/* Requests taken per second, and in a burst */
+#ifndef APP_RMT_RATE
+#define APP_RMT_RATE 8
+#endif
+#ifndef APP_RMT_BURST
+#define APP_RMT_BURST 16
+#endif
+
+/* Senders whose replay window is kept, further ones are refused */
+#ifndef APP_RMT_PEERS
+#define APP_RMT_PEERS 16
+#endif
+
+#ifndef APP_RMT_ARGC_MAX
+#define APP_RMT_ARGC_MAX 12
+#endif
+
+/* A sleepy sender polls fast this long for the response */
+#ifndef APP_RMT_REPLY_MS
+#define APP_RMT_REPLY_MS 3000
+#endif
+
+/* Counters reserved by one flash write, a reboot skips at most as many */
+#ifndef APP_RMT_SAVE_STEP
+#define APP_RMT_SAVE_STEP 64
+#endif
+
+#define APP_RMT_TASK_SIZE 768
+
+#define APP_RMT_KEY_ENV   "rmt_key"
+#define APP_RMT_TX_ENV    "rmt_tx"
+#define APP_RMT_PEERS_ENV "rmt_peers"
+
+typedef struct {
+    otIp6Address addr;
+    uint16_t port;
+    uint16_t len;
+    uint8_t buf[RMT_FRAME_MAX];
+} app_rmt_msg_t;
+
+typedef struct {
+    uint8_t sender[RMT_SENDER_LEN];
+    rmt_replay_t window;
+    uint32_t saved; /**< floor in flash, above every counter accepted */
+    bool valid;
+} app_rmt_peer_t;
+
+/* flash record of a peer, floor 0 is an empty slot */
+typedef struct {
+    uint8_t sender[RMT_SENDER_LEN];
+    uint32_t floor;
+} app_rmt_saved_t;
+
+typedef struct {
+    uint32_t rx;
+    uint32_t rate_limited;
+    uint32_t queue_full;
+    uint32_t auth_failed;
+    uint32_t replayed;
+    uint32_t challenged;
+    uint32_t peers_full;
+    uint32_t executed;
+    uint32_t failed;
+    uint32_t unknown;
+    uint32_t responses;
+} app_rmt_stats_t;
+
+/* Commands a remote peer may run, never rmt itself */
+extern const sh_cmd_t g_cli_cmd_miu_app;
+extern const sh_cmd_t g_cli_cmd_phy;
+#if (CONFIG_APP_NBR_MONITOR == 1)
+extern const sh_cmd_t g_cli_cmd_nbrmon;
+#endif
+#if (CONFIG_APP_PWR_TELEMETRY == 1)
+extern const sh_cmd_t g_cli_cmd_pwr;
+#endif
+#if (CONFIG_APP_POLL_CTRL == 1)
+extern const sh_cmd_t g_cli_cmd_poll;
+#endif
+
+static const sh_cmd_t* const s_cmds[] = {
+    &g_cli_cmd_miu_app,
+    &g_cli_cmd_phy,
+#if (CONFIG_APP_NBR_MONITOR == 1)
+    &g_cli_cmd_nbrmon,
+#endif
+#if (CONFIG_APP_PWR_TELEMETRY == 1)
+    &g_cli_cmd_pwr,
+#endif
+#if (CONFIG_APP_POLL_CTRL == 1)
+    &g_cli_cmd_poll,
+#endif
+};
+
+static QueueHandle_t s_queue;
+static SemaphoreHandle_t s_lock;
+
+/* key, counters and stats, under s_lock */
+static uint8_t s_key[RMT_KEY_MAX];
+static uint8_t s_key_len;
+static uint16_t s_tx_id;
+static uint32_t s_tx_counter;
+static uint32_t s_tx_saved;
+static app_rmt_stats_t s_stats;
+static bool s_peers_clear; /**< a new key, the windows of the old one go */
+
+/* set once in the OpenThread task before the service starts */
+static uint8_t s_sender[RMT_SENDER_LEN];
+
+/* OpenThread task only */
+static app_rmt_msg_t s_rx_msg;
+static TickType_t s_rate_tick;
+static uint32_t s_tokens = APP_RMT_BURST;
+
+/* worker task only */
+static app_rmt_msg_t s_msg;
+static app_rmt_peer_t s_peers[APP_RMT_PEERS];
+static app_rmt_saved_t s_saved[APP_RMT_PEERS];
+static char s_line[RMT_PAYLOAD_MAX + 1];
+static char s_out[RMT_PAYLOAD_MAX + 1];
+static uint16_t s_out_len;
+static bool s_out_truncated;
+static uint8_t s_frame[RMT_FRAME_MAX];
+
+/* shell task only */
+static uint8_t s_cli_frame[RMT_FRAME_MAX];
+
+static void stat_inc(uint32_t* counter) {
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    (*counter)++;
+    xSemaphoreGive(s_lock);
+}
+
+/* token bucket, OpenThread task */
+static bool rate_take(void) {
+    TickType_t period = configTICK_RATE_HZ / APP_RMT_RATE;
+    TickType_t now = xTaskGetTickCount();
+    TickType_t elapsed = now - s_rate_tick;
+
+    if (elapsed >= period * APP_RMT_BURST) {
+        s_tokens = APP_RMT_BURST;
+        s_rate_tick = now;
+    } else if (elapsed >= period) {
+        s_tokens += elapsed / period;
+        s_rate_tick += (elapsed / period) * period;
+        if (s_tokens > APP_RMT_BURST) {
+            s_tokens = APP_RMT_BURST;
+        }
+    }
+
+    if (s_tokens == 0) {
+        return false;
+    }
+    s_tokens--;
+    return true;
+}
+
+bool app_rmt_receive(const uint8_t* p, uint16_t len,
+                     const otMessageInfo* info) {
+    if (!s_queue || !rmt_is_frame(p, len)) {
+        return false;
+    }
+
+    stat_inc(&s_stats.rx);
+    /* answers to a multicast request arrive together, only the queue
+     * bounds them */
+    if (p[1] == RMT_TYPE_REQUEST && !rate_take()) {
+        stat_inc(&s_stats.rate_limited);
+        return true;
+    }
+
+    memcpy(&s_rx_msg.addr, &info->mPeerAddr, sizeof(otIp6Address));
+    s_rx_msg.port = info->mPeerPort;
+    s_rx_msg.len = len;
+    memcpy(s_rx_msg.buf, p, len);
+    if (xQueueSend(s_queue, &s_rx_msg, 0) != pdTRUE) {
+        stat_inc(&s_stats.queue_full);
+    }
+    return true;
+}
+
+static int rmt_out(const char* fmt, ...) {
+    va_list args;
+    int len;
+
+    if (s_out_len >= RMT_PAYLOAD_MAX) {
+        s_out_truncated = true;
+        return 0;
+    }
+
+    va_start(args, fmt);
+    len = vsnprintf(&s_out[s_out_len], sizeof(s_out) - s_out_len, fmt, args);
+    va_end(args);
+
+    if (len < 0) {
+        return len;
+    }
+    if (s_out_len + len > RMT_PAYLOAD_MAX) {
+        s_out_truncated = true;
+        s_out_len = RMT_PAYLOAD_MAX;
+    } else {
+        s_out_len += len;
+    }
+    return len;
+}
+
+/* a window is never reused for another sender, or its floor would be lost */
+static app_rmt_peer_t* peer_get(const uint8_t* sender, bool* created) {
+    app_rmt_peer_t* free_peer = NULL;
+    uint8_t i;
+
+    *created = false;
+    for (i = 0; i < APP_RMT_PEERS; i++) {
+        if (!s_peers[i].valid) {
+            if (!free_peer) {
+                free_peer = &s_peers[i];
+            }
+        } else if (!memcmp(s_peers[i].sender, sender, RMT_SENDER_LEN)) {
+            return &s_peers[i];
+        }
+    }
+
+    if (free_peer) {
+        memset(free_peer, 0, sizeof(*free_peer));
+        memcpy(free_peer->sender, sender, RMT_SENDER_LEN);
+        free_peer->valid = true;
+        *created = true;
+    }
+    return free_peer;
+}
+
+/* worker task, after a counter at or above the saved floor was accepted */
+static void peers_save(void) {
+    uint8_t i;
+
+    memset(s_saved, 0, sizeof(s_saved));
+    for (i = 0; i < APP_RMT_PEERS; i++) {
+        if (s_peers[i].valid) {
+            memcpy(s_saved[i].sender, s_peers[i].sender, RMT_SENDER_LEN);
+            s_saved[i].floor = s_peers[i].saved;
+        }
+    }
+    if (efd_set_env_blob(APP_RMT_PEERS_ENV, s_saved, sizeof(s_saved))
+        != EF_NO_ERR) {
+        log_warn("rmt replay windows not saved");
+    }
+}
+
+static void peers_load(void) {
+    size_t len = 0;
+    uint8_t i;
+
+    memset(s_saved, 0, sizeof(s_saved));
+    efd_get_env_blob(APP_RMT_PEERS_ENV, s_saved, sizeof(s_saved), &len);
+    if (len != sizeof(s_saved)) {
+        return;
+    }
+    for (i = 0; i < APP_RMT_PEERS; i++) {
+        if (s_saved[i].floor) {
+            memcpy(s_peers[i].sender, s_saved[i].sender, RMT_SENDER_LEN);
+            rmt_replay_restore(&s_peers[i].window, s_saved[i].floor);
+            s_peers[i].saved = s_saved[i].floor;
+            s_peers[i].valid = true;
+        }
+    }
+}
+
+/* next request counter, under s_lock */
+static uint32_t tx_counter_next(void) {
+    s_tx_counter++;
+    if (s_tx_counter >= s_tx_saved) {
+        s_tx_saved = s_tx_counter + APP_RMT_SAVE_STEP;
+        efd_set_env_blob(APP_RMT_TX_ENV, &s_tx_saved, sizeof(s_tx_saved));
+    }
+    return s_tx_counter;
+}
+
+static void respond(const app_rmt_msg_t* msg, const rmt_frame_t* req,
+                    uint8_t status, const void* payload, uint8_t len) {
+    rmt_frame_t rsp = {
+        .type = RMT_TYPE_RESPONSE,
+        .id = req->id,
+        .counter = req->counter,
+        .status = status,
+        .len = len,
+        .payload = payload,
+    };
+    uint16_t frame_len;
+
+    memcpy(rsp.sender, s_sender, RMT_SENDER_LEN);
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    frame_len = rmt_encode(s_frame, &rsp, s_key, s_key_len);
+    s_stats.responses++;
+    xSemaphoreGive(s_lock);
+
+    app_udpSendTo(&msg->addr, msg->port, s_frame, frame_len);
+}
+
+static const sh_cmd_t* cmd_find(const char* name) {
+    uint8_t i;
+
+    for (i = 0; i < sizeof(s_cmds) / sizeof(s_cmds[0]); i++) {
+        if (!strcmp(s_cmds[i]->pCmd_name, name)) {
+            return s_cmds[i];
+        }
+    }
+    return NULL;
+}
+
+static void execute(const app_rmt_msg_t* msg, const rmt_frame_t* req) {
+    char* argv[APP_RMT_ARGC_MAX];
+    const sh_cmd_t* cmd = NULL;
+    uint8_t status = RMT_STATUS_OK;
+    char* save;
+    int argc = 0;
+
+    memcpy(s_line, req->payload, req->len);
+    s_line[req->len] = '\0';
+    log_info("rmt cmd %u: %s", req->id, s_line);
+
+    argv[0] = strtok_r(s_line, " ", &save);
+    while (argv[argc] && argc < APP_RMT_ARGC_MAX - 1) {
+        argv[++argc] = strtok_r(NULL, " ", &save);
+    }
+
+    s_out_len = 0;
+    s_out_truncated = false;
+    if (argc > 0) {
+        cmd = cmd_find(argv[0]);
+    }
+
+    if (!cmd) {
+        status = RMT_STATUS_UNKNOWN;
+        stat_inc(&s_stats.unknown);
+    } else if (cmd->cmd_exec(argc, argv, rmt_out, NULL) != 0) {
+        status = RMT_STATUS_FAILED;
+        stat_inc(&s_stats.failed);
+    } else {
+        stat_inc(&s_stats.executed);
+    }
+
+    if (s_out_truncated) {
+        status |= RMT_STATUS_TRUNCATED;
+    }
+    respond(msg, req, status, s_out, s_out_len);
+}
+
+static void response_show(const app_rmt_msg_t* msg, const rmt_frame_t* rsp) {
+    uint32_t next;
+
+    if ((rsp->status & ~RMT_STATUS_TRUNCATED) == RMT_STATUS_STALE
+        && rsp->len == sizeof(next)) {
+        /* the peer rebooted less recently than we did, catch up */
+        memcpy(&next, rsp->payload, sizeof(next));
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        if (next > s_tx_counter) {
+            s_tx_counter = next;
+        }
+        xSemaphoreGive(s_lock);
+        log_warn("rmt %u: counter stale, resend", rsp->id);
+        return;
+    }
+
+    memcpy(s_line, rsp->payload, rsp->len);
+    s_line[rsp->len] = '\0';
+    log_info("rmt %u from %04x status %02x: %s", rsp->id,
+             (msg->addr.mFields.m8[14] << 8) | msg->addr.mFields.m8[15],
+             rsp->status, s_line);
+}
+
+static void peers_clear(void) {
+    memset(s_peers, 0, sizeof(s_peers));
+    efd_del_env(APP_RMT_PEERS_ENV);
+}
+
+static void rmt_process(const app_rmt_msg_t* msg) {
+    app_rmt_peer_t* peer;
+    rmt_frame_t frame;
+    uint32_t next;
+    bool created;
+    bool clear;
+    int ret;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    ret = rmt_decode(msg->buf, msg->len, s_key, s_key_len, &frame);
+    if (ret != 0) {
+        s_stats.auth_failed++;
+    }
+    clear = s_peers_clear;
+    s_peers_clear = false;
+    xSemaphoreGive(s_lock);
+
+    if (clear) {
+        peers_clear();
+    }
+    if (ret != 0) {
+        return;
+    }
+
+    if (frame.type == RMT_TYPE_RESPONSE) {
+        response_show(msg, &frame);
+        return;
+    }
+
+    /* only a verified request may take a replay slot */
+    peer = peer_get(frame.sender, &created);
+    if (!peer) {
+        stat_inc(&s_stats.peers_full);
+        return;
+    }
+    if (created) {
+        /* it may be a capture, the sender proves itself past this counter */
+        rmt_replay_restore(&peer->window, frame.counter);
+        peer->saved = frame.counter + APP_RMT_SAVE_STEP;
+        peers_save();
+        stat_inc(&s_stats.challenged);
+        next = frame.counter + 1;
+        respond(msg, &frame, RMT_STATUS_STALE, &next, sizeof(next));
+        return;
+    }
+    if (rmt_replay_accept(&peer->window, frame.counter) != 0) {
+        stat_inc(&s_stats.replayed);
+        next = peer->window.top + 1;
+        respond(msg, &frame, RMT_STATUS_STALE, &next, sizeof(next));
+        return;
+    }
+    if (frame.counter >= peer->saved) {
+        peer->saved = frame.counter + APP_RMT_SAVE_STEP;
+        peers_save();
+    }
+
+    execute(msg, &frame);
+}
+
+static void rmt_task(void* arg) {
+    QueueHandle_t queue = arg;
+
+    for (;;) {
+        if (xQueueReceive(queue, &s_msg, portMAX_DELAY) == pdTRUE) {
+            rmt_process(&s_msg);
+        }
+    }
+}
+
+/* once a key is set, the queue is published last */
+static int rmt_start(void) {
+    QueueHandle_t queue;
+
+    if (s_queue) {
+        return 0;
+    }
+
+    queue = xQueueCreate(APP_RMT_QUEUE_LEN, sizeof(app_rmt_msg_t));
+    if (!queue
+        || xTaskCreate(rmt_task, "rmt", APP_RMT_TASK_SIZE, queue,
+                       E_TASK_PRIORITY_APP, NULL)
+               != pdPASS) {
+        log_error("remote command init failed");
+        return -1;
+    }
+    s_queue = queue;
+    log_info("remote commands running");
+    return 0;
+}
+
+void app_rmt_init(otInstance* instance) {
+    otExtAddress eui64;
+    size_t len = 0;
+
+    otLinkGetFactoryAssignedIeeeEui64(instance, &eui64);
+    memcpy(s_sender, eui64.m8, RMT_SENDER_LEN);
+
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock) {
+        log_error("remote command init failed");
+        return;
+    }
+
+    efd_get_env_blob(APP_RMT_TX_ENV, &s_tx_saved, sizeof(s_tx_saved), &len);
+    if (len != sizeof(s_tx_saved)) {
+        s_tx_saved = 0;
+    }
+    s_tx_counter = s_tx_saved;
+    peers_load();
+    s_rate_tick = xTaskGetTickCount();
+
+    len = 0;
+    efd_get_env_blob(APP_RMT_KEY_ENV, s_key, sizeof(s_key), &len);
+    if (len > 0 && len <= RMT_KEY_MAX) {
+        s_key_len = len;
+#ifdef CONFIG_APP_RMT_KEY
+    } else if (strlen(CONFIG_APP_RMT_KEY) > 0) {
+        s_key_len = strlen(CONFIG_APP_RMT_KEY);
+        if (s_key_len > RMT_KEY_MAX) {
+            s_key_len = RMT_KEY_MAX;
+        }
+        memcpy(s_key, CONFIG_APP_RMT_KEY, s_key_len);
+#endif
+    } else {
+        log_warn("remote commands off until a key is set: rmt key <string>");
+        return;
+    }
+
+    rmt_start();
+}
+
+static int cli_send(int argc, char** argv, cb_shell_out_t log_out) {
+    otIp6Address addr;
+    rmt_frame_t req = {.type = RMT_TYPE_REQUEST};
+    uint8_t* payload = &s_cli_frame[RMT_HDR_LEN];
+    uint16_t len = 0;
+    uint16_t frame_len;
+    int i;
+
+    if (otIp6AddressFromString(argv[2], &addr) != OT_ERROR_NONE) {
+        log_out("Invalid address \r\n");
+        return -1;
+    }
+
+    for (i = 3; i < argc; i++) {
+        size_t n = strlen(argv[i]);
+
+        if (len + n + (i > 3) > RMT_PAYLOAD_MAX) {
+            log_out("Command too long \r\n");
+            return -1;
+        }
+        if (i > 3) {
+            payload[len++] = ' ';
+        }
+        memcpy(&payload[len], argv[i], n);
+        len += n;
+    }
+
+    req.len = len;
+    req.payload = payload;
+
+    memcpy(req.sender, s_sender, RMT_SENDER_LEN);
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    req.id = ++s_tx_id;
+    req.counter = tx_counter_next();
+    frame_len = rmt_encode(s_cli_frame, &req, s_key, s_key_len);
+    xSemaphoreGive(s_lock);
+
+    app_udpSend(addr, s_cli_frame, frame_len);
+#if (CONFIG_APP_POLL_CTRL == 1)
+    app_poll_tx();
+    app_poll_expect(APP_RMT_REPLY_MS);
+#endif
+
+    log_out("id %u \r\n", req.id);
+    return 0;
+}
+
+static void cli_show(cb_shell_out_t log_out) {
+    app_rmt_stats_t stats;
+    uint32_t counter;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    stats = s_stats;
+    counter = s_tx_counter;
+    xSemaphoreGive(s_lock);
+
+    log_out("key             : %u bytes\r\n", s_key_len);
+    log_out("sender          : %02x%02x%02x%02x%02x%02x%02x%02x\r\n",
+            s_sender[0], s_sender[1], s_sender[2], s_sender[3], s_sender[4],
+            s_sender[5], s_sender[6], s_sender[7]);
+    log_out("tx counter      : %lu\r\n", (unsigned long)counter);
+    log_out("queued          : %lu / %u\r\n",
+            (unsigned long)uxQueueMessagesWaiting(s_queue), APP_RMT_QUEUE_LEN);
+    log_out("rx              : %lu\r\n", (unsigned long)stats.rx);
+    log_out("rate limited    : %lu\r\n", (unsigned long)stats.rate_limited);
+    log_out("queue full      : %lu\r\n", (unsigned long)stats.queue_full);
+    log_out("auth failed     : %lu\r\n", (unsigned long)stats.auth_failed);
+    log_out("replayed        : %lu\r\n", (unsigned long)stats.replayed);
+    log_out("challenged      : %lu\r\n", (unsigned long)stats.challenged);
+    log_out("senders full    : %lu / %u\r\n", (unsigned long)stats.peers_full,
+            APP_RMT_PEERS);
+    log_out("ok/failed/unknw : %lu / %lu / %lu\r\n",
+            (unsigned long)stats.executed, (unsigned long)stats.failed,
+            (unsigned long)stats.unknown);
+    log_out("responses       : %lu\r\n", (unsigned long)stats.responses);
+}
+
+static int cli_key(const char* key, cb_shell_out_t log_out) {
+    size_t len = strlen(key);
+
+    if (len > RMT_KEY_MAX) {
+        log_out("Key longer than %u \r\n", RMT_KEY_MAX);
+        return -1;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (len != s_key_len || memcmp(s_key, key, len)) {
+        /* frames of the old key fail the tag now, their windows can go */
+        s_peers_clear = true;
+    }
+    memcpy(s_key, key, len);
+    s_key_len = len;
+    xSemaphoreGive(s_lock);
+
+    if (efd_set_env_blob(APP_RMT_KEY_ENV, key, len) != EF_NO_ERR) {
+        log_out("Key not saved, lost on reboot \r\n");
+    }
+    return rmt_start();
+}
+
+static int _cli_cmd_rmt(int argc, char** argv, cb_shell_out_t log_out,
+                        void* pExtra) {
+    if (!s_lock) {
+        log_out("remote commands not running \r\n");
+        return -1;
+    }
+
+    if (argc > 2 && !strncmp(argv[1], "key", 3)) {
+        if (cli_key(argv[2], log_out) != 0) {
+            return -1;
+        }
+    } else if (!s_queue) {
+        log_out("remote commands off until a key is set: rmt key <string> \r\n");
+        return -1;
+    } else if (argc > 1 && !strncmp(argv[1], "show", 4)) {
+        cli_show(log_out);
+    } else if (argc > 3 && !strncmp(argv[1], "send", 4)) {
+        return cli_send(argc, argv, log_out);
+    } else if (argc > 2 && !strncmp(argv[1], "counter", 7)) {
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        s_tx_counter = strtoul(argv[2], NULL, 10);
+        xSemaphoreGive(s_lock);
+    } else if (argc > 1 && !strncmp(argv[1], "reset", 5)) {
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        memset(&s_stats, 0, sizeof(s_stats));
+        xSemaphoreGive(s_lock);
+    } else {
+        log_out("rmt show \r\n");
+        log_out("rmt send <ipv6> <command> \r\n");
+        log_out("rmt key <string> \r\n");
+        log_out("rmt counter <n> \r\n");
+        log_out("rmt reset \r\n");
+        return 0;
+    }
+
+    log_out("+Ok \r\n");
+    return 0;
+}
+
+const sh_cmd_t g_cli_cmd_rmt STATIC_CLI_CMD_ATTRIBUTE = {
+    .pCmd_name = "rmt",
+    .pDescription = "Authenticated remote commands : see rmt help",
+    .cmd_exec = _cli_cmd_rmt,
+};
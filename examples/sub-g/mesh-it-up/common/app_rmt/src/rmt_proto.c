@@ -0,0 +1,129 @@
+/**
+ * @file rmt_proto.c
+ * @brief Remote command framing, authentication and replay window, see
+ *        rmt_proto.h
+ */
+
+#include <string.h>
+#include "hosal_crypto_sha256.h"
+#include "rmt_proto.h"
+
+static void put_le16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static void put_le32(uint8_t* p, uint32_t v) {
+    put_le16(p, v & 0xffff);
+    put_le16(p + 2, v >> 16);
+}
+
+static uint16_t get_le16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_le32(const uint8_t* p) {
+    return get_le16(p) | ((uint32_t)get_le16(p + 2) << 16);
+}
+
+/* same time whatever the first difference */
+static bool tag_equal(const uint8_t* a, const uint8_t* b) {
+    uint8_t diff = 0;
+    uint8_t i;
+
+    for (i = 0; i < RMT_TAG_LEN; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+static void tag_compute(const uint8_t* buf, uint16_t len, const uint8_t* key,
+                        uint8_t key_len, uint8_t* tag) {
+    uint8_t digest[SHA256_DIGEST_SIZE];
+
+    hmac_sha256(key, key_len, buf, len, digest);
+    memcpy(tag, digest, RMT_TAG_LEN);
+}
+
+bool rmt_is_frame(const uint8_t* buf, uint16_t len) {
+    return len >= RMT_HDR_LEN + RMT_TAG_LEN && buf[0] == RMT_MAGIC
+           && (buf[1] == RMT_TYPE_REQUEST || buf[1] == RMT_TYPE_RESPONSE)
+           && buf[17] <= RMT_PAYLOAD_MAX
+           && len == RMT_HDR_LEN + buf[17] + RMT_TAG_LEN;
+}
+
+uint16_t rmt_encode(uint8_t* buf, const rmt_frame_t* frame, const uint8_t* key,
+                    uint8_t key_len) {
+    uint16_t len = RMT_HDR_LEN + frame->len;
+
+    if (frame->len > RMT_PAYLOAD_MAX) {
+        return 0;
+    }
+
+    if (frame->len && frame->payload != &buf[RMT_HDR_LEN]) {
+        memmove(&buf[RMT_HDR_LEN], frame->payload, frame->len);
+    }
+
+    buf[0] = RMT_MAGIC;
+    buf[1] = frame->type;
+    put_le16(&buf[2], frame->id);
+    memcpy(&buf[4], frame->sender, RMT_SENDER_LEN);
+    put_le32(&buf[12], frame->counter);
+    buf[16] = frame->status;
+    buf[17] = frame->len;
+
+    tag_compute(buf, len, key, key_len, &buf[len]);
+    return len + RMT_TAG_LEN;
+}
+
+int rmt_decode(const uint8_t* buf, uint16_t len, const uint8_t* key,
+               uint8_t key_len, rmt_frame_t* frame) {
+    uint8_t tag[RMT_TAG_LEN];
+
+    if (!rmt_is_frame(buf, len)) {
+        return RMT_ERR_FORMAT;
+    }
+
+    len -= RMT_TAG_LEN;
+    tag_compute(buf, len, key, key_len, tag);
+    if (!tag_equal(tag, &buf[len])) {
+        return RMT_ERR_AUTH;
+    }
+
+    frame->type = buf[1];
+    frame->id = get_le16(&buf[2]);
+    memcpy(frame->sender, &buf[4], RMT_SENDER_LEN);
+    frame->counter = get_le32(&buf[12]);
+    frame->status = buf[16];
+    frame->len = buf[17];
+    frame->payload = &buf[RMT_HDR_LEN];
+    return 0;
+}
+
+int rmt_replay_accept(rmt_replay_t* window, uint32_t counter) {
+    uint32_t behind;
+
+    if (counter == 0) {
+        return -1;
+    }
+
+    if (counter > window->top) {
+        behind = counter - window->top;
+        window->mask = behind < RMT_REPLAY_WINDOW ? window->mask << behind : 0;
+        window->mask |= 1;
+        window->top = counter;
+        return 0;
+    }
+
+    behind = window->top - counter;
+    if (behind >= RMT_REPLAY_WINDOW || (window->mask & (1UL << behind))) {
+        return -1;
+    }
+    window->mask |= 1UL << behind;
+    return 0;
+}
+
+void rmt_replay_restore(rmt_replay_t* window, uint32_t floor) {
+    window->top = floor;
+    window->mask = floor ? 0xffffffffUL : 0;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file app_udp.h
+ * @brief Application UDP service of the mesh-it-up devices: one bound
+ *        socket, per-destination batching of small records and heap-free
+ *        receive.
+ *
+ * Every call into the stack runs with the stack lock held, the batch timer
+ * only posts the flush to the OpenThread task.
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+
+#ifndef __APP_UDP_H
+#define __APP_UDP_H
+
+#include <stdint.h>
+#include <openthread/instance.h>
+#include <openthread/ip6.h>
+#include <openthread/message.h>
+
+/* Records queued to one destination leave together within this budget */
+#ifndef APP_UDP_BATCH_LATENCY_MS
+#define APP_UDP_BATCH_LATENCY_MS 200
+#endif
+
+/* Batch datagram payload size */
+#ifndef APP_UDP_BATCH_SIZE
+#define APP_UDP_BATCH_SIZE 256
+#endif
+
+/* Destinations batched at once */
+#ifndef APP_UDP_BATCH_DEST
+#define APP_UDP_BATCH_DEST 4
+#endif
+
+/* Message buffers the application never takes from the stack */
+#ifndef APP_UDP_RESERVED_BUFFERS
+#define APP_UDP_RESERVED_BUFFERS 8
+#endif
+
+/* Largest datagram received, longer ones are dropped */
+#ifndef APP_UDP_RX_MAX
+#define APP_UDP_RX_MAX 512
+#endif
+
+typedef struct {
+    uint32_t tx_datagrams;
+    uint32_t tx_bytes;
+    uint32_t tx_records;      /* queued with app_udpQueue() */
+    uint32_t tx_batches;
+    uint32_t records_dropped; /* lost with a batch that could not be sent */
+    uint32_t reserve_refused; /* pool down to APP_UDP_RESERVED_BUFFERS */
+    uint32_t alloc_failed;    /* pool exhausted */
+    uint32_t send_failed;
+    uint32_t rx_datagrams;
+    uint32_t rx_records;
+    uint32_t rx_oversize;
+} app_udp_stats_t;
+
+/* p is only valid during the call, p[len] is '\0' */
+typedef void (*app_udp_handler_t)(uint8_t* p, uint16_t len,
+                                  const otMessageInfo* info);
+
+uint8_t app_sockInit(otInstance* instance, app_udp_handler_t handler,
+                     uint16_t udp_port);
+
+void app_udpSend(otIp6Address dstaddr, uint8_t* p, uint16_t len);
+
+/* Send to another port, such as the one a request came from */
+void app_udpSendTo(const otIp6Address* dstaddr, uint16_t port,
+                   const uint8_t* p, uint16_t len);
+
+/* Queue a record for the next batch to dstaddr, -1 when too long */
+int app_udpQueue(const otIp6Address* dstaddr, const uint8_t* p, uint8_t len);
+
+/* Send every open batch now */
+void app_udpFlush(void);
+
+void app_udpStats(app_udp_stats_t* stats);
+void app_udpStatsReset(void);
+
+#endif // __APP_UDP_H
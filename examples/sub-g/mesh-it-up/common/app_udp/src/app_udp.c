@@ -0,0 +1,374 @@
+/**
+ * @file app_udp.c
+ * @author Rex Huang (rex.huang@rafaelmicro.com)
+ * @brief Application UDP service: one bound socket, bounded use of the
+ *        OpenThread message pool, per-destination batching of small
+ *        records and heap-free receive.
+ *
+ * Lock order is the stack lock of the port, then appUdpLock. The batch
+ * timer runs in the timer daemon, which must not call the stack, so it
+ * only posts the flush job and the flush itself runs in the OpenThread
+ * task.
+ * @version 0.1
+ * @date 2023-10-06
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <miu_port.h>
+#include <openthread/message.h>
+#include <openthread/thread.h>
+#include <openthread/udp.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+#include "timers.h"
+
+#include "app_ot_job.h"
+#include "app_udp.h"
+#include "log.h"
+#include "string.h"
+
+/* A batch datagram is the magic byte followed by records, each a length
+ * byte and that many payload bytes */
+#define APP_UDP_BATCH_MAGIC 0xB7
+
+typedef struct {
+    otIp6Address dst;
+    TickType_t deadline;
+    uint16_t len;
+    uint8_t records;
+    uint8_t used;
+    uint8_t buf[APP_UDP_BATCH_SIZE];
+} app_udp_batch_t;
+
+static otUdpSocket appSock;
+static app_udp_handler_t app_udpHandler;
+static uint16_t appUdpPort = CONFIG_APP_TASK_UDP_LISTEN_PORT;
+
+static SemaphoreHandle_t appUdpLock;
+static TimerHandle_t appUdpTimer;
+static int appUdpJob = -1;
+static app_udp_batch_t appUdpBatch[APP_UDP_BATCH_DEST];
+static app_udp_stats_t appUdpStats;
+
+/* Receive runs in the OpenThread task only, one datagram at a time. The
+ * extra byte keeps every delivered slice NUL terminated. */
+static uint8_t appUdpRxBuf[APP_UDP_RX_MAX + 1];
+
+static otError udp_send_buf(const otIp6Address* dstaddr, uint16_t port,
+                            const uint8_t* p, uint16_t len) {
+    otInstance* instance = otrGetInstance();
+    otMessageSettings settings = {
+        .mLinkSecurityEnabled = true,
+        .mPriority = OT_MESSAGE_PRIORITY_NORMAL,
+    };
+    otMessageInfo messageInfo;
+    otBufferInfo bufferInfo;
+    otMessage* pmsg;
+    otError error;
+
+    /* leave the last buffers to MLE and the MAC, a burst of application
+     * traffic must not detach the node */
+    otMessageGetBufferInfo(instance, &bufferInfo);
+    if (bufferInfo.mFreeBuffers <= APP_UDP_RESERVED_BUFFERS) {
+        appUdpStats.reserve_refused++;
+        return OT_ERROR_NO_BUFS;
+    }
+
+    pmsg = otUdpNewMessage(instance, &settings);
+    if (pmsg == NULL) {
+        appUdpStats.alloc_failed++;
+        return OT_ERROR_NO_BUFS;
+    }
+
+    error = otMessageAppend(pmsg, p, len);
+    if (error != OT_ERROR_NONE) {
+        appUdpStats.alloc_failed++;
+        otMessageFree(pmsg);
+        return error;
+    }
+
+    memset(&messageInfo, 0, sizeof(messageInfo));
+    memcpy(messageInfo.mPeerAddr.mFields.m8, dstaddr, OT_IP6_ADDRESS_SIZE);
+    messageInfo.mPeerPort = port;
+    messageInfo.mHopLimit = 255;
+    messageInfo.mAllowZeroHopLimit = false;
+
+    error = otUdpSend(instance, &appSock, pmsg, &messageInfo);
+    if (error != OT_ERROR_NONE) {
+        appUdpStats.send_failed++;
+        otMessageFree(pmsg);
+        return error;
+    }
+
+    appUdpStats.tx_datagrams++;
+    appUdpStats.tx_bytes += len;
+    return OT_ERROR_NONE;
+}
+
+/* lock held */
+static void batch_flush(app_udp_batch_t* batch) {
+    if (!batch->used) {
+        return;
+    }
+    if (batch->len > 1) {
+        if (udp_send_buf(&batch->dst, appUdpPort, batch->buf, batch->len)
+            == OT_ERROR_NONE) {
+            appUdpStats.tx_batches++;
+        } else {
+            appUdpStats.records_dropped += batch->records;
+        }
+    }
+    batch->used = 0;
+}
+
+/* lock held, earliest deadline of the open batches */
+static void batch_timer_arm(void) {
+    TickType_t now = xTaskGetTickCount();
+    TickType_t wait = portMAX_DELAY;
+    int32_t left;
+    uint8_t i;
+
+    for (i = 0; i < APP_UDP_BATCH_DEST; i++) {
+        if (!appUdpBatch[i].used) {
+            continue;
+        }
+        left = (int32_t)(appUdpBatch[i].deadline - now);
+        if (left < 0) {
+            left = 0; /* already due */
+        }
+        if ((TickType_t)left < wait) {
+            wait = (TickType_t)left;
+        }
+    }
+
+    if (wait == portMAX_DELAY) {
+        xTimerStop(appUdpTimer, 0);
+    } else {
+        xTimerChangePeriod(appUdpTimer, wait ? wait : 1, 0);
+    }
+}
+
+/* OpenThread task, the stack lock is held by the port */
+static void batch_flush_due(otInstance* instance) {
+    TickType_t now = xTaskGetTickCount();
+    uint8_t i;
+
+    (void)instance;
+
+    xSemaphoreTake(appUdpLock, portMAX_DELAY);
+    for (i = 0; i < APP_UDP_BATCH_DEST; i++) {
+        if (appUdpBatch[i].used
+            && (int32_t)(now - appUdpBatch[i].deadline) >= 0) {
+            batch_flush(&appUdpBatch[i]);
+        }
+    }
+    batch_timer_arm();
+    xSemaphoreGive(appUdpLock);
+}
+
+static void batch_timer_cb(TimerHandle_t timer) {
+    (void)timer;
+
+    app_ot_job_post(appUdpJob);
+}
+
+/* lock held, the open batch to dstaddr or a fresh one */
+static app_udp_batch_t* batch_get(const otIp6Address* dstaddr) {
+    app_udp_batch_t* batch = NULL;
+    app_udp_batch_t* oldest = &appUdpBatch[0];
+    uint8_t i;
+
+    for (i = 0; i < APP_UDP_BATCH_DEST; i++) {
+        if (appUdpBatch[i].used) {
+            if (!memcmp(&appUdpBatch[i].dst, dstaddr, sizeof(*dstaddr))) {
+                return &appUdpBatch[i];
+            }
+            if ((int32_t)(appUdpBatch[i].deadline - oldest->deadline) < 0) {
+                oldest = &appUdpBatch[i];
+            }
+        } else if (!batch) {
+            batch = &appUdpBatch[i];
+        }
+    }
+
+    if (!batch) {
+        /* every slot busy, send the one waiting longest early */
+        batch_flush(oldest);
+        batch = oldest;
+    }
+
+    memcpy(&batch->dst, dstaddr, sizeof(*dstaddr));
+    batch->deadline = xTaskGetTickCount() + pdMS_TO_TICKS(APP_UDP_BATCH_LATENCY_MS);
+    batch->buf[0] = APP_UDP_BATCH_MAGIC;
+    batch->len = 1;
+    batch->records = 0;
+    batch->used = 1;
+    return batch;
+}
+
+static void deliver(uint8_t* p, uint16_t len, const otMessageInfo* aMessageInfo) {
+    uint8_t saved = p[len];
+
+    p[len] = '\0';
+    app_udpHandler(p, len, aMessageInfo);
+    p[len] = saved;
+}
+
+/* a well formed batch, records fill the datagram exactly */
+static bool is_batch(const uint8_t* p, uint16_t len) {
+    uint16_t off = 1;
+
+    if (len < 2 || p[0] != APP_UDP_BATCH_MAGIC) {
+        return false;
+    }
+    while (off < len) {
+        off += 1 + p[off];
+    }
+    return off == len;
+}
+
+static void otUdpReceive_handler(void* aContext, otMessage* aMessage,
+                                 const otMessageInfo* aMessageInfo) {
+    uint16_t offset = otMessageGetOffset(aMessage);
+    uint16_t len = otMessageGetLength(aMessage) - offset;
+    uint16_t off;
+
+    log_info("UPD Packet received, port: %d, len: %d", aMessageInfo->mPeerPort,
+             len);
+
+    appUdpStats.rx_datagrams++;
+    if (!app_udpHandler) {
+        return;
+    }
+    if (len > APP_UDP_RX_MAX) {
+        appUdpStats.rx_oversize++;
+        return;
+    }
+
+    len = otMessageRead(aMessage, offset, appUdpRxBuf, len);
+
+    if (!is_batch(appUdpRxBuf, len)) {
+        appUdpStats.rx_records++;
+        deliver(appUdpRxBuf, len, aMessageInfo);
+        return;
+    }
+
+    for (off = 1; off < len; off += 1 + appUdpRxBuf[off]) {
+        appUdpStats.rx_records++;
+        deliver(&appUdpRxBuf[off + 1], appUdpRxBuf[off], aMessageInfo);
+    }
+}
+
+void app_udpSendTo(const otIp6Address* dstaddr, uint16_t port,
+                   const uint8_t* p, uint16_t len) {
+    uint8_t i;
+
+    otrLock();
+    xSemaphoreTake(appUdpLock, portMAX_DELAY);
+    /* keep the order of what was queued before */
+    for (i = 0; i < APP_UDP_BATCH_DEST; i++) {
+        if (appUdpBatch[i].used
+            && !memcmp(&appUdpBatch[i].dst, dstaddr, sizeof(*dstaddr))) {
+            batch_flush(&appUdpBatch[i]);
+        }
+    }
+    udp_send_buf(dstaddr, port, p, len);
+    xSemaphoreGive(appUdpLock);
+    otrUnlock();
+}
+
+void app_udpSend(otIp6Address dstaddr, uint8_t* p, uint16_t len) {
+    app_udpSendTo(&dstaddr, appUdpPort, p, len);
+}
+
+int app_udpQueue(const otIp6Address* dstaddr, const uint8_t* p, uint8_t len) {
+    app_udp_batch_t* batch;
+
+    if (len == 0 || 2 + len > APP_UDP_BATCH_SIZE) {
+        return -1;
+    }
+
+    otrLock();
+    xSemaphoreTake(appUdpLock, portMAX_DELAY);
+    batch = batch_get(dstaddr);
+    if (batch->len + 1 + len > APP_UDP_BATCH_SIZE) {
+        batch_flush(batch);
+        batch = batch_get(dstaddr);
+    }
+
+    batch->buf[batch->len++] = len;
+    memcpy(&batch->buf[batch->len], p, len);
+    batch->len += len;
+    appUdpStats.tx_records++;
+
+    if (++batch->records == 1) {
+        batch_timer_arm();
+    }
+    xSemaphoreGive(appUdpLock);
+    otrUnlock();
+    return 0;
+}
+
+void app_udpFlush(void) {
+    uint8_t i;
+
+    otrLock();
+    xSemaphoreTake(appUdpLock, portMAX_DELAY);
+    for (i = 0; i < APP_UDP_BATCH_DEST; i++) {
+        batch_flush(&appUdpBatch[i]);
+    }
+    xTimerStop(appUdpTimer, 0);
+    xSemaphoreGive(appUdpLock);
+    otrUnlock();
+}
+
+void app_udpStats(app_udp_stats_t* stats) {
+    xSemaphoreTake(appUdpLock, portMAX_DELAY);
+    *stats = appUdpStats;
+    xSemaphoreGive(appUdpLock);
+}
+
+void app_udpStatsReset(void) {
+    xSemaphoreTake(appUdpLock, portMAX_DELAY);
+    memset(&appUdpStats, 0, sizeof(appUdpStats));
+    xSemaphoreGive(appUdpLock);
+}
+
+uint8_t app_sockInit(otInstance* instance, app_udp_handler_t handler,
+                     uint16_t udp_port) {
+    otSockAddr sockAddr;
+
+    uint8_t ret;
+
+    memset(&appSock, 0, sizeof(otUdpSocket));
+    memset(&sockAddr, 0, sizeof(otSockAddr));
+
+    if (!appUdpLock) {
+        appUdpLock = xSemaphoreCreateMutex();
+        appUdpTimer = xTimerCreate("udp_batch",
+                                   pdMS_TO_TICKS(APP_UDP_BATCH_LATENCY_MS),
+                                   pdFALSE, NULL, batch_timer_cb);
+        appUdpJob = app_ot_job_register(batch_flush_due);
+        if (!appUdpLock || !appUdpTimer || appUdpJob < 0) {
+            return OT_ERROR_NO_BUFS;
+        }
+    }
+
+    ret = otUdpOpen(instance, &appSock, otUdpReceive_handler, instance);
+
+    if (OT_ERROR_NONE == ret) {
+        app_udpHandler = handler;
+        appUdpPort = udp_port;
+        sockAddr.mPort = appUdpPort;
+        ret = otUdpBind(instance, &appSock, &sockAddr, OT_NETIF_THREAD_HOST);
+        if (OT_ERROR_NONE == ret) {
+            log_info("UDP PORT           : 0x%x", sockAddr.mPort);
+        }
+    }
+
+    return ret;
+}
@@ -0,0 +1,618 @@
+/*
+ *  Copyright (c) 2016, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "openthread-core-config.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+
+// #include <openthread-system.h>
+#include <openthread/cli.h>
+#include <openthread/logging.h>
+
+// #include "cli/cli_config.h"
+#include "common/code_utils.hpp"
+#include "common/debug.hpp"
+#include "common/new.hpp"
+#include "common/tasklet.hpp"
+#if __has_include("instance/instance.hpp")
+#include "instance/instance.hpp"
+#else
+#include "common/instance.hpp"
+#endif
+#include "uart.h"
+
+#if OPENTHREAD_POSIX
+#include <signal.h>
+#include <sys/types.h>
+#endif
+
+/**
+ * @def OPENTHREAD_CONFIG_CLI_UART_RX_BUFFER_SIZE
+ *
+ * The size of CLI UART RX buffer in bytes.
+ *
+ */
+#ifndef OPENTHREAD_CONFIG_CLI_UART_RX_BUFFER_SIZE
+#if OPENTHREAD_CONFIG_REFERENCE_DEVICE_ENABLE
+#define OPENTHREAD_CONFIG_CLI_UART_RX_BUFFER_SIZE 640
+#else
+#define OPENTHREAD_CONFIG_CLI_UART_RX_BUFFER_SIZE 512
+#endif
+#endif
+
+/**
+ * @def OPENTHREAD_CONFIG_CLI_TX_BUFFER_SIZE
+ *
+ * The size of CLI message buffer in bytes. Output that does not fit while
+ * the UART drains waits in heap chunks, in order, and is moved in as the
+ * UART completes.
+ *
+ */
+#ifndef OPENTHREAD_CONFIG_CLI_UART_TX_BUFFER_SIZE
+#define OPENTHREAD_CONFIG_CLI_UART_TX_BUFFER_SIZE 2048
+#endif
+
+/**
+ * @def OPENTHREAD_CONFIG_CLI_UART_TX_SPILL_MAX
+ *
+ * The heap bytes output waiting for the TX buffer may take at once. Output
+ * past it is dropped and reported once drained. Commands typed meanwhile
+ * wait until the waiting output has drained.
+ *
+ */
+#ifndef OPENTHREAD_CONFIG_CLI_UART_TX_SPILL_MAX
+#define OPENTHREAD_CONFIG_CLI_UART_TX_SPILL_MAX (2 * OPENTHREAD_CONFIG_CLI_UART_TX_BUFFER_SIZE)
+#endif
+
+#if OPENTHREAD_CONFIG_DIAG_ENABLE
+#if OPENTHREAD_CONFIG_DIAG_OUTPUT_BUFFER_SIZE > OPENTHREAD_CONFIG_CLI_UART_TX_BUFFER_SIZE
+#error "diag output buffer should be smaller than CLI UART tx buffer"
+#endif
+#if OPENTHREAD_CONFIG_DIAG_CMD_LINE_BUFFER_SIZE > OPENTHREAD_CONFIG_CLI_UART_RX_BUFFER_SIZE
+#error "diag command line should be smaller than CLI UART rx buffer"
+#endif
+#endif
+
+#if OPENTHREAD_CONFIG_CLI_MAX_LINE_LENGTH > OPENTHREAD_CONFIG_CLI_UART_RX_BUFFER_SIZE
+#error "command line should be should be smaller than CLI rx buffer"
+#endif
+
+enum
+{
+    kRxBufferSize   = OPENTHREAD_CONFIG_CLI_UART_RX_BUFFER_SIZE,
+    kTxBufferSize   = OPENTHREAD_CONFIG_CLI_UART_TX_BUFFER_SIZE,
+    kTxResumeLength = kTxBufferSize / 4, ///< A held command runs once the TX buffer is drained to this.
+    kTxSpillMax     = OPENTHREAD_CONFIG_CLI_UART_TX_SPILL_MAX,
+};
+
+/* Output that did not fit in sTxBuffer, oldest first */
+struct TxChunk
+{
+    TxChunk *mNext;
+    uint16_t mLength;
+    uint16_t mOffset;
+    char     mData[1];
+};
+
+char     sRxBuffer[kRxBufferSize];
+uint16_t sRxLength;
+
+/* A complete line waits in sRxBuffer while the output of the previous
+ * command drains, input received meanwhile is kept in sRxBacklog. */
+bool     sRxHeld;
+char     sRxBacklog[kRxBufferSize];
+uint16_t sRxBacklogLength;
+
+char     sTxBuffer[kTxBufferSize];
+uint16_t sTxHead;
+uint16_t sTxLength;
+
+uint16_t sSendLength;
+uint32_t sTxDropped;
+
+static TxChunk *sTxSpillHead;
+static TxChunk *sTxSpillTail;
+static uint32_t sTxSpilled; ///< Bytes in the chunks, at most kTxSpillMax
+
+static ot::Tasklet *sTasklet;
+alignas(ot::Tasklet) static uint8_t sTaskletRaw[sizeof(ot::Tasklet)];
+
+#ifdef OT_CLI_UART_LOCK_HDR_FILE
+
+#include OT_CLI_UART_LOCK_HDR_FILE
+
+#else
+
+/**
+ * Macro to acquire an exclusive lock of uart cli output
+ * Default implementation does nothing
+ *
+ */
+#ifndef OT_CLI_UART_OUTPUT_LOCK
+#define OT_CLI_UART_OUTPUT_LOCK() \
+    do                            \
+    {                             \
+    } while (0)
+#endif
+
+/**
+ * Macro to release the exclusive lock of uart cli output
+ * Default implementation does nothing
+ *
+ */
+#ifndef OT_CLI_UART_OUTPUT_UNLOCK
+#define OT_CLI_UART_OUTPUT_UNLOCK() \
+    do                              \
+    {                               \
+    } while (0)
+#endif
+
+#endif // OT_CLI_UART_LOCK_HDR_FILE
+
+static int     Output(const char *aBuf, uint16_t aBufLength);
+static otError ProcessCommand(void);
+static void    Send(void);
+static void    Drain(void);
+
+/* Room for the output of the next command */
+static bool TxReady(void) { return sTxSpillHead == nullptr && sTxLength <= kTxResumeLength; }
+
+static void BacklogAppend(const uint8_t *aBuf, uint16_t aBufLength)
+{
+    if (aBufLength > kRxBufferSize - sRxBacklogLength)
+    {
+        aBufLength = kRxBufferSize - sRxBacklogLength;
+    }
+
+    // aBuf may point into the backlog itself when it is replayed
+    memmove(&sRxBacklog[sRxBacklogLength], aBuf, aBufLength);
+    sRxBacklogLength += aBufLength;
+}
+
+static void ReceiveTask(const uint8_t *aBuf, uint16_t aBufLength)
+{
+    static const char sEraseString[] = {'\b', ' ', '\b'};
+    static const char CRNL[]         = {'\r', '\n'};
+    static uint8_t    sLastChar      = '\0';
+    const uint8_t    *end;
+
+    end = aBuf + aBufLength;
+
+    if (sRxHeld)
+    {
+        BacklogAppend(aBuf, aBufLength);
+        ExitNow();
+    }
+
+    for (; aBuf < end; aBuf++)
+    {
+        switch (*aBuf)
+        {
+        case '\n':
+            if (sLastChar == '\r')
+            {
+                break;
+            }
+
+            OT_FALL_THROUGH;
+
+        case '\r':
+            Output(CRNL, sizeof(CRNL));
+            sRxBuffer[sRxLength] = '\0';
+
+            if (!TxReady())
+            {
+                // Still sending the previous output, run from the tasklet
+                // posted on send done rather than overflow the TX buffer.
+                sRxHeld   = true;
+                sLastChar = *aBuf;
+                BacklogAppend(aBuf + 1, static_cast<uint16_t>(end - aBuf - 1));
+                ExitNow();
+            }
+
+            IgnoreError(ProcessCommand());
+            break;
+
+#if OPENTHREAD_POSIX && !defined(FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION)
+        case 0x03: // ASCII for Ctrl-C
+            kill(0, SIGINT);
+            break;
+
+        case 0x04: // ASCII for Ctrl-D
+            exit(EXIT_SUCCESS);
+            break;
+#endif
+
+        case '\b':
+        case 127:
+            if (sRxLength > 0)
+            {
+                Output(sEraseString, sizeof(sEraseString));
+                sRxBuffer[--sRxLength] = '\0';
+            }
+
+            break;
+
+        default:
+            if (sRxLength < kRxBufferSize - 1)
+            {
+                Output(reinterpret_cast<const char *>(aBuf), 1);
+                sRxBuffer[sRxLength++] = static_cast<char>(*aBuf);
+            }
+
+            break;
+        }
+
+        sLastChar = *aBuf;
+    }
+
+exit:
+    return;
+}
+
+static otError ProcessCommand(void)
+{
+    otError error = OT_ERROR_NONE;
+
+    while (sRxLength > 0 && (sRxBuffer[sRxLength - 1] == '\n' || sRxBuffer[sRxLength - 1] == '\r'))
+    {
+        sRxBuffer[--sRxLength] = '\0';
+    }
+
+    otCliInputLine(sRxBuffer);
+    sRxLength = 0;
+
+    return error;
+}
+
+/**
+ * Retry a send the UART refused and run a held command once its output has
+ * drained.
+ *
+ */
+static void HandleTasklet(ot::Tasklet &aTasklet)
+{
+    OT_UNUSED_VARIABLE(aTasklet);
+
+    uint16_t length;
+
+    OT_CLI_UART_OUTPUT_LOCK();
+    Drain();
+    Send();
+    OT_CLI_UART_OUTPUT_UNLOCK();
+
+    VerifyOrExit(sRxHeld && TxReady());
+
+    sRxHeld = false;
+    IgnoreError(ProcessCommand());
+
+    // Replay what was typed meanwhile, it may hold the next line again.
+    length           = sRxBacklogLength;
+    sRxBacklogLength = 0;
+    ReceiveTask(reinterpret_cast<const uint8_t *>(sRxBacklog), length);
+
+exit:
+    return;
+}
+
+static uint16_t TxTail(void)
+{
+    uint16_t tail = sTxHead + sTxLength;
+
+    return tail >= kTxBufferSize ? tail - kTxBufferSize : tail;
+}
+
+/**
+ * Copy what fits into the TX buffer, in at most two pieces.
+ *
+ */
+static uint16_t Enqueue(const char *aBuf, uint16_t aBufLength)
+{
+    uint16_t tail = TxTail();
+    uint16_t first;
+
+    if (aBufLength > kTxBufferSize - sTxLength)
+    {
+        aBufLength = kTxBufferSize - sTxLength;
+    }
+
+    first = kTxBufferSize - tail;
+    if (first > aBufLength)
+    {
+        first = aBufLength;
+    }
+
+    memcpy(&sTxBuffer[tail], aBuf, first);
+    memcpy(sTxBuffer, aBuf + first, aBufLength - first);
+    sTxLength += aBufLength;
+
+    return aBufLength;
+}
+
+static TxChunk *ChunkNew(uint16_t aLength)
+{
+    TxChunk *chunk = nullptr;
+
+    // A command printing without end must not take the heap from the stack
+    if (aLength <= kTxSpillMax - sTxSpilled)
+    {
+        chunk = static_cast<TxChunk *>(pvPortMalloc(offsetof(TxChunk, mData) + aLength + 1));
+    }
+
+    if (chunk != nullptr)
+    {
+        chunk->mNext   = nullptr;
+        chunk->mLength = aLength;
+        chunk->mOffset = 0;
+        sTxSpilled += aLength;
+    }
+    else
+    {
+        // Past the cap or out of heap, reported once drained
+        sTxDropped += aLength;
+    }
+
+    return chunk;
+}
+
+static void ChunkQueue(TxChunk *aChunk)
+{
+    if (sTxSpillTail != nullptr)
+    {
+        sTxSpillTail->mNext = aChunk;
+    }
+    else
+    {
+        sTxSpillHead = aChunk;
+    }
+    sTxSpillTail = aChunk;
+}
+
+/**
+ * Move waiting output into the TX buffer as far as it fits, keeping the
+ * order it was written in.
+ *
+ */
+static void Drain(void)
+{
+    TxChunk *chunk;
+
+    while ((chunk = sTxSpillHead) != nullptr)
+    {
+        chunk->mOffset += Enqueue(&chunk->mData[chunk->mOffset], chunk->mLength - chunk->mOffset);
+        VerifyOrExit(chunk->mOffset == chunk->mLength);
+
+        sTxSpillHead = chunk->mNext;
+        if (sTxSpillHead == nullptr)
+        {
+            sTxSpillTail = nullptr;
+        }
+        sTxSpilled -= chunk->mLength;
+        vPortFree(chunk);
+    }
+
+exit:
+    return;
+}
+
+/**
+ * Hand the contiguous part of the TX buffer to the UART DMA, the next part
+ * follows from otPlatUartSendDone(). A refused send is retried from the
+ * tasklet, nothing else would run it while a command is held.
+ *
+ */
+static void Send(void)
+{
+    VerifyOrExit(sSendLength == 0);
+
+    if (sTxLength > kTxBufferSize - sTxHead)
+    {
+        sSendLength = kTxBufferSize - sTxHead;
+    }
+    else
+    {
+        sSendLength = sTxLength;
+    }
+
+    if (sSendLength > 0)
+    {
+#if OPENTHREAD_CONFIG_ENABLE_DEBUG_UART
+        /* duplicate the output to the debug uart */
+        otSysDebugUart_write_bytes(reinterpret_cast<uint8_t *>(sTxBuffer + sTxHead), sSendLength);
+#endif
+        if (otPlatUartSend(reinterpret_cast<uint8_t *>(sTxBuffer + sTxHead), sSendLength) != OT_ERROR_NONE)
+        {
+            sSendLength = 0;
+            if (sTasklet != nullptr)
+            {
+                sTasklet->Post();
+            }
+        }
+    }
+
+exit:
+    return;
+}
+
+static void SendDoneTask(void)
+{
+    uint32_t dropped;
+
+    OT_CLI_UART_OUTPUT_LOCK();
+
+    sTxHead += sSendLength;
+    if (sTxHead >= kTxBufferSize)
+    {
+        sTxHead -= kTxBufferSize;
+    }
+    sTxLength -= sSendLength;
+    sSendLength = 0;
+
+    Drain();
+    Send();
+
+    dropped = (sTxLength == 0) ? sTxDropped : 0;
+    if (dropped != 0)
+    {
+        sTxDropped = 0;
+    }
+
+    OT_CLI_UART_OUTPUT_UNLOCK();
+
+    if (dropped != 0)
+    {
+        otLogWarnPlat("CLI output dropped %lu bytes", static_cast<unsigned long>(dropped));
+    }
+
+    if (sRxHeld && TxReady() && sTasklet != nullptr)
+    {
+        sTasklet->Post();
+    }
+}
+
+static int Output(const char *aBuf, uint16_t aBufLength)
+{
+    uint16_t sent = 0;
+    TxChunk *chunk;
+
+    OT_CLI_UART_OUTPUT_LOCK();
+
+    if (sTxSpillHead == nullptr)
+    {
+        sent = Enqueue(aBuf, aBufLength);
+    }
+
+    if (sent < aBufLength && (chunk = ChunkNew(aBufLength - sent)) != nullptr)
+    {
+        memcpy(chunk->mData, aBuf + sent, aBufLength - sent);
+        ChunkQueue(chunk);
+    }
+
+    Send();
+
+    OT_CLI_UART_OUTPUT_UNLOCK();
+
+    return aBufLength;
+}
+
+static int CliUartOutput(void *aContext, const char *aFormat, va_list aArguments)
+{
+    OT_UNUSED_VARIABLE(aContext);
+
+    int      rval;
+    va_list  retryArguments;
+    uint16_t tail;
+    uint16_t contiguous = 0;
+    TxChunk *chunk;
+
+    OT_CLI_UART_OUTPUT_LOCK();
+
+    if (sTxLength == 0)
+    {
+        // Nothing in flight, format from the start of the buffer
+        sTxHead = 0;
+    }
+
+    tail = TxTail();
+    if (sTxSpillHead != nullptr)
+    {
+        // Older output is waiting, this one goes behind it
+    }
+    else if (tail < sTxHead || sTxLength == kTxBufferSize)
+    {
+        contiguous = sTxHead - tail;
+    }
+    else
+    {
+        contiguous = kTxBufferSize - tail;
+    }
+
+    va_copy(retryArguments, aArguments);
+
+    rval = vsnprintf(contiguous ? &sTxBuffer[tail] : nullptr, contiguous, aFormat, aArguments);
+
+    if (rval < 0 || rval > UINT16_MAX)
+    {
+        // Reported below
+        rval = -1;
+    }
+    else if (rval < contiguous)
+    {
+        // Formatted in place
+        sTxLength += static_cast<uint16_t>(rval);
+    }
+    else if ((chunk = ChunkNew(static_cast<uint16_t>(rval))) != nullptr)
+    {
+        // Wraps or does not fit, format it whole aside and move in what fits
+        vsnprintf(chunk->mData, static_cast<size_t>(rval) + 1, aFormat, retryArguments);
+        ChunkQueue(chunk);
+        Drain();
+    }
+
+    va_end(retryArguments);
+
+    Send();
+
+    OT_CLI_UART_OUTPUT_UNLOCK();
+
+    // Logged outside the lock, the log may be routed to this CLI
+    if (rval < 0)
+    {
+        otLogWarnPlat("Failed to format CLI output `%s`", aFormat);
+    }
+
+    return rval;
+}
+
+void otPlatUartReceived(const uint8_t *aBuf, uint16_t aBufLength) { ReceiveTask(aBuf, aBufLength); }
+
+void otPlatUartSendDone(void) { SendDoneTask(); }
+
+extern "C" void otAppCliInit(otInstance *aInstance)
+{
+    sRxLength        = 0;
+    sRxHeld          = false;
+    sRxBacklogLength = 0;
+    sTxHead          = 0;
+    sTxLength        = 0;
+    sSendLength      = 0;
+    sTxDropped       = 0;
+    sTxSpillHead     = nullptr;
+    sTxSpillTail     = nullptr;
+    sTxSpilled       = 0;
+
+    sTasklet = new (sTaskletRaw) ot::Tasklet(*static_cast<ot::Instance *>(aInstance), HandleTasklet);
+
+    IgnoreError(otPlatUartEnable());
+
+    otCliInit(aInstance, CliUartOutput, aInstance);
+}
@@ -0,0 +1,114 @@
+/**
+ * @file phy_profile.h
+ * @brief Sub-GHz PHY profiles: one const descriptor per modulation and
+ *        data rate, the CCA, backoff, ACK and frame wait timings derived
+ *        from it, and a single routine that programs the MAC and the modem
+ *        from it, at boot and at runtime.
+ *
+ * Timings, in microseconds, after the 802.15.4g attribute definitions:
+ *  - cca_us: phyCcaDuration, aCcaTime symbols
+ *  - backoff_us: aUnitBackoffPeriod = aTurnaroundTime + CCA
+ *  - ack_wait_us: macAckWaitDuration = aUnitBackoffPeriod +
+ *    aTurnaroundTime + the air time of an ACK frame
+ *  - frame_wait_us: macMaxFrameTotalWaitTime, the CSMA-CA backoffs the
+ *    sender of the pending frame may take at most plus phyMaxFrameDuration,
+ *    so it depends on the CSMA-CA settings of the application
+ * A timing symbol is 4 bits for both modulations, the O-QPSK symbol, which
+ * is also what the FSK values of the examples were tuned with.
+ *
+ * Shared by the mesh-it-up router, sleepy and sniffer applications.
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+
+#ifndef __PHY_PROFILE_H
+#define __PHY_PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** aTurnaroundTime of the SUN PHYs */
+#define PHY_PROFILE_TURNAROUND_US 1000
+
+#define PHY_PROFILE_CCA_DETECT_MODE 0
+#define PHY_PROFILE_CCA_THRESHOLD   75
+
+/** Preamble octets and SFD sent on air */
+#define PHY_PROFILE_PREAMBLE_LEN 8
+#define PHY_PROFILE_SFD          0x00007209
+#define PHY_PROFILE_SFD_LEN      2
+
+/** PHR octets, ACK PSDU octets with a 16 bit FCS, aMaxPhyPacketSize */
+#define PHY_PROFILE_PHR_LEN  2
+#define PHY_PROFILE_ACK_LEN  5
+#define PHY_PROFILE_PSDU_MAX 127
+
+/** Bits per timing symbol and aCcaTime in symbols */
+#define PHY_PROFILE_SYMBOL_BITS 4
+#define PHY_PROFILE_CCA_SYMBOLS 8
+
+/** Shortest CCA, the value the 300 kbit/s profile was tuned with */
+#define PHY_PROFILE_CCA_MIN_US 128
+
+typedef struct {
+    const char* name;
+    uint8_t modulation; /**< LMAC15P4_SUBG_FSK or LMAC15P4_SUBG_OQPSK */
+    uint8_t data_rate;  /**< HOSAL_RF_PHY_DATA_RATE_* */
+    uint32_t bit_rate;  /**< bit/s */
+} phy_profile_t;
+
+/** CSMA-CA and retry settings, chosen by the application */
+typedef struct {
+    uint8_t min_be;
+    uint8_t max_be;
+    uint8_t max_csma_backoffs;
+    uint8_t max_frame_retries;
+} phy_profile_mac_t;
+
+typedef struct {
+    uint16_t cca_us;
+    uint16_t ack_wait_us;
+    uint32_t backoff_us;
+    uint32_t frame_wait_us;
+} phy_profile_timing_t;
+
+/**
+ * @brief Derive the timings of a profile under the given CSMA-CA settings
+ */
+void phy_profile_timing(const phy_profile_t* profile,
+                        const phy_profile_mac_t* mac,
+                        phy_profile_timing_t* timing);
+
+/**
+ * @brief Apply the profile selected in Kconfig on the Kconfig band, before
+ *        the OpenThread stack is started
+ */
+void phy_profile_init(const phy_profile_mac_t* mac);
+
+/**
+ * @brief Program the MAC and modem from a profile in one step, under the
+ *        OpenThread stack lock
+ * @return 0 on success, -1 for an unknown band
+ */
+int phy_profile_apply(const phy_profile_t* profile, uint8_t band);
+
+/**
+ * @brief Apply after delay_ms from a worker task, so a command received
+ *        over the air can be acknowledged on the current profile first
+ * @return 0 when scheduled, -1 when another switch is pending
+ */
+int phy_profile_schedule(const phy_profile_t* profile, uint8_t band,
+                         uint32_t delay_ms);
+
+const phy_profile_t* phy_profile_find(const char* name);
+const phy_profile_t* phy_profile_get(uint8_t index);
+uint8_t phy_profile_count(void);
+
+const phy_profile_t* phy_profile_current(void);
+uint8_t phy_profile_band(void);
+const char* phy_profile_band_str(uint8_t band);
+
+#endif // __PHY_PROFILE_H
@@ -0,0 +1,314 @@
+/**
+ * @file phy_profile.c
+ * @brief Sub-GHz PHY profile table and switching, see phy_profile.h
+ *
+ * A switch at runtime, from the shell, the "phy" worker or the remote
+ * command worker, reprograms the LMAC under the OpenThread stack lock so
+ * the stack never sends or receives with half a profile.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "cli.h"
+#include "hosal_rf.h"
+#include "lmac15p4.h"
+#include "log.h"
+#include "miu_port.h"
+#include "phy_profile.h"
+#include "subg_ctrl.h"
+#include "task.h"
+
+#define PHY_PROFILE_TASK_SIZE 256
+
+#define PROFILE(_name, _mod, _rate, _bps)                                  \
+    { .name = _name, .modulation = _mod, .data_rate = _rate, .bit_rate = _bps }
+
+static const phy_profile_t s_profiles[] = {
+    PROFILE("fsk-300k", LMAC15P4_SUBG_FSK, HOSAL_RF_PHY_DATA_RATE_300K, 300000),
+    PROFILE("fsk-200k", LMAC15P4_SUBG_FSK, HOSAL_RF_PHY_DATA_RATE_200K, 200000),
+    PROFILE("fsk-150k", LMAC15P4_SUBG_FSK, HOSAL_RF_PHY_DATA_RATE_150K, 150000),
+    PROFILE("fsk-100k", LMAC15P4_SUBG_FSK, HOSAL_RF_PHY_DATA_RATE_100K, 100000),
+    PROFILE("fsk-50k", LMAC15P4_SUBG_FSK, HOSAL_RF_PHY_DATA_RATE_50K, 50000),
+    PROFILE("oqpsk-25k", LMAC15P4_SUBG_OQPSK, HOSAL_RF_PHY_DATA_RATE_25K,
+            25000),
+};
+
+#define PHY_PROFILE_NUM (sizeof(s_profiles) / sizeof(s_profiles[0]))
+
+static const char* const s_band_str[] = {"SubG_915M", "2P4G",
+                                         "SubG_868M", "SubG_433M",
+                                         "SubG_315M", "SubG_470M"};
+
+/* read by the mesh-it-up port layer, the frame wait of fsk-50k is past
+ * 16 bits */
+uint16_t cca_duration = 0;
+uint32_t frame_total_wait_time = 0;
+uint32_t backof_period = 0;
+
+static phy_profile_mac_t s_mac;
+static const phy_profile_t* s_current;
+static phy_profile_timing_t s_timing;
+static uint8_t s_band;
+
+static const phy_profile_t* s_pending;
+static uint8_t s_pending_band;
+static uint32_t s_pending_delay;
+
+static const phy_profile_t* profile_default(void) {
+#if CONFIG_SUBG_DATA_RATE_FSK_200K
+    return &s_profiles[1];
+#elif CONFIG_SUBG_DATA_RATE_FSK_100K
+    return &s_profiles[3];
+#elif CONFIG_SUBG_DATA_RATE_FSK_50K
+    return &s_profiles[4];
+#elif CONFIG_SUBG_DATA_RATE_OQPSK_25K
+    return &s_profiles[5];
+#else
+    return &s_profiles[0];
+#endif
+}
+
+static uint8_t band_default(void) {
+#if CONFIG_SUBG_FREQUENCY_BAND_868
+    return HOSAL_RF_BAND_SUBG_868M;
+#elif CONFIG_SUBG_FREQUENCY_BAND_470
+    return HOSAL_RF_BAND_SUBG_470M;
+#elif CONFIG_SUBG_FREQUENCY_BAND_433
+    return HOSAL_RF_BAND_SUBG_433M;
+#else
+    return HOSAL_RF_BAND_SUBG_915M;
+#endif
+}
+
+static bool band_valid(uint8_t band) {
+    return band < sizeof(s_band_str) / sizeof(s_band_str[0])
+           && band != HOSAL_RF_BAND_2P4G;
+}
+
+/* air time of bits at the profile rate, rounded up */
+static uint32_t air_us(const phy_profile_t* profile, uint32_t bits) {
+    return (bits * 1000000UL + profile->bit_rate - 1) / profile->bit_rate;
+}
+
+void phy_profile_timing(const phy_profile_t* profile,
+                        const phy_profile_mac_t* mac,
+                        phy_profile_timing_t* timing) {
+    uint32_t shr_phr = (PHY_PROFILE_PREAMBLE_LEN + PHY_PROFILE_SFD_LEN
+                        + PHY_PROFILE_PHR_LEN)
+                       * 8;
+    uint32_t cca, slots = 0;
+    uint8_t m, k;
+
+    cca = air_us(profile, PHY_PROFILE_CCA_SYMBOLS * PHY_PROFILE_SYMBOL_BITS);
+    if (cca < PHY_PROFILE_CCA_MIN_US) {
+        cca = PHY_PROFILE_CCA_MIN_US;
+    }
+    timing->cca_us = cca;
+    timing->backoff_us = PHY_PROFILE_TURNAROUND_US + cca;
+    timing->ack_wait_us = timing->backoff_us + PHY_PROFILE_TURNAROUND_US
+                          + air_us(profile, shr_phr + PHY_PROFILE_ACK_LEN * 8);
+
+    /* m = min(macMaxBe - macMinBe, macMaxCsmaBackoffs), the first m
+     * backoffs double the window, the rest stay at 2^macMaxBe - 1 */
+    m = mac->max_be > mac->min_be ? mac->max_be - mac->min_be : 0;
+    if (m > mac->max_csma_backoffs) {
+        m = mac->max_csma_backoffs;
+    }
+    for (k = 0; k < m; k++) {
+        slots += 1UL << (mac->min_be + k);
+    }
+    slots += ((1UL << mac->max_be) - 1) * (mac->max_csma_backoffs - m);
+    timing->frame_wait_us =
+        slots * timing->backoff_us
+        + air_us(profile, shr_phr + PHY_PROFILE_PSDU_MAX * 8);
+}
+
+static void profile_program(const phy_profile_t* profile, uint8_t band) {
+    uint8_t modu;
+
+    /* the modem API takes the FSK modulation under its own name */
+    modu = profile->modulation == LMAC15P4_SUBG_OQPSK ? LMAC15P4_SUBG_OQPSK
+                                                      : SUBG_CTRL_MODU_FSK;
+
+    phy_profile_timing(profile, &s_mac, &s_timing);
+
+    if (!s_current || s_current->modulation != profile->modulation
+        || s_band != band) {
+        lmac15p4_init(profile->modulation, band);
+    }
+
+    cca_duration = s_timing.cca_us;
+    frame_total_wait_time = s_timing.frame_wait_us;
+    backof_period = s_timing.backoff_us;
+
+    lmac15p4_phy_pib_set(PHY_PROFILE_TURNAROUND_US, PHY_PROFILE_CCA_DETECT_MODE,
+                         PHY_PROFILE_CCA_THRESHOLD, s_timing.cca_us);
+
+    lmac15p4_mac_pib_set(s_timing.backoff_us, s_timing.ack_wait_us,
+                         s_mac.max_be, s_mac.max_csma_backoffs,
+                         s_timing.frame_wait_us, s_mac.max_frame_retries,
+                         s_mac.min_be);
+
+    subg_ctrl_sleep_set(false);
+    subg_ctrl_idle_set();
+    subg_ctrl_modem_config_set(modu, profile->data_rate, SUBG_CTRL_FSK_MOD_1);
+    subg_ctrl_mac_set(modu, SUBG_CTRL_CRC_TYPE_16, SUBG_CTRL_WHITEN_DISABLE);
+    subg_ctrl_preamble_set(modu, PHY_PROFILE_PREAMBLE_LEN);
+    subg_ctrl_sfd_set(modu, PHY_PROFILE_SFD);
+    subg_ctrl_filter_set(modu, SUBG_CTRL_FILTER_TYPE_GFSK);
+
+    s_current = profile;
+    s_band = band;
+}
+
+int phy_profile_apply(const phy_profile_t* profile, uint8_t band) {
+    if (!band_valid(band)) {
+        return -1;
+    }
+
+    otrLock();
+    profile_program(profile, band);
+    otrUnlock();
+
+    log_info("Band               : %s", s_band_str[band]);
+    log_info("PHY Profile        : %s", profile->name);
+    return 0;
+}
+
+static void phy_profile_task(void* arg) {
+    (void)arg;
+
+    vTaskDelay(pdMS_TO_TICKS(s_pending_delay));
+    phy_profile_apply(s_pending, s_pending_band);
+    s_pending = NULL;
+    vTaskDelete(NULL);
+}
+
+int phy_profile_schedule(const phy_profile_t* profile, uint8_t band,
+                         uint32_t delay_ms) {
+    if (!band_valid(band)) {
+        return -1;
+    }
+
+    taskENTER_CRITICAL();
+    if (s_pending) {
+        taskEXIT_CRITICAL();
+        return -1;
+    }
+    s_pending = profile;
+    taskEXIT_CRITICAL();
+
+    s_pending_band = band;
+    s_pending_delay = delay_ms;
+    if (xTaskCreate(phy_profile_task, "phy", PHY_PROFILE_TASK_SIZE, NULL,
+                    E_TASK_PRIORITY_APP, NULL)
+        != pdPASS) {
+        s_pending = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+const phy_profile_t* phy_profile_find(const char* name) {
+    uint8_t i;
+
+    for (i = 0; i < PHY_PROFILE_NUM; i++) {
+        if (!strcmp(s_profiles[i].name, name)) {
+            return &s_profiles[i];
+        }
+    }
+    return NULL;
+}
+
+const phy_profile_t* phy_profile_get(uint8_t index) {
+    return index < PHY_PROFILE_NUM ? &s_profiles[index] : NULL;
+}
+
+uint8_t phy_profile_count(void) { return PHY_PROFILE_NUM; }
+
+const phy_profile_t* phy_profile_current(void) { return s_current; }
+
+uint8_t phy_profile_band(void) { return s_band; }
+
+const char* phy_profile_band_str(uint8_t band) {
+    return band < sizeof(s_band_str) / sizeof(s_band_str[0]) ? s_band_str[band]
+                                                             : "unknown";
+}
+
+void phy_profile_init(const phy_profile_mac_t* mac) {
+    /* before miuStart(), there is no stack to lock yet */
+    s_mac = *mac;
+    profile_program(profile_default(), band_default());
+    log_info("Band               : %s", s_band_str[s_band]);
+    log_info("PHY Profile        : %s", s_current->name);
+}
+
+static uint8_t band_parse(const char* str) {
+    switch (strtoul(str, NULL, 10)) {
+        case 868: return HOSAL_RF_BAND_SUBG_868M;
+        case 470: return HOSAL_RF_BAND_SUBG_470M;
+        case 433: return HOSAL_RF_BAND_SUBG_433M;
+        case 315: return HOSAL_RF_BAND_SUBG_315M;
+        case 915: return HOSAL_RF_BAND_SUBG_915M;
+        default: return 0xff;
+    }
+}
+
+static void print_profile(cb_shell_out_t log_out, const phy_profile_t* p) {
+    phy_profile_timing_t t;
+
+    phy_profile_timing(p, &s_mac, &t);
+    log_out("%c %-10s %7lu %5u %6lu %5u %7lu\r\n", p == s_current ? '*' : ' ',
+            p->name, (unsigned long)p->bit_rate, t.cca_us,
+            (unsigned long)t.backoff_us, t.ack_wait_us,
+            (unsigned long)t.frame_wait_us);
+}
+
+static int _cli_cmd_phy(int argc, char** argv, cb_shell_out_t log_out,
+                        void* pExtra) {
+    const phy_profile_t* profile;
+    uint32_t delay = 0;
+    uint8_t band = s_band;
+    uint8_t i;
+
+    if (argc > 1 && !strncmp(argv[1], "list", 4)) {
+        log_out("band: %s\r\n", s_band_str[s_band]);
+        log_out("  %-10s %7s %5s %6s %5s %7s (us)\r\n", "profile", "bit/s",
+                "cca", "backof", "ack", "frame");
+        for (i = 0; i < PHY_PROFILE_NUM; i++) {
+            print_profile(log_out, &s_profiles[i]);
+        }
+    } else if (argc > 2 && !strncmp(argv[1], "set", 3)) {
+        profile = phy_profile_find(argv[2]);
+        if (!profile) {
+            log_out("Unknown profile \r\n");
+            return -1;
+        }
+        if (argc > 3) {
+            band = band_parse(argv[3]);
+        }
+        if (argc > 4) {
+            delay = strtoul(argv[4], NULL, 10);
+        }
+        if (delay ? phy_profile_schedule(profile, band, delay)
+                  : phy_profile_apply(profile, band)) {
+            log_out("Switch failed \r\n");
+            return -1;
+        }
+    } else {
+        log_out("phy list \r\n");
+        log_out("phy set <profile> [915/868/470/433/315] [delay ms] \r\n");
+        return 0;
+    }
+
+    log_out("+Ok \r\n");
+    return 0;
+}
+
+const sh_cmd_t g_cli_cmd_phy STATIC_CLI_CMD_ATTRIBUTE = {
+    .pCmd_name = "phy",
+    .pDescription = "Sub-GHz PHY profile : see phy help",
+    .cmd_exec = _cli_cmd_phy,
+};
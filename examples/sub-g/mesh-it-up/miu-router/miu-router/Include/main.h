@@ -9,6 +9,9 @@
 #include <openthread/thread.h>
 #include <openthread/thread_ftd.h>
 
+#include "app_rmt.h"
+#include "app_udp.h"
+
 /*app_task.c*/
 void app_task(void);
 
@@ -23,11 +26,4 @@ void app_set_led1_off(void);
 void app_set_led1_toggle(void);
 void app_led_pin_init(void);
 
-/*app_udp.c*/
-uint8_t app_sockInit(otInstance* instance,
-                     void (*handler)(otMessage*, const otMessageInfo*),
-                     uint16_t udp_port);
-
-void app_udpSend(otIp6Address dstaddr, uint8_t* p, uint16_t len);
-
 #endif // __DEMO_GPIO_H
\ No newline at end of file
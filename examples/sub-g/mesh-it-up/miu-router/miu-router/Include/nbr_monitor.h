@@ -0,0 +1,132 @@
+/**
+ * @file nbr_monitor.h
+ * @brief Neighbor monitor: retained link quality history and churn
+ *        counters for the children and routers of this node.
+ *
+ * Add and remove events come from the OpenThread neighbor table callback,
+ * the link figures from sampling the neighbor table in the OpenThread
+ * task. The table is static: NBR_MONITOR_MAX entries, a neighbor that left
+ * is kept until its slot is needed for a new one.
+ */
+
+#ifndef __NBR_MONITOR_H
+#define __NBR_MONITOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <openthread/thread.h>
+
+/** Neighbors tracked, present and past; sized for 32 children and routers */
+#ifndef NBR_MONITOR_MAX
+#define NBR_MONITOR_MAX 48
+#endif
+
+/** Neighbor table sampling period */
+#ifndef NBR_MONITOR_SAMPLE_MS
+#define NBR_MONITOR_SAMPLE_MS 10000
+#endif
+
+/** EWMA weight of a new sample, 1 / (1 << NBR_MONITOR_EWMA_SHIFT) */
+#ifndef NBR_MONITOR_EWMA_SHIFT
+#define NBR_MONITOR_EWMA_SHIFT 3
+#endif
+
+/** Samples between two reports to the collector */
+#ifndef NBR_MONITOR_REPORT_SAMPLES
+#define NBR_MONITOR_REPORT_SAMPLES 6
+#endif
+
+/** First byte of a report record, see nbr_monitor_record_t */
+#define NBR_MONITOR_RECORD_TYPE 0x4E
+
+#define NBR_MONITOR_FLAG_CHILD    (1 << 0) /**< else a router */
+#define NBR_MONITOR_FLAG_PRESENT  (1 << 1) /**< in the neighbor table now */
+#define NBR_MONITOR_FLAG_RX_IDLE  (1 << 2) /**< rx-on-when-idle */
+#define NBR_MONITOR_FLAG_FTD      (1 << 3)
+
+typedef struct {
+    otExtAddress ext_addr;
+    uint16_t rloc16;
+    uint8_t flags;
+    int8_t rssi_last;      /**< dBm */
+    int16_t rssi_avg;      /**< dBm in 1/16 */
+    uint16_t lq_avg;       /**< link quality in 0..3, in 1/256 */
+    uint16_t frame_err;    /**< 0xffff is 100% */
+    uint16_t msg_err;      /**< 0xffff is 100% */
+    uint16_t joins;
+    uint16_t leaves;
+    uint16_t mode_changes;
+    uint16_t samples;
+    uint32_t first_seen_s; /**< uptime */
+    uint32_t last_seen_s;  /**< uptime of the last frame heard */
+} nbr_monitor_entry_t;
+
+typedef struct {
+    uint32_t child_added;
+    uint32_t child_removed;
+    uint32_t router_added;
+    uint32_t router_removed;
+    uint32_t mode_changed;
+    uint32_t role_changed; /**< role changes of this node */
+    uint32_t evicted;      /**< past neighbors replaced by new ones */
+    uint32_t untracked;    /**< new neighbors with no free slot */
+    uint32_t reports;
+    uint32_t report_failed;
+} nbr_monitor_stats_t;
+
+/**
+ * Report record, little endian, queued with app_udpQueue() so several
+ * neighbors share one datagram.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t type; /**< NBR_MONITOR_RECORD_TYPE */
+    uint8_t ext_addr[OT_EXT_ADDRESS_SIZE];
+    uint16_t rloc16;
+    uint8_t flags;
+    int8_t rssi_last;
+    int16_t rssi_avg;
+    uint16_t lq_avg;
+    uint16_t frame_err;
+    uint16_t msg_err;
+    uint16_t joins;
+    uint16_t leaves;
+    uint32_t age_s; /**< since last heard */
+} nbr_monitor_record_t;
+
+void nbr_monitor_init(otInstance* instance);
+
+/**
+ * @brief Neighbor table callback, call from the registered
+ *        otNeighborTableCallback
+ */
+void nbr_monitor_neighbor_event(otNeighborTableEvent event,
+                                const otNeighborTableEntryInfo* info);
+
+/**
+ * @brief Role change of this node, all neighbors are gone once detached
+ */
+void nbr_monitor_role_changed(otDeviceRole role);
+
+/**
+ * @brief Post the sampling of the neighbor table to the OpenThread task
+ *        when NBR_MONITOR_SAMPLE_MS has passed, the report to the collector
+ *        follows when due. Call from the application task at least every
+ *        NBR_MONITOR_SAMPLE_MS.
+ */
+void nbr_monitor_process(void);
+
+/**
+ * @brief Send reports to addr, NULL stops reporting
+ */
+void nbr_monitor_collector_set(const otIp6Address* addr);
+
+/**
+ * @brief Copy the table, present neighbors first
+ * @return number of valid entries
+ */
+uint8_t nbr_monitor_table_get(nbr_monitor_entry_t* entries, uint8_t max);
+
+void nbr_monitor_stats_get(nbr_monitor_stats_t* stats);
+void nbr_monitor_reset(void);
+
+#endif // __NBR_MONITOR_H
@@ -11,13 +11,19 @@
 
 #include <FreeRTOS.h>
 #include <semphr.h>
+#include <stdlib.h>
 #include <string.h>
 #include <task.h>
 #include <timers.h>
+#include "app_ot_job.h"
 #include "cli.h"
 #include "log.h"
 #include "main.h"
+#include "phy_profile.h"
 #include "util_string.h"
+#if (CONFIG_APP_NBR_MONITOR == 1)
+#include "nbr_monitor.h"
+#endif
 
 static SemaphoreHandle_t appSemHandle = NULL;
 
@@ -119,6 +125,10 @@ static void ot_stateChangeCallback(uint32_t flags, void* p_context) {
             default: break;
         }
 
+#if (CONFIG_APP_NBR_MONITOR == 1)
+        nbr_monitor_role_changed(role);
+#endif
+
         log_info("Current role       : %s",
                  otThreadDeviceRoleToString(otThreadGetDeviceRole(p_context)));
         if (role > OT_DEVICE_ROLE_DETACHED) {
@@ -206,46 +216,33 @@ ot_neighborChangeCallback(otNeighborTableEvent aEvent,
             break;
     }
 
+#if (CONFIG_APP_NBR_MONITOR == 1)
+    nbr_monitor_neighbor_event(aEvent, aEntryInfo);
+#endif
+
     // xSemaphoreGive(appSemHandle);
 }
 
-static void app_udp_cb(otMessage* otMsg, const otMessageInfo* otInfo) {
-    uint8_t* p = NULL;
-
-    uint16_t len = 0;
-
-    len = otMessageGetLength(otMsg) - otMessageGetOffset(otMsg);
-
-    p = pvPortMalloc(len);
-
-    do {
-        if (p == NULL)
-            break;
-
-        otMessageRead(otMsg, otMessageGetOffset(otMsg), p, len);
-
-        if (!strncmp(p, "app", 3)) {
-            //execute cli app command
-            char* cmd = (char*)pvPortMalloc(len + 1);
-            if (cmd == NULL) {
-                log_error("malloc cmd failed");
-                break;
-            }
-            memset(cmd, 0, len + 1);
-            memcpy(cmd, p, len);
-            cmd[len] = '\0';
-            log_info("remove cmd: %s", cmd);
-            if (shell_exec_string(cmd) != 0) {
-                log_error("app cli execute failed");
-            }
-        } else {
-            log_info_hexdump("UDP", p, len);
+static void app_udp_cb(uint8_t* p, uint16_t len, const otMessageInfo* otInfo) {
+#if (CONFIG_APP_RMT == 1)
+    if (app_rmt_receive(p, len, otInfo)) {
+        return;
+    }
+#endif
+    if (!strncmp((char*)p, "app", 3)) {
+#if (CONFIG_APP_RMT == 1)
+        /* commands are only taken authenticated, see rmt send */
+        log_warn("plain text command ignored: %s", (char*)p);
+#else
+        //execute cli app command, p is NUL terminated
+        log_info("remove cmd: %s", (char*)p);
+        if (shell_exec_string((char*)p) != 0) {
+            log_error("app cli execute failed");
         }
-
-    } while (0);
-
-    if (p != NULL)
-        vPortFree(p);
+#endif
+    } else {
+        log_info_hexdump("UDP", p, len);
+    }
 }
 
 static void otdatasetInit(otInstance* instance) {
@@ -369,11 +366,18 @@ void otrInitUser(otInstance* instance) {
 #if OPENTHREAD_CONFIG_LOG_LEVEL_DYNAMIC_ENABLE
     otLoggingSetLevel(OT_LOG_LEVEL_NOTE);
 #endif
+    app_ot_job_init(instance);
     otdatasetInit(instance);
     otAppCliInit(instance);
     otSetStateChangedCallback(instance, ot_stateChangeCallback, instance);
     otThreadRegisterNeighborTableCallback(instance, ot_neighborChangeCallback);
     app_sockInit(instance, app_udp_cb, CONFIG_APP_TASK_UDP_LISTEN_PORT);
+#if (CONFIG_APP_RMT == 1)
+    app_rmt_init(instance);
+#endif
+#if (CONFIG_APP_NBR_MONITOR == 1)
+    nbr_monitor_init(instance);
+#endif
     /*led pin init*/
     app_led_pin_init();
 
@@ -389,6 +393,9 @@ void app_task(void) {
         if (xSemaphoreTake(appSemHandle, 10000)) {
             /*Customer written code*/
         }
+#if (CONFIG_APP_NBR_MONITOR == 1)
+        nbr_monitor_process();
+#endif
     }
 }
 
@@ -396,7 +403,11 @@ static void print_help(cb_shell_out_t log_out) {
     log_out("app udp send <ipv6> -x <hex data> \r\n");
     log_out("app udp send <ipv6> -c <string data> \r\n");
     log_out("app udp port \r\n");
+    log_out("app udp queue <ipv6> <string data> \r\n");
+    log_out("app udp flush \r\n");
+    log_out("app udp stats [reset] \r\n");
     log_out("app led <on/off/toggle/flash> \r\n");
+    log_out("app phy <profile> [delay ms] \r\n");
 }
 
 static int handle_udp_send(int argc, char** argv, cb_shell_out_t log_out) {
@@ -455,6 +466,52 @@ static int handle_udp_send(int argc, char** argv, cb_shell_out_t log_out) {
     return 0;
 }
 
+static int handle_udp_queue(int argc, char** argv, cb_shell_out_t log_out) {
+    otIp6Address dst_addr;
+    size_t len;
+
+    if (argc < 5) {
+        log_out("Too few parameters \r\n");
+        return -1;
+    }
+
+    if (otIp6AddressFromString(argv[3], &dst_addr) != OT_ERROR_NONE) {
+        log_out("Invalid IPv6 address \r\n");
+        return -1;
+    }
+
+    len = strlen(argv[4]);
+    if (len > 255 || app_udpQueue(&dst_addr, (uint8_t*)argv[4], len) != 0) {
+        log_out("Record too long \r\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int handle_udp_stats(int argc, char** argv, cb_shell_out_t log_out) {
+    app_udp_stats_t stats;
+
+    if (argc > 3 && !strncmp(argv[3], "reset", 5)) {
+        app_udpStatsReset();
+        return 0;
+    }
+
+    app_udpStats(&stats);
+    log_out("tx datagrams    : %lu (%lu bytes)\r\n",
+            (unsigned long)stats.tx_datagrams, (unsigned long)stats.tx_bytes);
+    log_out("tx records      : %lu in %lu batches, %lu dropped\r\n",
+            (unsigned long)stats.tx_records, (unsigned long)stats.tx_batches,
+            (unsigned long)stats.records_dropped);
+    log_out("pool            : %lu reserve refused, %lu exhausted\r\n",
+            (unsigned long)stats.reserve_refused,
+            (unsigned long)stats.alloc_failed);
+    log_out("send failed     : %lu\r\n", (unsigned long)stats.send_failed);
+    log_out("rx datagrams    : %lu, %lu records, %lu oversize\r\n",
+            (unsigned long)stats.rx_datagrams, (unsigned long)stats.rx_records,
+            (unsigned long)stats.rx_oversize);
+    return 0;
+}
+
 static int handle_led_command(int argc, char** argv, cb_shell_out_t log_out) {
     if (argc < 3) {
         log_out("Too few parameters \r\n");
@@ -477,6 +534,32 @@ static int handle_led_command(int argc, char** argv, cb_shell_out_t log_out) {
     return 0;
 }
 
+static int handle_phy_command(int argc, char** argv, cb_shell_out_t log_out) {
+    const phy_profile_t* profile;
+    uint32_t delay = 1000;
+
+    if (argc < 3) {
+        log_out("Too few parameters \r\n");
+        return -1;
+    }
+
+    profile = phy_profile_find(argv[2]);
+    if (!profile) {
+        log_out("Unknown profile \r\n");
+        return -1;
+    }
+
+    /* usually received over UDP, leave time to finish the exchange */
+    if (argc > 3) {
+        delay = strtoul(argv[3], NULL, 10);
+    }
+    if (phy_profile_schedule(profile, phy_profile_band(), delay) != 0) {
+        log_out("Switch already pending \r\n");
+        return -1;
+    }
+    return 0;
+}
+
 static int _cli_cmd_miu_app(int argc, char** argv, cb_shell_out_t log_out,
                             void* pExtra) {
     int ret = -1;
@@ -502,11 +585,20 @@ static int _cli_cmd_miu_app(int argc, char** argv, cb_shell_out_t log_out,
         } else if (!strncmp(argv[2], "port", 4)) {
             log_out("app udp port: %d \r\n", CONFIG_APP_TASK_UDP_LISTEN_PORT);
             ret = 0;
+        } else if (!strncmp(argv[2], "queue", 5)) {
+            ret = handle_udp_queue(argc, argv, log_out);
+        } else if (!strncmp(argv[2], "flush", 5)) {
+            app_udpFlush();
+            ret = 0;
+        } else if (!strncmp(argv[2], "stats", 5)) {
+            ret = handle_udp_stats(argc, argv, log_out);
         } else {
             log_out("Unknown udp subcommand\r\n");
         }
     } else if (!strncmp(argv[1], "led", 3)) {
         ret = handle_led_command(argc, argv, log_out);
+    } else if (!strncmp(argv[1], "phy", 3)) {
+        ret = handle_phy_command(argc, argv, log_out);
     } else {
         log_out("Unknown command\r\n");
     }
@@ -0,0 +1,529 @@
+/**
+ * @file nbr_monitor.c
+ * @brief Neighbor monitor: keeps a bounded table of the children and
+ *        routers seen by this node with RSSI and link quality EWMAs, frame
+ *        error rates, last-seen times and churn counters, shows it on the
+ *        CLI and reports it over UDP to a collector.
+ *
+ * Events and sampling run in the OpenThread task, the application task
+ * only posts the sampling job when it is due, and the CLI runs in the
+ * shell task, so the table is under a mutex. The mutex is never held
+ * across an OpenThread or app_udp call.
+ */
+
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <stdio.h>
+#include <string.h>
+#include <task.h>
+#include "app_ot_job.h"
+#include "cli.h"
+#include "log.h"
+#include "main.h"
+#include "nbr_monitor.h"
+
+#define NBR_MONITOR_RSSI_INVALID 127
+
+static SemaphoreHandle_t s_lock;
+static int s_job = -1;
+
+static nbr_monitor_entry_t s_entry[NBR_MONITOR_MAX];
+static uint8_t s_num;
+static nbr_monitor_stats_t s_stats;
+
+static TickType_t s_sample_tick;
+static uint8_t s_sample_count;
+
+static bool s_collector_set;
+static otIp6Address s_collector;
+
+static uint32_t now_s(void) {
+    return xTaskGetTickCount() / configTICK_RATE_HZ;
+}
+
+static int32_t ewma(int32_t avg, int32_t sample, uint16_t samples) {
+    if (samples == 0) {
+        return sample;
+    }
+    return avg + (sample - avg) / (1 << NBR_MONITOR_EWMA_SHIFT);
+}
+
+/* lock held */
+static nbr_monitor_entry_t* entry_find(const otExtAddress* ext_addr) {
+    uint8_t i;
+
+    for (i = 0; i < s_num; i++) {
+        if (!memcmp(&s_entry[i].ext_addr, ext_addr, sizeof(otExtAddress))) {
+            return &s_entry[i];
+        }
+    }
+    return NULL;
+}
+
+/* lock held, the entry of ext_addr, a free one or the past neighbor heard
+ * from longest ago */
+static nbr_monitor_entry_t* entry_get(const otExtAddress* ext_addr) {
+    nbr_monitor_entry_t* e = entry_find(ext_addr);
+    uint8_t i;
+
+    if (e) {
+        return e;
+    }
+
+    if (s_num < NBR_MONITOR_MAX) {
+        e = &s_entry[s_num++];
+    } else {
+        for (i = 0; i < NBR_MONITOR_MAX; i++) {
+            if (s_entry[i].flags & NBR_MONITOR_FLAG_PRESENT) {
+                continue;
+            }
+            if (!e || (int32_t)(s_entry[i].last_seen_s - e->last_seen_s) < 0) {
+                e = &s_entry[i];
+            }
+        }
+        if (!e) {
+            s_stats.untracked++;
+            return NULL;
+        }
+        s_stats.evicted++;
+    }
+
+    memset(e, 0, sizeof(*e));
+    memcpy(&e->ext_addr, ext_addr, sizeof(otExtAddress));
+    e->rssi_last = NBR_MONITOR_RSSI_INVALID;
+    e->first_seen_s = now_s();
+    e->last_seen_s = e->first_seen_s;
+    return e;
+}
+
+/* lock held */
+static void entry_join(nbr_monitor_entry_t* e, uint8_t flags, uint16_t rloc16) {
+    if (!(e->flags & NBR_MONITOR_FLAG_PRESENT)) {
+        e->joins++;
+    }
+    e->flags = flags | NBR_MONITOR_FLAG_PRESENT;
+    e->rloc16 = rloc16;
+    e->last_seen_s = now_s();
+}
+
+/* lock held */
+static void entry_leave(nbr_monitor_entry_t* e) {
+    if (e->flags & NBR_MONITOR_FLAG_PRESENT) {
+        e->leaves++;
+        e->flags &= ~NBR_MONITOR_FLAG_PRESENT;
+    }
+}
+
+static uint8_t child_flags(const otChildInfo* child) {
+    return NBR_MONITOR_FLAG_CHILD
+           | (child->mRxOnWhenIdle ? NBR_MONITOR_FLAG_RX_IDLE : 0)
+           | (child->mFullThreadDevice ? NBR_MONITOR_FLAG_FTD : 0);
+}
+
+void nbr_monitor_neighbor_event(otNeighborTableEvent event,
+                                const otNeighborTableEntryInfo* info) {
+    const otChildInfo* child = &info->mInfo.mChild;
+    const otNeighborInfo* router = &info->mInfo.mRouter;
+    nbr_monitor_entry_t* e;
+
+    if (!s_lock) {
+        return;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    switch (event) {
+        case OT_NEIGHBOR_TABLE_EVENT_CHILD_ADDED:
+            s_stats.child_added++;
+            e = entry_get(&child->mExtAddress);
+            if (e) {
+                entry_join(e, child_flags(child), child->mRloc16);
+            }
+            break;
+        case OT_NEIGHBOR_TABLE_EVENT_CHILD_REMOVED:
+            s_stats.child_removed++;
+            e = entry_find(&child->mExtAddress);
+            if (e) {
+                entry_leave(e);
+            }
+            break;
+        case OT_NEIGHBOR_TABLE_EVENT_CHILD_MODE_CHANGED:
+            s_stats.mode_changed++;
+            e = entry_get(&child->mExtAddress);
+            if (e) {
+                e->mode_changes++;
+                entry_join(e, child_flags(child), child->mRloc16);
+            }
+            break;
+        case OT_NEIGHBOR_TABLE_EVENT_ROUTER_ADDED:
+            s_stats.router_added++;
+            e = entry_get(&router->mExtAddress);
+            if (e) {
+                entry_join(e,
+                           NBR_MONITOR_FLAG_RX_IDLE | NBR_MONITOR_FLAG_FTD,
+                           router->mRloc16);
+            }
+            break;
+        case OT_NEIGHBOR_TABLE_EVENT_ROUTER_REMOVED:
+            s_stats.router_removed++;
+            e = entry_find(&router->mExtAddress);
+            if (e) {
+                entry_leave(e);
+            }
+            break;
+        default: break;
+    }
+    xSemaphoreGive(s_lock);
+}
+
+void nbr_monitor_role_changed(otDeviceRole role) {
+    uint8_t i;
+
+    if (!s_lock) {
+        return;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_stats.role_changed++;
+    if (role <= OT_DEVICE_ROLE_DETACHED) {
+        for (i = 0; i < s_num; i++) {
+            entry_leave(&s_entry[i]);
+        }
+    }
+    xSemaphoreGive(s_lock);
+}
+
+/* lock held */
+static void entry_sample(nbr_monitor_entry_t* e, const otNeighborInfo* n,
+                         uint32_t now) {
+    uint8_t flags = (n->mIsChild ? NBR_MONITOR_FLAG_CHILD : 0)
+                    | (n->mRxOnWhenIdle ? NBR_MONITOR_FLAG_RX_IDLE : 0)
+                    | (n->mFullThreadDevice ? NBR_MONITOR_FLAG_FTD : 0);
+
+    entry_join(e, flags, n->mRloc16);
+
+    if (n->mLastRssi != NBR_MONITOR_RSSI_INVALID) {
+        e->rssi_avg = ewma(e->rssi_avg, n->mLastRssi * 16,
+                           e->rssi_last == NBR_MONITOR_RSSI_INVALID ? 0 : 1);
+        e->rssi_last = n->mLastRssi;
+    }
+    e->lq_avg = ewma(e->lq_avg, n->mLinkQualityIn * 256, e->samples);
+    e->frame_err = n->mFrameErrorRate;
+    e->msg_err = n->mMessageErrorRate;
+    e->last_seen_s = now - n->mAge;
+
+    if (e->samples < UINT16_MAX) {
+        e->samples++;
+    }
+}
+
+/* OpenThread task */
+static void sample(otInstance* instance) {
+    otNeighborInfoIterator iter = OT_NEIGHBOR_INFO_ITERATOR_INIT;
+    otNeighborInfo info;
+    nbr_monitor_entry_t* e;
+    bool seen[NBR_MONITOR_MAX] = {0};
+    uint32_t now = now_s();
+    uint8_t i;
+
+    /* known neighbors first, so the ones gone without an event free their
+     * slot before new neighbors are added */
+    while (otThreadGetNextNeighborInfo(instance, &iter, &info)
+           == OT_ERROR_NONE) {
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        e = entry_find(&info.mExtAddress);
+        if (e) {
+            entry_sample(e, &info, now);
+            seen[e - s_entry] = true;
+        }
+        xSemaphoreGive(s_lock);
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (i = 0; i < s_num; i++) {
+        if (!seen[i]) {
+            entry_leave(&s_entry[i]);
+        }
+    }
+    xSemaphoreGive(s_lock);
+
+    iter = OT_NEIGHBOR_INFO_ITERATOR_INIT;
+    while (otThreadGetNextNeighborInfo(instance, &iter, &info)
+           == OT_ERROR_NONE) {
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        if (!entry_find(&info.mExtAddress)) {
+            e = entry_get(&info.mExtAddress);
+            if (e) {
+                entry_sample(e, &info, now);
+            }
+        }
+        xSemaphoreGive(s_lock);
+    }
+}
+
+static void record_fill(nbr_monitor_record_t* r, const nbr_monitor_entry_t* e,
+                        uint32_t now) {
+    r->type = NBR_MONITOR_RECORD_TYPE;
+    memcpy(r->ext_addr, e->ext_addr.m8, OT_EXT_ADDRESS_SIZE);
+    r->rloc16 = e->rloc16;
+    r->flags = e->flags;
+    r->rssi_last = e->rssi_last;
+    r->rssi_avg = e->rssi_avg;
+    r->lq_avg = e->lq_avg;
+    r->frame_err = e->frame_err;
+    r->msg_err = e->msg_err;
+    r->joins = e->joins;
+    r->leaves = e->leaves;
+    r->age_s = now - e->last_seen_s;
+}
+
+static void report(void) {
+    nbr_monitor_record_t record;
+    otIp6Address dst;
+    uint32_t now = now_s();
+    uint8_t i;
+
+    for (i = 0; i < NBR_MONITOR_MAX; i++) {
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        if (i >= s_num || !s_collector_set) {
+            xSemaphoreGive(s_lock);
+            break;
+        }
+        record_fill(&record, &s_entry[i], now);
+        dst = s_collector;
+        xSemaphoreGive(s_lock);
+
+        if (app_udpQueue(&dst, (uint8_t*)&record, sizeof(record)) != 0) {
+            xSemaphoreTake(s_lock, portMAX_DELAY);
+            s_stats.report_failed++;
+            xSemaphoreGive(s_lock);
+        }
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_stats.reports++;
+    xSemaphoreGive(s_lock);
+}
+
+/* OpenThread task, the stack lock is held by the port */
+static void sample_job(otInstance* instance) {
+    bool report_due;
+
+    if (otThreadGetDeviceRole(instance) > OT_DEVICE_ROLE_DETACHED) {
+        sample(instance);
+    }
+
+    report_due = ++s_sample_count >= NBR_MONITOR_REPORT_SAMPLES;
+    if (report_due) {
+        s_sample_count = 0;
+        if (s_collector_set) {
+            report();
+        }
+    }
+}
+
+void nbr_monitor_process(void) {
+    if (!s_lock) {
+        return;
+    }
+
+    if ((TickType_t)(xTaskGetTickCount() - s_sample_tick)
+        < pdMS_TO_TICKS(NBR_MONITOR_SAMPLE_MS)) {
+        return;
+    }
+    s_sample_tick = xTaskGetTickCount();
+
+    app_ot_job_post(s_job);
+}
+
+void nbr_monitor_collector_set(const otIp6Address* addr) {
+    if (!s_lock) {
+        return;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_collector_set = (addr != NULL);
+    if (addr) {
+        s_collector = *addr;
+    }
+    xSemaphoreGive(s_lock);
+}
+
+/* lock held */
+static uint8_t table_copy(nbr_monitor_entry_t* entries, uint8_t max) {
+    uint8_t n = 0;
+    uint8_t pass, i;
+
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < s_num && n < max; i++) {
+            if (!(s_entry[i].flags & NBR_MONITOR_FLAG_PRESENT) == !pass) {
+                continue;
+            }
+            entries[n++] = s_entry[i];
+        }
+    }
+    return n;
+}
+
+uint8_t nbr_monitor_table_get(nbr_monitor_entry_t* entries, uint8_t max) {
+    uint8_t n;
+
+    if (!s_lock) {
+        return 0;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    n = table_copy(entries, max);
+    xSemaphoreGive(s_lock);
+    return n;
+}
+
+void nbr_monitor_stats_get(nbr_monitor_stats_t* stats) {
+    if (!s_lock) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_lock);
+}
+
+void nbr_monitor_reset(void) {
+    if (!s_lock) {
+        return;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    memset(s_entry, 0, sizeof(s_entry));
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_num = 0;
+    s_sample_count = 0;
+    xSemaphoreGive(s_lock);
+}
+
+void nbr_monitor_init(otInstance* instance) {
+    (void)instance;
+
+    s_sample_tick = xTaskGetTickCount();
+    if (!s_lock) {
+        s_job = app_ot_job_register(sample_job);
+        if (s_job < 0) {
+            log_error("nbr_monitor: no job slot");
+            return;
+        }
+        s_lock = xSemaphoreCreateMutex();
+    }
+}
+
+/* x in tenths, right aligned in 6 columns */
+static void print_tenths(cb_shell_out_t log_out, int32_t x) {
+    char buf[12];
+
+    snprintf(buf, sizeof(buf), "%s%ld.%ld", x < 0 ? "-" : "",
+             (long)((x < 0 ? -x : x) / 10), (long)((x < 0 ? -x : x) % 10));
+    log_out("%6s", buf);
+}
+
+static void print_entry(cb_shell_out_t log_out, const nbr_monitor_entry_t* e,
+                        uint32_t now) {
+    log_out("%02x%02x%02x%02x%02x%02x%02x%02x %04x %-4s ", e->ext_addr.m8[0],
+            e->ext_addr.m8[1], e->ext_addr.m8[2], e->ext_addr.m8[3],
+            e->ext_addr.m8[4], e->ext_addr.m8[5], e->ext_addr.m8[6],
+            e->ext_addr.m8[7], e->rloc16,
+            !(e->flags & NBR_MONITOR_FLAG_PRESENT) ? "-"
+            : (e->flags & NBR_MONITOR_FLAG_CHILD)  ? "C"
+                                                   : "R");
+    print_tenths(log_out, (int32_t)e->rssi_avg * 10 / 16);
+    log_out(" %4d %1lu.%02lu ",
+            e->rssi_last == NBR_MONITOR_RSSI_INVALID ? 0 : e->rssi_last,
+            (unsigned long)(e->lq_avg / 256),
+            (unsigned long)((e->lq_avg % 256) * 100 / 256));
+    print_tenths(log_out, (int32_t)((uint32_t)e->frame_err * 1000 / 0xffff));
+    log_out(" ");
+    print_tenths(log_out, (int32_t)((uint32_t)e->msg_err * 1000 / 0xffff));
+    log_out(" %7lu %5u %6u\r\n", (unsigned long)(now - e->last_seen_s),
+            e->joins, e->leaves);
+}
+
+static void print_table(cb_shell_out_t log_out) {
+    nbr_monitor_entry_t e;
+    uint32_t now = now_s();
+    uint8_t pass, i;
+
+    log_out("%-16s %-4s %-4s %6s %4s %4s %6s %6s %7s %5s %6s\r\n", "extaddr",
+            "rloc", "type", "rssi", "last", "lq", "fer%", "mer%", "age(s)",
+            "joins", "leaves");
+
+    /* present neighbors first, one entry copied per lock */
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < NBR_MONITOR_MAX; i++) {
+            xSemaphoreTake(s_lock, portMAX_DELAY);
+            if (i >= s_num) {
+                xSemaphoreGive(s_lock);
+                break;
+            }
+            e = s_entry[i];
+            xSemaphoreGive(s_lock);
+
+            if (!(e.flags & NBR_MONITOR_FLAG_PRESENT) == !pass) {
+                continue;
+            }
+            print_entry(log_out, &e, now);
+        }
+    }
+}
+
+static void print_stats(cb_shell_out_t log_out) {
+    nbr_monitor_stats_t stats;
+
+    nbr_monitor_stats_get(&stats);
+    log_out("child added/removed  : %lu / %lu\r\n",
+            (unsigned long)stats.child_added,
+            (unsigned long)stats.child_removed);
+    log_out("router added/removed : %lu / %lu\r\n",
+            (unsigned long)stats.router_added,
+            (unsigned long)stats.router_removed);
+    log_out("child mode changes   : %lu\r\n", (unsigned long)stats.mode_changed);
+    log_out("own role changes     : %lu\r\n", (unsigned long)stats.role_changed);
+    log_out("evicted / untracked  : %lu / %lu\r\n",
+            (unsigned long)stats.evicted, (unsigned long)stats.untracked);
+    log_out("reports              : %lu, %lu records failed\r\n",
+            (unsigned long)stats.reports, (unsigned long)stats.report_failed);
+}
+
+static int _cli_cmd_nbrmon(int argc, char** argv, cb_shell_out_t log_out,
+                           void* pExtra) {
+    otIp6Address addr;
+
+    if (argc > 1 && !strncmp(argv[1], "show", 4)) {
+        print_table(log_out);
+    } else if (argc > 1 && !strncmp(argv[1], "stats", 5)) {
+        print_stats(log_out);
+    } else if (argc > 1 && !strncmp(argv[1], "reset", 5)) {
+        nbr_monitor_reset();
+    } else if (argc > 2 && !strncmp(argv[1], "collector", 9)) {
+        if (!strncmp(argv[2], "off", 3)) {
+            nbr_monitor_collector_set(NULL);
+        } else if (otIp6AddressFromString(argv[2], &addr) == OT_ERROR_NONE) {
+            nbr_monitor_collector_set(&addr);
+        } else {
+            log_out("Invalid IPv6 address \r\n");
+            return -1;
+        }
+    } else {
+        log_out("nbrmon show \r\n");
+        log_out("nbrmon stats \r\n");
+        log_out("nbrmon reset \r\n");
+        log_out("nbrmon collector <ipv6/off> \r\n");
+        return 0;
+    }
+
+    log_out("+Ok \r\n");
+    return 0;
+}
+
+const sh_cmd_t g_cli_cmd_nbrmon STATIC_CLI_CMD_ATTRIBUTE = {
+    .pCmd_name = "nbrmon",
+    .pDescription = "Neighbor monitor : see nbrmon help",
+    .cmd_exec = _cli_cmd_nbrmon,
+};
@@ -9,6 +9,9 @@
 #include <openthread/thread.h>
 #include <openthread/thread_ftd.h>
 
+#include "app_rmt.h"
+#include "app_udp.h"
+
 /*app_task.c*/
 void app_task(void);
 
@@ -23,10 +26,13 @@ void app_set_led1_off(void);
 void app_set_led1_toggle(void);
 void app_led_pin_init(void);
 
-/*app_udp.c*/
-uint8_t app_sockInit(otInstance* instance,
-                     void (*handler)(otMessage*, const otMessageInfo*),
-                     uint16_t udp_port);
-void app_udpSend(otIp6Address dstaddr, uint8_t* p, uint16_t len);
+/*app_poll.c*/
+void app_poll_init(otInstance* instance);
+void app_poll_state_changed(uint32_t flags);
+void app_poll_tx(void);
+void app_poll_rx(void);
+
+/* Poll fast until a reply expected within window_ms has arrived */
+void app_poll_expect(uint32_t window_ms);
 
 #endif // __DEMO_GPIO_H
\ No newline at end of file
@@ -0,0 +1,133 @@
+/**
+ * @file poll_ctrl.h
+ * @brief Adaptive data poll controller for a sleepy child: polls fast
+ *        after traffic and doubles the period back to a long one when idle.
+ *
+ * Plain state machine without OpenThread or RTOS dependencies: the caller
+ * feeds events with a millisecond timestamp and applies the period
+ * returned. An energy model turns polls and frames into radio-on time, and
+ * poll_ctrl_replay() runs a recorded event trace through any configuration
+ * so strategies can be compared on the same traffic.
+ */
+
+#ifndef __POLL_CTRL_H
+#define __POLL_CTRL_H
+
+#include <stdint.h>
+
+/** Poll period right after traffic */
+#ifndef POLL_CTRL_FAST_MS
+#define POLL_CTRL_FAST_MS 250
+#endif
+
+/** Longest poll period when idle */
+#ifndef POLL_CTRL_SLOW_MS
+#define POLL_CTRL_SLOW_MS 30000
+#endif
+
+/** Time the fast period is kept after the last traffic */
+#ifndef POLL_CTRL_HOLD_MS
+#define POLL_CTRL_HOLD_MS 2000
+#endif
+
+/** Polls at least this often per child timeout, so the parent keeps us */
+#ifndef POLL_CTRL_TIMEOUT_POLLS
+#define POLL_CTRL_TIMEOUT_POLLS 4
+#endif
+
+/** Radio-on time of an empty poll, a data frame sent and one received */
+#ifndef POLL_CTRL_POLL_US
+#define POLL_CTRL_POLL_US 4000
+#endif
+#ifndef POLL_CTRL_TX_US
+#define POLL_CTRL_TX_US 6000
+#endif
+#ifndef POLL_CTRL_RX_US
+#define POLL_CTRL_RX_US 6000
+#endif
+
+typedef enum {
+    POLL_CTRL_EVENT_TX = 0, /**< frame sent, a reply may follow */
+    POLL_CTRL_EVENT_RX,     /**< frame received, the parent may hold more */
+    POLL_CTRL_EVENT_EXPECT, /**< reply expected within arg ms */
+    POLL_CTRL_EVENT_POLL,   /**< one poll period has passed */
+    POLL_CTRL_EVENT_MAX,
+} poll_ctrl_event_t;
+
+typedef struct {
+    uint32_t fast_ms;
+    uint32_t slow_ms;
+    uint32_t hold_ms;
+} poll_ctrl_cfg_t;
+
+typedef struct {
+    uint32_t poll_us;
+    uint32_t tx_us;
+    uint32_t rx_us;
+} poll_ctrl_model_t;
+
+typedef struct {
+    poll_ctrl_cfg_t cfg;
+    poll_ctrl_model_t model;
+    uint32_t timeout_ms;   /**< child timeout, 0 unknown */
+    uint32_t period_ms;
+    uint32_t fast_until_ms;
+    uint32_t polls;
+    uint32_t tx;
+    uint32_t rx;
+    uint64_t radio_on_us;
+} poll_ctrl_t;
+
+typedef struct {
+    uint32_t at_ms;
+    uint16_t arg_ms; /**< POLL_CTRL_EVENT_EXPECT window */
+    uint8_t event;   /**< poll_ctrl_event_t, POLL is not recorded */
+} poll_ctrl_trace_t;
+
+typedef struct {
+    uint32_t polls;
+    uint32_t rx;
+    uint32_t radio_on_ms;
+    uint32_t latency_avg_ms; /**< from a frame at the parent to its poll */
+    uint32_t latency_max_ms;
+} poll_ctrl_result_t;
+
+/**
+ * @brief Start in the fast period, model NULL for the defaults above
+ */
+void poll_ctrl_init(poll_ctrl_t* ctrl, const poll_ctrl_cfg_t* cfg,
+                    const poll_ctrl_model_t* model, uint32_t now_ms);
+
+/**
+ * @brief Child timeout granted by the parent, in seconds, 0 unknown
+ * @return poll period to apply
+ */
+uint32_t poll_ctrl_timeout_set(poll_ctrl_t* ctrl, uint32_t timeout_s);
+
+/**
+ * @return poll period to apply
+ */
+uint32_t poll_ctrl_event(poll_ctrl_t* ctrl, poll_ctrl_event_t event,
+                         uint32_t now_ms, uint32_t arg_ms);
+
+/**
+ * @brief Longest period allowed by the configuration and the child timeout
+ */
+uint32_t poll_ctrl_slow_max(const poll_ctrl_t* ctrl);
+
+/**
+ * @brief Radio-on time per hour of idle polling at the current period
+ */
+uint32_t poll_ctrl_radio_ms_per_hour(const poll_ctrl_t* ctrl);
+
+/**
+ * @brief Run a trace through a configuration from trace[0].at_ms to end_ms.
+ *        Received frames are taken as waiting at the parent since their
+ *        timestamp and delivered at the next poll.
+ */
+void poll_ctrl_replay(const poll_ctrl_cfg_t* cfg,
+                      const poll_ctrl_model_t* model, uint32_t timeout_s,
+                      const poll_ctrl_trace_t* trace, uint16_t num,
+                      uint32_t end_ms, poll_ctrl_result_t* result);
+
+#endif // __POLL_CTRL_H
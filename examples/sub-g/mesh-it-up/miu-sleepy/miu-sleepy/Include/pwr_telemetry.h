@@ -0,0 +1,130 @@
+/**
+ * @file pwr_telemetry.h
+ * @brief Power state telemetry: time-in-state accounting for active, idle,
+ *        sleep and radio, with wakeup source and task attribution.
+ *
+ * The kernel hooks are wired in FreeRTOSConfig.h through
+ * traceTASK_SWITCHED_IN, traceLOW_POWER_IDLE_BEGIN,
+ * configPOST_SLEEP_PROCESSING and traceLOW_POWER_IDLE_END when
+ * CONFIG_APP_PWR_TELEMETRY is enabled. pwr_radio.c feeds the radio state
+ * and radio wakeups from the MAC callbacks.
+ */
+
+#ifndef __PWR_TELEMETRY_H
+#define __PWR_TELEMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Time base in microseconds. The default follows the RTOS tick, which keeps
+ * counting across tickless sleep; override with a free-running hardware
+ * timer for sub-tick resolution of short active bursts.
+ */
+#ifndef PWR_TELEMETRY_TIME_US
+#define PWR_TELEMETRY_TIME_US()                                                \
+    ((uint32_t)(xTaskGetTickCountFromISR() * (1000000UL / configTICK_RATE_HZ)))
+#endif
+
+/** Number of tasks tracked for wakeup and idle-break attribution */
+#ifndef PWR_TELEMETRY_TASK_MAX
+#define PWR_TELEMETRY_TASK_MAX 12
+#endif
+
+/** Task name length kept in the table, the handle may outlive the task */
+#define PWR_TELEMETRY_NAME_LEN 16
+
+/** Number of interrupt lines that can be mapped to a wakeup source */
+#ifndef PWR_TELEMETRY_IRQ_MAX
+#define PWR_TELEMETRY_IRQ_MAX 8
+#endif
+
+typedef enum {
+    PWR_TELEMETRY_STATE_ACTIVE = 0, /**< a task other than idle runs */
+    PWR_TELEMETRY_STATE_IDLE,       /**< idle task runs without sleeping */
+    PWR_TELEMETRY_STATE_SLEEP,      /**< inside tickless low-power sleep */
+    PWR_TELEMETRY_STATE_MAX,
+} pwr_telemetry_state_t;
+
+typedef enum {
+    PWR_TELEMETRY_RADIO_OFF = 0,
+    PWR_TELEMETRY_RADIO_RX,
+    PWR_TELEMETRY_RADIO_TX,
+    PWR_TELEMETRY_RADIO_MAX,
+} pwr_telemetry_radio_t;
+
+typedef enum {
+    PWR_TELEMETRY_WAKEUP_TIMER = 0,
+    PWR_TELEMETRY_WAKEUP_GPIO,
+    PWR_TELEMETRY_WAKEUP_RADIO,
+    PWR_TELEMETRY_WAKEUP_UART,
+    PWR_TELEMETRY_WAKEUP_OTHER,
+    PWR_TELEMETRY_WAKEUP_MAX,
+} pwr_telemetry_wakeup_t;
+
+typedef struct {
+    uint64_t state_us[PWR_TELEMETRY_STATE_MAX];
+    uint32_t state_entries[PWR_TELEMETRY_STATE_MAX];
+    uint64_t radio_us[PWR_TELEMETRY_RADIO_MAX];
+    uint32_t wakeups[PWR_TELEMETRY_WAKEUP_MAX];
+    uint32_t short_sleeps; /**< sleeps that ended before the expected time */
+    uint64_t elapsed_us;
+} pwr_telemetry_summary_t;
+
+typedef struct {
+    void* task;
+    char name[PWR_TELEMETRY_NAME_LEN];
+    uint64_t active_us;
+    uint32_t wakeups;     /**< first task to run after a wakeup */
+    uint32_t idle_breaks; /**< preempted idle before it could sleep */
+} pwr_telemetry_task_t;
+
+/**
+ * @brief Reset all counters and start accounting from now
+ */
+void pwr_telemetry_init(void);
+
+/**
+ * @brief Map an interrupt line to a wakeup source. A line found pending
+ *        right after the wakeup is used when no source was marked.
+ */
+void pwr_telemetry_wakeup_irq_set(int irq, pwr_telemetry_wakeup_t source);
+
+/**
+ * @brief Mark the wakeup source from an interrupt handler or callback.
+ *        Only the first mark after a sleep is used for attribution.
+ */
+void pwr_telemetry_wakeup_mark(pwr_telemetry_wakeup_t source);
+
+/**
+ * @brief Report the radio state, callable from interrupt context
+ */
+void pwr_telemetry_radio_set(pwr_telemetry_radio_t radio);
+
+/**
+ * @brief Kernel hooks, see FreeRTOSConfig.h
+ */
+void pwr_telemetry_task_switched_in(void* task);
+void pwr_telemetry_sleep_enter(uint32_t expected_idle_ticks);
+void pwr_telemetry_sleep_exit(void);
+
+/**
+ * @brief Sample the mapped interrupt lines. Call from the sleep routine of
+ *        the port after the wakeup with interrupts still masked, before the
+ *        handler of the waking interrupt clears its pending bit. Lines
+ *        are read with PWR_TELEMETRY_IRQ_PENDING(), the NVIC by default.
+ */
+void pwr_telemetry_sleep_wake(void);
+
+/**
+ * @brief Take a consistent snapshot of the counters up to now
+ */
+void pwr_telemetry_summary_get(pwr_telemetry_summary_t* summary);
+
+/**
+ * @brief Copy the per-task table
+ * @return number of valid entries
+ */
+uint8_t pwr_telemetry_task_get(pwr_telemetry_task_t* tasks, uint8_t max);
+
+#endif // __PWR_TELEMETRY_H
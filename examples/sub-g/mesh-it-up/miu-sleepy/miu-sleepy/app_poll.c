@@ -0,0 +1,326 @@
+/**
+ * @file app_poll.c
+ * @brief Drives the adaptive poll controller from application traffic and
+ *        OpenThread state, applies its period with otLinkSetPollPeriod()
+ *        and records the traffic for strategy comparison on the CLI.
+ *
+ * A periodic timer running at the applied poll period stands for the data
+ * polls, which OpenThread does not report; each expiry lets the period
+ * decay one step.
+ *
+ * Events come from the timer daemon, the shell and the OpenThread task. A
+ * new period is only recorded in the controller, the apply job sets it in
+ * the OpenThread task and moves the timer once the stack took it.
+ */
+
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <stdlib.h>
+#include <string.h>
+#include <task.h>
+#include <timers.h>
+#include "app_ot_job.h"
+#include "cli.h"
+#include "log.h"
+#include "main.h"
+#include "poll_ctrl.h"
+
+/* Traffic events kept for "poll compare" and "poll trace" */
+#ifndef APP_POLL_TRACE_MAX
+#define APP_POLL_TRACE_MAX 64
+#endif
+
+static otInstance* s_instance;
+static SemaphoreHandle_t s_lock;
+static TimerHandle_t s_timer;
+static int s_job = -1;
+
+/* OpenThread task, shown by the CLI */
+static uint32_t s_applied_ms;
+static uint32_t s_apply_failed;
+
+static poll_ctrl_t s_ctrl;
+static poll_ctrl_cfg_t s_cfg = {
+    .fast_ms = POLL_CTRL_FAST_MS,
+    .slow_ms = POLL_CTRL_SLOW_MS,
+    .hold_ms = POLL_CTRL_HOLD_MS,
+};
+
+static poll_ctrl_trace_t s_trace[APP_POLL_TRACE_MAX];
+static uint16_t s_trace_head;
+static uint16_t s_trace_num;
+
+/* CLI only, too large for the shell stack */
+static poll_ctrl_trace_t s_replay[APP_POLL_TRACE_MAX];
+
+static const char* const s_event_str[POLL_CTRL_EVENT_MAX] = {"tx", "rx",
+                                                             "expect", "poll"};
+
+static uint32_t now_ms(void) {
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+/* OpenThread task, the stack lock is held by the port */
+static void period_job(otInstance* instance) {
+    uint32_t period;
+    otError error;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    period = s_ctrl.period_ms;
+    xSemaphoreGive(s_lock);
+
+    if (period == s_applied_ms) {
+        return;
+    }
+
+    error = otLinkSetPollPeriod(instance, period);
+    if (error != OT_ERROR_NONE) {
+        /* the stack keeps the period it had, so does the timer */
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        s_apply_failed++;
+        xSemaphoreGive(s_lock);
+        log_warn("poll period %lu ms refused: %d", (unsigned long)period,
+                 error);
+        return;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_applied_ms = period;
+    xSemaphoreGive(s_lock);
+    xTimerChangePeriod(s_timer, pdMS_TO_TICKS(period), 0);
+}
+
+/* any task, the controller holds the period to apply */
+static void period_apply(void) {
+    app_ot_job_post(s_job);
+}
+
+/* lock held */
+static void trace_add(poll_ctrl_event_t event, uint32_t at, uint32_t arg_ms) {
+    poll_ctrl_trace_t* t = &s_trace[s_trace_head];
+
+    t->at_ms = at;
+    t->arg_ms = arg_ms > UINT16_MAX ? UINT16_MAX : arg_ms;
+    t->event = event;
+    s_trace_head = (s_trace_head + 1) % APP_POLL_TRACE_MAX;
+    if (s_trace_num < APP_POLL_TRACE_MAX) {
+        s_trace_num++;
+    }
+}
+
+static void poll_event(poll_ctrl_event_t event, uint32_t arg_ms) {
+    uint32_t now = now_ms();
+    uint32_t old, period;
+
+    if (!s_lock) {
+        return;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    old = s_ctrl.period_ms;
+    period = poll_ctrl_event(&s_ctrl, event, now, arg_ms);
+    if (event != POLL_CTRL_EVENT_POLL) {
+        trace_add(event, now, arg_ms);
+    }
+    xSemaphoreGive(s_lock);
+
+    if (period != old) {
+        period_apply();
+    }
+}
+
+static void poll_timer_cb(TimerHandle_t timer) {
+    (void)timer;
+    poll_event(POLL_CTRL_EVENT_POLL, 0);
+}
+
+void app_poll_tx(void) {
+    poll_event(POLL_CTRL_EVENT_TX, 0);
+}
+
+void app_poll_rx(void) {
+    poll_event(POLL_CTRL_EVENT_RX, 0);
+}
+
+void app_poll_expect(uint32_t window_ms) {
+    poll_event(POLL_CTRL_EVENT_EXPECT, window_ms);
+}
+
+void app_poll_state_changed(uint32_t flags) {
+    if (!s_lock || !(flags & OT_CHANGED_THREAD_ROLE)
+        || otThreadGetDeviceRole(s_instance) != OT_DEVICE_ROLE_CHILD) {
+        return;
+    }
+
+    /* the parent keeps the timeout requested in the Child ID Request */
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    poll_ctrl_timeout_set(&s_ctrl, otThreadGetChildTimeout(s_instance));
+    xSemaphoreGive(s_lock);
+
+    period_apply();
+}
+
+void app_poll_init(otInstance* instance) {
+    s_instance = instance;
+
+    s_job = app_ot_job_register(period_job);
+    s_lock = xSemaphoreCreateMutex();
+    s_timer = xTimerCreate("poll", pdMS_TO_TICKS(s_cfg.fast_ms), pdTRUE, NULL,
+                           poll_timer_cb);
+    if (s_job < 0 || !s_lock || !s_timer) {
+        log_error("poll controller init failed");
+        return;
+    }
+
+    poll_ctrl_init(&s_ctrl, &s_cfg, NULL, now_ms());
+    poll_ctrl_timeout_set(&s_ctrl, otThreadGetChildTimeout(instance));
+    period_apply();
+}
+
+static void print_show(cb_shell_out_t log_out) {
+    poll_ctrl_t ctrl;
+    uint32_t applied, failed;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    ctrl = s_ctrl;
+    applied = s_applied_ms;
+    failed = s_apply_failed;
+    xSemaphoreGive(s_lock);
+
+    log_out("poll period     : %lu ms, %lu ms applied, %lu refused\r\n",
+            (unsigned long)ctrl.period_ms, (unsigned long)applied,
+            (unsigned long)failed);
+    log_out("fast/slow/hold  : %lu / %lu / %lu ms\r\n",
+            (unsigned long)ctrl.cfg.fast_ms, (unsigned long)ctrl.cfg.slow_ms,
+            (unsigned long)ctrl.cfg.hold_ms);
+    log_out("child timeout   : %lu s, slow period capped at %lu ms\r\n",
+            (unsigned long)(ctrl.timeout_ms / 1000),
+            (unsigned long)poll_ctrl_slow_max(&ctrl));
+    log_out("polls/tx/rx     : %lu / %lu / %lu\r\n", (unsigned long)ctrl.polls,
+            (unsigned long)ctrl.tx, (unsigned long)ctrl.rx);
+    log_out("radio on        : %lu ms, %lu ms/h idle at this period\r\n",
+            (unsigned long)(ctrl.radio_on_us / 1000),
+            (unsigned long)poll_ctrl_radio_ms_per_hour(&ctrl));
+}
+
+/* oldest first, returns the number copied */
+static uint16_t trace_copy(poll_ctrl_trace_t* out) {
+    uint16_t first, i, num;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    num = s_trace_num;
+    first = (s_trace_head + APP_POLL_TRACE_MAX - num) % APP_POLL_TRACE_MAX;
+    for (i = 0; i < num; i++) {
+        out[i] = s_trace[(first + i) % APP_POLL_TRACE_MAX];
+    }
+    xSemaphoreGive(s_lock);
+    return num;
+}
+
+static void print_result(cb_shell_out_t log_out, const char* name,
+                         const poll_ctrl_result_t* r) {
+    log_out("%-10s %7lu %8lu %5lu %8lu %8lu\r\n", name, (unsigned long)r->polls,
+            (unsigned long)r->radio_on_ms, (unsigned long)r->rx,
+            (unsigned long)r->latency_avg_ms, (unsigned long)r->latency_max_ms);
+}
+
+static void print_compare(cb_shell_out_t log_out, uint32_t static_ms) {
+    poll_ctrl_cfg_t fixed = {static_ms, static_ms, 0};
+    poll_ctrl_result_t result;
+    poll_ctrl_t ctrl;
+    uint16_t num = trace_copy(s_replay);
+    uint32_t timeout_s;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    ctrl = s_ctrl;
+    xSemaphoreGive(s_lock);
+    timeout_s = ctrl.timeout_ms / 1000;
+
+    log_out("%u events over %lu ms\r\n", num,
+            (unsigned long)(num ? now_ms() - s_replay[0].at_ms : 0));
+    log_out("%-10s %7s %8s %5s %8s %8s\r\n", "strategy", "polls", "radio ms",
+            "rx", "avg lat", "max lat");
+
+    poll_ctrl_replay(&ctrl.cfg, &ctrl.model, timeout_s, s_replay, num,
+                     now_ms(), &result);
+    print_result(log_out, "adaptive", &result);
+
+    poll_ctrl_replay(&fixed, &ctrl.model, timeout_s, s_replay, num, now_ms(),
+                     &result);
+    print_result(log_out, "static", &result);
+}
+
+static void print_trace(cb_shell_out_t log_out) {
+    uint16_t num = trace_copy(s_replay);
+    uint16_t i;
+
+    for (i = 0; i < num; i++) {
+        log_out("%10lu %-6s %u\r\n",
+                (unsigned long)(s_replay[i].at_ms - s_replay[0].at_ms),
+                s_event_str[s_replay[i].event], s_replay[i].arg_ms);
+    }
+}
+
+static int _cli_cmd_poll(int argc, char** argv, cb_shell_out_t log_out,
+                         void* pExtra) {
+    poll_ctrl_t old;
+    uint32_t period;
+
+    if (!s_lock) {
+        log_out("poll controller not running \r\n");
+        return -1;
+    }
+
+    if (argc > 1 && !strncmp(argv[1], "show", 4)) {
+        print_show(log_out);
+    } else if (argc > 4 && !strncmp(argv[1], "set", 3)) {
+        s_cfg.fast_ms = strtoul(argv[2], NULL, 10);
+        s_cfg.slow_ms = strtoul(argv[3], NULL, 10);
+        s_cfg.hold_ms = strtoul(argv[4], NULL, 10);
+
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        old = s_ctrl;
+        poll_ctrl_init(&s_ctrl, &s_cfg, &old.model, now_ms());
+        s_ctrl.polls = old.polls;
+        s_ctrl.tx = old.tx;
+        s_ctrl.rx = old.rx;
+        s_ctrl.radio_on_us = old.radio_on_us;
+        poll_ctrl_timeout_set(&s_ctrl, old.timeout_ms / 1000);
+        xSemaphoreGive(s_lock);
+        period_apply();
+    } else if (argc > 2 && !strncmp(argv[1], "expect", 6)) {
+        app_poll_expect(strtoul(argv[2], NULL, 10));
+    } else if (argc > 2 && !strncmp(argv[1], "compare", 7)) {
+        period = strtoul(argv[2], NULL, 10);
+        if (period == 0) {
+            log_out("Invalid period \r\n");
+            return -1;
+        }
+        print_compare(log_out, period);
+    } else if (argc > 1 && !strncmp(argv[1], "trace", 5)) {
+        print_trace(log_out);
+    } else if (argc > 1 && !strncmp(argv[1], "reset", 5)) {
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        s_ctrl.polls = s_ctrl.tx = s_ctrl.rx = 0;
+        s_ctrl.radio_on_us = 0;
+        s_trace_head = s_trace_num = 0;
+        xSemaphoreGive(s_lock);
+    } else {
+        log_out("poll show \r\n");
+        log_out("poll set <fast ms> <slow ms> <hold ms> \r\n");
+        log_out("poll expect <ms> \r\n");
+        log_out("poll compare <static period ms> \r\n");
+        log_out("poll trace \r\n");
+        log_out("poll reset \r\n");
+        return 0;
+    }
+
+    log_out("+Ok \r\n");
+    return 0;
+}
+
+const sh_cmd_t g_cli_cmd_poll STATIC_CLI_CMD_ATTRIBUTE = {
+    .pCmd_name = "poll",
+    .pDescription = "Adaptive poll controller : see poll help",
+    .cmd_exec = _cli_cmd_poll,
+};
@@ -19,6 +19,8 @@
 #include "main.h"
 #include "mcu.h"
 #include "miu_port.h"
+#include "phy_profile.h"
+#include "pwr_telemetry.h"
 #include "subg_ctrl.h"
 #include "task.h"
 #include "uart_stdio.h"
@@ -27,55 +29,17 @@
 #define CONFIG_HOSAL_SOC_MAIN_ENTRY_TASK_SIZE 8192
 #endif
 
-#define PHY_PIB_TURNAROUND_TIMER  1000
-#define PHY_PIB_CCA_DETECTED_TIME 640 // 8 symbols for 50 kbps-data rate
-#define PHY_PIB_CCA_DETECT_MODE   0
-#define PHY_PIB_CCA_THRESHOLD     75
-#define MAC_PIB_UNIT_BACKOFF_PERIOD                                            \
-    1640 // PHY_PIB_TURNAROUND_TIMER + PHY_PIB_CCA_DETECTED_TIME
-#define MAC_PIB_MAC_ACK_WAIT_DURATION         2000 // oqpsk neee more then 2000
-#define MAC_PIB_MAC_MAX_BE                    5
-#define MAC_PIB_MAC_MAX_FRAME_TOTAL_WAIT_TIME 82080 // for 50 kbps-data rate
-#define MAC_PIB_MAC_MAX_FRAME_RETRIES         4
-#define MAC_PIB_MAC_MAX_CSMACA_BACKOFFS       4
-#define MAC_PIB_MAC_MIN_BE                    2
-static uint16_t cca_duration_table[] = {0, 0, 0, 160, 320, 640, 128, 213};
-static uint32_t frame_total_wait_time_table[] = {0,     0,     0,      20520,
-                                                 41040, 82080, 164160, 273600};
-static const char* const data_rate_str[] = {
-    "2M", "1M", "500K", "200K", "100K", "50K", "300K", "150K", "75K"};
-static const char* const band_str[] = {"SubG_915M", "2P4G",      "SubG_868M",
-                                       "SubG_433M", "SubG_315M", "SubG_470M"};
-uint16_t cca_duration = 0;
-uint16_t frame_total_wait_time = 0;
-uint32_t backof_period = 0;
-/*set subg frequencydatarate*/
-#if CONFIG_SUBG_FREQUENCY_BAND_915
-static uint8_t sPhyFrequencyBand = HOSAL_RF_BAND_SUBG_915M;
-#elif CONFIG_SUBG_FREQUENCY_BAND_868
-static uint8_t sPhyFrequencyBand = HOSAL_RF_BAND_SUBG_868M;
-#elif CONFIG_SUBG_FREQUENCY_BAND_470
-static uint8_t sPhyFrequencyBand = HOSAL_RF_BAND_SUBG_470M;
-#elif CONFIG_SUBG_FREQUENCY_BAND_433
-static uint8_t sPhyFrequencyBand = HOSAL_RF_BAND_SUBG_433M;
-#else
-static uint8_t sPhyFrequencyBand = HOSAL_RF_BAND_SUBG_915M;
-#endif
-// static uint8_t sPhyPowerIndex = 30;
-/*set subg datarate*/
-#if CONFIG_SUBG_DATA_RATE_FSK_300K
-static uint8_t sPhyDataRate = HOSAL_RF_PHY_DATA_RATE_300K;
-#elif CONFIG_SUBG_DATA_RATE_FSK_200K
-static uint8_t sPhyDataRate = HOSAL_RF_PHY_DATA_RATE_200K;
-#elif CONFIG_SUBG_DATA_RATE_FSK_100K
-static uint8_t sPhyDataRate = HOSAL_RF_PHY_DATA_RATE_100K;
-#elif CONFIG_SUBG_DATA_RATE_FSK_50K
-static uint8_t sPhyDataRate = HOSAL_RF_PHY_DATA_RATE_50K;
-#elif CONFIG_SUBG_DATA_RATE_OQPSK_25K
-static uint8_t sPhyDataRate = HOSAL_RF_PHY_DATA_RATE_25K;
-#else
-static uint8_t sPhyDataRate = HOSAL_RF_PHY_DATA_RATE_300K;
-#endif
+#define MAC_PIB_MAC_MAX_BE              5
+#define MAC_PIB_MAC_MAX_FRAME_RETRIES   4
+#define MAC_PIB_MAC_MAX_CSMACA_BACKOFFS 4
+#define MAC_PIB_MAC_MIN_BE              2
+
+static const phy_profile_mac_t s_phy_mac = {
+    .min_be = MAC_PIB_MAC_MIN_BE,
+    .max_be = MAC_PIB_MAC_MAX_BE,
+    .max_csma_backoffs = MAC_PIB_MAC_MAX_CSMACA_BACKOFFS,
+    .max_frame_retries = MAC_PIB_MAC_MAX_FRAME_RETRIES,
+};
 
 static void pin_mux_init(void) {
     int i;
@@ -95,6 +59,18 @@ static void __init_sleep() {
 }
 #endif
 
+#if CONFIG_APP_PWR_TELEMETRY
+static void __init_pwr_telemetry() {
+    pwr_telemetry_init();
+
+    /*interrupts seen pending when tickless sleep ends*/
+    pwr_telemetry_wakeup_irq_set(CommSubsystem_IRQn, PWR_TELEMETRY_WAKEUP_RADIO);
+    pwr_telemetry_wakeup_irq_set(Gpio_IRQn, PWR_TELEMETRY_WAKEUP_GPIO);
+    pwr_telemetry_wakeup_irq_set(Uart0_IRQn, PWR_TELEMETRY_WAKEUP_UART);
+    pwr_telemetry_wakeup_irq_set(Uart1_IRQn, PWR_TELEMETRY_WAKEUP_UART);
+}
+#endif
+
 static void app_task_entry(void* pvParameters) {
     /*watch dog init*/
     // init_wdt_init(); // debug should be close
@@ -106,47 +82,9 @@ static void app_task_entry(void* pvParameters) {
     hosal_rf_init(HOSAL_RF_MODE_RUCI_CMD);
 
     log_info("Mesh It Up Sleepy");
-    log_info("Band               : %s", band_str[sPhyFrequencyBand]);
-    log_info("Data Rate          : %s", data_rate_str[sPhyDataRate]);
 
     /*subg phy parameter setting*/
-    cca_duration = cca_duration_table[sPhyDataRate];
-    frame_total_wait_time = frame_total_wait_time_table[sPhyDataRate];
-    backof_period = PHY_PIB_TURNAROUND_TIMER + cca_duration;
-
-#if CONFIG_SUBG_DATA_RATE_OQPSK_25K
-    lmac15p4_init(LMAC15P4_SUBG_OQPSK, sPhyFrequencyBand);
-#else
-    lmac15p4_init(LMAC15P4_SUBG_FSK, sPhyFrequencyBand);
-#endif
-
-    lmac15p4_phy_pib_set(PHY_PIB_TURNAROUND_TIMER, PHY_PIB_CCA_DETECT_MODE,
-                         PHY_PIB_CCA_THRESHOLD, cca_duration);
-
-    lmac15p4_mac_pib_set(backof_period, MAC_PIB_MAC_ACK_WAIT_DURATION,
-                         MAC_PIB_MAC_MAX_BE, MAC_PIB_MAC_MAX_CSMACA_BACKOFFS,
-                         frame_total_wait_time, MAC_PIB_MAC_MAX_FRAME_RETRIES,
-                         MAC_PIB_MAC_MIN_BE);
-
-    subg_ctrl_sleep_set(false);
-    subg_ctrl_idle_set();
-#if CONFIG_SUBG_DATA_RATE_OQPSK_25K
-    subg_ctrl_modem_config_set(LMAC15P4_SUBG_OQPSK, sPhyDataRate,
-                               SUBG_CTRL_FSK_MOD_1);
-    subg_ctrl_mac_set(LMAC15P4_SUBG_OQPSK, SUBG_CTRL_CRC_TYPE_16,
-                      SUBG_CTRL_WHITEN_DISABLE);
-    subg_ctrl_preamble_set(LMAC15P4_SUBG_OQPSK, 8);
-    subg_ctrl_sfd_set(LMAC15P4_SUBG_OQPSK, 0x00007209);
-    subg_ctrl_filter_set(LMAC15P4_SUBG_OQPSK, SUBG_CTRL_FILTER_TYPE_GFSK);
-#else
-    subg_ctrl_modem_config_set(SUBG_CTRL_MODU_FSK, sPhyDataRate,
-                               SUBG_CTRL_FSK_MOD_1);
-    subg_ctrl_mac_set(SUBG_CTRL_MODU_FSK, SUBG_CTRL_CRC_TYPE_16,
-                      SUBG_CTRL_WHITEN_DISABLE);
-    subg_ctrl_preamble_set(SUBG_CTRL_MODU_FSK, 8);
-    subg_ctrl_sfd_set(SUBG_CTRL_MODU_FSK, 0x00007209);
-    subg_ctrl_filter_set(SUBG_CTRL_MODU_FSK, SUBG_CTRL_FILTER_TYPE_GFSK);
-#endif
+    phy_profile_init(&s_phy_mac);
 
     /*sdk cli init*/
     cli_init();
@@ -178,6 +116,9 @@ int main(void) {
 
 #ifdef CONFIG_HOSAL_SOC_IDLE_SLEEP
     __init_sleep();
+#endif
+#if CONFIG_APP_PWR_TELEMETRY
+    __init_pwr_telemetry();
 #endif
     /*application task start for customer*/
     if (xTaskCreate(app_task_entry, (char*)"main",
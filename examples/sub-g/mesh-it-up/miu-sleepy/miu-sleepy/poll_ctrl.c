@@ -0,0 +1,161 @@
+/**
+ * @file poll_ctrl.c
+ * @brief Adaptive data poll controller: fast period after traffic, held
+ *        for hold_ms, then doubled at every poll up to the slow period or
+ *        the child timeout share, whichever is shorter.
+ */
+
+#include <string.h>
+#include "poll_ctrl.h"
+
+/* a - b in ms, valid across the 32-bit wrap */
+static int32_t time_diff(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b);
+}
+
+void poll_ctrl_init(poll_ctrl_t* ctrl, const poll_ctrl_cfg_t* cfg,
+                    const poll_ctrl_model_t* model, uint32_t now_ms) {
+    memset(ctrl, 0, sizeof(*ctrl));
+
+    ctrl->cfg = *cfg;
+    if (ctrl->cfg.fast_ms == 0) {
+        ctrl->cfg.fast_ms = POLL_CTRL_FAST_MS;
+    }
+    if (ctrl->cfg.slow_ms < ctrl->cfg.fast_ms) {
+        ctrl->cfg.slow_ms = ctrl->cfg.fast_ms;
+    }
+
+    if (model) {
+        ctrl->model = *model;
+    } else {
+        ctrl->model.poll_us = POLL_CTRL_POLL_US;
+        ctrl->model.tx_us = POLL_CTRL_TX_US;
+        ctrl->model.rx_us = POLL_CTRL_RX_US;
+    }
+
+    ctrl->period_ms = ctrl->cfg.fast_ms;
+    ctrl->fast_until_ms = now_ms + ctrl->cfg.hold_ms;
+}
+
+uint32_t poll_ctrl_slow_max(const poll_ctrl_t* ctrl) {
+    uint32_t slow = ctrl->cfg.slow_ms;
+
+    if (ctrl->timeout_ms && ctrl->timeout_ms / POLL_CTRL_TIMEOUT_POLLS < slow) {
+        slow = ctrl->timeout_ms / POLL_CTRL_TIMEOUT_POLLS;
+    }
+    return slow < ctrl->cfg.fast_ms ? ctrl->cfg.fast_ms : slow;
+}
+
+uint32_t poll_ctrl_timeout_set(poll_ctrl_t* ctrl, uint32_t timeout_s) {
+    ctrl->timeout_ms = timeout_s * 1000;
+    if (ctrl->period_ms > poll_ctrl_slow_max(ctrl)) {
+        ctrl->period_ms = poll_ctrl_slow_max(ctrl);
+    }
+    return ctrl->period_ms;
+}
+
+static void fast_hold(poll_ctrl_t* ctrl, uint32_t until_ms) {
+    if (time_diff(until_ms, ctrl->fast_until_ms) > 0) {
+        ctrl->fast_until_ms = until_ms;
+    }
+    ctrl->period_ms = ctrl->cfg.fast_ms;
+}
+
+uint32_t poll_ctrl_event(poll_ctrl_t* ctrl, poll_ctrl_event_t event,
+                         uint32_t now_ms, uint32_t arg_ms) {
+    uint32_t slow = poll_ctrl_slow_max(ctrl);
+
+    switch (event) {
+        case POLL_CTRL_EVENT_TX:
+            ctrl->tx++;
+            ctrl->radio_on_us += ctrl->model.tx_us;
+            fast_hold(ctrl, now_ms + ctrl->cfg.hold_ms);
+            break;
+        case POLL_CTRL_EVENT_RX:
+            ctrl->rx++;
+            ctrl->radio_on_us += ctrl->model.rx_us;
+            fast_hold(ctrl, now_ms + ctrl->cfg.hold_ms);
+            break;
+        case POLL_CTRL_EVENT_EXPECT:
+            fast_hold(ctrl, now_ms + arg_ms);
+            break;
+        case POLL_CTRL_EVENT_POLL:
+            ctrl->polls++;
+            ctrl->radio_on_us += ctrl->model.poll_us;
+            if (time_diff(now_ms, ctrl->fast_until_ms) >= 0) {
+                ctrl->period_ms = ctrl->period_ms > slow / 2 ? slow
+                                                             : ctrl->period_ms * 2;
+            }
+            break;
+        default: break;
+    }
+
+    if (ctrl->period_ms > slow) {
+        ctrl->period_ms = slow;
+    }
+    return ctrl->period_ms;
+}
+
+uint32_t poll_ctrl_radio_ms_per_hour(const poll_ctrl_t* ctrl) {
+    return (uint32_t)((uint64_t)ctrl->model.poll_us * (3600000 / ctrl->period_ms)
+                      / 1000);
+}
+
+void poll_ctrl_replay(const poll_ctrl_cfg_t* cfg,
+                      const poll_ctrl_model_t* model, uint32_t timeout_s,
+                      const poll_ctrl_trace_t* trace, uint16_t num,
+                      uint32_t end_ms, poll_ctrl_result_t* result) {
+    poll_ctrl_t ctrl;
+    uint64_t latency_sum = 0;
+    uint32_t start = num ? trace[0].at_ms : end_ms;
+    uint32_t now = start;
+    uint32_t next, at, latency;
+    uint16_t i;
+
+    memset(result, 0, sizeof(*result));
+    poll_ctrl_init(&ctrl, cfg, model, start);
+    poll_ctrl_timeout_set(&ctrl, timeout_s);
+    next = start + ctrl.period_ms;
+
+    for (i = 0; i < num; i++) {
+        at = trace[i].at_ms;
+        if (time_diff(at, now) < 0) {
+            at = now;
+        }
+
+        /* polls before the event */
+        while (time_diff(next, at) <= 0) {
+            now = next;
+            next = now + poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_POLL, now, 0);
+        }
+
+        if (trace[i].event == POLL_CTRL_EVENT_RX) {
+            /* waits at the parent until the next poll */
+            latency = next - at;
+            latency_sum += latency;
+            if (latency > result->latency_max_ms) {
+                result->latency_max_ms = latency;
+            }
+            now = next;
+            poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_POLL, now, 0);
+            next = now + poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_RX, now, 0);
+        } else if (trace[i].event < POLL_CTRL_EVENT_POLL) {
+            now = at;
+            poll_ctrl_event(&ctrl, (poll_ctrl_event_t)trace[i].event, now,
+                            trace[i].arg_ms);
+            if (time_diff(next, now + ctrl.period_ms) > 0) {
+                next = now + ctrl.period_ms;
+            }
+        }
+    }
+
+    while (time_diff(next, end_ms) <= 0) {
+        now = next;
+        next = now + poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_POLL, now, 0);
+    }
+
+    result->polls = ctrl.polls;
+    result->rx = ctrl.rx;
+    result->radio_on_ms = (uint32_t)(ctrl.radio_on_us / 1000);
+    result->latency_avg_ms = ctrl.rx ? (uint32_t)(latency_sum / ctrl.rx) : 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file pwr_radio.c
+ * @brief Radio state and radio wakeups for the power telemetry, taken from
+ *        the lmac15p4 calls of the OpenThread radio platform.
+ *
+ * The platform lives in the SDK components, so its calls are intercepted at
+ * link time (-Wl,--wrap, see CMakeLists.txt). The MAC callbacks run in the
+ * RF interrupt handler, which is where a radio wakeup is marked.
+ */
+
+#include <FreeRTOS.h>
+#include "lmac15p4.h"
+#include "pwr_telemetry.h"
+#include "subg_ctrl.h"
+
+__typeof__(lmac15p4_cb_set) __real_lmac15p4_cb_set;
+__typeof__(lmac15p4_cb_set) __wrap_lmac15p4_cb_set;
+__typeof__(lmac15p4_tx_data_send) __real_lmac15p4_tx_data_send;
+__typeof__(lmac15p4_tx_data_send) __wrap_lmac15p4_tx_data_send;
+__typeof__(lmac15p4_auto_state_set) __real_lmac15p4_auto_state_set;
+__typeof__(lmac15p4_auto_state_set) __wrap_lmac15p4_auto_state_set;
+__typeof__(subg_ctrl_sleep_set) __real_subg_ctrl_sleep_set;
+__typeof__(subg_ctrl_sleep_set) __wrap_subg_ctrl_sleep_set;
+
+static lmac15p4_callback_t s_mac_cb;
+static bool s_rx_on_idle;
+static bool s_tx;
+
+static pwr_telemetry_radio_t radio_idle(void) {
+    return s_rx_on_idle ? PWR_TELEMETRY_RADIO_RX : PWR_TELEMETRY_RADIO_OFF;
+}
+
+static void pwr_radio_rx_done(uint16_t packet_length, uint8_t* rx_data_address,
+                              uint8_t crc_status, uint8_t rssi, uint8_t snr) {
+    RTOS_TRACE_ISR_ENTER(CommSubsystem_IRQn);
+    pwr_telemetry_wakeup_mark(PWR_TELEMETRY_WAKEUP_RADIO);
+    if (s_mac_cb.rx_cb) {
+        s_mac_cb.rx_cb(packet_length, rx_data_address, crc_status, rssi, snr);
+    }
+    RTOS_TRACE_ISR_EXIT(CommSubsystem_IRQn);
+}
+
+static void pwr_radio_tx_done(uint32_t tx_status) {
+    RTOS_TRACE_ISR_ENTER(CommSubsystem_IRQn);
+    pwr_telemetry_wakeup_mark(PWR_TELEMETRY_WAKEUP_RADIO);
+    s_tx = false;
+    pwr_telemetry_radio_set(radio_idle());
+    if (s_mac_cb.tx_cb) {
+        s_mac_cb.tx_cb(tx_status);
+    }
+    RTOS_TRACE_ISR_EXIT(CommSubsystem_IRQn);
+}
+
+void __wrap_lmac15p4_cb_set(uint32_t mac_index,
+                            lmac15p4_callback_t* callback) {
+    lmac15p4_callback_t mac_cb = *callback;
+
+    s_mac_cb = *callback;
+    mac_cb.rx_cb = pwr_radio_rx_done;
+    mac_cb.tx_cb = pwr_radio_tx_done;
+    __real_lmac15p4_cb_set(mac_index, &mac_cb);
+}
+
+int8_t __wrap_lmac15p4_tx_data_send(uint8_t mac_index, uint8_t* tx_data_address,
+                                    uint16_t packet_length, uint8_t mac_control,
+                                    uint8_t mac_dsn) {
+    int8_t ret;
+
+    s_tx = true;
+    pwr_telemetry_radio_set(PWR_TELEMETRY_RADIO_TX);
+    ret = __real_lmac15p4_tx_data_send(mac_index, tx_data_address,
+                                       packet_length, mac_control, mac_dsn);
+    if (ret != 0) {
+        s_tx = false;
+        pwr_telemetry_radio_set(radio_idle());
+    }
+    return ret;
+}
+
+void __wrap_lmac15p4_auto_state_set(bool rx_on_when_idle) {
+    s_rx_on_idle = rx_on_when_idle;
+    if (!s_tx) {
+        pwr_telemetry_radio_set(radio_idle());
+    }
+    __real_lmac15p4_auto_state_set(rx_on_when_idle);
+}
+
+void __wrap_subg_ctrl_sleep_set(bool sleep) {
+    if (sleep) {
+        s_rx_on_idle = false;
+        s_tx = false;
+        pwr_telemetry_radio_set(PWR_TELEMETRY_RADIO_OFF);
+    }
+    __real_subg_ctrl_sleep_set(sleep);
+}
@@ -0,0 +1,351 @@
+/**
+ * @file pwr_telemetry.c
+ * @brief Power state telemetry: accumulates residency per CPU power state
+ *        and radio state, attributes wakeups to their source and to the
+ *        first task that ran afterwards, and dumps a summary on the CLI.
+ *
+ * All entry points may run from the kernel (PendSV, idle task with the
+ * scheduler suspended) or from interrupt handlers, so every update is done
+ * under the interrupt mask.
+ *
+ * The wakeup source is taken from the first interrupt handler that marks
+ * one, else from the mapped interrupt lines sampled in
+ * pwr_telemetry_sleep_wake() before any handler ran.
+ */
+
+#include <FreeRTOS.h>
+#include <string.h>
+#include <task.h>
+#include "cli.h"
+#include "pwr_telemetry.h"
+
+#ifndef PWR_TELEMETRY_IRQ_PENDING
+#include "mcu.h"
+#define PWR_TELEMETRY_IRQ_PENDING(irq) NVIC_GetPendingIRQ((IRQn_Type)(irq))
+#endif
+
+typedef struct {
+    int irq;
+    pwr_telemetry_wakeup_t source;
+} pwr_telemetry_irq_map_t;
+
+static pwr_telemetry_summary_t s_summary;
+static pwr_telemetry_task_t s_task[PWR_TELEMETRY_TASK_MAX];
+static uint8_t s_task_num;
+
+static pwr_telemetry_irq_map_t s_irq_map[PWR_TELEMETRY_IRQ_MAX];
+static uint8_t s_irq_num;
+
+static pwr_telemetry_state_t s_state;
+static uint32_t s_state_ts;
+static pwr_telemetry_radio_t s_radio;
+static uint32_t s_radio_ts;
+
+static void* s_idle_task;
+static void* s_cur_task;
+static uint32_t s_cur_task_ts;
+
+static bool s_sleeping;
+static bool s_wake_pending;
+static pwr_telemetry_wakeup_t s_wake_mark;
+static pwr_telemetry_wakeup_t s_wake_irq;
+static TickType_t s_sleep_tick;
+static uint32_t s_sleep_expected;
+
+static const char* const s_state_str[PWR_TELEMETRY_STATE_MAX] = {
+    "active", "idle", "sleep"};
+static const char* const s_radio_str[PWR_TELEMETRY_RADIO_MAX] = {"off", "rx",
+                                                                 "tx"};
+static const char* const s_wakeup_str[PWR_TELEMETRY_WAKEUP_MAX] = {
+    "timer", "gpio", "radio", "uart", "other"};
+
+static void state_flush(uint32_t now) {
+    s_summary.state_us[s_state] += (uint32_t)(now - s_state_ts);
+    s_state_ts = now;
+}
+
+static void state_change(pwr_telemetry_state_t state, uint32_t now) {
+    state_flush(now);
+    if (s_state != state) {
+        s_state = state;
+        s_summary.state_entries[state]++;
+    }
+}
+
+static void radio_flush(uint32_t now) {
+    s_summary.radio_us[s_radio] += (uint32_t)(now - s_radio_ts);
+    s_radio_ts = now;
+}
+
+static pwr_telemetry_task_t* task_entry_get(void* task) {
+    uint8_t i;
+
+    for (i = 0; i < s_task_num; i++) {
+        if (s_task[i].task == task) {
+            return &s_task[i];
+        }
+    }
+    if (s_task_num < PWR_TELEMETRY_TASK_MAX) {
+        s_task[s_task_num].task = task;
+        strncpy(s_task[s_task_num].name, pcTaskGetName((TaskHandle_t)task),
+                PWR_TELEMETRY_NAME_LEN - 1);
+        return &s_task[s_task_num++];
+    }
+    return NULL;
+}
+
+/* The Cortex-M ports step the tick one short of a full sleep and leave the
+ * last one to the tick interrupt pending at the wakeup, which the kernel
+ * only counts once the scheduler resumes, after sleep_exit */
+static bool sleep_full(void) {
+    return (uint32_t)(xTaskGetTickCountFromISR() - s_sleep_tick) + 1
+           >= s_sleep_expected;
+}
+
+static pwr_telemetry_wakeup_t wakeup_source_resolve(void) {
+    if (s_wake_mark != PWR_TELEMETRY_WAKEUP_MAX) {
+        return s_wake_mark;
+    }
+
+    if (s_wake_irq != PWR_TELEMETRY_WAKEUP_MAX) {
+        return s_wake_irq;
+    }
+
+    // slept the whole expected time: the tickless wakeup timer fired
+    if (sleep_full()) {
+        return PWR_TELEMETRY_WAKEUP_TIMER;
+    }
+    return PWR_TELEMETRY_WAKEUP_OTHER;
+}
+
+void pwr_telemetry_init(void) {
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    uint32_t now = PWR_TELEMETRY_TIME_US();
+
+    memset(&s_summary, 0, sizeof(s_summary));
+    memset(s_task, 0, sizeof(s_task));
+    s_task_num = 0;
+
+    s_state = PWR_TELEMETRY_STATE_ACTIVE;
+    s_state_ts = now;
+    s_radio_ts = now;
+    s_cur_task_ts = now;
+    s_wake_pending = false;
+    s_wake_mark = PWR_TELEMETRY_WAKEUP_MAX;
+    s_wake_irq = PWR_TELEMETRY_WAKEUP_MAX;
+
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void pwr_telemetry_wakeup_irq_set(int irq, pwr_telemetry_wakeup_t source) {
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    uint8_t i;
+
+    for (i = 0; i < s_irq_num; i++) {
+        if (s_irq_map[i].irq == irq) {
+            break;
+        }
+    }
+    if (i < PWR_TELEMETRY_IRQ_MAX) {
+        s_irq_map[i].irq = irq;
+        s_irq_map[i].source = source;
+        if (i == s_irq_num) {
+            s_irq_num++;
+        }
+    }
+
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void pwr_telemetry_wakeup_mark(pwr_telemetry_wakeup_t source) {
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+
+    if (s_sleeping && s_wake_mark == PWR_TELEMETRY_WAKEUP_MAX
+        && source < PWR_TELEMETRY_WAKEUP_MAX) {
+        s_wake_mark = source;
+    }
+
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void pwr_telemetry_radio_set(pwr_telemetry_radio_t radio) {
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+
+    if (radio < PWR_TELEMETRY_RADIO_MAX && radio != s_radio) {
+        radio_flush(PWR_TELEMETRY_TIME_US());
+        s_radio = radio;
+    }
+
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void pwr_telemetry_task_switched_in(void* task) {
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    uint32_t now = PWR_TELEMETRY_TIME_US();
+    pwr_telemetry_task_t* entry;
+
+    if (s_idle_task == NULL) {
+        s_idle_task = (void*)xTaskGetIdleTaskHandle();
+    }
+
+    if (s_cur_task != NULL && s_cur_task != s_idle_task) {
+        entry = task_entry_get(s_cur_task);
+        if (entry != NULL) {
+            entry->active_us += (uint32_t)(now - s_cur_task_ts);
+        }
+    }
+    s_cur_task = task;
+    s_cur_task_ts = now;
+
+    if (task == s_idle_task) {
+        state_change(PWR_TELEMETRY_STATE_IDLE, now);
+    } else {
+        entry = task_entry_get(task);
+        if (entry != NULL) {
+            if (s_wake_pending) {
+                entry->wakeups++;
+            } else if (s_state == PWR_TELEMETRY_STATE_IDLE) {
+                entry->idle_breaks++;
+            }
+        }
+        s_wake_pending = false;
+        state_change(PWR_TELEMETRY_STATE_ACTIVE, now);
+    }
+
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void pwr_telemetry_sleep_enter(uint32_t expected_idle_ticks) {
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+
+    state_change(PWR_TELEMETRY_STATE_SLEEP, PWR_TELEMETRY_TIME_US());
+    s_sleep_tick = xTaskGetTickCountFromISR();
+    s_sleep_expected = expected_idle_ticks;
+    s_wake_mark = PWR_TELEMETRY_WAKEUP_MAX;
+    s_wake_irq = PWR_TELEMETRY_WAKEUP_MAX;
+    s_sleeping = true;
+
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void pwr_telemetry_sleep_wake(void) {
+    uint8_t i;
+
+    // interrupts are still masked, nothing has cleared its pending bit yet
+    for (i = 0; i < s_irq_num; i++) {
+        if (PWR_TELEMETRY_IRQ_PENDING(s_irq_map[i].irq)) {
+            s_wake_irq = s_irq_map[i].source;
+            break;
+        }
+    }
+}
+
+void pwr_telemetry_sleep_exit(void) {
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    pwr_telemetry_wakeup_t source;
+
+    state_change(PWR_TELEMETRY_STATE_IDLE, PWR_TELEMETRY_TIME_US());
+
+    source = wakeup_source_resolve();
+    s_summary.wakeups[source]++;
+    if (!sleep_full()) {
+        s_summary.short_sleeps++;
+    }
+    s_sleeping = false;
+    s_wake_pending = true;
+
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void pwr_telemetry_summary_get(pwr_telemetry_summary_t* summary) {
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    uint32_t now = PWR_TELEMETRY_TIME_US();
+    uint8_t i;
+
+    state_flush(now);
+    radio_flush(now);
+    memcpy(summary, &s_summary, sizeof(*summary));
+
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+
+    summary->elapsed_us = 0;
+    for (i = 0; i < PWR_TELEMETRY_STATE_MAX; i++) {
+        summary->elapsed_us += summary->state_us[i];
+    }
+}
+
+uint8_t pwr_telemetry_task_get(pwr_telemetry_task_t* tasks, uint8_t max) {
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    uint8_t num = (s_task_num < max) ? s_task_num : max;
+
+    memcpy(tasks, s_task, num * sizeof(pwr_telemetry_task_t));
+
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+    return num;
+}
+
+static uint32_t pct_x100(uint64_t part, uint64_t total) {
+    return (total == 0) ? 0 : (uint32_t)((part * 10000) / total);
+}
+
+static void print_summary(cb_shell_out_t log_out) {
+    pwr_telemetry_summary_t summary;
+    pwr_telemetry_task_t tasks[PWR_TELEMETRY_TASK_MAX];
+    uint8_t num, i;
+    uint32_t pct;
+
+    pwr_telemetry_summary_get(&summary);
+    num = pwr_telemetry_task_get(tasks, PWR_TELEMETRY_TASK_MAX);
+
+    log_out("elapsed(ms)  : %lu\r\n",
+            (unsigned long)(summary.elapsed_us / 1000));
+    for (i = 0; i < PWR_TELEMETRY_STATE_MAX; i++) {
+        pct = pct_x100(summary.state_us[i], summary.elapsed_us);
+        log_out("%-12s : %10lu ms %3lu.%02lu%% entries %lu\r\n", s_state_str[i],
+                (unsigned long)(summary.state_us[i] / 1000),
+                (unsigned long)(pct / 100), (unsigned long)(pct % 100),
+                (unsigned long)summary.state_entries[i]);
+    }
+    for (i = 0; i < PWR_TELEMETRY_RADIO_MAX; i++) {
+        pct = pct_x100(summary.radio_us[i], summary.elapsed_us);
+        log_out("radio %-6s : %10lu ms %3lu.%02lu%%\r\n", s_radio_str[i],
+                (unsigned long)(summary.radio_us[i] / 1000),
+                (unsigned long)(pct / 100), (unsigned long)(pct % 100));
+    }
+    log_out("wakeups      :");
+    for (i = 0; i < PWR_TELEMETRY_WAKEUP_MAX; i++) {
+        log_out(" %s %lu", s_wakeup_str[i], (unsigned long)summary.wakeups[i]);
+    }
+    log_out("\r\nshort sleeps : %lu\r\n", (unsigned long)summary.short_sleeps);
+
+    log_out("%-16s %10s %8s %11s\r\n", "task", "active(ms)", "wakeups",
+            "idle-breaks");
+    for (i = 0; i < num; i++) {
+        log_out("%-16s %10lu %8lu %11lu\r\n", tasks[i].name,
+                (unsigned long)(tasks[i].active_us / 1000),
+                (unsigned long)tasks[i].wakeups,
+                (unsigned long)tasks[i].idle_breaks);
+    }
+}
+
+static int _cli_cmd_pwr(int argc, char** argv, cb_shell_out_t log_out,
+                        void* pExtra) {
+    if (argc < 2 || !strncmp(argv[1], "show", 4)) {
+        print_summary(log_out);
+    } else if (!strncmp(argv[1], "reset", 5)) {
+        pwr_telemetry_init();
+    } else {
+        log_out("pwr show \r\n");
+        log_out("pwr reset \r\n");
+        return -1;
+    }
+
+    log_out("+Ok \r\n");
+    return 0;
+}
+
+const sh_cmd_t g_cli_cmd_pwr STATIC_CLI_CMD_ATTRIBUTE = {
+    .pCmd_name = "pwr",
+    .pDescription = "Power state telemetry : pwr <show/reset>",
+    .cmd_exec = _cli_cmd_pwr,
+};
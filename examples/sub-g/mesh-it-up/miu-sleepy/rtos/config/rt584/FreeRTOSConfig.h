@@ -44,7 +44,7 @@ See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
 #define configUSE_APPLICATION_TASK_TAG	0
 #define configUSE_COUNTING_SEMAPHORES	1
 #define configGENERATE_RUN_TIME_STATS	0
-#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 1
 #define configSUPPORT_STATIC_ALLOCATION 1
 
 
@@ -94,6 +94,34 @@ to exclude the API function. */
 //#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()    rt584_utick_set_clear()
 //#define portGET_RUN_TIME_COUNTER_VALUE()       Timer_25us_Tick
 
+/* Binary trace recorder, see rtos_trace.h. The cycle counter stops in
+ * sleep, set RTOS_TRACE_TIMESTAMP to a sleep timer for wall clock times. */
+#define configUSE_RTOS_TRACE 0
+
+#if (CONFIG_APP_PWR_TELEMETRY == 1)
+/* Power state telemetry hooks, see pwr_telemetry.h */
+void pwr_telemetry_task_switched_in(void* task);
+void pwr_telemetry_sleep_enter(uint32_t expected_idle_ticks);
+void pwr_telemetry_sleep_exit(void);
+void pwr_telemetry_sleep_wake(void);
+#if (configUSE_RTOS_TRACE == 1)
+void rtos_trace_task_switched_in(const void* task, uint8_t priority, uint32_t tick);
+#define traceTASK_SWITCHED_IN()                                                \
+    do {                                                                       \
+        pwr_telemetry_task_switched_in((void*)pxCurrentTCB);                   \
+        rtos_trace_task_switched_in(pxCurrentTCB,                              \
+                                    (uint8_t)pxCurrentTCB->uxPriority,         \
+                                    xTickCount);                               \
+    } while (0)
+#else
+#define traceTASK_SWITCHED_IN()     pwr_telemetry_task_switched_in((void*)pxCurrentTCB)
+#endif
+#define traceLOW_POWER_IDLE_BEGIN() pwr_telemetry_sleep_enter((uint32_t)xExpectedIdleTime)
+#define traceLOW_POWER_IDLE_END()   pwr_telemetry_sleep_exit()
+#define configPOST_SLEEP_PROCESSING(x) pwr_telemetry_sleep_wake()
+#endif /* CONFIG_APP_PWR_TELEMETRY */
+#include "rtos_trace.h"
+
 /* Stop if an assertion fails. */
 #define configASSERT(x)                                                                                                            \
     if ((x) == 0)                                                                                                                  \
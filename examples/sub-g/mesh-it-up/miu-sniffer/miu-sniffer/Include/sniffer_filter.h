@@ -0,0 +1,115 @@
+/**
+ * @file sniffer_filter.h
+ * @brief On-device capture filter: drops, truncates and trims captured
+ *        frames in the spinel stream before it reaches the UART.
+ *
+ * The RCP sends every received frame to the host as an HDLC framed spinel
+ * STREAM_RAW property. The filter sits between the HDLC encoder and the
+ * UART: it decodes each frame, matches the 802.15.4 header and the RSSI
+ * against the configuration, and re-encodes the frames it keeps, cut to
+ * the snap length and without the vendor and MAC metadata when compact.
+ * Other spinel frames pass unchanged.
+ *
+ * Frames that lack a filtered field, an immediate ACK has no PAN ID nor
+ * address, are kept so the exchanges of the selected devices stay
+ * complete.
+ *
+ * The capturing host reads and sets the filter through two vendor spinel
+ * properties. The filter watches the bytes from the host, answers
+ * PROP_VALUE_GET and PROP_VALUE_SET of its properties with PROP_VALUE_IS,
+ * and cuts these requests short so the stack drops them.
+ */
+
+#ifndef __SNIFFER_FILTER_H
+#define __SNIFFER_FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Longest decoded spinel frame, FCS included; longer ones are dropped */
+#ifndef SNIFFER_FILTER_FRAME_MAX
+#define SNIFFER_FILTER_FRAME_MAX 2200
+#endif
+
+/** Longest input passed to sniffer_filter_feed() */
+#ifndef SNIFFER_FILTER_CHUNK_MAX
+#define SNIFFER_FILTER_CHUNK_MAX 512
+#endif
+
+#define SNIFFER_FILTER_PAN_ANY  0xFFFF
+#define SNIFFER_FILTER_RSSI_ANY (-128)
+#define SNIFFER_FILTER_TYPE_ALL 0xFF
+
+/** Frame type mask bits, 1 << frame type */
+#define SNIFFER_FILTER_TYPE_BEACON (1 << 0)
+#define SNIFFER_FILTER_TYPE_DATA   (1 << 1)
+#define SNIFFER_FILTER_TYPE_ACK    (1 << 2)
+#define SNIFFER_FILTER_TYPE_CMD    (1 << 3)
+
+/**
+ * Vendor spinel properties. The configuration is 16 bytes little endian:
+ * PAN ID (2), address length (1), address (8, over the air order), type
+ * mask (1), minimum RSSI (1, signed), snap length (2), compact (1). The
+ * counters are the seven uint32_t of sniffer_filter_stats_t, a set of
+ * any value clears them.
+ */
+#define SNIFFER_FILTER_PROP_CFG     0x3C01
+#define SNIFFER_FILTER_PROP_STATS   0x3C02
+#define SNIFFER_FILTER_CFG_WIRE_LEN 16
+
+typedef struct {
+    uint16_t pan_id;     /**< destination or source PAN, SNIFFER_FILTER_PAN_ANY */
+    uint8_t addr_len;    /**< 0 any address, 2 short or 8 extended */
+    uint8_t addr[8];     /**< destination or source address, over the air order */
+    uint8_t type_mask;   /**< frame types kept */
+    int8_t rssi_min;     /**< dBm, SNIFFER_FILTER_RSSI_ANY */
+    uint16_t snap_len;   /**< PSDU bytes kept, 0 whole frame */
+    bool compact;        /**< drop the vendor and MAC metadata */
+} sniffer_filter_cfg_t;
+
+typedef struct {
+    uint32_t frames;     /**< captured frames seen */
+    uint32_t passed;
+    uint32_t filtered;   /**< dropped by the configuration */
+    uint32_t truncated;  /**< cut to the snap length */
+    uint32_t oversize;   /**< longer than SNIFFER_FILTER_FRAME_MAX, dropped */
+    uint32_t bad;        /**< HDLC FCS errors, dropped */
+    uint32_t overflow;   /**< no room in the output, dropped */
+} sniffer_filter_stats_t;
+
+/** Reset the configuration to pass everything */
+void sniffer_filter_init(void);
+
+void sniffer_filter_set(const sniffer_filter_cfg_t* cfg);
+void sniffer_filter_get(sniffer_filter_cfg_t* cfg);
+
+/** Whether any filtering, truncation or trimming is configured */
+bool sniffer_filter_active(void);
+
+/**
+ * @brief Run HDLC encoded bytes through the filter
+ * @param in encoded bytes, at most SNIFFER_FILTER_CHUNK_MAX
+ * @param out set to the encoded frames completed by this input, valid
+ *        until the next call
+ * @return length of out, 0 while a frame is incomplete or dropped
+ */
+uint32_t sniffer_filter_feed(const uint8_t* in, uint32_t len,
+                             const uint8_t** out);
+
+void sniffer_filter_stats(sniffer_filter_stats_t* stats);
+void sniffer_filter_stats_reset(void);
+
+/**
+ * @brief Look at HDLC encoded bytes from the host before the stack does
+ * @param in bytes for the stack, a request for a filter property is ended
+ *        early in place so that its FCS fails there
+ */
+void sniffer_filter_host(uint8_t* in, uint32_t len);
+
+/**
+ * @brief Take the HDLC encoded reply to a filter property request
+ * @return bytes copied to buf, 0 when no reply waits or it does not fit
+ */
+uint32_t sniffer_filter_reply(uint8_t* buf, uint32_t size);
+
+#endif // __SNIFFER_FILTER_H
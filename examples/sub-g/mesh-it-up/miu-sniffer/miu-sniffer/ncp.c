@@ -8,10 +8,15 @@
 #include "miu_port.h"
 
 #include "FreeRTOS.h"
+#include "cli.h"
 #include "hosal_swi.h"
 #include "hosal_uart.h"
 #include "task.h"
 
+#if (CONFIG_APP_SNIFFER_FILTER == 1)
+#include "sniffer_filter.h"
+#endif
+
 //=============================================================================
 //                  Constant Definition
 //=============================================================================
@@ -67,7 +72,31 @@ HOSAL_UART_DEV_DECL(cpc_uart_dev, CONFIG_APP_OT_NCP_OPERATION_UART_PORT,
     g_ot_ncp_uart_evt_var = OT_NCP_UART_EVENT_NONE;                            \
     leave_critical_section()
 
-#define OT_NCP_UART_DATA_CACHE_SIZE 512
+/* RX ring, a power of two. At 2 Mbaud it holds ~20 ms of input while the
+ * task is busy handing frames to the HDLC decoder. */
+#ifndef OT_NCP_UART_RX_RING_SIZE
+#define OT_NCP_UART_RX_RING_SIZE 4096
+#endif
+
+#if (OT_NCP_UART_RX_RING_SIZE & (OT_NCP_UART_RX_RING_SIZE - 1)) != 0
+#error "OT_NCP_UART_RX_RING_SIZE must be a power of two"
+#endif
+
+#define OT_NCP_UART_RX_RING_MASK (OT_NCP_UART_RX_RING_SIZE - 1)
+
+/* HDLC flag sequence, ends every frame of the stack */
+#define OT_NCP_HDLC_FLAG 0x7E
+
+/* DMA transfer size, longer sends go out in several transfers */
+#ifndef OT_NCP_UART_TX_BUF_SIZE
+#define OT_NCP_UART_TX_BUF_SIZE 512
+#endif
+
+/* RTS/CTS: when the ring is full the RX interrupt is held off, the FIFO
+ * fills and RTS stops the host instead of bytes being dropped */
+#ifndef CONFIG_APP_OT_NCP_OPERATION_UART_FLOW_CONTROL
+#define CONFIG_APP_OT_NCP_OPERATION_UART_FLOW_CONTROL 0
+#endif
 
 //=============================================================================
 //                  Structure Definition
@@ -76,31 +105,58 @@ typedef enum {
     OT_NCP_UART_EVENT_NONE = 0,
     OT_NCP_UART_EVENT_TRIGGER = 0x00000001,
     OT_NCP_UART_EVENT_UART_IN = 0x00000002,
+    OT_NCP_UART_EVENT_TX_DONE = 0x00000004,
     OT_NCP_UART_EVENT_UART_TIMEOUT = 0x00000010,
 
     OT_NCP_UART_EVENT_ALL = 0xffffffff,
 } ot_ncp_uart_event_t;
 
+/* Single producer, single consumer: wr_idx is only written by the UART
+ * interrupt and rd_idx only by the NCP task. Both run freely and are
+ * masked on access, so no lock is needed to publish either. */
 typedef struct ncp_uart {
     /* data */
     volatile uint32_t wr_idx;
     volatile uint32_t rd_idx;
-    uint8_t rx_cache[OT_NCP_UART_DATA_CACHE_SIZE];
+    volatile uint8_t rx_paused;
+    uint8_t rx_cache[OT_NCP_UART_RX_RING_SIZE];
 } ot_ncp_uart_io_t;
 
+/* Two TX buffers, the next transfer is staged while the other is in
+ * flight. Only touched by tasks, with the scheduler suspended. */
+typedef struct {
+    uint8_t buf[2][OT_NCP_UART_TX_BUF_SIZE];
+    const uint8_t* pending;  /* bytes of the last send not copied yet */
+    uint32_t pending_len;
+    uint16_t staged_len;
+    uint8_t fill;            /* buffer the next bytes are copied into */
+    uint8_t staged;          /* fill holds a transfer waiting for the DMA */
+    uint8_t busy;            /* DMA in flight */
+    uint8_t done_owed;       /* send-done held until pending is copied */
+    uint8_t boundary;        /* the bytes sent so far end an HDLC frame */
+} ot_ncp_uart_tx_t;
+
+typedef struct {
+    uint32_t rx_bytes;
+    uint32_t rx_dropped;     /* bytes read and lost on a full ring */
+    uint32_t rx_pauses;      /* RX held off by flow control */
+    uint32_t rx_peak;        /* highest ring fill */
+    uint32_t tx_dma;         /* DMA transfers */
+    uint32_t tx_deferred;    /* sends reported done only after a DMA */
+} ot_ncp_uart_stats_t;
+
 static ot_ncp_uart_event_t g_ot_ncp_uart_evt_var;
 
 static ot_ncp_uart_io_t g_uart_io = {
     .wr_idx = 0,
 };
 
-static uint8_t g_tx_buf[OT_NCP_UART_DATA_CACHE_SIZE];
-static uint8_t g_rx_buf[32];
-
-static hosal_uart_dma_cfg_t txdam_cfg = {
-    .dma_buf = g_tx_buf,
-    .dma_buf_size = sizeof(g_tx_buf),
+static ot_ncp_uart_tx_t g_uart_tx = {
+    .boundary = 1,
 };
+static ot_ncp_uart_stats_t g_uart_stats;
+
+static hosal_uart_dma_cfg_t txdam_cfg;
 
 static TaskHandle_t ot_ncp_utask_handle = NULL;
 
@@ -117,120 +173,186 @@ static void _uart_sw_isr_cb(uint32_t sw_id) {
         OT_NCP_UART_NOTIFY_ISR(OT_NCP_UART_EVENT_UART_IN);
     }
 }
-#if (CONFIG_APP_OT_NCP_OPERATION_UART_PORT == 1)
-void uart1_handler(void) {
-    uint32_t wr_pos = g_uart_io.wr_idx;
-    uint32_t rd_pos = g_uart_io.rd_idx;
-    uint32_t pos = 0, cnt;
-    uint8_t value[8] = {0};
-    uart_t* uart = UART1;
-    uint32_t iir;
-    uint32_t tx = 0;
 
-    NVIC_ClearPendingIRQ(Uart1_IRQn);
+static void _uart_rx_drain(void) {
+    uint32_t wr_pos = g_uart_io.wr_idx;
+    uint32_t used, chunk, cnt;
+#if (CONFIG_APP_OT_NCP_OPERATION_UART_FLOW_CONTROL == 0)
+    uint8_t discard[16];
+#endif
 
-    do {
-        /* code */
-        iir = uart->IIR & IIR_INTID_MSK;
+    for (;;) {
+        used = wr_pos - g_uart_io.rd_idx;
+        if (used == OT_NCP_UART_RX_RING_SIZE) {
+#if (CONFIG_APP_OT_NCP_OPERATION_UART_FLOW_CONTROL == 1)
+            /* leave the bytes in the FIFO, RTS deasserts as it fills */
+            hosal_uart_ioctl(&cpc_uart_dev, HOSAL_UART_DISABLE_INTERRUPT, NULL);
+            g_uart_io.rx_paused = 1;
+            g_uart_stats.rx_pauses++;
+            break;
+#else
+            cnt = hosal_uart_receive(&cpc_uart_dev, discard, sizeof(discard));
+            if (cnt == 0) {
+                break;
+            }
+            g_uart_stats.rx_dropped += cnt;
+            continue;
+#endif
+        }
 
-        if ((uart->xDMA_INT_STATUS & xDMA_ISR_TX) == xDMA_ISR_TX) {
-            uart->xDMA_INT_STATUS = xDMA_ISR_TX;
-            uart->xDMA_TX_ENABLE = xDMA_Stop;
-            hosal_swi_trigger(HOSAL_SWI0_ID, 0);
+        /* straight into the ring, up to the wrap */
+        chunk = OT_NCP_UART_RX_RING_SIZE - (wr_pos & OT_NCP_UART_RX_RING_MASK);
+        if (chunk > OT_NCP_UART_RX_RING_SIZE - used) {
+            chunk = OT_NCP_UART_RX_RING_SIZE - used;
         }
-        /* Triger receiver FIFO exceeds and in last 4 character times
-         didn't read from the FIFO. */
-        if ((iir == IIR_INTID_RDA) || (iir == IIR_INTID_CTI)) {
-            if (uart->LSR & UART_LSR_DR) {
-                cnt = hosal_uart_receive(&cpc_uart_dev, value, 8);
-
-                if (cnt > 0) {
-                    pos = (wr_pos + cnt) % OT_NCP_UART_DATA_CACHE_SIZE;
-                    if (pos == rd_pos) {
-                        hosal_swi_trigger(HOSAL_SWI0_ID, 1);
-                        break;
-                    }
-
-                    for (int i = 0; i < cnt; i++)
-                        g_uart_io.rx_cache[((wr_pos + i)
-                                            % OT_NCP_UART_DATA_CACHE_SIZE)] =
-                            value[i];
-                    g_uart_io.wr_idx = pos;
-                    hosal_swi_trigger(HOSAL_SWI0_ID, 1);
-                } else {
-                    log_error("UART receive failed");
-                }
-            }
+        cnt = hosal_uart_receive(&cpc_uart_dev,
+                                 &g_uart_io.rx_cache[wr_pos & OT_NCP_UART_RX_RING_MASK],
+                                 chunk);
+        if (cnt == 0) {
+            break;
         }
-    } while (0);
+        wr_pos += cnt;
+        g_uart_stats.rx_bytes += cnt;
+        if (used + cnt > g_uart_stats.rx_peak) {
+            g_uart_stats.rx_peak = used + cnt;
+        }
+    }
+
+    if (wr_pos != g_uart_io.wr_idx || g_uart_io.rx_paused) {
+        g_uart_io.wr_idx = wr_pos;
+        hosal_swi_trigger(HOSAL_SWI0_ID, 1);
+    }
+}
+
+static void _uart_isr(uart_t* uart) {
+    uint32_t iir;
+
+    iir = uart->IIR & IIR_INTID_MSK;
+
+    if ((uart->xDMA_INT_STATUS & xDMA_ISR_TX) == xDMA_ISR_TX) {
+        uart->xDMA_INT_STATUS = xDMA_ISR_TX;
+        uart->xDMA_TX_ENABLE = xDMA_Stop;
+        hosal_swi_trigger(HOSAL_SWI0_ID, 0);
+    }
+    /* Triger receiver FIFO exceeds and in last 4 character times
+     didn't read from the FIFO. */
+    if ((iir == IIR_INTID_RDA) || (iir == IIR_INTID_CTI)) {
+        if (uart->LSR & UART_LSR_DR) {
+            _uart_rx_drain();
+        }
+    }
+}
+
+#if (CONFIG_APP_OT_NCP_OPERATION_UART_PORT == 1)
+void uart1_handler(void) {
+    NVIC_ClearPendingIRQ(Uart1_IRQn);
+    _uart_isr(UART1);
 }
 #endif
 
 #if (CONFIG_APP_OT_NCP_OPERATION_UART_PORT == 0)
 void uart0_handler(void) {
+    NVIC_ClearPendingIRQ(Uart0_IRQn);
+    _uart_isr(UART0);
+}
+#endif
 
-    uint32_t wr_pos = g_uart_io.wr_idx;
+static void _uart_data_read(void) {
     uint32_t rd_pos = g_uart_io.rd_idx;
-    uint32_t pos = 0, cnt;
-    uint8_t value[8] = {0};
-    uart_t* uart = UART0;
-    uint32_t iir;
+    uint32_t wr_pos = g_uart_io.wr_idx;
+    uint32_t off, len;
+
+    /* hand the ring to the decoder in place, at most two segments */
+    while (rd_pos != wr_pos) {
+        off = rd_pos & OT_NCP_UART_RX_RING_MASK;
+        len = wr_pos - rd_pos;
+        if (len > OT_NCP_UART_RX_RING_SIZE - off) {
+            len = OT_NCP_UART_RX_RING_SIZE - off;
+        }
+#if (CONFIG_APP_SNIFFER_FILTER == 1)
+        /* filter property requests are answered here, cut for the stack */
+        sniffer_filter_host(&g_uart_io.rx_cache[off], len);
+#endif
+        otNcpHdlcReceive(&g_uart_io.rx_cache[off], len);
 
-    NVIC_ClearPendingIRQ(Uart0_IRQn);
+        rd_pos += len;
+        g_uart_io.rd_idx = rd_pos;
+        wr_pos = g_uart_io.wr_idx;
+    }
 
-    do {
-        /* code */
-        iir = uart->IIR & IIR_INTID_MSK;
+    if (g_uart_io.rx_paused) {
+        g_uart_io.rx_paused = 0;
+        hosal_uart_ioctl(&cpc_uart_dev, HOSAL_UART_ENABLE_INTERRUPT, NULL);
+    }
+}
 
-        if ((uart->xDMA_INT_STATUS & xDMA_ISR_TX) == xDMA_ISR_TX) {
-            uart->xDMA_INT_STATUS = xDMA_ISR_TX;
-            uart->xDMA_TX_ENABLE = xDMA_Stop;
-            hosal_swi_trigger(HOSAL_SWI0_ID, 0);
-        }
+static void _uart_dma_start(uint8_t idx, uint16_t len) {
+    txdam_cfg.dma_buf = g_uart_tx.buf[idx];
+    txdam_cfg.dma_buf_size = len;
+    g_uart_tx.busy = 1;
+    g_uart_stats.tx_dma++;
+
+    hosal_uart_ioctl(&cpc_uart_dev, HOSAL_UART_DMA_TX_START, &txdam_cfg);
+}
 
-        if ((iir == IIR_INTID_RDA) || (iir == IIR_INTID_CTI)) {
-            if (uart->LSR & UART_LSR_DR) {
-                cnt = hosal_uart_receive(&cpc_uart_dev, value, 8);
-
-                if (cnt > 0) {
-                    pos = (wr_pos + cnt) % OT_NCP_UART_DATA_CACHE_SIZE;
-                    if (pos == rd_pos)
-                        break;
-
-                    for (int i = 0; i < cnt; i++)
-                        g_uart_io.rx_cache[((wr_pos + i)
-                                            % OT_NCP_UART_DATA_CACHE_SIZE)] =
-                            value[i];
-                    g_uart_io.wr_idx = pos;
-                    hosal_swi_trigger(HOSAL_SWI0_ID, 1);
-                }
+/* Copy pending bytes into the free buffer and keep the DMA running */
+static void _uart_tx_pump(void) {
+    uint32_t n;
+
+    for (;;) {
+        if (!g_uart_tx.staged && g_uart_tx.pending_len) {
+            n = g_uart_tx.pending_len;
+            if (n > OT_NCP_UART_TX_BUF_SIZE) {
+                n = OT_NCP_UART_TX_BUF_SIZE;
             }
+            memcpy(g_uart_tx.buf[g_uart_tx.fill], g_uart_tx.pending, n);
+            g_uart_tx.pending += n;
+            g_uart_tx.pending_len -= n;
+            g_uart_tx.staged_len = (uint16_t)n;
+            g_uart_tx.staged = 1;
+        }
+        if (!g_uart_tx.staged || g_uart_tx.busy) {
+            break;
+        }
+        _uart_dma_start(g_uart_tx.fill, g_uart_tx.staged_len);
+        g_uart_tx.fill ^= 1;
+        g_uart_tx.staged = 0;
+    }
+}
+
+#if (CONFIG_APP_SNIFFER_FILTER == 1)
+/* A filter reply goes out between two frames of the stack, staged in the
+ * free buffer in one piece */
+static void _uart_tx_reply(void) {
+    vTaskSuspendAll();
+    if (g_uart_tx.boundary && !g_uart_tx.pending_len && !g_uart_tx.staged) {
+        g_uart_tx.staged_len = (uint16_t)sniffer_filter_reply(
+            g_uart_tx.buf[g_uart_tx.fill], OT_NCP_UART_TX_BUF_SIZE);
+        if (g_uart_tx.staged_len) {
+            g_uart_tx.staged = 1;
+            _uart_tx_pump();
         }
-    } while (0);
+    }
+    xTaskResumeAll();
 }
 #endif
-static size_t _uart_data_read(uint8_t* pbuf, int length) {
-    size_t byte_cnt = 0;
-    uint32_t rd_pos = g_uart_io.rd_idx;
-    uint32_t wr_pos = g_uart_io.wr_idx;
 
-    do {
-        /* code */
-        while (1) {
-            if (rd_pos == wr_pos)
-                break;
-            if (length == byte_cnt)
-                break;
+static void _uart_dma_done(void) {
+    uint8_t send_done = 0;
 
-            pbuf[byte_cnt++] = g_uart_io.rx_cache[rd_pos];
-            rd_pos = (rd_pos + 1) % OT_NCP_UART_DATA_CACHE_SIZE;
-        }
-        hosal_uart_ioctl(&cpc_uart_dev, HOSAL_UART_DISABLE_INTERRUPT, NULL);
-        g_uart_io.rd_idx = rd_pos;
-        hosal_uart_ioctl(&cpc_uart_dev, HOSAL_UART_ENABLE_INTERRUPT, NULL);
-    } while (0);
+    vTaskSuspendAll();
+    g_uart_tx.busy = 0;
+    _uart_tx_pump();
+    if (g_uart_tx.done_owed && !g_uart_tx.pending_len) {
+        g_uart_tx.done_owed = 0;
+        send_done = 1;
+    }
+    xTaskResumeAll();
 
-    return byte_cnt;
+    /* the last send is copied out, the encoder may reuse its buffer */
+    if (send_done) {
+        otNcpHdlcSendDone();
+    }
 }
 
 static void ot_ncp_uart_signal(void) {
@@ -242,11 +364,28 @@ static void ot_ncp_uart_signal(void) {
     }
 }
 
-static void ot_ncp_task_loop(void* parameters_ptr) {
+static void ot_ncp_uart_process(void) {
     ot_ncp_uart_event_t sevent = OT_NCP_UART_EVENT_NONE;
-    static uint8_t uart_packet[OT_NCP_UART_DATA_CACHE_SIZE];
-    uint32_t data_len = 0;
 
+    OT_NCP_UART_GET_NOTIFY(sevent);
+    if (OT_NCP_UART_EVENT_TRIGGER & sevent) {
+        _uart_dma_done();
+    }
+
+    if (OT_NCP_UART_EVENT_TX_DONE & sevent) {
+        otNcpHdlcSendDone();
+    }
+
+    if (OT_NCP_UART_EVENT_UART_IN & sevent) {
+        _uart_data_read();
+    }
+
+#if (CONFIG_APP_SNIFFER_FILTER == 1)
+    _uart_tx_reply();
+#endif
+}
+
+static void ot_ncp_task_loop(void* parameters_ptr) {
     /* Configure UART to interrupt mode */
     hosal_uart_ioctl(&cpc_uart_dev, HOSAL_UART_MODE_SET,
                      (void*)HOSAL_UART_MODE_INT_RX);
@@ -256,36 +395,90 @@ static void ot_ncp_task_loop(void* parameters_ptr) {
     else if (CONFIG_APP_OT_NCP_OPERATION_UART_PORT == 1)
         NVIC_SetPriority(Uart1_IRQn, 0);
 
-    memset(uart_packet, 0x00, sizeof(uart_packet));
-
     for (;;) {
-        OT_NCP_UART_GET_NOTIFY(sevent);
-        if (OT_NCP_UART_EVENT_TRIGGER & sevent) {
-            otNcpHdlcSendDone();
-        }
-
-        if (OT_NCP_UART_EVENT_UART_IN & sevent) {
-            data_len = _uart_data_read(uart_packet,
-                                       OT_NCP_UART_DATA_CACHE_SIZE);
-            otNcpHdlcReceive(uart_packet, data_len);
-        }
+        ot_ncp_uart_process();
         ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     }
 }
 
 static int NcpSend(const uint8_t* aBuf, uint16_t aBufLength) {
-    txdam_cfg.dma_buf_size = aBufLength;
-    memcpy(txdam_cfg.dma_buf, aBuf, aBufLength);
+    const uint8_t* out = aBuf;
+    uint32_t out_len = aBufLength;
+    uint8_t send_done;
+
+#if (CONFIG_APP_SNIFFER_FILTER == 1)
+    /* switching the filter on or off loses the frame in progress */
+    if (sniffer_filter_active()) {
+        out_len = sniffer_filter_feed(aBuf, aBufLength, &out);
+    }
+#endif
 
-    hosal_uart_ioctl(&cpc_uart_dev, HOSAL_UART_DMA_TX_START, &txdam_cfg);
+    vTaskSuspendAll();
+    if (out_len) {
+        g_uart_tx.boundary = out[out_len - 1] == OT_NCP_HDLC_FLAG;
+    }
+    g_uart_tx.pending = out;
+    g_uart_tx.pending_len = out_len;
+    _uart_tx_pump();
+    send_done = !g_uart_tx.pending_len;
+    if (!send_done) {
+        /* sent and reported done as the running DMA completes */
+        g_uart_tx.done_owed = 1;
+        g_uart_stats.tx_deferred++;
+    }
+    xTaskResumeAll();
+
+    /* copied out, let the encoder build the next frame meanwhile */
+    if (send_done) {
+        OT_NCP_UART_NOTIFY(OT_NCP_UART_EVENT_TX_DONE);
+    }
     return aBufLength;
 }
 
+static int _cli_cmd_ncp_uart(int argc, char** argv, cb_shell_out_t log_out,
+                             void* pExtra) {
+    ot_ncp_uart_stats_t stats;
+
+    if (argc < 2 || !strncmp(argv[1], "show", 4)) {
+        enter_critical_section();
+        stats = g_uart_stats;
+        leave_critical_section();
+
+        log_out("rx bytes     : %lu\r\n", (unsigned long)stats.rx_bytes);
+        log_out("rx dropped   : %lu\r\n", (unsigned long)stats.rx_dropped);
+        log_out("rx pauses    : %lu\r\n", (unsigned long)stats.rx_pauses);
+        log_out("rx peak      : %lu/%u\r\n", (unsigned long)stats.rx_peak,
+                OT_NCP_UART_RX_RING_SIZE);
+        log_out("tx dma       : %lu\r\n", (unsigned long)stats.tx_dma);
+        log_out("tx deferred  : %lu\r\n", (unsigned long)stats.tx_deferred);
+    } else if (!strncmp(argv[1], "reset", 5)) {
+        enter_critical_section();
+        memset(&g_uart_stats, 0, sizeof(g_uart_stats));
+        leave_critical_section();
+    } else {
+        log_out("ncpuart show \r\n");
+        log_out("ncpuart reset \r\n");
+        return -1;
+    }
+
+    log_out("+Ok \r\n");
+    return 0;
+}
+
+const sh_cmd_t g_cli_cmd_ncp_uart STATIC_CLI_CMD_ATTRIBUTE = {
+    .pCmd_name = "ncpuart",
+    .pDescription = "NCP UART counters : ncpuart <show/reset>",
+    .cmd_exec = _cli_cmd_ncp_uart,
+};
+
 void otAppNcpInit(otInstance* aInstance) { otNcpHdlcInit(aInstance, NcpSend); }
 
 void otrInitUser(otInstance* instance) {
     BaseType_t xReturned;
     /*Init UART In the first place*/
+#if (CONFIG_APP_OT_NCP_OPERATION_UART_FLOW_CONTROL == 1)
+    cpc_uart_dev.config.flow_control = UART_HWFC_ENABLED;
+#endif
     hosal_uart_init(&cpc_uart_dev);
 
     hosal_swi_callback_register(HOSAL_SWI0_ID, HOSAL_TRIG_0, _uart_sw_isr_cb);
@@ -300,6 +493,9 @@ void otrInitUser(otInstance* instance) {
     if (xReturned != pdPASS) {
         log_error("task create fail\n");
     }
+#if (CONFIG_APP_SNIFFER_FILTER == 1)
+    sniffer_filter_init();
+#endif
     otAppCliInit((otInstance*)instance);
     otAppNcpInit((otInstance*)instance);
 }
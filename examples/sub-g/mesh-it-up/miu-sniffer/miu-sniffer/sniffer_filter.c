@@ -0,0 +1,756 @@
+/**
+ * @file sniffer_filter.c
+ * @brief On-device capture filter, see sniffer_filter.h.
+ *
+ * Feeding is serialised by the NCP, which hands over the next chunk only
+ * after the previous send completed; the configuration is written from
+ * the CLI task and copied under the interrupt mask once per frame. The
+ * bytes from the host and the replies are handled in the NCP task too.
+ */
+
+#include <FreeRTOS.h>
+#include <stdlib.h>
+#include <string.h>
+#include <task.h>
+#include "cli.h"
+#include "sniffer_filter.h"
+
+#define HDLC_FLAG        0x7E
+#define HDLC_ESCAPE      0x7D
+#define HDLC_XON         0x11
+#define HDLC_XOFF        0x13
+#define HDLC_SPECIAL     0xF8
+#define HDLC_ESCAPE_XOR  0x20
+#define HDLC_FCS_INIT    0xFFFF
+#define HDLC_FCS_GOOD    0xF0B8
+
+#define SPINEL_HEADER_FLAG        0x80
+#define SPINEL_HEADER_FLAG_MASK   0xC0
+#define SPINEL_CMD_PROP_VALUE_GET 2
+#define SPINEL_CMD_PROP_VALUE_SET 3
+#define SPINEL_CMD_PROP_VALUE_IS  6
+#define SPINEL_PROP_LAST_STATUS   0
+#define SPINEL_PROP_STREAM_RAW    0x71
+#define SPINEL_STATUS_PARSE_ERROR 9
+
+/* rssi, noise floor and flags, then the PHY data struct */
+#define SPINEL_RAW_META_FIXED 4
+
+#define MAC_FCF_TYPE_MASK     0x0007
+#define MAC_FCF_PANID_COMP    (1 << 6)
+#define MAC_FCF_SEQ_SUPPRESS  (1 << 8)
+#define MAC_FCF_DST_MODE(fcf) (((fcf) >> 10) & 3)
+#define MAC_FCF_VERSION(fcf)  (((fcf) >> 12) & 3)
+#define MAC_FCF_SRC_MODE(fcf) (((fcf) >> 14) & 3)
+#define MAC_ADDR_MODE_SHORT   2
+#define MAC_ADDR_MODE_EXT     3
+#define MAC_VERSION_2015      2
+
+/* worst case: the frame carried over from earlier input, every byte
+ * escaped, plus frames completed within this input */
+#define FILTER_OUT_SIZE                                                        \
+    (2 * (SNIFFER_FILTER_FRAME_MAX + 2) + SNIFFER_FILTER_CHUNK_MAX)
+
+/* header, command, a two byte property, the value and the FCS */
+#define HOST_FRAME_MAX (4 + SNIFFER_FILTER_CFG_WIRE_LEN + 2)
+#define REPLY_VALUE_MAX sizeof(sniffer_filter_stats_t)
+#define REPLY_SIZE      (2 * (4 + REPLY_VALUE_MAX + 2) + 2)
+
+typedef struct {
+    uint16_t dst_pan;
+    uint16_t src_pan;
+    const uint8_t* dst;
+    const uint8_t* src;
+    uint8_t dst_len;
+    uint8_t src_len;
+    uint8_t type;
+    bool has_dst_pan;
+    bool has_src_pan;
+} mac_hdr_t;
+
+/* CRC-16/X.25 a nibble at a time */
+static const uint16_t s_fcs_table[16] = {
+    0x0000, 0x1081, 0x2102, 0x3183, 0x4204, 0x5285, 0x6306, 0x7387,
+    0x8408, 0x9489, 0xA50A, 0xB58B, 0xC60C, 0xD68D, 0xE70E, 0xF78F,
+};
+
+static sniffer_filter_cfg_t s_cfg;
+static sniffer_filter_stats_t s_stats;
+
+static uint8_t s_dec[SNIFFER_FILTER_FRAME_MAX];
+static uint32_t s_dec_len;
+static bool s_escape;
+static bool s_dec_overflow;
+
+static uint8_t s_out[FILTER_OUT_SIZE];
+static uint32_t s_out_len;
+
+static uint8_t s_host[HOST_FRAME_MAX];
+static uint32_t s_host_len;
+static bool s_host_escape;
+static bool s_host_ours;  /* a request for a filter property */
+static bool s_host_skip;  /* any other frame, left to the stack */
+static bool s_host_cut;   /* the next byte ends the request for the stack */
+
+static uint8_t s_reply[REPLY_SIZE];
+static uint32_t s_reply_len;
+
+static inline uint16_t fcs_update(uint16_t fcs, uint8_t b) {
+    fcs = (fcs >> 4) ^ s_fcs_table[(fcs ^ b) & 0x0F];
+    return (fcs >> 4) ^ s_fcs_table[(fcs ^ (b >> 4)) & 0x0F];
+}
+
+static inline uint16_t get_le16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline bool hdlc_needs_escape(uint8_t b) {
+    return b == HDLC_FLAG || b == HDLC_ESCAPE || b == HDLC_XON
+           || b == HDLC_XOFF || b == HDLC_SPECIAL;
+}
+
+static inline uint32_t out_byte(uint8_t* dst, uint8_t b) {
+    if (hdlc_needs_escape(b)) {
+        dst[0] = HDLC_ESCAPE;
+        dst[1] = b ^ HDLC_ESCAPE_XOR;
+        return 2;
+    }
+    dst[0] = b;
+    return 1;
+}
+
+/* dst holds at least 2 * (len + 2) + 2 bytes */
+static uint32_t hdlc_encode(uint8_t* dst, const uint8_t* buf, uint32_t len) {
+    uint16_t fcs = HDLC_FCS_INIT;
+    uint32_t i, n = 0;
+
+    dst[n++] = HDLC_FLAG;
+    for (i = 0; i < len; i++) {
+        fcs = fcs_update(fcs, buf[i]);
+        n += out_byte(&dst[n], buf[i]);
+    }
+    fcs ^= 0xFFFF;
+    n += out_byte(&dst[n], (uint8_t)fcs);
+    n += out_byte(&dst[n], (uint8_t)(fcs >> 8));
+    dst[n++] = HDLC_FLAG;
+    return n;
+}
+
+static void hdlc_emit(const uint8_t* buf, uint32_t len) {
+    if (s_out_len + 2 * (len + 2) + 2 > sizeof(s_out)) {
+        s_stats.overflow++;
+        return;
+    }
+    s_out_len += hdlc_encode(&s_out[s_out_len], buf, len);
+}
+
+static bool hdlc_fcs_good(const uint8_t* buf, uint32_t len) {
+    uint16_t fcs = HDLC_FCS_INIT;
+    uint32_t i;
+
+    for (i = 0; i < len; i++) {
+        fcs = fcs_update(fcs, buf[i]);
+    }
+    return fcs == HDLC_FCS_GOOD;
+}
+
+/* spinel packed unsigned integer, 7 bits per byte, at most 3 bytes */
+static uint32_t spinel_uint(const uint8_t* p, uint32_t len, uint32_t* value) {
+    uint32_t i;
+
+    *value = 0;
+    for (i = 0; i < len && i < 3; i++) {
+        *value |= (uint32_t)(p[i] & 0x7F) << (7 * i);
+        if (!(p[i] & 0x80)) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+static bool mac_addr_len(uint8_t mode, uint8_t* len) {
+    if (mode == MAC_ADDR_MODE_SHORT) {
+        *len = 2;
+    } else if (mode == MAC_ADDR_MODE_EXT) {
+        *len = 8;
+    } else if (mode == 0) {
+        *len = 0;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool mac_parse(const uint8_t* psdu, uint16_t len, mac_hdr_t* hdr) {
+    uint16_t fcf, off;
+    uint8_t dst_mode, src_mode;
+    bool comp;
+
+    memset(hdr, 0, sizeof(*hdr));
+    if (len < 3) {
+        return false;
+    }
+
+    fcf = get_le16(psdu);
+    hdr->type = fcf & MAC_FCF_TYPE_MASK;
+    comp = (fcf & MAC_FCF_PANID_COMP) != 0;
+    dst_mode = MAC_FCF_DST_MODE(fcf);
+    src_mode = MAC_FCF_SRC_MODE(fcf);
+    if (!mac_addr_len(dst_mode, &hdr->dst_len)
+        || !mac_addr_len(src_mode, &hdr->src_len)) {
+        return false;
+    }
+
+    off = 2;
+    if (MAC_FCF_VERSION(fcf) == MAC_VERSION_2015) {
+        if (!(fcf & MAC_FCF_SEQ_SUPPRESS)) {
+            off++;
+        }
+        /* 802.15.4-2015 table 7-2, the common cases */
+        if (!dst_mode && !src_mode) {
+            hdr->has_dst_pan = comp;
+        } else if (dst_mode && !src_mode) {
+            hdr->has_dst_pan = !comp;
+        } else if (!dst_mode && src_mode) {
+            hdr->has_src_pan = !comp;
+        } else if (dst_mode == MAC_ADDR_MODE_EXT && src_mode == MAC_ADDR_MODE_EXT) {
+            hdr->has_dst_pan = !comp;
+        } else {
+            hdr->has_dst_pan = true;
+            hdr->has_src_pan = !comp;
+        }
+    } else {
+        off++;
+        hdr->has_dst_pan = dst_mode != 0;
+        hdr->has_src_pan = src_mode != 0 && !comp;
+    }
+
+    if (hdr->has_dst_pan) {
+        if (off + 2 > len) {
+            return false;
+        }
+        hdr->dst_pan = get_le16(&psdu[off]);
+        off += 2;
+    }
+    if (hdr->dst_len) {
+        if (off + hdr->dst_len > len) {
+            return false;
+        }
+        hdr->dst = &psdu[off];
+        off += hdr->dst_len;
+    }
+    if (hdr->has_src_pan) {
+        if (off + 2 > len) {
+            return false;
+        }
+        hdr->src_pan = get_le16(&psdu[off]);
+        off += 2;
+    }
+    if (hdr->src_len) {
+        if (off + hdr->src_len > len) {
+            return false;
+        }
+        hdr->src = &psdu[off];
+    }
+    return true;
+}
+
+static bool frame_match(const sniffer_filter_cfg_t* cfg, const uint8_t* psdu,
+                        uint16_t len, int8_t rssi) {
+    mac_hdr_t hdr;
+
+    if (cfg->rssi_min != SNIFFER_FILTER_RSSI_ANY && rssi < cfg->rssi_min) {
+        return false;
+    }
+
+    if (!mac_parse(psdu, len, &hdr)) {
+        /* nothing to match a header filter against */
+        return cfg->type_mask == SNIFFER_FILTER_TYPE_ALL
+               && cfg->pan_id == SNIFFER_FILTER_PAN_ANY && cfg->addr_len == 0;
+    }
+
+    if (!(cfg->type_mask & (1 << hdr.type))) {
+        return false;
+    }
+
+    if (cfg->pan_id != SNIFFER_FILTER_PAN_ANY
+        && (hdr.has_dst_pan || hdr.has_src_pan)
+        && !(hdr.has_dst_pan && hdr.dst_pan == cfg->pan_id)
+        && !(hdr.has_src_pan && hdr.src_pan == cfg->pan_id)) {
+        return false;
+    }
+
+    if (cfg->addr_len && (hdr.dst_len || hdr.src_len)
+        && !(hdr.dst_len == cfg->addr_len
+             && !memcmp(hdr.dst, cfg->addr, cfg->addr_len))
+        && !(hdr.src_len == cfg->addr_len
+             && !memcmp(hdr.src, cfg->addr, cfg->addr_len))) {
+        return false;
+    }
+
+    return true;
+}
+
+static void frame_done(void) {
+    sniffer_filter_cfg_t cfg;
+    uint8_t* p = s_dec;
+    uint32_t n, off, used, cmd, prop;
+    uint32_t meta_len, keep;
+    uint16_t psdu_len, snap;
+    uint8_t* meta;
+    int8_t rssi;
+    bool modified = false;
+
+    if (s_dec_overflow) {
+        s_stats.oversize++;
+        return;
+    }
+    if (s_dec_len < 3) {
+        return;
+    }
+
+    n = s_dec_len;
+    if (!hdlc_fcs_good(p, n)) {
+        s_stats.bad++;
+        return;
+    }
+    n -= 2;
+
+    /* header, command, property */
+    off = 1;
+    used = spinel_uint(&p[off], n - off, &cmd);
+    off += used;
+    if (!used || cmd != SPINEL_CMD_PROP_VALUE_IS) {
+        hdlc_emit(p, n);
+        return;
+    }
+    used = spinel_uint(&p[off], n - off, &prop);
+    off += used;
+    if (!used || prop != SPINEL_PROP_STREAM_RAW || off + 2 > n
+        || off + 2 + get_le16(&p[off]) > n) {
+        hdlc_emit(p, n);
+        return;
+    }
+
+    psdu_len = get_le16(&p[off]);
+    meta = &p[off + 2 + psdu_len];
+    meta_len = n - (off + 2 + psdu_len);
+    rssi = meta_len ? (int8_t)meta[0] : 0;
+
+    taskENTER_CRITICAL();
+    cfg = s_cfg;
+    taskEXIT_CRITICAL();
+
+    s_stats.frames++;
+    if (!frame_match(&cfg, &p[off + 2], psdu_len, rssi)) {
+        s_stats.filtered++;
+        return;
+    }
+    s_stats.passed++;
+
+    keep = meta_len;
+    if (cfg.compact && meta_len >= SPINEL_RAW_META_FIXED + 2) {
+        /* keep rssi, noise floor, flags and the PHY struct (channel,
+         * LQI, timestamp), drop the vendor and MAC structs after it */
+        keep = SPINEL_RAW_META_FIXED + 2
+               + get_le16(&meta[SPINEL_RAW_META_FIXED]);
+        if (keep > meta_len) {
+            keep = meta_len;
+        }
+        modified = keep != meta_len;
+    }
+
+    snap = psdu_len;
+    if (cfg.snap_len && psdu_len > cfg.snap_len) {
+        snap = cfg.snap_len;
+        p[off] = (uint8_t)snap;
+        p[off + 1] = (uint8_t)(snap >> 8);
+        memmove(&p[off + 2 + snap], meta, keep);
+        s_stats.truncated++;
+        modified = true;
+    }
+
+    if (modified) {
+        n = off + 2 + snap + keep;
+    }
+    hdlc_emit(p, n);
+}
+
+void sniffer_filter_init(void) {
+    sniffer_filter_cfg_t cfg;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.pan_id = SNIFFER_FILTER_PAN_ANY;
+    cfg.type_mask = SNIFFER_FILTER_TYPE_ALL;
+    cfg.rssi_min = SNIFFER_FILTER_RSSI_ANY;
+    sniffer_filter_set(&cfg);
+}
+
+void sniffer_filter_set(const sniffer_filter_cfg_t* cfg) {
+    taskENTER_CRITICAL();
+    s_cfg = *cfg;
+    taskEXIT_CRITICAL();
+}
+
+void sniffer_filter_get(sniffer_filter_cfg_t* cfg) {
+    taskENTER_CRITICAL();
+    *cfg = s_cfg;
+    taskEXIT_CRITICAL();
+}
+
+bool sniffer_filter_active(void) {
+    sniffer_filter_cfg_t cfg;
+
+    sniffer_filter_get(&cfg);
+    return cfg.pan_id != SNIFFER_FILTER_PAN_ANY || cfg.addr_len
+           || cfg.type_mask != SNIFFER_FILTER_TYPE_ALL
+           || cfg.rssi_min != SNIFFER_FILTER_RSSI_ANY || cfg.snap_len
+           || cfg.compact;
+}
+
+uint32_t sniffer_filter_feed(const uint8_t* in, uint32_t len,
+                             const uint8_t** out) {
+    uint32_t i;
+    uint8_t b;
+
+    s_out_len = 0;
+    for (i = 0; i < len; i++) {
+        b = in[i];
+        if (b == HDLC_FLAG) {
+            frame_done();
+            s_dec_len = 0;
+            s_escape = false;
+            s_dec_overflow = false;
+            continue;
+        }
+        if (b == HDLC_ESCAPE) {
+            s_escape = true;
+            continue;
+        }
+        if (s_escape) {
+            b ^= HDLC_ESCAPE_XOR;
+            s_escape = false;
+        }
+        if (s_dec_len < sizeof(s_dec)) {
+            s_dec[s_dec_len++] = b;
+        } else {
+            s_dec_overflow = true;
+        }
+    }
+
+    *out = s_out;
+    return s_out_len;
+}
+
+void sniffer_filter_stats(sniffer_filter_stats_t* stats) {
+    taskENTER_CRITICAL();
+    *stats = s_stats;
+    taskEXIT_CRITICAL();
+}
+
+void sniffer_filter_stats_reset(void) {
+    taskENTER_CRITICAL();
+    memset(&s_stats, 0, sizeof(s_stats));
+    taskEXIT_CRITICAL();
+}
+
+static void cfg_pack(const sniffer_filter_cfg_t* cfg, uint8_t* p) {
+    p[0] = (uint8_t)cfg->pan_id;
+    p[1] = (uint8_t)(cfg->pan_id >> 8);
+    p[2] = cfg->addr_len;
+    memcpy(&p[3], cfg->addr, 8);
+    p[11] = cfg->type_mask;
+    p[12] = (uint8_t)cfg->rssi_min;
+    p[13] = (uint8_t)cfg->snap_len;
+    p[14] = (uint8_t)(cfg->snap_len >> 8);
+    p[15] = cfg->compact;
+}
+
+static bool cfg_unpack(const uint8_t* p, sniffer_filter_cfg_t* cfg) {
+    if (p[2] != 0 && p[2] != 2 && p[2] != 8) {
+        return false;
+    }
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->pan_id = get_le16(p);
+    cfg->addr_len = p[2];
+    memcpy(cfg->addr, &p[3], cfg->addr_len);
+    cfg->type_mask = p[11];
+    cfg->rssi_min = (int8_t)p[12];
+    cfg->snap_len = get_le16(&p[13]);
+    cfg->compact = p[15] != 0;
+    return true;
+}
+
+/* the second and third byte of a packed filter property */
+static bool host_prop_ours(const uint8_t* p) {
+    uint32_t prop;
+
+    return spinel_uint(p, 2, &prop) == 2
+           && (prop == SNIFFER_FILTER_PROP_CFG
+               || prop == SNIFFER_FILTER_PROP_STATS);
+}
+
+static void host_reply(const uint8_t* req, const uint8_t* value,
+                       uint32_t len) {
+    uint8_t buf[4 + REPLY_VALUE_MAX];
+
+    /* one reply waits at a time, the host asks again */
+    if (s_reply_len) {
+        return;
+    }
+    buf[0] = req[0];
+    buf[1] = SPINEL_CMD_PROP_VALUE_IS;
+    buf[2] = req[2];
+    buf[3] = req[3];
+    memcpy(&buf[4], value, len);
+    s_reply_len = hdlc_encode(s_reply, buf, 4 + len);
+}
+
+static void host_status(const uint8_t* req, uint8_t status) {
+    uint8_t buf[4] = {req[0], SPINEL_CMD_PROP_VALUE_IS,
+                      SPINEL_PROP_LAST_STATUS, status};
+
+    if (!s_reply_len) {
+        s_reply_len = hdlc_encode(s_reply, buf, sizeof(buf));
+    }
+}
+
+/* a whole request for a filter property */
+static void host_done(void) {
+    sniffer_filter_stats_t stats;
+    sniffer_filter_cfg_t cfg;
+    uint8_t value[SNIFFER_FILTER_CFG_WIRE_LEN];
+    uint32_t prop, len;
+    uint8_t cmd;
+
+    if (s_host_len < 6 || !hdlc_fcs_good(s_host, s_host_len)) {
+        return;
+    }
+    len = s_host_len - 2 - 4;
+    cmd = s_host[1];
+    spinel_uint(&s_host[2], 2, &prop);
+
+    if (prop == SNIFFER_FILTER_PROP_CFG) {
+        if (cmd == SPINEL_CMD_PROP_VALUE_SET) {
+            if (len != SNIFFER_FILTER_CFG_WIRE_LEN
+                || !cfg_unpack(&s_host[4], &cfg)) {
+                host_status(s_host, SPINEL_STATUS_PARSE_ERROR);
+                return;
+            }
+            sniffer_filter_set(&cfg);
+        }
+        sniffer_filter_get(&cfg);
+        cfg_pack(&cfg, value);
+        host_reply(s_host, value, sizeof(value));
+    } else {
+        if (cmd == SPINEL_CMD_PROP_VALUE_SET) {
+            sniffer_filter_stats_reset();
+        }
+        /* the counters go out in the order of the struct */
+        sniffer_filter_stats(&stats);
+        host_reply(s_host, (const uint8_t*)&stats, sizeof(stats));
+    }
+}
+
+void sniffer_filter_host(uint8_t* in, uint32_t len) {
+    uint32_t i;
+    uint8_t b;
+
+    for (i = 0; i < len; i++) {
+        b = in[i];
+        if (s_host_cut && b != HDLC_FLAG) {
+            /* the stack sees the request end here, with a bad FCS */
+            in[i] = HDLC_FLAG;
+        }
+        s_host_cut = false;
+
+        if (b == HDLC_FLAG) {
+            if (s_host_ours) {
+                host_done();
+            }
+            s_host_len = 0;
+            s_host_escape = false;
+            s_host_ours = false;
+            s_host_skip = false;
+            continue;
+        }
+        if (s_host_skip) {
+            continue;
+        }
+        if (b == HDLC_ESCAPE) {
+            s_host_escape = true;
+            continue;
+        }
+        if (s_host_escape) {
+            b ^= HDLC_ESCAPE_XOR;
+            s_host_escape = false;
+        }
+        if (s_host_len == sizeof(s_host)) {
+            /* too long for a request of ours, already cut for the stack */
+            s_host_ours = false;
+            s_host_skip = true;
+            continue;
+        }
+        s_host[s_host_len++] = b;
+
+        if (s_host_len == 4 && !s_host_ours) {
+            if ((s_host[0] & SPINEL_HEADER_FLAG_MASK) == SPINEL_HEADER_FLAG
+                && (s_host[1] == SPINEL_CMD_PROP_VALUE_GET
+                    || s_host[1] == SPINEL_CMD_PROP_VALUE_SET)
+                && host_prop_ours(&s_host[2])) {
+                s_host_ours = true;
+                s_host_cut = true;
+            } else {
+                s_host_skip = true;
+            }
+        }
+    }
+}
+
+uint32_t sniffer_filter_reply(uint8_t* buf, uint32_t size) {
+    uint32_t len = s_reply_len;
+
+    if (!len || len > size) {
+        return 0;
+    }
+    memcpy(buf, s_reply, len);
+    s_reply_len = 0;
+    return len;
+}
+
+static int parse_addr(const char* str, sniffer_filter_cfg_t* cfg) {
+    uint32_t digits;
+    uint8_t i;
+    char byte[3] = {0};
+
+    if (!strncmp(str, "0x", 2) || !strncmp(str, "0X", 2)) {
+        str += 2;
+    }
+    digits = strlen(str);
+    if (digits != 4 && digits != 16) {
+        return -1;
+    }
+
+    /* written most significant byte first, sent least significant first */
+    cfg->addr_len = (uint8_t)(digits / 2);
+    for (i = 0; i < cfg->addr_len; i++) {
+        byte[0] = str[2 * i];
+        byte[1] = str[2 * i + 1];
+        cfg->addr[cfg->addr_len - 1 - i] = (uint8_t)strtoul(byte, NULL, 16);
+    }
+    return 0;
+}
+
+static void print_filter(cb_shell_out_t log_out) {
+    sniffer_filter_cfg_t cfg;
+    sniffer_filter_stats_t stats;
+    int8_t i;
+
+    sniffer_filter_get(&cfg);
+    sniffer_filter_stats(&stats);
+
+    if (cfg.pan_id == SNIFFER_FILTER_PAN_ANY) {
+        log_out("pan       : any\r\n");
+    } else {
+        log_out("pan       : 0x%04x\r\n", cfg.pan_id);
+    }
+    log_out("addr      : ");
+    if (!cfg.addr_len) {
+        log_out("any");
+    }
+    for (i = cfg.addr_len - 1; i >= 0; i--) {
+        log_out("%02x", cfg.addr[i]);
+    }
+    log_out("\r\ntype mask : 0x%02x\r\n", cfg.type_mask);
+    if (cfg.rssi_min == SNIFFER_FILTER_RSSI_ANY) {
+        log_out("rssi      : any\r\n");
+    } else {
+        log_out("rssi      : >= %d dBm\r\n", cfg.rssi_min);
+    }
+    log_out("snap      : %u\r\n", cfg.snap_len);
+    log_out("compact   : %s\r\n", cfg.compact ? "on" : "off");
+
+    log_out("frames %lu passed %lu filtered %lu truncated %lu\r\n",
+            (unsigned long)stats.frames, (unsigned long)stats.passed,
+            (unsigned long)stats.filtered, (unsigned long)stats.truncated);
+    log_out("dropped: oversize %lu bad %lu overflow %lu\r\n",
+            (unsigned long)stats.oversize, (unsigned long)stats.bad,
+            (unsigned long)stats.overflow);
+}
+
+static void print_help(cb_shell_out_t log_out) {
+    log_out("snfilter show \r\n");
+    log_out("snfilter reset \r\n");
+    log_out("snfilter clear \r\n");
+    log_out("snfilter pan <id/any> \r\n");
+    log_out("snfilter addr <short/extended/any> \r\n");
+    log_out("snfilter type <mask/all>  sum of 1 beacon 2 data 4 ack 8 cmd \r\n");
+    log_out("snfilter rssi <dBm/any> \r\n");
+    log_out("snfilter snap <len> \r\n");
+    log_out("snfilter compact <on/off> \r\n");
+}
+
+static int _cli_cmd_snfilter(int argc, char** argv, cb_shell_out_t log_out,
+                             void* pExtra) {
+    sniffer_filter_cfg_t cfg;
+    bool any;
+
+    if (argc < 2 || !strncmp(argv[1], "show", 4)) {
+        print_filter(log_out);
+        log_out("+Ok \r\n");
+        return 0;
+    }
+    if (!strncmp(argv[1], "reset", 5)) {
+        sniffer_filter_stats_reset();
+        log_out("+Ok \r\n");
+        return 0;
+    }
+    if (!strncmp(argv[1], "clear", 5)) {
+        sniffer_filter_init();
+        log_out("+Ok \r\n");
+        return 0;
+    }
+    if (argc < 3) {
+        print_help(log_out);
+        return -1;
+    }
+
+    sniffer_filter_get(&cfg);
+    any = !strncmp(argv[2], "any", 3) || !strncmp(argv[2], "all", 3);
+
+    if (!strncmp(argv[1], "pan", 3)) {
+        cfg.pan_id = any ? SNIFFER_FILTER_PAN_ANY
+                         : (uint16_t)strtoul(argv[2], NULL, 16);
+    } else if (!strncmp(argv[1], "addr", 4)) {
+        if (any) {
+            cfg.addr_len = 0;
+        } else if (parse_addr(argv[2], &cfg) < 0) {
+            log_out("4 or 16 hex digits \r\n");
+            return -1;
+        }
+    } else if (!strncmp(argv[1], "type", 4)) {
+        cfg.type_mask = any ? SNIFFER_FILTER_TYPE_ALL
+                            : (uint8_t)strtoul(argv[2], NULL, 0);
+    } else if (!strncmp(argv[1], "rssi", 4)) {
+        cfg.rssi_min = any ? SNIFFER_FILTER_RSSI_ANY
+                           : (int8_t)strtol(argv[2], NULL, 10);
+    } else if (!strncmp(argv[1], "snap", 4)) {
+        cfg.snap_len = (uint16_t)strtoul(argv[2], NULL, 10);
+    } else if (!strncmp(argv[1], "compact", 7)) {
+        cfg.compact = !strncmp(argv[2], "on", 2);
+    } else {
+        print_help(log_out);
+        return -1;
+    }
+
+    sniffer_filter_set(&cfg);
+    log_out("+Ok \r\n");
+    return 0;
+}
+
+const sh_cmd_t g_cli_cmd_snfilter STATIC_CLI_CMD_ATTRIBUTE = {
+    .pCmd_name = "snfilter",
+    .pDescription = "Capture filter : snfilter <show/reset/clear/pan/addr/"
+                    "type/rssi/snap/compact>",
+    .cmd_exec = _cli_cmd_snfilter,
+};
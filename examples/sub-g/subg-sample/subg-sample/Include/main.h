@@ -42,4 +42,31 @@
             0x8A, 0x84, 0x39, 0xF4, 0x36, 0x0B, 0xF7                                                            \
     }
 
+#if (CONFIG_APP_SUBG_TS == 1)
+#include "subg_ts.h"
+
+void app_ts_init(void);
+void app_ts_rate_set(uint8_t mode, uint8_t data_rate);
+void app_ts_tx_enqueue(uint16_t len);
+void app_ts_tx_mark(uint8_t stage);
+void app_ts_tx_done_isr(void);
+void app_ts_tx_complete(uint32_t tx_status);
+void app_ts_rx(uint32_t now, uint16_t len, subg_ts_rx_t* rx);
+const subg_ts_rx_t* app_ts_rx_last(void);
+uint32_t app_ts_now(void);
+uint32_t app_ts_ticks_to_us(uint32_t ticks);
+int app_ts_tx_sfd(uint32_t* sfd);
+/* a stamp taken at most one counter wrap ago, as microseconds since boot;
+ * called once per wrap at least */
+uint64_t app_ts_local_us(uint32_t ticks);
+#endif
+
+#if (CONFIG_APP_SUBG_SYNC == 1)
+void app_sync_init(bool coord, void (*slot_cb)(void));
+int app_sync_tx_request(void);
+bool app_sync_slot_process(void);
+bool app_sync_tx_done(uint32_t tx_status);
+bool app_sync_rx(const uint8_t* frame, uint16_t len, uint32_t sfd);
+#endif
+
 #endif // __MAIN_H
@@ -0,0 +1,119 @@
+/**
+ * @file subg_sync.h
+ * @brief Time synchronisation and TX slots for a Sub-GHz star: the
+ *        coordinator beacons its clock, nodes estimate offset and drift
+ *        from the beacons and send in a slot derived from their address.
+ *
+ * Network time is the coordinator clock. A slotframe of cfg.slots slots
+ * starts every slots * slot_us us of network time. Slot 0 carries the
+ * beacon every beacon_frames slotframes, a node sends in slot
+ * 1 + addr % (slots - 1), guard_us after the slot boundary.
+ *
+ * Beacons are two-step: a beacon carries the network time of the SFD of
+ * the previous one, measured after it was sent, so channel access delay
+ * does not add to the estimate. A node pairs it with its own RX SFD
+ * timestamp of that beacon.
+ *
+ * Times are 64-bit microsecond counts of the local clock, no RTOS or
+ * driver dependency.
+ */
+
+#ifndef __SUBG_SYNC_H
+#define __SUBG_SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SUBG_SYNC_MAGIC      0x5C
+#define SUBG_SYNC_BEACON_LEN 19
+
+/** Drift estimate smoothing, 1/2^n of each new measurement */
+#ifndef SUBG_SYNC_DRIFT_SHIFT
+#define SUBG_SYNC_DRIFT_SHIFT 2
+#endif
+
+typedef struct {
+    uint32_t slot_us;
+    uint16_t slots;        /**< per slotframe, slot 0 is the beacon */
+    uint8_t beacon_frames; /**< slotframes from one beacon to the next */
+    uint8_t lost_beacons;  /**< missed before a node is unsynchronised */
+    uint16_t guard_us;     /**< sync error and timer jitter allowed */
+} subg_sync_cfg_t;
+
+typedef struct {
+    subg_sync_cfg_t cfg;
+    uint16_t addr;
+    uint16_t slot;
+    bool coord;
+    bool synced;
+
+    /* network time = ref_net + dt + dt * drift_ppb / 10^9, dt from ref_local */
+    uint64_t ref_local;
+    uint64_t ref_net;
+    int32_t drift_ppb;
+    uint8_t samples; /**< beacon pairs since synchronised, saturates */
+
+    uint8_t seq;        /**< coordinator: next beacon, node: last received */
+    bool seq_valid;
+    uint64_t seq_sfd;   /**< local SFD of beacon seq, sent or received */
+    uint64_t last_beacon;
+
+    int32_t error_us;      /**< last prediction error at a beacon */
+    uint32_t error_max_us; /**< largest one since synchronised */
+    uint32_t beacons;
+    uint32_t lost;
+} subg_sync_t;
+
+/**
+ * @param coord true on the coordinator, synchronised from the start
+ * @param now local time
+ */
+void subg_sync_init(subg_sync_t* sync, const subg_sync_cfg_t* cfg,
+                    uint16_t addr, bool coord, uint64_t now);
+
+uint16_t subg_sync_slot_of(const subg_sync_cfg_t* cfg, uint16_t addr);
+
+uint64_t subg_sync_to_net(const subg_sync_t* sync, uint64_t local);
+uint64_t subg_sync_to_local(const subg_sync_t* sync, uint64_t net);
+
+/**
+ * @brief Start of the next slot of this node at or after now
+ * @param at local time to start sending
+ * @return 0, -1 when not synchronised
+ */
+int subg_sync_next_slot(const subg_sync_t* sync, uint64_t now, uint64_t* at);
+
+/**
+ * @brief Coordinator: start of the next beacon slot at or after now
+ * @return 0, -1 on a node
+ */
+int subg_sync_next_beacon(const subg_sync_t* sync, uint64_t now,
+                          uint64_t* at);
+
+/**
+ * @brief Coordinator: beacon payload, SUBG_SYNC_BEACON_LEN bytes
+ */
+uint8_t subg_sync_beacon_build(const subg_sync_t* sync, uint8_t* buf);
+
+/**
+ * @brief Coordinator: the beacon built last has been sent
+ * @param ok false when it did not go on air
+ * @param sfd local time of the end of its SFD
+ */
+void subg_sync_beacon_sent(subg_sync_t* sync, bool ok, uint64_t sfd);
+
+/**
+ * @brief Node: a beacon received, the schedule it carries is adopted
+ * @param sfd local time of the end of its SFD
+ * @return 0, -1 when not a beacon
+ */
+int subg_sync_beacon_rx(subg_sync_t* sync, const uint8_t* buf, uint16_t len,
+                        uint64_t sfd);
+
+/**
+ * @brief Node: drop synchronisation after lost_beacons missed beacons
+ * @return synchronised
+ */
+bool subg_sync_check(subg_sync_t* sync, uint64_t now);
+
+#endif // __SUBG_SYNC_H
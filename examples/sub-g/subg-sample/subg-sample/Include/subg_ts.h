@@ -0,0 +1,173 @@
+/**
+ * @file subg_ts.h
+ * @brief Sub-GHz MAC timestamps: one record per frame handed to lmac15p4,
+ *        latency histograms per data rate, and the time of arrival of
+ *        received frames.
+ *
+ * TX stages, in order:
+ *  - ENQUEUE: lmac15p4_tx_data_send called
+ *  - CSMA: first backoff of the last attempt started
+ *  - TX: channel clear, SHR on air
+ *  - TX_DONE: last bit of the frame on air
+ *  - ACK: immediate ACK received
+ * The tx done callback closes the record. A stage the MAC did not mark is
+ * estimated back from the completion with the frame and ACK airtime, and the
+ * frame counted as estimated.
+ *
+ * Timestamps are ticks of a free running 32-bit counter at the rate given to
+ * subg_ts_init, intervals up to one counter wrap. No RTOS or driver
+ * dependency.
+ */
+
+#ifndef __SUBG_TS_H
+#define __SUBG_TS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Data rates tracked at once, in the order they are first selected */
+#ifndef SUBG_TS_RATES
+#define SUBG_TS_RATES 5
+#endif
+
+/** Bin 0 holds 0-1 us, bin n 2^n to 2^(n+1) - 1 us, the last one the rest */
+#ifndef SUBG_TS_BINS
+#define SUBG_TS_BINS 18
+#endif
+
+typedef enum {
+    SUBG_TS_ENQUEUE = 0,
+    SUBG_TS_CSMA,
+    SUBG_TS_TX,
+    SUBG_TS_TX_DONE,
+    SUBG_TS_ACK,
+    SUBG_TS_STAGE_NUM
+} subg_ts_stage_t;
+
+typedef enum {
+    SUBG_TS_LAT_TOTAL = 0, /**< ENQUEUE to the tx done callback */
+    SUBG_TS_LAT_QUEUE,     /**< ENQUEUE to CSMA, only when CSMA is marked */
+    SUBG_TS_LAT_CSMA,      /**< CSMA to TX, or to the callback on CCA failure */
+    SUBG_TS_LAT_AIR,       /**< TX to TX_DONE */
+    SUBG_TS_LAT_ACK,       /**< TX_DONE to ACK */
+    SUBG_TS_LAT_NUM
+} subg_ts_lat_t;
+
+typedef enum {
+    SUBG_TS_TX_SENT = 0, /**< no ACK requested */
+    SUBG_TS_TX_ACKED,
+    SUBG_TS_TX_NO_ACK,   /**< ACK wait expired on the last retry */
+    SUBG_TS_TX_CCA_FAIL, /**< channel access failure, nothing sent */
+    SUBG_TS_TX_FAIL,
+} subg_ts_outcome_t;
+
+/** Airtime inputs of a data rate, in octets on air around the MAC frame */
+typedef struct {
+    uint32_t bit_rate;      /**< bit/s */
+    uint8_t shr_octets;     /**< preamble and SFD */
+    uint8_t phr_octets;
+    uint8_t fcs_octets;     /**< appended by the radio */
+    uint8_t ack_octets;     /**< MAC frame of an immediate ACK */
+    uint16_t turnaround_us; /**< TX_DONE to the ACK SHR */
+    uint16_t ack_wait_us;   /**< macAckWaitDuration */
+    uint16_t rx_delay_us;   /**< last bit on air to the rx callback */
+} subg_ts_phy_t;
+
+typedef struct {
+    uint32_t bin[SUBG_TS_BINS];
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+} subg_ts_hist_t;
+
+typedef struct {
+    bool used;
+    uint8_t rate; /**< caller's data rate id */
+    subg_ts_phy_t phy;
+    uint32_t frames;
+    uint32_t estimated; /**< frames with a stage estimated */
+    uint32_t failed;    /**< no ACK, CCA or TX failure */
+    subg_ts_hist_t lat[SUBG_TS_LAT_NUM];
+} subg_ts_rate_t;
+
+/** Time of arrival of a received frame */
+typedef struct {
+    uint32_t sfd;  /**< end of the SFD, the 802.15.4 reference point */
+    uint32_t done; /**< rx callback */
+    uint8_t rate;
+} subg_ts_rx_t;
+
+typedef struct {
+    uint32_t hz;
+    subg_ts_rate_t rates[SUBG_TS_RATES];
+    subg_ts_rate_t* current;
+    uint32_t stamp[SUBG_TS_STAGE_NUM];
+    uint8_t marked; /**< bit per stage of the frame in flight */
+    uint16_t len;   /**< MAC frame in flight, without FCS */
+    uint32_t unmatched; /**< completions without an enqueue */
+    bool sent;          /**< the frame completed last went on air */
+    uint32_t sfd;       /**< end of its SFD */
+} subg_ts_t;
+
+/**
+ * @param hz counter rate, 1 MHz or more
+ */
+void subg_ts_init(subg_ts_t* ts, uint32_t hz);
+
+/**
+ * @brief Clear the counters and histograms, the data rates stay
+ */
+void subg_ts_reset(subg_ts_t* ts);
+
+/**
+ * @brief Select the data rate the following frames are sent and received on
+ * @return 0, -1 when SUBG_TS_RATES other rates are tracked already
+ */
+int subg_ts_rate_set(subg_ts_t* ts, uint8_t rate, const subg_ts_phy_t* phy);
+
+void subg_ts_tx_enqueue(subg_ts_t* ts, uint32_t now, uint16_t len);
+
+/**
+ * @brief Stage hook for a MAC that reports CSMA, TX, TX_DONE or ACK
+ */
+void subg_ts_tx_mark(subg_ts_t* ts, subg_ts_stage_t stage, uint32_t now);
+
+/**
+ * @brief Close the frame in flight and add its latencies to the histograms
+ *        of the current data rate
+ */
+void subg_ts_tx_complete(subg_ts_t* ts, uint32_t now,
+                         subg_ts_outcome_t outcome);
+
+/**
+ * @brief End of the SFD of the frame completed last, estimated unless its
+ *        TX stage was marked
+ * @return 0, -1 when it did not go on air
+ */
+int subg_ts_tx_sfd(const subg_ts_t* ts, uint32_t* sfd);
+
+/**
+ * @brief Time of arrival of a frame whose rx callback ran at now
+ * @param len MAC frame length, without FCS
+ */
+void subg_ts_rx(const subg_ts_t* ts, uint32_t now, uint16_t len,
+                subg_ts_rx_t* rx);
+
+/**
+ * @return airtime of a MAC frame on the current data rate, in us
+ */
+uint32_t subg_ts_airtime_us(const subg_ts_t* ts, uint16_t len);
+
+uint32_t subg_ts_ticks_to_us(const subg_ts_t* ts, uint32_t ticks);
+uint32_t subg_ts_us_to_ticks(const subg_ts_t* ts, uint32_t us);
+
+const subg_ts_rate_t* subg_ts_rate_get(const subg_ts_t* ts, uint8_t index);
+
+/**
+ * @return upper bound of the bin holding the pct percentile, at most the
+ *         maximum seen, 0 when empty
+ */
+uint32_t subg_ts_hist_percentile(const subg_ts_hist_t* hist, uint8_t pct);
+
+#endif // __SUBG_TS_H
@@ -0,0 +1,259 @@
+/**
+ * @file app_sync.c
+ * @brief Beacon time synchronisation and slot scheduled TX of the sample,
+ *        on top of subg_sync and the SFD timestamps of app_ts.
+ *
+ * The RX mode board is the coordinator and beacons in slot 0, TX mode
+ * boards defer every frame to their own slot once synchronised and send at
+ * once until then. A slot is entered with a one-shot timer, so slot_us
+ * must leave a tick of timer jitter on top of guard_us.
+ */
+
+#include <FreeRTOS.h>
+#include <stdlib.h>
+#include <string.h>
+#include <task.h>
+#include <timers.h>
+#include "cli.h"
+#include "lmac15p4.h"
+#include "main.h"
+#include "subg_sync.h"
+
+#ifndef APP_SYNC_BEACON_FRAMES
+#define APP_SYNC_BEACON_FRAMES 4
+#endif
+
+#ifndef APP_SYNC_LOST_BEACONS
+#define APP_SYNC_LOST_BEACONS 3
+#endif
+
+#ifndef APP_SYNC_GUARD_US
+#define APP_SYNC_GUARD_US 2000
+#endif
+
+/* Beacon: data frame, no ACK, short source address only */
+#define APP_SYNC_HDR_LEN  7
+#define APP_SYNC_FCF_LO   0x01
+#define APP_SYNC_FCF_HI   0x80
+#define APP_SYNC_PAN_ID   0x1AAA
+#define APP_SYNC_CHECK_MS 1000
+
+static subg_sync_t s_sync;
+static TimerHandle_t s_slot_timer;
+static TimerHandle_t s_check_timer;
+static void (*s_slot_cb)(void);
+
+static bool s_tx_pending;
+static bool s_beacon_pending;
+static uint8_t s_dsn;
+static uint32_t s_deferred;
+static uint32_t s_direct;
+
+static uint16_t sync_addr(void) {
+#if (CONFIG_APP_SUBG_SYNC_ADDR != 0)
+    return CONFIG_APP_SUBG_SYNC_ADDR;
+#else
+    uint8_t uid[8];
+    uint16_t addr = 0;
+    uint8_t i;
+
+    /* boards of the sample share one MAC address, fold the unique id */
+    flash_get_unique_id((uint32_t)uid, sizeof(uid));
+    for (i = 0; i < sizeof(uid); i += 2) {
+        addr ^= uid[i] | (uid[i + 1] << 8);
+    }
+    return addr;
+#endif
+}
+
+static uint64_t sync_now(void) { return app_ts_local_us(app_ts_now()); }
+
+/* arm the slot timer for a local time, at least one tick ahead */
+static void slot_arm(uint64_t at) {
+    uint64_t now = sync_now();
+    uint32_t ms = at > now ? (uint32_t)((at - now + 999) / 1000) : 0;
+    TickType_t ticks = pdMS_TO_TICKS(ms);
+
+    xTimerChangePeriod(s_slot_timer, ticks ? ticks : 1, 0);
+}
+
+static void beacon_arm(void) {
+    uint64_t now = sync_now();
+    uint64_t at;
+    int ret;
+
+    taskENTER_CRITICAL();
+    ret = subg_sync_next_beacon(&s_sync, now, &at);
+    taskEXIT_CRITICAL();
+    if (ret == 0) {
+        slot_arm(at);
+    }
+}
+
+static void beacon_send(void) {
+    static uint8_t frame[APP_SYNC_HDR_LEN + SUBG_SYNC_BEACON_LEN];
+    uint16_t addr = s_sync.addr;
+
+    frame[0] = APP_SYNC_FCF_LO;
+    frame[1] = APP_SYNC_FCF_HI;
+    frame[2] = s_dsn++;
+    frame[3] = APP_SYNC_PAN_ID & 0xff;
+    frame[4] = APP_SYNC_PAN_ID >> 8;
+    frame[5] = addr & 0xff;
+    frame[6] = addr >> 8;
+    taskENTER_CRITICAL();
+    subg_sync_beacon_build(&s_sync, &frame[APP_SYNC_HDR_LEN]);
+    taskEXIT_CRITICAL();
+
+    s_beacon_pending = true;
+    app_ts_tx_enqueue(sizeof(frame));
+    if (lmac15p4_tx_data_send(0, frame, sizeof(frame), 0, frame[2]) != 0) {
+        s_beacon_pending = false;
+        taskENTER_CRITICAL();
+        subg_sync_beacon_sent(&s_sync, false, 0);
+        taskEXIT_CRITICAL();
+    }
+}
+
+static void slot_timeout(TimerHandle_t timer) {
+    if (s_slot_cb) {
+        s_slot_cb();
+    }
+}
+
+static void check_timeout(TimerHandle_t timer) {
+    uint64_t now = sync_now();
+
+    taskENTER_CRITICAL();
+    subg_sync_check(&s_sync, now);
+    taskEXIT_CRITICAL();
+}
+
+void app_sync_init(bool coord, void (*slot_cb)(void)) {
+    subg_sync_cfg_t cfg = {
+        .slot_us = CONFIG_APP_SUBG_SYNC_SLOT_MS * 1000UL,
+        .slots = CONFIG_APP_SUBG_SYNC_SLOTS,
+        .beacon_frames = APP_SYNC_BEACON_FRAMES,
+        .lost_beacons = APP_SYNC_LOST_BEACONS,
+        .guard_us = APP_SYNC_GUARD_US,
+    };
+
+    subg_sync_init(&s_sync, &cfg, sync_addr(), coord, sync_now());
+    s_slot_cb = slot_cb;
+    s_slot_timer = xTimerCreate("sync_slot", 1, pdFALSE, (void*)0,
+                                slot_timeout);
+    s_check_timer = xTimerCreate("sync_check", pdMS_TO_TICKS(APP_SYNC_CHECK_MS),
+                                 pdTRUE, (void*)0, check_timeout);
+    xTimerStart(s_check_timer, 0);
+
+    printf("sync: %s, addr 0x%04X, slot %u\r\n",
+           coord ? "coordinator" : "node", s_sync.addr, s_sync.slot);
+    beacon_arm();
+}
+
+int app_sync_tx_request(void) {
+    uint64_t now = sync_now();
+    uint64_t at;
+    int ret;
+
+    if (s_sync.coord) {
+        return -1;
+    }
+
+    taskENTER_CRITICAL();
+    ret = subg_sync_next_slot(&s_sync, now, &at);
+    taskEXIT_CRITICAL();
+    if (ret) {
+        s_direct++;
+        return -1;
+    }
+
+    s_tx_pending = true;
+    s_deferred++;
+    slot_arm(at);
+    return 0;
+}
+
+bool app_sync_slot_process(void) {
+    if (s_sync.coord) {
+        beacon_send();
+        beacon_arm();
+        return true;
+    }
+
+    /* nothing deferred */
+    if (!s_tx_pending) {
+        return true;
+    }
+    s_tx_pending = false;
+    return false;
+}
+
+bool app_sync_tx_done(uint32_t tx_status) {
+    uint64_t at;
+    uint32_t sfd;
+    bool ok;
+
+    if (!s_beacon_pending) {
+        return false;
+    }
+    s_beacon_pending = false;
+
+    ok = tx_status == 0x00 && app_ts_tx_sfd(&sfd) == 0;
+    at = ok ? app_ts_local_us(sfd) : 0;
+    taskENTER_CRITICAL();
+    subg_sync_beacon_sent(&s_sync, ok, at);
+    taskEXIT_CRITICAL();
+    return true;
+}
+
+bool app_sync_rx(const uint8_t* frame, uint16_t len, uint32_t sfd) {
+    const uint8_t* payload = frame + APP_SYNC_HDR_LEN;
+    UBaseType_t mask;
+    uint64_t at;
+
+    if (len < APP_SYNC_HDR_LEN + SUBG_SYNC_BEACON_LEN
+        || (frame[0] & 0x07) != 0x01 || frame[1] != APP_SYNC_FCF_HI
+        || payload[0] != SUBG_SYNC_MAGIC) {
+        return false;
+    }
+
+    at = app_ts_local_us(sfd);
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    subg_sync_beacon_rx(&s_sync, payload, len - APP_SYNC_HDR_LEN, at);
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+    return true;
+}
+
+static int _cli_cmd_sync(int argc, char** argv, cb_shell_out_t log_out,
+                         void* pExtra) {
+    static subg_sync_t sync;
+    uint32_t deferred;
+    uint32_t direct;
+
+    taskENTER_CRITICAL();
+    sync = s_sync;
+    deferred = s_deferred;
+    direct = s_direct;
+    taskEXIT_CRITICAL();
+
+    log_out("%s, addr 0x%04X, slot %u of %u, %lu us\r\n",
+            sync.coord ? "coordinator" : "node", sync.addr, sync.slot,
+            sync.cfg.slots, (unsigned long)sync.cfg.slot_us);
+    log_out("beacon every %u slotframes, lost after %u, guard %u us\r\n",
+            sync.cfg.beacon_frames, sync.cfg.lost_beacons, sync.cfg.guard_us);
+    log_out("synced: %u, drift: %ld ppb, error: %ld us, max: %lu us\r\n",
+            sync.synced, (long)sync.drift_ppb, (long)sync.error_us,
+            (unsigned long)sync.error_max_us);
+    log_out("beacons: %lu, lost: %lu, tx in slot: %lu, tx direct: %lu\r\n",
+            (unsigned long)sync.beacons, (unsigned long)sync.lost,
+            (unsigned long)deferred, (unsigned long)direct);
+    log_out("+Ok \r\n");
+    return 0;
+}
+
+const sh_cmd_t g_cli_cmd_sync STATIC_CLI_CMD_ATTRIBUTE = {
+    .pCmd_name = "sync",
+    .pDescription = "Sub-GHz time sync and TX slot",
+    .cmd_exec = _cli_cmd_sync,
+};
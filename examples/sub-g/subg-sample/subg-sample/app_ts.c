@@ -0,0 +1,285 @@
+/**
+ * @file app_ts.c
+ * @brief Stamps the frames of the sample with the DWT cycle counter, feeds
+ *        subg_ts and shows the latency histograms on the CLI.
+ *
+ * lmac15p4 reports a frame only through its tx done callback, so CSMA, TX
+ * and ACK are estimated here unless a MAC build calls app_ts_tx_mark().
+ * The cycle counter stops in sleep, this sample never sleeps.
+ */
+
+#include <FreeRTOS.h>
+#include <stdlib.h>
+#include <string.h>
+#include <task.h>
+#include "cli.h"
+#include "main.h"
+#include "subg_ctrl.h"
+#include "subg_ts.h"
+
+#define DEMCR         (*(volatile uint32_t*)0xE000EDFCUL)
+#define DEMCR_TRCENA  (1UL << 24)
+#define DWT_CTRL      (*(volatile uint32_t*)0xE0001000UL)
+#define DWT_CYCCNTENA (1UL << 0)
+
+/* Frame timestamp, the DWT cycle counter by default */
+#ifndef APP_TS_TIMESTAMP
+#define APP_TS_TIMESTAMP() (*(volatile uint32_t*)0xE0001004UL)
+#endif
+
+#ifndef APP_TS_TIMESTAMP_HZ
+#define APP_TS_TIMESTAMP_HZ configCPU_CLOCK_HZ
+#endif
+
+/* Octets on air around the MAC frame, see subg_cfg_set() */
+#define APP_TS_FSK_SHR     10 /* 8 preamble, 2 SFD */
+#define APP_TS_FSK_PHR     2
+#define APP_TS_OQPSK_SHR   5
+#define APP_TS_OQPSK_PHR   1
+#define APP_TS_FCS         2
+#define APP_TS_ACK         3
+#define APP_TS_TURNAROUND  1000
+#define APP_TS_ACK_WAIT    16000
+
+/* Last bit on air to the rx done callback, 0 stamps the SFD that much late */
+#ifndef CONFIG_APP_SUBG_TS_RX_DELAY_US
+#define CONFIG_APP_SUBG_TS_RX_DELAY_US 0
+#endif
+
+static subg_ts_t s_ts;
+static uint32_t s_tx_done;
+static subg_ts_rx_t s_rx_last;
+
+/* counter wraps seen by app_ts_local_us() */
+static uint32_t s_wrap_last;
+static uint64_t s_wrap_high;
+
+static const char* const s_lat_str[SUBG_TS_LAT_NUM] = {"total", "queue",
+                                                       "csma", "air", "ack"};
+
+static uint32_t rate_bps(uint8_t data_rate) {
+    switch (data_rate) {
+        case SUBG_CTRL_DATA_RATE_6P25K: return 6250;
+        case SUBG_CTRL_DATA_RATE_50K: return 50000;
+        case SUBG_CTRL_DATA_RATE_100K: return 100000;
+        case SUBG_CTRL_DATA_RATE_200K: return 200000;
+        case SUBG_CTRL_DATA_RATE_300K: return 300000;
+        default: return 0;
+    }
+}
+
+uint32_t app_ts_now(void) { return APP_TS_TIMESTAMP(); }
+
+uint32_t app_ts_ticks_to_us(uint32_t ticks) {
+    return subg_ts_ticks_to_us(&s_ts, ticks);
+}
+
+uint64_t app_ts_local_us(uint32_t ticks) {
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    uint32_t now = APP_TS_TIMESTAMP();
+    uint64_t cycles;
+
+    if (now < s_wrap_last) {
+        s_wrap_high += 1ULL << 32;
+    }
+    s_wrap_last = now;
+    cycles = (s_wrap_high | now) - (uint32_t)(now - ticks);
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+
+    /* whole MHz clocks */
+    return cycles / (APP_TS_TIMESTAMP_HZ / 1000000);
+}
+
+void app_ts_rate_set(uint8_t mode, uint8_t data_rate) {
+    subg_ts_phy_t phy = {
+        .bit_rate = rate_bps(data_rate),
+        .fcs_octets = APP_TS_FCS,
+        .ack_octets = APP_TS_ACK,
+        .turnaround_us = APP_TS_TURNAROUND,
+        .ack_wait_us = APP_TS_ACK_WAIT,
+        .rx_delay_us = CONFIG_APP_SUBG_TS_RX_DELAY_US,
+    };
+    int ret;
+
+    if (mode == SUBG_CTRL_MODU_FSK) {
+        phy.shr_octets = APP_TS_FSK_SHR;
+        phy.phr_octets = APP_TS_FSK_PHR;
+    } else {
+        phy.shr_octets = APP_TS_OQPSK_SHR;
+        phy.phr_octets = APP_TS_OQPSK_PHR;
+    }
+
+    taskENTER_CRITICAL();
+    ret = subg_ts_rate_set(&s_ts, data_rate, &phy);
+    taskEXIT_CRITICAL();
+
+    if (ret) {
+        printf("[W] ts: %u data rates tracked already\r\n", SUBG_TS_RATES);
+    }
+}
+
+void app_ts_tx_enqueue(uint16_t len) {
+    uint32_t now = APP_TS_TIMESTAMP();
+
+    taskENTER_CRITICAL();
+    subg_ts_tx_enqueue(&s_ts, now, len);
+    taskEXIT_CRITICAL();
+}
+
+void app_ts_tx_mark(uint8_t stage) {
+    uint32_t now = APP_TS_TIMESTAMP();
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+
+    subg_ts_tx_mark(&s_ts, stage, now);
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void app_ts_tx_done_isr(void) { s_tx_done = APP_TS_TIMESTAMP(); }
+
+void app_ts_tx_complete(uint32_t tx_status) {
+    subg_ts_outcome_t outcome;
+
+    switch (tx_status) {
+        case 0x00: outcome = SUBG_TS_TX_SENT; break;
+        case 0x40:
+        case 0x80: outcome = SUBG_TS_TX_ACKED; break;
+        case 0x10: outcome = SUBG_TS_TX_CCA_FAIL; break;
+        case 0x20: outcome = SUBG_TS_TX_NO_ACK; break;
+        default: outcome = SUBG_TS_TX_FAIL; break;
+    }
+
+    taskENTER_CRITICAL();
+    subg_ts_tx_complete(&s_ts, s_tx_done, outcome);
+    taskEXIT_CRITICAL();
+}
+
+int app_ts_tx_sfd(uint32_t* sfd) {
+    int ret;
+
+    taskENTER_CRITICAL();
+    ret = subg_ts_tx_sfd(&s_ts, sfd);
+    taskEXIT_CRITICAL();
+    return ret;
+}
+
+void app_ts_rx(uint32_t now, uint16_t len, subg_ts_rx_t* rx) {
+    subg_ts_rx(&s_ts, now, len, rx);
+    s_rx_last = *rx;
+}
+
+const subg_ts_rx_t* app_ts_rx_last(void) { return &s_rx_last; }
+
+void app_ts_init(void) {
+    if ((DWT_CTRL & DWT_CYCCNTENA) == 0) {
+        DEMCR |= DEMCR_TRCENA;
+        DWT_CTRL |= DWT_CYCCNTENA;
+    }
+    subg_ts_init(&s_ts, APP_TS_TIMESTAMP_HZ);
+}
+
+static void print_rate(cb_shell_out_t log_out, uint8_t index,
+                       const subg_ts_rate_t* rate, bool current) {
+    const subg_ts_hist_t* hist;
+    uint8_t i;
+
+    log_out("[%u] rate %u%s: %lu bit/s, %lu frames, %lu failed, %lu "
+            "estimated\r\n",
+            index, rate->rate, current ? " *" : "",
+            (unsigned long)rate->phy.bit_rate, (unsigned long)rate->frames,
+            (unsigned long)rate->failed, (unsigned long)rate->estimated);
+    log_out("  %-6s %7s %8s %8s %8s %8s %8s (us)\r\n", "", "count", "avg",
+            "p50", "p90", "p99", "max");
+    for (i = 0; i < SUBG_TS_LAT_NUM; i++) {
+        hist = &rate->lat[i];
+        if (hist->count == 0) {
+            continue;
+        }
+        log_out("  %-6s %7lu %8lu %8lu %8lu %8lu %8lu\r\n", s_lat_str[i],
+                (unsigned long)hist->count,
+                (unsigned long)(hist->sum_us / hist->count),
+                (unsigned long)subg_ts_hist_percentile(hist, 50),
+                (unsigned long)subg_ts_hist_percentile(hist, 90),
+                (unsigned long)subg_ts_hist_percentile(hist, 99),
+                (unsigned long)hist->max_us);
+    }
+}
+
+static void print_hist(cb_shell_out_t log_out, const subg_ts_hist_t* hist) {
+    uint8_t i;
+
+    for (i = 0; i < SUBG_TS_BINS; i++) {
+        if (hist->bin[i] == 0) {
+            continue;
+        }
+        if (i == SUBG_TS_BINS - 1) {
+            log_out("  >= %7lu us: %lu\r\n", 1UL << i,
+                    (unsigned long)hist->bin[i]);
+        } else {
+            log_out("  %7lu us: %lu\r\n", i ? 1UL << i : 0UL,
+                    (unsigned long)hist->bin[i]);
+        }
+    }
+}
+
+static int _cli_cmd_ts(int argc, char** argv, cb_shell_out_t log_out,
+                       void* pExtra) {
+    static subg_ts_rate_t rate;
+    const subg_ts_rate_t* found;
+    uint32_t unmatched;
+    bool current;
+    uint8_t index;
+    uint8_t lat;
+
+    if (argc < 2 || !strncmp(argv[1], "show", 4)) {
+        for (index = 0; index < SUBG_TS_RATES; index++) {
+            taskENTER_CRITICAL();
+            found = subg_ts_rate_get(&s_ts, index);
+            if (found) {
+                rate = *found;
+            }
+            current = found && found == s_ts.current;
+            unmatched = s_ts.unmatched;
+            taskEXIT_CRITICAL();
+            if (found) {
+                print_rate(log_out, index, &rate, current);
+            }
+        }
+        log_out("unmatched tx done: %lu\r\n", (unsigned long)unmatched);
+    } else if (argc > 3 && !strncmp(argv[1], "hist", 4)) {
+        index = strtoul(argv[2], NULL, 10);
+        for (lat = 0; lat < SUBG_TS_LAT_NUM; lat++) {
+            if (!strcmp(argv[3], s_lat_str[lat])) {
+                break;
+            }
+        }
+        taskENTER_CRITICAL();
+        found = subg_ts_rate_get(&s_ts, index);
+        if (found) {
+            rate = *found;
+        }
+        taskEXIT_CRITICAL();
+        if (!found || lat == SUBG_TS_LAT_NUM) {
+            log_out("Unknown rate or latency \r\n");
+            return -1;
+        }
+        print_hist(log_out, &rate.lat[lat]);
+    } else if (!strncmp(argv[1], "reset", 5)) {
+        taskENTER_CRITICAL();
+        subg_ts_reset(&s_ts);
+        taskEXIT_CRITICAL();
+    } else {
+        log_out("ts show \r\n");
+        log_out("ts hist <rate index> <total/queue/csma/air/ack> \r\n");
+        log_out("ts reset \r\n");
+        return 0;
+    }
+
+    log_out("+Ok \r\n");
+    return 0;
+}
+
+const sh_cmd_t g_cli_cmd_ts STATIC_CLI_CMD_ATTRIBUTE = {
+    .pCmd_name = "ts",
+    .pDescription = "Sub-GHz TX latency : see ts help",
+    .cmd_exec = _cli_cmd_ts,
+};
@@ -86,7 +86,8 @@ typedef enum {
     APP_TX_DONE_EVT,
     APP_RX_DONE_EVT,
     APP_TX_TIMER_EVT,
-    APP_RX_TIMER_EVT
+    APP_RX_TIMER_EVT,
+    APP_SYNC_SLOT_EVT
 } app_evt_t;
 
 typedef struct {
@@ -237,6 +238,10 @@ void subg_cfg_set(subg_ctrl_modulation_t mode, uint8_t data_rate) {
                           SUBG_CTRL_WHITEN_DISABLE);
     }
 
+#if (CONFIG_APP_SUBG_TS == 1)
+    app_ts_rate_set(mode, data_rate);
+#endif
+
     gpio_frequency_chek();
 }
 
@@ -501,6 +506,17 @@ static void app_button_process(uint32_t pin) {
 
 static void app_tx_done_process(uint32_t tx_status) {
 
+#if (CONFIG_APP_SUBG_TS == 1)
+    app_ts_tx_complete(tx_status);
+#endif
+
+#if (CONFIG_APP_SUBG_SYNC == 1)
+    /* beacons are not counted as test frames */
+    if (app_sync_tx_done(tx_status)) {
+        return;
+    }
+#endif
+
 #if (SUBG_MAC)
     /* tx_status =
     0x00: TX success
@@ -545,7 +561,7 @@ static void app_tx_done_process(uint32_t tx_status) {
 #endif
 }
 
-static void app_tx_process() {
+static void app_tx_send() {
 #if (SUBG_MAC)
     uint8_t tx_control = 0;
     uint8_t Dsn = 0;
@@ -557,6 +573,9 @@ static void app_tx_process() {
 #if (SUBG_MAC)
     /* Generate IEEE802.15.4 MAC Header and append data */
     subg_data_gen(&MacBuf, &tx_control, &Dsn);
+#if (CONFIG_APP_SUBG_TS == 1)
+    app_ts_tx_enqueue(MacBuf.len);
+#endif
     int ret = lmac15p4_tx_data_send(0, MacBuf.dptr, MacBuf.len, tx_control,
                                     Dsn);
     g_tx_len = MacBuf.len;
@@ -567,10 +586,31 @@ static void app_tx_process() {
         g_tx_len = PHY_MIN_LENGTH;
     }
     /* Send data */
+#if (CONFIG_APP_SUBG_TS == 1)
+    app_ts_tx_enqueue(g_tx_len);
+#endif
     lmac15p4_tx_data_send(0, &g_prbs9_buf[0], g_tx_len, 0, 0);
 #endif
 }
 
+static void app_tx_process() {
+#if (CONFIG_APP_SUBG_SYNC == 1)
+    /* sent from APP_SYNC_SLOT_EVT once synchronised */
+    if (app_sync_tx_request() == 0) {
+        return;
+    }
+#endif
+    app_tx_send();
+}
+
+#if (CONFIG_APP_SUBG_SYNC == 1)
+static void app_slot_process() {
+    if (!app_sync_slot_process()) {
+        app_tx_send();
+    }
+}
+#endif
+
 static void app_rx_process() {
     /* Check whether RX data is comming during certain interval */
     if ((RF_Rx_Switch == true) && (g_rx_total_count_last == g_rx_total_count)) {
@@ -591,6 +631,9 @@ static void app_main_task(void) {
                 case APP_RX_DONE_EVT: break;
                 case APP_TX_TIMER_EVT: app_tx_process(); break;
                 case APP_RX_TIMER_EVT: app_rx_process(); break;
+#if (CONFIG_APP_SUBG_SYNC == 1)
+                case APP_SYNC_SLOT_EVT: app_slot_process(); break;
+#endif
                 default: break;
             }
         }
@@ -634,10 +677,25 @@ static void rx_timer_timeout() {
     xQueueSendToBackFromISR(app_msg_q, &t_app_q, &context_switch);
 }
 
+#if (CONFIG_APP_SUBG_SYNC == 1)
+static void sync_slot_timeout(void) {
+    app_queue_t t_app_q;
+    BaseType_t context_switch;
+
+    t_app_q.event = APP_SYNC_SLOT_EVT;
+    t_app_q.data = 0;
+    xQueueSendToBackFromISR(app_msg_q, &t_app_q, &context_switch);
+}
+#endif
+
 static void subg_mac_tx_done(uint32_t tx_status) {
     app_queue_t t_app_q;
     BaseType_t context_switch;
 
+#if (CONFIG_APP_SUBG_TS == 1)
+    app_ts_tx_done_isr();
+#endif
+
     t_app_q.event = APP_TX_DONE_EVT;
     t_app_q.data = tx_status;
 
@@ -646,6 +704,11 @@ static void subg_mac_tx_done(uint32_t tx_status) {
 
 static void subg_mac_rx_done(uint16_t packet_length, uint8_t* rx_data_address,
                              uint8_t crc_status, uint8_t rssi, uint8_t snr) {
+#if (CONFIG_APP_SUBG_TS == 1)
+    uint32_t now = app_ts_now();
+    uint32_t sfd_last = app_ts_rx_last()->sfd;
+    subg_ts_rx_t rx_ts;
+#endif
     led_on(GPIO_LED_0);
 
 #if (!SUBG_MAC)
@@ -658,6 +721,23 @@ static void subg_mac_rx_done(uint16_t packet_length, uint8_t* rx_data_address,
     uint8_t phr_length = ((modem_type == SUBG_CTRL_MODU_FSK)
                               ? FSK_PHR_LENGTH
                               : OQPSK_PHR_LENGTH);
+#if (CONFIG_APP_SUBG_TS == 1)
+    /* once per frame, the SFD of the previous one is replaced */
+    if (crc_status == 0) {
+        rx_data_len = packet_length
+                      - (RUCI_PHY_STATUS_LENGTH + phr_length
+                         + RX_APPEND_LENGTH);
+        app_ts_rx(now, rx_data_len, &rx_ts);
+    }
+#endif
+#if (CONFIG_APP_SUBG_SYNC == 1)
+    /* beacons are not counted as test frames */
+    if (crc_status == 0
+        && app_sync_rx(rx_data_address + RX_CONTROL_FIELD_LENGTH + phr_length,
+                       rx_data_len, rx_ts.sfd)) {
+        return;
+    }
+#endif
     g_rx_total_count++;
     if (crc_status == 0) {
         /* Calculate PHY payload length*/
@@ -678,6 +758,16 @@ static void subg_mac_rx_done(uint16_t packet_length, uint8_t* rx_data_address,
         g_crc_fail_count++;
     }
 
+#if (CONFIG_APP_SUBG_TS == 1)
+    if (crc_status == 0) {
+        /* SFD to SFD, the first frame counts from boot */
+        printf("RX (len:%d) done, Success:%d Fail:%d SFD +%lu us \r\r\n",
+               rx_data_len, g_crc_success_count, g_crc_fail_count,
+               (unsigned long)app_ts_ticks_to_us(rx_ts.sfd - sfd_last));
+        return;
+    }
+#endif
+
     printf("RX (len:%d) done, Success:%d Fail:%d \r\r\n", rx_data_len,
            g_crc_success_count, g_crc_fail_count);
 }
@@ -687,6 +777,15 @@ void subg_config_init() {
     NVIC_SetPriority(Uart0_IRQn, 0x01);
     NVIC_SetPriority(CommSubsystem_IRQn, 0x00);
 
+#if (CONFIG_APP_SUBG_TS == 1)
+    app_ts_init();
+    app_ts_rate_set(SUBG_CTRL_MODU_FSK, SUBG_CTRL_DATA_RATE_300K);
+#endif
+#if (CONFIG_APP_SUBG_SYNC == 1)
+    app_sync_init(transfer_mode_get() == SUBG_TRANSFER_RX_MODE,
+                  sync_slot_timeout);
+#endif
+
     /*rf init */
     hosal_rf_init(HOSAL_RF_MODE_RUCI_CMD);
     /*Choose the frequency band you want */
@@ -0,0 +1,212 @@
+/**
+ * @file subg_sync.c
+ * @brief Beacon clock synchronisation and slot schedule, see subg_sync.h
+ */
+
+#include <string.h>
+#include "subg_sync.h"
+
+/* beacon flags */
+#define BEACON_PREV_VALID 0x01
+
+static void put_le16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static void put_le32(uint8_t* p, uint32_t v) {
+    put_le16(p, v & 0xffff);
+    put_le16(p + 2, v >> 16);
+}
+
+static void put_le64(uint8_t* p, uint64_t v) {
+    put_le32(p, (uint32_t)v);
+    put_le32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint16_t get_le16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+
+static uint32_t get_le32(const uint8_t* p) {
+    return get_le16(p) | ((uint32_t)get_le16(p + 2) << 16);
+}
+
+static uint64_t get_le64(const uint8_t* p) {
+    return get_le32(p) | ((uint64_t)get_le32(p + 4) << 32);
+}
+
+static uint64_t frame_us(const subg_sync_cfg_t* cfg) {
+    return (uint64_t)cfg->slot_us * cfg->slots;
+}
+
+static void sync_restart(subg_sync_t* sync) {
+    sync->synced = sync->coord;
+    sync->samples = 0;
+    sync->drift_ppb = 0;
+    sync->seq_valid = false;
+    sync->error_us = 0;
+    sync->error_max_us = 0;
+}
+
+uint16_t subg_sync_slot_of(const subg_sync_cfg_t* cfg, uint16_t addr) {
+    /* consecutive addresses take consecutive slots */
+    return cfg->slots > 1 ? 1 + addr % (cfg->slots - 1) : 0;
+}
+
+void subg_sync_init(subg_sync_t* sync, const subg_sync_cfg_t* cfg,
+                    uint16_t addr, bool coord, uint64_t now) {
+    memset(sync, 0, sizeof(*sync));
+    sync->cfg = *cfg;
+    sync->addr = addr;
+    sync->slot = subg_sync_slot_of(cfg, addr);
+    sync->coord = coord;
+    sync->ref_local = now;
+    sync->ref_net = now;
+    sync->last_beacon = now;
+    sync_restart(sync);
+}
+
+uint64_t subg_sync_to_net(const subg_sync_t* sync, uint64_t local) {
+    int64_t dt = (int64_t)(local - sync->ref_local);
+
+    return sync->ref_net + dt + dt * sync->drift_ppb / 1000000000;
+}
+
+uint64_t subg_sync_to_local(const subg_sync_t* sync, uint64_t net) {
+    int64_t dt = (int64_t)(net - sync->ref_net);
+
+    return sync->ref_local + dt - dt * sync->drift_ppb / 1000000000;
+}
+
+/* network time of the next slot boundary of slot, plus guard, at or after
+ * net; every frames slotframes only */
+static uint64_t slot_next(const subg_sync_cfg_t* cfg, uint64_t net,
+                          uint16_t slot, uint8_t frames) {
+    uint64_t frame = frame_us(cfg);
+    uint64_t period = frame * (frames ? frames : 1);
+    uint64_t start = net - net % period + (uint64_t)slot * cfg->slot_us
+                     + cfg->guard_us;
+
+    return start < net ? start + period : start;
+}
+
+int subg_sync_next_slot(const subg_sync_t* sync, uint64_t now, uint64_t* at) {
+    if (!sync->synced || sync->slot == 0) {
+        return -1;
+    }
+
+    *at = subg_sync_to_local(
+        sync, slot_next(&sync->cfg, subg_sync_to_net(sync, now), sync->slot, 1));
+    return 0;
+}
+
+int subg_sync_next_beacon(const subg_sync_t* sync, uint64_t now,
+                          uint64_t* at) {
+    if (!sync->coord) {
+        return -1;
+    }
+
+    /* the coordinator clock is the network time */
+    *at = slot_next(&sync->cfg, now, 0, sync->cfg.beacon_frames);
+    return 0;
+}
+
+uint8_t subg_sync_beacon_build(const subg_sync_t* sync, uint8_t* buf) {
+    buf[0] = SUBG_SYNC_MAGIC;
+    buf[1] = sync->seq;
+    buf[2] = (uint8_t)(sync->seq - 1);
+    buf[3] = sync->seq_valid ? BEACON_PREV_VALID : 0;
+    put_le64(&buf[4], sync->seq_sfd);
+    put_le32(&buf[12], sync->cfg.slot_us);
+    put_le16(&buf[16], sync->cfg.slots);
+    buf[18] = sync->cfg.beacon_frames;
+    return SUBG_SYNC_BEACON_LEN;
+}
+
+void subg_sync_beacon_sent(subg_sync_t* sync, bool ok, uint64_t sfd) {
+    /* a beacon lost on the way only costs the pair of the next one */
+    sync->seq_valid = ok;
+    sync->seq_sfd = sfd;
+    sync->seq++;
+    if (ok) {
+        sync->last_beacon = sfd;
+        sync->beacons++;
+    }
+}
+
+static void sync_sample(subg_sync_t* sync, uint64_t local, uint64_t net) {
+    int64_t dt = (int64_t)(local - sync->ref_local);
+    int64_t error = (int64_t)(net - subg_sync_to_net(sync, local));
+    int32_t ppb;
+
+    if (sync->samples && dt > 0) {
+        ppb = (int32_t)(((int64_t)(net - sync->ref_net) - dt) * 1000000000
+                        / dt);
+        if (sync->samples == 1) {
+            sync->drift_ppb = ppb;
+        } else {
+            sync->drift_ppb += (ppb - sync->drift_ppb) >> SUBG_SYNC_DRIFT_SHIFT;
+        }
+    }
+
+    /* the first pair has no drift estimate to be judged against */
+    if (sync->samples >= 2) {
+        sync->error_us = (int32_t)error;
+        if ((uint32_t)(error < 0 ? -error : error) > sync->error_max_us) {
+            sync->error_max_us = (uint32_t)(error < 0 ? -error : error);
+        }
+    }
+
+    sync->ref_local = local;
+    sync->ref_net = net;
+    sync->synced = true;
+    if (sync->samples < 0xff) {
+        sync->samples++;
+    }
+}
+
+int subg_sync_beacon_rx(subg_sync_t* sync, const uint8_t* buf, uint16_t len,
+                        uint64_t sfd) {
+    subg_sync_cfg_t cfg = sync->cfg;
+
+    if (sync->coord || len < SUBG_SYNC_BEACON_LEN || buf[0] != SUBG_SYNC_MAGIC) {
+        return -1;
+    }
+
+    cfg.slot_us = get_le32(&buf[12]);
+    cfg.slots = get_le16(&buf[16]);
+    cfg.beacon_frames = buf[18];
+    if (cfg.slot_us == 0 || cfg.slots == 0) {
+        return -1;
+    }
+    if (cfg.slot_us != sync->cfg.slot_us || cfg.slots != sync->cfg.slots
+        || cfg.beacon_frames != sync->cfg.beacon_frames) {
+        sync->cfg = cfg;
+        sync->slot = subg_sync_slot_of(&cfg, sync->addr);
+        sync_restart(sync);
+    }
+
+    if ((buf[3] & BEACON_PREV_VALID) && sync->seq_valid
+        && sync->seq == buf[2]) {
+        sync_sample(sync, sync->seq_sfd, get_le64(&buf[4]));
+    }
+
+    sync->seq = buf[1];
+    sync->seq_valid = true;
+    sync->seq_sfd = sfd;
+    sync->last_beacon = sfd;
+    sync->beacons++;
+    return 0;
+}
+
+bool subg_sync_check(subg_sync_t* sync, uint64_t now) {
+    uint64_t timeout = frame_us(&sync->cfg)
+                       * (sync->cfg.beacon_frames ? sync->cfg.beacon_frames : 1)
+                       * sync->cfg.lost_beacons;
+
+    if (!sync->coord && sync->synced
+        && (int64_t)(now - sync->last_beacon) > (int64_t)timeout) {
+        sync_restart(sync);
+        sync->lost++;
+    }
+    return sync->synced;
+}
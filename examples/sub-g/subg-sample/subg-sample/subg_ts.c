@@ -0,0 +1,298 @@
+/**
+ * @file subg_ts.c
+ * @brief Sub-GHz MAC timestamps and latency histograms, see subg_ts.h
+ */
+
+#include <string.h>
+#include "subg_ts.h"
+
+#define STAGE_BIT(s) (1U << (s))
+
+/* wrap safe, a is at or after b */
+static bool stamp_after(uint32_t a, uint32_t b) { return (int32_t)(a - b) >= 0; }
+
+static uint8_t hist_bin(uint32_t us) {
+    uint8_t bin = 0;
+
+    while (us > 1 && bin < SUBG_TS_BINS - 1) {
+        us >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+static void hist_add(subg_ts_hist_t* hist, uint32_t us) {
+    if (hist->count == 0 || us < hist->min_us) {
+        hist->min_us = us;
+    }
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+    hist->bin[hist_bin(us)]++;
+    hist->sum_us += us;
+    hist->count++;
+}
+
+static void rate_clear(subg_ts_rate_t* rate) {
+    rate->frames = 0;
+    rate->estimated = 0;
+    rate->failed = 0;
+    memset(rate->lat, 0, sizeof(rate->lat));
+}
+
+void subg_ts_init(subg_ts_t* ts, uint32_t hz) {
+    memset(ts, 0, sizeof(*ts));
+    ts->hz = hz;
+}
+
+void subg_ts_reset(subg_ts_t* ts) {
+    uint8_t i;
+
+    for (i = 0; i < SUBG_TS_RATES; i++) {
+        rate_clear(&ts->rates[i]);
+    }
+    ts->marked = 0;
+    ts->unmatched = 0;
+}
+
+int subg_ts_rate_set(subg_ts_t* ts, uint8_t rate, const subg_ts_phy_t* phy) {
+    subg_ts_rate_t* slot = NULL;
+    uint8_t i;
+
+    for (i = 0; i < SUBG_TS_RATES; i++) {
+        if (ts->rates[i].used && ts->rates[i].rate == rate) {
+            slot = &ts->rates[i];
+            break;
+        }
+        if (!slot && !ts->rates[i].used) {
+            slot = &ts->rates[i];
+        }
+    }
+
+    /* frames on an untracked rate are not counted against another one */
+    ts->current = slot;
+    ts->marked = 0;
+    if (!slot) {
+        return -1;
+    }
+
+    if (!slot->used) {
+        rate_clear(slot);
+        slot->used = true;
+        slot->rate = rate;
+    }
+    slot->phy = *phy;
+    return 0;
+}
+
+uint32_t subg_ts_ticks_to_us(const subg_ts_t* ts, uint32_t ticks) {
+    return (uint32_t)((uint64_t)ticks * 1000000 / ts->hz);
+}
+
+uint32_t subg_ts_us_to_ticks(const subg_ts_t* ts, uint32_t us) {
+    return (uint32_t)((uint64_t)us * ts->hz / 1000000);
+}
+
+static uint32_t octets_us(const subg_ts_phy_t* phy, uint32_t octets) {
+    if (phy->bit_rate == 0) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)octets * 8 * 1000000 / phy->bit_rate);
+}
+
+uint32_t subg_ts_airtime_us(const subg_ts_t* ts, uint16_t len) {
+    const subg_ts_phy_t* phy;
+
+    if (!ts->current) {
+        return 0;
+    }
+    phy = &ts->current->phy;
+    return octets_us(phy, phy->shr_octets + phy->phr_octets + len
+                              + phy->fcs_octets);
+}
+
+void subg_ts_tx_enqueue(subg_ts_t* ts, uint32_t now, uint16_t len) {
+    ts->stamp[SUBG_TS_ENQUEUE] = now;
+    ts->marked = STAGE_BIT(SUBG_TS_ENQUEUE);
+    ts->len = len;
+}
+
+void subg_ts_tx_mark(subg_ts_t* ts, subg_ts_stage_t stage, uint32_t now) {
+    /* CSMA is marked per attempt, the last one is kept */
+    if (stage > SUBG_TS_ENQUEUE && stage < SUBG_TS_STAGE_NUM
+        && (ts->marked & STAGE_BIT(SUBG_TS_ENQUEUE))) {
+        ts->stamp[stage] = now;
+        ts->marked |= STAGE_BIT(stage);
+    }
+}
+
+/* estimate an unmarked stage, never before the stage ahead of it */
+static void stage_estimate(subg_ts_t* ts, subg_ts_stage_t stage,
+                           uint32_t value) {
+    uint32_t prev = ts->stamp[stage - 1];
+
+    ts->stamp[stage] = stamp_after(value, prev) ? value : prev;
+}
+
+static void lat_add(subg_ts_t* ts, subg_ts_lat_t lat, uint32_t from,
+                    uint32_t to) {
+    hist_add(&ts->current->lat[lat], subg_ts_ticks_to_us(ts, to - from));
+}
+
+void subg_ts_tx_complete(subg_ts_t* ts, uint32_t now,
+                         subg_ts_outcome_t outcome) {
+    subg_ts_rate_t* rate = ts->current;
+    const subg_ts_phy_t* phy;
+    uint32_t* stamp = ts->stamp;
+    uint8_t marked = ts->marked;
+    uint8_t need;
+    uint32_t done;
+
+    ts->marked = 0;
+    ts->sent = false;
+    if (!(marked & STAGE_BIT(SUBG_TS_ENQUEUE))) {
+        ts->unmatched++;
+        return;
+    }
+    if (!rate) {
+        return;
+    }
+    phy = &rate->phy;
+
+    rate->frames++;
+    if (outcome != SUBG_TS_TX_SENT && outcome != SUBG_TS_TX_ACKED) {
+        rate->failed++;
+    }
+
+    lat_add(ts, SUBG_TS_LAT_TOTAL, stamp[SUBG_TS_ENQUEUE], now);
+    if (marked & STAGE_BIT(SUBG_TS_CSMA)) {
+        lat_add(ts, SUBG_TS_LAT_QUEUE, stamp[SUBG_TS_ENQUEUE],
+                stamp[SUBG_TS_CSMA]);
+    } else {
+        stamp[SUBG_TS_CSMA] = stamp[SUBG_TS_ENQUEUE];
+    }
+
+    if (outcome == SUBG_TS_TX_CCA_FAIL) {
+        lat_add(ts, SUBG_TS_LAT_CSMA, stamp[SUBG_TS_CSMA], now);
+    }
+    if (outcome != SUBG_TS_TX_SENT && outcome != SUBG_TS_TX_ACKED
+        && outcome != SUBG_TS_TX_NO_ACK) {
+        if (!(marked & STAGE_BIT(SUBG_TS_CSMA))) {
+            rate->estimated++;
+        }
+        return;
+    }
+
+    need = STAGE_BIT(SUBG_TS_CSMA) | STAGE_BIT(SUBG_TS_TX)
+           | STAGE_BIT(SUBG_TS_TX_DONE);
+    if (outcome == SUBG_TS_TX_ACKED) {
+        need |= STAGE_BIT(SUBG_TS_ACK);
+    }
+    if ((marked & need) != need) {
+        rate->estimated++;
+    }
+
+    /* walk back from the completion: ACK, then the frame end, then SHR */
+    if (!(marked & STAGE_BIT(SUBG_TS_ACK))) {
+        stamp[SUBG_TS_ACK] = now;
+    }
+    if (!(marked & STAGE_BIT(SUBG_TS_TX_DONE))) {
+        if (outcome == SUBG_TS_TX_ACKED) {
+            done = stamp[SUBG_TS_ACK]
+                   - subg_ts_us_to_ticks(
+                       ts, phy->turnaround_us
+                               + octets_us(phy, phy->shr_octets
+                                                    + phy->phr_octets
+                                                    + phy->ack_octets
+                                                    + phy->fcs_octets));
+        } else if (outcome == SUBG_TS_TX_NO_ACK) {
+            done = now - subg_ts_us_to_ticks(ts, phy->ack_wait_us);
+        } else {
+            done = now;
+        }
+        stamp[SUBG_TS_TX_DONE] = done;
+    }
+    if (!(marked & STAGE_BIT(SUBG_TS_TX))) {
+        stage_estimate(ts, SUBG_TS_TX,
+                       stamp[SUBG_TS_TX_DONE]
+                           - subg_ts_us_to_ticks(
+                               ts, subg_ts_airtime_us(ts, ts->len)));
+    }
+    if (!(marked & STAGE_BIT(SUBG_TS_TX_DONE))) {
+        stage_estimate(ts, SUBG_TS_TX_DONE, stamp[SUBG_TS_TX_DONE]);
+    }
+
+    ts->sent = true;
+    ts->sfd = stamp[SUBG_TS_TX]
+              + subg_ts_us_to_ticks(ts, octets_us(phy, phy->shr_octets));
+
+    lat_add(ts, SUBG_TS_LAT_CSMA, stamp[SUBG_TS_CSMA], stamp[SUBG_TS_TX]);
+    lat_add(ts, SUBG_TS_LAT_AIR, stamp[SUBG_TS_TX], stamp[SUBG_TS_TX_DONE]);
+    if (outcome == SUBG_TS_TX_ACKED) {
+        if (!(marked & STAGE_BIT(SUBG_TS_ACK))) {
+            stage_estimate(ts, SUBG_TS_ACK, stamp[SUBG_TS_ACK]);
+        }
+        lat_add(ts, SUBG_TS_LAT_ACK, stamp[SUBG_TS_TX_DONE],
+                stamp[SUBG_TS_ACK]);
+    }
+}
+
+int subg_ts_tx_sfd(const subg_ts_t* ts, uint32_t* sfd) {
+    if (!ts->sent) {
+        return -1;
+    }
+    *sfd = ts->sfd;
+    return 0;
+}
+
+void subg_ts_rx(const subg_ts_t* ts, uint32_t now, uint16_t len,
+                subg_ts_rx_t* rx) {
+    const subg_ts_phy_t* phy;
+    uint32_t end;
+
+    rx->done = now;
+    rx->sfd = now;
+    rx->rate = 0xff;
+    if (!ts->current) {
+        return;
+    }
+
+    phy = &ts->current->phy;
+    end = now - subg_ts_us_to_ticks(ts, phy->rx_delay_us);
+    rx->sfd = end
+              - subg_ts_us_to_ticks(
+                  ts, octets_us(phy, phy->phr_octets + len + phy->fcs_octets));
+    rx->rate = ts->current->rate;
+}
+
+const subg_ts_rate_t* subg_ts_rate_get(const subg_ts_t* ts, uint8_t index) {
+    if (index >= SUBG_TS_RATES || !ts->rates[index].used) {
+        return NULL;
+    }
+    return &ts->rates[index];
+}
+
+uint32_t subg_ts_hist_percentile(const subg_ts_hist_t* hist, uint8_t pct) {
+    uint32_t target;
+    uint32_t seen = 0;
+    uint32_t bound;
+    uint8_t i;
+
+    if (hist->count == 0) {
+        return 0;
+    }
+
+    target = (uint32_t)(((uint64_t)hist->count * pct + 99) / 100);
+    if (target == 0) {
+        target = 1;
+    }
+
+    for (i = 0; i < SUBG_TS_BINS - 1; i++) {
+        seen += hist->bin[i];
+        if (seen >= target) {
+            bound = (2UL << i) - 1;
+            return bound < hist->max_us ? bound : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
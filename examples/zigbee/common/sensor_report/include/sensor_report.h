@@ -0,0 +1,111 @@
+/**
+ * @file sensor_report.h
+ * @brief Sensor sampling and reporting engine.
+ *
+ * The engine samples a set of attributes at a fixed cadence and only hands
+ * a value to the stack when it moved by more than the reportable change
+ * (delta), or when the maximum report interval expires. Reversing direction
+ * needs delta plus hysteresis, so a reading that jitters around a threshold
+ * does not produce a report on every sample. The minimum report interval
+ * holds back a change until it is allowed to go out, and when one attribute
+ * reports, the other changed attributes are flushed with it so a single
+ * wakeup carries all of them.
+ *
+ * The reporting intervals and delta configured by a remote Configure
+ * Reporting command override the application defaults through the cfg
+ * callback. The engine itself has no stack or RTOS dependency; the caller
+ * passes the current time and reschedules with the returned delay.
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+
+#ifndef __SENSOR_REPORT_H
+#define __SENSOR_REPORT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Maximum number of attributes handled by one engine, one bit per attribute in a batch mask */
+#define SENSOR_REPORT_ATTR_MAX 32
+
+/* An attribute whose max interval expires within this window is refreshed with a batch */
+#ifndef SENSOR_REPORT_BATCH_WINDOW_MS
+#define SENSOR_REPORT_BATCH_WINDOW_MS 30000
+#endif
+
+typedef struct {
+    uint32_t min_interval_ms; /* hold back changes until this long after the last report */
+    uint32_t max_interval_ms; /* refresh at least this often, 0 to disable */
+    uint32_t delta;           /* reportable change, in attribute units */
+} sensor_report_cfg_t;
+
+typedef struct {
+    uint8_t ep;
+    uint8_t zcl_type;
+    uint16_t cluster;
+    uint16_t attr_id;
+    sensor_report_cfg_t cfg; /* application default, used until reporting is configured */
+    uint32_t hysteresis;     /* extra change needed when the direction reverses */
+
+    /* runtime state, owned by the engine */
+    int32_t sample;
+    int32_t reported;
+    int8_t direction;
+    bool valid;
+    bool reported_once;
+    uint32_t last_report_ms;
+} sensor_report_attr_t;
+
+typedef struct sensor_report_s sensor_report_t;
+
+/* Read attribute idx into value, return false when no reading is available */
+typedef bool (*sensor_report_sample_cb_t)(uint8_t idx, int32_t* value);
+/* Write the samples of all attributes set in mask in one go */
+typedef void (*sensor_report_write_cb_t)(sensor_report_t* ctx, uint32_t mask);
+/* Fill cfg with the remote reporting configuration, return false to keep the default */
+typedef bool (*sensor_report_cfg_cb_t)(const sensor_report_attr_t* attr,
+                                       sensor_report_cfg_t* cfg);
+
+typedef struct {
+    uint32_t samples;
+    uint32_t reports;    /* attribute writes handed to the stack */
+    uint32_t batches;    /* write calls, one per wakeup that reported */
+    uint32_t suppressed; /* samples below the reportable change */
+    uint32_t held;       /* changes delayed by the min interval */
+} sensor_report_stats_t;
+
+struct sensor_report_s {
+    sensor_report_attr_t* attrs;
+    uint8_t attr_num;
+    uint32_t sample_period_ms;
+    sensor_report_sample_cb_t sample;
+    sensor_report_write_cb_t write;
+    sensor_report_cfg_cb_t cfg;
+
+    /* runtime state, owned by the engine */
+    uint32_t next_sample_ms;
+    bool force;
+    sensor_report_stats_t stats;
+};
+
+/**
+ * @brief Reset runtime state, the first run samples and reports everything
+ */
+void sensor_report_init(sensor_report_t* ctx, uint32_t now_ms);
+
+/**
+ * @brief Sample when due, write what has to be reported
+ * @return delay in ms until the engine has to run again
+ */
+uint32_t sensor_report_run(sensor_report_t* ctx, uint32_t now_ms);
+
+/**
+ * @brief Sample on the next run and report every attribute that changed,
+ *        regardless of delta, e.g. after joining or on a button press
+ */
+void sensor_report_trigger(sensor_report_t* ctx);
+
+#endif // __SENSOR_REPORT_H
@@ -0,0 +1,186 @@
+/**
+ * @file sensor_report.c
+ * @brief Sensor sampling and reporting engine, see sensor_report.h
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+//=============================================================================
+//                Include
+//=============================================================================
+#include <stddef.h>
+
+#include "sensor_report.h"
+
+//=============================================================================
+//                Private Function
+//=============================================================================
+static int32_t sensor_report_time_diff(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b);
+}
+
+static uint32_t sensor_report_abs(int32_t v) {
+    return (v < 0) ? (uint32_t)(-(int64_t)v) : (uint32_t)v;
+}
+
+static void sensor_report_attr_cfg(sensor_report_t* ctx,
+                                   const sensor_report_attr_t* attr,
+                                   sensor_report_cfg_t* cfg) {
+    *cfg = attr->cfg;
+    if (ctx->cfg) {
+        ctx->cfg(attr, cfg);
+    }
+}
+
+//=============================================================================
+//                Public Function
+//=============================================================================
+void sensor_report_init(sensor_report_t* ctx, uint32_t now_ms) {
+    uint8_t i;
+
+    if (ctx->attr_num > SENSOR_REPORT_ATTR_MAX) {
+        ctx->attr_num = SENSOR_REPORT_ATTR_MAX;
+    }
+    for (i = 0; i < ctx->attr_num; i++) {
+        ctx->attrs[i].sample = 0;
+        ctx->attrs[i].reported = 0;
+        ctx->attrs[i].direction = 0;
+        ctx->attrs[i].valid = false;
+        ctx->attrs[i].reported_once = false;
+        ctx->attrs[i].last_report_ms = now_ms;
+    }
+    ctx->next_sample_ms = now_ms;
+    ctx->force = false;
+    ctx->stats = (sensor_report_stats_t){0};
+}
+
+void sensor_report_trigger(sensor_report_t* ctx) { ctx->force = true; }
+
+uint32_t sensor_report_run(sensor_report_t* ctx, uint32_t now_ms) {
+    sensor_report_attr_t* attr;
+    sensor_report_cfg_t cfg;
+    uint32_t urgent = 0, held = 0, mask;
+    uint32_t since, need, next;
+    bool sampled = false;
+    int32_t diff, wait;
+    int8_t dir;
+    uint8_t i;
+
+    if (ctx->force
+        || sensor_report_time_diff(now_ms, ctx->next_sample_ms) >= 0) {
+        ctx->next_sample_ms = now_ms + ctx->sample_period_ms;
+        for (i = 0; i < ctx->attr_num; i++) {
+            if (ctx->sample(i, &ctx->attrs[i].sample)) {
+                ctx->attrs[i].valid = true;
+                ctx->stats.samples++;
+            }
+        }
+        sampled = true;
+    }
+
+    for (i = 0; i < ctx->attr_num; i++) {
+        attr = &ctx->attrs[i];
+        if (!attr->valid) {
+            continue;
+        }
+        if (!attr->reported_once) {
+            urgent |= (1UL << i);
+            continue;
+        }
+
+        sensor_report_attr_cfg(ctx, attr, &cfg);
+        since = now_ms - attr->last_report_ms;
+        diff = attr->sample - attr->reported;
+        dir = (diff > 0) ? 1 : ((diff < 0) ? -1 : 0);
+
+        need = cfg.delta;
+        if (dir != 0 && attr->direction != 0 && dir != attr->direction) {
+            need += attr->hysteresis;
+        }
+
+        if (dir != 0 && (ctx->force || sensor_report_abs(diff) >= need)) {
+            if (since >= cfg.min_interval_ms) {
+                urgent |= (1UL << i);
+            } else {
+                held |= (1UL << i);
+                if (sampled) {
+                    ctx->stats.held++;
+                }
+            }
+        } else if (dir != 0 && sampled) {
+            ctx->stats.suppressed++;
+        }
+
+        if (cfg.max_interval_ms != 0 && since >= cfg.max_interval_ms) {
+            urgent |= (1UL << i);
+        }
+    }
+
+    if (urgent) {
+        /* The radio is up anyway, take along everything that is allowed to go */
+        mask = urgent;
+        for (i = 0; i < ctx->attr_num; i++) {
+            attr = &ctx->attrs[i];
+            if (!attr->valid || (mask & (1UL << i))) {
+                continue;
+            }
+            sensor_report_attr_cfg(ctx, attr, &cfg);
+            since = now_ms - attr->last_report_ms;
+            if (since < cfg.min_interval_ms) {
+                continue;
+            }
+            if (attr->sample != attr->reported
+                || (cfg.max_interval_ms != 0
+                    && since + SENSOR_REPORT_BATCH_WINDOW_MS
+                           >= cfg.max_interval_ms)) {
+                mask |= (1UL << i);
+            }
+        }
+
+        ctx->write(ctx, mask);
+        ctx->stats.batches++;
+
+        for (i = 0; i < ctx->attr_num; i++) {
+            if (!(mask & (1UL << i))) {
+                continue;
+            }
+            attr = &ctx->attrs[i];
+            diff = attr->sample - attr->reported;
+            if (attr->reported_once && diff != 0) {
+                attr->direction = (diff > 0) ? 1 : -1;
+            }
+            attr->reported = attr->sample;
+            attr->reported_once = true;
+            attr->last_report_ms = now_ms;
+            ctx->stats.reports++;
+        }
+        held &= ~mask;
+    }
+    ctx->force = false;
+
+    /* Sleep until the next sample, held change or max interval refresh */
+    wait = sensor_report_time_diff(ctx->next_sample_ms, now_ms);
+    next = (wait > 0) ? (uint32_t)wait : 0;
+    for (i = 0; i < ctx->attr_num; i++) {
+        attr = &ctx->attrs[i];
+        if (!attr->valid || !attr->reported_once) {
+            continue;
+        }
+        sensor_report_attr_cfg(ctx, attr, &cfg);
+        since = now_ms - attr->last_report_ms;
+        if ((held & (1UL << i)) && cfg.min_interval_ms - since < next) {
+            next = cfg.min_interval_ms - since;
+        }
+        if (cfg.max_interval_ms != 0) {
+            wait = (since < cfg.max_interval_ms) ? cfg.max_interval_ms - since
+                                                 : 0;
+            if ((uint32_t)wait < next) {
+                next = (uint32_t)wait;
+            }
+        }
+    }
+
+    return next;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file pin_store.h
+ * @brief Door lock PIN credential store.
+ *
+ * Users are addressed by the ZCL user ID, 0 to PIN_STORE_USER_MAX - 1.
+ * A PIN is looked up through an open addressing index keyed by SipHash-2-4
+ * with a per-boot random key, so the probe sequence cannot be steered from
+ * outside, and candidates are compared in constant time over the full PIN
+ * buffer. Every user is persisted as its own flash dataset record next to a
+ * small occupancy bitmap, so adding or clearing one user only rewrites
+ * that user.
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+
+#ifndef __PIN_STORE_H
+#define __PIN_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef PIN_STORE_USER_MAX
+#define PIN_STORE_USER_MAX 500
+#endif
+
+/* Longest PIN accepted, in bytes */
+#define PIN_STORE_PIN_MAX 16
+
+/* Index slots, a power of two at least twice PIN_STORE_USER_MAX */
+#ifndef PIN_STORE_INDEX_SIZE
+#define PIN_STORE_INDEX_SIZE 1024
+#endif
+
+/* ZCL door lock user status */
+#define PIN_STORE_USER_AVAILABLE        0x00
+#define PIN_STORE_USER_ENABLED          0x01
+#define PIN_STORE_USER_DISABLED         0x03
+
+/* Set PIN Code Response status values */
+typedef enum {
+    PIN_STORE_OK = 0,
+    PIN_STORE_FAIL = 1,
+    PIN_STORE_FULL = 2,
+    PIN_STORE_DUPLICATE = 3,
+} pin_store_status_t;
+
+typedef struct {
+    uint8_t status;
+    uint8_t type;
+    uint8_t len;
+    uint8_t pin[PIN_STORE_PIN_MAX];
+} pin_store_user_t;
+
+/**
+ * @brief Load all users from flash and build the lookup index. A PIN saved
+ *        by the single-PIN firmware is moved to user 0.
+ */
+void pin_store_init(void);
+
+/**
+ * @brief Add or replace the PIN of a user and persist that user
+ * @return PIN_STORE_FULL when the flash dataset is full, PIN_STORE_FAIL on
+ *         any other write error; the user is left as it was on either
+ */
+pin_store_status_t pin_store_set(uint16_t user_id, uint8_t status, uint8_t type,
+                                 const uint8_t* pin, uint8_t len);
+
+/**
+ * @brief Read a user, false when the user ID is free or out of range
+ */
+bool pin_store_get(uint16_t user_id, pin_store_user_t* user);
+
+/**
+ * @brief Remove one user, kept when the flash write fails
+ */
+pin_store_status_t pin_store_clear(uint16_t user_id);
+
+/**
+ * @brief Remove all users, all kept when the flash write fails
+ */
+pin_store_status_t pin_store_clear_all(void);
+
+/**
+ * @brief Find the enabled user owning a PIN
+ * @return user ID, or -1 when no enabled user has this PIN
+ */
+int32_t pin_store_match(const uint8_t* pin, uint8_t len);
+
+/**
+ * @brief Number of users holding a PIN
+ */
+uint16_t pin_store_count(void);
+
+#endif // __PIN_STORE_H
@@ -57,8 +57,6 @@ void zigbee_app_nwk_start(uint32_t channel_mask, uint32_t max_child, uint32_t re
 void zigbee_start_identify(void);
 void zigbee_zcl_set_attrubute(uint8_t ep, uint16_t cluster, uint8_t role, uint16_t attr_id, uint8_t* val);
 void zigbee_app_toggle_lock_state(void);
-void pincode_init(void);
-void pincode_update(void);
 
 uint8_t get_lock_state(void);
 void set_lock_state(uint8_t lockstate);
@@ -80,8 +78,5 @@ void z_set_OTA_downloaded_file_offset(uint32_t ver);
 void set_lock_state(uint8_t lockstate);
 uint8_t get_lock_type(void);
 void set_lock_type(uint8_t lock_type);
-uint8_t *get_pincode(void);
-void set_pincode(uint8_t *pincode);
-void clear_pincode(void);
 
 #endif // __ZIGBEE_API_H
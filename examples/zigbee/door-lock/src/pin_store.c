@@ -0,0 +1,417 @@
+/**
+ * @file pin_store.c
+ * @brief Door lock PIN credential store, see pin_store.h
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+//=============================================================================
+//                Include
+//=============================================================================
+#include <stdio.h>
+#include <string.h>
+
+#include "EnhancedFlashDataset.h"
+#include "hosal_trng.h"
+#include "log.h"
+#include "pin_store.h"
+
+//=============================================================================
+//                Private Definitions
+//=============================================================================
+#define PIN_STORE_SLOT_EMPTY     0xFFFF
+#define PIN_STORE_SLOT_DELETED   0xFFFE
+
+#define PIN_STORE_MAP_KEY        "pin_map"
+#define PIN_STORE_LEGACY_KEY     "pin"
+#define PIN_STORE_LEGACY_LEN     17
+
+#if (PIN_STORE_INDEX_SIZE & (PIN_STORE_INDEX_SIZE - 1)) || (PIN_STORE_INDEX_SIZE < 2 * PIN_STORE_USER_MAX)
+#error "PIN_STORE_INDEX_SIZE must be a power of two of at least twice PIN_STORE_USER_MAX"
+#endif
+
+//=============================================================================
+//                Private Global Variables
+//=============================================================================
+static pin_store_user_t pin_users[PIN_STORE_USER_MAX];
+static uint16_t pin_index[PIN_STORE_INDEX_SIZE];
+static uint8_t pin_map[(PIN_STORE_USER_MAX + 7) / 8];
+static uint32_t pin_key[4];
+static uint16_t pin_count;
+static uint16_t pin_tombstones;
+
+//=============================================================================
+//                Private Function
+//=============================================================================
+#define ROTL64(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+#define SIPROUND                                                               \
+    do {                                                                       \
+        v0 += v1; v1 = ROTL64(v1, 13); v1 ^= v0; v0 = ROTL64(v0, 32);          \
+        v2 += v3; v3 = ROTL64(v3, 16); v3 ^= v2;                               \
+        v0 += v3; v3 = ROTL64(v3, 21); v3 ^= v0;                               \
+        v2 += v1; v1 = ROTL64(v1, 17); v1 ^= v2; v2 = ROTL64(v2, 32);          \
+    } while (0)
+
+/* SipHash-2-4 */
+static uint64_t pin_hash(const uint8_t* in, uint8_t len) {
+    uint64_t k0 = ((uint64_t)pin_key[1] << 32) | pin_key[0];
+    uint64_t k1 = ((uint64_t)pin_key[3] << 32) | pin_key[2];
+    uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+    uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+    uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+    uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+    uint64_t m, b = (uint64_t)len << 56;
+    uint8_t i, left = len & 7;
+    const uint8_t* end = in + len - left;
+
+    for (; in != end; in += 8) {
+        m = 0;
+        for (i = 0; i < 8; i++) {
+            m |= (uint64_t)in[i] << (8 * i);
+        }
+        v3 ^= m;
+        SIPROUND;
+        SIPROUND;
+        v0 ^= m;
+    }
+    for (i = 0; i < left; i++) {
+        b |= (uint64_t)in[i] << (8 * i);
+    }
+    v3 ^= b;
+    SIPROUND;
+    SIPROUND;
+    v0 ^= b;
+    v2 ^= 0xff;
+    SIPROUND;
+    SIPROUND;
+    SIPROUND;
+    SIPROUND;
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/* Compare over the whole buffer so the time does not depend on where the PINs differ */
+static bool pin_equal(const pin_store_user_t* user, const uint8_t* pin, uint8_t len) {
+    uint8_t diff = user->len ^ len;
+    uint8_t i;
+
+    for (i = 0; i < PIN_STORE_PIN_MAX; i++) {
+        diff |= user->pin[i] ^ ((i < len) ? pin[i] : 0);
+    }
+    return diff == 0;
+}
+
+static bool pin_used(uint16_t user_id) {
+    return (pin_map[user_id >> 3] >> (user_id & 7)) & 1;
+}
+
+static void pin_key_name(char* name, uint16_t user_id) {
+    sprintf(name, "pin_u%u", user_id);
+}
+
+static int32_t pin_index_find(const uint8_t* pin, uint8_t len, uint16_t* slot_out) {
+    uint32_t slot = (uint32_t)pin_hash(pin, len) & (PIN_STORE_INDEX_SIZE - 1);
+    uint32_t probe;
+    uint16_t user_id;
+
+    for (probe = 0; probe < PIN_STORE_INDEX_SIZE; probe++) {
+        user_id = pin_index[slot];
+        if (user_id == PIN_STORE_SLOT_EMPTY) {
+            break;
+        }
+        if (user_id != PIN_STORE_SLOT_DELETED && pin_equal(&pin_users[user_id], pin, len)) {
+            if (slot_out) {
+                *slot_out = slot;
+            }
+            return user_id;
+        }
+        slot = (slot + 1) & (PIN_STORE_INDEX_SIZE - 1);
+    }
+    return -1;
+}
+
+static void pin_index_insert(uint16_t user_id) {
+    const pin_store_user_t* user = &pin_users[user_id];
+    uint32_t slot = (uint32_t)pin_hash(user->pin, user->len) & (PIN_STORE_INDEX_SIZE - 1);
+
+    while (pin_index[slot] != PIN_STORE_SLOT_EMPTY && pin_index[slot] != PIN_STORE_SLOT_DELETED) {
+        slot = (slot + 1) & (PIN_STORE_INDEX_SIZE - 1);
+    }
+    if (pin_index[slot] == PIN_STORE_SLOT_DELETED) {
+        pin_tombstones--;
+    }
+    pin_index[slot] = user_id;
+}
+
+static void pin_index_remove(uint16_t user_id) {
+    const pin_store_user_t* user = &pin_users[user_id];
+    uint16_t slot;
+
+    if (pin_index_find(user->pin, user->len, &slot) == user_id) {
+        pin_index[slot] = PIN_STORE_SLOT_DELETED;
+        pin_tombstones++;
+    }
+}
+
+/* Rebuild from scratch once tombstones pile up, probes stop at empty slots only */
+static void pin_index_rebuild(void) {
+    uint16_t i;
+
+    memset(pin_index, 0xFF, sizeof(pin_index));
+    pin_tombstones = 0;
+    for (i = 0; i < PIN_STORE_USER_MAX; i++) {
+        if (pin_used(i)) {
+            pin_index_insert(i);
+        }
+    }
+}
+
+static void pin_index_tidy(void) {
+    if (pin_tombstones > PIN_STORE_INDEX_SIZE / 4) {
+        pin_index_rebuild();
+    }
+}
+
+static void pin_map_bit(uint16_t user_id, bool used) {
+    if (used) {
+        pin_map[user_id >> 3] |= (1 << (user_id & 7));
+    } else {
+        pin_map[user_id >> 3] &= ~(1 << (user_id & 7));
+    }
+}
+
+/* The map is the commit point: a user exists once its bit is in flash */
+static EfErrCode pin_map_set(uint16_t user_id, bool used) {
+    EfErrCode err;
+
+    pin_map_bit(user_id, used);
+    err = efd_set_env_blob(PIN_STORE_MAP_KEY, pin_map, sizeof(pin_map));
+    if (err != EF_NO_ERR) {
+        pin_map_bit(user_id, !used);
+        log_error("pin map write error %d", err);
+    }
+    return err;
+}
+
+static pin_store_status_t pin_store_status(EfErrCode err) {
+    return (err == EF_ENV_FULL) ? PIN_STORE_FULL : PIN_STORE_FAIL;
+}
+
+/* Put a user back as it was before a failed write */
+static void pin_user_restore(uint16_t user_id, const pin_store_user_t* prev, bool was_used) {
+    pin_index_remove(user_id);
+    if (was_used) {
+        pin_users[user_id] = *prev;
+        pin_index_insert(user_id);
+    } else {
+        memset(&pin_users[user_id], 0, sizeof(pin_store_user_t));
+        pin_count--;
+    }
+}
+
+//=============================================================================
+//                Public Function
+//=============================================================================
+void pin_store_init(void) {
+    uint8_t legacy[PIN_STORE_LEGACY_LEN];
+    char name[12];
+    size_t actual_len = 0;
+    bool dropped = false;
+    EfErrCode err;
+    uint16_t i;
+
+    hosal_trng_get_random_number(pin_key, 4);
+    memset(pin_users, 0, sizeof(pin_users));
+    memset(pin_map, 0, sizeof(pin_map));
+    pin_count = 0;
+
+    efd_get_env_blob(PIN_STORE_MAP_KEY, pin_map, sizeof(pin_map), &actual_len);
+    if (actual_len == 0) {
+        /* First boot, or the single PIN layout: carry the old PIN over to user 0 */
+        pin_index_rebuild();
+        efd_get_env_blob(PIN_STORE_LEGACY_KEY, legacy, sizeof(legacy), &actual_len);
+        if (actual_len == 0) {
+            log_info("pincode not found, use default pincode");
+            memcpy(legacy, "\x08" "12345678", 9);
+        }
+        err = efd_set_env_blob(PIN_STORE_MAP_KEY, pin_map, sizeof(pin_map));
+        if (err != EF_NO_ERR) {
+            log_error("pin map write error %d", err);
+        }
+        if (legacy[0] > 0 && legacy[0] <= PIN_STORE_PIN_MAX
+            && pin_store_set(0, PIN_STORE_USER_ENABLED, 0, &legacy[1], legacy[0]) == PIN_STORE_OK
+            && actual_len != 0) {
+            /* Only once user 0 holds it, the next boot imports it again otherwise */
+            err = efd_del_env(PIN_STORE_LEGACY_KEY);
+            if (err != EF_NO_ERR) {
+                log_error("pin legacy delete error %d", err);
+            }
+        }
+        return;
+    }
+
+    for (i = 0; i < PIN_STORE_USER_MAX; i++) {
+        if (!pin_used(i)) {
+            continue;
+        }
+        pin_key_name(name, i);
+        actual_len = 0;
+        efd_get_env_blob(name, &pin_users[i], sizeof(pin_store_user_t), &actual_len);
+        if (actual_len != sizeof(pin_store_user_t) || pin_users[i].len == 0
+            || pin_users[i].len > PIN_STORE_PIN_MAX) {
+            /* Drop the record too, once off the map nothing would delete it */
+            memset(&pin_users[i], 0, sizeof(pin_store_user_t));
+            pin_map_bit(i, false);
+            err = efd_del_env(name);
+            if (err != EF_NO_ERR && err != EF_ENV_NAME_ERR) {
+                log_error("pin user %d delete error %d", i, err);
+            }
+            dropped = true;
+            continue;
+        }
+        pin_count++;
+    }
+    if (dropped) {
+        /* Dropped in RAM either way, a failed write drops them again next boot */
+        err = efd_set_env_blob(PIN_STORE_MAP_KEY, pin_map, sizeof(pin_map));
+        if (err != EF_NO_ERR) {
+            log_error("pin map write error %d", err);
+        }
+    }
+    pin_index_rebuild();
+    log_info("pincode users %d", pin_count);
+}
+
+pin_store_status_t pin_store_set(uint16_t user_id, uint8_t status, uint8_t type,
+                                 const uint8_t* pin, uint8_t len) {
+    pin_store_user_t prev;
+    bool was_used;
+    int32_t owner;
+    EfErrCode err;
+    char name[12];
+
+    if (user_id >= PIN_STORE_USER_MAX || len == 0 || len > PIN_STORE_PIN_MAX
+        || status == PIN_STORE_USER_AVAILABLE) {
+        return PIN_STORE_FAIL;
+    }
+    owner = pin_index_find(pin, len, NULL);
+    if (owner >= 0 && owner != user_id) {
+        return PIN_STORE_DUPLICATE;
+    }
+
+    prev = pin_users[user_id];
+    was_used = pin_used(user_id);
+    if (was_used) {
+        pin_index_remove(user_id);
+    } else {
+        pin_count++;
+    }
+    memset(&pin_users[user_id], 0, sizeof(pin_store_user_t));
+    pin_users[user_id].status = status;
+    pin_users[user_id].type = type;
+    pin_users[user_id].len = len;
+    memcpy(pin_users[user_id].pin, pin, len);
+    pin_index_insert(user_id);
+
+    pin_key_name(name, user_id);
+    err = efd_set_env_blob(name, &pin_users[user_id], sizeof(pin_store_user_t));
+    if (err != EF_NO_ERR) {
+        log_error("pin user %d write error %d", user_id, err);
+        pin_user_restore(user_id, &prev, was_used);
+        return pin_store_status(err);
+    }
+    if (!was_used) {
+        err = pin_map_set(user_id, true);
+        if (err != EF_NO_ERR) {
+            /* Off the map the record is never read, drop it if we can */
+            efd_del_env(name);
+            pin_user_restore(user_id, &prev, was_used);
+            return pin_store_status(err);
+        }
+    }
+    /* A changed PIN leaves a tombstone behind */
+    pin_index_tidy();
+    return PIN_STORE_OK;
+}
+
+bool pin_store_get(uint16_t user_id, pin_store_user_t* user) {
+    if (user_id >= PIN_STORE_USER_MAX || !pin_used(user_id)) {
+        return false;
+    }
+    *user = pin_users[user_id];
+    return true;
+}
+
+pin_store_status_t pin_store_clear(uint16_t user_id) {
+    EfErrCode err;
+    char name[12];
+
+    if (user_id >= PIN_STORE_USER_MAX) {
+        return PIN_STORE_FAIL;
+    }
+    if (!pin_used(user_id)) {
+        return PIN_STORE_OK;
+    }
+    /* Off the map first, the user stays as it was when that fails */
+    err = pin_map_set(user_id, false);
+    if (err != EF_NO_ERR) {
+        return pin_store_status(err);
+    }
+    pin_index_remove(user_id);
+    memset(&pin_users[user_id], 0, sizeof(pin_store_user_t));
+    pin_count--;
+
+    /* A record left behind is never read and is replaced by the next set */
+    pin_key_name(name, user_id);
+    err = efd_del_env(name);
+    if (err != EF_NO_ERR) {
+        log_error("pin user %d delete error %d", user_id, err);
+    }
+
+    pin_index_tidy();
+    return PIN_STORE_OK;
+}
+
+pin_store_status_t pin_store_clear_all(void) {
+    uint8_t map[sizeof(pin_map)];
+    EfErrCode err;
+    char name[12];
+    uint16_t i;
+
+    memset(map, 0, sizeof(map));
+    err = efd_set_env_blob(PIN_STORE_MAP_KEY, map, sizeof(map));
+    if (err != EF_NO_ERR) {
+        log_error("pin map write error %d", err);
+        return pin_store_status(err);
+    }
+    for (i = 0; i < PIN_STORE_USER_MAX; i++) {
+        if (pin_used(i)) {
+            pin_key_name(name, i);
+            err = efd_del_env(name);
+            if (err != EF_NO_ERR) {
+                log_error("pin user %d delete error %d", i, err);
+            }
+        }
+    }
+    memset(pin_users, 0, sizeof(pin_users));
+    memset(pin_map, 0, sizeof(pin_map));
+    pin_index_rebuild();
+    pin_count = 0;
+    return PIN_STORE_OK;
+}
+
+int32_t pin_store_match(const uint8_t* pin, uint8_t len) {
+    int32_t user_id;
+
+    if (len == 0 || len > PIN_STORE_PIN_MAX) {
+        return -1;
+    }
+    user_id = pin_index_find(pin, len, NULL);
+    if (user_id < 0 || pin_users[user_id].status != PIN_STORE_USER_ENABLED) {
+        return -1;
+    }
+    return user_id;
+}
+
+uint16_t pin_store_count(void) { return pin_count; }
@@ -129,7 +129,6 @@ uint8_t g_attr_cie_ep = 0;
 uint8_t g_att_lock_state = ZB_ZCL_ATTR_DOOR_LOCK_LOCK_STATE_LOCKED;
 uint8_t g_att_lock_type = 0;
 zb_bool_t g_att_actuator_enabled = 0;
-uint8_t g_att_pin_code[17] = {8, '1', '2', '3', '4', '5', '6', '7', '8'};
 zb_zcl_reporting_info_t rep_ctx[8];
 //=============================================================================
 //                Attribute definitions
@@ -444,19 +443,3 @@ void set_lock_type(uint8_t lock_type)
 {
     g_att_lock_type = lock_type;
 }
-uint8_t *get_pincode(void)
-{
-
-    return g_att_pin_code;
-}
-
-void set_pincode(uint8_t *pincode)
-{
-    memset(g_att_pin_code, 0, g_att_pin_code[0] + 1);
-    memcpy(g_att_pin_code, pincode, pincode[0] + 1);
-}
-void clear_pincode(void)
-{
-    memset(g_att_pin_code, 0, g_att_pin_code[0] + 1);
-}
-
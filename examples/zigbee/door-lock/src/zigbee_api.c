@@ -24,6 +24,7 @@
 #include "log.h"
 #include "zigbee_api.h"
 #include "device_api.h"
+#include "pin_store.h"
 #include "zigbee_platform.h"
 #include "zigbee_zcl_msg_handler.h"
 #include "hosal_gpio.h"
@@ -46,19 +47,6 @@ static TaskHandle_t zb_app_taskHandle;
 //=============================================================================
 //                Function
 //=============================================================================
-void pincode_init(void)
-{
-    size_t actual_len;
-    efd_get_env_blob("pin", (void *) get_pincode(), 17, &actual_len);
-    if(actual_len == 0) {
-        log_info("pincode not found, use default pincode");
-        pincode_update();
-    }
-}
-void pincode_update(void)
-{
-    efd_set_env_blob("pin", (void *) get_pincode(), 17);
-}
 static void zb_app_ota_status_chk(void)
 {
     fota_information_t t_bootloader_ota_info = {0};
@@ -254,6 +242,6 @@ void zigbee_app_init(void) {
 
     // zb_app_handle = xQueueCreate(16, sizeof(_zb_app_data_t*));
     button_init();
-    pincode_init();
+    pin_store_init();
 
 }
\ No newline at end of file
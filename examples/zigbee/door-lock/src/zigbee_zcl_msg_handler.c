@@ -20,6 +20,7 @@
 #include <zigbee_platform.h>
 #include "zigbee_api.h"
 #include "device_api.h"
+#include "pin_store.h"
 #include "log.h"
 
 #define ZB_TRACE_FILE_ID 294
@@ -65,6 +66,7 @@ static void _zcl_indentify_process(uint16_t cmd, uint16_t datalen, uint8_t *pdat
 static void _zcl_doorlock_process(uint16_t cmd, uint16_t datalen, uint8_t *pdata, uint32_t srcAddr, uint32_t srcEndpint, uint32_t seqnum, uint32_t dstAddr, uint32_t disableDefaultRsp)
 {
     uint8_t code_len;
+    int32_t user_id;
     switch (cmd)
     {
     case ZB_ZCL_CMD_DOOR_LOCK_LOCK_DOOR:
@@ -83,12 +85,13 @@ static void _zcl_doorlock_process(uint16_t cmd, uint16_t datalen, uint8_t *pdata
         {
             log_info("Receive TOGGLE command");
         }
-        if (datalen > 0 && get_pincode()[0] > 0)
+        if (datalen > 0 && pin_store_count() > 0)
         {
             code_len = pdata[0];
-            if (code_len > 0 && code_len == get_pincode()[0] && !memcmp(pdata, get_pincode(), code_len))
+            user_id = (code_len > 0 && code_len < datalen) ? pin_store_match(&pdata[1], code_len) : -1;
+            if (user_id >= 0)
             {
-                log_info("PIN code match");
+                log_info("PIN code match, user %d", user_id);
                 set_lock_state((cmd == ZB_ZCL_CMD_DOOR_LOCK_LOCK_DOOR) ? ZB_ZCL_ATTR_DOOR_LOCK_LOCK_STATE_LOCKED :
                                (cmd == ZB_ZCL_CMD_DOOR_LOCK_UNLOCK_DOOR) ? ZB_ZCL_ATTR_DOOR_LOCK_LOCK_STATE_UNLOCKED :
                                get_lock_state() == ZB_ZCL_ATTR_DOOR_LOCK_LOCK_STATE_LOCKED ? ZB_ZCL_ATTR_DOOR_LOCK_LOCK_STATE_UNLOCKED : ZB_ZCL_ATTR_DOOR_LOCK_LOCK_STATE_LOCKED);
@@ -105,7 +108,7 @@ static void _zcl_doorlock_process(uint16_t cmd, uint16_t datalen, uint8_t *pdata
                 log_info("PIN code not match");
             }
         }
-        else if (get_pincode()[0] == 0)
+        else if (pin_store_count() == 0)
         {
             set_lock_state((cmd == ZB_ZCL_CMD_DOOR_LOCK_LOCK_DOOR) ? ZB_ZCL_ATTR_DOOR_LOCK_LOCK_STATE_LOCKED :
                            (cmd == ZB_ZCL_CMD_DOOR_LOCK_UNLOCK_DOOR) ? ZB_ZCL_ATTR_DOOR_LOCK_LOCK_STATE_UNLOCKED :
@@ -116,34 +119,33 @@ static void _zcl_doorlock_process(uint16_t cmd, uint16_t datalen, uint8_t *pdata
     break;
     case ZB_ZCL_CMD_DOOR_LOCK_SET_PIN_CODE:
     {
-        uint8_t status = 0;
-        if (datalen > 4)
+        /* User ID (2), user status (1), user type (1), PIN (octet string) */
+        uint8_t status = PIN_STORE_FAIL;
+        if (datalen > 4 && (pdata[4] + 5) == datalen)
         {
-            if ((pdata[4] + 5) != datalen)
-            {
-                log_info("pincode len error");
-                status = 1;// generic error
-            }
             log_info_hexdump("PIN", &pdata[5], pdata[4]);
-            set_pincode(pdata + 4);
-            pincode_update();
-            zcl_data_req_t *pt_data_req;
+            status = pin_store_set(pdata[0] | (pdata[1] << 8), pdata[2], pdata[3], &pdata[5], pdata[4]);
+        }
+        else
+        {
+            log_info("pincode len error");
+        }
+        zcl_data_req_t *pt_data_req;
 
-            ZIGBEE_ZCL_DATA_REQ(pt_data_req, srcAddr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT, srcEndpint, DOOR_LOCK_EP,
-                                ZB_ZCL_CLUSTER_ID_DOOR_LOCK,
-                                ZB_ZCL_CMD_DOOR_LOCK_SET_PIN_CODE_RESPONSE,
-                                TRUE, TRUE,
-                                ZCL_FRAME_SERVER_CLIENT_DIR, 0, 1)
+        ZIGBEE_ZCL_DATA_REQ(pt_data_req, srcAddr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT, srcEndpint, DOOR_LOCK_EP,
+                            ZB_ZCL_CLUSTER_ID_DOOR_LOCK,
+                            ZB_ZCL_CMD_DOOR_LOCK_SET_PIN_CODE_RESPONSE,
+                            TRUE, TRUE,
+                            ZCL_FRAME_SERVER_CLIENT_DIR, 0, 1)
 
 
-            if (pt_data_req)
-            {
-                pt_data_req->specific_seq_num = 1;
-                pt_data_req->seq_num = seqnum;
-                pt_data_req->cmdFormat[0] = status;
-                zigbee_app_zcl_send_command(pt_data_req);
-                vPortFree(pt_data_req);
-            }
+        if (pt_data_req)
+        {
+            pt_data_req->specific_seq_num = 1;
+            pt_data_req->seq_num = seqnum;
+            pt_data_req->cmdFormat[0] = status;
+            zigbee_app_zcl_send_command(pt_data_req);
+            vPortFree(pt_data_req);
         }
     }
     break;
@@ -155,11 +157,11 @@ static void _zcl_doorlock_process(uint16_t cmd, uint16_t datalen, uint8_t *pdata
         }
         log_info("Received GET PINCODE command");
         uint8_t len;
-        uint16_t uid = pdata[1] << 8 & pdata[0];
+        uint16_t uid = pdata[0] | (pdata[1] << 8);
         log_info("uid %d", uid);
-        uint8_t *buf;
+        pin_store_user_t user;
         zcl_data_req_t *pt_data_req;
-        if (uid != 0)
+        if (uid >= PIN_STORE_USER_MAX)
         {
             len = 2;
             ZIGBEE_ZCL_DATA_REQ(pt_data_req, srcAddr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT, srcEndpint, DOOR_LOCK_EP,
@@ -167,10 +169,10 @@ static void _zcl_doorlock_process(uint16_t cmd, uint16_t datalen, uint8_t *pdata
                                 ZB_ZCL_CMD_DEFAULT_RESP,
                                 FALSE, TRUE,
                                 ZCL_FRAME_SERVER_CLIENT_DIR, 0, len)
-            pt_data_req->specific_seq_num = 1;
-            pt_data_req->seq_num = seqnum;
             if (pt_data_req)
             {
+                pt_data_req->specific_seq_num = 1;
+                pt_data_req->seq_num = seqnum;
                 pt_data_req->cmdFormat[0] = ZB_ZCL_CMD_DOOR_LOCK_GET_PIN_CODE;
                 pt_data_req->cmdFormat[1] = ZB_ZCL_STATUS_FAIL;
 
@@ -180,8 +182,12 @@ static void _zcl_doorlock_process(uint16_t cmd, uint16_t datalen, uint8_t *pdata
         }
         else
         {
-            buf = get_pincode();
-            len = buf[0] + 5;
+            if (!pin_store_get(uid, &user))
+            {
+                memset(&user, 0, sizeof(user));
+                user.type = 0xFF;
+            }
+            len = user.len + 5;
             ZIGBEE_ZCL_DATA_REQ(pt_data_req, srcAddr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT, srcEndpint, DOOR_LOCK_EP,
                                 ZB_ZCL_CLUSTER_ID_DOOR_LOCK,
                                 ZB_ZCL_CMD_DOOR_LOCK_GET_PIN_CODE_RESPONSE,
@@ -194,11 +200,12 @@ static void _zcl_doorlock_process(uint16_t cmd, uint16_t datalen, uint8_t *pdata
                 pt_data_req->specific_seq_num = 1;
                 pt_data_req->seq_num = seqnum;
 
-                pt_data_req->cmdFormat[0] = 0;
-                pt_data_req->cmdFormat[1] = 0;
-                pt_data_req->cmdFormat[2] = 0;
-                pt_data_req->cmdFormat[3] = (buf[0] == 0) ? 0xFF : 0x00;
-                memcpy(&pt_data_req->cmdFormat[4], buf, buf[0] + 1);
+                pt_data_req->cmdFormat[0] = uid & 0xFF;
+                pt_data_req->cmdFormat[1] = uid >> 8;
+                pt_data_req->cmdFormat[2] = user.status;
+                pt_data_req->cmdFormat[3] = user.type;
+                pt_data_req->cmdFormat[4] = user.len;
+                memcpy(&pt_data_req->cmdFormat[5], user.pin, user.len);
                 zigbee_app_zcl_send_command(pt_data_req);
                 vPortFree(pt_data_req);
             }
@@ -210,13 +217,19 @@ static void _zcl_doorlock_process(uint16_t cmd, uint16_t datalen, uint8_t *pdata
     {
         uint8_t status = 0;
         char *c = (cmd == ZB_ZCL_CMD_DOOR_LOCK_CLEAR_PIN_CODE) ? "CLEAR PINCODE" : "CLEAR ALL PINCODE";
-        uint16_t uid = pdata[1] << 8 & pdata[0];
         log_info("Received %s command", c);
-        if (uid != 0)
+        if (cmd == ZB_ZCL_CMD_DOOR_LOCK_CLEAR_ALL_PIN_CODES)
+        {
+            status = pin_store_clear_all();
+        }
+        else if (datalen >= 2)
+        {
+            status = pin_store_clear(pdata[0] | (pdata[1] << 8));
+        }
+        else
         {
             status = 1;    //fail
         }
-        clear_pincode();
         zcl_data_req_t *pt_data_req;
 
         ZIGBEE_ZCL_DATA_REQ(pt_data_req, srcAddr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT, srcEndpint, DOOR_LOCK_EP,
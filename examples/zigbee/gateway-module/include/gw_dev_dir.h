@@ -0,0 +1,158 @@
+/**
+ * @file gw_dev_dir.h
+ * @brief Gateway device directory.
+ *
+ * One record per joined device, found in O(1) by IEEE or by short address
+ * through two open addressing indexes. A record carries the capability
+ * from the last device announce, the LQI/RSSI and time of the last frame,
+ * and the active endpoints and simple descriptors once they have been
+ * read, so later requests are answered without going over the air.
+ *
+ * A device announce inserts or re-keys a record: a known IEEE with a new
+ * short address keeps its cached endpoints, and a short address already
+ * held by another IEEE is taken away from the older record, which stays
+ * reachable by IEEE until it announces again. Leave removes the record.
+ * A device the stack address table knows but the directory does not, its
+ * announce missed, is brought in with gw_dev_dir_sync.
+ *
+ * The directory has no stack dependency and is only touched from the
+ * ZBOSS thread.
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+
+#ifndef __GW_DEV_DIR_H
+#define __GW_DEV_DIR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef GW_DEV_DIR_DEV_MAX
+#define GW_DEV_DIR_DEV_MAX 128
+#endif
+
+/* Index slots, a power of two of at least twice GW_DEV_DIR_DEV_MAX */
+#ifndef GW_DEV_DIR_INDEX_SIZE
+#define GW_DEV_DIR_INDEX_SIZE 256
+#endif
+
+/* Endpoints cached per device */
+#ifndef GW_DEV_DIR_EP_MAX
+#define GW_DEV_DIR_EP_MAX 8
+#endif
+
+/* Simple descriptors cached over all devices */
+#ifndef GW_DEV_DIR_DESC_MAX
+#define GW_DEV_DIR_DESC_MAX 128
+#endif
+
+/* Input plus output clusters of one cached simple descriptor */
+#ifndef GW_DEV_DIR_CLUSTER_MAX
+#define GW_DEV_DIR_CLUSTER_MAX 12
+#endif
+
+#define GW_DEV_DIR_SHORT_UNKNOWN 0xFFFF
+
+typedef struct {
+    uint8_t endpoint;
+    uint16_t profile_id;
+    uint16_t device_id;
+    uint8_t device_version;
+    uint8_t in_count;
+    uint8_t out_count;
+    uint16_t clusters[GW_DEV_DIR_CLUSTER_MAX]; /* input clusters, then output */
+} gw_dev_desc_t;
+
+typedef struct {
+    uint8_t ieee[8];
+    uint16_t short_addr;   /* GW_DEV_DIR_SHORT_UNKNOWN after a conflict */
+    uint8_t capability;    /* from the device announce */
+    uint8_t lqi;
+    int8_t rssi;
+    uint8_t ep_valid : 1;  /* ep_list holds the active endpoint response */
+    uint8_t ep_count;
+    uint8_t ep_list[GW_DEV_DIR_EP_MAX];
+    uint8_t desc[GW_DEV_DIR_EP_MAX]; /* descriptor per ep_list entry, 0xFF none */
+    uint32_t last_seen_ms;
+} gw_dev_t;
+
+typedef struct {
+    uint32_t announces;
+    uint32_t rejoins;      /* announce of a known IEEE */
+    uint32_t addr_changes; /* known IEEE with a new short address */
+    uint32_t conflicts;    /* short address taken over from another IEEE */
+    uint32_t leaves;
+    uint32_t full;         /* devices dropped, directory full */
+    uint32_t synced;       /* records added or re-keyed from the stack table */
+} gw_dev_dir_stats_t;
+
+void gw_dev_dir_init(void);
+
+/**
+ * @brief Insert or update a device from a device announce
+ * @return the record, NULL when the directory is full
+ */
+gw_dev_t* gw_dev_dir_announce(const uint8_t ieee[8], uint16_t short_addr,
+                              uint8_t capability, uint32_t now_ms);
+
+/**
+ * @brief Bring one device in line with its stack address table entry, for
+ *        a device whose announce the gateway missed. A record added
+ *        here has no capability yet, a known record keeps its own.
+ * @return the record, NULL when the directory is full
+ */
+gw_dev_t* gw_dev_dir_sync(const uint8_t ieee[8], uint16_t short_addr, uint32_t now_ms);
+
+/**
+ * @brief Remove a device that left the network
+ * @return false when the device was not known
+ */
+bool gw_dev_dir_remove(const uint8_t ieee[8]);
+
+/**
+ * @brief Forget a short address reported in conflict, the owner keeps its
+ *        record and gets the new address with its next announce
+ */
+void gw_dev_dir_addr_conflict(uint16_t short_addr);
+
+gw_dev_t* gw_dev_dir_find_ieee(const uint8_t ieee[8]);
+
+gw_dev_t* gw_dev_dir_find_short(uint16_t short_addr);
+
+/**
+ * @brief Note a frame received from a device
+ */
+void gw_dev_dir_seen(uint16_t short_addr, uint8_t lqi, int8_t rssi, uint32_t now_ms);
+
+/**
+ * @brief Cache the active endpoint list, drops cached descriptors of
+ *        endpoints that are gone
+ */
+void gw_dev_dir_set_endpoints(uint16_t short_addr, uint8_t ep_count, const uint8_t* ep_list);
+
+/**
+ * @brief Cache a simple descriptor
+ * @return false when the device is unknown, the descriptor has more than
+ *         GW_DEV_DIR_CLUSTER_MAX clusters or no slot is free
+ */
+bool gw_dev_dir_set_desc(uint16_t short_addr, const gw_dev_desc_t* desc);
+
+/**
+ * @brief Cached simple descriptor of a device endpoint, NULL when not read yet
+ */
+const gw_dev_desc_t* gw_dev_dir_get_desc(uint16_t short_addr, uint8_t endpoint);
+
+/**
+ * @brief Number of devices and access by position, positions change when
+ *        a device is removed
+ */
+uint16_t gw_dev_dir_count(void);
+
+gw_dev_t* gw_dev_dir_get(uint16_t idx);
+
+void gw_dev_dir_stats_get(gw_dev_dir_stats_t* stats);
+
+#endif // __GW_DEV_DIR_H
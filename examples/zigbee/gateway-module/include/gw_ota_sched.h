@@ -0,0 +1,195 @@
+/**
+ * @file gw_ota_sched.h
+ * @brief OTA campaign scheduler of the gateway OTA server.
+ *
+ * A campaign is the list of devices to upgrade, or every device that
+ * queries when the list is empty. At most max_active devices download at
+ * the same time, the others stay pending: a pending device that asks for a
+ * block is told to wait, and when a slot frees up the next pending device
+ * gets an Image Notify so it queries at once instead of at its next query
+ * period.
+ *
+ * The active devices share block_rate blocks per second. Each one is paced
+ * with the minimum block period of a WAIT_FOR_DATA image block response,
+ * sent again only when the share changes by a large step, a request that
+ * comes too early is answered with a wait. A device without a block for
+ * stall_ms loses its slot and counts a failure, a device that reached
+ * max_failures is aborted.
+ *
+ * Blocks are read through a small LRU of RAM copies of the image, so the
+ * active devices working on different parts of the image do not each go
+ * to the flash.
+ *
+ * Progress in steps of GW_OTA_SCHED_PROGRESS_STEP percent and failures are
+ * sent to the host as GW_CMD_OTA_UPGRADE_STATUS_RESPONSE, the whole table
+ * with GW_CMD_OTA_CAMPAIGN_STATUS.
+ *
+ * Everything runs in the ZBOSS thread.
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+
+#ifndef __GW_OTA_SCHED_H
+#define __GW_OTA_SCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "zboss_api.h"
+
+/* Devices of one campaign, as many as the stack has addresses for */
+#ifndef GW_OTA_SCHED_DEV_MAX
+#define GW_OTA_SCHED_DEV_MAX ZB_IEEE_ADDR_TABLE_SIZE
+#endif
+
+/* RAM copies of the image, one per active device works best */
+#ifndef GW_OTA_SCHED_CACHE_LINES
+#define GW_OTA_SCHED_CACHE_LINES 4
+#endif
+
+/* Bytes per RAM copy, a power of two */
+#ifndef GW_OTA_SCHED_CACHE_LINE_SIZE
+#define GW_OTA_SCHED_CACHE_LINE_SIZE 512
+#endif
+
+/* Stall check and slot refill period while a campaign runs */
+#ifndef GW_OTA_SCHED_TICK_MS
+#define GW_OTA_SCHED_TICK_MS 5000
+#endif
+
+/* Shortest time between two Image Notify to the same pending device */
+#ifndef GW_OTA_SCHED_NOTIFY_MS
+#define GW_OTA_SCHED_NOTIFY_MS 60000
+#endif
+
+/* Wait asked from a pending device that requests a block */
+#ifndef GW_OTA_SCHED_RETRY_S
+#define GW_OTA_SCHED_RETRY_S 30
+#endif
+
+#ifndef GW_OTA_SCHED_PROGRESS_STEP
+#define GW_OTA_SCHED_PROGRESS_STEP 5
+#endif
+
+/* Records per GW_CMD_OTA_CAMPAIGN_STATUS response */
+#define GW_OTA_SCHED_STATUS_RECORDS 36
+
+/* data[2] of GW_CMD_OTA_UPGRADE_STATUS_RESPONSE */
+#define GW_OTA_STATUS_PROGRESS      0
+#define GW_OTA_STATUS_FINISHED      1
+#define GW_OTA_STATUS_SERVER_ABORT  2
+#define GW_OTA_STATUS_CLIENT_ABORT  3
+#define GW_OTA_STATUS_STALLED       4 /* no block for stall_ms, slot released */
+
+typedef enum {
+    GW_OTA_DEV_PENDING = 0, /* waiting for a slot */
+    GW_OTA_DEV_ACTIVE,      /* downloading */
+    GW_OTA_DEV_DONE,
+    GW_OTA_DEV_FAILED,      /* max_failures reached */
+} gw_ota_dev_state_t;
+
+typedef struct {
+    uint8_t max_active;     /* devices downloading at the same time */
+    uint8_t max_failures;   /* failed attempts before a device is given up */
+    uint16_t block_rate;    /* blocks per second shared by the active devices */
+    uint16_t min_period_ms; /* lower bound of the block period of one device */
+    uint32_t stall_ms;      /* time without a block before the slot is taken back */
+} gw_ota_sched_cfg_t;
+
+typedef struct {
+    uint16_t short_addr;
+    uint8_t ep;         /* client endpoint, 0xFF until the device sent an OTA frame */
+    uint8_t state;      /* gw_ota_dev_state_t */
+    uint8_t percent;
+    uint8_t failures;
+    uint16_t period_ms; /* minimum block period last given to the device */
+    uint32_t offset;    /* file offset of the last block served */
+    uint32_t last_ms;   /* last block, or Image Notify while pending */
+    uint32_t next_ms;   /* earliest time of the next block */
+} gw_ota_dev_t;
+
+typedef struct {
+    uint16_t pending;
+    uint16_t active;
+    uint16_t done;
+    uint16_t failed;
+    uint32_t blocks;       /* blocks served */
+    uint32_t waits;        /* WAIT_FOR_DATA responses */
+    uint32_t aborts;       /* ABORT responses */
+    uint32_t notifies;     /* Image Notify sent to pending devices */
+    uint32_t stalls;
+    uint32_t cache_hits;
+    uint32_t cache_misses;
+} gw_ota_sched_stats_t;
+
+void gw_ota_sched_init(void);
+
+/**
+ * @brief Image served by the OTA server, NULL when the file is removed
+ */
+void gw_ota_sched_image_set(const uint8_t* image, uint32_t size);
+
+/**
+ * @brief Start a campaign, replaces the running one
+ * @param addrs devices to upgrade, every device that queries when count is 0
+ * @return false when count is above GW_OTA_SCHED_DEV_MAX
+ */
+bool gw_ota_sched_start(const uint16_t* addrs, uint16_t count);
+
+/**
+ * @brief Stop the campaign, devices still downloading are aborted at their
+ *        next block request
+ */
+void gw_ota_sched_stop(void);
+
+bool gw_ota_sched_running(void);
+
+void gw_ota_sched_cfg_set(const gw_ota_sched_cfg_t* cfg);
+
+void gw_ota_sched_cfg_get(gw_ota_sched_cfg_t* cfg);
+
+/**
+ * @brief Query Next Image of a device
+ * @return true when the device may be offered the image
+ */
+bool gw_ota_sched_query(uint16_t short_addr);
+
+/**
+ * @brief OTA cluster frame received by the gateway endpoint
+ * @return true when the frame was answered and the buffer freed, false
+ *         when the OTA server has to process it
+ */
+bool gw_ota_sched_frame(zb_uint8_t param);
+
+/**
+ * @brief Image block sent by the OTA server
+ */
+void gw_ota_sched_block_sent(uint16_t short_addr, uint32_t offset);
+
+/**
+ * @brief Upgrade finished or aborted
+ * @param status GW_OTA_STATUS_FINISHED, _SERVER_ABORT or _CLIENT_ABORT
+ */
+void gw_ota_sched_end(uint16_t short_addr, uint8_t status);
+
+/**
+ * @brief Release the slot of a device that left the network
+ */
+void gw_ota_sched_remove_device(uint16_t short_addr);
+
+/**
+ * @brief Image data for a block, from the RAM copies when the block fits
+ *        in one line
+ */
+const uint8_t* gw_ota_sched_data(uint32_t offset, uint8_t size);
+
+uint16_t gw_ota_sched_count(void);
+
+const gw_ota_dev_t* gw_ota_sched_get(uint16_t idx);
+
+void gw_ota_sched_stats_get(gw_ota_sched_stats_t* stats);
+
+#endif // __GW_OTA_SCHED_H
@@ -0,0 +1,100 @@
+/**
+ * @file gw_report_agg.h
+ * @brief Attribute report aggregation between the Zigbee network and the host.
+ *
+ * Reports are cached per (short address, endpoint, cluster, attribute).
+ * A value equal to the one last sent to the host, or closer to it than the
+ * delta of the cluster policy, is dropped. A changed value is held until the
+ * minimum interval of the cluster policy has passed since the last frame for
+ * that attribute, a newer value replaces a held one. A periodic flush sends
+ * all due values of one device endpoint and cluster as a single report
+ * frame. Caching is opt-in per cluster: reports of clusters without a
+ * policy, and of those carrying alarms or user actions, bypass the cache.
+ * When the cache is full, the entry reported least recently whose value
+ * the host already has makes room. A frame the host link refuses keeps its
+ * values held for the next flush.
+ *
+ * Everything except the statistics runs in the ZBOSS thread.
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+
+#ifndef __GW_REPORT_AGG_H
+#define __GW_REPORT_AGG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Cached attributes, a power of two */
+#ifndef GW_REPORT_AGG_ENTRY_MAX
+#define GW_REPORT_AGG_ENTRY_MAX 256
+#endif
+
+/* Per-cluster policies that can be set at run time */
+#ifndef GW_REPORT_AGG_POLICY_MAX
+#define GW_REPORT_AGG_POLICY_MAX 16
+#endif
+
+/* Flush period while values are pending */
+#ifndef GW_REPORT_AGG_FLUSH_MS
+#define GW_REPORT_AGG_FLUSH_MS 500
+#endif
+
+typedef struct {
+    uint16_t cluster;
+    uint32_t min_interval_ms; /* shortest time between two frames for one attribute */
+    uint32_t max_interval_ms; /* resend an unchanged value after this, 0 never */
+    uint32_t delta;           /* smallest change forwarded, integer types only */
+} gw_report_agg_policy_t;
+
+typedef struct {
+    uint32_t received;         /* attribute records received */
+    uint32_t forwarded;        /* attribute records sent to the host */
+    uint32_t suppressed_equal; /* dropped, same value as last sent */
+    uint32_t suppressed_delta; /* dropped, change below the delta */
+    uint32_t coalesced;        /* held value replaced by a newer one */
+    uint32_t bypassed;         /* reports of urgent clusters */
+    uint32_t uncached;         /* reports sent at once, value not cacheable or cache full */
+    uint32_t frames;           /* report frames sent by the flush */
+    uint32_t evicted;          /* entries dropped to make room */
+    uint32_t send_failed;      /* flush frames refused, values kept for the next flush */
+} gw_report_agg_stats_t;
+
+/**
+ * @brief Clear the cache and restore the default policies
+ */
+void gw_report_agg_init(void);
+
+/**
+ * @brief Feed one received attribute report
+ * @return true when the report was taken, false when the caller has to
+ *         forward it at once
+ */
+bool gw_report_agg_input(uint16_t cluster, uint16_t addr, uint8_t ep,
+                         const uint8_t* pdata, uint16_t len);
+
+/**
+ * @brief Drop the cache entries of a device that left the network
+ */
+void gw_report_agg_remove_device(uint16_t addr);
+
+/**
+ * @brief Add or replace the policy of a cluster
+ * @return false when the policy table is full
+ */
+bool gw_report_agg_policy_set(const gw_report_agg_policy_t* policy);
+
+/**
+ * @brief Policy in effect for a cluster
+ * @return false when the cluster has no policy and bypasses the cache
+ */
+bool gw_report_agg_policy_get(uint16_t cluster, gw_report_agg_policy_t* policy);
+
+void gw_report_agg_stats_get(gw_report_agg_stats_t* stats);
+
+void gw_report_agg_stats_reset(void);
+
+#endif // __GW_REPORT_AGG_H
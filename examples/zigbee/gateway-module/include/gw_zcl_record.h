@@ -0,0 +1,56 @@
+/**
+ * @file gw_zcl_record.h
+ * @brief Attribute record walking of ZCL general command payloads.
+ *
+ * Sizes attribute values with a type-to-size table and splits report and
+ * read attribute response payloads at record boundaries, so a payload
+ * longer than one gateway frame goes to the host as several complete
+ * frames. No ZBOSS state is used, only the ZCL type and command ids.
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+
+#ifndef __GW_ZCL_RECORD_H
+#define __GW_ZCL_RECORD_H
+
+#include <stdint.h>
+
+/**
+ * @brief Called with each chunk of whole records
+ *
+ * @return 0 to go on, anything else stops the split
+ */
+typedef int (*gw_zcl_record_chunk_cb)(const uint8_t* data, uint16_t len,
+                                      void* arg);
+
+/* Size of a ZCL attribute value including any length prefix, 0 when the
+ * type is unknown or the value does not fit in avail bytes */
+uint16_t zigbee_zcl_attr_size(uint8_t attr_type, const uint8_t* data,
+                              uint16_t avail);
+
+/**
+ * @brief Size of the record at @p rec of a report (ZB_ZCL_CMD_REPORT_ATTRIB)
+ *        or read attribute response (ZB_ZCL_CMD_READ_ATTRIB_RESP)
+ *
+ * @return the record size, 0 when malformed, truncated or another command
+ */
+uint16_t gw_zcl_record_size(uint8_t zcl_cmd, const uint8_t* rec,
+                            uint16_t avail);
+
+/**
+ * @brief Hand @p data to @p cb in chunks of whole records of at most
+ *        @p max bytes, a payload that fits goes in one call
+ *
+ * The records before a malformed one, or one longer than @p max, still go
+ * out.
+ *
+ * @return 0, or -1 when a record is malformed or longer than @p max, or
+ *         @p cb stopped the split
+ */
+int gw_zcl_record_split(uint8_t zcl_cmd, const uint8_t* data, uint16_t len,
+                        uint16_t max, gw_zcl_record_chunk_cb cb, void* arg);
+
+#endif // __GW_ZCL_RECORD_H
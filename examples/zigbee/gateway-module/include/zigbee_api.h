@@ -39,20 +39,20 @@
     vPortExitCritical()
 
 typedef void (*zcl_read_rsp_cb)(uint16_t cluster_id, uint16_t addr,
-                                uint8_t src_endp, uint8_t* pd, uint8_t pd_len);
+                                uint8_t src_endp, uint8_t* pd, uint16_t pd_len);
 typedef void (*zcl_write_rsp_cb)(uint16_t cluster_id, uint16_t addr,
-                                 uint8_t src_endp, uint8_t* pd, uint8_t pd_len);
+                                 uint8_t src_endp, uint8_t* pd, uint16_t pd_len);
 typedef void (*zcl_cfg_report_rsp_cb)(uint16_t cluster_id, uint16_t addr,
                                       uint8_t src_endp, uint8_t* pd,
-                                      uint8_t pd_len);
+                                      uint16_t pd_len);
 typedef void (*zcl_report_attribute_cb)(uint16_t cluster_id, uint16_t addr,
                                         uint8_t src_endp, uint8_t* pd,
-                                        uint8_t pd_len);
+                                        uint16_t pd_len);
 typedef void (*zcl_zone_status_change_notification_cb)(uint16_t cluster_id,
                                                        uint16_t addr,
                                                        uint8_t src_endp,
                                                        uint8_t* pd,
-                                                       uint8_t pd_len);
+                                                       uint16_t pd_len);
 
 typedef enum {
     ZB_APP_EVENT_NONE = 0,
@@ -60,6 +60,7 @@ typedef enum {
     ZB_APP_EVENT_UART_DATA_IN = 0x00000002,
     ZB_APP_EVENT_UART_TX_DONE = 0x00000004,
     ZB_APP_EVENT_JOINED = 0x00000008,
+    ZB_APP_EVENT_SYS_MONITOR = 0x00000010,
     ZB_APP_EVENT_ALL = 0xffffffff,
 } zb_app_event_t;
 
@@ -106,4 +107,6 @@ uint32_t get_gw_time(void);
 void zigbee_app_mac_ed_scan_command(void);
 void zigbee_app_addr_table_update(void);
 void zigbee_app_get_address_by_group_idx(uint8_t group);
+void zigbee_app_dev_dir_seen(uint16_t short_addr);
+void zigbee_app_dev_dir_desc_update(uint16_t short_addr, zb_af_simple_desc_1_1_t* simple_desc);
 #endif // __ZIGBEE_API_H
@@ -127,11 +127,27 @@ typedef enum {
 
 #define GW_CMD_APP_SRV_CUSTOM_BASE 0xFC000000
 
+/* Largest parameter a gateway frame can carry. The length and checksum are
+ * one byte wide and also cover the length byte, command id, address, address
+ * mode and endpoint */
+#define ZIGBEE_GW_CMD_PARAM_MAX    (255 - 9)
+
 
 void zigbee_gw_init(void* cmd_queue);
 void zigbee_gw_cmd_proc(uint8_t* pBuf, uint16_t len);
-void zigbee_gw_cmd_send(uint32_t cmd_id, uint16_t addr, uint8_t addr_mode,
-                        uint8_t src_endp, uint8_t* pParam, uint32_t len);
+/* The send functions return 0, or -1 when the frame is longer than
+ * ZIGBEE_GW_CMD_PARAM_MAX or cannot be allocated, nothing is sent then */
+int zigbee_gw_cmd_send(uint32_t cmd_id, uint16_t addr, uint8_t addr_mode,
+                       uint8_t src_endp, uint8_t* pParam, uint32_t len);
+int zigbee_gw_cmd_send_prefixed(uint32_t cmd_id, uint16_t addr,
+                                uint8_t addr_mode, uint8_t src_endp,
+                                uint8_t* pPrefix, uint32_t prefix_len,
+                                uint8_t* pParam, uint32_t len);
+/* Attribute reports and read attribute responses with the cluster id in
+ * front, split at record boundaries into as many frames as needed */
+int zigbee_gw_cmd_send_records(uint32_t cmd_id, uint16_t addr,
+                               uint8_t src_endp, uint16_t cluster_id,
+                               uint8_t zcl_cmd, uint8_t* pParam, uint32_t len);
 void zigbee_gw_cmd_act(uint32_t cmd_id, uint16_t addr, uint8_t addr_mode,
                        uint8_t src_endp, uint8_t* pParam, uint32_t len);
 // void _zcl_report_attribute_cb(uint16_t cluster_id, uint16_t addr, uint8_t src_endp, uint8_t *pd, uint8_t pd_len);
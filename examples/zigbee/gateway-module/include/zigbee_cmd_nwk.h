@@ -45,6 +45,7 @@ typedef enum {
     ZIGBEE_CMD_GATEWAY_INSTALL_CODE_REMOVE_REQUEST = 0x00000045,
     ZIGBEE_CMD_GATEWAY_INSTALL_CODE_REMOVE_ALL_REQUEST = 0x00000046,
     ZIGBEE_CMD_GATEWAY_STANDARD_TIME_SET = 0x00000047,
+    ZIGBEE_CMD_GATEWAY_SYS_MONITOR_REQUEST = 0x00000048,
     ZIGBEE_CMD_FINISH,
 } zigbee_cmd_t;
 
@@ -81,4 +82,10 @@ typedef void (*zigbee_cmd_func)(zigbee_cmd_req_t* pt_cmd_req);
 void zigbee_cmd_request(uint16_t dst_addr, uint32_t t_index, uint32_t u32_len,
                         uint8_t* pu8_value);
 
+/* System monitor record, see rtos_monitor.h; sampled() is the monitor
+ * callback and asks the app task to push the record when the host
+ * subscribed with ZIGBEE_CMD_GATEWAY_SYS_MONITOR_REQUEST */
+void zigbee_sys_monitor_sampled(void);
+void zigbee_sys_monitor_send(void);
+
 #endif // __ZIGBEE_CMD_NWK_H
\ No newline at end of file
@@ -24,6 +24,9 @@ typedef enum {
     GW_CMD_OTA_CANDIDATE_REMOVE = 0xF0000006,
     GW_CMD_OTA_CANDIDATE_GET = 0xF0000007,
     GW_CMD_OTA_FILE_INFO_REQUEST = 0xF000000A,
+    GW_CMD_OTA_CAMPAIGN_START = 0xF000000B,
+    GW_CMD_OTA_CAMPAIGN_STOP = 0xF000000C,
+    GW_CMD_OTA_CAMPAIGN_STATUS = 0xF000000D,
     GW_CMD_OTA_END,
 
     GW_CMD_OTA_UPLOAD_END_RESPONSE = 0xF0008002,
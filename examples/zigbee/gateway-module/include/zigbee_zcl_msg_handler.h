@@ -13,6 +13,8 @@
 #include "zb_mac_globals.h"
 #include "zboss_api.h"
 
+#include "gw_zcl_record.h"
+
 zb_uint8_t zigbee_zcl_msg_handler(zb_uint8_t param);
 
 #endif // __ZIGBEE_ZCL_MSG_HANDLER_H__
\ No newline at end of file
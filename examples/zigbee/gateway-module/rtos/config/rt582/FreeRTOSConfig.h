@@ -36,7 +36,7 @@ See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
 
 #define configTOTAL_HEAP_SIZE                   ((size_t)0x8000)
 #define configMAX_TASK_NAME_LEN                 (24)
-#define configUSE_TRACE_FACILITY                0
+#define configUSE_TRACE_FACILITY                1
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 #define configUSE_16_BIT_TICKS                  0
 #define configIDLE_SHOULD_YIELD                 1
@@ -47,8 +47,8 @@ See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
 #define configUSE_MALLOC_FAILED_HOOK            1
 #define configUSE_APPLICATION_TASK_TAG          0
 #define configUSE_COUNTING_SEMAPHORES           1
-#define configGENERATE_RUN_TIME_STATS           0
-#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#define configGENERATE_RUN_TIME_STATS           1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 1
 #define configSUPPORT_STATIC_ALLOCATION         1
 #define configRECORD_STACK_HIGH_ADDRESS         1
 
@@ -86,6 +86,14 @@ to exclude the API function. */
 #define INCLUDE_xTaskGetHandle                 (1)
 
 
+/* Binary trace recorder, dump with the trace CLI command, see rtos_trace.h */
+#define configUSE_RTOS_TRACE 1
+#include "rtos_trace.h"
+
+/* CPU, stack and heap monitor, sysmon CLI command, see rtos_monitor.h */
+#define configUSE_RTOS_MONITOR 1
+#include "rtos_monitor.h"
+
 /* Stop if an assertion fails. */
 #define configASSERT(x)                                                        \
     if ((x) == 0) {                                                            \
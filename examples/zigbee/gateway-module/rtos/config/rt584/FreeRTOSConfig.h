@@ -43,8 +43,8 @@ See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
 #define configUSE_MALLOC_FAILED_HOOK	1
 #define configUSE_APPLICATION_TASK_TAG	0
 #define configUSE_COUNTING_SEMAPHORES	1
-#define configGENERATE_RUN_TIME_STATS	0
-#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#define configGENERATE_RUN_TIME_STATS	1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 1
 #define configSUPPORT_STATIC_ALLOCATION 1
 
 
@@ -94,6 +94,14 @@ to exclude the API function. */
 //#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()    rt584_utick_set_clear()
 //#define portGET_RUN_TIME_COUNTER_VALUE()       Timer_25us_Tick
 
+/* Binary trace recorder, dump with the trace CLI command, see rtos_trace.h */
+#define configUSE_RTOS_TRACE 1
+#include "rtos_trace.h"
+
+/* CPU, stack and heap monitor, sysmon CLI command, see rtos_monitor.h */
+#define configUSE_RTOS_MONITOR 1
+#include "rtos_monitor.h"
+
 /* Stop if an assertion fails. */
 #define configASSERT(x)                                                                                                            \
     if ((x) == 0)                                                                                                                  \
@@ -0,0 +1,397 @@
+/**
+ * @file gw_dev_dir.c
+ * @brief Gateway device directory, see gw_dev_dir.h
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+//=============================================================================
+//                Include
+//=============================================================================
+#include <stddef.h>
+#include <string.h>
+
+#include "gw_dev_dir.h"
+
+//=============================================================================
+//                Private Definitions
+//=============================================================================
+#define DIR_NONE    0xFF
+#define DIR_MASK    (GW_DEV_DIR_INDEX_SIZE - 1)
+
+#if (GW_DEV_DIR_INDEX_SIZE & DIR_MASK) || (GW_DEV_DIR_INDEX_SIZE < 2 * GW_DEV_DIR_DEV_MAX)
+#error "GW_DEV_DIR_INDEX_SIZE must be a power of two of at least twice GW_DEV_DIR_DEV_MAX"
+#endif
+#if (GW_DEV_DIR_DEV_MAX >= DIR_NONE) || (GW_DEV_DIR_DESC_MAX >= DIR_NONE)
+#error "GW_DEV_DIR_DEV_MAX and GW_DEV_DIR_DESC_MAX must be below 255"
+#endif
+
+//=============================================================================
+//                Private Global Variables
+//=============================================================================
+/* Records are kept dense, removal moves the last record into the hole */
+static gw_dev_t dir_devs[GW_DEV_DIR_DEV_MAX];
+static uint16_t dir_count;
+static uint8_t dir_by_ieee[GW_DEV_DIR_INDEX_SIZE];
+static uint8_t dir_by_short[GW_DEV_DIR_INDEX_SIZE];
+
+static gw_dev_desc_t dir_descs[GW_DEV_DIR_DESC_MAX];
+static uint8_t dir_desc_free[GW_DEV_DIR_DESC_MAX];
+static uint8_t dir_desc_free_num;
+
+static gw_dev_dir_stats_t dir_stats;
+
+//=============================================================================
+//                Private Function
+//=============================================================================
+static uint32_t dir_hash_ieee(const uint8_t* ieee) {
+    uint64_t key = 0;
+    uint8_t i;
+
+    for (i = 0; i < 8; i++) {
+        key |= (uint64_t)ieee[i] << (8 * i);
+    }
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 40) & DIR_MASK;
+}
+
+static uint32_t dir_hash_short(uint16_t short_addr) {
+    return ((short_addr * 0x9E3779B1UL) >> 16) & DIR_MASK;
+}
+
+static uint32_t dir_home(const uint8_t* index, uint8_t dev) {
+    return (index == dir_by_ieee) ? dir_hash_ieee(dir_devs[dev].ieee)
+                                  : dir_hash_short(dir_devs[dev].short_addr);
+}
+
+static int32_t dir_slot_ieee(const uint8_t* ieee) {
+    uint32_t slot = dir_hash_ieee(ieee);
+
+    while (dir_by_ieee[slot] != DIR_NONE) {
+        if (memcmp(dir_devs[dir_by_ieee[slot]].ieee, ieee, 8) == 0) {
+            return slot;
+        }
+        slot = (slot + 1) & DIR_MASK;
+    }
+    return -1;
+}
+
+static int32_t dir_slot_short(uint16_t short_addr) {
+    uint32_t slot = dir_hash_short(short_addr);
+
+    if (short_addr == GW_DEV_DIR_SHORT_UNKNOWN) {
+        return -1;
+    }
+    while (dir_by_short[slot] != DIR_NONE) {
+        if (dir_devs[dir_by_short[slot]].short_addr == short_addr) {
+            return slot;
+        }
+        slot = (slot + 1) & DIR_MASK;
+    }
+    return -1;
+}
+
+static void dir_index_insert(uint8_t* index, uint8_t dev) {
+    uint32_t slot = dir_home(index, dev);
+
+    while (index[slot] != DIR_NONE) {
+        slot = (slot + 1) & DIR_MASK;
+    }
+    index[slot] = dev;
+}
+
+/* Backward shift deletion, no tombstones are left in the probe sequences */
+static void dir_index_erase(uint8_t* index, uint32_t hole) {
+    uint32_t slot = hole, home;
+
+    for (;;) {
+        slot = (slot + 1) & DIR_MASK;
+        if (index[slot] == DIR_NONE) {
+            break;
+        }
+        home = dir_home(index, index[slot]);
+        if (((slot - home) & DIR_MASK) >= ((slot - hole) & DIR_MASK)) {
+            index[hole] = index[slot];
+            hole = slot;
+        }
+    }
+    index[hole] = DIR_NONE;
+}
+
+static void dir_index_retarget(uint8_t* index, uint8_t from, uint8_t to) {
+    uint32_t slot = dir_home(index, to);
+
+    while (index[slot] != from) {
+        slot = (slot + 1) & DIR_MASK;
+    }
+    index[slot] = to;
+}
+
+static void dir_short_drop(gw_dev_t* dev) {
+    int32_t slot = dir_slot_short(dev->short_addr);
+
+    if (slot >= 0) {
+        dir_index_erase(dir_by_short, slot);
+    }
+    dev->short_addr = GW_DEV_DIR_SHORT_UNKNOWN;
+}
+
+static void dir_desc_release(uint8_t desc) {
+    if (desc != DIR_NONE) {
+        dir_desc_free[dir_desc_free_num++] = desc;
+    }
+}
+
+static int32_t dir_ep_pos(const gw_dev_t* dev, uint8_t endpoint) {
+    uint8_t i;
+
+    for (i = 0; i < dev->ep_count; i++) {
+        if (dev->ep_list[i] == endpoint) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Insert or re-key a record, the newest claim owns the short address */
+static gw_dev_t* dir_upsert(const uint8_t* ieee, uint16_t short_addr, bool* known) {
+    int32_t slot = dir_slot_ieee(ieee), holder = dir_slot_short(short_addr);
+    gw_dev_t* dev;
+    uint8_t d;
+
+    if (holder >= 0 && (slot < 0 || dir_by_short[holder] != dir_by_ieee[slot])) {
+        dir_devs[dir_by_short[holder]].short_addr = GW_DEV_DIR_SHORT_UNKNOWN;
+        dir_index_erase(dir_by_short, holder);
+        dir_stats.conflicts++;
+    }
+
+    *known = (slot >= 0);
+    if (slot >= 0) {
+        d = dir_by_ieee[slot];
+        dev = &dir_devs[d];
+        if (dev->short_addr != short_addr) {
+            dir_stats.addr_changes++;
+            dir_short_drop(dev);
+            dev->short_addr = short_addr;
+            if (short_addr != GW_DEV_DIR_SHORT_UNKNOWN) {
+                dir_index_insert(dir_by_short, d);
+            }
+        }
+    } else {
+        if (dir_count >= GW_DEV_DIR_DEV_MAX) {
+            dir_stats.full++;
+            return NULL;
+        }
+        d = dir_count++;
+        dev = &dir_devs[d];
+        memset(dev, 0, sizeof(gw_dev_t));
+        memcpy(dev->ieee, ieee, 8);
+        memset(dev->desc, DIR_NONE, sizeof(dev->desc));
+        dev->short_addr = short_addr;
+        dir_index_insert(dir_by_ieee, d);
+        if (short_addr != GW_DEV_DIR_SHORT_UNKNOWN) {
+            dir_index_insert(dir_by_short, d);
+        }
+    }
+    return dev;
+}
+
+//=============================================================================
+//                Public Function
+//=============================================================================
+void gw_dev_dir_init(void) {
+    uint8_t i;
+
+    memset(dir_by_ieee, DIR_NONE, sizeof(dir_by_ieee));
+    memset(dir_by_short, DIR_NONE, sizeof(dir_by_short));
+    dir_count = 0;
+    for (i = 0; i < GW_DEV_DIR_DESC_MAX; i++) {
+        dir_desc_free[i] = GW_DEV_DIR_DESC_MAX - 1 - i;
+    }
+    dir_desc_free_num = GW_DEV_DIR_DESC_MAX;
+    memset(&dir_stats, 0, sizeof(dir_stats));
+}
+
+gw_dev_t* gw_dev_dir_announce(const uint8_t ieee[8], uint16_t short_addr,
+                              uint8_t capability, uint32_t now_ms) {
+    gw_dev_t* dev;
+    bool known;
+
+    dir_stats.announces++;
+    dev = dir_upsert(ieee, short_addr, &known);
+    if (dev == NULL) {
+        return NULL;
+    }
+    if (known) {
+        dir_stats.rejoins++;
+    }
+    dev->capability = capability;
+    dev->last_seen_ms = now_ms;
+    return dev;
+}
+
+gw_dev_t* gw_dev_dir_sync(const uint8_t ieee[8], uint16_t short_addr, uint32_t now_ms) {
+    gw_dev_t* dev = gw_dev_dir_find_ieee(ieee);
+    bool known;
+
+    if (dev && dev->short_addr == short_addr) {
+        return dev;
+    }
+    dev = dir_upsert(ieee, short_addr, &known);
+    if (dev == NULL) {
+        return NULL;
+    }
+    dir_stats.synced++;
+    if (!known) {
+        dev->last_seen_ms = now_ms;
+    }
+    return dev;
+}
+
+bool gw_dev_dir_remove(const uint8_t ieee[8]) {
+    int32_t slot = dir_slot_ieee(ieee);
+    uint8_t d, last, i;
+    gw_dev_t* dev;
+
+    if (slot < 0) {
+        return false;
+    }
+    d = dir_by_ieee[slot];
+    dev = &dir_devs[d];
+    dir_index_erase(dir_by_ieee, slot);
+    dir_short_drop(dev);
+    for (i = 0; i < dev->ep_count; i++) {
+        dir_desc_release(dev->desc[i]);
+    }
+
+    last = dir_count - 1;
+    if (d != last) {
+        *dev = dir_devs[last];
+        dir_index_retarget(dir_by_ieee, last, d);
+        if (dev->short_addr != GW_DEV_DIR_SHORT_UNKNOWN) {
+            dir_index_retarget(dir_by_short, last, d);
+        }
+    }
+    dir_count--;
+    dir_stats.leaves++;
+    return true;
+}
+
+void gw_dev_dir_addr_conflict(uint16_t short_addr) {
+    gw_dev_t* dev = gw_dev_dir_find_short(short_addr);
+
+    if (dev) {
+        dir_short_drop(dev);
+        dir_stats.conflicts++;
+    }
+}
+
+gw_dev_t* gw_dev_dir_find_ieee(const uint8_t ieee[8]) {
+    int32_t slot = dir_slot_ieee(ieee);
+
+    return (slot < 0) ? NULL : &dir_devs[dir_by_ieee[slot]];
+}
+
+gw_dev_t* gw_dev_dir_find_short(uint16_t short_addr) {
+    int32_t slot = dir_slot_short(short_addr);
+
+    return (slot < 0) ? NULL : &dir_devs[dir_by_short[slot]];
+}
+
+void gw_dev_dir_seen(uint16_t short_addr, uint8_t lqi, int8_t rssi, uint32_t now_ms) {
+    gw_dev_t* dev = gw_dev_dir_find_short(short_addr);
+
+    if (dev) {
+        dev->lqi = lqi;
+        dev->rssi = rssi;
+        dev->last_seen_ms = now_ms;
+    }
+}
+
+void gw_dev_dir_set_endpoints(uint16_t short_addr, uint8_t ep_count, const uint8_t* ep_list) {
+    gw_dev_t* dev = gw_dev_dir_find_short(short_addr);
+    uint8_t desc[GW_DEV_DIR_EP_MAX];
+    int32_t pos;
+    uint8_t i;
+
+    if (dev == NULL) {
+        return;
+    }
+    if (ep_count > GW_DEV_DIR_EP_MAX) {
+        /* Not cacheable, requests keep going over the air */
+        for (i = 0; i < dev->ep_count; i++) {
+            dir_desc_release(dev->desc[i]);
+        }
+        dev->ep_count = 0;
+        dev->ep_valid = 0;
+        return;
+    }
+
+    /* Keep the descriptors of endpoints that are still there */
+    for (i = 0; i < ep_count; i++) {
+        pos = dir_ep_pos(dev, ep_list[i]);
+        desc[i] = (pos < 0) ? DIR_NONE : dev->desc[pos];
+        if (pos >= 0) {
+            dev->desc[pos] = DIR_NONE;
+        }
+    }
+    for (i = 0; i < dev->ep_count; i++) {
+        dir_desc_release(dev->desc[i]);
+    }
+    memset(dev->desc, DIR_NONE, sizeof(dev->desc));
+    memcpy(dev->desc, desc, ep_count);
+    memcpy(dev->ep_list, ep_list, ep_count);
+    dev->ep_count = ep_count;
+    dev->ep_valid = 1;
+}
+
+bool gw_dev_dir_set_desc(uint16_t short_addr, const gw_dev_desc_t* desc) {
+    gw_dev_t* dev = gw_dev_dir_find_short(short_addr);
+    int32_t pos;
+
+    if (dev == NULL || desc->in_count + desc->out_count > GW_DEV_DIR_CLUSTER_MAX) {
+        return false;
+    }
+    pos = dir_ep_pos(dev, desc->endpoint);
+    if (pos < 0) {
+        /* Descriptor read before the endpoint list, remember the endpoint
+         * without marking the list complete */
+        if (dev->ep_valid || dev->ep_count >= GW_DEV_DIR_EP_MAX) {
+            return false;
+        }
+        pos = dev->ep_count++;
+        dev->ep_list[pos] = desc->endpoint;
+        dev->desc[pos] = DIR_NONE;
+    }
+    if (dev->desc[pos] == DIR_NONE) {
+        if (dir_desc_free_num == 0) {
+            return false;
+        }
+        dev->desc[pos] = dir_desc_free[--dir_desc_free_num];
+    }
+    dir_descs[dev->desc[pos]] = *desc;
+    return true;
+}
+
+const gw_dev_desc_t* gw_dev_dir_get_desc(uint16_t short_addr, uint8_t endpoint) {
+    gw_dev_t* dev = gw_dev_dir_find_short(short_addr);
+    int32_t pos;
+
+    if (dev == NULL) {
+        return NULL;
+    }
+    pos = dir_ep_pos(dev, endpoint);
+    if (pos < 0 || dev->desc[pos] == DIR_NONE) {
+        return NULL;
+    }
+    return &dir_descs[dev->desc[pos]];
+}
+
+uint16_t gw_dev_dir_count(void) { return dir_count; }
+
+gw_dev_t* gw_dev_dir_get(uint16_t idx) {
+    return (idx < dir_count) ? &dir_devs[idx] : NULL;
+}
+
+void gw_dev_dir_stats_get(gw_dev_dir_stats_t* stats) { *stats = dir_stats; }
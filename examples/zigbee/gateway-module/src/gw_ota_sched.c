@@ -0,0 +1,471 @@
+/**
+ * @file gw_ota_sched.c
+ * @brief OTA campaign scheduler, see gw_ota_sched.h
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+//=============================================================================
+//                Include
+//=============================================================================
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "zb_common.h"
+#include "zboss_api.h"
+
+#include <zigbee_platform.h>
+#include "log.h"
+#include "zigbee_api.h"
+#include "zigbee_cmd_app.h"
+#include "zigbee_cmd_ota.h"
+#include "gw_ota_sched.h"
+
+//=============================================================================
+//                Private Definitions
+//=============================================================================
+#define OTA_EP_UNKNOWN          0xFF /* also the APS broadcast endpoint */
+#define OTA_NOTIFY_JITTER       100  /* query at once, unicast notify */
+
+#if (GW_OTA_SCHED_CACHE_LINE_SIZE & (GW_OTA_SCHED_CACHE_LINE_SIZE - 1))
+#error "GW_OTA_SCHED_CACHE_LINE_SIZE must be a power of two"
+#endif
+
+//=============================================================================
+//                Private Global Variables
+//=============================================================================
+static const gw_ota_sched_cfg_t ota_default_cfg = {
+    .max_active = 4,
+    .max_failures = 3,
+    .block_rate = 20,
+    .min_period_ms = 0,
+    .stall_ms = 60000,
+};
+
+static gw_ota_sched_cfg_t ota_cfg;
+static gw_ota_dev_t ota_devs[GW_OTA_SCHED_DEV_MAX];
+static uint16_t ota_count;
+static uint16_t ota_active;
+static uint16_t ota_notify_next;
+static bool ota_running;
+static bool ota_open;
+static bool ota_tick_armed;
+static gw_ota_sched_stats_t ota_stats;
+
+static const uint8_t* ota_image;
+static uint32_t ota_image_size;
+static uint8_t ota_cache[GW_OTA_SCHED_CACHE_LINES][GW_OTA_SCHED_CACHE_LINE_SIZE];
+static uint32_t ota_cache_tag[GW_OTA_SCHED_CACHE_LINES];
+static uint32_t ota_cache_used[GW_OTA_SCHED_CACHE_LINES];
+static uint32_t ota_cache_clock;
+
+//=============================================================================
+//                Private Function
+//=============================================================================
+static uint32_t ota_now_ms(void) {
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+static gw_ota_dev_t* ota_find(uint16_t short_addr) {
+    uint16_t i;
+
+    for (i = 0; i < ota_count; i++) {
+        if (ota_devs[i].short_addr == short_addr) {
+            return &ota_devs[i];
+        }
+    }
+    return NULL;
+}
+
+static gw_ota_dev_t* ota_add(uint16_t short_addr, uint32_t now) {
+    gw_ota_dev_t* e;
+
+    if (ota_count >= GW_OTA_SCHED_DEV_MAX) {
+        return NULL;
+    }
+    e = &ota_devs[ota_count++];
+    memset(e, 0, sizeof(gw_ota_dev_t));
+    e->short_addr = short_addr;
+    e->ep = OTA_EP_UNKNOWN;
+    e->state = GW_OTA_DEV_PENDING;
+    e->last_ms = now - GW_OTA_SCHED_NOTIFY_MS; /* notify at the first tick */
+    return e;
+}
+
+/* Block period of each active device so that they share block_rate */
+static uint16_t ota_period(void) {
+    uint32_t period = 0;
+
+    if (ota_cfg.block_rate) {
+        period = (uint32_t)ota_active * 1000 / ota_cfg.block_rate;
+    }
+    if (period < ota_cfg.min_period_ms) {
+        period = ota_cfg.min_period_ms;
+    }
+    return (period > 0xFFFF) ? 0xFFFF : period;
+}
+
+static void ota_report(uint16_t short_addr, uint8_t status, uint8_t percent) {
+    uint8_t data[4];
+
+    memcpy(data, &short_addr, 2);
+    data[2] = status;
+    data[3] = percent;
+    zigbee_gw_cmd_send(GW_CMD_OTA_UPGRADE_STATUS_RESPONSE, 0x0000, 0, 0, data, 4);
+}
+
+static void ota_fail(gw_ota_dev_t* e, uint8_t status) {
+    if (e->state == GW_OTA_DEV_ACTIVE) {
+        ota_active--;
+    }
+    e->failures++;
+    e->state = (e->failures >= ota_cfg.max_failures) ? GW_OTA_DEV_FAILED : GW_OTA_DEV_PENDING;
+    ota_report(e->short_addr, status, (status == GW_OTA_STATUS_STALLED) ? e->percent : 0xFF);
+}
+
+static void ota_block_rsp(uint16_t short_addr, uint8_t ep, uint8_t seq, uint8_t status,
+                          uint32_t wait_s, uint16_t period_ms) {
+    zcl_data_req_t* pt_data_req;
+    uint8_t len = (status == ZB_ZCL_STATUS_WAIT_FOR_DATA) ? 11 : 1;
+
+    ZIGBEE_ZCL_DATA_REQ(pt_data_req, short_addr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT, ep,
+                        ZIGBEE_DEFAULT_ENDPOINT, ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+                        ZB_ZCL_CMD_OTA_UPGRADE_IMAGE_BLOCK_RESP_ID,
+                        TRUE, TRUE, ZCL_FRAME_SERVER_CLIENT_DIR, 0, len)
+
+    if (pt_data_req) {
+        pt_data_req->specific_seq_num = 1;
+        pt_data_req->seq_num = seq;
+        pt_data_req->cmdFormat[0] = status;
+        if (len > 1) {
+            /* current time 0: the request time is the wait in seconds */
+            memset(&pt_data_req->cmdFormat[1], 0, 4);
+            memcpy(&pt_data_req->cmdFormat[5], &wait_s, 4);
+            memcpy(&pt_data_req->cmdFormat[9], &period_ms, 2);
+            ota_stats.waits++;
+        } else {
+            ota_stats.aborts++;
+        }
+        zigbee_app_zcl_send_command(pt_data_req);
+        vPortFree(pt_data_req);
+    }
+}
+
+static void ota_image_notify(const gw_ota_dev_t* e) {
+    zcl_data_req_t* pt_data_req;
+
+    ZIGBEE_ZCL_DATA_REQ(pt_data_req, e->short_addr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT, e->ep,
+                        ZIGBEE_DEFAULT_ENDPOINT, ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+                        ZB_ZCL_CMD_OTA_UPGRADE_IMAGE_NOTIFY_ID,
+                        TRUE, TRUE, ZCL_FRAME_SERVER_CLIENT_DIR, 0, 2)
+
+    if (pt_data_req) {
+        pt_data_req->cmdFormat[0] = 0x00; /* payload type: query jitter only */
+        pt_data_req->cmdFormat[1] = OTA_NOTIFY_JITTER;
+        zigbee_app_zcl_send_command(pt_data_req);
+        vPortFree(pt_data_req);
+        ota_stats.notifies++;
+    }
+}
+
+static void ota_tick(zb_uint8_t param);
+
+static void ota_tick_schedule(void) {
+    if (!ota_tick_armed) {
+        ota_tick_armed = true;
+        ZB_SCHEDULE_APP_ALARM(ota_tick, 0,
+                              ZB_MILLISECONDS_TO_BEACON_INTERVAL(GW_OTA_SCHED_TICK_MS));
+    }
+}
+
+static void ota_tick(zb_uint8_t param) {
+    uint32_t now = ota_now_ms();
+    uint16_t i, idx, start;
+    int32_t free_slots;
+    gw_ota_dev_t* e;
+
+    ota_tick_armed = false;
+    if (!ota_running) {
+        return;
+    }
+
+    free_slots = ota_cfg.max_active;
+    for (i = 0; i < ota_count; i++) {
+        e = &ota_devs[i];
+        if (e->state == GW_OTA_DEV_ACTIVE) {
+            if (now - e->last_ms > ota_cfg.stall_ms) {
+                log_info("OTA 0x%04x stalled at %d%%", e->short_addr, e->percent);
+                ota_stats.stalls++;
+                ota_fail(e, GW_OTA_STATUS_STALLED);
+            } else {
+                free_slots--;
+            }
+        } else if (e->state == GW_OTA_DEV_PENDING && now - e->last_ms < 2 * GW_OTA_SCHED_TICK_MS) {
+            /* notified a moment ago, its first block request is on the way */
+            free_slots--;
+        }
+    }
+
+    /* Wake pending devices round robin so each one gets its turn */
+    start = ota_notify_next;
+    for (i = 0; i < ota_count && free_slots > 0; i++) {
+        idx = (start + i) % ota_count;
+        e = &ota_devs[idx];
+        if (e->state == GW_OTA_DEV_PENDING && now - e->last_ms >= GW_OTA_SCHED_NOTIFY_MS) {
+            ota_image_notify(e);
+            e->last_ms = now;
+            free_slots--;
+            ota_notify_next = idx + 1;
+        }
+    }
+    ota_tick_schedule();
+}
+
+//=============================================================================
+//                Public Function
+//=============================================================================
+void gw_ota_sched_init(void) {
+    ota_cfg = ota_default_cfg;
+    ota_count = 0;
+    ota_active = 0;
+    ota_running = false;
+    ota_tick_armed = false;
+    ota_image = NULL;
+    ota_image_size = 0;
+    memset(ota_cache_tag, 0xFF, sizeof(ota_cache_tag));
+    memset(&ota_stats, 0, sizeof(ota_stats));
+}
+
+void gw_ota_sched_image_set(const uint8_t* image, uint32_t size) {
+    ota_image = image;
+    ota_image_size = image ? size : 0;
+    memset(ota_cache_tag, 0xFF, sizeof(ota_cache_tag));
+}
+
+bool gw_ota_sched_start(const uint16_t* addrs, uint16_t count) {
+    uint32_t now = ota_now_ms();
+    uint16_t i;
+
+    if (count > GW_OTA_SCHED_DEV_MAX) {
+        return false;
+    }
+    ota_count = 0;
+    ota_active = 0;
+    ota_notify_next = 0;
+    for (i = 0; i < count; i++) {
+        if (!ota_find(addrs[i])) {
+            ota_add(addrs[i], now);
+        }
+    }
+    ota_open = (count == 0);
+    ota_running = true;
+    log_info("OTA campaign %d devices, %d at a time", count, ota_cfg.max_active);
+    ota_tick_schedule();
+    return true;
+}
+
+void gw_ota_sched_stop(void) {
+    ota_running = false;
+    ota_count = 0;
+    ota_active = 0;
+}
+
+bool gw_ota_sched_running(void) { return ota_running; }
+
+void gw_ota_sched_cfg_set(const gw_ota_sched_cfg_t* cfg) {
+    ota_cfg = *cfg;
+    if (ota_cfg.max_active == 0) {
+        ota_cfg.max_active = 1;
+    }
+    if (ota_cfg.max_failures == 0) {
+        ota_cfg.max_failures = 1;
+    }
+}
+
+void gw_ota_sched_cfg_get(gw_ota_sched_cfg_t* cfg) { *cfg = ota_cfg; }
+
+bool gw_ota_sched_query(uint16_t short_addr) {
+    gw_ota_dev_t* e;
+
+    if (!ota_running) {
+        return false;
+    }
+    e = ota_find(short_addr);
+    if (!e && ota_open) {
+        e = ota_add(short_addr, ota_now_ms());
+    }
+    if (!e || e->state == GW_OTA_DEV_FAILED) {
+        return false;
+    }
+    /* A device turned down now is notified once a slot frees up */
+    return e->state == GW_OTA_DEV_ACTIVE || ota_active < ota_cfg.max_active;
+}
+
+bool gw_ota_sched_frame(zb_uint8_t param) {
+    zb_zcl_parsed_hdr_t* cmd_info = ZB_BUF_GET_PARAM(param, zb_zcl_parsed_hdr_t);
+    uint16_t short_addr;
+    uint8_t ep;
+    uint16_t period;
+    uint32_t now;
+    gw_ota_dev_t* e;
+
+    if (cmd_info->addr_data.common_data.source.addr_type != 0
+        || cmd_info->cmd_direction != ZB_ZCL_FRAME_DIRECTION_TO_SRV) {
+        return false;
+    }
+    short_addr = ZB_ZCL_PARSED_HDR_SHORT_DATA(cmd_info).source.u.short_addr;
+    ep = ZB_ZCL_PARSED_HDR_SHORT_DATA(cmd_info).src_endpoint;
+    e = ota_find(short_addr);
+    if (e) {
+        e->ep = ep;
+    }
+    if (cmd_info->cmd_id != ZB_ZCL_CMD_OTA_UPGRADE_IMAGE_BLOCK_ID || !ota_image) {
+        return false;
+    }
+
+    do {
+        if (!e || e->state == GW_OTA_DEV_FAILED) {
+            /* campaign stopped or given up */
+            ota_block_rsp(short_addr, ep, cmd_info->seq_number, ZB_ZCL_STATUS_ABORT, 0, 0);
+            break;
+        }
+
+        now = ota_now_ms();
+        if (e->state != GW_OTA_DEV_ACTIVE) {
+            if (ota_active >= ota_cfg.max_active) {
+                ota_block_rsp(short_addr, ep, cmd_info->seq_number, ZB_ZCL_STATUS_WAIT_FOR_DATA,
+                              GW_OTA_SCHED_RETRY_S, ota_period());
+                break;
+            }
+            ota_active++;
+            e->state = GW_OTA_DEV_ACTIVE;
+            e->percent = 0;
+            e->period_ms = 0;
+            e->last_ms = now;
+            e->next_ms = now;
+        }
+
+        period = ota_period();
+        if (period > e->period_ms + e->period_ms / 4 || period < e->period_ms / 2) {
+            /* Share changed by a large step, hand over the new period */
+            e->period_ms = period;
+            e->next_ms = now;
+            ota_block_rsp(short_addr, ep, cmd_info->seq_number, ZB_ZCL_STATUS_WAIT_FOR_DATA, 0, period);
+            break;
+        }
+        if ((int32_t)(e->next_ms - now) > period / 4) {
+            ota_block_rsp(short_addr, ep, cmd_info->seq_number, ZB_ZCL_STATUS_WAIT_FOR_DATA,
+                          (e->next_ms - now + 999) / 1000, period);
+            break;
+        }
+        e->next_ms = now + period;
+        e->last_ms = now;
+        return false;
+    } while (0);
+
+    zb_buf_free(param);
+    return true;
+}
+
+void gw_ota_sched_block_sent(uint16_t short_addr, uint32_t offset) {
+    gw_ota_dev_t* e = ota_find(short_addr);
+    uint32_t percent;
+
+    if (!e || e->state != GW_OTA_DEV_ACTIVE) {
+        return;
+    }
+    ota_stats.blocks++;
+    e->offset = offset;
+    e->last_ms = ota_now_ms();
+
+    percent = ota_image_size ? offset * 100 / ota_image_size : 0;
+    if (percent > 100) {
+        percent = 100;
+    }
+    if (percent >= e->percent + GW_OTA_SCHED_PROGRESS_STEP * 1U) {
+        e->percent = percent;
+        ota_report(short_addr, GW_OTA_STATUS_PROGRESS, percent);
+    }
+}
+
+void gw_ota_sched_end(uint16_t short_addr, uint8_t status) {
+    gw_ota_dev_t* e = ota_find(short_addr);
+
+    if (status == GW_OTA_STATUS_FINISHED) {
+        if (e) {
+            if (e->state == GW_OTA_DEV_ACTIVE) {
+                ota_active--;
+            }
+            e->state = GW_OTA_DEV_DONE;
+            e->percent = 100;
+        }
+        ota_report(short_addr, status, 100);
+    } else if (e) {
+        ota_fail(e, status);
+    } else {
+        ota_report(short_addr, status, 0xFF);
+    }
+}
+
+void gw_ota_sched_remove_device(uint16_t short_addr) {
+    gw_ota_dev_t* e = ota_find(short_addr);
+
+    if (e && e->state == GW_OTA_DEV_ACTIVE) {
+        ota_fail(e, GW_OTA_STATUS_STALLED);
+    }
+}
+
+const uint8_t* gw_ota_sched_data(uint32_t offset, uint8_t size) {
+    uint32_t tag = offset & ~(GW_OTA_SCHED_CACHE_LINE_SIZE - 1);
+    uint32_t len;
+    uint8_t i, victim = 0;
+
+    if (offset - tag + size > GW_OTA_SCHED_CACHE_LINE_SIZE || tag >= ota_image_size) {
+        return ota_image + offset;
+    }
+    for (i = 0; i < GW_OTA_SCHED_CACHE_LINES; i++) {
+        if (ota_cache_tag[i] == tag) {
+            ota_cache_used[i] = ++ota_cache_clock;
+            ota_stats.cache_hits++;
+            return &ota_cache[i][offset - tag];
+        }
+        if (ota_cache_used[i] < ota_cache_used[victim]) {
+            victim = i;
+        }
+    }
+
+    len = ota_image_size - tag;
+    if (len > GW_OTA_SCHED_CACHE_LINE_SIZE) {
+        len = GW_OTA_SCHED_CACHE_LINE_SIZE;
+    }
+    memcpy(ota_cache[victim], ota_image + tag, len);
+    ota_cache_tag[victim] = tag;
+    ota_cache_used[victim] = ++ota_cache_clock;
+    ota_stats.cache_misses++;
+    return &ota_cache[victim][offset - tag];
+}
+
+uint16_t gw_ota_sched_count(void) { return ota_count; }
+
+const gw_ota_dev_t* gw_ota_sched_get(uint16_t idx) {
+    return (idx < ota_count) ? &ota_devs[idx] : NULL;
+}
+
+void gw_ota_sched_stats_get(gw_ota_sched_stats_t* stats) {
+    uint16_t i;
+
+    *stats = ota_stats;
+    stats->pending = stats->active = stats->done = stats->failed = 0;
+    for (i = 0; i < ota_count; i++) {
+        switch (ota_devs[i].state) {
+            case GW_OTA_DEV_PENDING: stats->pending++; break;
+            case GW_OTA_DEV_ACTIVE: stats->active++; break;
+            case GW_OTA_DEV_DONE: stats->done++; break;
+            default: stats->failed++; break;
+        }
+    }
+}
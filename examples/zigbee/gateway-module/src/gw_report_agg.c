@@ -0,0 +1,489 @@
+/**
+ * @file gw_report_agg.c
+ * @brief Attribute report aggregation, see gw_report_agg.h
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+//=============================================================================
+//                Include
+//=============================================================================
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "zb_common.h"
+#include "zboss_api.h"
+
+#include "gw_report_agg.h"
+#include "zigbee_cmd_app.h"
+#include "zigbee_zcl_msg_handler.h"
+
+//=============================================================================
+//                Private Definitions
+//=============================================================================
+#define AGG_MASK            (GW_REPORT_AGG_ENTRY_MAX - 1)
+/* Keep the probe sequences short, evict beyond 3/4 load */
+#define AGG_LOAD_MAX        (GW_REPORT_AGG_ENTRY_MAX * 3 / 4)
+#define AGG_VALUE_MAX       8
+#define AGG_REPORT_CMD      0x00028800
+#define AGG_DUE_DONE        0xFFFF
+
+#if (GW_REPORT_AGG_ENTRY_MAX & AGG_MASK)
+#error "GW_REPORT_AGG_ENTRY_MAX must be a power of two"
+#endif
+
+typedef struct {
+    uint16_t addr;
+    uint16_t cluster;
+    uint16_t attr;
+    uint8_t ep;
+    uint8_t type;
+    uint8_t len;
+    uint8_t used  : 1;
+    uint8_t sent  : 1; /* value holds what the host has */
+    uint8_t dirty : 1; /* pending waits for the flush */
+    uint8_t value[AGG_VALUE_MAX];
+    uint8_t pending[AGG_VALUE_MAX];
+    uint32_t last_ms;
+    uint32_t seen_ms; /* last report of the attribute, for the eviction */
+} agg_entry_t;
+
+//=============================================================================
+//                Private Global Variables
+//=============================================================================
+/* Alarms and user actions go to the host as they arrive */
+static const uint16_t agg_bypass[] = {
+    ZB_ZCL_CLUSTER_ID_ON_OFF,
+    ZB_ZCL_CLUSTER_ID_ALARMS,
+    ZB_ZCL_CLUSTER_ID_DOOR_LOCK,
+    ZB_ZCL_CLUSTER_ID_OCCUPANCY_SENSING,
+    ZB_ZCL_CLUSTER_ID_IAS_ZONE,
+    ZB_ZCL_CLUSTER_ID_IAS_ACE,
+    ZB_ZCL_CLUSTER_ID_IAS_WD,
+};
+
+static const gw_report_agg_policy_t agg_initial_policy[] = {
+    {ZB_ZCL_CLUSTER_ID_ILLUMINANCE_MEASUREMENT, 2000, 300000, 100},
+    {ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, 1000, 300000, 10},
+    {ZB_ZCL_CLUSTER_ID_PRESSURE_MEASUREMENT, 1000, 300000, 1},
+    {ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT, 1000, 300000, 50},
+    {ZB_ZCL_CLUSTER_ID_METERING, 5000, 300000, 0},
+    {ZB_ZCL_CLUSTER_ID_ELECTRICAL_MEASUREMENT, 2000, 300000, 0},
+};
+
+static agg_entry_t agg_table[GW_REPORT_AGG_ENTRY_MAX];
+static uint16_t agg_count;
+static gw_report_agg_policy_t agg_policy[GW_REPORT_AGG_POLICY_MAX];
+static uint8_t agg_policy_num;
+static gw_report_agg_stats_t agg_stats;
+static bool agg_flush_scheduled;
+
+//=============================================================================
+//                Private Function
+//=============================================================================
+static uint32_t agg_now_ms(void) {
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+static bool agg_is_bypass(uint16_t cluster) {
+    uint8_t i;
+
+    for (i = 0; i < sizeof(agg_bypass) / sizeof(agg_bypass[0]); i++) {
+        if (agg_bypass[i] == cluster) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static const gw_report_agg_policy_t* agg_policy_find(uint16_t cluster) {
+    uint8_t i;
+
+    for (i = 0; i < agg_policy_num; i++) {
+        if (agg_policy[i].cluster == cluster) {
+            return &agg_policy[i];
+        }
+    }
+    return NULL;
+}
+
+static uint32_t agg_hash(uint16_t addr, uint8_t ep, uint16_t cluster, uint16_t attr) {
+    uint64_t key = ((uint64_t)addr << 40) | ((uint64_t)ep << 32)
+                   | ((uint32_t)cluster << 16) | attr;
+
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & AGG_MASK;
+}
+
+static void agg_erase(uint32_t hole);
+
+/* The clean entry reported least recently makes room; held values and
+ * entries of the report being taken stay */
+static bool agg_evict(uint32_t now) {
+    uint32_t i, victim = GW_REPORT_AGG_ENTRY_MAX, age, oldest = 0;
+    agg_entry_t* e;
+
+    for (i = 0; i < GW_REPORT_AGG_ENTRY_MAX; i++) {
+        e = &agg_table[i];
+        if (!e->used || e->dirty) {
+            continue;
+        }
+        age = now - e->seen_ms;
+        if (age > oldest) {
+            oldest = age;
+            victim = i;
+        }
+    }
+    if (victim == GW_REPORT_AGG_ENTRY_MAX) {
+        return false;
+    }
+    agg_erase(victim);
+    agg_stats.evicted++;
+    return true;
+}
+
+static agg_entry_t* agg_lookup(uint16_t addr, uint8_t ep, uint16_t cluster,
+                               uint16_t attr, bool create) {
+    uint32_t slot = agg_hash(addr, ep, cluster, attr);
+    uint32_t now;
+    agg_entry_t* e;
+
+    while (agg_table[slot].used) {
+        e = &agg_table[slot];
+        if (e->addr == addr && e->attr == attr && e->cluster == cluster && e->ep == ep) {
+            return e;
+        }
+        slot = (slot + 1) & AGG_MASK;
+    }
+    if (!create) {
+        return NULL;
+    }
+    now = agg_now_ms();
+    if (agg_count >= AGG_LOAD_MAX) {
+        if (!agg_evict(now)) {
+            return NULL;
+        }
+        /* The shift may have ended the probe sequence earlier */
+        slot = agg_hash(addr, ep, cluster, attr);
+        while (agg_table[slot].used) {
+            slot = (slot + 1) & AGG_MASK;
+        }
+    }
+    e = &agg_table[slot];
+    memset(e, 0, sizeof(agg_entry_t));
+    e->used = 1;
+    e->addr = addr;
+    e->ep = ep;
+    e->cluster = cluster;
+    e->attr = attr;
+    e->seen_ms = now;
+    agg_count++;
+    return e;
+}
+
+/* Backward shift deletion, no tombstones are left in the probe sequences */
+static void agg_erase(uint32_t hole) {
+    uint32_t slot = hole, home;
+    agg_entry_t* e;
+
+    for (;;) {
+        slot = (slot + 1) & AGG_MASK;
+        e = &agg_table[slot];
+        if (!e->used) {
+            break;
+        }
+        home = agg_hash(e->addr, e->ep, e->cluster, e->attr);
+        if (((slot - home) & AGG_MASK) >= ((slot - hole) & AGG_MASK)) {
+            agg_table[hole] = *e;
+            hole = slot;
+        }
+    }
+    agg_table[hole].used = 0;
+    agg_count--;
+}
+
+static bool agg_is_integer(uint8_t type) {
+    return type >= ZB_ZCL_ATTR_TYPE_U8 && type <= ZB_ZCL_ATTR_TYPE_S64;
+}
+
+static int64_t agg_decode(uint8_t type, const uint8_t* p, uint8_t len) {
+    uint64_t v = 0;
+    uint8_t i;
+
+    for (i = 0; i < len; i++) {
+        v |= (uint64_t)p[i] << (8 * i);
+    }
+    if (type >= ZB_ZCL_ATTR_TYPE_S8 && len < 8 && (v >> (8 * len - 1)) & 1) {
+        v |= ~0ULL << (8 * len);
+    }
+    return (int64_t)v;
+}
+
+static bool agg_below_delta(const agg_entry_t* e, const uint8_t* value, uint32_t delta) {
+    int64_t diff;
+
+    /* 64-bit values may overflow the difference, they compare for equality only */
+    if (delta == 0 || !agg_is_integer(e->type) || e->len == AGG_VALUE_MAX) {
+        return false;
+    }
+    diff = agg_decode(e->type, value, e->len) - agg_decode(e->type, e->value, e->len);
+    return diff < (int64_t)delta && diff > -(int64_t)delta;
+}
+
+static void agg_update(agg_entry_t* e, const gw_report_agg_policy_t* policy,
+                       uint8_t type, const uint8_t* value, uint8_t len, uint32_t now) {
+    if (e->type != type || e->len != len) {
+        e->type = type;
+        e->len = len;
+        e->sent = 0;
+        e->dirty = 0;
+    }
+
+    if (e->sent && memcmp(e->value, value, len) == 0) {
+        if (!e->dirty && policy->max_interval_ms != 0
+            && now - e->last_ms >= policy->max_interval_ms) {
+            memcpy(e->pending, value, len);
+            e->dirty = 1;
+            return;
+        }
+        /* A held change that went back to the sent value is dropped too */
+        e->dirty = 0;
+        agg_stats.suppressed_equal++;
+        return;
+    }
+    if (e->sent && agg_below_delta(e, value, policy->delta)) {
+        e->dirty = 0;
+        agg_stats.suppressed_delta++;
+        return;
+    }
+    if (e->dirty) {
+        agg_stats.coalesced++;
+    }
+    memcpy(e->pending, value, len);
+    e->dirty = 1;
+}
+
+static void agg_mark_sent(agg_entry_t* e, uint8_t type, const uint8_t* value,
+                          uint8_t len, uint32_t now) {
+    e->type = type;
+    e->len = len;
+    memcpy(e->value, value, len);
+    e->sent = 1;
+    e->dirty = 0;
+    e->last_ms = now;
+}
+
+static void agg_flush(zb_uint8_t param);
+
+/* One report frame; its values count as sent only when the frame went out,
+ * otherwise they stay held for the next flush */
+static bool agg_send(const agg_entry_t* head, uint8_t* buf, uint16_t buf_len,
+                     const uint16_t* group, uint16_t group_num, uint32_t now) {
+    agg_entry_t* e;
+    uint16_t i;
+
+    if (zigbee_gw_cmd_send_prefixed(AGG_REPORT_CMD, head->addr, 0, head->ep,
+                                    (uint8_t*)&head->cluster, sizeof(uint16_t),
+                                    buf, buf_len)
+        != 0) {
+        agg_stats.send_failed++;
+        return false;
+    }
+    for (i = 0; i < group_num; i++) {
+        e = &agg_table[group[i]];
+        agg_mark_sent(e, e->type, e->pending, e->len, now);
+    }
+    agg_stats.forwarded += group_num;
+    agg_stats.frames++;
+    return true;
+}
+
+static void agg_flush_schedule(void) {
+    if (!agg_flush_scheduled) {
+        agg_flush_scheduled = true;
+        ZB_SCHEDULE_APP_ALARM(agg_flush, 0,
+                              ZB_MILLISECONDS_TO_BEACON_INTERVAL(GW_REPORT_AGG_FLUSH_MS));
+    }
+}
+
+static void agg_flush(zb_uint8_t param) {
+    static uint16_t due[AGG_LOAD_MAX];
+    uint8_t buf[ZIGBEE_GW_CMD_PARAM_MAX - sizeof(uint16_t)];
+    /* a record takes 4 bytes at least */
+    uint16_t group[sizeof(buf) / 4];
+    const gw_report_agg_policy_t* policy;
+    uint16_t due_num = 0, group_num, i, j, buf_len;
+    uint32_t now = agg_now_ms();
+    bool pending = false;
+    agg_entry_t *e, *head;
+
+    (void)param;
+    agg_flush_scheduled = false;
+
+    for (i = 0; i < GW_REPORT_AGG_ENTRY_MAX; i++) {
+        e = &agg_table[i];
+        if (!e->used || !e->dirty) {
+            continue;
+        }
+        /* A policy removed meanwhile flushes at once */
+        policy = agg_policy_find(e->cluster);
+        if (!e->sent || !policy || now - e->last_ms >= policy->min_interval_ms) {
+            due[due_num++] = i;
+        } else {
+            pending = true;
+        }
+    }
+
+    /* One frame per device endpoint and cluster, split only when full */
+    for (i = 0; i < due_num; i++) {
+        if (due[i] == AGG_DUE_DONE) {
+            continue;
+        }
+        head = &agg_table[due[i]];
+        buf_len = 0;
+        group_num = 0;
+        for (j = i; j < due_num; j++) {
+            if (due[j] == AGG_DUE_DONE) {
+                continue;
+            }
+            e = &agg_table[due[j]];
+            if (e->addr != head->addr || e->ep != head->ep || e->cluster != head->cluster) {
+                continue;
+            }
+            if (buf_len + 3U + e->len > sizeof(buf)) {
+                pending |= !agg_send(head, buf, buf_len, group, group_num, now);
+                buf_len = 0;
+                group_num = 0;
+            }
+            buf[buf_len++] = e->attr & 0xFF;
+            buf[buf_len++] = e->attr >> 8;
+            buf[buf_len++] = e->type;
+            memcpy(&buf[buf_len], e->pending, e->len);
+            buf_len += e->len;
+            group[group_num++] = due[j];
+            due[j] = AGG_DUE_DONE;
+        }
+        pending |= !agg_send(head, buf, buf_len, group, group_num, now);
+    }
+
+    if (pending) {
+        agg_flush_schedule();
+    }
+}
+
+//=============================================================================
+//                Public Function
+//=============================================================================
+void gw_report_agg_init(void) {
+    memset(agg_table, 0, sizeof(agg_table));
+    agg_count = 0;
+    memcpy(agg_policy, agg_initial_policy, sizeof(agg_initial_policy));
+    agg_policy_num = sizeof(agg_initial_policy) / sizeof(agg_initial_policy[0]);
+    memset(&agg_stats, 0, sizeof(agg_stats));
+}
+
+bool gw_report_agg_input(uint16_t cluster, uint16_t addr, uint8_t ep,
+                         const uint8_t* pdata, uint16_t len) {
+    const gw_report_agg_policy_t* policy;
+    uint16_t i, attr_len;
+    bool cacheable = true;
+    uint32_t now;
+    agg_entry_t* e;
+
+    /* Caching is opt-in: clusters without a policy go out as they are */
+    policy = agg_policy_find(cluster);
+    if (policy == NULL || agg_is_bypass(cluster)) {
+        agg_stats.bypassed++;
+        return false;
+    }
+
+    /* A malformed report goes out as it is, before any entry is taken */
+    for (i = 0; i < len; i += 3 + attr_len) {
+        attr_len = (i + 3 <= len) ? zigbee_zcl_attr_size(pdata[i + 2], pdata + i + 3, len - (i + 3)) : 0;
+        if (attr_len == 0) {
+            return false;
+        }
+    }
+
+    /* Every record needs a short value and a cache entry, otherwise the
+     * report goes out as it is. The entries touched here are not evicted
+     * for the next record. */
+    now = agg_now_ms();
+    for (i = 0; i < len; i += 3 + attr_len) {
+        attr_len = zigbee_zcl_attr_size(pdata[i + 2], pdata + i + 3, len - (i + 3));
+        e = (attr_len <= AGG_VALUE_MAX)
+                ? agg_lookup(addr, ep, cluster, pdata[i] | (pdata[i + 1] << 8), true)
+                : NULL;
+        if (e == NULL) {
+            cacheable = false;
+        } else {
+            e->seen_ms = now;
+        }
+        agg_stats.received++;
+    }
+
+    for (i = 0; i < len; i += 3 + attr_len) {
+        attr_len = zigbee_zcl_attr_size(pdata[i + 2], pdata + i + 3, len - (i + 3));
+        e = agg_lookup(addr, ep, cluster, pdata[i] | (pdata[i + 1] << 8), false);
+        if (e == NULL || attr_len > AGG_VALUE_MAX) {
+            continue;
+        }
+        if (cacheable) {
+            agg_update(e, policy, pdata[i + 2], pdata + i + 3, attr_len, now);
+        } else {
+            agg_mark_sent(e, pdata[i + 2], pdata + i + 3, attr_len, now);
+            agg_stats.forwarded++;
+        }
+    }
+
+    if (!cacheable) {
+        agg_stats.uncached++;
+        return false;
+    }
+    agg_flush_schedule();
+    return true;
+}
+
+void gw_report_agg_remove_device(uint16_t addr) {
+    uint32_t i;
+
+    for (i = 0; i < GW_REPORT_AGG_ENTRY_MAX; i++) {
+        /* The shift may pull another entry of this device into the slot */
+        while (agg_table[i].used && agg_table[i].addr == addr) {
+            agg_erase(i);
+        }
+    }
+}
+
+bool gw_report_agg_policy_set(const gw_report_agg_policy_t* policy) {
+    uint8_t i;
+
+    for (i = 0; i < agg_policy_num; i++) {
+        if (agg_policy[i].cluster == policy->cluster) {
+            agg_policy[i] = *policy;
+            return true;
+        }
+    }
+    if (agg_policy_num >= GW_REPORT_AGG_POLICY_MAX) {
+        return false;
+    }
+    agg_policy[agg_policy_num++] = *policy;
+    return true;
+}
+
+bool gw_report_agg_policy_get(uint16_t cluster, gw_report_agg_policy_t* policy) {
+    const gw_report_agg_policy_t* found = agg_policy_find(cluster);
+
+    if (found == NULL) {
+        return false;
+    }
+    *policy = *found;
+    return true;
+}
+
+void gw_report_agg_stats_get(gw_report_agg_stats_t* stats) { *stats = agg_stats; }
+
+void gw_report_agg_stats_reset(void) { memset(&agg_stats, 0, sizeof(agg_stats)); }
@@ -0,0 +1,161 @@
+/**
+ * @file gw_zcl_record.c
+ * @brief Attribute record walking of ZCL general commands, see gw_zcl_record.h
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+//=============================================================================
+//                Include
+//=============================================================================
+#include "zboss_api.h"
+
+#include "gw_zcl_record.h"
+
+//=============================================================================
+//                Private Definitions
+//=============================================================================
+/* Fixed value size per ZCL data type, 0 for unknown types */
+#define ZCL_ATTR_SIZE_STR8      0xFF /* one byte length prefix */
+#define ZCL_ATTR_SIZE_STR16     0xFE /* two byte length prefix */
+
+static const uint8_t zcl_attr_size[256] = {
+    [ZB_ZCL_ATTR_TYPE_8BIT] = 1,
+    [ZB_ZCL_ATTR_TYPE_U8] = 1,
+    [ZB_ZCL_ATTR_TYPE_S8] = 1,
+    [ZB_ZCL_ATTR_TYPE_BOOL] = 1,
+    [ZB_ZCL_ATTR_TYPE_8BITMAP] = 1,
+    [ZB_ZCL_ATTR_TYPE_8BIT_ENUM] = 1,
+
+    [ZB_ZCL_ATTR_TYPE_16BIT] = 2,
+    [ZB_ZCL_ATTR_TYPE_U16] = 2,
+    [ZB_ZCL_ATTR_TYPE_S16] = 2,
+    [ZB_ZCL_ATTR_TYPE_16BITMAP] = 2,
+    [ZB_ZCL_ATTR_TYPE_16BIT_ENUM] = 2,
+    [ZB_ZCL_ATTR_TYPE_SEMI] = 2,
+    [ZB_ZCL_ATTR_TYPE_CLUSTER_ID] = 2,
+    [ZB_ZCL_ATTR_TYPE_ATTRIBUTE_ID] = 2,
+
+    [ZB_ZCL_ATTR_TYPE_S24] = 3,
+    [ZB_ZCL_ATTR_TYPE_U24] = 3,
+    [ZB_ZCL_ATTR_TYPE_24BIT] = 3,
+    [ZB_ZCL_ATTR_TYPE_24BITMAP] = 3,
+
+    [ZB_ZCL_ATTR_TYPE_32BIT] = 4,
+    [ZB_ZCL_ATTR_TYPE_U32] = 4,
+    [ZB_ZCL_ATTR_TYPE_S32] = 4,
+    [ZB_ZCL_ATTR_TYPE_32BITMAP] = 4,
+    [ZB_ZCL_ATTR_TYPE_UTC_TIME] = 4,
+    [ZB_ZCL_ATTR_TYPE_TIME_OF_DAY] = 4,
+    [ZB_ZCL_ATTR_TYPE_DATE] = 4,
+    [ZB_ZCL_ATTR_TYPE_BACNET_OID] = 4,
+    [ZB_ZCL_ATTR_TYPE_SINGLE] = 4,
+
+    [ZB_ZCL_ATTR_TYPE_U40] = 5,
+    [ZB_ZCL_ATTR_TYPE_S40] = 5,
+    [ZB_ZCL_ATTR_TYPE_40BIT] = 5,
+    [ZB_ZCL_ATTR_TYPE_40BITMAP] = 5,
+
+    [ZB_ZCL_ATTR_TYPE_S48] = 6,
+    [ZB_ZCL_ATTR_TYPE_U48] = 6,
+    [ZB_ZCL_ATTR_TYPE_48BIT] = 6,
+    [ZB_ZCL_ATTR_TYPE_48BITMAP] = 6,
+
+    [ZB_ZCL_ATTR_TYPE_U56] = 7,
+    [ZB_ZCL_ATTR_TYPE_S56] = 7,
+    [ZB_ZCL_ATTR_TYPE_56BIT] = 7,
+    [ZB_ZCL_ATTR_TYPE_56BITMAP] = 7,
+
+    [ZB_ZCL_ATTR_TYPE_64BIT] = 8,
+    [ZB_ZCL_ATTR_TYPE_64BITMAP] = 8,
+    [ZB_ZCL_ATTR_TYPE_U64] = 8,
+    [ZB_ZCL_ATTR_TYPE_S64] = 8,
+    [ZB_ZCL_ATTR_TYPE_DOUBLE] = 8,
+    [ZB_ZCL_ATTR_TYPE_IEEE_ADDR] = 8,
+
+    [ZB_ZCL_ATTR_TYPE_128_BIT_KEY] = 16,
+
+    [ZB_ZCL_ATTR_TYPE_OCTET_STRING] = ZCL_ATTR_SIZE_STR8,
+    [ZB_ZCL_ATTR_TYPE_CHAR_STRING] = ZCL_ATTR_SIZE_STR8,
+    [ZB_ZCL_ATTR_TYPE_ARRAY] = ZCL_ATTR_SIZE_STR16,
+    [ZB_ZCL_ATTR_TYPE_CUSTOM_32ARRAY] = ZCL_ATTR_SIZE_STR16,
+    [ZB_ZCL_ATTR_TYPE_LONG_OCTET_STRING] = ZCL_ATTR_SIZE_STR16,
+};
+
+//=============================================================================
+//                Public Function
+//=============================================================================
+uint16_t zigbee_zcl_attr_size(uint8_t attr_type, const uint8_t* data,
+                              uint16_t avail) {
+    uint16_t ret = zcl_attr_size[attr_type];
+
+    if (ret == ZCL_ATTR_SIZE_STR8) {
+        ret = (avail < 1) ? 0 : (data[0] == 0xFF) ? 1 : data[0] + 1;
+    } else if (ret == ZCL_ATTR_SIZE_STR16) {
+        ret = (avail < 2) ? 0
+              : (data[0] == 0xFF && data[1] == 0xFF)
+                  ? 2
+                  : (data[0] | (data[1] << 8)) + 2;
+    }
+    return (ret <= avail) ? ret : 0;
+}
+
+uint16_t gw_zcl_record_size(uint8_t zcl_cmd, const uint8_t* rec,
+                            uint16_t avail) {
+    uint16_t attr_len;
+
+    if (zcl_cmd == ZB_ZCL_CMD_READ_ATTRIB_RESP) {
+        /* attribute id, status, then type and value on success only */
+        if (avail < 3) {
+            return 0;
+        }
+        if (rec[2] != ZB_ZCL_STATUS_SUCCESS) {
+            return 3;
+        }
+        rec++;
+        avail--;
+    } else if (zcl_cmd != ZB_ZCL_CMD_REPORT_ATTRIB) {
+        return 0;
+    }
+
+    /* attribute id, type, value */
+    if (avail < 3) {
+        return 0;
+    }
+    attr_len = zigbee_zcl_attr_size(rec[2], rec + 3, avail - 3);
+    if (attr_len == 0) {
+        return 0;
+    }
+    return 3 + attr_len + (zcl_cmd == ZB_ZCL_CMD_READ_ATTRIB_RESP);
+}
+
+int gw_zcl_record_split(uint8_t zcl_cmd, const uint8_t* data, uint16_t len,
+                        uint16_t max, gw_zcl_record_chunk_cb cb, void* arg) {
+    uint16_t start = 0, i = 0, rec_len;
+    int ret = 0;
+
+    if (len <= max) {
+        return cb(data, len, arg) ? -1 : 0;
+    }
+
+    while (i < len) {
+        rec_len = gw_zcl_record_size(zcl_cmd, data + i, len - i);
+        if (rec_len == 0 || rec_len > max) {
+            ret = -1;
+            break;
+        }
+        if (i + rec_len - start > max) {
+            if (cb(data + start, i - start, arg)) {
+                return -1;
+            }
+            start = i;
+        }
+        i += rec_len;
+    }
+    if (i > start && cb(data + start, i - start, arg)) {
+        return -1;
+    }
+    return ret;
+}
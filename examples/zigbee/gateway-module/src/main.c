@@ -5,7 +5,10 @@
 #include "zigbee_platform.h"
 #include "zigbee_zcl_msg_handler.h"
 #include "zigbee_cmd_ota.h"
+#include "zigbee_cmd_nwk.h"
 #include "zigbee_api.h"
+#include "gw_report_agg.h"
+#include "gw_ota_sched.h"
 
 #include "hosal_rf.h"
 #include "hosal_uart.h"
@@ -46,6 +49,9 @@ int main(void) {
     cli_init();
     zigbee_app_init();
     zbStart();
+#if (configUSE_RTOS_MONITOR == 1)
+    rtos_monitor_init(RTOS_MONITOR_PERIOD_MS, zigbee_sys_monitor_sampled);
+#endif
     vTaskStartScheduler();
     while(1) {;}
 }
@@ -64,12 +70,20 @@ void app_main_loop(void* parameters_ptr) {
         }
 
         zb_zdo_register_device_annce_cb(dev_annce_cb);
+        gw_report_agg_init();
+        gw_ota_sched_init();
     )
     start_gw_timer();
 
     for (;;) {
         if (ulTaskNotifyTake(pdFALSE, portMAX_DELAY) != 0) {
             ZIGBEE_APP_GET_NOTIFY(sevent);
+#if (configUSE_RTOS_MONITOR == 1)
+            if (sevent & ZB_APP_EVENT_SYS_MONITOR) {
+                ZB_THREAD_SAFE(zigbee_sys_monitor_send();)
+                sevent &= ~ZB_APP_EVENT_SYS_MONITOR;
+            }
+#endif
             switch (sevent) {
                 case ZB_APP_EVENT_JOINED: {
                     log_info("Gateway Started");
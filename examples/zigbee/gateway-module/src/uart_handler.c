@@ -97,8 +97,11 @@ static uint8_t g_uart_buffer[MAX_UART_BUFFER_SIZE];
 //                Functions
 //=============================================================================
 
+/* runs in the UART interrupt handler */
 static int uart_handler_rx_cb(void* p_arg) {
     uint32_t len = 0;
+
+    RTOS_TRACE_ISR_ENTER(Uart1_IRQn);
     if (g_uart_rx_io.start >= g_uart_rx_io.end) {
         g_uart_rx_io.start += hosal_uart_receive(
             p_arg, g_uart_rx_io.uart_cache + g_uart_rx_io.start,
@@ -125,6 +128,7 @@ static int uart_handler_rx_cb(void* p_arg) {
             g_uart_rx_io.recvLen = len;
         }
     }
+    RTOS_TRACE_ISR_EXIT(Uart1_IRQn);
     return 0;
 }
 
@@ -27,6 +27,9 @@
 #include "zigbee_cmd_nwk.h"
 #include "zigbee_cmd_app.h"
 #include "zigbee_cmd_ota.h"
+#include "gw_report_agg.h"
+#include "gw_dev_dir.h"
+#include "gw_ota_sched.h"
 #include "zigbee_zcl_msg_handler.h"
 
 //=============================================================================
@@ -86,6 +89,66 @@ void zigbee_app_read_otp_mac_addr(uint8_t* addr) {
     memcpy(addr, temp + 8, 8);
 }
 
+static uint32_t dev_dir_now_ms(void) {
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+/* Bring one device in line with the stack address table */
+static void dev_dir_sync(uint16_t short_addr) {
+    zb_ieee_addr_t ieee_addr;
+
+    if (zb_address_ieee_by_short(short_addr, ieee_addr) == RET_OK) {
+        gw_dev_dir_sync(ieee_addr, short_addr, dev_dir_now_ms());
+    }
+}
+
+/* The directory lives in RAM, after a reboot it is seeded once from the
+ * address table the stack restored. From then on announces and leaves
+ * update their own record, and a frame from a short address the directory
+ * does not know syncs that device only */
+static void dev_dir_load(void) {
+    zb_address_map_t* ent;
+    zb_ushort_t i;
+
+    for (i = 0; i < ZB_IEEE_ADDR_TABLE_SIZE; i++) {
+        ent = &ZG->addr.addr_map[i];
+        if (ZB_U2B(ent->used) && ent->lock_cnt > 0 && !ent->pending_for_delete
+            && ent->redirect_type == ZB_ADDR_REDIRECT_NONE && ent->addr != 0x0000) {
+            dev_dir_sync(ent->addr);
+        }
+    }
+    log_info("device directory %d entries", gw_dev_dir_count());
+}
+
+void zigbee_app_dev_dir_seen(uint16_t short_addr) {
+    zb_uint8_t lqi = 0;
+    zb_int8_t rssi = 0;
+
+    /* a device whose announce was missed */
+    if (gw_dev_dir_find_short(short_addr) == NULL) {
+        dev_dir_sync(short_addr);
+    }
+    zb_zdo_get_diag_data(short_addr, &lqi, &rssi);
+    gw_dev_dir_seen(short_addr, lqi, rssi, dev_dir_now_ms());
+}
+
+void zigbee_app_dev_dir_desc_update(uint16_t short_addr, zb_af_simple_desc_1_1_t* simple_desc) {
+    gw_dev_desc_t desc;
+    uint8_t count = simple_desc->app_input_cluster_count + simple_desc->app_output_cluster_count;
+
+    if (count > GW_DEV_DIR_CLUSTER_MAX) {
+        return;
+    }
+    desc.endpoint = simple_desc->endpoint;
+    desc.profile_id = simple_desc->app_profile_id;
+    desc.device_id = simple_desc->app_device_id;
+    desc.device_version = simple_desc->app_device_version;
+    desc.in_count = simple_desc->app_input_cluster_count;
+    desc.out_count = simple_desc->app_output_cluster_count;
+    memcpy(desc.clusters, simple_desc->app_cluster_list, count * sizeof(uint16_t));
+    gw_dev_dir_set_desc(short_addr, &desc);
+}
+
 void zboss_signal_handler(zb_uint8_t param) {
     zb_zdo_app_signal_hdr_t* sg_p = NULL;
     zb_zdo_app_signal_t sig = zb_get_app_signal(param, &sg_p);
@@ -112,7 +175,10 @@ void zboss_signal_handler(zb_uint8_t param) {
             } break;
 
             case ZB_NLME_STATUS_INDICATION: {
-
+                zb_zdo_signal_nlme_status_indication_params_t* nlme_params = ZB_ZDO_SIGNAL_GET_PARAMS(sg_p, zb_zdo_signal_nlme_status_indication_params_t);
+                if (nlme_params->nlme_status.status == ZB_NWK_COMMAND_STATUS_ADDRESS_CONFLICT) {
+                    gw_dev_dir_addr_conflict(nlme_params->nlme_status.network_addr);
+                }
             } break;
             case ZB_ZDO_SIGNAL_PERMIT_JOIN: {
                 zb_zdo_signal_permit_join_params_t* request =
@@ -126,8 +192,14 @@ void zboss_signal_handler(zb_uint8_t param) {
             case ZB_ZDO_SIGNAL_LEAVE_INDICATION: {
                 zb_zdo_signal_leave_indication_params_t* ind_params = ZB_ZDO_SIGNAL_GET_PARAMS(sg_p, zb_zdo_signal_leave_indication_params_t);
                 if(ind_params->rejoin == 0) {
-                    uint16_t short_addr = zb_address_short_by_ieee(ind_params->device_addr);
+                    gw_dev_t* dev = gw_dev_dir_find_ieee(ind_params->device_addr);
+                    uint16_t short_addr = (dev && dev->short_addr != GW_DEV_DIR_SHORT_UNKNOWN)
+                                        ? dev->short_addr
+                                        : zb_address_short_by_ieee(ind_params->device_addr);
+                    gw_dev_dir_remove(ind_params->device_addr);
                     if(short_addr != ZB_UNKNOWN_SHORT_ADDR) {
+                        gw_report_agg_remove_device(short_addr);
+                        gw_ota_sched_remove_device(short_addr);
                         zigbee_gw_cmd_send(ZIGBEE_CMD_DEVICE_LEAVE_INDICATION, 0x0000, 0, 0, (uint8_t*) &short_addr, 2);
                     }
                 }
@@ -142,6 +214,9 @@ void zboss_signal_handler(zb_uint8_t param) {
             bdb_start_top_level_commissioning(ZB_BDB_NETWORK_STEERING);
         }
     } else if (sig == ZB_BDB_SIGNAL_DEVICE_REBOOT) {
+        if (z_ret == 0) {
+            dev_dir_load();
+        }
     }
 
     if (param) {
@@ -242,6 +317,9 @@ void zigbee_app_nwk_start(uint32_t channel, uint32_t max_child,
 void dev_annce_cb(zb_zdo_device_annce_t* da) {
     uint8_t* pd = (uint8_t*)da;
 
+    /* tsn, short address, IEEE address, capability */
+    gw_dev_dir_announce(&pd[3], pd[1] | (pd[2] << 8), pd[11], dev_dir_now_ms());
+
     zigbee_gw_cmd_send(ZIGBEE_CMD_DEVICE_ANNCE_INDICATION, 0x0000, 0, 0, &pd[1], 11);
 }
 
@@ -266,7 +344,8 @@ void zcl_send_cmd_cb(zb_uint8_t param)
 }
 void zigbee_app_addr_table_update(void)
 {
-  zb_ushort_t i;
+  gw_dev_t *dev;
+  uint16_t i;
   uint8_t addr_idx=0;
   
   addr_table.status=0xFF;
@@ -274,19 +353,14 @@ void zigbee_app_addr_table_update(void)
   addr_table.group_count=0;
   memset(&addr_table, 0, 3+ZB_IEEE_ADDR_TABLE_SIZE*2);
 
-  for (i=0; i<ZB_IEEE_ADDR_TABLE_SIZE; i++)
+  for (i=0; i<gw_dev_dir_count() && addr_idx<ZB_IEEE_ADDR_TABLE_SIZE; i++)
   {
-    zb_address_map_t *ent;
-
-    ent = &ZG->addr.addr_map[i];
+    dev = gw_dev_dir_get(i);
 
-    if (ZB_U2B(ZG->addr.addr_map[i].used) && (ZG->addr.addr_map[i].lock_cnt > 0 && !ZG->addr.addr_map[i].pending_for_delete))
+    if (dev->short_addr != GW_DEV_DIR_SHORT_UNKNOWN)
     {
-      if (ent->redirect_type == ZB_ADDR_REDIRECT_NONE && ent->addr != 0x0000)
-      {
-        addr_table.short_addr[addr_idx] = ent->addr;
-        addr_idx += 1;
-      }
+      addr_table.short_addr[addr_idx] = dev->short_addr;
+      addr_idx += 1;
     }
   }
   log_info("addr count %d", addr_idx);
@@ -341,6 +415,8 @@ void zigbee_app_get_address_by_group_idx(uint8_t group)
 }
 void zigbee_app_init(void) {
     BaseType_t xReturned;
+
+    gw_dev_dir_init();
     xReturned = xTaskCreate(app_main_loop, "app-zigbee", 512, NULL,
                             E_TASK_PRIORITY_LOWEST, &zb_app_taskHandle);
     if (xReturned != pdPASS) {
@@ -15,6 +15,7 @@
 #include "mcu.h"
 
 #include "FreeRTOS.h"
+#include "task.h"
 
 #include "zb_common.h"
 #include "zb_mac_globals.h"
@@ -25,9 +26,13 @@
 #include "cli.h"
 #include "log.h"
 #include "util_string.h"
+#include "cli_args.h"
 #include "zigbee_api.h"
 #include "zigbee_cmd_nwk.h"
 #include "zigbee_cmd_app.h"
+#include "gw_report_agg.h"
+#include "gw_dev_dir.h"
+#include "gw_ota_sched.h"
 //=============================================================================
 //                Private Definitions of const value
 //=============================================================================
@@ -40,10 +45,170 @@
 //=============================================================================
 //                Private Struct
 //=============================================================================
+typedef struct {
+    uint8_t mode;
+    uint16_t src_address;
+    uint8_t src_ep;
+    uint16_t dst_address;
+    uint8_t dst_ep;
+    uint16_t cluster;
+} cli_bind_args_t;
+
+typedef struct {
+    uint8_t reset;
+    uint8_t channel;
+    uint16_t panid;
+    uint8_t max_child;
+} cli_start_args_t;
+
+typedef struct {
+    uint8_t cmd;
+    uint16_t addr;
+    uint8_t ep;
+    uint16_t group_id;
+    uint8_t scene_id;
+    uint8_t level;
+} cli_zcl_args_t;
+
+typedef struct {
+    uint8_t max_active;
+    uint16_t block_rate;
+    uint16_t min_period_ms;
+    uint32_t stall_s;
+    uint8_t max_failures;
+} cli_otacamp_cfg_args_t;
+
+#if (configUSE_RTOS_TRACE == 1)
+enum {
+    CLI_TRACE_CLEAR,
+    CLI_TRACE_DUMP,
+    CLI_TRACE_OFF,
+    CLI_TRACE_ON,
+};
+
+typedef struct {
+    uint8_t cmd;
+} cli_trace_args_t;
+#endif
+
+#if (configUSE_RTOS_MONITOR == 1)
+typedef struct {
+    uint32_t period;
+} cli_sysmon_args_t;
+#endif
 
 //=============================================================================
 //                Private Global Variables
 //=============================================================================
+/* Keyword tables are sorted by name */
+static const cli_keyword_t g_bind_mode[] = {
+    {"g", ZB_APS_ADDR_MODE_16_GROUP_ENDP_NOT_PRESENT},
+    {"u", ZB_APS_ADDR_MODE_64_ENDP_PRESENT},
+};
+
+static const cli_keyword_t g_group_cmd[] = {
+    {"a", ZB_ZCL_CMD_GROUPS_ADD_GROUP},
+    {"r", ZB_ZCL_CMD_GROUPS_REMOVE_GROUP},
+};
+
+static const cli_keyword_t g_scene_cmd[] = {
+    {"rc", ZB_ZCL_CMD_SCENES_RECALL_SCENE},
+    {"re", ZB_ZCL_CMD_SCENES_REMOVE_SCENE},
+    {"s", ZB_ZCL_CMD_SCENES_STORE_SCENE},
+    {"v", ZB_ZCL_CMD_SCENES_VIEW_SCENE},
+};
+
+static const cli_keyword_t g_onoff_cmd[] = {
+    {"off", ZB_ZCL_CMD_ON_OFF_OFF_ID},
+    {"on", ZB_ZCL_CMD_ON_OFF_ON_ID},
+    {"toggle", ZB_ZCL_CMD_ON_OFF_TOGGLE_ID},
+};
+
+static const cli_arg_t g_bind_args[] = {
+    CLI_ARG_KEY(cli_bind_args_t, mode, g_bind_mode, "g/u"),
+    CLI_ARG_NUM(cli_bind_args_t, src_address, CLI_ARG_U16, 0, 0xFFF7, "src addr"),
+    CLI_ARG_NUM(cli_bind_args_t, src_ep, CLI_ARG_U8, 1, 240, "src ep"),
+    CLI_ARG_NUM(cli_bind_args_t, dst_address, CLI_ARG_U16, 0, 0xFFFF, "dst addr"),
+    CLI_ARG_NUM(cli_bind_args_t, dst_ep, CLI_ARG_U8, 1, 240, "dst ep"),
+    CLI_ARG_NUM(cli_bind_args_t, cluster, CLI_ARG_U16, 0, 0xFFFF, "cluster"),
+};
+
+static const cli_arg_t g_start_args[] = {
+    CLI_ARG_NUM(cli_start_args_t, reset, CLI_ARG_U8, 0, 1, "reset"),
+    CLI_ARG_NUM(cli_start_args_t, channel, CLI_ARG_U8, 11, 26, "channel"),
+    CLI_ARG_NUM(cli_start_args_t, panid, CLI_ARG_U16, 0, 0xFFFE, "panid"),
+    CLI_ARG_NUM(cli_start_args_t, max_child, CLI_ARG_U8, 0, 0xFF, "max child"),
+};
+
+static const cli_arg_t g_group_args[] = {
+    CLI_ARG_KEY(cli_zcl_args_t, cmd, g_group_cmd, "action"),
+    CLI_ARG_NUM(cli_zcl_args_t, addr, CLI_ARG_U16, 0, 0xFFFF, "addr"),
+    CLI_ARG_NUM(cli_zcl_args_t, ep, CLI_ARG_U8, 1, 240, "ep"),
+    CLI_ARG_NUM(cli_zcl_args_t, group_id, CLI_ARG_U16, 1, 0xFFF7, "group id"),
+};
+
+static const cli_arg_t g_scene_args[] = {
+    CLI_ARG_KEY(cli_zcl_args_t, cmd, g_scene_cmd, "action"),
+    CLI_ARG_NUM(cli_zcl_args_t, addr, CLI_ARG_U16, 0, 0xFFFF, "addr"),
+    CLI_ARG_NUM(cli_zcl_args_t, ep, CLI_ARG_U8, 1, 240, "ep"),
+    CLI_ARG_NUM(cli_zcl_args_t, group_id, CLI_ARG_U16, 0, 0xFFF7, "group id"),
+    CLI_ARG_NUM(cli_zcl_args_t, scene_id, CLI_ARG_U8, 0, 0xFF, "scene id"),
+};
+
+static const cli_arg_t g_addr_ep_args[] = {
+    CLI_ARG_NUM(cli_zcl_args_t, addr, CLI_ARG_U16, 0, 0xFFFF, "addr"),
+    CLI_ARG_NUM(cli_zcl_args_t, ep, CLI_ARG_U8, 1, 240, "ep"),
+};
+
+static const cli_arg_t g_onoff_args[] = {
+    CLI_ARG_NUM(cli_zcl_args_t, addr, CLI_ARG_U16, 0, 0xFFFF, "short addr"),
+    CLI_ARG_NUM(cli_zcl_args_t, ep, CLI_ARG_U8, 1, 240, "ep"),
+    CLI_ARG_KEY(cli_zcl_args_t, cmd, g_onoff_cmd, "on/off/toggle"),
+};
+
+static const cli_arg_t g_level_args[] = {
+    CLI_ARG_NUM(cli_zcl_args_t, addr, CLI_ARG_U16, 0, 0xFFFF, "short addr"),
+    CLI_ARG_NUM(cli_zcl_args_t, ep, CLI_ARG_U8, 1, 240, "ep"),
+    CLI_ARG_NUM(cli_zcl_args_t, level, CLI_ARG_U8, 0, 0xFE, "level"),
+};
+
+static const cli_arg_t g_rptagg_policy_args[] = {
+    CLI_ARG_NUM(gw_report_agg_policy_t, cluster, CLI_ARG_U16, 0, 0xFFFF, "cluster"),
+    CLI_ARG_NUM_OPT(gw_report_agg_policy_t, min_interval_ms, CLI_ARG_U32, 0, 0xFFFFFFFF, "min ms"),
+    CLI_ARG_NUM_OPT(gw_report_agg_policy_t, max_interval_ms, CLI_ARG_U32, 0, 0xFFFFFFFF, "max ms"),
+    CLI_ARG_NUM_OPT(gw_report_agg_policy_t, delta, CLI_ARG_U32, 0, 0xFFFFFFFF, "delta"),
+};
+
+static const cli_arg_t g_otacamp_addr_args[] = {
+    CLI_ARG_NUM(cli_zcl_args_t, addr, CLI_ARG_U16, 0, 0xFFF7, "addr"),
+};
+
+static const cli_arg_t g_otacamp_cfg_args[] = {
+    CLI_ARG_NUM(cli_otacamp_cfg_args_t, max_active, CLI_ARG_U8, 1, 0xFF, "max active"),
+    CLI_ARG_NUM(cli_otacamp_cfg_args_t, block_rate, CLI_ARG_U16, 1, 0xFFFF, "blocks/s"),
+    CLI_ARG_NUM(cli_otacamp_cfg_args_t, min_period_ms, CLI_ARG_U16, 0, 0xFFFF, "min period ms"),
+    CLI_ARG_NUM(cli_otacamp_cfg_args_t, stall_s, CLI_ARG_U32, 1, 0xFFFFFFFF / 1000, "stall s"),
+    CLI_ARG_NUM(cli_otacamp_cfg_args_t, max_failures, CLI_ARG_U8, 1, 0xFF, "max failures"),
+};
+
+#if (configUSE_RTOS_TRACE == 1)
+static const cli_keyword_t g_trace_cmd[] = {
+    {"clear", CLI_TRACE_CLEAR},
+    {"dump", CLI_TRACE_DUMP},
+    {"off", CLI_TRACE_OFF},
+    {"on", CLI_TRACE_ON},
+};
+
+static const cli_arg_t g_trace_args[] = {
+    CLI_ARG_KEY(cli_trace_args_t, cmd, g_trace_cmd, "action"),
+};
+#endif
+
+#if (configUSE_RTOS_MONITOR == 1)
+static const cli_arg_t g_sysmon_args[] = {
+    CLI_ARG_NUM_OPT(cli_sysmon_args_t, period, CLI_ARG_U32, RTOS_MONITOR_PERIOD_MIN_MS, 60000, "period ms"),
+};
+#endif
 
 //=============================================================================
 //                Callback Functions
@@ -79,6 +244,7 @@ static void _act_ep_req_cb(zb_uint8_t param)
         {
             break;
         }
+        gw_dev_dir_set_endpoints(resp->nwk_addr, resp->ep_count, ep_list);
         log_info("Addr 0x%04X Active Endpoint:", resp->nwk_addr);
 
         for (uint8_t i = 0; i < resp->ep_count; i++)
@@ -105,6 +271,7 @@ static void _simple_desc_cb(zb_bufid_t param)
             break;
         }
         total_cluster_count = resp->simple_desc.app_input_cluster_count + resp->simple_desc.app_output_cluster_count;
+        zigbee_app_dev_dir_desc_update(resp->hdr.nwk_addr, &resp->simple_desc);
 
         log_info("Simple Descriptor of 0x%04X EP %02x:", resp->hdr.nwk_addr, resp->simple_desc.endpoint);
         log_info("Device ID 0x%04X", resp->simple_desc.app_device_id);
@@ -114,7 +281,7 @@ static void _simple_desc_cb(zb_bufid_t param)
             log_info("0x%04X, ", *(resp->simple_desc.app_cluster_list + i));
         }
         log_info("Client cluster:");
-        for (; i < resp->simple_desc.app_output_cluster_count; i++)
+        for (; i < total_cluster_count; i++)
         {
             log_info("0x%04X, ", *(resp->simple_desc.app_cluster_list + i));
         }
@@ -127,46 +294,15 @@ static void _simple_desc_cb(zb_bufid_t param)
 //=============================================================================
 //                ZDO Functions
 //=============================================================================
-static int _cli_cmd_bind(int argc, char** argv, cb_shell_out_t log_out,
-                       void* pExtra) {
-    uint8_t src_ep, dst_ep, mode;
-    uint16_t src_address, dst_address, cluster;
+static void _cli_bind_req(int argc, char** argv, bool unbind) {
+    cli_bind_args_t args;
     zb_bufid_t buf;
     zb_ieee_addr_t ieee_address;
     zb_zdo_bind_req_param_t *bind_param = NULL;
     do {
-        if(argc < 7) {
+        if (cli_args_parse(argc - 1, argv + 1, g_bind_args, CLI_ARGS_COUNT(g_bind_args), &args) != 0) {
             break;
         }
-        if(strcmp(argv[1], "u") == 0) {
-            mode = ZB_APS_ADDR_MODE_64_ENDP_PRESENT;
-        }
-        else if(strcmp(argv[1], "g") == 0) {
-            mode = ZB_APS_ADDR_MODE_16_GROUP_ENDP_NOT_PRESENT;
-        }
-        else {
-            log_error("Invalid binding mode");
-            break;
-        }
-        src_address = (*(argv[2] + 1) == 'x')
-                ? utility_strtox(argv[2] + 2, 0, 4)
-                : utility_strtol(argv[2], 0);
-
-        src_ep = (*(argv[3] + 1) == 'x')
-                ? utility_strtox(argv[3] + 2, 0, 2)
-                : utility_strtol(argv[3], 0);
-
-        dst_address = (*(argv[4] + 1) == 'x')
-                ? utility_strtox(argv[4] + 2, 0, 4)
-                : utility_strtol(argv[4], 0);
-
-        dst_ep = (*(argv[5] + 1) == 'x')
-                ? utility_strtox(argv[5] + 2, 0, 2)
-                : utility_strtol(argv[5], 0);
-
-        cluster = (*(argv[6] + 1) == 'x')
-                ? utility_strtox(argv[6] + 2, 0, 4)
-                : utility_strtol(argv[6], 0);
 
         ZB_THREAD_SAFE(
             buf = zb_buf_get_any();
@@ -174,112 +310,47 @@ static int _cli_cmd_bind(int argc, char** argv, cb_shell_out_t log_out,
                 break;
             }
             bind_param = ZB_BUF_GET_PARAM(buf, zb_zdo_bind_req_param_t);
-            bind_param->req_dst_addr = src_address;
-            bind_param->dst_endp = dst_ep;
-            bind_param->src_endp = src_ep;
-            bind_param->cluster_id = cluster;
-            bind_param->dst_addr_mode = mode;
-            if (mode == ZB_APS_ADDR_MODE_64_ENDP_PRESENT) {
-                if(zb_address_ieee_by_short(dst_address, ieee_address) != RET_OK) {
+            bind_param->req_dst_addr = args.src_address;
+            bind_param->dst_endp = args.dst_ep;
+            bind_param->src_endp = args.src_ep;
+            bind_param->cluster_id = args.cluster;
+            bind_param->dst_addr_mode = args.mode;
+            if (args.mode == ZB_APS_ADDR_MODE_64_ENDP_PRESENT) {
+                if(zb_address_ieee_by_short(args.dst_address, ieee_address) != RET_OK) {
                     log_error("unknown dst address");
-                    if(buf != 0) {
-                        zb_buf_free(buf);
-                    }
+                    zb_buf_free(buf);
                     break;
                 }
                 memcpy(bind_param->dst_address.addr_long, ieee_address, sizeof(zb_ieee_addr_t));
             }
-            else if (mode == ZB_APS_ADDR_MODE_16_GROUP_ENDP_NOT_PRESENT) {
-                bind_param->dst_address.addr_short = dst_address;
+            else {
+                bind_param->dst_address.addr_short = args.dst_address;
             }
-            if(zb_address_ieee_by_short(src_address, ieee_address) != RET_OK) {
+            if(zb_address_ieee_by_short(args.src_address, ieee_address) != RET_OK) {
                 log_error("unknown src address");
-                if(buf != 0) {
-                    zb_buf_free(buf);
-                }
+                zb_buf_free(buf);
                 break;
             }
             memcpy(bind_param->src_address, ieee_address, sizeof(zb_ieee_addr_t));
-            zb_zdo_bind_req(buf, bind_req_cb);
+            if (unbind) {
+                zb_zdo_unbind_req(buf, bind_req_cb);
+            } else {
+                zb_zdo_bind_req(buf, bind_req_cb);
+            }
         );
 
     } while (0);
+}
+
+static int _cli_cmd_bind(int argc, char** argv, cb_shell_out_t log_out,
+                       void* pExtra) {
+    _cli_bind_req(argc, argv, false);
     return 0;
 }
 
 static int _cli_cmd_unbind(int argc, char** argv, cb_shell_out_t log_out,
                        void* pExtra) {
-    uint8_t src_ep, dst_ep, mode;
-    uint16_t src_address, dst_address, cluster;
-    zb_bufid_t buf;
-    zb_ieee_addr_t ieee_address;
-    zb_zdo_bind_req_param_t *bind_param = NULL;
-    do {
-        if(argc < 7) {
-            break;
-        }
-        if(strcmp(argv[1], "u") == 0) {
-            mode = ZB_APS_ADDR_MODE_64_ENDP_PRESENT;
-        }
-        else if(strcmp(argv[1], "g") == 0) {
-            mode = ZB_APS_ADDR_MODE_16_GROUP_ENDP_NOT_PRESENT;
-        }
-        else {
-            log_error("Invalid binding mode");
-            break;
-        }
-        src_address = (*(argv[2] + 1) == 'x')
-                ? utility_strtox(argv[2] + 2, 0, 4)
-                : utility_strtol(argv[2], 0);
-
-        src_ep = (*(argv[3] + 1) == 'x')
-                ? utility_strtox(argv[3] + 2, 0, 2)
-                : utility_strtol(argv[3], 0);
-
-        dst_address = (*(argv[4] + 1) == 'x')
-                ? utility_strtox(argv[4] + 2, 0, 4)
-                : utility_strtol(argv[4], 0);
-
-        dst_ep = (*(argv[5] + 1) == 'x')
-                ? utility_strtox(argv[5] + 2, 0, 2)
-                : utility_strtol(argv[5], 0);
-
-        cluster = (*(argv[6] + 1) == 'x')
-                ? utility_strtox(argv[6] + 2, 0, 4)
-                : utility_strtol(argv[6], 0);
-
-        ZB_THREAD_SAFE(
-            buf = zb_buf_get_any();
-            if (buf == 0U) {
-                break;
-            }
-            bind_param = ZB_BUF_GET_PARAM(buf, zb_zdo_bind_req_param_t);
-            bind_param->req_dst_addr = src_address;
-            bind_param->dst_endp = dst_ep;
-            bind_param->src_endp = src_ep;
-            bind_param->cluster_id = cluster;
-            bind_param->dst_addr_mode = mode;
-            if (mode == ZB_APS_ADDR_MODE_64_ENDP_PRESENT) {
-                if(zb_address_ieee_by_short(dst_address, ieee_address) != RET_OK) {
-                    log_error("unknown dst address");
-                    zb_buf_free(buf);
-                    break;
-                }
-                memcpy(bind_param->dst_address.addr_long, ieee_address, sizeof(zb_ieee_addr_t));
-            }
-            else if (mode == ZB_APS_ADDR_MODE_16_GROUP_ENDP_NOT_PRESENT) {
-                bind_param->dst_address.addr_short = dst_address;
-            }
-            if(zb_address_ieee_by_short(src_address, ieee_address) != RET_OK) {
-                log_error("unknown src address");
-                zb_buf_free(buf);
-                break;
-            }
-            memcpy(bind_param->src_address, ieee_address, sizeof(zb_ieee_addr_t));
-            zb_zdo_unbind_req(buf, bind_req_cb);
-        );
-
-    } while (0);
+    _cli_bind_req(argc, argv, true);
     return 0;
 }
 
@@ -289,6 +360,7 @@ _cli_cmd_zdo_act_ep_req(int argc, char **argv, cb_shell_out_t log_out, void *pEx
     uint16_t addr;
     zb_bufid_t buf = 0U;
     zb_zdo_active_ep_req_t *ep_req;
+    gw_dev_t *dev;
 
     do
     {
@@ -301,6 +373,16 @@ _cli_cmd_zdo_act_ep_req(int argc, char **argv, cb_shell_out_t log_out, void *pEx
                ? utility_strtox(argv[1] + 2, 0, 4)
                : utility_strtol(argv[1], 0);
         ZB_THREAD_SAFE(
+            dev = gw_dev_dir_find_short(addr);
+            if (argc < 3 && dev && dev->ep_valid) {
+                log_info("Addr 0x%04X Active Endpoint (cached):", addr);
+                for (uint8_t i = 0; i < dev->ep_count; i++)
+                {
+                    log_info("[%02x]", dev->ep_list[i]);
+                }
+                break;
+            }
+
             buf = zb_buf_get_any();
             if (buf == 0U) {
                 break;
@@ -319,9 +401,10 @@ static int
 _cli_cmd_zdo_simple_desc_req(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
 {
     uint16_t addr;
-    uint8_t endpoint;
+    uint8_t endpoint, i;
     zb_bufid_t buf = 0U;
     zb_zdo_simple_desc_req_t *req;
+    const gw_dev_desc_t *desc;
     do
     {
         if (argc < 3)
@@ -338,6 +421,23 @@ _cli_cmd_zdo_simple_desc_req(int argc, char **argv, cb_shell_out_t log_out, void
                    : utility_strtol(argv[2], 0);
 
         ZB_THREAD_SAFE(
+            desc = gw_dev_dir_get_desc(addr, endpoint);
+            if (argc < 4 && desc) {
+                log_info("Simple Descriptor of 0x%04X EP %02x (cached):", addr, endpoint);
+                log_info("Device ID 0x%04X", desc->device_id);
+                log_info("Server cluster:");
+                for (i = 0; i < desc->in_count; i++)
+                {
+                    log_info("0x%04X, ", desc->clusters[i]);
+                }
+                log_info("Client cluster:");
+                for (; i < desc->in_count + desc->out_count; i++)
+                {
+                    log_info("0x%04X, ", desc->clusters[i]);
+                }
+                break;
+            }
+
             buf = zb_buf_get_any();
             if (buf == 0U) {
                 break;
@@ -404,30 +504,13 @@ static int _cli_cmd_pj(int argc, char** argv, cb_shell_out_t log_out,
 
 static int _cli_cmd_start(int argc, char** argv, cb_shell_out_t log_out,
                        void* pExtra) {
-    uint8_t channel, max_child, reset;
-    uint16_t panid;
+    cli_start_args_t args;
     do {
-        if(argc < 5) {
+        if (cli_args_parse(argc - 1, argv + 1, g_start_args, CLI_ARGS_COUNT(g_start_args), &args) != 0) {
             break;
         }
 
-        reset = (*(argv[1] + 1) == 'x')
-                ? utility_strtox(argv[1] + 2, 0, 2)
-                : utility_strtol(argv[1], 0);
-
-        channel = (*(argv[2] + 1) == 'x')
-                ? utility_strtox(argv[2] + 2, 0, 2)
-                : utility_strtol(argv[2], 0);
-
-        panid = (*(argv[3] + 1) == 'x')
-                ? utility_strtox(argv[3] + 2, 0, 4)
-                : utility_strtol(argv[3], 0);
-
-        max_child = (*(argv[4] + 1) == 'x')
-                ? utility_strtox(argv[4] + 2, 0, 2)
-                : utility_strtol(argv[4], 0);
-
-        zigbee_app_nwk_start(channel, max_child, panid, reset);
+        zigbee_app_nwk_start(args.channel, args.max_child, args.panid, args.reset);
 
     } while (0);
     return 0;
@@ -584,49 +667,25 @@ static int
 _cli_cmd_zcl_group(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
 {
     zcl_data_req_t *pt_data_req;
-    uint16_t addr, group_id, ep, cmd;
+    cli_zcl_args_t args;
 
     do
     {
-        if (argc < 4)
+        if (cli_args_parse(argc - 1, argv + 1, g_group_args, CLI_ARGS_COUNT(g_group_args), &args) != 0)
         {
             break;
         }
 
-        if (memcmp("a", argv[1], 1) == 0)
-        {
-            cmd = ZB_ZCL_CMD_GROUPS_ADD_GROUP;
-        }
-        else if (memcmp("r", argv[1], 1) == 0)
-        {
-            cmd = ZB_ZCL_CMD_GROUPS_REMOVE_GROUP;
-        }
-        else
-        {
-            break;
-        }
-
-        addr = (*(argv[2] + 1) == 'x')
-               ? utility_strtox(argv[2] + 2, 0, 4)
-               : utility_strtol(argv[2], 0);
-        ep = (*(argv[3] + 1) == 'x')
-             ? utility_strtox(argv[3] + 2, 0, 2)
-             : utility_strtol(argv[3], 0);
-        group_id = (*(argv[4] + 1) == 'x')
-                   ? utility_strtox(argv[4] + 2, 0, 4)
-                   : utility_strtol(argv[4], 0);
-
-
-        ZIGBEE_ZCL_DATA_REQ(pt_data_req, addr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
-                            ep, ZIGBEE_DEFAULT_ENDPOINT,
-                            ZB_ZCL_CLUSTER_ID_GROUPS, cmd, TRUE, TRUE,
+        ZIGBEE_ZCL_DATA_REQ(pt_data_req, args.addr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+                            args.ep, ZIGBEE_DEFAULT_ENDPOINT,
+                            ZB_ZCL_CLUSTER_ID_GROUPS, args.cmd, TRUE, TRUE,
                             ZCL_FRAME_CLIENT_SERVER_DIR, 0, 3)
 
 
         if (pt_data_req)
         {
-            pt_data_req->cmdFormat[0] = group_id & 0xFF;
-            pt_data_req->cmdFormat[1] = (group_id >> 8) & 0xFF;
+            pt_data_req->cmdFormat[0] = args.group_id & 0xFF;
+            pt_data_req->cmdFormat[1] = (args.group_id >> 8) & 0xFF;
             pt_data_req->cmdFormat[2] = 0x00;     /* string lenght */
             zigbee_app_zcl_send_command(pt_data_req);
             vPortFree(pt_data_req);
@@ -640,28 +699,17 @@ static int
 _cli_cmd_zcl_identify(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
 {
     zcl_data_req_t *pt_data_req;
-    uint16_t addr;
-    uint8_t ep;
+    cli_zcl_args_t args;
 
     do
     {
-        if (argc < 3)
+        if (cli_args_parse(argc - 1, argv + 1, g_addr_ep_args, CLI_ARGS_COUNT(g_addr_ep_args), &args) != 0)
         {
             break;
         }
 
-        addr = (*(argv[1] + 1) == 'x')
-               ? utility_strtox(argv[1] + 2, 0, 4)
-               : utility_strtol(argv[1], 0);
-
-        ep = (*(argv[2] + 1) == 'x')
-             ? utility_strtox(argv[2] + 2, 0, 2)
-             : utility_strtol(argv[2], 0);
-
-
-
-        ZIGBEE_ZCL_DATA_REQ(pt_data_req, addr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
-                            ep, ZIGBEE_DEFAULT_ENDPOINT,
+        ZIGBEE_ZCL_DATA_REQ(pt_data_req, args.addr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+                            args.ep, ZIGBEE_DEFAULT_ENDPOINT,
                             ZB_ZCL_CLUSTER_ID_IDENTIFY, ZB_ZCL_CMD_IDENTIFY_IDENTIFY_ID, TRUE, TRUE,
                             ZCL_FRAME_CLIENT_SERVER_DIR, 0, 2)
 
@@ -680,39 +728,14 @@ _cli_cmd_zcl_identify(int argc, char **argv, cb_shell_out_t log_out, void *pExtr
 static int _cli_cmd_onoff(int argc, char** argv, cb_shell_out_t log_out,
                        void* pExtra) {
     zcl_data_req_t *pt_data_req;
-    uint8_t cmd,ep;
-    uint16_t address;
+    cli_zcl_args_t args;
     do {
-        if(argc < 4) {
+        if (cli_args_parse(argc - 1, argv + 1, g_onoff_args, CLI_ARGS_COUNT(g_onoff_args), &args) != 0) {
             break;
         }
-        address = (*(argv[1] + 1) == 'x')
-                ? utility_strtox(argv[1] + 2, 0, 4)
-                : utility_strtol(argv[1], 0);
 
-        ep = (*(argv[2] + 1) == 'x')
-                ? utility_strtox(argv[2] + 2, 0, 2)
-                : utility_strtol(argv[2], 0);
-
-        if(strcmp(argv[3],"on") == 0)
-        {
-            cmd = ZB_ZCL_CMD_ON_OFF_ON_ID;
-        }
-        else if(strcmp(argv[3],"off") == 0)
-        {
-            cmd = ZB_ZCL_CMD_ON_OFF_OFF_ID;
-        }
-        else if(strcmp(argv[3],"toggle") == 0)
-        {
-            cmd = ZB_ZCL_CMD_ON_OFF_TOGGLE_ID;
-        }
-        else {
-            log_error("Invalid command");
-            break;
-        }
-
-    ZIGBEE_ZCL_DATA_REQ(pt_data_req, address, ZB_APS_ADDR_MODE_16_ENDP_PRESENT, ep, ZIGBEE_DEFAULT_ENDPOINT, ZB_ZCL_CLUSTER_ID_ON_OFF,
-                        cmd, TRUE, TRUE, ZCL_FRAME_CLIENT_SERVER_DIR, 0, 0)
+    ZIGBEE_ZCL_DATA_REQ(pt_data_req, args.addr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT, args.ep, ZIGBEE_DEFAULT_ENDPOINT, ZB_ZCL_CLUSTER_ID_ON_OFF,
+                        args.cmd, TRUE, TRUE, ZCL_FRAME_CLIENT_SERVER_DIR, 0, 0)
 
 
     if (pt_data_req)
@@ -728,32 +751,19 @@ static int _cli_cmd_onoff(int argc, char** argv, cb_shell_out_t log_out,
 static int _cli_cmd_level(int argc, char** argv, cb_shell_out_t log_out,
                        void* pExtra) {
     zcl_data_req_t *pt_data_req;
-    uint8_t level,ep;
-    uint16_t address;
+    cli_zcl_args_t args;
     do {
-        if(argc < 4) {
+        if (cli_args_parse(argc - 1, argv + 1, g_level_args, CLI_ARGS_COUNT(g_level_args), &args) != 0) {
             break;
         }
-        address = (*(argv[1] + 1) == 'x')
-                ? utility_strtox(argv[1] + 2, 0, 4)
-                : utility_strtol(argv[1], 0);
-
-        ep = (*(argv[2] + 1) == 'x')
-                ? utility_strtox(argv[2] + 2, 0, 2)
-                : utility_strtol(argv[2], 0);
 
-        level = (*(argv[3] + 1) == 'x')
-                ? utility_strtox(argv[3] + 2, 0, 2)
-                : utility_strtol(argv[3], 0);
-                
-
-    ZIGBEE_ZCL_DATA_REQ(pt_data_req, address, ZB_APS_ADDR_MODE_16_ENDP_PRESENT, ep, ZIGBEE_DEFAULT_ENDPOINT, ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
+    ZIGBEE_ZCL_DATA_REQ(pt_data_req, args.addr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT, args.ep, ZIGBEE_DEFAULT_ENDPOINT, ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
                         ZB_ZCL_CMD_LEVEL_CONTROL_MOVE_TO_LEVEL_WITH_ON_OFF, TRUE, TRUE, ZCL_FRAME_CLIENT_SERVER_DIR, 0, 3)
 
 
     if (pt_data_req)
     {
-        pt_data_req->cmdFormat[0] = level;
+        pt_data_req->cmdFormat[0] = args.level;
         pt_data_req->cmdFormat[1] = 0xA;
         pt_data_req->cmdFormat[2] = 0;
         zigbee_app_zcl_send_command(pt_data_req);
@@ -769,52 +779,23 @@ static int
 _cli_cmd_zcl_scene(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
 {
     zcl_data_req_t *pt_data_req;
-    uint16_t addr, group_id, scence_id, cmd, ep;
+    cli_zcl_args_t args;
 
     do
     {
-
-        if (memcmp("s", argv[1], 1) == 0)
+        if (cli_args_parse(argc - 1, argv + 1, g_scene_args, CLI_ARGS_COUNT(g_scene_args), &args) != 0)
         {
-            cmd = ZB_ZCL_CMD_SCENES_STORE_SCENE;
-        }
-        else if (memcmp("rc", argv[1], 2) == 0)
-        {
-            cmd = ZB_ZCL_CMD_SCENES_RECALL_SCENE;
-        }
-        else if (memcmp("re", argv[1], 2) == 0)
-        {
-            cmd = ZB_ZCL_CMD_SCENES_REMOVE_SCENE;
-        }
-        else if (memcmp("v", argv[1], 1) == 0)
-        {
-            cmd = ZB_ZCL_CMD_SCENES_VIEW_SCENE;
+            break;
         }
 
-        addr = (*(argv[2] + 1) == 'x')
-               ? utility_strtox(argv[2] + 2, 0, 4)
-               : utility_strtol(argv[2], 0);
-
-        ep = (*(argv[3] + 1) == 'x')
-             ? utility_strtox(argv[3] + 2, 0, 2)
-             : utility_strtol(argv[3], 0);
-
-        group_id = (*(argv[4] + 1) == 'x')
-                   ? utility_strtox(argv[4] + 2, 0, 4)
-                   : utility_strtol(argv[4], 0);
-
-        scence_id = (*(argv[5] + 1) == 'x')
-                    ? utility_strtox(argv[5] + 2, 0, 4)
-                    : utility_strtol(argv[5], 0);
-
-        ZIGBEE_ZCL_DATA_REQ(pt_data_req, addr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT, ep, ZIGBEE_DEFAULT_ENDPOINT, ZB_ZCL_CLUSTER_ID_SCENES,
-                            cmd, TRUE, TRUE, ZCL_FRAME_CLIENT_SERVER_DIR, 0, 3)
+        ZIGBEE_ZCL_DATA_REQ(pt_data_req, args.addr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT, args.ep, ZIGBEE_DEFAULT_ENDPOINT, ZB_ZCL_CLUSTER_ID_SCENES,
+                            args.cmd, TRUE, TRUE, ZCL_FRAME_CLIENT_SERVER_DIR, 0, 3)
 
         if (pt_data_req)
         {
-            pt_data_req->cmdFormat[0] = group_id & 0xFF;
-            pt_data_req->cmdFormat[1] = (group_id >> 8) & 0xFF;
-            pt_data_req->cmdFormat[2] = scence_id & 0xFF;
+            pt_data_req->cmdFormat[0] = args.group_id & 0xFF;
+            pt_data_req->cmdFormat[1] = (args.group_id >> 8) & 0xFF;
+            pt_data_req->cmdFormat[2] = args.scene_id;
 
             zigbee_app_zcl_send_command(pt_data_req);
             vPortFree(pt_data_req);
@@ -1073,6 +1054,246 @@ _cli_cmd_zcl_config_report(int argc, char **argv, cb_shell_out_t log_out, void *
     return 0;
 }
 
+static int
+_cli_cmd_dev_dir(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
+{
+    gw_dev_dir_stats_t stats;
+    gw_dev_t *dev;
+    uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    uint16_t i;
+
+    ZB_THREAD_SAFE(
+        for (i = 0; i < gw_dev_dir_count(); i++)
+        {
+            dev = gw_dev_dir_get(i);
+            log_info("%02X%02X%02X%02X%02X%02X%02X%02X 0x%04X cap 0x%02x lqi %d rssi %d seen %ds ep %d",
+                     dev->ieee[7], dev->ieee[6], dev->ieee[5], dev->ieee[4],
+                     dev->ieee[3], dev->ieee[2], dev->ieee[1], dev->ieee[0],
+                     dev->short_addr, dev->capability, dev->lqi, dev->rssi,
+                     (now - dev->last_seen_ms) / 1000, dev->ep_valid ? dev->ep_count : -1);
+        }
+        gw_dev_dir_stats_get(&stats);
+    )
+    log_info("announce %d rejoin %d addr change %d conflict %d leave %d full %d synced %d",
+             stats.announces, stats.rejoins, stats.addr_changes, stats.conflicts,
+             stats.leaves, stats.full, stats.synced);
+    return 0;
+}
+
+static int
+_cli_report_agg_reset(int argc, char **argv, void *pCtx)
+{
+    ZB_THREAD_SAFE(gw_report_agg_stats_reset();)
+    return 0;
+}
+
+static int
+_cli_report_agg_policy(int argc, char **argv, void *pCtx)
+{
+    gw_report_agg_policy_t policy;
+    bool ret = true;
+
+    if (cli_args_parse(argc - 1, argv + 1, g_rptagg_policy_args, CLI_ARGS_COUNT(g_rptagg_policy_args), &policy) != 0)
+    {
+        return -1;
+    }
+
+    /* the cluster alone shows its policy */
+    if (argc > 2)
+    {
+        if (argc < (int)CLI_ARGS_COUNT(g_rptagg_policy_args) + 1)
+        {
+            log_info("missing [%s]", g_rptagg_policy_args[argc - 1].pName);
+            return -1;
+        }
+        ZB_THREAD_SAFE(ret = gw_report_agg_policy_set(&policy);)
+        if (!ret)
+        {
+            log_info("policy table full");
+            return -1;
+        }
+    }
+    ZB_THREAD_SAFE(ret = gw_report_agg_policy_get(policy.cluster, &policy);)
+    if (!ret)
+    {
+        log_info("cluster 0x%04x not cached", policy.cluster);
+        return 0;
+    }
+    log_info("cluster 0x%04x min %d ms max %d ms delta %d", policy.cluster,
+             policy.min_interval_ms, policy.max_interval_ms, policy.delta);
+    return 0;
+}
+
+/* Sorted by name */
+static const cli_subcmd_t g_rptagg_cmds[] = {
+    {"policy", _cli_report_agg_policy},
+    {"reset", _cli_report_agg_reset},
+};
+
+static int
+_cli_cmd_report_agg(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
+{
+    gw_report_agg_stats_t stats;
+
+    if (argc >= 2)
+    {
+        cli_subcmd_run(argc - 1, argv + 1, g_rptagg_cmds, CLI_ARGS_COUNT(g_rptagg_cmds), NULL);
+        return 0;
+    }
+
+    gw_report_agg_stats_get(&stats);
+    log_info("received %d forwarded %d frames %d", stats.received, stats.forwarded, stats.frames);
+    log_info("suppressed equal %d delta %d, coalesced %d", stats.suppressed_equal,
+             stats.suppressed_delta, stats.coalesced);
+    log_info("bypassed %d uncached %d evicted %d", stats.bypassed, stats.uncached,
+             stats.evicted);
+    log_info("flush failed %d", stats.send_failed);
+    return 0;
+}
+
+static int
+_cli_ota_campaign_start(int argc, char **argv, void *pCtx)
+{
+    cli_zcl_args_t args;
+    uint16_t addrs[16];
+    uint16_t count = 0;
+    int i;
+
+    for (i = 1; i < argc && count < 16; i++)
+    {
+        if (cli_args_parse(1, argv + i, g_otacamp_addr_args, CLI_ARGS_COUNT(g_otacamp_addr_args), &args) != 0)
+        {
+            return -1;
+        }
+        addrs[count++] = args.addr;
+    }
+    ZB_THREAD_SAFE(gw_ota_sched_start(addrs, count);)
+    return 0;
+}
+
+static int
+_cli_ota_campaign_stop(int argc, char **argv, void *pCtx)
+{
+    ZB_THREAD_SAFE(gw_ota_sched_stop();)
+    return 0;
+}
+
+static int
+_cli_ota_campaign_cfg(int argc, char **argv, void *pCtx)
+{
+    cli_otacamp_cfg_args_t args;
+    gw_ota_sched_cfg_t cfg;
+
+    ZB_THREAD_SAFE(gw_ota_sched_cfg_get(&cfg);)
+    if (argc > 1)
+    {
+        if (cli_args_parse(argc - 1, argv + 1, g_otacamp_cfg_args, CLI_ARGS_COUNT(g_otacamp_cfg_args), &args) != 0)
+        {
+            return -1;
+        }
+        cfg.max_active = args.max_active;
+        cfg.block_rate = args.block_rate;
+        cfg.min_period_ms = args.min_period_ms;
+        cfg.stall_ms = args.stall_s * 1000;
+        cfg.max_failures = args.max_failures;
+        ZB_THREAD_SAFE(gw_ota_sched_cfg_set(&cfg);
+                       gw_ota_sched_cfg_get(&cfg);)
+    }
+    log_info("max active %d block rate %d/s min period %d ms stall %d s max failures %d",
+             cfg.max_active, cfg.block_rate, cfg.min_period_ms, cfg.stall_ms / 1000,
+             cfg.max_failures);
+    return 0;
+}
+
+/* Sorted by name */
+static const cli_subcmd_t g_otacamp_cmds[] = {
+    {"cfg", _cli_ota_campaign_cfg},
+    {"start", _cli_ota_campaign_start},
+    {"stop", _cli_ota_campaign_stop},
+};
+
+static int
+_cli_cmd_ota_campaign(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
+{
+    static const char *state_str[] = {"pending", "active", "done", "failed"};
+    gw_ota_sched_stats_t stats;
+    const gw_ota_dev_t *dev;
+    uint16_t i;
+
+    if (argc >= 2)
+    {
+        cli_subcmd_run(argc - 1, argv + 1, g_otacamp_cmds, CLI_ARGS_COUNT(g_otacamp_cmds), NULL);
+        return 0;
+    }
+
+    ZB_THREAD_SAFE(
+        for (i = 0; i < gw_ota_sched_count(); i++)
+        {
+            dev = gw_ota_sched_get(i);
+            log_info("0x%04X ep %d %s %d%% offset %d failures %d period %d ms",
+                     dev->short_addr, dev->ep, state_str[dev->state], dev->percent,
+                     dev->offset, dev->failures, dev->period_ms);
+        }
+        gw_ota_sched_stats_get(&stats);
+    )
+    log_info("%s pending %d active %d done %d failed %d",
+             gw_ota_sched_running() ? "running" : "stopped",
+             stats.pending, stats.active, stats.done, stats.failed);
+    log_info("blocks %d wait %d abort %d notify %d stall %d cache hit %d miss %d",
+             stats.blocks, stats.waits, stats.aborts, stats.notifies, stats.stalls,
+             stats.cache_hits, stats.cache_misses);
+    return 0;
+}
+
+#if (configUSE_RTOS_TRACE == 1)
+static int
+_cli_cmd_trace(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
+{
+    cli_trace_args_t args;
+
+    do
+    {
+        if (cli_args_parse(argc - 1, argv + 1, g_trace_args, CLI_ARGS_COUNT(g_trace_args), &args) != 0)
+        {
+            break;
+        }
+
+        switch (args.cmd)
+        {
+        case CLI_TRACE_CLEAR: rtos_trace_clear(); break;
+        case CLI_TRACE_DUMP: rtos_trace_dump(); break;
+        case CLI_TRACE_OFF: rtos_trace_enable(0); break;
+        case CLI_TRACE_ON: rtos_trace_enable(1); break;
+        }
+    } while (0);
+    return 0;
+}
+#endif
+
+#if (configUSE_RTOS_MONITOR == 1)
+static int
+_cli_cmd_sysmon(int argc, char **argv, cb_shell_out_t log_out, void *pExtra)
+{
+    cli_sysmon_args_t args = {0};
+
+    do
+    {
+        if (cli_args_parse(argc - 1, argv + 1, g_sysmon_args, CLI_ARGS_COUNT(g_sysmon_args), &args) != 0)
+        {
+            break;
+        }
+
+        if (args.period)
+        {
+            rtos_monitor_period_set(args.period);
+            break;
+        }
+        rtos_monitor_print();
+    } while (0);
+    return 0;
+}
+#endif
+
 //=============================================================================
 //                  Public Function Definition
 //=============================================================================
@@ -1098,7 +1319,8 @@ const sh_cmd_t  g_cli_cmd_act_ep_req STATIC_CLI_CMD_ATTRIBUTE =
     .pCmd_name      = "ep",
     .cmd_exec       = _cli_cmd_zdo_act_ep_req,
     .pDescription   = "active endpoint request\n"
-    "  usage: ep [addr]\n"
+    "  usage: ep [addr] [r]\n"
+    "    cached list is shown unless r is given\n"
     "    e.g. ep 0x1234",
 };
 const sh_cmd_t  g_cli_cmd_simple_desc_req STATIC_CLI_CMD_ATTRIBUTE =
@@ -1106,7 +1328,8 @@ const sh_cmd_t  g_cli_cmd_simple_desc_req STATIC_CLI_CMD_ATTRIBUTE =
     .pCmd_name      = "simple",
     .cmd_exec       = _cli_cmd_zdo_simple_desc_req,
     .pDescription   = "simple descriptor request\n"
-    "  usage: simple [addr] [ep]\n"
+    "  usage: simple [addr] [ep] [r]\n"
+    "    cached descriptor is shown unless r is given\n"
     "    e.g. simple 0x1234 2",
 };
 const sh_cmd_t  g_cli_cmd_ed_scan_req STATIC_CLI_CMD_ATTRIBUTE =
@@ -1225,3 +1448,51 @@ const sh_cmd_t  g_cli_cmd_config_report STATIC_CLI_CMD_ATTRIBUTE =
     "  usage: cr [addr] [ep] [cluster id] [attribute id] [data type] [min_interval] [max interval]\n"
     "    e.g. cr 0x1234 2 0x0006 0x0000 0x10 0x1E 0x3D\n",
 };
+
+const sh_cmd_t  g_cli_cmd_report_agg STATIC_CLI_CMD_ATTRIBUTE =
+{
+    .pCmd_name      = "rptagg",
+    .cmd_exec       = _cli_cmd_report_agg,
+    .pDescription   = "report aggregation counters and per-cluster policy\n"
+    "  usage: rptagg [reset]\n"
+    "         rptagg policy [cluster] [min ms] [max ms] [delta]\n"
+    "    e.g. rptagg policy 0x0702 10000 300000 0\n",
+};
+const sh_cmd_t  g_cli_cmd_dev_dir STATIC_CLI_CMD_ATTRIBUTE =
+{
+    .pCmd_name      = "devs",
+    .cmd_exec       = _cli_cmd_dev_dir,
+    .pDescription   = "list the device directory\n"
+    "  usage: devs\n",
+};
+const sh_cmd_t  g_cli_cmd_ota_campaign STATIC_CLI_CMD_ATTRIBUTE =
+{
+    .pCmd_name      = "otacamp",
+    .cmd_exec       = _cli_cmd_ota_campaign,
+    .pDescription   = "OTA campaign progress and control\n"
+    "  usage: otacamp\n"
+    "         otacamp start [addr] ...   (no addr: every device that queries)\n"
+    "         otacamp stop\n"
+    "         otacamp cfg [max active] [blocks/s] [min period ms] [stall s] [max failures]\n"
+    "    e.g. otacamp cfg 4 20 0 60 3\n",
+};
+#if (configUSE_RTOS_TRACE == 1)
+const sh_cmd_t  g_cli_cmd_trace STATIC_CLI_CMD_ATTRIBUTE =
+{
+    .pCmd_name      = "trace",
+    .cmd_exec       = _cli_cmd_trace,
+    .pDescription   = "kernel trace recorder\n"
+    "  usage: trace dump|clear|on|off\n"
+    "    decode the dump with tools/rtos_trace/rtos_trace_decode.py\n",
+};
+#endif
+#if (configUSE_RTOS_MONITOR == 1)
+const sh_cmd_t  g_cli_cmd_sysmon STATIC_CLI_CMD_ATTRIBUTE =
+{
+    .pCmd_name      = "sysmon",
+    .cmd_exec       = _cli_cmd_sysmon,
+    .pDescription   = "per-task CPU, stack high-water and heap usage\n"
+    "  usage: sysmon              last sample\n"
+    "         sysmon [period ms]  sample period\n",
+};
+#endif
@@ -27,6 +27,7 @@
 #include "zigbee_cmd_nwk.h"
 #include "zigbee_cmd_app.h"
 #include "zigbee_cmd_ota.h"
+#include "gw_zcl_record.h"
 #include "flashctl.h"
 
 #include "uart_handler.h"
@@ -113,6 +114,14 @@ typedef struct __attribute__((packed)) {
     zone_status_change_notification_record_t att_status;
 } zone_status_change_notification_t;
 
+/* Context of zigbee_gw_cmd_send_records while splitting */
+typedef struct {
+    uint32_t cmd_id;
+    uint16_t addr;
+    uint8_t src_endp;
+    uint16_t cluster_id;
+} gw_cmd_records_t;
+
 
 
 //=============================================================================
@@ -125,7 +134,7 @@ static QueueHandle_t g_cmd_queue;
 //=============================================================================
 static void _zcl_basic_read_rsp_cb(uint16_t cluster_id, uint16_t addr,
                                    uint8_t src_endp, uint8_t* pd,
-                                   uint8_t pd_len) {
+                                   uint16_t pd_len) {
     read_attr_status_record_t* pt_record;
     uint8_t offset = 0, i;
     uint8_t *p_rsp_pd = NULL, rsp_pd_len = 0;
@@ -210,37 +219,22 @@ static void _zcl_basic_read_rsp_cb(uint16_t cluster_id, uint16_t addr,
 
 static void _zcl_basic_read_attribute_cb(uint16_t cluster_id, uint16_t addr,
                                          uint8_t src_endp, uint8_t* pd,
-                                         uint8_t pd_len) {
-    read_cluster_attr_rsp_t* pt_att_rsp = NULL;
-    uint8_t rsp_pd_len = 0;
-    do {
-
-        if (pd == NULL) {
-            break;
-        }
-
-        rsp_pd_len = pd_len + sizeof(cluster_id);
-        pt_att_rsp = pvPortMalloc(rsp_pd_len);
-        pt_att_rsp->cluster_id = cluster_id;
-        memcpy(&(pt_att_rsp->att_status), pd,
-               (rsp_pd_len - sizeof(cluster_id)));
-    } while (0);
-
-    if (pt_att_rsp) {
-        zigbee_gw_cmd_send(
-            GW_CMD_APP_CMD_RSP_GEN(GW_CMD_APP_SRV_GENERAL_COMMAND_BASE), addr,
-            0, src_endp, (uint8_t*)pt_att_rsp, rsp_pd_len);
-        vPortFree(pt_att_rsp);
-    } else {
-        log_error("Read attribute rsp malloc fail\n");
+                                         uint16_t pd_len) {
+    if (pd == NULL) {
+        return;
     }
+    /* The cluster id goes in front of the records, a response longer than
+     * one frame is split at record boundaries */
+    zigbee_gw_cmd_send_records(
+        GW_CMD_APP_CMD_RSP_GEN(GW_CMD_APP_SRV_GENERAL_COMMAND_BASE), addr,
+        src_endp, cluster_id, ZB_ZCL_CMD_READ_ATTRIB_RESP, pd, pd_len);
 }
 
 static void _zcl_basic_write_attribute_cb(uint16_t cluster_id, uint16_t addr,
                                           uint8_t src_endp, uint8_t* pd,
-                                          uint8_t pd_len) {
+                                          uint16_t pd_len) {
     write_cluster_attr_rsp_t* pt_att_rsp = NULL;
-    uint8_t rsp_pd_len = 0;
+    uint16_t rsp_pd_len = 0;
 
     do {
         if (pd == NULL) {
@@ -265,9 +259,9 @@ static void _zcl_basic_write_attribute_cb(uint16_t cluster_id, uint16_t addr,
 
 static void _zcl_basic_cfg_report_rsp_cb(uint16_t cluster_id, uint16_t addr,
                                          uint8_t src_endp, uint8_t* pd,
-                                         uint8_t pd_len) {
+                                         uint16_t pd_len) {
     cfg_report_rsp_t* pt_att_rsp = NULL;
-    uint8_t rsp_pd_len = 0;
+    uint16_t rsp_pd_len = 0;
     do {
 
         if (pd == NULL) {
@@ -1250,17 +1244,54 @@ void zigbee_gw_cmd_act(uint32_t cmd_id, uint16_t addr, uint8_t addr_mode,
     } while (0);
 }
 
-void zigbee_gw_cmd_send(uint32_t cmd_id, uint16_t addr, uint8_t addr_mode,
-                        uint8_t src_endp, uint8_t* pParam, uint32_t len) {
+int zigbee_gw_cmd_send(uint32_t cmd_id, uint16_t addr, uint8_t addr_mode,
+                       uint8_t src_endp, uint8_t* pParam, uint32_t len) {
+    return zigbee_gw_cmd_send_prefixed(cmd_id, addr, addr_mode, src_endp, NULL,
+                                       0, pParam, len);
+}
+
+static int _gw_cmd_records_chunk(const uint8_t* data, uint16_t len, void* arg) {
+    gw_cmd_records_t* r = arg;
+
+    return zigbee_gw_cmd_send_prefixed(r->cmd_id, r->addr, 0, r->src_endp,
+                                       (uint8_t*)&r->cluster_id,
+                                       sizeof(uint16_t), (uint8_t*)data, len);
+}
+
+int zigbee_gw_cmd_send_records(uint32_t cmd_id, uint16_t addr,
+                               uint8_t src_endp, uint16_t cluster_id,
+                               uint8_t zcl_cmd, uint8_t* pParam, uint32_t len) {
+    gw_cmd_records_t r = {cmd_id, addr, src_endp, cluster_id};
+
+    if (len > UINT16_MAX
+        || gw_zcl_record_split(zcl_cmd, pParam, len,
+                               ZIGBEE_GW_CMD_PARAM_MAX - sizeof(uint16_t),
+                               _gw_cmd_records_chunk, &r)) {
+        log_error("gw cmd %08X from 0x%04x cluster 0x%04x not fully sent, "
+                  "%d bytes", cmd_id, addr, cluster_id, len);
+        return -1;
+    }
+    return 0;
+}
+
+int zigbee_gw_cmd_send_prefixed(uint32_t cmd_id, uint16_t addr,
+                                uint8_t addr_mode, uint8_t src_endp,
+                                uint8_t* pPrefix, uint32_t prefix_len,
+                                uint8_t* pParam, uint32_t len) {
     _zb_app_data_t* zb_data = NULL;
     uint8_t* gateway_cmd_pkt;
     uint32_t pkt_len;
     uint32_t ep_len = 0;
     uint8_t idx = 0;
+    int ret = -1;
 
     do {
-        pkt_len = sizeof(gateway_cmd_hdr) + sizeof(gateway_cmd_pd) + len
-                  + sizeof(gateway_cmd_end);
+        if (prefix_len + len > ZIGBEE_GW_CMD_PARAM_MAX) {
+            log_error("gw cmd %08X too long %d", cmd_id, prefix_len + len);
+            break;
+        }
+        pkt_len = sizeof(gateway_cmd_hdr) + sizeof(gateway_cmd_pd) + prefix_len
+                  + len + sizeof(gateway_cmd_end);
 
         if (src_endp != 0) {
             pkt_len += 1;
@@ -1268,6 +1299,7 @@ void zigbee_gw_cmd_send(uint32_t cmd_id, uint16_t addr, uint8_t addr_mode,
         zb_data = pvPortMalloc(sizeof(_zb_app_data_t) + pkt_len);
 
         if (zb_data == NULL) {
+            log_error("gw cmd %08X no memory", cmd_id);
             break;
         }
 
@@ -1278,7 +1310,7 @@ void zigbee_gw_cmd_send(uint32_t cmd_id, uint16_t addr, uint8_t addr_mode,
         ((gateway_cmd_hdr*)(gateway_cmd_pkt))->header[2] = 0xFC;
         ((gateway_cmd_hdr*)(gateway_cmd_pkt))->header[3] = 0xFF;
         ((gateway_cmd_hdr*)(gateway_cmd_pkt))->len = sizeof(gateway_cmd_pd)
-                                                     + len;
+                                                     + prefix_len + len;
 
         if (src_endp != 0) {
             ((gateway_cmd_hdr*)(gateway_cmd_pkt))->len += 1;
@@ -1295,15 +1327,23 @@ void zigbee_gw_cmd_send(uint32_t cmd_id, uint16_t addr, uint8_t addr_mode,
             ep_len = 1;
             ((gateway_cmd_pd*)(&gateway_cmd_pkt[idx]))->parameter[0] = src_endp;
         }
-        memcpy(((gateway_cmd_pd*)(&gateway_cmd_pkt[idx]))->parameter + ep_len,
-               pParam, len);
+        /* Prefix and payload go straight into the frame, no staging buffer */
+        if (prefix_len) {
+            memcpy(((gateway_cmd_pd*)(&gateway_cmd_pkt[idx]))->parameter + ep_len,
+                   pPrefix, prefix_len);
+        }
+        if (len) {
+            memcpy(((gateway_cmd_pd*)(&gateway_cmd_pkt[idx]))->parameter + ep_len
+                       + prefix_len,
+                   pParam, len);
+        }
 
-        idx += sizeof(gateway_cmd_pd) + len + ep_len;
+        idx += sizeof(gateway_cmd_pd) + prefix_len + len + ep_len;
 
         ((gateway_cmd_end*)(&gateway_cmd_pkt[idx]))->cs =
             _gateway_checksum_calc(
                 (uint8_t*)&(((gateway_cmd_hdr*)(gateway_cmd_pkt))->len),
-                sizeof(gateway_cmd_pd) + len + 1 + ep_len);
+                sizeof(gateway_cmd_pd) + prefix_len + len + 1 + ep_len);
         // log_info("sizeof(gateway_cmd_pd): %02x", sizeof(gateway_cmd_pd));
         // log_info("len: %02x", (sizeof(gateway_cmd_pd) + len + 1 + ep_len));
         // log_info_hexdump("GW_TX", gateway_cmd_pkt, pkt_len);
@@ -1312,6 +1352,7 @@ void zigbee_gw_cmd_send(uint32_t cmd_id, uint16_t addr, uint8_t addr_mode,
         if(zb_data) {
             vPortFree(zb_data);
         }
+        ret = 0;
         // if (xQueueSend(g_cmd_queue, (void*)&zb_data, 0) != pdPASS) {
         //     log_error("q full!");
         //     vPortFree(zb_data);
@@ -1320,6 +1361,8 @@ void zigbee_gw_cmd_send(uint32_t cmd_id, uint16_t addr, uint8_t addr_mode,
         // }
 
     } while (0);
+
+    return ret;
 }
 
 void zigbee_gw_cmd_proc(uint8_t* pBuf, uint16_t len) {
@@ -25,6 +25,7 @@
 #include "zigbee_api.h"
 #include "zigbee_cmd_nwk.h"
 #include "zigbee_cmd_app.h"
+#include "gw_dev_dir.h"
 //=============================================================================
 //                Private Definitions of const value
 //=============================================================================
@@ -69,6 +70,9 @@ __cmd_gateway_install_code_remove_request(zigbee_cmd_req_t* pt_cmd_req);
 static void
 __cmd_gateway_install_code_remove_all_request(zigbee_cmd_req_t* pt_cmd_req);
 static void __cmd_gateway_standart_time_set(zigbee_cmd_req_t* pt_cmd_req);
+#if (configUSE_RTOS_MONITOR == 1)
+static void __cmd_gateway_sys_monitor_request(zigbee_cmd_req_t* pt_cmd_req);
+#endif
 static zigbee_cmd_func g_zb_cmd_func[] = {
     [ZIGBEE_CMD_NWK_ADDRESS_REQUEST] = __cmd_network_address_request,
     [ZIGBEE_CMD_IEEE_ADDRESS_REQUEST] = __cmd_ieee_address_request,
@@ -101,9 +105,16 @@ static zigbee_cmd_func g_zb_cmd_func[] = {
     [ZIGBEE_CMD_GATEWAY_INSTALL_CODE_REMOVE_ALL_REQUEST] =
         __cmd_gateway_install_code_remove_all_request,
     [ZIGBEE_CMD_GATEWAY_STANDARD_TIME_SET] = __cmd_gateway_standart_time_set,
+#if (configUSE_RTOS_MONITOR == 1)
+    [ZIGBEE_CMD_GATEWAY_SYS_MONITOR_REQUEST] =
+        __cmd_gateway_sys_monitor_request,
+#endif
 };
 
 static uint16_t g_tsn_adrr_tbl[0xFF] = {0};
+#if (configUSE_RTOS_MONITOR == 1)
+static volatile uint8_t g_sys_monitor_push = 0;
+#endif
 //=============================================================================
 //                Functions
 //=============================================================================
@@ -365,6 +376,7 @@ static void _simple_descriptor_response(zb_uint8_t param) {
 
         zb_copy_simple_desc((zb_af_simple_desc_1_1_t*)&prsp_pd[4],
                             &resp->simple_desc);
+        zigbee_app_dev_dir_desc_update(resp->hdr.nwk_addr, &resp->simple_desc);
         zb_buf_free(param);
     } while (0);
 
@@ -380,12 +392,43 @@ static void _simple_descriptor_response(zb_uint8_t param) {
     }
 }
 
+/* Same frame as _simple_descriptor_response, built from the directory */
+static void _simple_descriptor_cached(uint16_t nwk_addr, const gw_dev_desc_t* desc) {
+    uint8_t rsp_pd[12 + GW_DEV_DIR_CLUSTER_MAX * sizeof(uint16_t)];
+    uint8_t count = desc->in_count + desc->out_count;
+    uint8_t i;
+
+    rsp_pd[0] = 0x00;
+    memcpy(&rsp_pd[1], (uint8_t*)&nwk_addr, 2);
+    rsp_pd[3] = 8 + count * sizeof(uint16_t);
+    rsp_pd[4] = desc->endpoint;
+    memcpy(&rsp_pd[5], (uint8_t*)&desc->profile_id, 2);
+    memcpy(&rsp_pd[7], (uint8_t*)&desc->device_id, 2);
+    rsp_pd[9] = desc->device_version;
+    rsp_pd[10] = desc->in_count;
+    rsp_pd[11] = desc->out_count;
+    for (i = 0; i < count; i++) {
+        memcpy(&rsp_pd[12 + i * 2], (uint8_t*)&desc->clusters[i], 2);
+    }
+
+    zigbee_gw_cmd_send((ZIGBEE_CMD_SIMPLE_DESCRIPTOR_REQUEST | 0x8000),
+                       nwk_addr, 0, 0, rsp_pd, 12 + count * sizeof(uint16_t));
+}
+
 static void __cmd_simple_descriptor_request(zigbee_cmd_req_t* pt_cmd_req) {
     zb_zdo_simple_desc_req_t* req_param;
+    const gw_dev_desc_t* desc;
     zb_bufid_t buf;
     uint8_t* pdata;
 
     do {
+        pdata = (uint8_t*)pt_cmd_req->cmd_value;
+        desc = gw_dev_dir_get_desc(pdata[0] | (pdata[1] << 8), pdata[2]);
+        if (desc) {
+            _simple_descriptor_cached(pdata[0] | (pdata[1] << 8), desc);
+            break;
+        }
+
         buf = zb_buf_get_out();
         if (!buf) {
             break;
@@ -425,6 +468,7 @@ static void _active_endpoint_response(zb_uint8_t param) {
         memcpy(&prsp_pd[1], (uint8_t*)&resp->nwk_addr, 2);
         prsp_pd[3] = resp->ep_count;
         memcpy(&prsp_pd[4], ep_list, resp->ep_count);
+        gw_dev_dir_set_endpoints(resp->nwk_addr, resp->ep_count, ep_list);
         zb_buf_free(param);
     } while (0);
 
@@ -444,10 +488,24 @@ static void _active_endpoint_response(zb_uint8_t param) {
 
 static void __cmd_active_endpoint_request(zigbee_cmd_req_t* pt_cmd_req) {
     zb_zdo_active_ep_req_t* req_param;
+    uint8_t rsp_pd[4 + GW_DEV_DIR_EP_MAX];
     zb_bufid_t buf;
     uint8_t* pdata;
+    gw_dev_t* dev;
 
     do {
+        pdata = (uint8_t*)pt_cmd_req->cmd_value;
+        dev = gw_dev_dir_find_short(pdata[0] | (pdata[1] << 8));
+        if (dev && dev->ep_valid) {
+            rsp_pd[0] = 0x00;
+            memcpy(&rsp_pd[1], (uint8_t*)&dev->short_addr, 2);
+            rsp_pd[3] = dev->ep_count;
+            memcpy(&rsp_pd[4], dev->ep_list, dev->ep_count);
+            zigbee_gw_cmd_send((ZIGBEE_CMD_ACTIVE_ENDPOINT_REQUEST | 0x8000),
+                               dev->short_addr, 0, 0, rsp_pd, 4 + dev->ep_count);
+            break;
+        }
+
         buf = zb_buf_get_out();
         if (!buf) {
             break;
@@ -1065,6 +1123,25 @@ static void __cmd_gateway_standart_time_set(zigbee_cmd_req_t* pt_cmd_req) {
     } while (0);
 }
 
+#if (configUSE_RTOS_MONITOR == 1)
+/* param: push every sample (u8), optional sample period ms (u16) */
+static void __cmd_gateway_sys_monitor_request(zigbee_cmd_req_t* pt_cmd_req) {
+    uint8_t* pdata = (uint8_t*)pt_cmd_req->cmd_value;
+    uint16_t period;
+
+    if (pt_cmd_req->cmd_length >= 1) {
+        g_sys_monitor_push = pdata[0] ? 1 : 0;
+    }
+    if (pt_cmd_req->cmd_length >= 3) {
+        period = pdata[1] | (pdata[2] << 8);
+        if (period) {
+            rtos_monitor_period_set(period);
+        }
+    }
+    zigbee_sys_monitor_send();
+}
+#endif
+
 static void __cmd_handle(zigbee_cmd_req_t* pt_cmd_req) {
     if (g_zb_cmd_func[pt_cmd_req->cmd_index]) {
         ZB_THREAD_SAFE(g_zb_cmd_func[pt_cmd_req->cmd_index](pt_cmd_req););
@@ -1095,3 +1172,20 @@ void zigbee_cmd_request(uint16_t dst_addr, uint32_t t_index, uint32_t u32_len,
     if (pt_cmd_req != NULL)
         vPortFree(pt_cmd_req);
 }
+
+#if (configUSE_RTOS_MONITOR == 1)
+void zigbee_sys_monitor_sampled(void) {
+    if (g_sys_monitor_push) {
+        ZIGBEE_APP_NOTIFY(ZB_APP_EVENT_SYS_MONITOR);
+    }
+}
+
+void zigbee_sys_monitor_send(void) {
+    uint8_t record[ZIGBEE_GW_CMD_PARAM_MAX];
+    uint16_t len;
+
+    len = rtos_monitor_record(record, sizeof(record));
+    zigbee_gw_cmd_send((ZIGBEE_CMD_GATEWAY_SYS_MONITOR_REQUEST | 0x8000),
+                       0x0000, 0, 0, record, len);
+}
+#endif
@@ -26,6 +26,7 @@
 #include "zigbee_cmd_nwk.h"
 #include "zigbee_cmd_app.h"
 #include "zigbee_cmd_ota.h"
+#include "gw_ota_sched.h"
 //=============================================================================
 //                Private Definitions of const value
 //=============================================================================
@@ -96,7 +97,7 @@ ota_upgrade_test_file_t ota_file =
 zb_ret_t next_data_ind_cb(zb_uint8_t index, zb_zcl_parsed_hdr_t *zcl_hdr, zb_uint32_t offset,
     zb_uint8_t size, zb_uint8_t **data)
 {
-    *data = ((ota_file.pdata) + offset);
+    *data = (zb_uint8_t *)gw_ota_sched_data(offset, size);
     return RET_OK;
 }
 //=============================================================================
@@ -123,6 +124,7 @@ void insert_ota_file(zb_uint8_t param)
 {
     zb_ret_t ret;
     ZB_ZCL_OTA_UPGRADE_INSERT_FILE(param, 1, 0, (zb_uint8_t *)(&ota_file), 0, ZB_TRUE, ret);
+    gw_ota_sched_image_set(ota_file.pdata, ota_file.head.total_image_size);
     ota_image_ready = 1;
 }
 void remove_ota_file(zb_uint8_t param)
@@ -130,6 +132,7 @@ void remove_ota_file(zb_uint8_t param)
     zb_ret_t ret;
     uint8_t ota_ep = get_endpoint_by_cluster(ZB_ZCL_CLUSTER_ID_OTA_UPGRADE, ZB_ZCL_CLUSTER_SERVER_ROLE);
     ZB_ZCL_OTA_UPGRADE_REMOVE_FILE(param, ota_ep, 0, ret);
+    gw_ota_sched_image_set(NULL, 0);
     ota_image_ready = 0;
 
     zigbee_gw_cmd_send((GW_CMD_OTA_FILE_REMOVE_REQUEST | 0x8000), 0, 0, 0, (uint8_t *)&ret, 4);
@@ -228,6 +231,12 @@ static void _ota_candidate_set(uint16_t  candidate)
     uint8_t status = 0;
     ota_candidate = candidate;
     log_info("Set OTA Candidate 0x%04x", candidate);
+    /* A candidate is a campaign of one device, 0xFFFF an open campaign */
+    if (candidate == 0x0000) {
+        ZB_THREAD_SAFE(gw_ota_sched_stop();)
+    } else {
+        ZB_THREAD_SAFE(gw_ota_sched_start(&candidate, (candidate == 0xFFFF) ? 0 : 1);)
+    }
     zigbee_gw_cmd_send((GW_CMD_OTA_CANDIDATE_SET | 0x8000), 0x0000, 0, 0,
                         &status, 1);
 }
@@ -236,6 +245,7 @@ static void _ota_candidate_remove(void)
 {
     uint8_t status = 0;
     ota_candidate = 0;
+    ZB_THREAD_SAFE(gw_ota_sched_stop();)
     log_info("Remove OTA Candidate");
     zigbee_gw_cmd_send((GW_CMD_OTA_CANDIDATE_REMOVE | 0x8000), 0x0000, 0, 0,
                         &status, 1);
@@ -262,39 +272,103 @@ static void _ota_file_info_get(void)
                             (uint8_t *)&file_info, sizeof(ota_file_info_t));
 }
 
-static inline uint8_t progress_percent(uint32_t offset,
-    uint32_t total_length)
+static void _ota_campaign_start(uint8_t *pBuf)
 {
-    if (total_length == 0) {
-    return 0xFF;
-    }
-
-    uint32_t percent = offset * 100u / total_length;
-    if (percent > 100u) {
-    percent = 100u;
+    gw_ota_sched_cfg_t cfg;
+    uint16_t addrs[(ZIGBEE_GW_CMD_PARAM_MAX - 9) / 2];
+    uint16_t stall_s;
+    uint8_t count, status = 1;
+
+    //pBuf[0]:    max devices downloading at the same time
+    //pBuf[1]:    failed attempts before a device is given up
+    //pBuf[2~3]:  blocks per second shared by the active devices
+    //pBuf[4~5]:  minimum block period of one device in ms
+    //pBuf[6~7]:  seconds without a block before a device loses its slot
+    //pBuf[8]:    device count, 0 for every device that queries
+    //pBuf[9~]:   device short addresses
+    cfg.max_active = pBuf[0];
+    cfg.max_failures = pBuf[1];
+    memcpy(&cfg.block_rate, &pBuf[2], 2);
+    memcpy(&cfg.min_period_ms, &pBuf[4], 2);
+    memcpy(&stall_s, &pBuf[6], 2);
+    cfg.stall_ms = stall_s * 1000;
+    count = pBuf[8];
+
+    if (count <= (ZIGBEE_GW_CMD_PARAM_MAX - 9) / 2 && count <= GW_OTA_SCHED_DEV_MAX)
+    {
+        memcpy(addrs, &pBuf[9], count * 2);
+        ZB_THREAD_SAFE(gw_ota_sched_cfg_set(&cfg);
+                       if (gw_ota_sched_start(addrs, count))
+                       {
+                           status = 0;
+                       })
     }
+    zigbee_gw_cmd_send((GW_CMD_OTA_CAMPAIGN_START | 0x8000), 0x0000, 0, 0, &status, 1);
+}
 
-    static uint8_t last_percent = 0xFFu;
+static void _ota_campaign_stop(void)
+{
+    uint8_t status = 0;
 
-    if (percent != last_percent) {
-    last_percent = (uint8_t)percent;
-    return last_percent;
-    }
+    ZB_THREAD_SAFE(gw_ota_sched_stop();)
+    zigbee_gw_cmd_send((GW_CMD_OTA_CAMPAIGN_STOP | 0x8000), 0x0000, 0, 0, &status, 1);
+}
 
-    return 0xFFu;
+static void _ota_campaign_status(uint8_t *pBuf)
+{
+    uint8_t data[30 + GW_OTA_SCHED_STATUS_RECORDS * 5];
+    gw_ota_sched_stats_t stats;
+    const gw_ota_dev_t *dev;
+    uint16_t start, total, i;
+    uint8_t n = 0, len;
+
+    //data[0]:      campaign running
+    //data[1~8]:    pending, active, done, failed device counts
+    //data[9~24]:   blocks served, wait responses, cache hits, cache misses
+    //data[25~26]:  devices in the campaign
+    //data[27~28]:  index of the first record
+    //data[29]:     record count
+    //data[30~]:    records of short address(2), state(1), percent(1), failures(1)
+    memcpy(&start, pBuf, 2);
+    len = 30;
+    ZB_THREAD_SAFE(
+        gw_ota_sched_stats_get(&stats);
+        total = gw_ota_sched_count();
+        data[0] = gw_ota_sched_running();
+        for (i = start; i < total && n < GW_OTA_SCHED_STATUS_RECORDS; i++, n++)
+        {
+            dev = gw_ota_sched_get(i);
+            memcpy(&data[len], &dev->short_addr, 2);
+            data[len + 2] = dev->state;
+            data[len + 3] = dev->percent;
+            data[len + 4] = dev->failures;
+            len += 5;
+        }
+    )
+
+    memcpy(&data[1], &stats.pending, 2);
+    memcpy(&data[3], &stats.active, 2);
+    memcpy(&data[5], &stats.done, 2);
+    memcpy(&data[7], &stats.failed, 2);
+    memcpy(&data[9], &stats.blocks, 4);
+    memcpy(&data[13], &stats.waits, 4);
+    memcpy(&data[17], &stats.cache_hits, 4);
+    memcpy(&data[21], &stats.cache_misses, 4);
+    memcpy(&data[25], &total, 2);
+    memcpy(&data[27], &start, 2);
+    data[29] = n;
+    zigbee_gw_cmd_send((GW_CMD_OTA_CAMPAIGN_STATUS | 0x8000), 0x0000, 0, 0, data, len);
 }
 
 void zigbee_gw_ota_cb(uint8_t param) {
     uint8_t data[10];
-    uint8_t progress = 0;
-    static uint8_t count=0;
     zb_zcl_device_callback_param_t *device_cb_param = ZB_BUF_GET_PARAM(param, zb_zcl_device_callback_param_t);
     switch (device_cb_param->device_cb_id)
     {
         case ZB_ZCL_OTA_UPGRADE_SRV_QUERY_IMAGE_CB_ID:
         {
             zb_zcl_ota_upgrade_srv_query_img_param_t *value = &device_cb_param->cb_param.ota_upgrade_srv_query_img_param;
-            if((value->zcl_addr->u.short_addr == ota_candidate || ota_candidate == 0xFFFF) && ota_image_ready==1)
+            if(ota_image_ready==1 && gw_ota_sched_query(value->zcl_addr->u.short_addr))
                 device_cb_param->status = RET_OK;
             else
                 device_cb_param->status = RET_DEVICE_NOT_FOUND;
@@ -309,27 +383,9 @@ void zigbee_gw_ota_cb(uint8_t param) {
         case ZB_ZCL_OTA_UPGRADE_SRV_IMAGE_BLOCK_CB_ID:
         {
             zb_zcl_ota_upgrade_srv_image_block_param_t *value1 = &device_cb_param->cb_param.ota_upgrade_srv_image_block_param;
-            /* OTA server process image block upgrade */
-            if(count==50)
-            {
-                progress = progress_percent(value1->file_offset, gt_img_info.image_size);
-                if(progress != 0xFF)
-                {   
-                    //data[0~1]: device short address
-                    //data[2]:   status, 0:update progress in percentage
-                    //                   1:update finished & successed
-                    //                   2:update aborted
-                    //data[3]:   progress in percent when "status" is 0 or 1, not valid for status = 2 
-                    memcpy(data, &value1->zcl_addr->u.short_addr, 2);
-                    data[2] = 0;
-                    data[3] = progress;
-                    
-                    zigbee_gw_cmd_send(GW_CMD_OTA_UPGRADE_STATUS_RESPONSE, 0x0000, 0, 0, &data[0], 4);
-                }
-                count=0;
-            }
-            else
-                count++; 
+            /* OTA server process image block upgrade, the scheduler reports
+               GW_OTA_STATUS_PROGRESS per device */
+            gw_ota_sched_block_sent(value1->zcl_addr->u.short_addr, value1->file_offset);
         }
         break;        
         case ZB_ZCL_OTA_UPGRADE_SRV_UPGRADE_ABORTED_CB_ID:
@@ -341,33 +397,23 @@ void zigbee_gw_ota_cb(uint8_t param) {
             //                   1:update finished & successed
             //                   2:server update aborted
             //                   3:client update aborted
-            //data[3]:   progress in percent when "status" is 0 or 1, not valid for status is 2 or 3  
-            memcpy(data, &value2->zcl_addr->u.short_addr, 2);
-            data[2] = 2; //aborted
-            data[3] = 0xFF;
-            
-            zigbee_gw_cmd_send(GW_CMD_OTA_UPGRADE_STATUS_RESPONSE, 0x0000, 0, 0, &data[0], 4);
+            //                   4:stalled, no block for the stall time
+            //data[3]:   progress in percent when "status" is 0, 1 or 4, not valid for status is 2 or 3  
+            gw_ota_sched_end(value2->zcl_addr->u.short_addr, GW_OTA_STATUS_SERVER_ABORT);
         }
         break;
         case ZB_ZCL_OTA_UPGRADE_SRV_UPGRADE_END_CB_ID:
         {
             /* OTA server process upgrade end */
             zb_zcl_ota_upgrade_srv_upgrade_end_param_t *value3 = &device_cb_param->cb_param.ota_upgrade_srv_upgrade_end_param;
-            memcpy(data, &value3->zcl_addr->u.short_addr, 2);
 
             if(value3->status == 0x00)
             {
-                data[2] = 1; //success
-                data[3] = 0x64; //100% finished
-                
-                zigbee_gw_cmd_send(GW_CMD_OTA_UPGRADE_STATUS_RESPONSE, 0x0000, 0, 0, &data[0], 4);
+                gw_ota_sched_end(value3->zcl_addr->u.short_addr, GW_OTA_STATUS_FINISHED);
             }
             if(value3->status == 0x95)
             {
-                data[2] = 3; //client aborted
-                data[3] = 0xFF; 
-                
-                zigbee_gw_cmd_send(GW_CMD_OTA_UPGRADE_STATUS_RESPONSE, 0x0000, 0, 0, &data[0], 4);
+                gw_ota_sched_end(value3->zcl_addr->u.short_addr, GW_OTA_STATUS_CLIENT_ABORT);
             }
         }
         break;
@@ -535,4 +581,16 @@ void _gw_ota_cmd_handle(uint32_t cmd_id, uint8_t *pBuf)
     {
         _ota_file_info_get();
     }
+    else if (cmd_id == GW_CMD_OTA_CAMPAIGN_START)
+    {
+        _ota_campaign_start(pBuf);
+    }
+    else if (cmd_id == GW_CMD_OTA_CAMPAIGN_STOP)
+    {
+        _ota_campaign_stop();
+    }
+    else if (cmd_id == GW_CMD_OTA_CAMPAIGN_STATUS)
+    {
+        _ota_campaign_status(pBuf);
+    }
 }
@@ -21,8 +21,16 @@
 #include "zigbee_api.h"
 #include "log.h"
 #include "zigbee_cmd_app.h"
+#include "zigbee_zcl_msg_handler.h"
+#include "gw_report_agg.h"
+#include "gw_ota_sched.h"
 
 #define ZB_TRACE_FILE_ID 294
+
+/* Log every reported or read attribute, costs the ZBOSS callback time */
+#ifndef ZIGBEE_GW_REPORT_DECODE
+#define ZIGBEE_GW_REPORT_DECODE 0
+#endif
 //=============================================================================
 //                Global variables
 //=============================================================================
@@ -57,100 +65,9 @@ void zigbee_app_zcl_zone_status_change_notification_reg(void* cb) {
         (zcl_zone_status_change_notification_cb)cb;
 }
 
-static uint16_t get_attribute_size(uint8_t attr_type, uint8_t *data)
-{
-    uint16_t ret;
-    switch ( attr_type )
-    {
-    case ZB_ZCL_ATTR_TYPE_8BIT:
-    case ZB_ZCL_ATTR_TYPE_U8:
-    case ZB_ZCL_ATTR_TYPE_S8:
-    case ZB_ZCL_ATTR_TYPE_BOOL:
-    case ZB_ZCL_ATTR_TYPE_8BITMAP:
-    case ZB_ZCL_ATTR_TYPE_8BIT_ENUM:
-        ret = 1;
-        break;
-
-    case ZB_ZCL_ATTR_TYPE_16BIT:
-    case ZB_ZCL_ATTR_TYPE_U16:
-    case ZB_ZCL_ATTR_TYPE_S16:
-    case ZB_ZCL_ATTR_TYPE_16BITMAP:
-    case ZB_ZCL_ATTR_TYPE_16BIT_ENUM:
-    case ZB_ZCL_ATTR_TYPE_SEMI:
-    case ZB_ZCL_ATTR_TYPE_CLUSTER_ID:
-    case ZB_ZCL_ATTR_TYPE_ATTRIBUTE_ID:
-        ret = 2;
-        break;
-
-    case ZB_ZCL_ATTR_TYPE_32BIT:
-    case ZB_ZCL_ATTR_TYPE_U32:
-    case ZB_ZCL_ATTR_TYPE_S32:
-    case ZB_ZCL_ATTR_TYPE_32BITMAP:
-    case ZB_ZCL_ATTR_TYPE_UTC_TIME:
-    case ZB_ZCL_ATTR_TYPE_TIME_OF_DAY:
-    case ZB_ZCL_ATTR_TYPE_DATE:
-    case ZB_ZCL_ATTR_TYPE_BACNET_OID:
-    case ZB_ZCL_ATTR_TYPE_SINGLE:
-        ret = 4;
-        break;
-
-    case ZB_ZCL_ATTR_TYPE_S48:
-    case ZB_ZCL_ATTR_TYPE_U48:
-    case ZB_ZCL_ATTR_TYPE_48BIT:
-    case ZB_ZCL_ATTR_TYPE_48BITMAP:
-        ret = 6;
-        break;
-
-    case ZB_ZCL_ATTR_TYPE_S24:
-    case ZB_ZCL_ATTR_TYPE_U24:
-    case ZB_ZCL_ATTR_TYPE_24BIT:
-    case ZB_ZCL_ATTR_TYPE_24BITMAP:
-        ret = 3;
-        break;
-
-    case ZB_ZCL_ATTR_TYPE_U40:
-    case ZB_ZCL_ATTR_TYPE_S40:
-    case ZB_ZCL_ATTR_TYPE_40BIT:
-    case ZB_ZCL_ATTR_TYPE_40BITMAP:
-        ret = 5;
-        break;
-
-    case ZB_ZCL_ATTR_TYPE_U56:
-    case ZB_ZCL_ATTR_TYPE_S56:
-    case ZB_ZCL_ATTR_TYPE_56BIT:
-    case ZB_ZCL_ATTR_TYPE_56BITMAP:
-        ret = 7;
-        break;
-
-    case ZB_ZCL_ATTR_TYPE_64BIT:
-    case ZB_ZCL_ATTR_TYPE_64BITMAP:
-    case ZB_ZCL_ATTR_TYPE_U64:
-    case ZB_ZCL_ATTR_TYPE_S64:
-    case ZB_ZCL_ATTR_TYPE_DOUBLE:
-    case ZB_ZCL_ATTR_TYPE_IEEE_ADDR:
-        ret = 8;
-        break;
-    case ZB_ZCL_ATTR_TYPE_128_BIT_KEY:
-        ret = 16;
-        break;
-    case ZB_ZCL_ATTR_TYPE_OCTET_STRING:
-    case ZB_ZCL_ATTR_TYPE_CHAR_STRING:
-        ret = data[0] + 1;
-        break;
-    case ZB_ZCL_ATTR_TYPE_ARRAY:
-    case ZB_ZCL_ATTR_TYPE_CUSTOM_32ARRAY:
-    case ZB_ZCL_ATTR_TYPE_LONG_OCTET_STRING:
-        ret = data[0] | (data[1] << 8) + 2;
-        break;
-
-    default:
-        ret = 0;
-        break;
-    }
-    return ret;
-}
-
-void _zcl_read_attr_report_process(uint8_t cmd, uint16_t clusterID, uint16_t srcAddr, uint16_t datalen, uint8_t *pdata)
+#if (ZIGBEE_GW_REPORT_DECODE == 1)
+/* Diagnostic decoding, kept off the forwarding path unless enabled */
+static void _zcl_read_attr_report_process(uint8_t cmd, uint16_t clusterID, uint16_t srcAddr, uint16_t datalen, uint8_t *pdata)
 {
     if (cmd == ZB_ZCL_CMD_READ_ATTRIB_RESP)
     {
@@ -162,47 +79,34 @@ void _zcl_read_attr_report_process(uint8_t cmd, uint16_t clusterID, uint16_t src
     }
     uint16_t attr_id, attr_len;
     uint8_t attr_type;
-    int i = 0, j;
+    int i = 0;
 
-    while (i < datalen)
+    while (i + 3 <= datalen)
     {
         attr_id = pdata[i] | (pdata[i + 1] << 8);
-        if (cmd == 0x01)
+        if (cmd == ZB_ZCL_CMD_READ_ATTRIB_RESP)
         {
+            if (pdata[i + 2] != ZB_ZCL_STATUS_SUCCESS)
+            {
+                log_info("attribute id: 0x%04x, status: 0x%x", attr_id, pdata[i + 2]);
+                i += 3;
+                continue;
+            }
             i++;
         }
         attr_type = pdata[i + 2];
-
-        attr_len = get_attribute_size(attr_type, pdata + i + 3);
-        char tempStr[attr_len];
-        log_info("attribute id: 0x%04x, ", attr_id);
-        log_info("type: 0x%x, ", attr_type);
-        for (j = 0; j < attr_len; j++)
+        attr_len = zigbee_zcl_attr_size(attr_type, pdata + i + 3, datalen - (i + 3));
+        if (attr_len == 0)
         {
-            if (attr_type == ZB_ZCL_ATTR_TYPE_OCTET_STRING ||
-                    attr_type == ZB_ZCL_ATTR_TYPE_CHAR_STRING)
-            {
-                if (j > 0)
-                {
-                    sprintf(tempStr+j,"%c", pdata[i + 3 + j]);
-                }
-            }
-            else if (attr_type == ZB_ZCL_ATTR_TYPE_LONG_OCTET_STRING)
-            {
-                if (j > 1)
-                {
-                    sprintf(tempStr+j,"%c", pdata[i + 3 + j]);
-                }
-            }
-            else
-            {
-                sprintf(tempStr+j,"%x", pdata[i + 2 + attr_len - j]);
-            }
+            break;
         }
+        log_info("attribute id: 0x%04x, type: 0x%x", attr_id, attr_type);
+        log_info_hexdump("value", pdata + i + 3, attr_len);
         i += (3 + attr_len);
-        log_info("value: %s", tempStr);
     }
 }
+#endif
+
 uint8_t zigbee_zcl_msg_handler(zb_uint8_t param) {
     zb_bufid_t zcl_cmd_buf = param;
     zb_uint8_t cmd_processed = 0;
@@ -219,12 +123,16 @@ uint8_t zigbee_zcl_msg_handler(zb_uint8_t param) {
         ZB_ZCL_PARSED_HDR_SHORT_DATA(cmd_info).source.u.short_addr;
     zb_uint8_t dst_ep = ZB_ZCL_PARSED_HDR_SHORT_DATA(cmd_info).src_endpoint;
 
-    if (cmd_info->cluster_id == ZB_ZCL_CLUSTER_ID_OTA_UPGRADE) {
-        return ZB_FALSE;
+    /* Block requests paced by the campaign are answered and freed here,
+     * other OTA frames go on like any cluster and then to the OTA server */
+    if (cmd_info->cluster_id == ZB_ZCL_CLUSTER_ID_OTA_UPGRADE
+        && gw_ota_sched_frame(param)) {
+        return ZB_TRUE;
     }
 
     if (cmd_info->addr_data.common_data.source.addr_type == 0) {
         src_addr = ZB_ZCL_PARSED_HDR_SHORT_DATA(cmd_info).source.u.short_addr;
+        zigbee_app_dev_dir_seen(src_addr);
     }
 
     src_ep = ZB_ZCL_PARSED_HDR_SHORT_DATA(cmd_info).src_endpoint;
@@ -240,7 +148,9 @@ uint8_t zigbee_zcl_msg_handler(zb_uint8_t param) {
     if (cmd_info->is_common_command) {
         if (cmd_info->cmd_id == ZB_ZCL_CMD_READ_ATTRIB_RESP) // Read response
         {
+#if (ZIGBEE_GW_REPORT_DECODE == 1)
             _zcl_read_attr_report_process(cmd_info->cmd_id, cmd_info->cluster_id, src_addr, payload_size, pData);
+#endif
             if (p_read_rsp_cb) {
                 p_read_rsp_cb(cmd_info->cluster_id, src_addr, src_ep, pData,
                               payload_size);
@@ -261,21 +171,19 @@ uint8_t zigbee_zcl_msg_handler(zb_uint8_t param) {
         {
             // zigbee_app_zcl_report_attribute_cb_reg(_zcl_report_attribute_cb);
             // p_report_attribute_cb(cmd_info->cluster_id, src_addr, src_ep, pData, payload_size);
+#if (ZIGBEE_GW_REPORT_DECODE == 1)
             _zcl_read_attr_report_process(cmd_info->cmd_id, cmd_info->cluster_id, src_addr, payload_size, pData);
-            uint8_t report_data[100];
-            memcpy(report_data, &(cmd_info->cluster_id), sizeof(zb_uint16_t));
-            memcpy(report_data + sizeof(zb_uint16_t), pData, payload_size);
-            payload_size += sizeof(zb_uint16_t);
-            zigbee_gw_cmd_send(0x00028800, src_addr, 0, src_ep, report_data,
-                               payload_size);
+#endif
+            if (!gw_report_agg_input(cmd_info->cluster_id, src_addr, src_ep, pData, payload_size))
+            {
+                zigbee_gw_cmd_send_records(0x00028800, src_addr, src_ep, cmd_info->cluster_id,
+                                           ZB_ZCL_CMD_REPORT_ATTRIB, pData, payload_size);
+            }
         } else if (cmd_info->cmd_id == ZB_ZCL_CMD_DEFAULT_RESP) // defaut response
         {
-            uint8_t report_data[4];
-            memcpy(report_data, &(cmd_info->cluster_id), sizeof(zb_uint16_t));
-            memcpy(report_data + sizeof(zb_uint16_t), pData, payload_size);
-            payload_size += sizeof(zb_uint16_t);
-            zigbee_gw_cmd_send(0x00018800, src_addr, 0, src_ep, report_data,
-                               payload_size);
+            zigbee_gw_cmd_send_prefixed(0x00018800, src_addr, 0, src_ep,
+                                        (uint8_t*)&(cmd_info->cluster_id),
+                                        sizeof(zb_uint16_t), pData, payload_size);
         }
     } else {
         if (cmd_info->cluster_id == ZB_ZCL_CLUSTER_ID_IDENTIFY) {
@@ -317,18 +225,20 @@ uint8_t zigbee_zcl_msg_handler(zb_uint8_t param) {
                                src_ep, pData, payload_size);
         } else if (cmd_info->cluster_id >= 0xFC00) {
 
-            uint8_t custom_payload_data[payload_size + 6];
-            custom_payload_data[0] = cmd_info->cluster_id & 0xFF;
-            custom_payload_data[1] = (cmd_info->cluster_id >> 8) & 0xFF;
-            custom_payload_data[2] = cmd_info->manuf_specific & 0xFF;
-            custom_payload_data[3] = (cmd_info->manuf_specific >> 8) & 0xFF;
-            custom_payload_data[4] = cmd_info->cmd_id;
-            custom_payload_data[5] = payload_size;
-            if (payload_size > 0) {
-                memcpy(&custom_payload_data[6], pData, payload_size);
+            uint8_t custom_hdr[6];
+            custom_hdr[0] = cmd_info->cluster_id & 0xFF;
+            custom_hdr[1] = (cmd_info->cluster_id >> 8) & 0xFF;
+            custom_hdr[2] = cmd_info->manuf_specific & 0xFF;
+            custom_hdr[3] = (cmd_info->manuf_specific >> 8) & 0xFF;
+            custom_hdr[4] = cmd_info->cmd_id;
+            custom_hdr[5] = payload_size;
+            /* The payload is opaque here, it cannot be split */
+            if (zigbee_gw_cmd_send_prefixed(0xFC008000, src_addr, 0, src_ep,
+                                            custom_hdr, sizeof(custom_hdr),
+                                            pData, payload_size)) {
+                log_error("Cluster 0x%04x cmd 0x%02x from 0x%04x not forwarded",
+                          cmd_info->cluster_id, cmd_info->cmd_id, src_addr);
             }
-            zigbee_gw_cmd_send(0xFC008000, src_addr, 0, src_ep,
-                               custom_payload_data, payload_size + 6);
         }
     }
 
@@ -57,6 +57,7 @@ void zigbee_start_identify(void);
 void zigbee_zcl_set_attrubute(uint8_t ep, uint16_t cluster, uint8_t role, uint16_t attr_id, uint8_t* val);
 void zigbee_app_set_measured_value(uint16_t value);
 void start_sensor_timer(void);
+void zigbee_app_sensor_report_now(void);
 
 void reset_attr(void);
 uint32_t get_identify_time(void);
@@ -91,6 +91,7 @@ void app_main_loop(void* parameters_ptr) {
 
                     log_info("PAN ID: %04X, Short Addr: %04X, Channel: %d",
                              g_panid, g_short_addr, g_joined_channel);
+                    zigbee_app_sensor_report_now();
 
                 } break;
 
@@ -24,6 +24,7 @@
 #include "log.h"
 #include "zigbee_api.h"
 #include "device_api.h"
+#include "sensor_report.h"
 #include "zigbee_platform.h"
 #include "zigbee_zcl_msg_handler.h"
 #include "hosal_gpio.h"
@@ -43,28 +44,138 @@ static TimerHandle_t tmr_identify;
 static TaskHandle_t zb_app_taskHandle;
 static TimerHandle_t sensor_timer;
 int16_t simulated_measured_value[5] = {2800, 3200, 1650, 2480, 2560};
+uint16_t simulated_humidity_value[5] = {4500, 4520, 5100, 4980, 4700};
 
+#define SENSOR_SAMPLE_PERIOD_MS 60000
+
+static bool sensor_sample(uint8_t idx, int32_t* value);
+static void sensor_write(sensor_report_t* ctx, uint32_t mask);
+static bool sensor_report_cfg(const sensor_report_attr_t* attr,
+                              sensor_report_cfg_t* cfg);
+
+/* Defaults apply until a remote Configure Reporting sets the attribute up */
+static sensor_report_attr_t sensor_attrs[] = {
+    {
+        .ep = TEMPERATURE_SENSOR_EP,
+        .zcl_type = ZB_ZCL_ATTR_TYPE_S16,
+        .cluster = ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
+        .attr_id = ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,
+        .cfg = {.min_interval_ms = 10000, .max_interval_ms = 3600000, .delta = 50},
+        .hysteresis = 20,
+    },
+    {
+        .ep = TEMPERATURE_SENSOR_EP,
+        .zcl_type = ZB_ZCL_ATTR_TYPE_U16,
+        .cluster = ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT,
+        .attr_id = ZB_ZCL_ATTR_REL_HUMIDITY_MEASUREMENT_VALUE_ID,
+        .cfg = {.min_interval_ms = 10000, .max_interval_ms = 3600000, .delta = 100},
+        .hysteresis = 50,
+    },
+};
+
+static sensor_report_t sensor_ctx = {
+    .attrs = sensor_attrs,
+    .attr_num = sizeof(sensor_attrs) / sizeof(sensor_attrs[0]),
+    .sample_period_ms = SENSOR_SAMPLE_PERIOD_MS,
+    .sample = sensor_sample,
+    .write = sensor_write,
+    .cfg = sensor_report_cfg,
+};
 
 //=============================================================================
 //                Function
 //=============================================================================
 
-static void sensor_timer_handler(TimerHandle_t timer) {
+static uint32_t sensor_now_ms(void) {
+    return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+static bool sensor_sample(uint8_t idx, int32_t* value) {
     static uint8_t index = 0;
-    index++;
-    if(index > 4) {
-        index = 0;
+
+    if (idx == 0) {
+        index++;
+        if(index > 4) {
+            index = 0;
+        }
+        *value = simulated_measured_value[index];
+    } else {
+        *value = simulated_humidity_value[index];
+    }
+    return true;
+}
+
+static void sensor_write(sensor_report_t* ctx, uint32_t mask) {
+    sensor_report_attr_t* attr;
+    int16_t s16;
+    uint16_t u16;
+
+    ZB_THREAD_SAFE(
+        for (uint8_t i = 0; i < ctx->attr_num; i++) {
+            if (!(mask & (1UL << i))) {
+                continue;
+            }
+            attr = &ctx->attrs[i];
+            log_info("report cluster %04X value %d", attr->cluster, attr->sample);
+            if (attr->zcl_type == ZB_ZCL_ATTR_TYPE_S16) {
+                s16 = (int16_t)attr->sample;
+                zigbee_zcl_set_attrubute(attr->ep, attr->cluster, ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                         attr->attr_id, (uint8_t*)&s16);
+            } else {
+                u16 = (uint16_t)attr->sample;
+                zigbee_zcl_set_attrubute(attr->ep, attr->cluster, ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                         attr->attr_id, (uint8_t*)&u16);
+            }
+        }
+    )
+}
+
+static bool sensor_report_cfg(const sensor_report_attr_t* attr,
+                              sensor_report_cfg_t* cfg) {
+    zb_zcl_reporting_info_t* rep_info;
+    bool found = false;
+
+    ZB_THREAD_SAFE(
+        rep_info = zb_zcl_find_reporting_info(attr->ep, attr->cluster,
+                                              ZB_ZCL_CLUSTER_SERVER_ROLE, attr->attr_id);
+        if (rep_info && ZB_ZCL_GET_REPORTING_FLAG(rep_info, ZB_ZCL_REPORTING_SLOT_BUSY)) {
+            cfg->min_interval_ms = rep_info->u.send_info.min_interval * 1000UL;
+            /* 0xFFFF turns periodic reporting off */
+            cfg->max_interval_ms = (rep_info->u.send_info.max_interval == 0xFFFF)
+                                       ? 0
+                                       : rep_info->u.send_info.max_interval * 1000UL;
+            cfg->delta = (attr->zcl_type == ZB_ZCL_ATTR_TYPE_S16)
+                             ? (uint32_t)rep_info->u.send_info.delta.s16
+                             : rep_info->u.send_info.delta.u16;
+            found = true;
+        }
+    )
+    return found;
+}
+
+static void sensor_timer_handler(TimerHandle_t timer) {
+    uint32_t next_ms = sensor_report_run(&sensor_ctx, sensor_now_ms());
+
+    if (next_ms == 0) {
+        next_ms = portTICK_PERIOD_MS;
     }
-    log_info("new temperature value %d", simulated_measured_value[index]);
-    zigbee_app_set_measured_value(simulated_measured_value[index]);
+    xTimerChangePeriod(sensor_timer, pdMS_TO_TICKS(next_ms), 0);
 }
 
 void start_sensor_timer(void) {
-    sensor_timer = xTimerCreate("tmr_s", pdMS_TO_TICKS(60000), pdTRUE, (void*)0,
+    sensor_report_init(&sensor_ctx, sensor_now_ms());
+    sensor_timer = xTimerCreate("tmr_s", pdMS_TO_TICKS(SENSOR_SAMPLE_PERIOD_MS), pdFALSE, (void*)0,
                                  sensor_timer_handler);
     xTimerStart(sensor_timer, 0);
 }
 
+void zigbee_app_sensor_report_now(void) {
+    if (sensor_timer) {
+        sensor_report_trigger(&sensor_ctx);
+        xTimerChangePeriod(sensor_timer, 1, 0);
+    }
+}
+
 static void zb_app_ota_status_chk(void)
 {
     fota_information_t t_bootloader_ota_info = {0};
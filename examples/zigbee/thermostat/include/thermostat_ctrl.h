@@ -0,0 +1,106 @@
+/**
+ * @file thermostat_ctrl.h
+ * @brief Fixed-point thermostat control loop.
+ *
+ * All temperatures are in 0.01 degC like the ZCL thermostat cluster, the
+ * calibration and dead band attributes are in 0.1 degC and are converted
+ * here. One actuator is driven at a time, heating or cooling, either with
+ * a hysteresis band or with a PI loop whose demand is turned into on/off
+ * time over a fixed cycle. Minimum on and off times are always honoured,
+ * except that SystemMode Off switches the actuator off at once.
+ *
+ * The controller has no stack or RTOS dependency, the caller feeds the
+ * attribute values and the elapsed time from one low-rate timer.
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+
+#ifndef __THERMOSTAT_CTRL_H
+#define __THERMOSTAT_CTRL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define THERMOSTAT_CTRL_DEMAND_MAX 100
+
+typedef enum {
+    THERMOSTAT_CTRL_MODE_HYSTERESIS = 0,
+    THERMOSTAT_CTRL_MODE_PI,
+} thermostat_ctrl_mode_t;
+
+typedef enum {
+    THERMOSTAT_CTRL_ACTION_IDLE = 0,
+    THERMOSTAT_CTRL_ACTION_HEAT,
+    THERMOSTAT_CTRL_ACTION_COOL,
+} thermostat_ctrl_action_t;
+
+typedef struct {
+    thermostat_ctrl_mode_t mode;
+    uint16_t hysteresis; /* full band around the setpoint, 0.01 degC */
+    uint16_t kp;         /* demand % per degC of error */
+    uint16_t ki;         /* demand % per degC of error held for one hour */
+    uint32_t cycle_ms;   /* PI on/off cycle length */
+    uint32_t min_on_ms;
+    uint32_t min_off_ms;
+} thermostat_ctrl_cfg_t;
+
+typedef struct {
+    int16_t local_temperature; /* 0.01 degC */
+    int8_t calibration;        /* LocalTemperatureCalibration, 0.1 degC */
+    bool occupied;
+    uint8_t system_mode;       /* ZCL SystemMode */
+    uint8_t control_seq;       /* ZCL ControlSequenceOfOperation */
+    int16_t occupied_heat;
+    int16_t occupied_cool;
+    int16_t unoccupied_heat;
+    int16_t unoccupied_cool;
+    int16_t min_heat_limit;
+    int16_t max_heat_limit;
+    int16_t min_cool_limit;
+    int16_t max_cool_limit;
+    int8_t min_dead_band;      /* MinSetpointDeadBand, 0.1 degC */
+} thermostat_ctrl_input_t;
+
+typedef struct {
+    uint8_t heating_demand; /* PIHeatingDemand, % */
+    uint8_t cooling_demand; /* PICoolingDemand, % */
+    bool heat_on;
+    bool cool_on;
+    int16_t temperature;    /* calibrated local temperature */
+    int16_t heat_setpoint;  /* effective setpoints after occupancy, limits and dead band */
+    int16_t cool_setpoint;
+} thermostat_ctrl_output_t;
+
+typedef struct {
+    uint32_t run_ms;
+    uint32_t on_ms;
+    uint32_t switches;
+} thermostat_ctrl_stats_t;
+
+typedef struct {
+    thermostat_ctrl_cfg_t cfg;
+    thermostat_ctrl_action_t action;
+    int64_t integral;  /* 0.01 degC * ms */
+    uint8_t demand;
+    bool relay_on;
+    uint32_t relay_ms; /* time in the current relay state */
+    uint32_t cycle_ms; /* position in the PI cycle */
+    thermostat_ctrl_stats_t stats;
+} thermostat_ctrl_t;
+
+/**
+ * @brief Reset the loop, the actuator starts off and may switch on at once
+ */
+void thermostat_ctrl_init(thermostat_ctrl_t* ctx, const thermostat_ctrl_cfg_t* cfg);
+
+/**
+ * @brief Run one control step
+ * @param dt_ms time since the previous step
+ */
+void thermostat_ctrl_step(thermostat_ctrl_t* ctx, const thermostat_ctrl_input_t* in,
+                          uint32_t dt_ms, thermostat_ctrl_output_t* out);
+
+#endif // __THERMOSTAT_CTRL_H
@@ -20,6 +20,8 @@
 #include "queue.h"
 #include "timers.h"
 
+#include "thermostat_ctrl.h"
+
 #define THERMOSTAT_EP 1
 
 #define ZIGBEE_APP_NOTIFY_ISR(ebit)                                            \
@@ -42,6 +44,7 @@ typedef enum {
     ZB_APP_EVENT_NOT_JOINED = 0x00000002,
     ZB_APP_EVENT_JOINED = 0x00000004,
     ZB_APP_EVENT_FACTORY_RESET = 0x00000008,
+    ZB_APP_EVENT_OCCUPANCY = 0x00000010,
 
 
     ZB_APP_EVENT_ALL = 0xffffffff,
@@ -56,10 +59,13 @@ void zigbee_app_nwk_start(uint32_t channel_mask, uint32_t max_child, uint32_t re
 void zigbee_start_identify(void);
 void zigbee_app_thermostat_cb(uint8_t param);
 void zigbee_zcl_set_attrubute(uint8_t ep, uint16_t cluster, uint8_t role, uint16_t attr_id, uint8_t* val);
+void start_thermostat_timer(void);
+void zigbee_app_toggle_occupancy(void);
 
 void reset_attr(void);
 uint32_t get_identify_time(void);
 uint8_t get_system_mode(void);
+void get_thermostat_ctrl_input(thermostat_ctrl_input_t* in);
 int16_t get_cooling_setpoint(void);
 int16_t get_heating_setpoint(void);
 void set_system_mode(uint8_t mode);
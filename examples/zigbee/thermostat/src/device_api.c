@@ -33,6 +33,8 @@ static void button_cb(uint32_t pin, void* isr_param)
     switch (pin)
     {
     case 0:
+        ZIGBEE_APP_NOTIFY_ISR(ZB_APP_EVENT_OCCUPANCY);
+        break;
     case 1:
     case 2:
     case 3:
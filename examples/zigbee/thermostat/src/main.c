@@ -70,6 +70,7 @@ void app_main_loop(void* parameters_ptr) {
                 case ZB_APP_EVENT_INIT: {
                     zigbee_app_nwk_start(ZIGBEE_CHANNEL_ALL_MASK(), 32, 0);
                     log_info("ZigBee APP init");
+                    start_thermostat_timer();
                     set_led_onoff(LED_BLUE,1);
                 } break;
 
@@ -94,6 +95,10 @@ void app_main_loop(void* parameters_ptr) {
 
                 } break;
 
+                case ZB_APP_EVENT_OCCUPANCY: {
+                    zigbee_app_toggle_occupancy();
+                } break;
+
                 case ZB_APP_EVENT_FACTORY_RESET: {
                     zigbee_do_factory_reset();
                 } break;
@@ -0,0 +1,267 @@
+/**
+ * @file thermostat_ctrl.c
+ * @brief Fixed-point thermostat control loop, see thermostat_ctrl.h
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+//=============================================================================
+//                Include
+//=============================================================================
+#include <stddef.h>
+
+#include "thermostat_ctrl.h"
+
+//=============================================================================
+//                Private Definitions
+//=============================================================================
+/* ZCL SystemMode values */
+#define SYSTEM_MODE_OFF         0x00
+#define SYSTEM_MODE_AUTO        0x01
+#define SYSTEM_MODE_COOL        0x03
+#define SYSTEM_MODE_HEAT        0x04
+#define SYSTEM_MODE_EMERGENCY   0x05
+#define SYSTEM_MODE_PRECOOLING  0x06
+
+/* ZCL ControlSequenceOfOperation values */
+#define CONTROL_SEQ_COOLING_ONLY        0x00
+#define CONTROL_SEQ_COOLING_REHEAT      0x01
+#define CONTROL_SEQ_HEATING_ONLY        0x02
+#define CONTROL_SEQ_HEATING_REHEAT      0x03
+#define CONTROL_SEQ_COOLING_HEATING     0x04
+#define CONTROL_SEQ_COOLING_HEATING_RH  0x05
+
+/* Integrated error (0.01 degC * ms) that equals one degC held for one hour */
+#define DEGC_HOUR (100LL * 3600000LL)
+
+//=============================================================================
+//                Private Function
+//=============================================================================
+static int16_t clamp16(int32_t v, int16_t lo, int16_t hi) {
+    if (v < lo) {
+        return lo;
+    }
+    if (v > hi) {
+        return hi;
+    }
+    return (int16_t)v;
+}
+
+static bool heat_allowed(uint8_t seq) {
+    return seq >= CONTROL_SEQ_HEATING_ONLY && seq <= CONTROL_SEQ_COOLING_HEATING_RH;
+}
+
+static bool cool_allowed(uint8_t seq) {
+    return seq == CONTROL_SEQ_COOLING_ONLY || seq == CONTROL_SEQ_COOLING_REHEAT
+           || seq == CONTROL_SEQ_COOLING_HEATING
+           || seq == CONTROL_SEQ_COOLING_HEATING_RH;
+}
+
+static void effective_setpoints(const thermostat_ctrl_input_t* in,
+                                thermostat_ctrl_output_t* out) {
+    int32_t heat, cool;
+
+    heat = in->occupied ? in->occupied_heat : in->unoccupied_heat;
+    cool = in->occupied ? in->occupied_cool : in->unoccupied_cool;
+    heat = clamp16(heat, in->min_heat_limit, in->max_heat_limit);
+    cool = clamp16(cool, in->min_cool_limit, in->max_cool_limit);
+
+    /* Keep the dead band between the loops, move cooling away from heating */
+    if (heat_allowed(in->control_seq) && cool_allowed(in->control_seq)
+        && cool < heat + in->min_dead_band * 10) {
+        cool = heat + in->min_dead_band * 10;
+    }
+    out->heat_setpoint = (int16_t)heat;
+    out->cool_setpoint = clamp16(cool, INT16_MIN, INT16_MAX);
+}
+
+static thermostat_ctrl_action_t select_action(const thermostat_ctrl_t* ctx,
+                                              const thermostat_ctrl_input_t* in,
+                                              const thermostat_ctrl_output_t* out) {
+    bool heat = heat_allowed(in->control_seq);
+    bool cool = cool_allowed(in->control_seq);
+
+    switch (in->system_mode) {
+        case SYSTEM_MODE_HEAT:
+        case SYSTEM_MODE_EMERGENCY:
+            return heat ? THERMOSTAT_CTRL_ACTION_HEAT : THERMOSTAT_CTRL_ACTION_IDLE;
+        case SYSTEM_MODE_COOL:
+        case SYSTEM_MODE_PRECOOLING:
+            return cool ? THERMOSTAT_CTRL_ACTION_COOL : THERMOSTAT_CTRL_ACTION_IDLE;
+        case SYSTEM_MODE_AUTO:
+            if (heat && !cool) {
+                return THERMOSTAT_CTRL_ACTION_HEAT;
+            }
+            if (cool && !heat) {
+                return THERMOSTAT_CTRL_ACTION_COOL;
+            }
+            /* Change over only once a setpoint is crossed, the dead band holds */
+            if (out->temperature < out->heat_setpoint) {
+                return THERMOSTAT_CTRL_ACTION_HEAT;
+            }
+            if (out->temperature > out->cool_setpoint) {
+                return THERMOSTAT_CTRL_ACTION_COOL;
+            }
+            if (ctx->action != THERMOSTAT_CTRL_ACTION_IDLE) {
+                return ctx->action;
+            }
+            return (out->temperature - out->heat_setpoint
+                    < out->cool_setpoint - out->temperature)
+                       ? THERMOSTAT_CTRL_ACTION_HEAT
+                       : THERMOSTAT_CTRL_ACTION_COOL;
+        case SYSTEM_MODE_OFF:
+        default: return THERMOSTAT_CTRL_ACTION_IDLE;
+    }
+}
+
+static uint8_t hysteresis_demand(const thermostat_ctrl_t* ctx, int32_t error) {
+    int32_t half = ctx->cfg.hysteresis / 2;
+
+    if (ctx->relay_on) {
+        return (error >= -half) ? THERMOSTAT_CTRL_DEMAND_MAX : 0;
+    }
+    return (error > half) ? THERMOSTAT_CTRL_DEMAND_MAX : 0;
+}
+
+static uint8_t pi_demand(thermostat_ctrl_t* ctx, int32_t error, uint32_t dt_ms) {
+    int64_t p, i, integral, limit;
+    int64_t u;
+
+    if (ctx->cfg.ki == 0) {
+        ctx->integral = 0;
+    }
+
+    p = (int64_t)ctx->cfg.kp * error / 100;
+    integral = ctx->integral + (int64_t)error * dt_ms;
+    i = (int64_t)ctx->cfg.ki * integral / DEGC_HOUR;
+    u = p + i;
+
+    /* Anti-windup: stop integrating while the output is saturated the same way */
+    if (!((u > THERMOSTAT_CTRL_DEMAND_MAX && error > 0) || (u < 0 && error < 0))) {
+        ctx->integral = integral;
+    }
+    if (ctx->cfg.ki != 0) {
+        limit = THERMOSTAT_CTRL_DEMAND_MAX * DEGC_HOUR / ctx->cfg.ki;
+        if (ctx->integral > limit) {
+            ctx->integral = limit;
+        } else if (ctx->integral < 0) {
+            ctx->integral = 0;
+        }
+    }
+
+    u = p + (int64_t)ctx->cfg.ki * ctx->integral / DEGC_HOUR;
+    if (u < 0) {
+        return 0;
+    }
+    if (u > THERMOSTAT_CTRL_DEMAND_MAX) {
+        return THERMOSTAT_CTRL_DEMAND_MAX;
+    }
+    return (uint8_t)u;
+}
+
+static bool pi_relay(thermostat_ctrl_t* ctx, uint32_t dt_ms) {
+    uint32_t on_ms;
+
+    if (ctx->cfg.cycle_ms == 0) {
+        return ctx->demand != 0;
+    }
+    ctx->cycle_ms += dt_ms;
+    if (ctx->cycle_ms >= ctx->cfg.cycle_ms) {
+        ctx->cycle_ms %= ctx->cfg.cycle_ms;
+    }
+
+    /* Pulses shorter than the minimum on or off time are dropped, the
+     * integrator makes up for them over the next cycles */
+    on_ms = (uint32_t)((uint64_t)ctx->cfg.cycle_ms * ctx->demand
+                       / THERMOSTAT_CTRL_DEMAND_MAX);
+    if (on_ms < ctx->cfg.min_on_ms) {
+        on_ms = 0;
+    }
+    if (ctx->cfg.cycle_ms - on_ms < ctx->cfg.min_off_ms) {
+        on_ms = ctx->cfg.cycle_ms;
+    }
+    return ctx->cycle_ms < on_ms;
+}
+
+static void relay_reset(thermostat_ctrl_t* ctx) {
+    ctx->integral = 0;
+    ctx->demand = 0;
+    ctx->cycle_ms = 0;
+}
+
+//=============================================================================
+//                Public Function
+//=============================================================================
+void thermostat_ctrl_init(thermostat_ctrl_t* ctx, const thermostat_ctrl_cfg_t* cfg) {
+    ctx->cfg = *cfg;
+    ctx->action = THERMOSTAT_CTRL_ACTION_IDLE;
+    ctx->relay_on = false;
+    ctx->relay_ms = cfg->min_off_ms;
+    ctx->stats = (thermostat_ctrl_stats_t){0};
+    relay_reset(ctx);
+}
+
+void thermostat_ctrl_step(thermostat_ctrl_t* ctx, const thermostat_ctrl_input_t* in,
+                          uint32_t dt_ms, thermostat_ctrl_output_t* out) {
+    thermostat_ctrl_action_t action;
+    int32_t error = 0;
+    bool want = false;
+
+    ctx->stats.run_ms += dt_ms;
+    if (ctx->relay_on) {
+        ctx->stats.on_ms += dt_ms;
+    }
+    ctx->relay_ms = (UINT32_MAX - ctx->relay_ms > dt_ms) ? ctx->relay_ms + dt_ms
+                                                         : UINT32_MAX;
+
+    out->temperature = clamp16((int32_t)in->local_temperature + in->calibration * 10,
+                               INT16_MIN, INT16_MAX);
+    effective_setpoints(in, out);
+
+    action = select_action(ctx, in, out);
+    if (action != ctx->action) {
+        /* Changing over needs the running actuator to finish its min on time */
+        if (ctx->relay_on && in->system_mode != SYSTEM_MODE_OFF
+            && ctx->relay_ms < ctx->cfg.min_on_ms) {
+            action = ctx->action;
+        } else {
+            ctx->action = action;
+            relay_reset(ctx);
+            if (ctx->relay_on) {
+                ctx->relay_on = false;
+                ctx->relay_ms = 0;
+                ctx->stats.switches++;
+            }
+        }
+    }
+
+    if (action == THERMOSTAT_CTRL_ACTION_HEAT) {
+        error = (int32_t)out->heat_setpoint - out->temperature;
+    } else if (action == THERMOSTAT_CTRL_ACTION_COOL) {
+        error = (int32_t)out->temperature - out->cool_setpoint;
+    }
+
+    if (action == THERMOSTAT_CTRL_ACTION_IDLE) {
+        relay_reset(ctx);
+    } else if (ctx->cfg.mode == THERMOSTAT_CTRL_MODE_PI) {
+        ctx->demand = pi_demand(ctx, error, dt_ms);
+        want = pi_relay(ctx, dt_ms);
+    } else {
+        ctx->demand = hysteresis_demand(ctx, error);
+        want = ctx->demand != 0;
+    }
+
+    if (want != ctx->relay_on
+        && ctx->relay_ms >= (ctx->relay_on ? ctx->cfg.min_on_ms : ctx->cfg.min_off_ms)) {
+        ctx->relay_on = want;
+        ctx->relay_ms = 0;
+        ctx->stats.switches++;
+    }
+
+    out->heating_demand = (action == THERMOSTAT_CTRL_ACTION_HEAT) ? ctx->demand : 0;
+    out->cooling_demand = (action == THERMOSTAT_CTRL_ACTION_COOL) ? ctx->demand : 0;
+    out->heat_on = ctx->relay_on && action == THERMOSTAT_CTRL_ACTION_HEAT;
+    out->cool_on = ctx->relay_on && action == THERMOSTAT_CTRL_ACTION_COOL;
+}
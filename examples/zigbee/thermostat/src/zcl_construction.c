@@ -270,6 +270,21 @@ int16_t get_heating_setpoint (void)
 {
     return g_attr_occupied_heating_setpoint;
 }
+void get_thermostat_ctrl_input(thermostat_ctrl_input_t* in)
+{
+    in->calibration = g_attr_local_temperature_calibration;
+    in->system_mode = g_attr_system_mode;
+    in->control_seq = g_attr_control_seq_of_operation;
+    in->occupied_heat = g_attr_occupied_heating_setpoint;
+    in->occupied_cool = g_attr_occupied_cooling_setpoint;
+    in->unoccupied_heat = g_attr_unoccupied_heating_setpoint;
+    in->unoccupied_cool = g_attr_unoccupied_cooling_setpoint;
+    in->min_heat_limit = g_attr_min_heat_setpoint_limit;
+    in->max_heat_limit = g_attr_max_heat_setpoint_limit;
+    in->min_cool_limit = g_attr_min_cool_setpoint_limit;
+    in->max_cool_limit = g_attr_max_cool_setpoint_limit;
+    in->min_dead_band = g_attr_min_setpoint_dead_band;
+}
 void set_system_mode(uint8_t mode)
 {
     g_attr_system_mode = mode;
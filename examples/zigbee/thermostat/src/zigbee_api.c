@@ -41,6 +41,29 @@ uint8_t ZB_RAF_SCAN_DURATION = 3;
 static TimerHandle_t tmr_identify;
 
 static TaskHandle_t zb_app_taskHandle;
+static TimerHandle_t thermostat_timer;
+
+#define THERMOSTAT_CTRL_PERIOD_MS 10000
+
+static const thermostat_ctrl_cfg_t thermostat_cfg = {
+    .mode = THERMOSTAT_CTRL_MODE_PI,
+    .hysteresis = 50,
+    .kp = 40,
+    .ki = 20,
+    .cycle_ms = 600000,
+    .min_on_ms = 120000,
+    .min_off_ms = 120000,
+};
+static thermostat_ctrl_t thermostat_ctx;
+static bool thermostat_occupied = true;
+
+/* The board has no temperature sensor, a first order room model (0.0001 degC)
+ * driven by the actuator stands in for it */
+static int32_t simulated_room_temp = 180000;
+#define SIMULATED_OUTDOOR_TEMP   50000
+#define SIMULATED_ROOM_TAU_S     7200
+#define SIMULATED_HEAT_RATE      45 /* 0.0001 degC/s with the heater on */
+#define SIMULATED_COOL_RATE      45
 
 //=============================================================================
 //                Function
@@ -153,6 +176,62 @@ void zigbee_zcl_set_attrubute(uint8_t ep, uint16_t cluster, uint8_t role, uint16
     ZB_ZCL_SET_ATTRIBUTE(ep, cluster, role, attr_id, val, ZB_FALSE);
 }
 
+static void thermostat_simulated_room(const thermostat_ctrl_output_t* out, uint32_t dt_s) {
+    int32_t rate = (SIMULATED_OUTDOOR_TEMP - simulated_room_temp) / SIMULATED_ROOM_TAU_S;
+
+    if (out->heat_on) {
+        rate += SIMULATED_HEAT_RATE;
+    }
+    if (out->cool_on) {
+        rate -= SIMULATED_COOL_RATE;
+    }
+    simulated_room_temp += rate * (int32_t)dt_s;
+}
+
+static void thermostat_timer_handler(TimerHandle_t timer) {
+    static bool heat_on = false, cool_on = false;
+    thermostat_ctrl_input_t in;
+    thermostat_ctrl_output_t out;
+    int16_t local_temperature = (int16_t)(simulated_room_temp / 100);
+
+    /* the attributes are written by the stack task, read them under its lock */
+    ZB_THREAD_SAFE(get_thermostat_ctrl_input(&in);)
+    in.local_temperature = local_temperature;
+    in.occupied = thermostat_occupied;
+    thermostat_ctrl_step(&thermostat_ctx, &in, THERMOSTAT_CTRL_PERIOD_MS, &out);
+    thermostat_simulated_room(&out, THERMOSTAT_CTRL_PERIOD_MS / 1000);
+
+    /* publish the calibrated temperature the loop controlled on */
+    ZB_THREAD_SAFE(
+        zigbee_zcl_set_attrubute(THERMOSTAT_EP, ZB_ZCL_CLUSTER_ID_THERMOSTAT, ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID, (uint8_t*)&out.temperature);
+        zigbee_zcl_set_attrubute(THERMOSTAT_EP, ZB_ZCL_CLUSTER_ID_THERMOSTAT, ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ZB_ZCL_ATTR_THERMOSTAT_PI_HEATING_DEMAND_ID, &out.heating_demand);
+        zigbee_zcl_set_attrubute(THERMOSTAT_EP, ZB_ZCL_CLUSTER_ID_THERMOSTAT, ZB_ZCL_CLUSTER_SERVER_ROLE,
+                                 ZB_ZCL_ATTR_THERMOSTAT_PI_COOLING_DEMAND_ID, &out.cooling_demand);
+    )
+
+    if (out.heat_on != heat_on || out.cool_on != cool_on) {
+        heat_on = out.heat_on;
+        cool_on = out.cool_on;
+        log_info("temp %d heat %d (%d%%) cool %d (%d%%) sp %d/%d", out.temperature,
+                 heat_on, out.heating_demand, cool_on, out.cooling_demand,
+                 out.heat_setpoint, out.cool_setpoint);
+    }
+}
+
+void start_thermostat_timer(void) {
+    thermostat_ctrl_init(&thermostat_ctx, &thermostat_cfg);
+    thermostat_timer = xTimerCreate("tmr_c", pdMS_TO_TICKS(THERMOSTAT_CTRL_PERIOD_MS), pdTRUE, (void*)0,
+                                    thermostat_timer_handler);
+    xTimerStart(thermostat_timer, 0);
+}
+
+void zigbee_app_toggle_occupancy(void) {
+    thermostat_occupied = !thermostat_occupied;
+    log_info("occupancy %s", thermostat_occupied ? "occupied" : "unoccupied");
+}
+
 void zboss_signal_handler(zb_uint8_t param) {
     zb_zdo_app_signal_hdr_t* sg_p = NULL;
     zb_zdo_app_signal_t sig = zb_get_app_signal(param, &sg_p);
@@ -0,0 +1,17 @@
+/**
+ * @file hosal_crypto_sha256.h
+ * @brief Host stand-in for the HMAC-SHA256 call of the crypto HOSAL, a
+ *        plain software SHA-256 in sha256_mock.c
+ */
+
+#ifndef __RMT_MOCK_HOSAL_CRYPTO_SHA256_H
+#define __RMT_MOCK_HOSAL_CRYPTO_SHA256_H
+
+#include <stdint.h>
+
+#define SHA256_DIGEST_SIZE 32
+
+void hmac_sha256(const uint8_t* key, uint32_t key_len, const uint8_t* msg,
+                 uint32_t msg_len, uint8_t* digest);
+
+#endif // __RMT_MOCK_HOSAL_CRYPTO_SHA256_H
@@ -0,0 +1,17 @@
+/**
+ * @file main.h
+ * @brief Host stand-in for the mesh-it-up main.h, the stack calls come from
+ *        the OpenThread stand-in of ot/
+ */
+
+#ifndef __RMT_MOCK_MAIN_H
+#define __RMT_MOCK_MAIN_H
+
+#include <miu_port.h>
+#include <openthread/ip6.h>
+#include <openthread/thread.h>
+
+#include "app_rmt.h"
+#include "app_udp.h"
+
+#endif // __RMT_MOCK_MAIN_H
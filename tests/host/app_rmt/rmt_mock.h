@@ -0,0 +1,20 @@
+/**
+ * @file rmt_mock.h
+ * @brief Task calls of the remote command worker, forced into app_rmt.c.
+ *        The test drains the queue itself instead of running the worker.
+ */
+
+#ifndef __RMT_MOCK_H
+#define __RMT_MOCK_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define E_TASK_PRIORITY_APP 1
+
+typedef void (*TaskFunction_t)(void* arg);
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char* name, uint32_t depth,
+                       void* arg, UBaseType_t prio, TaskHandle_t* handle);
+
+#endif // __RMT_MOCK_H
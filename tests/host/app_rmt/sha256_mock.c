@@ -0,0 +1,135 @@
+/**
+ * @file sha256_mock.c
+ * @brief Software SHA-256 and HMAC-SHA256 (FIPS 180-4, RFC 2104) for the
+ *        remote command tests
+ */
+
+#include <string.h>
+#include "hosal_crypto_sha256.h"
+
+#define SHA256_BLOCK_SIZE 64
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t len;
+    uint8_t block[SHA256_BLOCK_SIZE];
+    uint32_t used;
+} sha256_t;
+
+static const uint32_t k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_block(sha256_t* ctx, const uint8_t* p) {
+    uint32_t w[64], s[8], t1, t2;
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16
+               | (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+    }
+    for (; i < 64; i++) {
+        w[i] = w[i - 16] + w[i - 7]
+               + (ROR(w[i - 15], 7) ^ ROR(w[i - 15], 18) ^ (w[i - 15] >> 3))
+               + (ROR(w[i - 2], 17) ^ ROR(w[i - 2], 19) ^ (w[i - 2] >> 10));
+    }
+
+    memcpy(s, ctx->state, sizeof(s));
+    for (i = 0; i < 64; i++) {
+        t1 = s[7] + (ROR(s[4], 6) ^ ROR(s[4], 11) ^ ROR(s[4], 25))
+             + ((s[4] & s[5]) ^ (~s[4] & s[6])) + k[i] + w[i];
+        t2 = (ROR(s[0], 2) ^ ROR(s[0], 13) ^ ROR(s[0], 22))
+             + ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+        memmove(&s[1], &s[0], 7 * sizeof(s[0]));
+        s[4] += t1;
+        s[0] = t1 + t2;
+    }
+    for (i = 0; i < 8; i++) {
+        ctx->state[i] += s[i];
+    }
+}
+
+static void sha256_init(sha256_t* ctx) {
+    static const uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372,
+                                  0xa54ff53a, 0x510e527f, 0x9b05688c,
+                                  0x1f83d9ab, 0x5be0cd19};
+
+    memcpy(ctx->state, h, sizeof(h));
+    ctx->len = 0;
+    ctx->used = 0;
+}
+
+static void sha256_update(sha256_t* ctx, const uint8_t* p, uint32_t len) {
+    ctx->len += len;
+    while (len--) {
+        ctx->block[ctx->used++] = *p++;
+        if (ctx->used == SHA256_BLOCK_SIZE) {
+            sha256_block(ctx, ctx->block);
+            ctx->used = 0;
+        }
+    }
+}
+
+static void sha256_final(sha256_t* ctx, uint8_t* digest) {
+    uint64_t bits = ctx->len * 8;
+    uint8_t pad = 0x80;
+    int i;
+
+    sha256_update(ctx, &pad, 1);
+    pad = 0;
+    while (ctx->used != SHA256_BLOCK_SIZE - 8) {
+        sha256_update(ctx, &pad, 1);
+    }
+    for (i = 0; i < 8; i++) {
+        ctx->block[SHA256_BLOCK_SIZE - 8 + i] = bits >> (56 - 8 * i);
+    }
+    sha256_block(ctx, ctx->block);
+    for (i = 0; i < 32; i++) {
+        digest[i] = ctx->state[i / 4] >> (24 - 8 * (i % 4));
+    }
+}
+
+void hmac_sha256(const uint8_t* key, uint32_t key_len, const uint8_t* msg,
+                 uint32_t msg_len, uint8_t* digest) {
+    uint8_t pad[SHA256_BLOCK_SIZE];
+    uint8_t inner[SHA256_DIGEST_SIZE];
+    sha256_t ctx;
+    int i;
+
+    memset(pad, 0, sizeof(pad));
+    if (key_len > SHA256_BLOCK_SIZE) {
+        sha256_init(&ctx);
+        sha256_update(&ctx, key, key_len);
+        sha256_final(&ctx, pad);
+    } else {
+        memcpy(pad, key, key_len);
+    }
+
+    for (i = 0; i < SHA256_BLOCK_SIZE; i++) {
+        pad[i] ^= 0x36;
+    }
+    sha256_init(&ctx);
+    sha256_update(&ctx, pad, SHA256_BLOCK_SIZE);
+    sha256_update(&ctx, msg, msg_len);
+    sha256_final(&ctx, inner);
+
+    for (i = 0; i < SHA256_BLOCK_SIZE; i++) {
+        pad[i] ^= 0x36 ^ 0x5c;
+    }
+    sha256_init(&ctx);
+    sha256_update(&ctx, pad, SHA256_BLOCK_SIZE);
+    sha256_update(&ctx, inner, SHA256_DIGEST_SIZE);
+    sha256_final(&ctx, digest);
+}
@@ -0,0 +1,438 @@
+/**
+ * @file test_app_rmt.c
+ * @brief Remote commands of the mesh-it-up apps against the OpenThread
+ *        stand-in of ot/: no service without a key, the rate limit, replay
+ *        windows keyed on the sender id, kept across a reboot and never
+ *        handed to another sender.
+ *
+ * Requests are delivered to the bound socket as the stack would, the test
+ * then drains the worker queue itself. The source is included so a reboot
+ * can clear the RAM state while the flash stand-in keeps its records.
+ */
+
+#include "app_rmt.c"
+#include "EnhancedFlashDataset.h"
+#include "app_ot_job.h"
+#include "host_test.h"
+#include "ot_mock.h"
+
+#define PORT 5678
+
+static const uint8_t s_peer_key[] = "mesh-test-key";
+static const uint8_t s_peer_a[RMT_SENDER_LEN] = {0xa, 0, 0, 0, 0, 0, 0, 1};
+static const uint8_t s_peer_b[RMT_SENDER_LEN] = {0xb, 0, 0, 0, 0, 0, 0, 2};
+static otIp6Address s_addr_a;
+static otIp6Address s_addr_b;
+
+static uint32_t s_tasks;
+static uint32_t s_runs;
+static uint32_t s_plain;
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char* name, uint32_t depth,
+                       void* arg, UBaseType_t prio, TaskHandle_t* handle) {
+    s_tasks++;
+    return pdPASS;
+}
+
+static int quiet(const char* fmt, ...) {
+    (void)fmt;
+    return 0;
+}
+
+static int _cli_cmd_miu(int argc, char** argv, cb_shell_out_t log_out,
+                        void* pExtra) {
+    s_runs++;
+    log_out("ran %s", argc > 1 ? argv[1] : "-");
+    return 0;
+}
+
+const sh_cmd_t g_cli_cmd_miu_app = {.pCmd_name = "miu",
+                                    .cmd_exec = _cli_cmd_miu};
+const sh_cmd_t g_cli_cmd_phy = {.pCmd_name = "phy", .cmd_exec = _cli_cmd_miu};
+
+/* the socket handler of app_task.c */
+static void udp_rx(uint8_t* p, uint16_t len, const otMessageInfo* info) {
+    if (!app_rmt_receive(p, len, info)) {
+        s_plain++;
+    }
+}
+
+static int rmt_cli(const char* line) {
+    char buf[128];
+    char* argv[APP_RMT_ARGC_MAX];
+    char* save;
+    int argc = 0;
+
+    snprintf(buf, sizeof(buf), "%s", line);
+    argv[0] = strtok_r(buf, " ", &save);
+    while (argv[argc] && argc < APP_RMT_ARGC_MAX - 1) {
+        argv[++argc] = strtok_r(NULL, " ", &save);
+    }
+    return _cli_cmd_rmt(argc, argv, quiet, NULL);
+}
+
+/* power cycle: RAM state gone, the flash records kept */
+static void reboot(void) {
+    static int opened;
+
+    if (!opened) {
+        otIp6AddressFromString("fd00::a", &s_addr_a);
+        otIp6AddressFromString("fd00::b", &s_addr_b);
+        app_ot_job_init(otrGetInstance());
+        otrLock();
+        app_sockInit(otrGetInstance(), udp_rx, PORT);
+        otrUnlock();
+        opened = 1;
+    }
+    ot_mock_reset();
+    g_ot_mock.eui64.m8[0] = 0xee;
+    g_ot_mock.eui64.m8[7] = 0x01;
+
+    s_queue = NULL;
+    s_lock = NULL;
+    memset(s_key, 0, sizeof(s_key));
+    s_key_len = 0;
+    s_tx_id = 0;
+    s_tx_counter = 0;
+    s_tx_saved = 0;
+    memset(&s_stats, 0, sizeof(s_stats));
+    memset(s_sender, 0, sizeof(s_sender));
+    s_tokens = APP_RMT_BURST;
+    s_peers_clear = false;
+    memset(s_peers, 0, sizeof(s_peers));
+    s_tasks = 0;
+    s_runs = 0;
+    s_plain = 0;
+
+    otrLock();
+    app_rmt_init(otrGetInstance());
+    otrUnlock();
+    CHECK_EQ(g_ot_mock.unlocked_calls, 0);
+}
+
+/* factory reset, then provisioned with the peer key */
+static void setup(void) {
+    efd_stub_reset();
+    reboot();
+    CHECK_EQ(rmt_cli("rmt key mesh-test-key"), 0);
+}
+
+static uint32_t drain(void) {
+    uint32_t n = 0;
+
+    while (xQueueReceive(s_queue, &s_msg, 0) == pdTRUE) {
+        rmt_process(&s_msg);
+        n++;
+    }
+    return n;
+}
+
+static void request(const uint8_t* sender, uint32_t counter,
+                    const otIp6Address* src, const char* cmd) {
+    uint8_t buf[RMT_FRAME_MAX];
+    rmt_frame_t frame = {
+        .type = RMT_TYPE_REQUEST,
+        .id = (uint16_t)counter,
+        .counter = counter,
+        .len = strlen(cmd),
+        .payload = (const uint8_t*)cmd,
+    };
+    uint16_t len;
+
+    memcpy(frame.sender, sender, RMT_SENDER_LEN);
+    len = rmt_encode(buf, &frame, s_peer_key, sizeof(s_peer_key) - 1);
+    ot_mock_udp_deliver(buf, len, src, 49152);
+}
+
+/* the last datagram sent, as a decoded response */
+static int last_response(rmt_frame_t* rsp) {
+    ot_mock_sent_t* sent;
+
+    if (g_ot_mock_sent_num == 0) {
+        return -1;
+    }
+    sent = &g_ot_mock_sent[g_ot_mock_sent_num - 1];
+    if (rmt_decode(sent->data, sent->len, s_peer_key,
+                   sizeof(s_peer_key) - 1, rsp)
+            != 0
+        || rsp->type != RMT_TYPE_RESPONSE) {
+        return -1;
+    }
+    return 0;
+}
+
+static uint32_t next_counter(const rmt_frame_t* rsp) {
+    uint32_t next = 0;
+
+    if (rsp->len == sizeof(next)) {
+        memcpy(&next, rsp->payload, sizeof(next));
+    }
+    return next;
+}
+
+/* the first request of a sender is answered with a floor to exceed */
+static void meet(const uint8_t* sender, const otIp6Address* src) {
+    uint32_t challenged = s_stats.challenged;
+    uint32_t runs = s_runs;
+    rmt_frame_t rsp;
+
+    request(sender, 1, src, "miu x");
+    drain();
+    CHECK_EQ(s_runs, runs);
+    CHECK_EQ(s_stats.challenged, challenged + 1);
+    CHECK_EQ(last_response(&rsp), 0);
+    CHECK_EQ(rsp.status, RMT_STATUS_STALE);
+    CHECK_EQ(next_counter(&rsp), 2);
+}
+
+static void test_no_key_no_service(void) {
+    efd_stub_reset();
+    reboot();
+    CHECK(s_queue == NULL);
+    CHECK_EQ(s_tasks, 0);
+
+    /* a frame is not taken, nothing answers it */
+    request(s_peer_a, 1, &s_addr_a, "miu x");
+    CHECK_EQ(s_plain, 1);
+    CHECK_EQ(g_ot_mock_sent_num, 0);
+    CHECK(rmt_cli("rmt show") != 0);
+    CHECK(rmt_cli("rmt send fd00::b miu") != 0);
+
+    /* provisioned: running, and still after a reboot */
+    CHECK_EQ(rmt_cli("rmt key mesh-test-key"), 0);
+    CHECK(s_queue != NULL);
+    CHECK_EQ(s_tasks, 1);
+    CHECK_EQ(rmt_cli("rmt key mesh-test-key"), 0);
+    CHECK_EQ(s_tasks, 1);
+    reboot();
+    CHECK(s_queue != NULL);
+    CHECK_EQ(s_key_len, sizeof(s_peer_key) - 1);
+    CHECK(memcmp(s_key, s_peer_key, s_key_len) == 0);
+}
+
+static void test_request_answered(void) {
+    rmt_frame_t rsp;
+
+    setup();
+    meet(s_peer_a, &s_addr_a);
+    g_ot_mock_sent_num = 0;
+    request(s_peer_a, 2, &s_addr_a, "miu x");
+    CHECK_EQ(drain(), 1);
+    CHECK_EQ(s_runs, 1);
+    CHECK_EQ(last_response(&rsp), 0);
+    CHECK_EQ(rsp.status, RMT_STATUS_OK);
+    CHECK_EQ(rsp.counter, 2);
+    CHECK(rsp.len == 5 && memcmp(rsp.payload, "ran x", 5) == 0);
+    /* signed as this node, back to where the request came from */
+    CHECK_EQ(rsp.sender[0], 0xee);
+    CHECK_EQ(rsp.sender[7], 0x01);
+    CHECK(!memcmp(&g_ot_mock_sent[0].dst, &s_addr_a, sizeof(s_addr_a)));
+    CHECK_EQ(g_ot_mock_sent[0].port, 49152);
+
+    /* rmt is never run remotely */
+    request(s_peer_a, 3, &s_addr_a, "rmt key x");
+    drain();
+    CHECK_EQ(last_response(&rsp), 0);
+    CHECK_EQ(rsp.status, RMT_STATUS_UNKNOWN);
+}
+
+static void test_replay_keyed_on_sender(void) {
+    uint8_t buf[RMT_FRAME_MAX];
+    rmt_frame_t rsp;
+    rmt_frame_t frame = {.type = RMT_TYPE_REQUEST, .id = 1, .counter = 7};
+    uint16_t len;
+
+    setup();
+    meet(s_peer_a, &s_addr_a);
+    meet(s_peer_b, &s_addr_b);
+    request(s_peer_a, 7, &s_addr_a, "miu x");
+    drain();
+    CHECK_EQ(s_runs, 1);
+
+    /* the same request from another address is still a replay */
+    request(s_peer_a, 7, &s_addr_b, "miu x");
+    drain();
+    CHECK_EQ(s_runs, 1);
+    CHECK_EQ(s_stats.replayed, 1);
+    CHECK_EQ(last_response(&rsp), 0);
+    CHECK_EQ(rsp.status, RMT_STATUS_STALE);
+
+    /* another sender has its own window, whatever its address */
+    request(s_peer_b, 7, &s_addr_a, "miu x");
+    drain();
+    CHECK_EQ(s_runs, 2);
+
+    /* a sender id rewritten without the key fails the tag */
+    memcpy(frame.sender, s_peer_a, RMT_SENDER_LEN);
+    len = rmt_encode(buf, &frame, s_peer_key, sizeof(s_peer_key) - 1);
+    buf[11] ^= 0x40;
+    g_ot_mock_sent_num = 0;
+    ot_mock_udp_deliver(buf, len, &s_addr_b, 49152);
+    drain();
+    CHECK_EQ(s_stats.auth_failed, 1);
+    CHECK_EQ(g_ot_mock_sent_num, 0);
+    CHECK_EQ(s_runs, 2);
+}
+
+static void test_rate_limited(void) {
+    uint32_t c = 2, i;
+
+    setup();
+    meet(s_peer_a, &s_addr_a);
+    g_stub_tick += configTICK_RATE_HZ * 10;
+    for (i = 0; i < APP_RMT_BURST + 4; i++) {
+        request(s_peer_a, c++, &s_addr_a, "miu x");
+        drain();
+    }
+    CHECK_EQ(s_runs, APP_RMT_BURST);
+    CHECK_EQ(s_stats.rate_limited, 4);
+
+    /* one more token every 1 / APP_RMT_RATE seconds */
+    g_stub_tick += configTICK_RATE_HZ / APP_RMT_RATE;
+    request(s_peer_a, c++, &s_addr_a, "miu x");
+    request(s_peer_a, c++, &s_addr_a, "miu x");
+    drain();
+    CHECK_EQ(s_runs, APP_RMT_BURST + 1);
+    CHECK_EQ(s_stats.rate_limited, 5);
+
+    /* a full bucket after a quiet spell, the queue bounds the burst */
+    g_stub_tick += configTICK_RATE_HZ * 10;
+    for (i = 0; i < APP_RMT_QUEUE_LEN + 2; i++) {
+        request(s_peer_a, c++, &s_addr_a, "miu x");
+    }
+    CHECK_EQ(s_stats.queue_full, 2);
+    CHECK_EQ(drain(), APP_RMT_QUEUE_LEN);
+    CHECK_EQ(s_stats.rate_limited, 5);
+    CHECK_EQ(g_ot_mock.unlocked_calls, 0);
+}
+
+static void test_window_kept_across_reboot(void) {
+    uint32_t sets, c;
+    rmt_frame_t rsp;
+
+    setup();
+    sets = g_efd_stub_stats.sets;
+    meet(s_peer_a, &s_addr_a);
+    for (c = 2; c <= 5; c++) {
+        request(s_peer_a, c, &s_addr_a, "miu x");
+        drain();
+    }
+    CHECK_EQ(s_runs, 4);
+    /* one write reserves APP_RMT_SAVE_STEP counters */
+    CHECK_EQ(g_efd_stub_stats.sets - sets, 1);
+
+    reboot();
+    request(s_peer_a, 5, &s_addr_a, "miu x");
+    request(s_peer_a, 3, &s_addr_a, "miu x");
+    drain();
+    CHECK_EQ(s_runs, 0);
+    CHECK_EQ(s_stats.replayed, 2);
+    CHECK_EQ(last_response(&rsp), 0);
+    CHECK_EQ(rsp.status, RMT_STATUS_STALE);
+    CHECK_EQ(next_counter(&rsp), 1 + APP_RMT_SAVE_STEP + 1);
+
+    /* the sender catches up, and is saved again */
+    sets = g_efd_stub_stats.sets;
+    request(s_peer_a, next_counter(&rsp), &s_addr_a, "miu x");
+    drain();
+    CHECK_EQ(s_runs, 1);
+    CHECK_EQ(g_efd_stub_stats.sets - sets, 1);
+    reboot();
+    request(s_peer_a, 1 + APP_RMT_SAVE_STEP + 1, &s_addr_a, "miu x");
+    drain();
+    CHECK_EQ(s_runs, 0);
+
+    /* a sender never heard from is unaffected */
+    meet(s_peer_b, &s_addr_b);
+    request(s_peer_b, 2, &s_addr_b, "miu x");
+    drain();
+    CHECK_EQ(s_runs, 1);
+}
+
+static void test_sender_never_evicted(void) {
+    uint8_t other[RMT_SENDER_LEN] = {0xc};
+    uint8_t i;
+    rmt_frame_t rsp;
+    size_t len;
+
+    setup();
+    meet(s_peer_a, &s_addr_a);
+    request(s_peer_a, 2, &s_addr_a, "miu x");
+    request(s_peer_a, 3, &s_addr_a, "miu x");
+    drain();
+    CHECK_EQ(s_runs, 2);
+
+    /* the table filled up by other senders, each one only once */
+    for (i = 1; i < APP_RMT_PEERS; i++) {
+        other[7] = i;
+        g_stub_tick += configTICK_RATE_HZ;
+        meet(other, &s_addr_b);
+    }
+    other[7] = APP_RMT_PEERS;
+    g_ot_mock_sent_num = 0;
+    request(other, 1, &s_addr_b, "miu x");
+    drain();
+    CHECK_EQ(s_stats.peers_full, 1);
+    CHECK_EQ(g_ot_mock_sent_num, 0);
+
+    /* the old request of the first sender stays refused, also after a
+     * reboot */
+    request(s_peer_a, 3, &s_addr_b, "miu x");
+    drain();
+    CHECK_EQ(s_runs, 2);
+    CHECK_EQ(last_response(&rsp), 0);
+    CHECK_EQ(rsp.status, RMT_STATUS_STALE);
+    reboot();
+    request(s_peer_a, 3, &s_addr_b, "miu x");
+    drain();
+    CHECK_EQ(s_runs, 0);
+    CHECK_EQ(s_stats.replayed, 1);
+
+    /* a new key frees the table */
+    CHECK_EQ(rmt_cli("rmt key mesh-new-key"), 0);
+    request(s_peer_a, 4, &s_addr_a, "miu x");
+    drain();
+    CHECK_EQ(s_stats.auth_failed, 1);
+    for (i = 0; i < APP_RMT_PEERS; i++) {
+        CHECK(!s_peers[i].valid);
+    }
+    CHECK(efd_get_env_blob(APP_RMT_PEERS_ENV, s_saved, sizeof(s_saved), &len)
+          == 0);
+}
+
+static void test_tx_counter_kept_across_reboot(void) {
+    rmt_frame_t req;
+    uint32_t first;
+
+    setup();
+    CHECK_EQ(rmt_cli("rmt send fd00::b miu x"), 0);
+    CHECK_EQ(rmt_cli("rmt send fd00::b miu x"), 0);
+    CHECK_EQ(g_ot_mock_sent_num, 2);
+    CHECK_EQ(rmt_decode(g_ot_mock_sent[1].data, g_ot_mock_sent[1].len,
+                        s_peer_key, sizeof(s_peer_key) - 1, &req),
+             0);
+    CHECK_EQ(req.counter, 2);
+    CHECK_EQ(req.sender[0], 0xee);
+    CHECK(!memcmp(&g_ot_mock_sent[1].dst, &s_addr_b, sizeof(s_addr_b)));
+
+    /* never a counter the peer may have seen */
+    reboot();
+    CHECK_EQ(rmt_cli("rmt send fd00::b miu x"), 0);
+    CHECK_EQ(rmt_decode(g_ot_mock_sent[0].data, g_ot_mock_sent[0].len,
+                        s_peer_key, sizeof(s_peer_key) - 1, &req),
+             0);
+    first = req.counter;
+    CHECK(first > 2);
+    CHECK(first <= 1 + APP_RMT_SAVE_STEP + 1);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_no_key_no_service);
+    HOST_TEST_RUN(test_request_answered);
+    HOST_TEST_RUN(test_replay_keyed_on_sender);
+    HOST_TEST_RUN(test_rate_limited);
+    HOST_TEST_RUN(test_window_kept_across_reboot);
+    HOST_TEST_RUN(test_sender_never_evicted);
+    HOST_TEST_RUN(test_tx_counter_kept_across_reboot);
+    return HOST_TEST_END();
+}
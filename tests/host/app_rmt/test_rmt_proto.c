@@ -0,0 +1,161 @@
+/**
+ * @file test_rmt_proto.c
+ * @brief Remote command frames of mesh-it-up: layout, tag checks, the
+ *        replay window and its restore from a saved floor.
+ */
+
+#include <string.h>
+#include "hosal_crypto_sha256.h"
+#include "host_test.h"
+#include "rmt_proto.h"
+
+static const uint8_t s_key[] = "test-key";
+static const uint8_t s_sender[RMT_SENDER_LEN] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+static uint16_t encode(uint8_t* buf, uint8_t type, uint32_t counter,
+                       const char* payload) {
+    rmt_frame_t frame = {
+        .type = type,
+        .id = 0x1234,
+        .counter = counter,
+        .len = strlen(payload),
+        .payload = (const uint8_t*)payload,
+    };
+
+    memcpy(frame.sender, s_sender, RMT_SENDER_LEN);
+    return rmt_encode(buf, &frame, s_key, sizeof(s_key) - 1);
+}
+
+static void test_hmac_vector(void) {
+    /* RFC 4231 test case 2 */
+    static const uint8_t expect[SHA256_DIGEST_SIZE] = {
+        0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e, 0x6a, 0x04, 0x24,
+        0x26, 0x08, 0x95, 0x75, 0xc7, 0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27,
+        0x39, 0x83, 0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43,
+    };
+    static const char msg[] = "what do ya want for nothing?";
+    uint8_t digest[SHA256_DIGEST_SIZE];
+
+    hmac_sha256((const uint8_t*)"Jefe", 4, (const uint8_t*)msg,
+                sizeof(msg) - 1, digest);
+    CHECK(memcmp(digest, expect, sizeof(expect)) == 0);
+}
+
+static void test_layout(void) {
+    uint8_t buf[RMT_FRAME_MAX];
+    rmt_frame_t frame;
+    uint16_t len;
+
+    len = encode(buf, RMT_TYPE_REQUEST, 0x01020304, "phy show");
+    CHECK_EQ(len, RMT_HDR_LEN + 8 + RMT_TAG_LEN);
+    CHECK_EQ(buf[0], RMT_MAGIC);
+    CHECK_EQ(buf[1], RMT_TYPE_REQUEST);
+    CHECK_EQ(buf[2] | buf[3] << 8, 0x1234);
+    CHECK(memcmp(&buf[4], s_sender, RMT_SENDER_LEN) == 0);
+    CHECK_EQ(buf[12], 0x04);
+    CHECK_EQ(buf[15], 0x01);
+    CHECK_EQ(buf[17], 8);
+    CHECK(memcmp(&buf[RMT_HDR_LEN], "phy show", 8) == 0);
+    CHECK(rmt_is_frame(buf, len));
+
+    CHECK_EQ(rmt_decode(buf, len, s_key, sizeof(s_key) - 1, &frame), 0);
+    CHECK_EQ(frame.type, RMT_TYPE_REQUEST);
+    CHECK_EQ(frame.id, 0x1234);
+    CHECK(memcmp(frame.sender, s_sender, RMT_SENDER_LEN) == 0);
+    CHECK_EQ(frame.counter, 0x01020304);
+    CHECK_EQ(frame.len, 8);
+    CHECK(frame.payload == &buf[RMT_HDR_LEN]);
+
+    /* an empty payload, and one too long to carry */
+    CHECK_EQ(encode(buf, RMT_TYPE_RESPONSE, 1, ""),
+             RMT_HDR_LEN + RMT_TAG_LEN);
+    frame.len = RMT_PAYLOAD_MAX + 1;
+    CHECK_EQ(rmt_encode(buf, &frame, s_key, sizeof(s_key) - 1), 0);
+}
+
+static void test_framing_rejects(void) {
+    uint8_t buf[RMT_FRAME_MAX];
+    uint16_t len = encode(buf, RMT_TYPE_REQUEST, 7, "miu");
+    rmt_frame_t frame;
+
+    CHECK(!rmt_is_frame(buf, len - 1));
+    CHECK(!rmt_is_frame(buf, RMT_HDR_LEN + RMT_TAG_LEN - 1));
+    CHECK_EQ(rmt_decode(buf, len + 1, s_key, sizeof(s_key) - 1, &frame),
+             RMT_ERR_FORMAT);
+
+    buf[0] = 0xA7;
+    CHECK(!rmt_is_frame(buf, len));
+    buf[0] = RMT_MAGIC;
+    buf[1] = 3;
+    CHECK(!rmt_is_frame(buf, len));
+    buf[1] = RMT_TYPE_REQUEST;
+    buf[17] = RMT_PAYLOAD_MAX + 1;
+    CHECK(!rmt_is_frame(buf, len));
+}
+
+static void test_tag_covers_frame(void) {
+    uint8_t buf[RMT_FRAME_MAX];
+    uint16_t len = encode(buf, RMT_TYPE_REQUEST, 9, "phy show");
+    rmt_frame_t frame;
+    uint16_t i;
+
+    /* every header, payload and tag byte, the sender id included */
+    for (i = 2; i < len; i++) {
+        if (i == 17) {
+            continue;
+        }
+        buf[i] ^= 0x01;
+        CHECK_EQ(rmt_decode(buf, len, s_key, sizeof(s_key) - 1, &frame),
+                 RMT_ERR_AUTH);
+        buf[i] ^= 0x01;
+    }
+    CHECK_EQ(rmt_decode(buf, len, (const uint8_t*)"other", 5, &frame),
+             RMT_ERR_AUTH);
+    CHECK_EQ(rmt_decode(buf, len, s_key, sizeof(s_key) - 1, &frame), 0);
+}
+
+static void test_replay_window(void) {
+    rmt_replay_t window = {0};
+
+    CHECK_EQ(rmt_replay_accept(&window, 0), -1);
+    CHECK_EQ(rmt_replay_accept(&window, 5), 0);
+    CHECK_EQ(rmt_replay_accept(&window, 5), -1);
+    CHECK_EQ(rmt_replay_accept(&window, 3), 0);
+    CHECK_EQ(rmt_replay_accept(&window, 3), -1);
+    CHECK_EQ(rmt_replay_accept(&window, 4), 0);
+
+    /* out of order within the window, too old behind it */
+    CHECK_EQ(rmt_replay_accept(&window, 40), 0);
+    CHECK_EQ(rmt_replay_accept(&window, 40 - RMT_REPLAY_WINDOW + 1), 0);
+    CHECK_EQ(rmt_replay_accept(&window, 40 - RMT_REPLAY_WINDOW), -1);
+    CHECK_EQ(rmt_replay_accept(&window, 5), -1);
+    CHECK_EQ(rmt_replay_accept(&window, 41), 0);
+    CHECK_EQ(window.top, 41);
+}
+
+static void test_replay_restore(void) {
+    rmt_replay_t window;
+    uint32_t c;
+
+    /* everything up to the floor counts as seen */
+    rmt_replay_restore(&window, 100);
+    for (c = 100 - RMT_REPLAY_WINDOW; c <= 100; c++) {
+        CHECK_EQ(rmt_replay_accept(&window, c), -1);
+    }
+    CHECK_EQ(rmt_replay_accept(&window, 102), 0);
+    CHECK_EQ(rmt_replay_accept(&window, 101), 0);
+    CHECK_EQ(rmt_replay_accept(&window, 101), -1);
+
+    rmt_replay_restore(&window, 0);
+    CHECK_EQ(rmt_replay_accept(&window, 1), 0);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_hmac_vector);
+    HOST_TEST_RUN(test_layout);
+    HOST_TEST_RUN(test_framing_rejects);
+    HOST_TEST_RUN(test_tag_covers_frame);
+    HOST_TEST_RUN(test_replay_window);
+    HOST_TEST_RUN(test_replay_restore);
+    return HOST_TEST_END();
+}
@@ -0,0 +1,307 @@
+/**
+ * @file test_app_udp.c
+ * @brief Application UDP service of the mesh-it-up apps against the
+ *        OpenThread stand-in of ot/: batching, the batch timer, the buffer
+ *        reserve and receive.
+ *
+ * The batch timer runs as in the timer daemon and must only post the flush,
+ * every stack call is checked to run with the stack lock held, and the
+ * stack lock is never taken inside the service's own lock.
+ */
+
+#include <string.h>
+#include "app_ot_job.h"
+#include "app_udp.h"
+#include "host_test.h"
+#include "miu_port.h"
+#include "ot_mock.h"
+#include "semphr.h"
+#include "timers.h"
+
+#define LATENCY pdMS_TO_TICKS(APP_UDP_BATCH_LATENCY_MS)
+#define PORT    5678
+
+typedef struct {
+    uint16_t len;
+    uint8_t nul;
+    uint8_t data[APP_UDP_RX_MAX];
+} rx_t;
+
+static rx_t s_rx[16];
+static uint32_t s_rx_num;
+
+static void rx_cb(uint8_t* p, uint16_t len, const otMessageInfo* info) {
+    rx_t* rx = &s_rx[s_rx_num++];
+
+    (void)info;
+    rx->len = len;
+    rx->nul = p[len] == '\0';
+    memcpy(rx->data, p, len);
+}
+
+static otIp6Address addr(uint8_t id) {
+    otIp6Address a;
+
+    memset(&a, 0, sizeof(a));
+    a.mFields.m8[0] = 0xfd;
+    a.mFields.m8[15] = id;
+    return a;
+}
+
+static void setup(void) {
+    static int opened;
+
+    ot_mock_reset();
+    if (!opened) {
+        app_ot_job_init(otrGetInstance());
+        otrLock();
+        CHECK_EQ(app_sockInit(otrGetInstance(), rx_cb, PORT), OT_ERROR_NONE);
+        otrUnlock();
+        opened = 1;
+    }
+    app_udpFlush();
+    ot_mock_reset();
+    app_udpStatsReset();
+    s_rx_num = 0;
+}
+
+/* no stack call outside the lock, from the timer daemon or in bad order */
+static void check_stack_use(void) {
+    CHECK_EQ(g_ot_mock.unlocked_calls, 0);
+    CHECK_EQ(g_ot_mock.timer_calls, 0);
+    CHECK_EQ(g_ot_mock.lock_order, 0);
+    CHECK_EQ(g_ot_mock.lock_depth, 0);
+    CHECK_EQ(g_stub_mutex_held, 0);
+    CHECK_EQ(ot_mock_messages_used(), 0);
+}
+
+static void queue_str(uint8_t id, const char* s) {
+    otIp6Address dst = addr(id);
+
+    CHECK_EQ(app_udpQueue(&dst, (const uint8_t*)s, (uint8_t)strlen(s)), 0);
+}
+
+static void test_timer_posts_flush(void) {
+    otIp6Address a = addr(1);
+
+    setup();
+    queue_str(1, "abc");
+    stub_timers_advance(LATENCY - 1);
+    CHECK_EQ(ot_mock_jobs_pending(), 0);
+    CHECK_EQ(g_ot_mock_sent_num, 0);
+
+    /* the timer only posts, the datagram leaves from the OpenThread task */
+    stub_timers_advance(1);
+    CHECK(ot_mock_jobs_pending() != 0);
+    CHECK_EQ(g_ot_mock_sent_num, 0);
+    CHECK_EQ(ot_mock_run_jobs(), 1);
+    CHECK_EQ(g_ot_mock_sent_num, 1);
+    CHECK(!memcmp(&g_ot_mock_sent[0].dst, &a, sizeof(a)));
+    CHECK_EQ(g_ot_mock_sent[0].port, PORT);
+
+    /* nothing open, the timer stays stopped */
+    stub_timers_advance(LATENCY * 2);
+    CHECK_EQ(ot_mock_jobs_pending(), 0);
+    check_stack_use();
+}
+
+/* the job sends what is due and re-arms for the rest */
+static void test_timer_rearms(void) {
+    otIp6Address b = addr(2);
+
+    setup();
+    queue_str(1, "first");
+    stub_timers_advance(LATENCY / 2);
+    queue_str(2, "second");
+    stub_timers_advance(LATENCY - LATENCY / 2);
+    CHECK_EQ(ot_mock_run_jobs(), 1);
+    CHECK_EQ(g_ot_mock_sent_num, 1);
+
+    stub_timers_advance(LATENCY / 2 - 1);
+    CHECK_EQ(ot_mock_jobs_pending(), 0);
+    stub_timers_advance(1);
+    CHECK_EQ(ot_mock_run_jobs(), 1);
+    CHECK_EQ(g_ot_mock_sent_num, 2);
+    CHECK(!memcmp(&g_ot_mock_sent[1].dst, &b, sizeof(b)));
+    check_stack_use();
+}
+
+/* a late job, after the batch went out some other way, sends nothing */
+static void test_late_job(void) {
+    setup();
+    queue_str(1, "abc");
+    stub_timers_advance(LATENCY);
+    app_udpFlush();
+    CHECK_EQ(g_ot_mock_sent_num, 1);
+    ot_mock_run_jobs();
+    CHECK_EQ(g_ot_mock_sent_num, 1);
+    check_stack_use();
+}
+
+static void test_batch_format(void) {
+    static const uint8_t want[] = {0xB7, 3, 'a', 'b', 'c', 1, 'x', 2, 'y', 'z'};
+    app_udp_stats_t stats;
+
+    setup();
+    queue_str(1, "abc");
+    queue_str(1, "x");
+    queue_str(1, "yz");
+    app_udpFlush();
+    CHECK_EQ(g_ot_mock_sent_num, 1);
+    CHECK_EQ(g_ot_mock_sent[0].len, sizeof(want));
+    CHECK(!memcmp(g_ot_mock_sent[0].data, want, sizeof(want)));
+
+    app_udpStats(&stats);
+    CHECK_EQ(stats.tx_records, 3);
+    CHECK_EQ(stats.tx_batches, 1);
+    CHECK_EQ(stats.tx_datagrams, 1);
+    CHECK_EQ(stats.tx_bytes, sizeof(want));
+
+    /* empty and oversize records are refused */
+    CHECK_EQ(app_udpQueue(&(otIp6Address){0}, (const uint8_t*)"", 0), -1);
+    CHECK_EQ(app_udpQueue(&(otIp6Address){0}, s_rx[0].data, 255), -1);
+    check_stack_use();
+}
+
+static void test_full_batch(void) {
+    uint8_t rec[60];
+    uint32_t i, num;
+
+    setup();
+    memset(rec, 'r', sizeof(rec));
+    otIp6Address a = addr(1);
+
+    /* records of 61 bytes, four fit after the magic byte */
+    num = (APP_UDP_BATCH_SIZE - 1) / (1 + sizeof(rec));
+    for (i = 0; i < num; i++) {
+        CHECK_EQ(app_udpQueue(&a, rec, sizeof(rec)), 0);
+    }
+    CHECK_EQ(g_ot_mock_sent_num, 0);
+    CHECK_EQ(app_udpQueue(&a, rec, sizeof(rec)), 0);
+    CHECK_EQ(g_ot_mock_sent_num, 1);
+    CHECK_EQ(g_ot_mock_sent[0].len, 1 + num * (1 + sizeof(rec)));
+
+    app_udpFlush();
+    CHECK_EQ(g_ot_mock_sent_num, 2);
+    CHECK_EQ(g_ot_mock_sent[1].len, 1 + 1 + sizeof(rec));
+    check_stack_use();
+}
+
+/* more destinations than slots send the one waiting longest early */
+static void test_dest_overflow(void) {
+    otIp6Address first = addr(1);
+    uint8_t i;
+
+    setup();
+    for (i = 1; i <= APP_UDP_BATCH_DEST; i++) {
+        queue_str(i, "r");
+        stub_timers_advance(1);
+    }
+    CHECK_EQ(g_ot_mock_sent_num, 0);
+    queue_str(APP_UDP_BATCH_DEST + 1, "r");
+    CHECK_EQ(g_ot_mock_sent_num, 1);
+    CHECK(!memcmp(&g_ot_mock_sent[0].dst, &first, sizeof(first)));
+
+    app_udpFlush();
+    CHECK_EQ(g_ot_mock_sent_num, APP_UDP_BATCH_DEST + 1);
+    check_stack_use();
+}
+
+/* a direct send goes after what was queued to the same destination */
+static void test_send_to_order(void) {
+    otIp6Address a = addr(1);
+
+    setup();
+    queue_str(1, "queued");
+    queue_str(2, "other");
+    app_udpSendTo(&a, 1234, (const uint8_t*)"direct", 6);
+    CHECK_EQ(g_ot_mock_sent_num, 2);
+    CHECK_EQ(g_ot_mock_sent[0].data[0], 0xB7);
+    CHECK_EQ(g_ot_mock_sent[0].port, PORT);
+    CHECK_EQ(g_ot_mock_sent[1].len, 6);
+    CHECK_EQ(g_ot_mock_sent[1].port, 1234);
+    CHECK(!memcmp(g_ot_mock_sent[1].data, "direct", 6));
+
+    /* the batch to the other destination is still open */
+    app_udpFlush();
+    CHECK_EQ(g_ot_mock_sent_num, 3);
+    check_stack_use();
+}
+
+static void test_reserve_and_failures(void) {
+    app_udp_stats_t stats;
+
+    setup();
+    g_ot_mock.free_buffers = APP_UDP_RESERVED_BUFFERS;
+    queue_str(1, "a");
+    queue_str(1, "b");
+    app_udpFlush();
+    app_udpStats(&stats);
+    CHECK_EQ(g_ot_mock_sent_num, 0);
+    CHECK_EQ(stats.reserve_refused, 1);
+    CHECK_EQ(stats.records_dropped, 2);
+
+    g_ot_mock.free_buffers = APP_UDP_RESERVED_BUFFERS + 1;
+    g_ot_mock.alloc_fail = 1;
+    queue_str(1, "c");
+    app_udpFlush();
+    g_ot_mock.alloc_fail = 0;
+    g_ot_mock.send_error = OT_ERROR_BUSY;
+    app_udpSendTo(&(otIp6Address){0}, PORT, (const uint8_t*)"d", 1);
+    app_udpStats(&stats);
+    CHECK_EQ(stats.alloc_failed, 1);
+    CHECK_EQ(stats.send_failed, 1);
+    CHECK_EQ(stats.records_dropped, 3);
+    CHECK_EQ(stats.tx_datagrams, 0);
+    check_stack_use();
+}
+
+static void test_receive(void) {
+    static const uint8_t batch[] = {0xB7, 2, 'h', 'i', 3, 'o', 'n', 'e'};
+    static const uint8_t bad[] = {0xB7, 5, 'h', 'i'};
+    static uint8_t big[APP_UDP_RX_MAX + 1];
+    otIp6Address peer = addr(9);
+    app_udp_stats_t stats;
+
+    setup();
+    ot_mock_udp_deliver(batch, sizeof(batch), &peer, PORT);
+    CHECK_EQ(s_rx_num, 2);
+    CHECK_EQ(s_rx[0].len, 2);
+    CHECK(!memcmp(s_rx[0].data, "hi", 2));
+    CHECK(s_rx[0].nul);
+    CHECK_EQ(s_rx[1].len, 3);
+    CHECK(!memcmp(s_rx[1].data, "one", 3));
+    CHECK(s_rx[1].nul);
+
+    /* not a well formed batch, delivered as one record */
+    ot_mock_udp_deliver(bad, sizeof(bad), &peer, PORT);
+    CHECK_EQ(s_rx_num, 3);
+    CHECK_EQ(s_rx[2].len, sizeof(bad));
+    CHECK(s_rx[2].nul);
+
+    ot_mock_udp_deliver(big, APP_UDP_RX_MAX, &peer, PORT);
+    CHECK_EQ(s_rx_num, 4);
+    CHECK_EQ(s_rx[3].len, APP_UDP_RX_MAX);
+    CHECK(s_rx[3].nul);
+    ot_mock_udp_deliver(big, sizeof(big), &peer, PORT);
+    CHECK_EQ(s_rx_num, 4);
+
+    app_udpStats(&stats);
+    CHECK_EQ(stats.rx_datagrams, 4);
+    CHECK_EQ(stats.rx_records, 4);
+    CHECK_EQ(stats.rx_oversize, 1);
+    check_stack_use();
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_timer_posts_flush);
+    HOST_TEST_RUN(test_timer_rearms);
+    HOST_TEST_RUN(test_late_job);
+    HOST_TEST_RUN(test_batch_format);
+    HOST_TEST_RUN(test_full_batch);
+    HOST_TEST_RUN(test_dest_overflow);
+    HOST_TEST_RUN(test_send_to_order);
+    HOST_TEST_RUN(test_reserve_and_failures);
+    HOST_TEST_RUN(test_receive);
+    return HOST_TEST_END();
+}
@@ -0,0 +1,365 @@
+/**
+ * @file test_cli_args.c
+ * @brief Shared CLI core of the Zigbee and BLE mesh gateways: argument
+ *        schemas, keyword and sub-command lookup by unique prefix,
+ *        completion, line splitting and the script runner, which also runs
+ *        the fixture script.txt and a generated script of many lines.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "host_test.h"
+#include "cli_args.h"
+
+#define SCRIPT_LINES 20000
+
+enum {
+    MODE_OFF,
+    MODE_ON,
+    MODE_TOGGLE,
+};
+
+typedef struct {
+    uint16_t addr;
+    uint8_t ep;
+    uint8_t level;
+    int16_t offset;
+    uint32_t period;
+    uint8_t mode;
+    char *pName;
+} args_t;
+
+/* sorted by name */
+static const cli_keyword_t s_modes[] = {
+    {"off", MODE_OFF},
+    {"on", MODE_ON},
+    {"toggle", MODE_TOGGLE},
+};
+
+static const cli_arg_t s_schema[] = {
+    CLI_ARG_NUM(args_t, addr, CLI_ARG_U16, 0, 0xFFF7, "addr"),
+    CLI_ARG_NUM(args_t, ep, CLI_ARG_U8, 1, 240, "ep"),
+    CLI_ARG_KEY(args_t, mode, s_modes, "mode"),
+    CLI_ARG_NUM(args_t, offset, CLI_ARG_S16, -500, 500, "offset"),
+    CLI_ARG_STRING(args_t, pName, "name"),
+    CLI_ARG_NUM_OPT(args_t, period, CLI_ARG_U32, 100, 60000, "period"),
+};
+
+static const cli_arg_t s_level_schema[] = {
+    CLI_ARG_NUM(args_t, addr, CLI_ARG_U16, 0, 0xFFF7, "addr"),
+    CLI_ARG_NUM(args_t, ep, CLI_ARG_U8, 1, 240, "ep"),
+    CLI_ARG_NUM(args_t, level, CLI_ARG_U8, 0, 0xFE, "level"),
+};
+
+static const cli_arg_t s_mode_schema[] = {
+    CLI_ARG_KEY(args_t, mode, s_modes, "mode"),
+};
+
+/* state of the mock commands run by the scripts */
+typedef struct {
+    uint32_t resets;
+    uint32_t joins;
+    uint32_t levels;
+    uint32_t ons;
+    uint32_t modes;
+    uint32_t level_sum;
+    uint16_t last_addr;
+    uint8_t last_mode;
+} script_state_t;
+
+static int cmd_join(int argc, char **argv, void *pCtx) {
+    script_state_t *pState = pCtx;
+    args_t args;
+
+    if (cli_args_parse(argc - 1, argv + 1, s_level_schema, 2, &args) != 0) {
+        return -1;
+    }
+    pState->joins++;
+    pState->last_addr = args.addr;
+    return 0;
+}
+
+static int cmd_level(int argc, char **argv, void *pCtx) {
+    script_state_t *pState = pCtx;
+    args_t args;
+
+    if (cli_args_parse(argc - 1, argv + 1, s_level_schema, CLI_ARGS_COUNT(s_level_schema), &args) != 0) {
+        return -1;
+    }
+    pState->levels++;
+    pState->level_sum += args.level;
+    pState->last_addr = args.addr;
+    return 0;
+}
+
+static int cmd_mode(int argc, char **argv, void *pCtx) {
+    script_state_t *pState = pCtx;
+    args_t args;
+
+    if (cli_args_parse(argc - 1, argv + 1, s_mode_schema, CLI_ARGS_COUNT(s_mode_schema), &args) != 0) {
+        return -1;
+    }
+    pState->modes++;
+    pState->last_mode = args.mode;
+    return 0;
+}
+
+static int cmd_on(int argc, char **argv, void *pCtx) {
+    ((script_state_t *)pCtx)->ons++;
+    return argc == 3 ? 0 : -1;
+}
+
+static int cmd_reset(int argc, char **argv, void *pCtx) {
+    ((script_state_t *)pCtx)->resets++;
+    return 0;
+}
+
+/* sorted by name */
+static const cli_subcmd_t s_cmds[] = {
+    {"join", cmd_join},
+    {"level", cmd_level},
+    {"mode", cmd_mode},
+    {"on", cmd_on},
+    {"reset", cmd_reset},
+};
+
+static int parse(const char *pLine, args_t *pArgs) {
+    static char line[128];
+    char *argv[8];
+    int argc;
+
+    strcpy(line, pLine);
+    argc = cli_args_split(line, argv, 8);
+    return cli_args_parse(argc, argv, s_schema, CLI_ARGS_COUNT(s_schema), pArgs);
+}
+
+static void test_parse(void) {
+    args_t args = {.period = 1000};
+
+    CHECK_EQ(parse("0x1234 2 on -20 lamp", &args), 0);
+    CHECK_EQ(args.addr, 0x1234);
+    CHECK_EQ(args.ep, 2);
+    CHECK_EQ(args.mode, MODE_ON);
+    CHECK_EQ(args.offset, -20);
+    CHECK(strcmp(args.pName, "lamp") == 0);
+    /* optional and missing keeps the field */
+    CHECK_EQ(args.period, 1000);
+
+    CHECK_EQ(parse("4660 240 t 500 x 0xEA60", &args), 0);
+    CHECK_EQ(args.addr, 4660);
+    CHECK_EQ(args.mode, MODE_TOGGLE);
+    CHECK_EQ(args.period, 60000);
+
+    /* ranges, both ends */
+    CHECK_EQ(parse("0xFFF7 1 off -500 x", &args), 0);
+    CHECK_EQ(parse("0xFFF8 1 off 0 x", &args), -1);
+    CHECK_EQ(parse("1 0 off 0 x", &args), -1);
+    CHECK_EQ(parse("1 241 off 0 x", &args), -1);
+    CHECK_EQ(parse("1 1 off -501 x", &args), -1);
+    CHECK_EQ(parse("1 1 off 0 x 99", &args), -1);
+    /* malformed numbers */
+    CHECK_EQ(parse("0x 1 off 0 x", &args), -1);
+    CHECK_EQ(parse("12a 1 off 0 x", &args), -1);
+    CHECK_EQ(parse("0xZ 1 off 0 x", &args), -1);
+    /* "o" is off and on, missing arguments */
+    CHECK_EQ(parse("1 1 o 0 x", &args), -1);
+    CHECK_EQ(parse("1 1 off 0", &args), -1);
+    CHECK_EQ(parse("", &args), -1);
+}
+
+/* a sorted table of every two letter word against a linear scan */
+static void test_keyword_match(void) {
+    static char names[26 * 26][3];
+    static cli_keyword_t table[255];
+    char prefix[3] = {0};
+    const cli_keyword_t *pKey;
+    uint16_t i, n = 0;
+    int c;
+
+    for (i = 0; i < 255; i++) {
+        names[i][0] = (char)('a' + i / 26);
+        names[i][1] = (char)('a' + i % 26);
+        table[n].pName = names[i];
+        table[n].id = (uint8_t)n;
+        n++;
+    }
+
+    for (i = 0; i < n; i++) {
+        pKey = cli_keyword_find(table, (uint8_t)n, table[i].pName);
+        CHECK(pKey == &table[i]);
+        CHECK(cli_keyword_match(table, (uint8_t)n, table[i].pName) == &table[i]);
+    }
+    CHECK(cli_keyword_find(table, (uint8_t)n, "zz") == NULL);
+    CHECK(cli_keyword_match(table, (uint8_t)n, "zz") == NULL);
+    CHECK(cli_keyword_match(table, (uint8_t)n, "aaa") == NULL);
+
+    /* a single letter starts several words, 'j' the last 21 */
+    for (c = 'a'; c <= 'j'; c++) {
+        prefix[0] = (char)c;
+        CHECK(cli_keyword_match(table, (uint8_t)n, prefix) == NULL);
+    }
+    CHECK(cli_keyword_match(s_modes, 3, "t") == &s_modes[MODE_TOGGLE]);
+    CHECK(cli_keyword_match(s_modes, 3, "of") == &s_modes[MODE_OFF]);
+    CHECK(cli_keyword_match(s_modes, 3, "o") == NULL);
+    CHECK(cli_keyword_match(s_modes, 3, "onx") == NULL);
+    CHECK(cli_keyword_match(s_modes, 0, "on") == NULL);
+}
+
+static int s_sub_ret;
+
+static int sub_exec(int argc, char **argv, void *pCtx) {
+    *(const char **)pCtx = argv[0];
+    return s_sub_ret;
+}
+
+static void test_subcmd(void) {
+    static const cli_subcmd_t cmds[] = {
+        {"cfg", sub_exec},
+        {"start", sub_exec},
+        {"stop", sub_exec},
+    };
+    char w0[] = "sta", w1[] = "st", w2[] = "x", w3[] = "cfg";
+    char *argv[1];
+    const char *pRan = NULL;
+
+    argv[0] = w0;
+    s_sub_ret = 0;
+    CHECK_EQ(cli_subcmd_run(1, argv, cmds, 3, &pRan), 0);
+    CHECK(pRan == w0);
+
+    pRan = NULL;
+    argv[0] = w1;
+    CHECK_EQ(cli_subcmd_run(1, argv, cmds, 3, &pRan), -1);
+    argv[0] = w2;
+    CHECK_EQ(cli_subcmd_run(1, argv, cmds, 3, &pRan), -1);
+    CHECK_EQ(cli_subcmd_run(0, argv, cmds, 3, &pRan), -1);
+    CHECK(pRan == NULL);
+
+    /* the handler's result comes back */
+    argv[0] = w3;
+    s_sub_ret = 7;
+    CHECK_EQ(cli_subcmd_run(1, argv, cmds, 3, &pRan), 7);
+}
+
+static void test_complete(void) {
+    char out[8];
+    char w0[] = "1", w1[] = "2", w2[] = "o";
+    char *argv[3] = {w0, w1, w2};
+
+    CHECK_EQ(cli_keyword_complete(s_modes, 3, "t", out, sizeof(out)), 1);
+    CHECK(strcmp(out, "oggle") == 0);
+    CHECK_EQ(cli_keyword_complete(s_modes, 3, "o", out, sizeof(out)), 2);
+    CHECK(strcmp(out, "") == 0);
+    CHECK_EQ(cli_keyword_complete(s_modes, 3, "", out, sizeof(out)), 3);
+    CHECK_EQ(cli_keyword_complete(s_modes, 3, "on", out, sizeof(out)), 1);
+    CHECK(strcmp(out, "") == 0);
+    CHECK_EQ(cli_keyword_complete(s_modes, 3, "x", out, sizeof(out)), 0);
+    /* cut to the output size */
+    CHECK_EQ(cli_keyword_complete(s_modes, 3, "t", out, 3), 1);
+    CHECK(strcmp(out, "og") == 0);
+
+    CHECK_EQ(cli_subcmd_complete(s_cmds, CLI_ARGS_COUNT(s_cmds), "l", out, sizeof(out)), 1);
+    CHECK(strcmp(out, "evel") == 0);
+    CHECK_EQ(cli_subcmd_complete(s_cmds, CLI_ARGS_COUNT(s_cmds), "", out, sizeof(out)), 5);
+
+    /* the third argument of the schema is the keyword */
+    CHECK_EQ(cli_args_complete(3, argv, s_schema, CLI_ARGS_COUNT(s_schema), out, sizeof(out)), 2);
+    CHECK_EQ(cli_args_complete(2, argv, s_schema, CLI_ARGS_COUNT(s_schema), out, sizeof(out)), 0);
+}
+
+static void test_split(void) {
+    char line[] = "  a\tbb  \r\n", big[] = "1 2 3 4 5";
+    char *argv[4];
+
+    CHECK_EQ(cli_args_split(line, argv, 4), 2);
+    CHECK(strcmp(argv[0], "a") == 0);
+    CHECK(strcmp(argv[1], "bb") == 0);
+    CHECK_EQ(cli_args_split(big, argv, 4), 4);
+    CHECK(strcmp(argv[3], "4") == 0);
+    line[0] = '\0';
+    CHECK_EQ(cli_args_split(line, argv, 4), 0);
+}
+
+static void test_script_file(void) {
+    static char text[4096];
+    script_state_t state = {0};
+    size_t len;
+    FILE *f = fopen(CLI_ARGS_SCRIPT, "r");
+
+    CHECK(f != NULL);
+    if (!f) {
+        return;
+    }
+    len = fread(text, 1, sizeof(text) - 1, f);
+    fclose(f);
+    text[len] = '\0';
+
+    CHECK_EQ(cli_script_run(text, s_cmds, CLI_ARGS_COUNT(s_cmds), &state), 0);
+    CHECK_EQ(state.resets, 1);
+    CHECK_EQ(state.joins, 2);
+    CHECK_EQ(state.levels, 2);
+    CHECK_EQ(state.level_sum, 128 + 0xFE);
+    CHECK_EQ(state.ons, 1);
+    CHECK_EQ(state.modes, 2);
+    CHECK_EQ(state.last_mode, MODE_OFF);
+    CHECK_EQ(state.last_addr, 0x5678);
+}
+
+static void test_script_stops(void) {
+    char ok[] = "reset\n\n# level 1 1 999\nlevel 1 1 1";
+    char bad_arg[] = "reset\nlevel 1 1 255\nreset";
+    char bad_cmd[] = "reset\r\nreset\r\nbogus 1\r\nreset";
+    char ambiguous[] = "re\nr\n";
+    script_state_t state = {0};
+
+    CHECK_EQ(cli_script_run(ok, s_cmds, CLI_ARGS_COUNT(s_cmds), &state), 0);
+    CHECK_EQ(state.levels, 1);
+    CHECK_EQ(cli_script_run(bad_arg, s_cmds, CLI_ARGS_COUNT(s_cmds), &state), 2);
+    CHECK_EQ(state.resets, 2);
+    CHECK_EQ(cli_script_run(bad_cmd, s_cmds, CLI_ARGS_COUNT(s_cmds), &state), 3);
+    CHECK_EQ(state.resets, 4);
+    CHECK_EQ(cli_script_run(ambiguous, s_cmds, CLI_ARGS_COUNT(s_cmds), &state), 0);
+    CHECK_EQ(state.resets, 6);
+}
+
+/* a production fixture drives many lines in one go */
+static void test_script_many(void) {
+    static char text[SCRIPT_LINES * 24];
+    script_state_t state = {0};
+    struct timespec t0, t1;
+    uint32_t i, level_sum = 0;
+    size_t pos = 0;
+    double ns;
+
+    for (i = 0; i < SCRIPT_LINES; i++) {
+        if (i % 4 == 3) {
+            pos += sprintf(text + pos, "mode %s\n", (i & 4) ? "on" : "tog");
+        } else {
+            pos += sprintf(text + pos, "level 0x%04X %u %u\n", i & 0xFFF, 1 + i % 240, i % 0xFF);
+            level_sum += i % 0xFF;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    CHECK_EQ(cli_script_run(text, s_cmds, CLI_ARGS_COUNT(s_cmds), &state), 0);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+    printf("  %u lines, %.0f ns per line\n", SCRIPT_LINES, ns / SCRIPT_LINES);
+
+    CHECK_EQ(state.levels, SCRIPT_LINES - SCRIPT_LINES / 4);
+    CHECK_EQ(state.modes, SCRIPT_LINES / 4);
+    CHECK_EQ(state.level_sum, level_sum);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_parse);
+    HOST_TEST_RUN(test_keyword_match);
+    HOST_TEST_RUN(test_subcmd);
+    HOST_TEST_RUN(test_complete);
+    HOST_TEST_RUN(test_split);
+    HOST_TEST_RUN(test_script_file);
+    HOST_TEST_RUN(test_script_stops);
+    HOST_TEST_RUN(test_script_many);
+    return HOST_TEST_END();
+}
@@ -0,0 +1,23 @@
+/**
+ * @file cli_mock.h
+ * @brief Heap calls of the CLI UART output queue, forced into
+ *        cli_uart.cpp. The test counts the blocks and can fail them.
+ */
+
+#ifndef __CLI_MOCK_H
+#define __CLI_MOCK_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void* pvPortMalloc(size_t size);
+void vPortFree(void* ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CLI_MOCK_H
@@ -0,0 +1,28 @@
+/**
+ * @file code_utils.hpp
+ * @brief Host stand-in for the OpenThread control flow macros
+ */
+
+#ifndef __CLI_MOCK_CODE_UTILS_HPP
+#define __CLI_MOCK_CODE_UTILS_HPP
+
+#define VerifyOrExit(aCondition, ...)                                          \
+    do {                                                                       \
+        if (!(aCondition)) {                                                   \
+            __VA_ARGS__;                                                       \
+            goto exit;                                                         \
+        }                                                                      \
+    } while (false)
+
+#define ExitNow(...)                                                           \
+    do {                                                                       \
+        __VA_ARGS__;                                                           \
+        goto exit;                                                             \
+    } while (false)
+
+#define OT_UNUSED_VARIABLE(aVariable) ((void)(aVariable))
+#define OT_FALL_THROUGH               [[fallthrough]]
+
+static inline void IgnoreError(int aError) { OT_UNUSED_VARIABLE(aError); }
+
+#endif // __CLI_MOCK_CODE_UTILS_HPP
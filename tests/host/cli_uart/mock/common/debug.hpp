@@ -0,0 +1,9 @@
+/**
+ * @file debug.hpp
+ * @brief Host stand-in, no OpenThread asserts are used by the CLI UART
+ */
+
+#ifndef __CLI_MOCK_DEBUG_HPP
+#define __CLI_MOCK_DEBUG_HPP
+
+#endif // __CLI_MOCK_DEBUG_HPP
@@ -0,0 +1,11 @@
+/**
+ * @file new.hpp
+ * @brief Host stand-in for placement new
+ */
+
+#ifndef __CLI_MOCK_NEW_HPP
+#define __CLI_MOCK_NEW_HPP
+
+#include <new>
+
+#endif // __CLI_MOCK_NEW_HPP
@@ -0,0 +1,44 @@
+/**
+ * @file tasklet.hpp
+ * @brief Host stand-in for the OpenThread tasklet. Post only marks it, the
+ *        test runs it in place of the OpenThread task.
+ */
+
+#ifndef __CLI_MOCK_TASKLET_HPP
+#define __CLI_MOCK_TASKLET_HPP
+
+#include "instance/instance.hpp"
+
+namespace ot {
+
+class Tasklet
+{
+public:
+    typedef void (&Handler)(Tasklet &aTasklet);
+
+    Tasklet(Instance &aInstance, Handler aHandler)
+        : mInstance(aInstance)
+        , mHandler(aHandler)
+        , mPosted(false)
+    {
+    }
+
+    void      Post(void) { mPosted = true; }
+    bool      IsPosted(void) const { return mPosted; }
+    Instance &GetInstance(void) const { return mInstance; }
+
+    void Run(void)
+    {
+        mPosted = false;
+        mHandler(*this);
+    }
+
+private:
+    Instance &mInstance;
+    Handler   mHandler;
+    bool      mPosted;
+};
+
+} // namespace ot
+
+#endif // __CLI_MOCK_TASKLET_HPP
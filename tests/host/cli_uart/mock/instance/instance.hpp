@@ -0,0 +1,23 @@
+/**
+ * @file instance.hpp
+ * @brief Host stand-in for the OpenThread instance
+ */
+
+#ifndef __CLI_MOCK_INSTANCE_HPP
+#define __CLI_MOCK_INSTANCE_HPP
+
+#include <openthread/instance.h>
+
+struct otInstance
+{
+};
+
+namespace ot {
+
+class Instance : public otInstance
+{
+};
+
+} // namespace ot
+
+#endif // __CLI_MOCK_INSTANCE_HPP
@@ -0,0 +1,11 @@
+/**
+ * @file openthread-core-config.h
+ * @brief Host stand-in, the CLI UART is built with the OpenThread defaults
+ */
+
+#ifndef __CLI_MOCK_CORE_CONFIG_H
+#define __CLI_MOCK_CORE_CONFIG_H
+
+#include <stdint.h>
+
+#endif // __CLI_MOCK_CORE_CONFIG_H
@@ -0,0 +1,27 @@
+/**
+ * @file cli.h
+ * @brief Host stand-in for the OpenThread CLI, the test runs the commands
+ */
+
+#ifndef __CLI_MOCK_OT_CLI_H
+#define __CLI_MOCK_OT_CLI_H
+
+#include <stdarg.h>
+#include <openthread/instance.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int (*otCliOutputCallback)(void* aContext, const char* aFormat,
+                                   va_list aArguments);
+
+void otCliInit(otInstance* aInstance, otCliOutputCallback aCallback,
+               void* aContext);
+void otCliInputLine(char* aBuf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CLI_MOCK_OT_CLI_H
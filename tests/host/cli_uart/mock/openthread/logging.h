@@ -0,0 +1,16 @@
+/**
+ * @file logging.h
+ * @brief Host stand-in for the platform log, warnings are counted
+ */
+
+#ifndef __CLI_MOCK_OT_LOGGING_H
+#define __CLI_MOCK_OT_LOGGING_H
+
+#include <stdio.h>
+
+extern int g_cli_mock_warnings;
+
+#define otLogWarnPlat(...)                                                     \
+    (g_cli_mock_warnings++, printf(__VA_ARGS__), printf("\n"))
+
+#endif // __CLI_MOCK_OT_LOGGING_H
@@ -0,0 +1,285 @@
+/**
+ * @file test_cli_uart.cpp
+ * @brief CLI UART of the mesh-it-up apps over a slow mock UART: commands
+ *        typed in bursts print more than the TX buffer holds, in lines
+ *        longer than any line buffer, while the UART completes a send only
+ *        every few steps of the OpenThread task or refuses it.
+ *
+ * The wire has to carry every echo and every output whole and in order:
+ * for each line typed, its echo, CRLF, then what the command printed.
+ * The source is included so the TX buffer and the queue behind it can be
+ * checked directly. The TX buffer is shrunk so it wraps often, the queue
+ * behind it is capped at 4 KiB.
+ */
+
+#include <stdlib.h>
+#include "cli_uart.cpp"
+#include "host_test.h"
+
+#define WIRE_MAX   (64 * 1024)
+#define FILLER_MAX 1500
+
+int g_cli_mock_warnings;
+
+static otCliOutputCallback s_output;
+static void* s_context;
+static ot::Instance s_instance;
+
+/* one send in flight, completed when the test says so */
+static const uint8_t* s_dma_buf;
+static uint16_t s_dma_len;
+static uint32_t s_refuse;
+static uint32_t s_refused;
+
+static char s_wire[WIRE_MAX];
+static uint32_t s_wire_len;
+static char s_expect[WIRE_MAX];
+static uint32_t s_expect_len;
+
+static uint32_t s_heap_live;
+static uint32_t s_heap_fail;
+static char s_filler[FILLER_MAX + 1];
+
+extern "C" void* pvPortMalloc(size_t size) {
+    if (s_heap_fail) {
+        return NULL;
+    }
+    s_heap_live++;
+    return malloc(size);
+}
+
+extern "C" void vPortFree(void* ptr) {
+    s_heap_live--;
+    free(ptr);
+}
+
+otError otPlatUartEnable(void) { return OT_ERROR_NONE; }
+
+otError otPlatUartSend(const uint8_t* aBuf, uint16_t aBufLength) {
+    CHECK(s_dma_len == 0);
+    if (s_refuse) {
+        s_refuse--;
+        s_refused++;
+        return OT_ERROR_FAILED;
+    }
+    s_dma_buf = aBuf;
+    s_dma_len = aBufLength;
+    return OT_ERROR_NONE;
+}
+
+void otCliInit(otInstance* aInstance, otCliOutputCallback aCallback,
+               void* aContext) {
+    s_output = aCallback;
+    s_context = aContext;
+}
+
+static void expect(const char* buf, uint32_t len) {
+    if (s_expect_len + len <= WIRE_MAX) {
+        memcpy(&s_expect[s_expect_len], buf, len);
+    }
+    s_expect_len += len;
+}
+
+static int cli_printf(const char* fmt, ...) {
+    va_list ap;
+    int rval;
+
+    va_start(ap, fmt);
+    rval = s_output(s_context, fmt, ap);
+    va_end(ap);
+    return rval;
+}
+
+/**
+ * "out <id> <lines> <length>": numbered lines of the given length. Nothing
+ * is echoed between a line and its command, so the expected stream is the
+ * line, CRLF and the output, built as the commands run.
+ */
+void otCliInputLine(char* aBuf) {
+    char line[FILLER_MAX + 32];
+    unsigned id, lines, len, i;
+    int n;
+
+    expect(aBuf, strlen(aBuf));
+    expect("\r\n", 2);
+    CHECK_EQ(sscanf(aBuf, "out %u %u %u", &id, &lines, &len), 3);
+    for (i = 0; i < lines; i++) {
+        n = snprintf(line, sizeof(line), "%03u:%04u %.*s\r\n", id, i, len,
+                     s_filler);
+        expect(line, n);
+        CHECK_EQ(cli_printf("%03u:%04u %.*s\r\n", id, i, len, s_filler), n);
+    }
+}
+
+static void setup(void) {
+    memset(s_filler, 'x', FILLER_MAX);
+    s_dma_len = 0;
+    s_refuse = 0;
+    s_refused = 0;
+    s_wire_len = 0;
+    s_expect_len = 0;
+    s_heap_fail = 0;
+    g_cli_mock_warnings = 0;
+    otAppCliInit(&s_instance);
+}
+
+/* type a burst of command lines at once */
+static void type(const char* const* cmds, uint32_t num) {
+    char burst[1024];
+    uint32_t len = 0, i;
+
+    for (i = 0; i < num; i++) {
+        len += snprintf(&burst[len], sizeof(burst) - len, "%s\r", cmds[i]);
+    }
+    otPlatUartReceived(reinterpret_cast<const uint8_t*>(burst), len);
+}
+
+static void uart_complete(void) {
+    if (s_wire_len + s_dma_len <= WIRE_MAX) {
+        memcpy(&s_wire[s_wire_len], s_dma_buf, s_dma_len);
+    }
+    s_wire_len += s_dma_len;
+    s_dma_len = 0;
+    otPlatUartSendDone();
+}
+
+/**
+ * Run the OpenThread task until the CLI is idle, the UART completing a send
+ * every @p slow steps. A held command or a refused send that nothing wakes
+ * ends the run with output left over.
+ */
+static void run(uint32_t slow) {
+    uint32_t step;
+
+    for (step = 1; step < 1000000; step++) {
+        if (s_dma_len && step % slow == 0) {
+            uart_complete();
+        }
+        if (sTasklet->IsPosted()) {
+            sTasklet->Run();
+        }
+        if (!s_dma_len && !sTasklet->IsPosted()) {
+            break;
+        }
+    }
+}
+
+/* the echo and output of every line, in order, nothing left behind */
+static void check_wire(void) {
+    CHECK_EQ(s_wire_len, s_expect_len);
+    CHECK(s_wire_len <= WIRE_MAX
+          && memcmp(s_wire, s_expect, s_wire_len) == 0);
+    CHECK_EQ(sTxLength, 0);
+    CHECK(sTxSpillHead == nullptr);
+    CHECK_EQ(s_heap_live, 0);
+    CHECK(!sRxHeld);
+    CHECK_EQ(sTxDropped, 0);
+}
+
+static void test_output_larger_than_buffer(void) {
+    static const char* const cmds[] = {"out 1 40 60"};
+
+    setup();
+    type(cmds, 1);
+    CHECK(sTxSpillHead != nullptr);
+    run(3);
+    check_wire();
+}
+
+static void test_long_lines(void) {
+    static const char* const cmds[] = {"out 2 3 1000", "out 3 2 700"};
+
+    setup();
+    type(cmds, 1);
+    run(5);
+    type(&cmds[1], 1);
+    run(1);
+    check_wire();
+}
+
+static void test_burst_slow_uart(void) {
+    static const char* const cmds[] = {
+        "out 4 1 10",  "out 5 12 50", "out 6 1 300", "out 7 0 0",
+        "out 8 30 20", "out 9 2 5",   "out 10 5 90",
+    };
+    static const uint32_t slow[] = {1, 2, 7};
+    uint32_t k;
+
+    /* the lines after the first are held and replayed from the backlog */
+    for (k = 0; k < sizeof(slow) / sizeof(slow[0]); k++) {
+        setup();
+        type(cmds, sizeof(cmds) / sizeof(cmds[0]));
+        CHECK(sRxHeld);
+        run(slow[k]);
+        check_wire();
+    }
+}
+
+static void test_send_refused_while_held(void) {
+    static const char* const cmds[] = {"out 11 20 40", "out 12 3 10"};
+
+    setup();
+    type(cmds, 1);
+
+    /* the next line is held behind the output, then the UART refuses */
+    type(&cmds[1], 1);
+    CHECK(sRxHeld);
+    s_refuse = 5;
+    uart_complete();
+    run(2);
+    CHECK_EQ(s_refused, 5);
+    check_wire();
+}
+
+static void test_heap_exhausted(void) {
+    static const char* const cmds[] = {"out 13 10 60"};
+
+    setup();
+    s_heap_fail = 1;
+    type(cmds, 1);
+    CHECK(sTxDropped > 0);
+    s_heap_fail = 0;
+    run(1);
+    CHECK_EQ(sTxDropped, 0);
+    CHECK_EQ(g_cli_mock_warnings, 1);
+    CHECK_EQ(s_heap_live, 0);
+}
+
+/* a command printing more than the cap loses the lines past it, the line
+ * typed meanwhile waits and comes out whole */
+static void test_spill_cap(void) {
+    static const char* const cmds[] = {"out 14 80 60", "out 15 4 30"};
+    uint32_t mark, dropped;
+
+    setup();
+    type(cmds, 1);
+    CHECK(sTxSpilled <= kTxSpillMax);
+    CHECK(s_heap_live * 60 <= kTxSpillMax);
+    dropped = sTxDropped;
+    CHECK(dropped > 0);
+    mark = s_expect_len;
+
+    type(&cmds[1], 1);
+    CHECK(sRxHeld);
+    run(2);
+    CHECK_EQ(s_wire_len + dropped, s_expect_len);
+    CHECK(memcmp(&s_wire[s_wire_len - (s_expect_len - mark)], &s_expect[mark],
+                 s_expect_len - mark)
+          == 0);
+    CHECK_EQ(g_cli_mock_warnings, 1);
+    CHECK_EQ(sTxDropped, 0);
+    CHECK_EQ(sTxSpilled, 0);
+    CHECK_EQ(s_heap_live, 0);
+    CHECK(!sRxHeld);
+}
+
+int main(void) {
+    printf("TX buffer %u bytes\n", (unsigned)kTxBufferSize);
+    HOST_TEST_RUN(test_output_larger_than_buffer);
+    HOST_TEST_RUN(test_long_lines);
+    HOST_TEST_RUN(test_burst_slow_uart);
+    HOST_TEST_RUN(test_send_refused_while_held);
+    HOST_TEST_RUN(test_heap_exhausted);
+    HOST_TEST_RUN(test_spill_cap);
+    return HOST_TEST_END();
+}
@@ -0,0 +1,108 @@
+/**
+ * @file FreeRTOSConfig.h
+ * @brief Kernel configuration of the host builds of the real FreeRTOS
+ *        sources over the POSIX port, for the kernel benchmarks.
+ *
+ * Priorities and the kernel options follow the example configurations,
+ * tasks run as pthreads and the heap is the C library's (heap_3).
+ *
+ * HOST_RTOS_OPTIMISED_SELECTION picks the task selection under test: 0 is
+ * the generic walk of the ready lists, 1 the ready-priority bitmap of the
+ * ARM_CM3 and ARM_CM33_NTZ ports with the CLZ done by the compiler.
+ *
+ * HOST_RTOS_TICKLESS turns on tickless idle, host_rtos_sleep.h of the test
+ * brings the sleep routine in place of the one of the Cortex-M ports.
+ */
+
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+
+#define configCPU_CLOCK_HZ (1000000)
+#define configTICK_RATE_HZ (1000)
+
+#define configUSE_PREEMPTION                1
+#define configUSE_IDLE_HOOK                 0
+#define configUSE_TICK_HOOK                 0
+#ifdef HOST_RTOS_TICKLESS
+#define configUSE_TICKLESS_IDLE             1
+#else
+#define configUSE_TICKLESS_IDLE             0
+#endif
+
+#define configMAX_PRIORITIES (32)
+
+#define configMINIMAL_STACK_SIZE                ((unsigned short)1024)
+#define configTOTAL_HEAP_SIZE                   ((size_t)0x8000)
+#define configMAX_TASK_NAME_LEN                 (24)
+#define configUSE_TRACE_FACILITY                0
+#define configUSE_STATS_FORMATTING_FUNCTIONS    0
+#define configUSE_16_BIT_TICKS                  0
+#define configIDLE_SHOULD_YIELD                 1
+#define configUSE_MUTEXES                       1
+#define configQUEUE_REGISTRY_SIZE               0
+#define configCHECK_FOR_STACK_OVERFLOW          0
+#define configUSE_RECURSIVE_MUTEXES             1
+#define configUSE_MALLOC_FAILED_HOOK            0
+#define configUSE_APPLICATION_TASK_TAG          0
+#define configUSE_COUNTING_SEMAPHORES           1
+#define configGENERATE_RUN_TIME_STATS           0
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configSUPPORT_DYNAMIC_ALLOCATION        1
+#define configKERNEL_PROVIDED_STATIC_MEMORY     1
+
+#ifndef HOST_RTOS_OPTIMISED_SELECTION
+#define HOST_RTOS_OPTIMISED_SELECTION 1
+#endif
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION HOST_RTOS_OPTIMISED_SELECTION
+
+/* Co-routine definitions. */
+#define configUSE_CO_ROUTINES           0
+#define configMAX_CO_ROUTINE_PRIORITIES (1)
+
+/* Software timer definitions. */
+#define configUSE_TIMERS             0
+
+#define INCLUDE_vTaskPrioritySet               (1)
+#define INCLUDE_uxTaskPriorityGet              (1)
+#define INCLUDE_vTaskDelete                    (1)
+#define INCLUDE_vTaskSuspend                   (1)
+#define INCLUDE_vTaskDelay                     (1)
+#define INCLUDE_xTaskGetSchedulerState         (1)
+#define INCLUDE_xTaskGetCurrentTaskHandle      (1)
+#define INCLUDE_xTaskGetIdleTaskHandle         (1)
+
+/* A test may count failed assertions instead of aborting */
+#ifndef configASSERT
+#define configASSERT(x) assert(x)
+#endif
+
+/* The interrupt mask from ISR of the POSIX port is a no-op in tasks, the
+ * tick would preempt rtos_pool inside its lock; no interrupt handler uses
+ * a pool on the host, a critical section will do */
+#define RTOS_POOL_LOCK()       (vPortEnterCritical(), (UBaseType_t)0)
+#define RTOS_POOL_UNLOCK(mask) ((void)(mask), vPortExitCritical())
+
+#if (configUSE_PORT_OPTIMISED_TASK_SELECTION == 1)
+/* Same bitmap as portmacro.h of ARM_CM3 and ARM_CM33_NTZ, the POSIX port
+ * has none; __builtin_clz is the CLZ instruction on the target */
+#define portRECORD_READY_PRIORITY(uxPriority, uxReadyPriorities) \
+    (uxReadyPriorities) |= (1UL << (uxPriority))
+#define portRESET_READY_PRIORITY(uxPriority, uxReadyPriorities) \
+    (uxReadyPriorities) &= ~(1UL << (uxPriority))
+#define portGET_HIGHEST_PRIORITY(uxTopPriority, uxReadyPriorities) \
+    uxTopPriority = (31UL - (uint32_t)__builtin_clz((uint32_t)(uxReadyPriorities)))
+#endif
+
+/* Kernel benchmarks may time the selection between these two points */
+#ifdef HOST_RTOS_TRACE_SWITCH
+void host_rtos_switch_out(void);
+void host_rtos_switch_in(void);
+#define traceTASK_SWITCHED_OUT() host_rtos_switch_out()
+#define traceTASK_SWITCHED_IN()  host_rtos_switch_in()
+#endif
+
+#ifdef HOST_RTOS_TICKLESS
+#include "host_rtos_sleep.h"
+#endif
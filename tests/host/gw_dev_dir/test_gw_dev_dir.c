@@ -0,0 +1,232 @@
+/**
+ * @file test_gw_dev_dir.c
+ * @brief Device directory of the Zigbee gateway: rejoins, short address
+ *        conflicts, leave, the sync from the stack address table, and
+ *        random join/rejoin/leave churn against a plain reference model.
+ */
+
+#include <string.h>
+#include "gw_dev_dir.h"
+#include "host_test.h"
+#include "hosal_trng.h"
+
+static void ieee_make(uint8_t ieee[8], uint32_t n) {
+    uint8_t i;
+
+    for (i = 0; i < 8; i++) {
+        ieee[i] = (uint8_t)(n >> (8 * (i % 4))) ^ (uint8_t)(0xA5 + i);
+    }
+}
+
+static void test_join_rejoin(void) {
+    uint8_t ieee[8], eps[2] = {1, 2};
+    gw_dev_dir_stats_t st;
+    gw_dev_desc_t desc = {.endpoint = 1, .profile_id = 0x0104, .in_count = 1};
+    gw_dev_t* dev;
+
+    gw_dev_dir_init();
+    ieee_make(ieee, 1);
+    dev = gw_dev_dir_announce(ieee, 0x1001, 0x8E, 10);
+    CHECK(dev != NULL);
+    gw_dev_dir_set_endpoints(0x1001, 2, eps);
+    CHECK(gw_dev_dir_set_desc(0x1001, &desc));
+
+    /* rejoin with a new short address keeps the cached endpoints */
+    dev = gw_dev_dir_announce(ieee, 0x2002, 0x80, 20);
+    CHECK(dev != NULL && dev->short_addr == 0x2002 && dev->capability == 0x80);
+    CHECK(gw_dev_dir_find_short(0x1001) == NULL);
+    CHECK(gw_dev_dir_find_short(0x2002) == dev);
+    CHECK(dev->ep_valid && dev->ep_count == 2);
+    CHECK(gw_dev_dir_get_desc(0x2002, 1) != NULL);
+    CHECK_EQ(gw_dev_dir_count(), 1);
+
+    gw_dev_dir_stats_get(&st);
+    CHECK_EQ(st.announces, 2);
+    CHECK_EQ(st.rejoins, 1);
+    CHECK_EQ(st.addr_changes, 1);
+    CHECK_EQ(st.conflicts, 0);
+}
+
+static void test_short_conflict(void) {
+    uint8_t a[8], b[8];
+    gw_dev_dir_stats_t st;
+    gw_dev_t* dev;
+
+    gw_dev_dir_init();
+    ieee_make(a, 1);
+    ieee_make(b, 2);
+    gw_dev_dir_announce(a, 0x3003, 0, 0);
+
+    /* b announces the short address of a: b owns it, a is kept by IEEE */
+    gw_dev_dir_announce(b, 0x3003, 0, 0);
+    CHECK(gw_dev_dir_find_short(0x3003) == gw_dev_dir_find_ieee(b));
+    dev = gw_dev_dir_find_ieee(a);
+    CHECK(dev != NULL && dev->short_addr == GW_DEV_DIR_SHORT_UNKNOWN);
+    CHECK_EQ(gw_dev_dir_count(), 2);
+
+    /* a resolves the conflict with a new address */
+    gw_dev_dir_announce(a, 0x3004, 0, 0);
+    CHECK(gw_dev_dir_find_short(0x3004) == gw_dev_dir_find_ieee(a));
+    CHECK(gw_dev_dir_find_short(0x3003) == gw_dev_dir_find_ieee(b));
+
+    /* a conflict reported by the network drops the address only */
+    gw_dev_dir_addr_conflict(0x3003);
+    CHECK(gw_dev_dir_find_short(0x3003) == NULL);
+    CHECK(gw_dev_dir_find_ieee(b) != NULL);
+    gw_dev_dir_addr_conflict(0x7777);
+
+    gw_dev_dir_stats_get(&st);
+    CHECK_EQ(st.conflicts, 2);
+}
+
+/* devices the gateway never saw announce come in from the address table,
+ * stale addresses are fixed, announced data stays */
+static void test_sync(void) {
+    uint8_t a[8], b[8], c[8];
+    gw_dev_dir_stats_t st;
+    gw_dev_t* dev;
+
+    gw_dev_dir_init();
+    ieee_make(a, 1);
+    ieee_make(b, 2);
+    ieee_make(c, 3);
+    gw_dev_dir_announce(a, 0x1111, 0x8E, 5);
+    gw_dev_dir_announce(b, 0x2222, 0x80, 5);
+
+    CHECK(gw_dev_dir_sync(a, 0x1111, 100) == gw_dev_dir_find_ieee(a));
+    dev = gw_dev_dir_sync(c, 0x3333, 100);
+    CHECK(dev != NULL && dev->capability == 0 && dev->last_seen_ms == 100);
+    /* the table moved b, and gave its old address to nobody */
+    dev = gw_dev_dir_sync(b, 0x2223, 100);
+    CHECK(dev != NULL && dev->capability == 0x80 && dev->last_seen_ms == 5);
+    CHECK(gw_dev_dir_find_short(0x2222) == NULL);
+    CHECK(gw_dev_dir_find_short(0x2223) == dev);
+    /* the table gives the address of a to c */
+    gw_dev_dir_sync(c, 0x1111, 100);
+    CHECK(gw_dev_dir_find_short(0x1111) == gw_dev_dir_find_ieee(c));
+    CHECK_EQ(gw_dev_dir_find_ieee(a)->short_addr, GW_DEV_DIR_SHORT_UNKNOWN);
+    CHECK_EQ(gw_dev_dir_count(), 3);
+
+    gw_dev_dir_stats_get(&st);
+    CHECK_EQ(st.synced, 3);
+    CHECK_EQ(st.announces, 2);
+    CHECK_EQ(st.rejoins, 0);
+}
+
+static void test_leave_and_full(void) {
+    uint8_t ieee[8];
+    gw_dev_dir_stats_t st;
+    uint32_t i;
+
+    gw_dev_dir_init();
+    for (i = 0; i < GW_DEV_DIR_DEV_MAX; i++) {
+        ieee_make(ieee, i);
+        CHECK(gw_dev_dir_announce(ieee, 0x100 + i, 0, 0) != NULL);
+    }
+    ieee_make(ieee, GW_DEV_DIR_DEV_MAX);
+    CHECK(gw_dev_dir_announce(ieee, 0x0FFF, 0, 0) == NULL);
+    CHECK(gw_dev_dir_sync(ieee, 0x0FFF, 0) == NULL);
+
+    ieee_make(ieee, 7);
+    CHECK(gw_dev_dir_remove(ieee));
+    CHECK(!gw_dev_dir_remove(ieee));
+    CHECK(gw_dev_dir_find_short(0x107) == NULL);
+    /* the record moved into the hole is still found both ways */
+    ieee_make(ieee, GW_DEV_DIR_DEV_MAX - 1);
+    CHECK(gw_dev_dir_find_ieee(ieee) != NULL);
+    CHECK(gw_dev_dir_find_short(0x100 + GW_DEV_DIR_DEV_MAX - 1)
+          == gw_dev_dir_find_ieee(ieee));
+
+    gw_dev_dir_stats_get(&st);
+    CHECK_EQ(st.full, 2);
+    CHECK_EQ(st.leaves, 1);
+}
+
+/* reference: one short address per IEEE, the newest claim wins */
+#define MODEL_IEEE 160
+
+static uint16_t s_model[MODEL_IEEE];
+static bool s_model_in[MODEL_IEEE];
+
+static void model_claim(uint32_t n, uint16_t short_addr) {
+    uint32_t i;
+
+    for (i = 0; i < MODEL_IEEE; i++) {
+        if (s_model_in[i] && s_model[i] == short_addr) {
+            s_model[i] = GW_DEV_DIR_SHORT_UNKNOWN;
+        }
+    }
+    s_model[n] = short_addr;
+}
+
+static void test_churn(void) {
+    uint8_t ieee[8];
+    uint32_t step, n, i, count, rnd[2];
+    uint16_t short_addr;
+    gw_dev_t* dev;
+
+    gw_dev_dir_init();
+    memset(s_model_in, 0, sizeof(s_model_in));
+    g_stub_trng_seed = 33;
+
+    for (step = 0; step < 20000; step++) {
+        hosal_trng_get_random_number(rnd, 2);
+        n = rnd[0] % MODEL_IEEE;
+        short_addr = 0x100 + rnd[1] % 64; /* few addresses, many conflicts */
+        ieee_make(ieee, n);
+
+        count = 0;
+        for (i = 0; i < MODEL_IEEE; i++) {
+            count += s_model_in[i];
+        }
+        switch ((n + step) % 5) {
+            case 0:
+                CHECK_EQ(gw_dev_dir_remove(ieee), s_model_in[n]);
+                s_model_in[n] = false;
+                break;
+            case 1:
+                if (s_model_in[n] && s_model[n] != GW_DEV_DIR_SHORT_UNKNOWN) {
+                    gw_dev_dir_addr_conflict(s_model[n]);
+                    s_model[n] = GW_DEV_DIR_SHORT_UNKNOWN;
+                }
+                break;
+            default:
+                dev = ((n + step) % 5 == 2)
+                          ? gw_dev_dir_sync(ieee, short_addr, step)
+                          : gw_dev_dir_announce(ieee, short_addr, 0, step);
+                if (!s_model_in[n] && count >= GW_DEV_DIR_DEV_MAX) {
+                    CHECK(dev == NULL);
+                    break;
+                }
+                CHECK(dev != NULL);
+                model_claim(n, short_addr);
+                s_model_in[n] = true;
+                break;
+        }
+    }
+
+    count = 0;
+    for (n = 0; n < MODEL_IEEE; n++) {
+        ieee_make(ieee, n);
+        dev = gw_dev_dir_find_ieee(ieee);
+        CHECK_EQ(dev != NULL, s_model_in[n]);
+        if (!s_model_in[n] || dev == NULL) {
+            continue;
+        }
+        count++;
+        CHECK_EQ(dev->short_addr, s_model[n]);
+        if (s_model[n] != GW_DEV_DIR_SHORT_UNKNOWN) {
+            CHECK(gw_dev_dir_find_short(s_model[n]) == dev);
+        }
+    }
+    CHECK_EQ(gw_dev_dir_count(), count);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_join_rejoin);
+    HOST_TEST_RUN(test_short_conflict);
+    HOST_TEST_RUN(test_sync);
+    HOST_TEST_RUN(test_leave_and_full);
+    HOST_TEST_RUN(test_churn);
+    return HOST_TEST_END();
+}
@@ -0,0 +1,11 @@
+/**
+ * @file zigbee_api.h
+ * @brief Host stand-in, the gateway one pulls in the whole platform
+ */
+
+#ifndef __HOST_MOCK_ZIGBEE_API_H
+#define __HOST_MOCK_ZIGBEE_API_H
+
+#include "zigbee_platform.h"
+
+#endif // __HOST_MOCK_ZIGBEE_API_H
@@ -0,0 +1,74 @@
+/**
+ * @file zigbee_platform.h
+ * @brief Host stand-in for the ZCL send path and the parsed frame header of
+ *        the Zigbee platform, what the OTA scheduler uses of them
+ */
+
+#ifndef __HOST_MOCK_ZIGBEE_PLATFORM_H
+#define __HOST_MOCK_ZIGBEE_PLATFORM_H
+
+#include <stdint.h>
+#include "zb_common.h"
+
+#define ZB_IEEE_ADDR_TABLE_SIZE 256
+
+#define ZB_APS_ADDR_MODE_16_ENDP_PRESENT 2
+#define ZIGBEE_DEFAULT_ENDPOINT          1
+#define ZCL_FRAME_SERVER_CLIENT_DIR      1
+#define ZB_ZCL_FRAME_DIRECTION_TO_SRV    0
+
+#define ZB_ZCL_CMD_OTA_UPGRADE_IMAGE_NOTIFY_ID     0x00
+#define ZB_ZCL_CMD_OTA_UPGRADE_QUERY_NEXT_IMAGE_ID 0x01
+#define ZB_ZCL_CMD_OTA_UPGRADE_IMAGE_BLOCK_ID      0x03
+#define ZB_ZCL_CMD_OTA_UPGRADE_IMAGE_BLOCK_RESP_ID 0x05
+
+#define ZB_ZCL_STATUS_ABORT         0x95
+#define ZB_ZCL_STATUS_WAIT_FOR_DATA 0x97
+
+#define TRUE  1
+#define FALSE 0
+
+typedef struct {
+    uint16_t dst_addr;
+    uint8_t dst_ep;
+    uint16_t cluster_id;
+    uint8_t cmd;
+    uint8_t specific_seq_num;
+    uint8_t seq_num;
+    uint8_t len;
+    uint8_t cmdFormat[16];
+} zcl_data_req_t;
+
+#define ZIGBEE_ZCL_DATA_REQ(p, addr, mode, ep, src_ep, cluster, cmd, a, b,     \
+                            dir, manuf, size)                                  \
+    (p) = zb_mock_data_req((addr), (ep), (cluster), (cmd), (size));
+
+zcl_data_req_t* zb_mock_data_req(uint16_t addr, uint8_t ep, uint16_t cluster,
+                                 uint8_t cmd, uint8_t len);
+void zigbee_app_zcl_send_command(zcl_data_req_t* req);
+void vPortFree(void* p);
+
+typedef struct {
+    struct {
+        struct {
+            struct {
+                uint8_t addr_type;
+                union {
+                    uint16_t short_addr;
+                } u;
+            } source;
+            uint8_t src_endpoint;
+        } common_data;
+    } addr_data;
+    uint8_t cmd_direction;
+    uint8_t cmd_id;
+    uint8_t seq_number;
+} zb_zcl_parsed_hdr_t;
+
+#define ZB_ZCL_PARSED_HDR_SHORT_DATA(hdr) ((hdr)->addr_data.common_data)
+#define ZB_BUF_GET_PARAM(param, type)     ((type*)zb_mock_buf_param(param))
+
+void* zb_mock_buf_param(zb_uint8_t param);
+void zb_buf_free(zb_uint8_t param);
+
+#endif // __HOST_MOCK_ZIGBEE_PLATFORM_H
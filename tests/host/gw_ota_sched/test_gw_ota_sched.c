@@ -0,0 +1,250 @@
+/**
+ * @file test_gw_ota_sched.c
+ * @brief OTA campaign scheduler of the Zigbee gateway: block pacing of the
+ *        active devices, WAIT_FOR_DATA to the ones over max_active, the
+ *        slot handed on by Image Notify, and a campaign of 200 bulbs.
+ *
+ * Block requests are fed as the ZCL handler would, the ZCL frames and the
+ * gateway frames the scheduler sends are captured.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "gw_ota_sched.h"
+#include "host_test.h"
+#include "task.h"
+#include "zigbee_cmd_app.h"
+#include "zigbee_cmd_ota.h"
+#include "zigbee_platform.h"
+
+#define SENT_MAX 64
+
+typedef struct {
+    uint16_t addr;
+    uint8_t cmd;
+    uint8_t status;
+    uint32_t wait_s;
+    uint16_t period_ms;
+} sent_t;
+
+static sent_t s_sent[SENT_MAX];
+static uint32_t s_sent_num;
+static uint32_t s_reports;
+static uint8_t s_report[4];
+static zb_zcl_parsed_hdr_t s_hdr;
+static uint32_t s_freed;
+static uint8_t s_image[4096];
+
+zcl_data_req_t* zb_mock_data_req(uint16_t addr, uint8_t ep, uint16_t cluster,
+                                 uint8_t cmd, uint8_t len) {
+    zcl_data_req_t* req = calloc(1, sizeof(zcl_data_req_t));
+
+    CHECK_EQ(cluster, ZB_ZCL_CLUSTER_ID_OTA_UPGRADE);
+    CHECK(len <= sizeof(req->cmdFormat));
+    req->dst_addr = addr;
+    req->dst_ep = ep;
+    req->cmd = cmd;
+    req->len = len;
+    return req;
+}
+
+void zigbee_app_zcl_send_command(zcl_data_req_t* req) {
+    sent_t* s = &s_sent[s_sent_num++ % SENT_MAX];
+
+    memset(s, 0, sizeof(*s));
+    s->addr = req->dst_addr;
+    s->cmd = req->cmd;
+    if (req->cmd == ZB_ZCL_CMD_OTA_UPGRADE_IMAGE_BLOCK_RESP_ID) {
+        s->status = req->cmdFormat[0];
+        if (req->len > 1) {
+            memcpy(&s->wait_s, &req->cmdFormat[5], 4);
+            memcpy(&s->period_ms, &req->cmdFormat[9], 2);
+        }
+    }
+}
+
+void vPortFree(void* p) { free(p); }
+
+void* zb_mock_buf_param(zb_uint8_t param) { return &s_hdr; }
+
+void zb_buf_free(zb_uint8_t param) { s_freed++; }
+
+int zigbee_gw_cmd_send(uint32_t cmd_id, uint16_t addr, uint8_t addr_mode,
+                       uint8_t src_endp, uint8_t* pParam, uint32_t len) {
+    CHECK_EQ(cmd_id, GW_CMD_OTA_UPGRADE_STATUS_RESPONSE);
+    memcpy(s_report, pParam, sizeof(s_report));
+    s_reports++;
+    return 0;
+}
+
+static const sent_t* last_sent(void) {
+    return s_sent_num ? &s_sent[(s_sent_num - 1) % SENT_MAX] : NULL;
+}
+
+/* an Image Block Request, true when the OTA server is to serve it */
+static bool block_req(uint16_t addr) {
+    memset(&s_hdr, 0, sizeof(s_hdr));
+    s_hdr.addr_data.common_data.source.u.short_addr = addr;
+    s_hdr.addr_data.common_data.src_endpoint = 8;
+    s_hdr.cmd_direction = ZB_ZCL_FRAME_DIRECTION_TO_SRV;
+    s_hdr.cmd_id = ZB_ZCL_CMD_OTA_UPGRADE_IMAGE_BLOCK_ID;
+    s_hdr.seq_number++;
+    return !gw_ota_sched_frame(1);
+}
+
+static void setup(uint8_t max_active, uint16_t block_rate) {
+    gw_ota_sched_cfg_t cfg = {
+        .max_active = max_active,
+        .max_failures = 2,
+        .block_rate = block_rate,
+        .min_period_ms = 0,
+        .stall_ms = 20000,
+    };
+
+    zb_stub_reset();
+    g_stub_tick = 1000000;
+    s_sent_num = 0;
+    s_reports = 0;
+    s_freed = 0;
+    gw_ota_sched_init();
+    gw_ota_sched_image_set(s_image, sizeof(s_image));
+    gw_ota_sched_cfg_set(&cfg);
+}
+
+static void test_pacing(void) {
+    const uint16_t addrs[] = {0x1001, 0x1002};
+    const sent_t* s;
+
+    setup(2, 10);
+    CHECK(gw_ota_sched_start(addrs, 2));
+
+    /* the first request hands over the block period of one device */
+    CHECK(!block_req(0x1001));
+    s = last_sent();
+    CHECK_EQ(s->status, ZB_ZCL_STATUS_WAIT_FOR_DATA);
+    CHECK_EQ(s->wait_s, 0);
+    CHECK_EQ(s->period_ms, 100);
+    CHECK_EQ(s_freed, 1);
+    CHECK(block_req(0x1001));
+
+    /* too early: told to wait, served once the period is up */
+    g_stub_tick += 10;
+    CHECK(!block_req(0x1001));
+    CHECK_EQ(last_sent()->status, ZB_ZCL_STATUS_WAIT_FOR_DATA);
+    CHECK_EQ(last_sent()->wait_s, 1);
+    g_stub_tick += 90;
+    CHECK(block_req(0x1001));
+    gw_ota_sched_block_sent(0x1001, 64);
+
+    /* a second device halves the share: both get the new period */
+    g_stub_tick += 100;
+    CHECK(!block_req(0x1002));
+    CHECK_EQ(last_sent()->period_ms, 200);
+    CHECK(!block_req(0x1001));
+    CHECK_EQ(last_sent()->period_ms, 200);
+    CHECK(block_req(0x1001));
+    CHECK(block_req(0x1002));
+    g_stub_tick += 100;
+    CHECK(!block_req(0x1001));
+    g_stub_tick += 100;
+    CHECK(block_req(0x1001));
+}
+
+static void test_wait_for_slot(void) {
+    const uint16_t addrs[] = {0x2001, 0x2002, 0x2003};
+    gw_ota_sched_stats_t st;
+    uint32_t i;
+
+    setup(2, 20);
+    CHECK(gw_ota_sched_start(addrs, 3));
+
+    /* the first tick wakes as many devices as there are slots */
+    CHECK(zb_stub_alarm_run());
+    CHECK_EQ(s_sent_num, 2);
+    CHECK_EQ(s_sent[0].cmd, ZB_ZCL_CMD_OTA_UPGRADE_IMAGE_NOTIFY_ID);
+    CHECK_EQ(s_sent[0].addr, 0x2001);
+    CHECK_EQ(s_sent[1].addr, 0x2002);
+    CHECK(gw_ota_sched_query(0x2001));
+
+    block_req(0x2001);
+    block_req(0x2002);
+    CHECK(!gw_ota_sched_query(0x2003));
+
+    /* the third one is told to come back, its slot is not taken */
+    CHECK(!block_req(0x2003));
+    CHECK_EQ(last_sent()->status, ZB_ZCL_STATUS_WAIT_FOR_DATA);
+    CHECK_EQ(last_sent()->wait_s, GW_OTA_SCHED_RETRY_S);
+    gw_ota_sched_stats_get(&st);
+    CHECK_EQ(st.active, 2);
+    CHECK_EQ(st.pending, 1);
+
+    /* one finishes, the next tick notifies the waiting device */
+    gw_ota_sched_end(0x2001, GW_OTA_STATUS_FINISHED);
+    CHECK_EQ(s_report[2], GW_OTA_STATUS_FINISHED);
+    g_stub_tick += GW_OTA_SCHED_NOTIFY_MS;
+    s_sent_num = 0;
+    gw_ota_sched_block_sent(0x2002, 100);
+    CHECK(zb_stub_alarm_run());
+    CHECK_EQ(s_sent_num, 1);
+    CHECK_EQ(s_sent[0].cmd, ZB_ZCL_CMD_OTA_UPGRADE_IMAGE_NOTIFY_ID);
+    CHECK_EQ(s_sent[0].addr, 0x2003);
+    CHECK(!block_req(0x2003));
+    CHECK(block_req(0x2003));
+
+    /* a device without blocks loses its slot, and is given up at the
+     * second failure */
+    for (i = 0; i < 2; i++) {
+        g_stub_tick += 30000;
+        gw_ota_sched_block_sent(0x2003, 100);
+        CHECK(zb_stub_alarm_run());
+        CHECK_EQ(s_report[2], GW_OTA_STATUS_STALLED);
+        if (i == 0) {
+            CHECK(!block_req(0x2002));
+        }
+    }
+    gw_ota_sched_stats_get(&st);
+    CHECK_EQ(st.stalls, 2);
+    CHECK_EQ(st.done, 1);
+    CHECK_EQ(st.failed, 1);
+    CHECK(!block_req(0x2002));
+    CHECK_EQ(last_sent()->status, ZB_ZCL_STATUS_ABORT);
+}
+
+/* 200 bulbs: a list of all of them, and an open campaign they join */
+static void test_capacity(void) {
+    static uint16_t addrs[ZB_IEEE_ADDR_TABLE_SIZE + 1];
+    gw_ota_sched_stats_t st;
+    uint16_t i;
+
+    setup(4, 20);
+    for (i = 0; i <= ZB_IEEE_ADDR_TABLE_SIZE; i++) {
+        addrs[i] = 0x3000 + i;
+    }
+    CHECK(gw_ota_sched_start(addrs, 200));
+    CHECK_EQ(gw_ota_sched_count(), 200);
+    CHECK(gw_ota_sched_start(addrs, ZB_IEEE_ADDR_TABLE_SIZE));
+    CHECK(!gw_ota_sched_start(addrs, ZB_IEEE_ADDR_TABLE_SIZE + 1));
+
+    CHECK(gw_ota_sched_start(NULL, 0));
+    for (i = 0; i < 200; i++) {
+        gw_ota_sched_query(addrs[i]);
+    }
+    CHECK_EQ(gw_ota_sched_count(), 200);
+    CHECK(gw_ota_sched_get(199)->short_addr == addrs[199]);
+    for (i = 0; i < 4; i++) {
+        block_req(addrs[i]);
+    }
+    CHECK(!block_req(addrs[199]));
+    CHECK_EQ(last_sent()->status, ZB_ZCL_STATUS_WAIT_FOR_DATA);
+    CHECK_EQ(last_sent()->wait_s, GW_OTA_SCHED_RETRY_S);
+    gw_ota_sched_stats_get(&st);
+    CHECK_EQ(st.active, 4);
+    CHECK_EQ(st.pending, 196);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_pacing);
+    HOST_TEST_RUN(test_wait_for_slot);
+    HOST_TEST_RUN(test_capacity);
+    return HOST_TEST_END();
+}
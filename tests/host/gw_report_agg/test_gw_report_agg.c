@@ -0,0 +1,211 @@
+/**
+ * @file test_gw_report_agg.c
+ * @brief Report aggregation of the Zigbee gateway: holding and flushing
+ *        changed values, suppressing equal ones, clusters without a policy,
+ *        eviction of the least recently reported entries, flush frames the
+ *        host link refuses, and reports the cache does not take, with the
+ *        gateway frames captured.
+ *
+ * The source is included so the cache table can be checked directly.
+ */
+
+#include "gw_report_agg.c"
+#include "host_test.h"
+
+#define TEMP   ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT
+#define DIAG   0x0B05
+#define SENSOR 0x1234
+
+static uint32_t s_frames;
+static int s_send_ret;
+static uint8_t s_frame[ZIGBEE_GW_CMD_PARAM_MAX];
+static uint32_t s_frame_len;
+
+int zigbee_gw_cmd_send_prefixed(uint32_t cmd_id, uint16_t addr,
+                                uint8_t addr_mode, uint8_t src_endp,
+                                uint8_t* pPrefix, uint32_t prefix_len,
+                                uint8_t* pParam, uint32_t len) {
+    memcpy(s_frame, pParam, len);
+    s_frame_len = len;
+    s_frames++;
+    return s_send_ret;
+}
+
+static void setup(void) {
+    zb_stub_reset();
+    gw_report_agg_init();
+    agg_flush_scheduled = false;
+    s_frames = 0;
+    s_send_ret = 0;
+    g_stub_tick = 100000;
+}
+
+static uint16_t rec_s16(uint8_t* p, uint16_t attr, int16_t v) {
+    p[0] = attr & 0xFF;
+    p[1] = attr >> 8;
+    p[2] = ZB_ZCL_ATTR_TYPE_S16;
+    p[3] = v & 0xFF;
+    p[4] = (uint16_t)v >> 8;
+    return 5;
+}
+
+static void test_hold_and_flush(void) {
+    uint8_t p[16];
+    uint16_t len;
+
+    setup();
+    len = rec_s16(p, 0x0000, 2000);
+    CHECK(gw_report_agg_input(TEMP, SENSOR, 1, p, len));
+    CHECK_EQ(agg_count, 1);
+    CHECK(zb_stub_alarm_run());
+    CHECK_EQ(s_frames, 1);
+    CHECK_EQ(s_frame_len, len);
+    CHECK(!memcmp(s_frame, p, len));
+
+    /* same value, then a change below the delta of 0.1 C */
+    g_stub_tick += 2000;
+    CHECK(gw_report_agg_input(TEMP, SENSOR, 1, p, len));
+    rec_s16(p, 0x0000, 2005);
+    CHECK(gw_report_agg_input(TEMP, SENSOR, 1, p, len));
+    zb_stub_alarm_run();
+    CHECK_EQ(s_frames, 1);
+    CHECK_EQ(agg_stats.suppressed_equal, 1);
+    CHECK_EQ(agg_stats.suppressed_delta, 1);
+}
+
+/* a bad record after a good one takes no entry for either */
+static void test_malformed(void) {
+    uint8_t p[32];
+    uint16_t len;
+
+    setup();
+    len = rec_s16(p, 0x0000, 2000);
+    len += rec_s16(p + len, 0x0001, 2100);
+    p[len++] = 0x02;
+    p[len++] = 0x00;
+    p[len++] = 0x4c; /* structure, not sized */
+    p[len++] = 0x00;
+    CHECK(!gw_report_agg_input(TEMP, SENSOR, 1, p, len));
+    CHECK_EQ(agg_count, 0);
+    CHECK_EQ(agg_stats.received, 0);
+
+    /* truncated value */
+    len = rec_s16(p, 0x0000, 2000) - 1;
+    CHECK(!gw_report_agg_input(TEMP, SENSOR, 1, p, len));
+    CHECK_EQ(agg_count, 0);
+    CHECK_EQ(g_zb_stub_stats.set, 0);
+}
+
+/* caching a cluster is opt-in */
+static void test_no_policy(void) {
+    const gw_report_agg_policy_t diag = {DIAG, 0, 0, 0};
+    gw_report_agg_policy_t policy;
+    uint8_t p[16];
+    uint16_t len;
+
+    setup();
+    len = rec_s16(p, 0x0000, 7);
+    CHECK(!gw_report_agg_policy_get(DIAG, &policy));
+    CHECK(!gw_report_agg_input(DIAG, SENSOR, 1, p, len));
+    CHECK_EQ(agg_stats.bypassed, 1);
+    CHECK_EQ(agg_count, 0);
+    CHECK(!zb_stub_alarm_run());
+
+    CHECK(gw_report_agg_policy_set(&diag));
+    CHECK(gw_report_agg_policy_get(DIAG, &policy));
+    CHECK(gw_report_agg_input(DIAG, SENSOR, 1, p, len));
+    CHECK_EQ(agg_count, 1);
+}
+
+/* a refused frame keeps its values held, the next flush sends them */
+static void test_send_failed(void) {
+    uint8_t p[16];
+    uint16_t len;
+    agg_entry_t* e;
+
+    setup();
+    len = rec_s16(p, 0x0000, 2000);
+    CHECK(gw_report_agg_input(TEMP, SENSOR, 1, p, len));
+    s_send_ret = -1;
+    CHECK(zb_stub_alarm_run());
+    CHECK_EQ(agg_stats.send_failed, 1);
+    CHECK_EQ(agg_stats.frames, 0);
+    CHECK_EQ(agg_stats.forwarded, 0);
+    e = agg_lookup(SENSOR, 1, TEMP, 0x0000, false);
+    CHECK(e != NULL && e->dirty && !e->sent);
+
+    s_send_ret = 0;
+    s_frames = 0;
+    CHECK(zb_stub_alarm_run());
+    CHECK_EQ(s_frames, 1);
+    CHECK(!memcmp(s_frame, p, len));
+    CHECK(e->sent && !e->dirty);
+    CHECK_EQ(agg_stats.frames, 1);
+    CHECK_EQ(agg_stats.forwarded, 1);
+}
+
+/* with the cache full of held values the report goes out; once they are
+ * sent, the entries reported least recently make room */
+static void test_full(void) {
+    uint8_t p[16];
+    uint16_t len, addr;
+    agg_entry_t* e;
+
+    setup();
+    for (addr = 0; agg_count < AGG_LOAD_MAX; addr++) {
+        len = rec_s16(p, 0x0000, 1000);
+        CHECK(gw_report_agg_input(TEMP, addr, 1, p, len));
+    }
+    g_stub_tick += 10;
+    len = rec_s16(p, 0x0000, 1500);
+    len += rec_s16(p + len, 0x0001, 1600);
+    CHECK(!gw_report_agg_input(TEMP, 0x7FFF, 1, p, len));
+    CHECK_EQ(agg_count, AGG_LOAD_MAX);
+    CHECK_EQ(agg_stats.uncached, 1);
+    CHECK_EQ(agg_stats.evicted, 0);
+
+    /* flushed, then device 0 and 1 report again */
+    CHECK(zb_stub_alarm_run());
+    g_stub_tick += 10;
+    len = rec_s16(p, 0x0000, 1000);
+    CHECK(gw_report_agg_input(TEMP, 0, 1, p, len));
+    CHECK(gw_report_agg_input(TEMP, 1, 1, p, len));
+
+    g_stub_tick += 10;
+    len = rec_s16(p, 0x0000, 1500);
+    len += rec_s16(p + len, 0x0001, 1600);
+    CHECK(gw_report_agg_input(TEMP, 0x7FFF, 1, p, len));
+    CHECK_EQ(agg_count, AGG_LOAD_MAX);
+    CHECK_EQ(agg_stats.evicted, 2);
+    CHECK(agg_lookup(0, 1, TEMP, 0x0000, false) != NULL);
+    CHECK(agg_lookup(1, 1, TEMP, 0x0000, false) != NULL);
+    CHECK(agg_lookup(0x7FFF, 1, TEMP, 0x0000, false) != NULL);
+    CHECK(agg_lookup(0x7FFF, 1, TEMP, 0x0001, false) != NULL);
+
+    /* an existing entry in an uncached report is marked sent */
+    len = rec_s16(p, 0x0000, 1200);
+    p[len++] = 0x02;
+    p[len++] = 0x00;
+    p[len++] = ZB_ZCL_ATTR_TYPE_CHAR_STRING;
+    p[len++] = 9;
+    memcpy(&p[len], "too long!", 9);
+    len += 9;
+    CHECK(!gw_report_agg_input(TEMP, 0, 1, p, len));
+    e = agg_lookup(0, 1, TEMP, 0x0000, false);
+    CHECK(e != NULL && e->sent && !e->dirty);
+    CHECK_EQ(agg_decode(e->type, e->value, e->len), 1200);
+    CHECK_EQ(agg_stats.uncached, 2);
+
+    gw_report_agg_remove_device(0);
+    CHECK_EQ(agg_count, AGG_LOAD_MAX - 1);
+    CHECK(agg_lookup(0, 1, TEMP, 0x0000, false) == NULL);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_hold_and_flush);
+    HOST_TEST_RUN(test_malformed);
+    HOST_TEST_RUN(test_no_policy);
+    HOST_TEST_RUN(test_send_failed);
+    HOST_TEST_RUN(test_full);
+    return HOST_TEST_END();
+}
@@ -0,0 +1,242 @@
+/**
+ * @file bench_gw_zcl_record.c
+ * @brief Replays typical report and read response payloads of a home
+ *        network through the forwarding path of the Zigbee gateway: the
+ *        size table and the record split writing straight into the frame,
+ *        against the earlier path that sized values with a switch, decoded
+ *        every value byte with sprintf for the log and staged the payload
+ *        before framing. Also splits long read responses.
+ *
+ * Host timings only compare the approaches, the target is a Cortex-M3 at
+ * 48 MHz (RT58x) or a Cortex-M33 at 64 MHz (RT584).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "zboss_api.h"
+#include "gw_zcl_record.h"
+
+#define ROUNDS     200000
+#define FRAME_MAX  (255 - 9 - 2)
+
+typedef struct {
+    const char* name;
+    uint8_t zcl_cmd;
+    uint8_t data[96];
+    uint16_t len;
+} payload_t;
+
+/* attribute id, status of reads, type, value; as received over the air */
+static payload_t s_payloads[] = {
+    {"temperature", ZB_ZCL_CMD_REPORT_ATTRIB,
+     {0x00, 0x00, ZB_ZCL_ATTR_TYPE_S16, 0xD0, 0x07}, 5},
+    {"humidity", ZB_ZCL_CMD_REPORT_ATTRIB,
+     {0x00, 0x00, ZB_ZCL_ATTR_TYPE_U16, 0x88, 0x13}, 5},
+    {"on/off", ZB_ZCL_CMD_REPORT_ATTRIB,
+     {0x00, 0x00, ZB_ZCL_ATTR_TYPE_BOOL, 0x01}, 4},
+    {"metering", ZB_ZCL_CMD_REPORT_ATTRIB,
+     {0x00, 0x00, ZB_ZCL_ATTR_TYPE_U48, 1, 2, 3, 4, 5, 6,
+      0x00, 0x04, ZB_ZCL_ATTR_TYPE_S24, 0x10, 0x02, 0x00}, 15},
+    {"power config", ZB_ZCL_CMD_REPORT_ATTRIB,
+     {0x20, 0x00, ZB_ZCL_ATTR_TYPE_U8, 30,
+      0x21, 0x00, ZB_ZCL_ATTR_TYPE_U8, 180,
+      0x3E, 0x00, ZB_ZCL_ATTR_TYPE_32BITMAP, 0, 0, 0, 0}, 15},
+    {"basic read", ZB_ZCL_CMD_READ_ATTRIB_RESP,
+     {0x00, 0x00, 0x00, ZB_ZCL_ATTR_TYPE_U8, 0x08,
+      0x01, 0x00, 0x00, ZB_ZCL_ATTR_TYPE_U8, 0x01,
+      0x04, 0x00, 0x00, ZB_ZCL_ATTR_TYPE_CHAR_STRING, 12,
+      'R', 'a', 'f', 'a', 'e', 'l', 'M', 'i', 'c', 'r', 'o', ' ',
+      0x05, 0x00, 0x00, ZB_ZCL_ATTR_TYPE_CHAR_STRING, 14,
+      'Z', 'B', '-', 'L', 'I', 'G', 'H', 'T', '-', 'R', 'T', '5', '8', '3',
+      0x06, 0x00, 0x00, ZB_ZCL_ATTR_TYPE_CHAR_STRING, 8,
+      '2', '0', '2', '4', '0', '1', '0', '1',
+      0x07, 0x00, 0x00, ZB_ZCL_ATTR_TYPE_8BIT_ENUM, 0x01,
+      0x08, 0x00, 0x86}, 72},
+    {"electrical", ZB_ZCL_CMD_REPORT_ATTRIB,
+     {0x05, 0x05, ZB_ZCL_ATTR_TYPE_U16, 0xE6, 0x00,
+      0x08, 0x05, ZB_ZCL_ATTR_TYPE_U16, 0x20, 0x01,
+      0x0B, 0x05, ZB_ZCL_ATTR_TYPE_S16, 0x3C, 0x00,
+      0x0E, 0x05, ZB_ZCL_ATTR_TYPE_S16, 0x05, 0x00,
+      0x0F, 0x05, ZB_ZCL_ATTR_TYPE_U16, 0x50, 0x00,
+      0x10, 0x05, ZB_ZCL_ATTR_TYPE_S8, 0x5A,
+      0x00, 0x03, ZB_ZCL_ATTR_TYPE_U16, 0x32, 0x00}, 34},
+};
+
+#define PAYLOAD_NUM (sizeof(s_payloads) / sizeof(s_payloads[0]))
+
+static uint8_t s_frame[256];
+static volatile uint32_t s_sink;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* the sizing switch of the earlier handler */
+static uint16_t switch_attr_size(uint8_t attr_type, const uint8_t* data) {
+    switch (attr_type) {
+        case ZB_ZCL_ATTR_TYPE_8BIT:
+        case ZB_ZCL_ATTR_TYPE_U8:
+        case ZB_ZCL_ATTR_TYPE_S8:
+        case ZB_ZCL_ATTR_TYPE_BOOL:
+        case ZB_ZCL_ATTR_TYPE_8BITMAP:
+        case ZB_ZCL_ATTR_TYPE_8BIT_ENUM: return 1;
+        case ZB_ZCL_ATTR_TYPE_16BIT:
+        case ZB_ZCL_ATTR_TYPE_U16:
+        case ZB_ZCL_ATTR_TYPE_S16:
+        case ZB_ZCL_ATTR_TYPE_16BITMAP:
+        case ZB_ZCL_ATTR_TYPE_16BIT_ENUM:
+        case ZB_ZCL_ATTR_TYPE_SEMI:
+        case ZB_ZCL_ATTR_TYPE_CLUSTER_ID:
+        case ZB_ZCL_ATTR_TYPE_ATTRIBUTE_ID: return 2;
+        case ZB_ZCL_ATTR_TYPE_32BIT:
+        case ZB_ZCL_ATTR_TYPE_U32:
+        case ZB_ZCL_ATTR_TYPE_S32:
+        case ZB_ZCL_ATTR_TYPE_32BITMAP:
+        case ZB_ZCL_ATTR_TYPE_UTC_TIME:
+        case ZB_ZCL_ATTR_TYPE_TIME_OF_DAY:
+        case ZB_ZCL_ATTR_TYPE_DATE:
+        case ZB_ZCL_ATTR_TYPE_BACNET_OID:
+        case ZB_ZCL_ATTR_TYPE_SINGLE: return 4;
+        case ZB_ZCL_ATTR_TYPE_S48:
+        case ZB_ZCL_ATTR_TYPE_U48:
+        case ZB_ZCL_ATTR_TYPE_48BIT:
+        case ZB_ZCL_ATTR_TYPE_48BITMAP: return 6;
+        case ZB_ZCL_ATTR_TYPE_S24:
+        case ZB_ZCL_ATTR_TYPE_U24:
+        case ZB_ZCL_ATTR_TYPE_24BIT:
+        case ZB_ZCL_ATTR_TYPE_24BITMAP: return 3;
+        case ZB_ZCL_ATTR_TYPE_U40:
+        case ZB_ZCL_ATTR_TYPE_S40:
+        case ZB_ZCL_ATTR_TYPE_40BIT:
+        case ZB_ZCL_ATTR_TYPE_40BITMAP: return 5;
+        case ZB_ZCL_ATTR_TYPE_U56:
+        case ZB_ZCL_ATTR_TYPE_S56:
+        case ZB_ZCL_ATTR_TYPE_56BIT:
+        case ZB_ZCL_ATTR_TYPE_56BITMAP: return 7;
+        case ZB_ZCL_ATTR_TYPE_64BIT:
+        case ZB_ZCL_ATTR_TYPE_64BITMAP:
+        case ZB_ZCL_ATTR_TYPE_U64:
+        case ZB_ZCL_ATTR_TYPE_S64:
+        case ZB_ZCL_ATTR_TYPE_DOUBLE:
+        case ZB_ZCL_ATTR_TYPE_IEEE_ADDR: return 8;
+        case ZB_ZCL_ATTR_TYPE_128_BIT_KEY: return 16;
+        case ZB_ZCL_ATTR_TYPE_OCTET_STRING:
+        case ZB_ZCL_ATTR_TYPE_CHAR_STRING: return data[0] + 1;
+        case ZB_ZCL_ATTR_TYPE_ARRAY:
+        case ZB_ZCL_ATTR_TYPE_CUSTOM_32ARRAY:
+        case ZB_ZCL_ATTR_TYPE_LONG_OCTET_STRING:
+            return (data[0] | (data[1] << 8)) + 2;
+        default: return 0;
+    }
+}
+
+/* earlier path: decode every value for the log, stage, then frame */
+static void forward_old(const payload_t* p) {
+    char text[64];
+    uint8_t stage[100];
+    uint16_t i = 0, attr_len, j;
+
+    while (i + 3 <= p->len) {
+        if (p->zcl_cmd == ZB_ZCL_CMD_READ_ATTRIB_RESP) {
+            if (p->data[i + 2] != ZB_ZCL_STATUS_SUCCESS) {
+                i += 3;
+                continue;
+            }
+            i++;
+        }
+        attr_len = switch_attr_size(p->data[i + 2], p->data + i + 3);
+        if (attr_len == 0) {
+            break;
+        }
+        for (j = 0; j < attr_len && j * 2 + 2 < sizeof(text); j++) {
+            sprintf(text + j * 2, "%02x", p->data[i + 3 + j]);
+        }
+        s_sink += (uint8_t)text[0];
+        i += 3 + attr_len;
+    }
+    memcpy(stage, p->data, p->len);
+    memcpy(s_frame + 10, stage, p->len);
+}
+
+static int frame_cb(const uint8_t* data, uint16_t len, void* arg) {
+    memcpy(s_frame + 10, data, len);
+    s_sink += len;
+    return 0;
+}
+
+/* the forwarding path: walk only to split, write straight into the frame */
+static void forward_new(const payload_t* p) {
+    gw_zcl_record_split(p->zcl_cmd, p->data, p->len, FRAME_MAX, frame_cb,
+                        NULL);
+}
+
+/* forwarding plus the record walk a payload longer than a frame costs */
+static void walk_new(const payload_t* p) {
+    gw_zcl_record_split(p->zcl_cmd, p->data, p->len, 0xFFFF >> 1, frame_cb,
+                        NULL);
+    for (uint16_t i = 0, rec; i < p->len; i += rec) {
+        rec = gw_zcl_record_size(p->zcl_cmd, p->data + i, p->len - i);
+        if (rec == 0) {
+            break;
+        }
+    }
+}
+
+static double per_payload_ns(void (*fn)(const payload_t*), const payload_t* p) {
+    uint64_t t0 = now_ns();
+    uint32_t r;
+
+    for (r = 0; r < ROUNDS; r++) {
+        fn(p);
+    }
+    return (double)(now_ns() - t0) / ROUNDS;
+}
+
+static int count_cb(const uint8_t* data, uint16_t len, void* arg) {
+    (*(uint32_t*)arg)++;
+    return 0;
+}
+
+int main(void) {
+    uint8_t big[2048], str[33];
+    uint16_t len, attr;
+    uint32_t i, frames, r;
+    uint64_t t0;
+
+    printf("%-14s %5s %10s %10s %10s\n", "payload", "bytes", "old ns",
+           "forward ns", "walk ns");
+    for (i = 0; i < PAYLOAD_NUM; i++) {
+        printf("%-14s %5u %10.1f %10.1f %10.1f\n", s_payloads[i].name,
+               s_payloads[i].len, per_payload_ns(forward_old, &s_payloads[i]),
+               per_payload_ns(forward_new, &s_payloads[i]),
+               per_payload_ns(walk_new, &s_payloads[i]));
+    }
+
+    /* read response of 48 strings of 32 characters, 1.7 kB over APS
+     * fragmentation */
+    memset(str, 'x', sizeof(str));
+    str[0] = 32;
+    for (attr = 0, len = 0; attr < 48; attr++) {
+        big[len++] = attr & 0xFF;
+        big[len++] = attr >> 8;
+        big[len++] = ZB_ZCL_STATUS_SUCCESS;
+        big[len++] = ZB_ZCL_ATTR_TYPE_CHAR_STRING;
+        memcpy(big + len, str, sizeof(str));
+        len += sizeof(str);
+    }
+    frames = 0;
+    gw_zcl_record_split(ZB_ZCL_CMD_READ_ATTRIB_RESP, big, len, FRAME_MAX,
+                        count_cb, &frames);
+    t0 = now_ns();
+    for (r = 0; r < ROUNDS / 10; r++) {
+        gw_zcl_record_split(ZB_ZCL_CMD_READ_ATTRIB_RESP, big, len, FRAME_MAX,
+                            frame_cb, NULL);
+    }
+    printf("read response  %5u bytes, %lu frames, %.1f ns\n", len,
+           (unsigned long)frames, (double)(now_ns() - t0) / (ROUNDS / 10));
+    return 0;
+}
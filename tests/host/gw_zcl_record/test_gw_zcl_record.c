@@ -0,0 +1,237 @@
+/**
+ * @file test_gw_zcl_record.c
+ * @brief Attribute record walking of the Zigbee gateway: value sizes by
+ *        type, record sizes of reports and read responses, and the split of
+ *        long payloads into gateway frames at record boundaries.
+ */
+
+#include <string.h>
+#include "host_test.h"
+#include "zboss_api.h"
+#include "gw_zcl_record.h"
+
+/* ZIGBEE_GW_CMD_PARAM_MAX less the cluster id in front */
+#define FRAME_MAX  (255 - 9 - 2)
+#define CHUNK_MAX  16
+
+typedef struct {
+    const uint8_t* data[CHUNK_MAX];
+    uint16_t len[CHUNK_MAX];
+    uint8_t num;
+    uint8_t stop_at;
+} chunks_t;
+
+static int chunk_cb(const uint8_t* data, uint16_t len, void* arg) {
+    chunks_t* c = arg;
+
+    if (c->num >= CHUNK_MAX || (c->stop_at && c->num + 1 == c->stop_at)) {
+        return -1;
+    }
+    c->data[c->num] = data;
+    c->len[c->num] = len;
+    c->num++;
+    return 0;
+}
+
+/* attribute id, status when read, type and value */
+static uint16_t rec_put(uint8_t* p, uint8_t zcl_cmd, uint16_t attr,
+                        uint8_t type, const uint8_t* value, uint16_t len) {
+    uint16_t n = 0;
+
+    p[n++] = attr & 0xFF;
+    p[n++] = attr >> 8;
+    if (zcl_cmd == ZB_ZCL_CMD_READ_ATTRIB_RESP) {
+        p[n++] = ZB_ZCL_STATUS_SUCCESS;
+    }
+    p[n++] = type;
+    memcpy(p + n, value, len);
+    return n + len;
+}
+
+/* every chunk fits, holds whole records and the chunks add up to the input */
+static void check_chunks(uint8_t zcl_cmd, const chunks_t* c,
+                         const uint8_t* data, uint16_t len) {
+    uint16_t total = 0, i, rec;
+    uint8_t k;
+
+    for (k = 0; k < c->num; k++) {
+        CHECK(c->len[k] <= FRAME_MAX);
+        CHECK(c->data[k] == data + total);
+        for (i = 0; i < c->len[k]; i += rec) {
+            rec = gw_zcl_record_size(zcl_cmd, c->data[k] + i, c->len[k] - i);
+            if (rec == 0) {
+                CHECK(rec != 0);
+                break;
+            }
+        }
+        CHECK_EQ(i, c->len[k]);
+        total += c->len[k];
+    }
+    CHECK_EQ(total, len);
+}
+
+static void test_attr_size(void) {
+    uint8_t str[300] = {5};
+
+    CHECK_EQ(zigbee_zcl_attr_size(ZB_ZCL_ATTR_TYPE_BOOL, str, 1), 1);
+    CHECK_EQ(zigbee_zcl_attr_size(ZB_ZCL_ATTR_TYPE_S16, str, 2), 2);
+    CHECK_EQ(zigbee_zcl_attr_size(ZB_ZCL_ATTR_TYPE_U24, str, 3), 3);
+    CHECK_EQ(zigbee_zcl_attr_size(ZB_ZCL_ATTR_TYPE_UTC_TIME, str, 4), 4);
+    CHECK_EQ(zigbee_zcl_attr_size(ZB_ZCL_ATTR_TYPE_U48, str, 6), 6);
+    CHECK_EQ(zigbee_zcl_attr_size(ZB_ZCL_ATTR_TYPE_IEEE_ADDR, str, 8), 8);
+    CHECK_EQ(zigbee_zcl_attr_size(ZB_ZCL_ATTR_TYPE_128_BIT_KEY, str, 16), 16);
+    /* value longer than what is left */
+    CHECK_EQ(zigbee_zcl_attr_size(ZB_ZCL_ATTR_TYPE_U32, str, 3), 0);
+    /* types without a size: unknown, structure, no data */
+    CHECK_EQ(zigbee_zcl_attr_size(0x00, str, 8), 0);
+    CHECK_EQ(zigbee_zcl_attr_size(0x4c, str, 8), 0);
+    CHECK_EQ(zigbee_zcl_attr_size(0xff, str, 8), 0);
+
+    /* strings count their length prefix, 0xFF is the invalid string */
+    CHECK_EQ(zigbee_zcl_attr_size(ZB_ZCL_ATTR_TYPE_CHAR_STRING, str, 6), 6);
+    CHECK_EQ(zigbee_zcl_attr_size(ZB_ZCL_ATTR_TYPE_CHAR_STRING, str, 5), 0);
+    CHECK_EQ(zigbee_zcl_attr_size(ZB_ZCL_ATTR_TYPE_CHAR_STRING, str, 0), 0);
+    str[0] = 0xFF;
+    CHECK_EQ(zigbee_zcl_attr_size(ZB_ZCL_ATTR_TYPE_OCTET_STRING, str, 1), 1);
+    str[0] = 0x2C;
+    str[1] = 0x01;
+    CHECK_EQ(zigbee_zcl_attr_size(ZB_ZCL_ATTR_TYPE_LONG_OCTET_STRING, str, 302),
+             302);
+    CHECK_EQ(zigbee_zcl_attr_size(ZB_ZCL_ATTR_TYPE_LONG_OCTET_STRING, str, 301),
+             0);
+    CHECK_EQ(zigbee_zcl_attr_size(ZB_ZCL_ATTR_TYPE_ARRAY, str, 1), 0);
+    str[0] = str[1] = 0xFF;
+    CHECK_EQ(zigbee_zcl_attr_size(ZB_ZCL_ATTR_TYPE_ARRAY, str, 2), 2);
+}
+
+static void test_record_size(void) {
+    uint8_t p[16];
+    uint8_t v[2] = {0x34, 0x12};
+
+    rec_put(p, ZB_ZCL_CMD_REPORT_ATTRIB, 0x0000, ZB_ZCL_ATTR_TYPE_S16, v, 2);
+    CHECK_EQ(gw_zcl_record_size(ZB_ZCL_CMD_REPORT_ATTRIB, p, 5), 5);
+    CHECK_EQ(gw_zcl_record_size(ZB_ZCL_CMD_REPORT_ATTRIB, p, 4), 0);
+
+    rec_put(p, ZB_ZCL_CMD_READ_ATTRIB_RESP, 0x0000, ZB_ZCL_ATTR_TYPE_S16, v, 2);
+    CHECK_EQ(gw_zcl_record_size(ZB_ZCL_CMD_READ_ATTRIB_RESP, p, 6), 6);
+    CHECK_EQ(gw_zcl_record_size(ZB_ZCL_CMD_READ_ATTRIB_RESP, p, 5), 0);
+
+    /* a failed read has no type and no value */
+    p[2] = ZB_ZCL_STATUS_UNSUP_ATTRIB;
+    CHECK_EQ(gw_zcl_record_size(ZB_ZCL_CMD_READ_ATTRIB_RESP, p, 3), 3);
+    CHECK_EQ(gw_zcl_record_size(ZB_ZCL_CMD_READ_ATTRIB_RESP, p, 2), 0);
+
+    /* other commands are not walked */
+    CHECK_EQ(gw_zcl_record_size(ZB_ZCL_CMD_DEFAULT_RESP, p, 6), 0);
+}
+
+static void test_split_fits(void) {
+    chunks_t c = {0};
+    uint8_t p[FRAME_MAX];
+
+    memset(p, 0xEE, sizeof(p));
+    /* a payload that fits goes as it is, even when it is not walkable */
+    CHECK_EQ(gw_zcl_record_split(ZB_ZCL_CMD_REPORT_ATTRIB, p, sizeof(p),
+                                 FRAME_MAX, chunk_cb, &c),
+             0);
+    CHECK_EQ(c.num, 1);
+    CHECK_EQ(c.len[0], sizeof(p));
+}
+
+/* a basic cluster read of every string attribute, 32 bytes each */
+static void test_split_read_rsp(void) {
+    chunks_t c = {0};
+    uint8_t p[1024], str[33];
+    uint16_t len = 0, attr;
+
+    memset(str, 'a', sizeof(str));
+    str[0] = 32;
+    for (attr = 0; attr < 20; attr++) {
+        if (attr % 5 == 4) {
+            p[len++] = attr;
+            p[len++] = 0;
+            p[len++] = ZB_ZCL_STATUS_UNSUP_ATTRIB;
+            continue;
+        }
+        len += rec_put(p + len, ZB_ZCL_CMD_READ_ATTRIB_RESP, attr,
+                       ZB_ZCL_ATTR_TYPE_CHAR_STRING, str, sizeof(str));
+    }
+    CHECK(len > 2 * FRAME_MAX);
+    CHECK_EQ(gw_zcl_record_split(ZB_ZCL_CMD_READ_ATTRIB_RESP, p, len,
+                                 FRAME_MAX, chunk_cb, &c),
+             0);
+    CHECK_EQ(c.num, 3);
+    check_chunks(ZB_ZCL_CMD_READ_ATTRIB_RESP, &c, p, len);
+}
+
+static void test_split_report(void) {
+    chunks_t c = {0};
+    uint8_t p[1024], v[8] = {0};
+    uint16_t len = 0, attr;
+
+    for (attr = 0; attr < 90; attr++) {
+        len += rec_put(p + len, ZB_ZCL_CMD_REPORT_ATTRIB, attr,
+                       ZB_ZCL_ATTR_TYPE_U48, v, 6);
+    }
+    CHECK_EQ(gw_zcl_record_split(ZB_ZCL_CMD_REPORT_ATTRIB, p, len, FRAME_MAX,
+                                 chunk_cb, &c),
+             0);
+    /* 27 records of 9 bytes per frame */
+    CHECK_EQ(c.num, 4);
+    CHECK_EQ(c.len[0], 27 * 9);
+    check_chunks(ZB_ZCL_CMD_REPORT_ATTRIB, &c, p, len);
+}
+
+static void test_split_errors(void) {
+    chunks_t c = {0};
+    uint8_t p[1024], v[8] = {0}, str[250];
+    uint16_t len = 0, good, attr;
+
+    /* records before a malformed one still go out */
+    for (attr = 0; attr < 60; attr++) {
+        len += rec_put(p + len, ZB_ZCL_CMD_REPORT_ATTRIB, attr,
+                       ZB_ZCL_ATTR_TYPE_U32, v, 4);
+    }
+    good = len;
+    len += rec_put(p + len, ZB_ZCL_CMD_REPORT_ATTRIB, 60, 0x4c, v, 4);
+    CHECK_EQ(gw_zcl_record_split(ZB_ZCL_CMD_REPORT_ATTRIB, p, len, FRAME_MAX,
+                                 chunk_cb, &c),
+             -1);
+    check_chunks(ZB_ZCL_CMD_REPORT_ATTRIB, &c, p, good);
+
+    /* a single record longer than a frame cannot be split */
+    memset(&c, 0, sizeof(c));
+    memset(str, 'b', sizeof(str));
+    str[0] = sizeof(str) - 1;
+    len = rec_put(p, ZB_ZCL_CMD_REPORT_ATTRIB, 0, ZB_ZCL_ATTR_TYPE_U8, v, 1);
+    len += rec_put(p + len, ZB_ZCL_CMD_REPORT_ATTRIB, 1,
+                   ZB_ZCL_ATTR_TYPE_CHAR_STRING, str, sizeof(str));
+    CHECK_EQ(gw_zcl_record_split(ZB_ZCL_CMD_REPORT_ATTRIB, p, len, FRAME_MAX,
+                                 chunk_cb, &c),
+             -1);
+    CHECK_EQ(c.num, 1);
+    CHECK_EQ(c.len[0], 4);
+
+    /* a failed send stops the split */
+    memset(&c, 0, sizeof(c));
+    c.stop_at = 2;
+    len = 0;
+    for (attr = 0; attr < 90; attr++) {
+        len += rec_put(p + len, ZB_ZCL_CMD_REPORT_ATTRIB, attr,
+                       ZB_ZCL_ATTR_TYPE_U48, v, 6);
+    }
+    CHECK_EQ(gw_zcl_record_split(ZB_ZCL_CMD_REPORT_ATTRIB, p, len, FRAME_MAX,
+                                 chunk_cb, &c),
+             -1);
+    CHECK_EQ(c.num, 1);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_attr_size);
+    HOST_TEST_RUN(test_record_size);
+    HOST_TEST_RUN(test_split_fits);
+    HOST_TEST_RUN(test_split_read_rsp);
+    HOST_TEST_RUN(test_split_report);
+    HOST_TEST_RUN(test_split_errors);
+    return HOST_TEST_END();
+}
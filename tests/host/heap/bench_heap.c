@@ -0,0 +1,245 @@
+/**
+ * @file bench_heap.c
+ * @brief pvPortMalloc() and vPortFree() of the TLSF heap (HEAP_BENCH_TLSF)
+ *        or heap_5 under the workloads of heap_workload.h over the same
+ *        two regions: mean, 99.9th percentile and worst time per call,
+ *        failed allocations and the fragmentation of the free space.
+ *
+ * Given a file, the benchmark replays the trace in it instead: one line per
+ * call as the traceMALLOC() and traceFREE() hooks of the target see it,
+ * "m <address> <size>" or "f <address>" with the address in hex. A failed
+ * allocation has address 0, it is tried again but not kept.
+ *
+ * Calls are timed with the time stamp counter where there is one. Host
+ * timings only compare the heaps, the target is a Cortex-M3 at 48 MHz
+ * (RT58x) or a Cortex-M33 at 64 MHz (RT584), and blocks carry a 16 byte
+ * header on a 64-bit host against 8 bytes there.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "FreeRTOS.h"
+#include "heap_workload.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define STAMP()    __rdtsc()
+#define STAMP_UNIT "cycles"
+#else
+#define STAMP()    now_ns()
+#define STAMP_UNIT "ns"
+#endif
+
+#define REGION0_SIZE (24 * 1024)
+#define REGION1_SIZE (40 * 1024)
+#define REGION_GAP   256
+#define OPS          1000000
+#define FRAG_EVERY   1000
+#define REPLAY_LIVE  1024
+
+#ifdef HEAP_BENCH_TLSF
+#define HEAP_NAME "heap_tlsf"
+#else
+#define HEAP_NAME "heap_5"
+#endif
+
+void vPortHeapResetState(void);
+
+static uint8_t s_ram[REGION0_SIZE + REGION_GAP + REGION1_SIZE] __attribute__((aligned(8)));
+
+static const HeapRegion_t s_regions[] = {
+    {s_ram, REGION0_SIZE},
+    {s_ram + REGION0_SIZE + REGION_GAP, REGION1_SIZE},
+    {NULL, 0},
+};
+
+typedef struct {
+    uint32_t *pSample;
+    uint32_t num;
+} timing_t;
+
+static timing_t s_alloc, s_free;
+
+/* live blocks of a replayed trace, by their address on the target */
+typedef struct {
+    unsigned long addr;
+    void *ptr;
+} replay_block_t;
+
+static replay_block_t s_live[REPLAY_LIVE];
+
+#if !(defined(__x86_64__) || defined(__i386__))
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#endif
+
+static void *timed_alloc(size_t size) {
+    uint64_t t0 = STAMP();
+    void *p = pvPortMalloc(size);
+
+    s_alloc.pSample[s_alloc.num++] = (uint32_t)(STAMP() - t0);
+    return p;
+}
+
+static void timed_free(void *p) {
+    uint64_t t0 = STAMP();
+
+    vPortFree(p);
+    s_free.pSample[s_free.num++] = (uint32_t)(STAMP() - t0);
+}
+
+static int sample_cmp(const void *pA, const void *pB) {
+    uint32_t a = *(const uint32_t *)pA, b = *(const uint32_t *)pB;
+
+    return (a > b) - (a < b);
+}
+
+static void timing_print(const char *pName, timing_t *pTiming) {
+    uint64_t sum = 0;
+    uint32_t i;
+
+    if (pTiming->num == 0) {
+        return;
+    }
+    qsort(pTiming->pSample, pTiming->num, sizeof(uint32_t), sample_cmp);
+    for (i = 0; i < pTiming->num; i++) {
+        sum += pTiming->pSample[i];
+    }
+    printf("  %-7s mean %6.1f  p99.9 %6lu  max %7lu %s\n", pName, (double)sum / pTiming->num,
+           (unsigned long)pTiming->pSample[pTiming->num - pTiming->num / 1000 - 1],
+           (unsigned long)pTiming->pSample[pTiming->num - 1], STAMP_UNIT);
+}
+
+/* 1000 - 1000 * largest free block / free bytes */
+static uint32_t fragmentation(void) {
+    HeapStats_t stats;
+
+    vPortGetHeapStats(&stats);
+    if (stats.xAvailableHeapSpaceInBytes == 0) {
+        return 0;
+    }
+    return 1000 - (uint32_t)(stats.xSizeOfLargestFreeBlockInBytes * 1000 / stats.xAvailableHeapSpaceInBytes);
+}
+
+/* the live block of a target address, an unused entry for address 0 */
+static replay_block_t *replay_find(unsigned long addr) {
+    uint32_t i;
+
+    for (i = 0; i < REPLAY_LIVE; i++) {
+        if (s_live[i].ptr != NULL ? s_live[i].addr == addr : addr == 0) {
+            return &s_live[i];
+        }
+    }
+    return NULL;
+}
+
+static int replay(const char *pPath) {
+    FILE *f = fopen(pPath, "r");
+    HeapStats_t stats;
+    replay_block_t *b;
+    char line[80];
+    unsigned long addr, size, calls = 0, fails = 0, unknown = 0;
+    uint64_t frag_sum = 0;
+    uint32_t frag_num = 0;
+    void *p;
+
+    if (f == NULL) {
+        perror(pPath);
+        return 1;
+    }
+    vPortHeapResetState();
+    vPortDefineHeapRegions(s_regions);
+    while (fgets(line, sizeof(line), f) && s_alloc.num < OPS && s_free.num < OPS) {
+        if (sscanf(line, "m %lx %lu", &addr, &size) == 2) {
+            p = timed_alloc(size);
+            b = addr ? replay_find(0) : NULL;
+            if (p == NULL) {
+                fails++;
+            } else if (b == NULL) {
+                /* failed on the target, or more live blocks than kept */
+                vPortFree(p);
+            } else {
+                b->addr = addr;
+                b->ptr = p;
+            }
+        } else if (sscanf(line, "f %lx", &addr) == 1) {
+            b = addr ? replay_find(addr) : NULL;
+            if (b == NULL) {
+                unknown++;
+                continue;
+            }
+            timed_free(b->ptr);
+            b->ptr = NULL;
+        } else {
+            continue;
+        }
+        if (calls++ % FRAG_EVERY == 0) {
+            frag_sum += fragmentation();
+            frag_num++;
+        }
+    }
+    fclose(f);
+    vPortGetHeapStats(&stats);
+
+    printf("%s, regions %u + %u bytes, trace %s\n", HEAP_NAME, REGION0_SIZE, REGION1_SIZE, pPath);
+    printf("%lu calls: %lu fails, %lu frees of unknown blocks, fragmentation mean %lu end %lu permille, "
+           "%lu free blocks, min free %lu\n",
+           calls, fails, unknown, (unsigned long)(frag_num ? frag_sum / frag_num : 0),
+           (unsigned long)fragmentation(), (unsigned long)stats.xNumberOfFreeBlocks,
+           (unsigned long)stats.xMinimumEverFreeBytesRemaining);
+    timing_print("malloc", &s_alloc);
+    timing_print("free", &s_free);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    static heap_wl_t wl;
+    HeapStats_t stats;
+    uint64_t frag_sum;
+    uint32_t op, frag_num, frag;
+    int profile;
+
+    s_alloc.pSample = malloc(OPS * sizeof(uint32_t));
+    s_free.pSample = malloc(OPS * sizeof(uint32_t) + HEAP_WL_SLOTS * sizeof(uint32_t));
+
+    if (argc > 1) {
+        return replay(argv[1]);
+    }
+    printf("%s, regions %u + %u bytes, %u operations of the synthetic workloads\n", HEAP_NAME,
+           REGION0_SIZE, REGION1_SIZE, OPS);
+    for (profile = 0; profile < HEAP_WL_NUM; profile++) {
+        vPortHeapResetState();
+        vPortDefineHeapRegions(s_regions);
+        heap_wl_init(&wl, (heap_wl_profile_t)profile, 1234 + profile);
+        s_alloc.num = 0;
+        s_free.num = 0;
+        frag_sum = 0;
+        frag_num = 0;
+
+        for (op = 0; op < OPS; op++) {
+            heap_wl_step(&wl, timed_alloc, timed_free);
+            if (op % FRAG_EVERY == 0) {
+                frag_sum += fragmentation();
+                frag_num++;
+            }
+        }
+        frag = fragmentation();
+        vPortGetHeapStats(&stats);
+
+        printf("%s: %lu fails, fragmentation mean %lu end %lu permille, %lu free blocks, min free %lu\n",
+               heap_wl_name[profile], (unsigned long)wl.fails, (unsigned long)(frag_sum / frag_num),
+               (unsigned long)frag, (unsigned long)stats.xNumberOfFreeBlocks,
+               (unsigned long)stats.xMinimumEverFreeBytesRemaining);
+        timing_print("malloc", &s_alloc);
+        timing_print("free", &s_free);
+        heap_wl_drain(&wl, vPortFree);
+        if (wl.corrupt) {
+            printf("  %lu corrupt blocks\n", (unsigned long)wl.corrupt);
+        }
+    }
+    return 0;
+}
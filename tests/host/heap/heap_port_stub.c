@@ -0,0 +1,17 @@
+/**
+ * @file heap_port_stub.c
+ * @brief Kernel calls of the heaps without a scheduler: the heap tests run
+ *        in one thread, so the critical sections and the scheduler
+ *        suspension have nothing to guard.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+void vPortEnterCritical(void) {}
+
+void vPortExitCritical(void) {}
+
+void vTaskSuspendAll(void) {}
+
+BaseType_t xTaskResumeAll(void) { return pdFALSE; }
@@ -0,0 +1,187 @@
+/**
+ * @file heap_workload.h
+ * @brief Allocation workloads of the heap test and benchmark, modelled on
+ *        the call sites that allocate per frame or event.
+ *
+ * The workloads are synthetic: sizes, mix and lifetimes are estimates read
+ * off the call sites, not a capture from a running gateway or router. The
+ * benchmark replays a captured trace when given one.
+ *
+ * - gateway: zigbee_gw_cmd_send() frames of 16 to 300 bytes, mostly under
+ *   80, freed once the UART sent them a few frames later, with device
+ *   records and OTA cache lines of 0.5 to 2 KB living long.
+ * - ble: data-rate event buffers of 251 bytes plus header queued up to 16
+ *   deep, with small control events in between.
+ * - churn: any size of 8 to 2048 bytes with any lifetime, the worst case
+ *   for fragmentation.
+ *
+ * Every live block is filled with a pattern of its slot and checked when
+ * it is freed, so an overlap of two blocks shows up.
+ */
+
+#ifndef HEAP_WORKLOAD_H
+#define HEAP_WORKLOAD_H
+
+#include <stdint.h>
+#include <string.h>
+#include "FreeRTOS.h"
+
+#define HEAP_WL_SLOTS 128
+
+typedef enum {
+    HEAP_WL_GATEWAY,
+    HEAP_WL_BLE,
+    HEAP_WL_CHURN,
+    HEAP_WL_NUM,
+} heap_wl_profile_t;
+
+typedef struct {
+    uint8_t *ptr;
+    uint32_t size;
+    uint32_t expire;
+} heap_wl_slot_t;
+
+typedef struct {
+    heap_wl_profile_t profile;
+    uint32_t rnd;
+    uint32_t op;
+    uint32_t live;
+    uint32_t fails;
+    uint32_t corrupt;
+    heap_wl_slot_t slot[HEAP_WL_SLOTS];
+} heap_wl_t;
+
+static const char *const heap_wl_name[HEAP_WL_NUM] = {"gateway", "ble", "churn"};
+
+static inline uint32_t heap_wl_rand(heap_wl_t *wl, uint32_t range) {
+    wl->rnd = wl->rnd * 1103515245u + 12345u;
+    return (wl->rnd >> 8) % range;
+}
+
+/* size of the next allocation and the operations it lives for */
+static inline void heap_wl_sample(heap_wl_t *wl, uint32_t *size, uint32_t *life) {
+    uint32_t r = heap_wl_rand(wl, 100);
+
+    switch (wl->profile) {
+        case HEAP_WL_GATEWAY:
+            if (r < 1) {
+                *size = 512 + heap_wl_rand(wl, 1537);
+                *life = 1000 + heap_wl_rand(wl, 4000);
+            } else if (r < 85) {
+                *size = 16 + heap_wl_rand(wl, 65);
+                *life = 1 + heap_wl_rand(wl, 8);
+            } else {
+                *size = 80 + heap_wl_rand(wl, 221);
+                *life = 1 + heap_wl_rand(wl, 8);
+            }
+            break;
+        case HEAP_WL_BLE:
+            if (r < 70) {
+                *size = 251 + 8;
+                *life = 1 + heap_wl_rand(wl, 16);
+            } else {
+                *size = 12 + heap_wl_rand(wl, 20);
+                *life = 1 + heap_wl_rand(wl, 4);
+            }
+            break;
+        default:
+            *size = 8 + heap_wl_rand(wl, 2041);
+            *life = 1 + heap_wl_rand(wl, 256);
+            break;
+    }
+}
+
+static inline void heap_wl_init(heap_wl_t *wl, heap_wl_profile_t profile, uint32_t seed) {
+    memset(wl, 0, sizeof(*wl));
+    wl->profile = profile;
+    wl->rnd = seed;
+}
+
+static inline void heap_wl_fill(heap_wl_slot_t *s, uint32_t idx) {
+    memset(s->ptr, (int)(idx & 0xFF), s->size);
+}
+
+static inline int heap_wl_intact(const heap_wl_slot_t *s, uint32_t idx) {
+    uint32_t i;
+
+    for (i = 0; i < s->size; i++) {
+        if (s->ptr[i] != (uint8_t)idx) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* the slot to free this operation, or to allocate into, -1 when full */
+static inline int heap_wl_pick(heap_wl_t *wl, int *free_idx) {
+    int i, empty = -1;
+
+    *free_idx = -1;
+    for (i = 0; i < HEAP_WL_SLOTS; i++) {
+        if (wl->slot[i].ptr == NULL) {
+            if (empty < 0) {
+                empty = i;
+            }
+        } else if (wl->slot[i].expire <= wl->op && *free_idx < 0) {
+            *free_idx = i;
+        }
+    }
+    return empty;
+}
+
+/*
+ * One operation: free a block whose time is up, or else allocate one. With
+ * every slot live a random one goes. The calls are passed in so the
+ * benchmark can time them.
+ */
+static inline void heap_wl_step(heap_wl_t *wl, void *(*alloc)(size_t), void (*release)(void *)) {
+    heap_wl_slot_t *s;
+    uint32_t size, life;
+    int idx, free_idx;
+
+    idx = heap_wl_pick(wl, &free_idx);
+    if (free_idx < 0 && idx < 0) {
+        free_idx = (int)heap_wl_rand(wl, HEAP_WL_SLOTS);
+    }
+
+    if (free_idx >= 0) {
+        s = &wl->slot[free_idx];
+        if (!heap_wl_intact(s, (uint32_t)free_idx)) {
+            wl->corrupt++;
+        }
+        release(s->ptr);
+        s->ptr = NULL;
+        wl->live--;
+    } else {
+        heap_wl_sample(wl, &size, &life);
+        s = &wl->slot[idx];
+        s->ptr = alloc(size);
+        if (s->ptr == NULL) {
+            wl->fails++;
+        } else {
+            s->size = size;
+            s->expire = wl->op + life;
+            heap_wl_fill(s, (uint32_t)idx);
+            wl->live++;
+        }
+    }
+    wl->op++;
+}
+
+/* free every live block */
+static inline void heap_wl_drain(heap_wl_t *wl, void (*release)(void *)) {
+    int i;
+
+    for (i = 0; i < HEAP_WL_SLOTS; i++) {
+        if (wl->slot[i].ptr != NULL) {
+            if (!heap_wl_intact(&wl->slot[i], (uint32_t)i)) {
+                wl->corrupt++;
+            }
+            release(wl->slot[i].ptr);
+            wl->slot[i].ptr = NULL;
+        }
+    }
+    wl->live = 0;
+}
+
+#endif /* HEAP_WORKLOAD_H */
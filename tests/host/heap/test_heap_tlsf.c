@@ -0,0 +1,259 @@
+/**
+ * @file test_heap_tlsf.c
+ * @brief TLSF heap under the allocation workloads of heap_workload.h over
+ *        two regions: block chain and free list invariants after every
+ *        operation of a run, no overlap of live blocks, full coalescing
+ *        once everything is freed, the fragmentation and largest block
+ *        statistics, the histogram and the failed allocation count.
+ *
+ * The source is included so the block chain can be walked.
+ */
+
+#include <stdbool.h>
+#include "heap_tlsf.c"
+#include "host_test.h"
+#include "heap_workload.h"
+
+#define REGION0_SIZE (24 * 1024)
+#define REGION1_SIZE (40 * 1024)
+#define REGION_GAP   256
+#define STRESS_OPS   200000
+#define CHECK_EVERY  1 /* invariants walk the whole heap, every op of a run */
+
+static uint8_t s_ram[REGION0_SIZE + REGION_GAP + REGION1_SIZE] __attribute__((aligned(8)));
+
+static const HeapRegion_t s_regions[] = {
+    {s_ram, REGION0_SIZE},
+    {s_ram + REGION0_SIZE + REGION_GAP, REGION1_SIZE},
+    {NULL, 0},
+};
+
+static size_t s_total;
+
+static void heap_boot(void) {
+    vPortHeapResetState();
+    vPortDefineHeapRegions(s_regions);
+    s_total = xPortGetFreeHeapSize();
+}
+
+/* free list of the class of pxBlock holds it */
+static bool in_free_list(BlockHeader_t *pxBlock) {
+    BlockHeader_t *pxIt;
+    uint32_t ulFl, ulSl;
+
+    prvMappingInsert(heapBLOCK_SIZE(pxBlock), &ulFl, &ulSl);
+    if (!(ulFlBitmap & (1u << ulFl)) || !(ulSlBitmap[ulFl] & (1u << ulSl))) {
+        return false;
+    }
+    for (pxIt = pxFreeLists[ulFl][ulSl]; pxIt != NULL; pxIt = pxIt->pxNextFree) {
+        if (pxIt == pxBlock) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* walk both regions, the counters must match the chain */
+static bool heap_consistent(void) {
+    BlockHeader_t *pxBlock, *pxNext;
+    size_t free_bytes = 0, free_blocks = 0;
+    uintptr_t start;
+    int r;
+
+    for (r = 0; r < 2; r++) {
+        start = ((uintptr_t)s_regions[r].pucStartAddress + heapTLSF_ALIGN - 1) & ~(uintptr_t)(heapTLSF_ALIGN - 1);
+        pxBlock = (BlockHeader_t *)start;
+        if (pxBlock->pxPrevPhys != NULL) {
+            return false;
+        }
+        while (heapBLOCK_SIZE(pxBlock) != 0) {
+            pxNext = heapBLOCK_NEXT(pxBlock);
+            if ((uint8_t *)pxNext > s_regions[r].pucStartAddress + s_regions[r].xSizeInBytes
+                || pxNext->pxPrevPhys != pxBlock) {
+                return false;
+            }
+            if (pxBlock->xSize & heapBLOCK_FREE) {
+                /* two free neighbours were not merged */
+                if (!(pxNext->xSize & heapBLOCK_PREV_FREE) || (pxNext->xSize & heapBLOCK_FREE)
+                    || !in_free_list(pxBlock)) {
+                    return false;
+                }
+                free_bytes += heapBLOCK_SIZE(pxBlock);
+                free_blocks++;
+            } else if (pxNext->xSize & heapBLOCK_PREV_FREE) {
+                return false;
+            }
+            pxBlock = pxNext;
+        }
+    }
+    return free_bytes == xFreeBytesRemaining && free_blocks == xNumberOfFreeBlocks;
+}
+
+static void *wl_alloc(size_t size) {
+    return pvPortMalloc(size);
+}
+
+static void test_regions(void) {
+    TlsfHeapStats_t tlsf;
+    HeapStats_t stats;
+
+    heap_boot();
+    CHECK(heap_consistent());
+    /* each region loses its alignment and the end marker only */
+    CHECK(s_total <= REGION0_SIZE + REGION1_SIZE - 2 * heapHEADER_SIZE);
+    CHECK(s_total >= REGION0_SIZE + REGION1_SIZE - 2 * (heapHEADER_SIZE + heapTLSF_ALIGN));
+
+    vPortGetTlsfHeapStats(&tlsf);
+    CHECK_EQ(tlsf.xFreeBlocks, 2);
+    CHECK_EQ(tlsf.xFreeBytes, s_total);
+    vPortGetHeapStats(&stats);
+    CHECK_EQ(stats.xNumberOfFreeBlocks, 2);
+    CHECK(stats.xSizeOfLargestFreeBlockInBytes < REGION1_SIZE);
+    CHECK(stats.xSizeOfLargestFreeBlockInBytes > REGION1_SIZE - 64);
+
+    /* nothing spans the gap between the regions */
+    CHECK(pvPortMalloc(REGION1_SIZE + 16) == NULL);
+    CHECK(pvPortMalloc(0) == NULL);
+    CHECK(heap_consistent());
+}
+
+static void run_profile(heap_wl_profile_t profile) {
+    TlsfHeapStats_t tlsf;
+    heap_wl_t wl;
+    uint32_t op, frag_max = 0, probes = 0, misses = 0;
+    bool consistent = true;
+    void *p;
+
+    heap_boot();
+    heap_wl_init(&wl, profile, 1234 + profile);
+    for (op = 0; op < STRESS_OPS; op++) {
+        heap_wl_step(&wl, wl_alloc, vPortFree);
+        if (op % CHECK_EVERY == 0 && consistent && !heap_consistent()) {
+            printf("  inconsistent at op %lu\n", (unsigned long)op);
+            consistent = false;
+        }
+
+        /* the largest allocatable block is really there */
+        if (op % 97 == 0) {
+            vPortGetTlsfHeapStats(&tlsf);
+            if (tlsf.usFragmentationPermille > frag_max) {
+                frag_max = tlsf.usFragmentationPermille;
+            }
+            if (tlsf.xLargestAllocatableBlock > heapHEADER_SIZE) {
+                probes++;
+                p = pvPortMalloc(tlsf.xLargestAllocatableBlock - heapHEADER_SIZE);
+                misses += (p == NULL);
+                vPortFree(p);
+            }
+        }
+    }
+    vPortGetTlsfHeapStats(&tlsf);
+    printf("  %-8s live %3lu fails %5lu, fragmentation %3u permille (max %3lu), %lu free blocks\n",
+           heap_wl_name[profile], (unsigned long)wl.live, (unsigned long)wl.fails,
+           tlsf.usFragmentationPermille, (unsigned long)frag_max, (unsigned long)tlsf.xFreeBlocks);
+
+    CHECK(consistent);
+    CHECK_EQ(wl.corrupt, 0);
+    CHECK_EQ(misses, 0);
+    CHECK(probes > 0);
+    CHECK_EQ(tlsf.xFailedAllocations, wl.fails);
+
+    /* everything merges back into one block per region */
+    heap_wl_drain(&wl, vPortFree);
+    CHECK_EQ(wl.corrupt, 0);
+    CHECK(heap_consistent());
+    vPortGetTlsfHeapStats(&tlsf);
+    CHECK_EQ(tlsf.xFreeBytes, s_total);
+    CHECK_EQ(tlsf.xFreeBlocks, 2);
+    CHECK_EQ(xNumberOfSuccessfulAllocations, xNumberOfSuccessfulFrees);
+}
+
+static void test_gateway(void) {
+    run_profile(HEAP_WL_GATEWAY);
+}
+
+static void test_ble(void) {
+    run_profile(HEAP_WL_BLE);
+}
+
+static void test_churn(void) {
+    run_profile(HEAP_WL_CHURN);
+}
+
+/* a failed request really did not fit, whatever the free space looks like */
+static void test_fail_only_when_full(void) {
+    TlsfHeapStats_t tlsf;
+    heap_wl_t wl;
+    size_t size;
+    uint32_t op, fails = 0;
+    void *p;
+
+    heap_boot();
+    heap_wl_init(&wl, HEAP_WL_CHURN, 99);
+    for (op = 0; op < 20000; op++) {
+        heap_wl_step(&wl, wl_alloc, vPortFree);
+        if (op % 499 != 0) {
+            continue;
+        }
+        for (size = 8; size <= 4096; size += 8) {
+            vPortGetTlsfHeapStats(&tlsf);
+            p = pvPortMalloc(size);
+            if (p == NULL) {
+                fails++;
+                /* good fit: any block of a class above the request fits */
+                CHECK(size + heapHEADER_SIZE > tlsf.xLargestAllocatableBlock);
+            }
+            vPortFree(p);
+        }
+    }
+    CHECK(fails > 0);
+    heap_wl_drain(&wl, vPortFree);
+    CHECK(heap_consistent());
+}
+
+static void test_histogram(void) {
+    TlsfHeapStats_t tlsf;
+    void *p[6];
+    int i;
+
+    heap_boot();
+    vPortResetTlsfHeapHistogram();
+    p[0] = pvPortMalloc(1);
+    p[1] = pvPortMalloc(16);
+    p[2] = pvPortMalloc(17);
+    p[3] = pvPortMalloc(100);
+    p[4] = pvPortMalloc(1024);
+    p[5] = pvPortMalloc(1025);
+    CHECK(pvPortMalloc(REGION1_SIZE) == NULL);
+
+    vPortGetTlsfHeapStats(&tlsf);
+    CHECK_EQ(tlsf.xAllocationHistogram[0], 2);
+    CHECK_EQ(tlsf.xAllocationHistogram[1], 1);
+    CHECK_EQ(tlsf.xAllocationHistogram[3], 1);
+    CHECK_EQ(tlsf.xAllocationHistogram[6], 1);
+    /* the failed request counts in the last bucket too */
+    CHECK_EQ(tlsf.xAllocationHistogram[7], 2);
+    CHECK_EQ(tlsf.xFailedAllocations, 1);
+    CHECK_EQ(tlsf.usFragmentationPermille,
+             (uint16_t)(1000 - tlsf.xLargestAllocatableBlock * 1000 / tlsf.xFreeBytes));
+
+    vPortResetTlsfHeapHistogram();
+    vPortGetTlsfHeapStats(&tlsf);
+    CHECK_EQ(tlsf.xFailedAllocations, 0);
+    CHECK_EQ(tlsf.xAllocationHistogram[0], 0);
+    for (i = 0; i < 6; i++) {
+        vPortFree(p[i]);
+    }
+    CHECK(heap_consistent());
+    CHECK_EQ(xPortGetFreeHeapSize(), s_total);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_regions);
+    HOST_TEST_RUN(test_gateway);
+    HOST_TEST_RUN(test_ble);
+    HOST_TEST_RUN(test_churn);
+    HOST_TEST_RUN(test_fail_only_when_full);
+    HOST_TEST_RUN(test_histogram);
+    return HOST_TEST_END();
+}
@@ -0,0 +1,16 @@
+/**
+ * @file main.h
+ * @brief Host stand-in for the miu-router main.h, the stack calls come from
+ *        the OpenThread stand-in of ot/
+ */
+
+#ifndef __NBR_MOCK_MAIN_H
+#define __NBR_MOCK_MAIN_H
+
+#include <miu_port.h>
+#include <openthread/thread.h>
+#include <openthread/thread_ftd.h>
+
+#include "app_udp.h"
+
+#endif // __NBR_MOCK_MAIN_H
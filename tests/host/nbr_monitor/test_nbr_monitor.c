@@ -0,0 +1,244 @@
+/**
+ * @file test_nbr_monitor.c
+ * @brief Neighbor monitor of miu-router against the OpenThread stand-in of
+ *        ot/: sampling in the OpenThread task, churn and reports.
+ *
+ * nbr_monitor_process() runs in the application task and must not call
+ * the stack, the sampling job it posts runs with the stack lock held. The
+ * source is included to reach the CLI handler.
+ */
+
+#include "nbr_monitor.c"
+#include "host_test.h"
+#include "ot_mock.h"
+#include "timers.h"
+
+#define SAMPLE pdMS_TO_TICKS(NBR_MONITOR_SAMPLE_MS)
+
+static int quiet(const char* fmt, ...) {
+    (void)fmt;
+    return 0;
+}
+
+static otNeighborInfo* nbr_add(uint8_t id, bool child, int8_t rssi) {
+    otNeighborInfo* n = &g_ot_mock_neighbor[g_ot_mock_neighbor_num++];
+
+    memset(n, 0, sizeof(*n));
+    n->mExtAddress.m8[7] = id;
+    n->mRloc16 = child ? 0x0400 + id : (uint16_t)(id << 10);
+    n->mIsChild = child;
+    n->mRxOnWhenIdle = !child;
+    n->mFullThreadDevice = !child;
+    n->mLastRssi = rssi;
+    n->mLinkQualityIn = 3;
+    return n;
+}
+
+/* as the neighbor table callback in the OpenThread task */
+static void event(otNeighborTableEvent ev, const otNeighborInfo* n) {
+    otNeighborTableEntryInfo info;
+
+    memset(&info, 0, sizeof(info));
+    if (ev <= OT_NEIGHBOR_TABLE_EVENT_CHILD_MODE_CHANGED) {
+        info.mInfo.mChild.mExtAddress = n->mExtAddress;
+        info.mInfo.mChild.mRloc16 = n->mRloc16;
+        info.mInfo.mChild.mRxOnWhenIdle = n->mRxOnWhenIdle;
+    } else {
+        info.mInfo.mRouter = *n;
+    }
+    otrLock();
+    nbr_monitor_neighbor_event(ev, &info);
+    otrUnlock();
+}
+
+/* one sampling period in the application task, then the OpenThread task */
+static void period(void) {
+    stub_timers_advance(SAMPLE);
+    nbr_monitor_process();
+    CHECK_EQ(g_ot_mock.unlocked_calls, 0);
+    CHECK(ot_mock_jobs_pending() != 0);
+    ot_mock_run_jobs();
+}
+
+static const nbr_monitor_entry_t* find(const nbr_monitor_entry_t* t,
+                                       uint8_t num, uint8_t id) {
+    uint8_t i;
+
+    for (i = 0; i < num; i++) {
+        if (t[i].ext_addr.m8[7] == id) {
+            return &t[i];
+        }
+    }
+    return NULL;
+}
+
+static void setup(void) {
+    static int opened;
+
+    if (!opened) {
+        app_ot_job_init(otrGetInstance());
+        otrLock();
+        app_sockInit(otrGetInstance(), NULL, 5678);
+        nbr_monitor_init(otrGetInstance());
+        otrUnlock();
+        opened = 1;
+    }
+    nbr_monitor_collector_set(NULL);
+    app_udpFlush();
+    ot_mock_reset();
+    nbr_monitor_reset();
+    s_sample_tick = xTaskGetTickCount();
+}
+
+static void no_job(otInstance* instance) { (void)instance; }
+
+/* without a job slot the monitor stays off, and its API with it */
+static void test_no_job_slot(void) {
+    nbr_monitor_entry_t t[1];
+    nbr_monitor_stats_t stats;
+
+    app_ot_job_init(otrGetInstance());
+    while (app_ot_job_register(no_job) >= 0) {
+    }
+    otrLock();
+    nbr_monitor_init(otrGetInstance());
+    otrUnlock();
+    CHECK(s_lock == NULL);
+
+    nbr_monitor_collector_set(NULL);
+    nbr_monitor_reset();
+    CHECK_EQ(nbr_monitor_table_get(t, 1), 0);
+    memset(&stats, 0xff, sizeof(stats));
+    nbr_monitor_stats_get(&stats);
+    CHECK_EQ(stats.role_changed, 0);
+    nbr_monitor_role_changed(OT_DEVICE_ROLE_DETACHED);
+    stub_timers_advance(SAMPLE);
+    nbr_monitor_process();
+    CHECK_EQ(ot_mock_jobs_pending(), 0);
+}
+
+static void test_sample_in_ot_task(void) {
+    nbr_monitor_entry_t t[NBR_MONITOR_MAX];
+    const nbr_monitor_entry_t* e;
+    uint8_t num;
+
+    setup();
+    event(OT_NEIGHBOR_TABLE_EVENT_ROUTER_ADDED, nbr_add(1, false, -60));
+    event(OT_NEIGHBOR_TABLE_EVENT_CHILD_ADDED, nbr_add(2, true, -80));
+
+    /* not due yet, nothing posted */
+    stub_timers_advance(SAMPLE - 1);
+    nbr_monitor_process();
+    CHECK_EQ(ot_mock_jobs_pending(), 0);
+
+    stub_timers_advance(1);
+    nbr_monitor_process();
+    CHECK_EQ(g_ot_mock.unlocked_calls, 0);
+    num = nbr_monitor_table_get(t, NBR_MONITOR_MAX);
+    CHECK_EQ(num, 2);
+    CHECK_EQ(t[0].samples, 0);
+
+    CHECK_EQ(ot_mock_run_jobs(), 1);
+    num = nbr_monitor_table_get(t, NBR_MONITOR_MAX);
+    e = find(t, num, 1);
+    CHECK(e && e->samples == 1 && e->rssi_last == -60);
+    CHECK(e && e->rssi_avg == -60 * 16);
+    CHECK(e && !(e->flags & NBR_MONITOR_FLAG_CHILD));
+    e = find(t, num, 2);
+    CHECK(e && e->samples == 1 && (e->flags & NBR_MONITOR_FLAG_CHILD));
+
+    CHECK_EQ(g_ot_mock.unlocked_calls, 0);
+    CHECK_EQ(g_ot_mock.lock_order, 0);
+    CHECK_EQ(g_stub_mutex_held, 0);
+}
+
+/* a neighbor seen only by sampling is added, one gone without an event
+ * leaves */
+static void test_churn(void) {
+    nbr_monitor_entry_t t[NBR_MONITOR_MAX];
+    const nbr_monitor_entry_t* e;
+    uint8_t num;
+
+    setup();
+    event(OT_NEIGHBOR_TABLE_EVENT_ROUTER_ADDED, nbr_add(1, false, -60));
+    nbr_add(3, false, -70);
+    period();
+    num = nbr_monitor_table_get(t, NBR_MONITOR_MAX);
+    CHECK_EQ(num, 2);
+    e = find(t, num, 3);
+    CHECK(e && (e->flags & NBR_MONITOR_FLAG_PRESENT) && e->joins == 1);
+
+    g_ot_mock_neighbor_num = 1;
+    period();
+    num = nbr_monitor_table_get(t, NBR_MONITOR_MAX);
+    e = find(t, num, 3);
+    CHECK(e && !(e->flags & NBR_MONITOR_FLAG_PRESENT) && e->leaves == 1);
+    /* present neighbors are listed first */
+    CHECK_EQ(t[0].ext_addr.m8[7], 1);
+
+    event(OT_NEIGHBOR_TABLE_EVENT_ROUTER_REMOVED, &g_ot_mock_neighbor[0]);
+    num = nbr_monitor_table_get(t, NBR_MONITOR_MAX);
+    e = find(t, num, 1);
+    CHECK(e && !(e->flags & NBR_MONITOR_FLAG_PRESENT));
+}
+
+/* detached, the job runs but the table is not sampled */
+static void test_detached(void) {
+    nbr_monitor_entry_t t[NBR_MONITOR_MAX];
+    uint8_t num;
+
+    setup();
+    event(OT_NEIGHBOR_TABLE_EVENT_ROUTER_ADDED, nbr_add(1, false, -60));
+    g_ot_mock.role = OT_DEVICE_ROLE_DETACHED;
+    period();
+    num = nbr_monitor_table_get(t, NBR_MONITOR_MAX);
+    CHECK_EQ(num, 1);
+    CHECK_EQ(t[0].samples, 0);
+    CHECK_EQ(g_ot_mock.unlocked_calls, 0);
+}
+
+static void test_report(void) {
+    static char* argv[] = {"nbrmon", "collector", "fd00::1"};
+    nbr_monitor_record_t r;
+    nbr_monitor_stats_t stats;
+    otIp6Address collector;
+    uint8_t i;
+
+    setup();
+    nbr_add(1, false, -60);
+    nbr_add(2, true, -75);
+    CHECK_EQ(_cli_cmd_nbrmon(3, argv, quiet, NULL), 0);
+    otIp6AddressFromString("fd00::1", &collector);
+
+    for (i = 0; i < NBR_MONITOR_REPORT_SAMPLES - 1; i++) {
+        period();
+    }
+    app_udpFlush();
+    CHECK_EQ(g_ot_mock_sent_num, 0);
+
+    period();
+    app_udpFlush();
+    CHECK_EQ(g_ot_mock_sent_num, 1);
+    CHECK(!memcmp(&g_ot_mock_sent[0].dst, &collector, sizeof(collector)));
+    /* two records in one batch */
+    CHECK_EQ(g_ot_mock_sent[0].len, 1 + 2 * (1 + sizeof(r)));
+    memcpy(&r, &g_ot_mock_sent[0].data[2], sizeof(r));
+    CHECK_EQ(r.type, NBR_MONITOR_RECORD_TYPE);
+    CHECK_EQ(r.ext_addr[7], 1);
+    CHECK_EQ(r.rssi_last, -60);
+
+    nbr_monitor_stats_get(&stats);
+    CHECK_EQ(stats.reports, 1);
+    CHECK_EQ(stats.report_failed, 0);
+    CHECK_EQ(g_ot_mock.unlocked_calls, 0);
+    CHECK_EQ(g_ot_mock.lock_order, 0);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_no_job_slot);
+    HOST_TEST_RUN(test_sample_in_ot_task);
+    HOST_TEST_RUN(test_churn);
+    HOST_TEST_RUN(test_detached);
+    HOST_TEST_RUN(test_report);
+    return HOST_TEST_END();
+}
@@ -0,0 +1,22 @@
+/**
+ * @file hosal_swi.h
+ * @brief Host stand-in for the software interrupt, a trigger runs the
+ *        registered callback at once, in interrupt context.
+ */
+
+#ifndef __NCP_MOCK_HOSAL_SWI_H
+#define __NCP_MOCK_HOSAL_SWI_H
+
+#include <stdint.h>
+
+#define HOSAL_SWI0_ID 0
+#define HOSAL_TRIG_0  0
+#define HOSAL_TRIG_1  1
+
+typedef void (*hosal_swi_cb_fn)(uint32_t sw_id);
+
+int hosal_swi_callback_register(uint32_t swi_id, uint32_t trig,
+                                hosal_swi_cb_fn cb);
+int hosal_swi_trigger(uint32_t swi_id, uint32_t trig);
+
+#endif // __NCP_MOCK_HOSAL_SWI_H
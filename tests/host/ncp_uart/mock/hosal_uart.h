@@ -0,0 +1,57 @@
+/**
+ * @file hosal_uart.h
+ * @brief Host stand-in for the HOSAL UART of the NCP transport: receive
+ *        reads the mock wire, a DMA start is recorded for the test to
+ *        complete, the interrupt enable is a flag.
+ */
+
+#ifndef __NCP_MOCK_HOSAL_UART_H
+#define __NCP_MOCK_HOSAL_UART_H
+
+#include <stdint.h>
+
+#define UART_BAUDRATE_115200  115200
+#define UART_BAUDRATE_500000  500000
+#define UART_BAUDRATE_1000000 1000000
+#define UART_BAUDRATE_2000000 2000000
+
+#define UART_HWFC_DISABLED 0
+#define UART_HWFC_ENABLED  1
+
+typedef struct {
+    uint8_t uart_id;
+    uint8_t tx_pin;
+    uint8_t rx_pin;
+    uint32_t baud_rate;
+    uint8_t flow_control;
+} hosal_uart_config_t;
+
+typedef struct {
+    hosal_uart_config_t config;
+} hosal_uart_dev_t;
+
+typedef struct {
+    uint8_t* dma_buf;
+    uint32_t dma_buf_size;
+} hosal_uart_dma_cfg_t;
+
+#define HOSAL_UART_DEV_DECL(dev, id, tx, rx, baud)                             \
+    hosal_uart_dev_t dev = {                                                   \
+        .config = {.uart_id = (id), .tx_pin = (tx), .rx_pin = (rx),            \
+                   .baud_rate = (baud)},                                       \
+    };
+
+enum {
+    HOSAL_UART_MODE_SET,
+    HOSAL_UART_DMA_TX_START,
+    HOSAL_UART_ENABLE_INTERRUPT,
+    HOSAL_UART_DISABLE_INTERRUPT,
+};
+
+#define HOSAL_UART_MODE_INT_RX 1
+
+int hosal_uart_init(hosal_uart_dev_t* dev);
+int hosal_uart_receive(hosal_uart_dev_t* dev, void* data, uint32_t size);
+int hosal_uart_ioctl(hosal_uart_dev_t* dev, int ctl, void* p_arg);
+
+#endif // __NCP_MOCK_HOSAL_UART_H
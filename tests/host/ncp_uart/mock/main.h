@@ -0,0 +1,25 @@
+/**
+ * @file main.h
+ * @brief Host stand-in for the OpenThread NCP calls of the miu-sniffer
+ *        transport. The HDLC decoder and encoder are the test's.
+ */
+
+#ifndef __NCP_MOCK_MAIN_H
+#define __NCP_MOCK_MAIN_H
+
+#include <stdint.h>
+
+typedef struct otInstance otInstance;
+
+typedef int (*otNcpHdlcSendCallback)(const uint8_t* aBuf,
+                                     uint16_t aBufLength);
+
+#define OT_LOG_LEVEL_NONE 0
+
+void otNcpHdlcInit(otInstance* aInstance, otNcpHdlcSendCallback aSendCallback);
+void otNcpHdlcReceive(const uint8_t* aBuf, uint16_t aBufLength);
+void otNcpHdlcSendDone(void);
+int otLoggingSetLevel(int aLogLevel);
+void otAppCliInit(otInstance* aInstance);
+
+#endif // __NCP_MOCK_MAIN_H
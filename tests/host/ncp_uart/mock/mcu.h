@@ -0,0 +1,44 @@
+/**
+ * @file mcu.h
+ * @brief Host stand-in for the UART registers and NVIC calls used by the
+ *        miu-sniffer NCP transport. UART0 and UART1 are plain structs the
+ *        test sets before calling the interrupt handler.
+ */
+
+#ifndef __NCP_MOCK_MCU_H
+#define __NCP_MOCK_MCU_H
+
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t IIR;
+    volatile uint32_t LSR;
+    volatile uint32_t xDMA_INT_STATUS;
+    volatile uint32_t xDMA_TX_ENABLE;
+} uart_t;
+
+extern uart_t g_mock_uart[2];
+
+#define UART0 (&g_mock_uart[0])
+#define UART1 (&g_mock_uart[1])
+
+#define IIR_INTID_MSK 0x0F
+#define IIR_INTID_RDA 0x04
+#define IIR_INTID_CTI 0x0C
+#define UART_LSR_DR   0x01
+#define xDMA_ISR_TX   0x01
+#define xDMA_Stop     0
+
+typedef enum {
+    Uart0_IRQn,
+    Uart1_IRQn,
+    Soft_IRQn,
+} IRQn_Type;
+
+#define NVIC_ClearPendingIRQ(irq)    ((void)(irq))
+#define NVIC_SetPriority(irq, prio)  ((void)(irq), (void)(prio))
+
+#define enter_critical_section() ((void)0)
+#define leave_critical_section() ((void)0)
+
+#endif // __NCP_MOCK_MCU_H
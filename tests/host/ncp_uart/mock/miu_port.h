@@ -0,0 +1,4 @@
+/**
+ * @file miu_port.h
+ * @brief Host stand-in, the NCP transport needs nothing of the port
+ */
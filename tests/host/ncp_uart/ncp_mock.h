@@ -0,0 +1,24 @@
+/**
+ * @file ncp_mock.h
+ * @brief Task notification and creation calls of the NCP transport, forced
+ *        into ncp.c. The test stands in for the task and the interrupts.
+ */
+
+#ifndef __NCP_MOCK_H
+#define __NCP_MOCK_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define configMAX_PRIORITIES 32
+
+typedef void (*TaskFunction_t)(void* arg);
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char* name, uint32_t depth,
+                       void* arg, UBaseType_t prio, TaskHandle_t* handle);
+BaseType_t xPortIsInsideInterrupt(void);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait);
+
+#endif // __NCP_MOCK_H
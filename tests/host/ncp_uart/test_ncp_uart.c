@@ -0,0 +1,418 @@
+/**
+ * @file test_ncp_uart.c
+ * @brief Loopback of the miu-sniffer NCP UART transport over a mock wire:
+ *        the host writes frames into the RX FIFO, the test's decoder
+ *        echoes every frame through the transport and the mock DMA puts
+ *        the TX transfers on the wire back.
+ *
+ * Interrupts, the DMA completion and the NCP task are stepped by the test,
+ * fast or slow, so frames of 1500 bytes and more go out in several DMA
+ * transfers, the RX ring wraps and fills, and with
+ * CONFIG_APP_OT_NCP_OPERATION_UART_FLOW_CONTROL 1 the RX interrupt is held
+ * off. The echo has to come back whole and in order with one send-done per
+ * send; without flow control the bytes lost on a full ring are counted.
+ *
+ * Frames are a 16 bit little endian length and the payload. The source is
+ * included so the ring and the counters can be checked directly.
+ */
+
+#include <stdlib.h>
+#include "ncp.c"
+#include "host_test.h"
+
+#define FIFO_SIZE   32
+#define FRAME_NUM   64
+#define STREAM_MAX  (FRAME_NUM * 2100)
+#define ENC_MAX     2100
+
+typedef struct {
+    uint32_t push_max;    /* bytes the host may write per step */
+    uint32_t task_every;  /* mean steps between runs of the NCP task */
+    uint32_t dma_every;   /* mean steps per DMA transfer */
+} sched_t;
+
+uart_t g_mock_uart[2];
+
+/* host to device */
+static uint8_t s_host[STREAM_MAX];
+static uint32_t s_host_len, s_host_pos;
+static uint8_t s_fifo[FIFO_SIZE];
+static uint32_t s_fifo_len;
+static int s_irq_enabled;
+
+/* device to host, one DMA transfer in flight at a time */
+static uint8_t s_wire[STREAM_MAX];
+static uint32_t s_wire_len;
+static const uint8_t* s_dma_buf;
+static uint8_t s_dma_snap[OT_NCP_UART_TX_BUF_SIZE];
+static uint32_t s_dma_len;
+static uint32_t s_dma_overlap;
+
+static hosal_swi_cb_fn s_swi_cb[2];
+static int s_in_isr;
+static uint32_t s_notified;
+static uint32_t s_isr_notify_in_task;
+
+/* the decoder gets the ring in place, the encoder echoes each frame */
+static otNcpHdlcSendCallback s_send;
+static uint8_t s_rx[STREAM_MAX];
+static uint32_t s_rx_len, s_rx_parsed;
+static uint32_t s_rx_wrap_segments;
+static uint32_t s_echo_off[FRAME_NUM * 4], s_echo_len[FRAME_NUM * 4];
+static uint32_t s_echo_num, s_echo_next;
+static uint8_t s_enc_buf[ENC_MAX];
+static int s_enc_busy;
+static uint32_t s_sends, s_dones, s_done_unowed;
+
+//=============================================================================
+//                  Mocks
+//=============================================================================
+int hosal_uart_init(hosal_uart_dev_t* dev) { return 0; }
+
+int hosal_uart_receive(hosal_uart_dev_t* dev, void* data, uint32_t size) {
+    uint32_t n = size < s_fifo_len ? size : s_fifo_len;
+
+    memcpy(data, s_fifo, n);
+    memmove(s_fifo, s_fifo + n, s_fifo_len - n);
+    s_fifo_len -= n;
+    return (int)n;
+}
+
+int hosal_uart_ioctl(hosal_uart_dev_t* dev, int ctl, void* p_arg) {
+    hosal_uart_dma_cfg_t* cfg = p_arg;
+
+    switch (ctl) {
+    case HOSAL_UART_DMA_TX_START:
+        if (s_dma_buf) {
+            s_dma_overlap++;
+        }
+        s_dma_buf = cfg->dma_buf;
+        s_dma_len = cfg->dma_buf_size;
+        memcpy(s_dma_snap, cfg->dma_buf, s_dma_len);
+        break;
+    case HOSAL_UART_ENABLE_INTERRUPT:
+        s_irq_enabled = 1;
+        break;
+    case HOSAL_UART_DISABLE_INTERRUPT:
+        s_irq_enabled = 0;
+        break;
+    default:
+        break;
+    }
+    return 0;
+}
+
+int hosal_swi_callback_register(uint32_t swi_id, uint32_t trig,
+                                hosal_swi_cb_fn cb) {
+    s_swi_cb[trig] = cb;
+    return 0;
+}
+
+int hosal_swi_trigger(uint32_t swi_id, uint32_t trig) {
+    int in_isr = s_in_isr;
+
+    s_in_isr = 1;
+    s_swi_cb[trig](trig);
+    s_in_isr = in_isr;
+    return 0;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char* name, uint32_t depth,
+                       void* arg, UBaseType_t prio, TaskHandle_t* handle) {
+    static stub_task_t task = {"ncp_uart"};
+
+    *handle = &task;
+    return pdPASS;
+}
+
+BaseType_t xPortIsInsideInterrupt(void) { return s_in_isr; }
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    if (s_in_isr) {
+        s_isr_notify_in_task++;
+    }
+    s_notified++;
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken) {
+    if (!s_in_isr) {
+        s_isr_notify_in_task++;
+    }
+    s_notified++;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait) { return 0; }
+
+int otLoggingSetLevel(int aLogLevel) { return 0; }
+
+void otAppCliInit(otInstance* aInstance) {}
+
+void otNcpHdlcInit(otInstance* aInstance, otNcpHdlcSendCallback aSendCallback) {
+    s_send = aSendCallback;
+}
+
+static void encoder_kick(void) {
+    uint32_t len;
+
+    if (s_enc_busy || s_echo_next == s_echo_num) {
+        return;
+    }
+    len = s_echo_len[s_echo_next];
+    memcpy(s_enc_buf, &s_rx[s_echo_off[s_echo_next]], len);
+    s_echo_next++;
+    s_enc_busy = 1;
+    s_sends++;
+    s_send(s_enc_buf, (uint16_t)len);
+}
+
+void otNcpHdlcSendDone(void) {
+    if (!s_enc_busy) {
+        s_done_unowed++;
+        return;
+    }
+    s_dones++;
+    s_enc_busy = 0;
+    /* the buffer is the encoder's again, a later copy out would show */
+    memset(s_enc_buf, 0xEE, sizeof(s_enc_buf));
+    encoder_kick();
+}
+
+void otNcpHdlcReceive(const uint8_t* aBuf, uint16_t aBufLength) {
+    uint32_t len;
+
+    if (aBuf + aBufLength == g_uart_io.rx_cache + OT_NCP_UART_RX_RING_SIZE) {
+        s_rx_wrap_segments++;
+    }
+    if (s_rx_len + aBufLength > sizeof(s_rx)) {
+        aBufLength = (uint16_t)(sizeof(s_rx) - s_rx_len);
+    }
+    memcpy(&s_rx[s_rx_len], aBuf, aBufLength);
+    s_rx_len += aBufLength;
+
+    /* whole frames go back out, anything longer is the framing lost on
+     * a full ring and is not echoed */
+    while (s_rx_len - s_rx_parsed >= 2) {
+        len = 2 + (s_rx[s_rx_parsed] | (s_rx[s_rx_parsed + 1] << 8));
+        if (s_rx_len - s_rx_parsed < len) {
+            break;
+        }
+        if (len <= ENC_MAX && s_echo_num < FRAME_NUM * 4) {
+            s_echo_off[s_echo_num] = s_rx_parsed;
+            s_echo_len[s_echo_num] = len;
+            s_echo_num++;
+        }
+        s_rx_parsed += len;
+    }
+    encoder_kick();
+}
+
+//=============================================================================
+//                  Wire and scheduling
+//=============================================================================
+static const uint16_t s_frame_sizes[] = {
+    1500, 3, 1600, 511, 512, 513, 2047, 1, 100, 1024, 1800, 64,
+};
+
+#define FRAME_SIZE_NUM (sizeof(s_frame_sizes) / sizeof(s_frame_sizes[0]))
+
+static void reset(void) {
+    memset(&g_uart_io, 0, sizeof(g_uart_io));
+    memset(&g_uart_tx, 0, sizeof(g_uart_tx));
+    memset(&g_uart_stats, 0, sizeof(g_uart_stats));
+    g_ot_ncp_uart_evt_var = OT_NCP_UART_EVENT_NONE;
+    memset(g_mock_uart, 0, sizeof(g_mock_uart));
+
+    s_host_len = s_host_pos = 0;
+    s_fifo_len = 0;
+    s_irq_enabled = 1;
+    s_wire_len = 0;
+    s_dma_buf = NULL;
+    s_dma_overlap = 0;
+    s_notified = 0;
+    s_isr_notify_in_task = 0;
+    s_rx_len = s_rx_parsed = 0;
+    s_rx_wrap_segments = 0;
+    s_echo_num = s_echo_next = 0;
+    s_enc_busy = 0;
+    s_sends = s_dones = s_done_unowed = 0;
+
+    otrInitUser(NULL);
+}
+
+static void host_frames(uint32_t num) {
+    uint32_t f, i, len;
+
+    for (f = 0; f < num; f++) {
+        len = s_frame_sizes[f % FRAME_SIZE_NUM];
+        s_host[s_host_len++] = (uint8_t)len;
+        s_host[s_host_len++] = (uint8_t)(len >> 8);
+        for (i = 0; i < len; i++) {
+            s_host[s_host_len++] = (uint8_t)(f * 31 + i);
+        }
+    }
+}
+
+/* the host stops on RTS, the FIFO full, only with flow control; without
+ * it the bytes are on the wire regardless and the handler has to keep up */
+static void host_push(uint32_t max) {
+    while (max-- && s_host_pos < s_host_len && s_fifo_len < FIFO_SIZE) {
+        s_fifo[s_fifo_len++] = s_host[s_host_pos++];
+    }
+}
+
+static void uart_irq(void) {
+    if (!s_irq_enabled || s_fifo_len == 0) {
+        return;
+    }
+    UART0->IIR = IIR_INTID_RDA;
+    UART0->LSR = UART_LSR_DR;
+    s_in_isr = 1;
+    uart0_handler();
+    s_in_isr = 0;
+    UART0->IIR = 0;
+}
+
+static void dma_complete(void) {
+    const uint8_t* buf = s_dma_buf;
+
+    if (!buf) {
+        return;
+    }
+    /* staging the next transfer must not touch the one in flight */
+    CHECK(memcmp(buf, s_dma_snap, s_dma_len) == 0);
+    memcpy(&s_wire[s_wire_len], buf, s_dma_len);
+    s_wire_len += s_dma_len;
+    s_dma_buf = NULL;
+
+    UART0->xDMA_INT_STATUS = xDMA_ISR_TX;
+    s_in_isr = 1;
+    uart0_handler();
+    s_in_isr = 0;
+    /* write one to clear */
+    UART0->xDMA_INT_STATUS = 0;
+}
+
+static void task_run(void) {
+    while (s_notified) {
+        s_notified = 0;
+        ot_ncp_uart_process();
+    }
+}
+
+/* irregular, so the ring fills and wraps at any offset */
+static void run(const sched_t* sched) {
+    uint32_t idle = 0;
+
+    while (idle < 1000) {
+        host_push(1 + (uint32_t)rand() % sched->push_max);
+        uart_irq();
+        if ((uint32_t)rand() % sched->dma_every == 0) {
+            dma_complete();
+        }
+        if ((uint32_t)rand() % sched->task_every == 0) {
+            task_run();
+        }
+        /* done once the host is out of bytes and nothing moves */
+        if (s_host_pos == s_host_len && s_fifo_len == 0 && !s_dma_buf
+            && !s_notified) {
+            idle++;
+        } else {
+            idle = 0;
+        }
+    }
+}
+
+static void check_loopback(void) {
+    CHECK_EQ(s_host_pos, s_host_len);
+    CHECK_EQ(s_rx_len, s_host_len);
+    CHECK_EQ(s_wire_len, s_host_len);
+    CHECK(memcmp(s_wire, s_host, s_host_len) == 0);
+    CHECK_EQ(s_echo_num, FRAME_NUM);
+    CHECK_EQ(s_sends, FRAME_NUM);
+    CHECK_EQ(s_dones, s_sends);
+    CHECK_EQ(s_done_unowed, 0);
+    CHECK(!s_enc_busy);
+    CHECK_EQ(s_dma_overlap, 0);
+    CHECK_EQ(s_isr_notify_in_task, 0);
+    CHECK_EQ(g_uart_stats.rx_dropped, 0);
+    CHECK_EQ(g_uart_stats.rx_bytes, s_host_len);
+    CHECK_EQ(g_uart_io.rd_idx, g_uart_io.wr_idx);
+}
+
+//=============================================================================
+//                  Tests
+//=============================================================================
+/* the task keeps up: every frame of 1500 bytes and more takes several
+ * DMA transfers, and the ring wraps many times over */
+static void test_loopback(void) {
+    const sched_t sched = {FIFO_SIZE, 1, 4};
+    uint32_t f, transfers = 0;
+
+    srand(1);
+    reset();
+    host_frames(FRAME_NUM);
+    run(&sched);
+    check_loopback();
+
+    for (f = 0; f < FRAME_NUM; f++) {
+        transfers += (2 + s_frame_sizes[f % FRAME_SIZE_NUM]
+                      + OT_NCP_UART_TX_BUF_SIZE - 1)
+                     / OT_NCP_UART_TX_BUF_SIZE;
+    }
+    CHECK(g_uart_stats.tx_dma >= transfers);
+    CHECK(g_uart_stats.tx_deferred > 0);
+    CHECK(g_uart_io.wr_idx > 8 * OT_NCP_UART_RX_RING_SIZE);
+    CHECK(s_rx_wrap_segments > 8);
+    printf("  %lu bytes, %lu dma, %lu deferred, rx peak %lu\n",
+           (unsigned long)s_host_len, (unsigned long)g_uart_stats.tx_dma,
+           (unsigned long)g_uart_stats.tx_deferred,
+           (unsigned long)g_uart_stats.rx_peak);
+}
+
+/* a slow wire out: sends wait on send-done, the frames still go back in
+ * order and one send-done each */
+static void test_slow_dma(void) {
+    const sched_t sched = {FIFO_SIZE, 1, 64};
+
+    srand(2);
+    reset();
+    host_frames(FRAME_NUM);
+    run(&sched);
+    check_loopback();
+}
+
+/* the task falls behind by far more than the ring: with flow control the
+ * RX interrupt is held off and nothing is lost, without it the bytes
+ * read on a full ring are counted */
+static void test_slow_task(void) {
+    const sched_t sched = {FIFO_SIZE, 600, 4};
+
+    srand(3);
+    reset();
+    host_frames(FRAME_NUM);
+    run(&sched);
+    CHECK_EQ(g_uart_stats.rx_peak, OT_NCP_UART_RX_RING_SIZE);
+#if (CONFIG_APP_OT_NCP_OPERATION_UART_FLOW_CONTROL == 1)
+    check_loopback();
+    CHECK(g_uart_stats.rx_pauses > 0);
+    CHECK(s_irq_enabled);
+#else
+    CHECK(g_uart_stats.rx_dropped > 0);
+    CHECK_EQ(g_uart_stats.rx_bytes + g_uart_stats.rx_dropped, s_host_len);
+    CHECK_EQ(s_rx_len, g_uart_stats.rx_bytes);
+    CHECK_EQ(s_dones, s_sends);
+    CHECK_EQ(s_done_unowed, 0);
+#endif
+    printf("  %lu pauses, %lu dropped\n",
+           (unsigned long)g_uart_stats.rx_pauses,
+           (unsigned long)g_uart_stats.rx_dropped);
+}
+
+int main(void) {
+    printf("flow control %d\n", CONFIG_APP_OT_NCP_OPERATION_UART_FLOW_CONTROL);
+    HOST_TEST_RUN(test_loopback);
+    HOST_TEST_RUN(test_slow_dma);
+    HOST_TEST_RUN(test_slow_task);
+    return HOST_TEST_END();
+}
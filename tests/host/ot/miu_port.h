@@ -0,0 +1,16 @@
+/**
+ * @file miu_port.h
+ * @brief Host stand-in for the OpenThread port: the instance and the stack
+ *        lock, which is recursive as on the target
+ */
+
+#ifndef __OT_MOCK_MIU_PORT_H
+#define __OT_MOCK_MIU_PORT_H
+
+#include "openthread/instance.h"
+
+otInstance* otrGetInstance(void);
+void otrLock(void);
+void otrUnlock(void);
+
+#endif // __OT_MOCK_MIU_PORT_H
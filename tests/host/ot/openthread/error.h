@@ -0,0 +1,19 @@
+/**
+ * @file error.h
+ * @brief Host stand-in for the OpenThread error codes used by the apps
+ */
+
+#ifndef __OT_MOCK_ERROR_H
+#define __OT_MOCK_ERROR_H
+
+typedef enum {
+    OT_ERROR_NONE = 0,
+    OT_ERROR_FAILED = 1,
+    OT_ERROR_NO_BUFS = 3,
+    OT_ERROR_BUSY = 5,
+    OT_ERROR_INVALID_ARGS = 7,
+    OT_ERROR_INVALID_STATE = 13,
+    OT_ERROR_NOT_FOUND = 23,
+} otError;
+
+#endif // __OT_MOCK_ERROR_H
@@ -0,0 +1,17 @@
+/**
+ * @file instance.h
+ * @brief Host stand-in, the instance is opaque to the apps
+ */
+
+#ifndef __OT_MOCK_INSTANCE_H
+#define __OT_MOCK_INSTANCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "openthread/error.h"
+
+typedef struct otInstance otInstance;
+
+#define OT_CHANGED_THREAD_ROLE (1U << 2)
+
+#endif // __OT_MOCK_INSTANCE_H
@@ -0,0 +1,28 @@
+/**
+ * @file ip6.h
+ * @brief Host stand-in for the IPv6 address and socket types
+ */
+
+#ifndef __OT_MOCK_IP6_H
+#define __OT_MOCK_IP6_H
+
+#include "openthread/instance.h"
+
+#define OT_IP6_ADDRESS_SIZE 16
+
+typedef struct {
+    union {
+        uint8_t m8[OT_IP6_ADDRESS_SIZE];
+        uint16_t m16[OT_IP6_ADDRESS_SIZE / 2];
+        uint32_t m32[OT_IP6_ADDRESS_SIZE / 4];
+    } mFields;
+} otIp6Address;
+
+typedef struct {
+    otIp6Address mAddress;
+    uint16_t mPort;
+} otSockAddr;
+
+otError otIp6AddressFromString(const char* string, otIp6Address* address);
+
+#endif // __OT_MOCK_IP6_H
@@ -0,0 +1,22 @@
+/**
+ * @file link.h
+ * @brief Host stand-in for the poll period call, with the range checks of
+ *        the stack, and the factory EUI-64
+ */
+
+#ifndef __OT_MOCK_LINK_H
+#define __OT_MOCK_LINK_H
+
+#include "openthread/instance.h"
+#include "openthread/thread.h"
+
+/* OPENTHREAD_CONFIG_MAC_MINIMUM_POLL_PERIOD and the largest period taken */
+#define OT_MOCK_POLL_PERIOD_MIN 10
+#define OT_MOCK_POLL_PERIOD_MAX 0x3FFFFFF
+
+otError otLinkSetPollPeriod(otInstance* instance, uint32_t period);
+
+void otLinkGetFactoryAssignedIeeeEui64(otInstance* instance,
+                                       otExtAddress* eui64);
+
+#endif // __OT_MOCK_LINK_H
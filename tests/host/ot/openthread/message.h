@@ -0,0 +1,46 @@
+/**
+ * @file message.h
+ * @brief Host stand-in for messages, each one flat buffer
+ */
+
+#ifndef __OT_MOCK_MESSAGE_H
+#define __OT_MOCK_MESSAGE_H
+
+#include "openthread/ip6.h"
+
+typedef struct otMessage otMessage;
+
+typedef enum {
+    OT_MESSAGE_PRIORITY_LOW = 0,
+    OT_MESSAGE_PRIORITY_NORMAL = 1,
+    OT_MESSAGE_PRIORITY_HIGH = 2,
+} otMessagePriority;
+
+typedef struct {
+    bool mLinkSecurityEnabled;
+    uint8_t mPriority;
+} otMessageSettings;
+
+typedef struct {
+    uint16_t mTotalBuffers;
+    uint16_t mFreeBuffers;
+} otBufferInfo;
+
+typedef struct {
+    otIp6Address mSockAddr;
+    otIp6Address mPeerAddr;
+    uint16_t mSockPort;
+    uint16_t mPeerPort;
+    uint8_t mHopLimit;
+    bool mAllowZeroHopLimit;
+} otMessageInfo;
+
+otError otMessageAppend(otMessage* message, const void* buf, uint16_t length);
+uint16_t otMessageRead(const otMessage* message, uint16_t offset, void* buf,
+                       uint16_t length);
+uint16_t otMessageGetLength(const otMessage* message);
+uint16_t otMessageGetOffset(const otMessage* message);
+void otMessageFree(otMessage* message);
+void otMessageGetBufferInfo(otInstance* instance, otBufferInfo* info);
+
+#endif // __OT_MOCK_MESSAGE_H
@@ -0,0 +1,52 @@
+/**
+ * @file thread.h
+ * @brief Host stand-in for the Thread role and neighbor table calls
+ */
+
+#ifndef __OT_MOCK_THREAD_H
+#define __OT_MOCK_THREAD_H
+
+#include "openthread/instance.h"
+
+typedef enum {
+    OT_DEVICE_ROLE_DISABLED = 0,
+    OT_DEVICE_ROLE_DETACHED = 1,
+    OT_DEVICE_ROLE_CHILD = 2,
+    OT_DEVICE_ROLE_ROUTER = 3,
+    OT_DEVICE_ROLE_LEADER = 4,
+} otDeviceRole;
+
+#define OT_EXT_ADDRESS_SIZE 8
+
+typedef struct {
+    uint8_t m8[OT_EXT_ADDRESS_SIZE];
+} otExtAddress;
+
+typedef struct {
+    otExtAddress mExtAddress;
+    uint32_t mAge;
+    uint16_t mRloc16;
+    uint32_t mLinkFrameCounter;
+    uint32_t mMleFrameCounter;
+    uint8_t mLinkQualityIn;
+    int8_t mAverageRssi;
+    int8_t mLastRssi;
+    uint16_t mFrameErrorRate;
+    uint16_t mMessageErrorRate;
+    bool mRxOnWhenIdle;
+    bool mFullThreadDevice;
+    bool mFullNetworkData;
+    bool mIsChild;
+} otNeighborInfo;
+
+typedef int16_t otNeighborInfoIterator;
+
+#define OT_NEIGHBOR_INFO_ITERATOR_INIT 0
+
+otDeviceRole otThreadGetDeviceRole(otInstance* instance);
+uint32_t otThreadGetChildTimeout(otInstance* instance);
+otError otThreadGetNextNeighborInfo(otInstance* instance,
+                                    otNeighborInfoIterator* iterator,
+                                    otNeighborInfo* info);
+
+#endif // __OT_MOCK_THREAD_H
@@ -0,0 +1,44 @@
+/**
+ * @file thread_ftd.h
+ * @brief Host stand-in for the child info and neighbor table events
+ */
+
+#ifndef __OT_MOCK_THREAD_FTD_H
+#define __OT_MOCK_THREAD_FTD_H
+
+#include "openthread/thread.h"
+
+typedef struct {
+    otExtAddress mExtAddress;
+    uint32_t mTimeout;
+    uint32_t mAge;
+    uint16_t mRloc16;
+    uint16_t mChildId;
+    uint8_t mNetworkDataVersion;
+    uint8_t mLinkQualityIn;
+    int8_t mAverageRssi;
+    int8_t mLastRssi;
+    uint16_t mFrameErrorRate;
+    uint16_t mMessageErrorRate;
+    bool mRxOnWhenIdle;
+    bool mFullThreadDevice;
+    bool mFullNetworkData;
+} otChildInfo;
+
+typedef enum {
+    OT_NEIGHBOR_TABLE_EVENT_CHILD_ADDED,
+    OT_NEIGHBOR_TABLE_EVENT_CHILD_REMOVED,
+    OT_NEIGHBOR_TABLE_EVENT_CHILD_MODE_CHANGED,
+    OT_NEIGHBOR_TABLE_EVENT_ROUTER_ADDED,
+    OT_NEIGHBOR_TABLE_EVENT_ROUTER_REMOVED,
+} otNeighborTableEvent;
+
+typedef struct {
+    otInstance* mInstance;
+    union {
+        otChildInfo mChild;
+        otNeighborInfo mRouter;
+    } mInfo;
+} otNeighborTableEntryInfo;
+
+#endif // __OT_MOCK_THREAD_FTD_H
@@ -0,0 +1,36 @@
+/**
+ * @file udp.h
+ * @brief Host stand-in for the UDP socket calls
+ */
+
+#ifndef __OT_MOCK_UDP_H
+#define __OT_MOCK_UDP_H
+
+#include "openthread/message.h"
+
+typedef void (*otUdpReceive)(void* context, otMessage* message,
+                             const otMessageInfo* info);
+
+typedef enum {
+    OT_NETIF_UNSPECIFIED = 0,
+    OT_NETIF_THREAD_HOST,
+    OT_NETIF_THREAD_INTERNAL,
+    OT_NETIF_BACKBONE,
+} otNetifIdentifier;
+
+typedef struct {
+    otSockAddr mSockName;
+    otUdpReceive mHandler;
+    void* mContext;
+} otUdpSocket;
+
+otMessage* otUdpNewMessage(otInstance* instance,
+                           const otMessageSettings* settings);
+otError otUdpOpen(otInstance* instance, otUdpSocket* socket,
+                  otUdpReceive callback, void* context);
+otError otUdpBind(otInstance* instance, otUdpSocket* socket,
+                  const otSockAddr* name, otNetifIdentifier netif);
+otError otUdpSend(otInstance* instance, otUdpSocket* socket,
+                  otMessage* message, const otMessageInfo* info);
+
+#endif // __OT_MOCK_UDP_H
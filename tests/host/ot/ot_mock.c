@@ -0,0 +1,299 @@
+/**
+ * @file ot_mock.c
+ * @brief Host stand-in for the OpenThread calls of the mesh-it-up apps, the
+ *        stack lock of the port and the app_ot_job tasklet.
+ */
+
+#include <arpa/inet.h>
+#include <string.h>
+#include "app_ot_job.h"
+#include "miu_port.h"
+#include "ot_mock.h"
+#include "semphr.h"
+#include "timers.h"
+
+struct otInstance {
+    int unused;
+};
+
+struct otMessage {
+    uint8_t used;
+    uint16_t len;
+    uint16_t offset;
+    uint8_t buf[OT_MOCK_MESSAGE_LEN];
+};
+
+ot_mock_t g_ot_mock;
+ot_mock_sent_t g_ot_mock_sent[OT_MOCK_SENT_MAX];
+uint32_t g_ot_mock_sent_num;
+otNeighborInfo g_ot_mock_neighbor[OT_MOCK_NEIGHBOR_MAX];
+uint32_t g_ot_mock_neighbor_num;
+
+static otInstance s_instance;
+static otMessage s_messages[OT_MOCK_MESSAGE_MAX];
+static otUdpSocket* s_socket;
+static app_ot_job_fn_t s_jobs[APP_OT_JOB_MAX];
+static uint32_t s_job_num;
+static uint32_t s_jobs_pending;
+
+void ot_mock_reset(void) {
+    memset(&g_ot_mock, 0, sizeof(g_ot_mock));
+    memset(s_messages, 0, sizeof(s_messages));
+    g_ot_mock.free_buffers = 64;
+    g_ot_mock.role = OT_DEVICE_ROLE_ROUTER;
+    g_ot_mock.child_timeout = 240;
+    g_ot_mock_sent_num = 0;
+    g_ot_mock_neighbor_num = 0;
+    s_jobs_pending = 0;
+}
+
+void ot_mock_call(void) {
+    if (g_ot_mock.lock_depth == 0) {
+        g_ot_mock.unlocked_calls++;
+    }
+    if (g_stub_in_timer) {
+        g_ot_mock.timer_calls++;
+    }
+}
+
+otInstance* otrGetInstance(void) { return &s_instance; }
+
+void otrLock(void) {
+    if (g_ot_mock.lock_depth == 0 && g_stub_mutex_held > 0) {
+        g_ot_mock.lock_order++;
+    }
+    g_ot_mock.lock_depth++;
+}
+
+void otrUnlock(void) {
+    configASSERT(g_ot_mock.lock_depth > 0);
+    g_ot_mock.lock_depth--;
+}
+
+void app_ot_job_init(otInstance* instance) {
+    (void)instance;
+    s_job_num = 0;
+    s_jobs_pending = 0;
+}
+
+int app_ot_job_register(app_ot_job_fn_t fn) {
+    if (!fn || s_job_num == APP_OT_JOB_MAX) {
+        return -1;
+    }
+    s_jobs[s_job_num] = fn;
+    return (int)s_job_num++;
+}
+
+void app_ot_job_post(int job) {
+    if (job >= 0 && (uint32_t)job < s_job_num) {
+        s_jobs_pending |= 1UL << job;
+    }
+}
+
+uint32_t ot_mock_run_jobs(void) {
+    uint32_t pending, i, num = 0;
+
+    otrLock();
+    while (s_jobs_pending) {
+        pending = s_jobs_pending;
+        s_jobs_pending = 0;
+        for (i = 0; i < s_job_num; i++) {
+            if (pending & (1UL << i)) {
+                s_jobs[i](&s_instance);
+                num++;
+            }
+        }
+    }
+    otrUnlock();
+    return num;
+}
+
+uint32_t ot_mock_jobs_pending(void) { return s_jobs_pending; }
+
+uint32_t ot_mock_messages_used(void) {
+    uint32_t i, num = 0;
+
+    for (i = 0; i < OT_MOCK_MESSAGE_MAX; i++) {
+        num += s_messages[i].used;
+    }
+    return num;
+}
+
+void ot_mock_udp_deliver(const void* data, uint16_t len,
+                         const otIp6Address* peer, uint16_t port) {
+    otMessageInfo info;
+    otMessage* message = &s_messages[OT_MOCK_MESSAGE_MAX - 1];
+
+    configASSERT(s_socket && !message->used && len <= OT_MOCK_MESSAGE_LEN - 8);
+    memset(&info, 0, sizeof(info));
+    info.mPeerAddr = *peer;
+    info.mPeerPort = port;
+    info.mSockPort = s_socket->mSockName.mPort;
+
+    /* behind a UDP header, as the stack hands it over */
+    message->used = 1;
+    message->offset = 8;
+    message->len = 8 + len;
+    memcpy(&message->buf[8], data, len);
+
+    otrLock();
+    s_socket->mHandler(s_socket->mContext, message, &info);
+    otrUnlock();
+    message->used = 0;
+}
+
+otError otMessageAppend(otMessage* message, const void* buf, uint16_t length) {
+    ot_mock_call();
+    if (message->len + length > OT_MOCK_MESSAGE_LEN) {
+        return OT_ERROR_NO_BUFS;
+    }
+    memcpy(&message->buf[message->len], buf, length);
+    message->len += length;
+    return OT_ERROR_NONE;
+}
+
+uint16_t otMessageRead(const otMessage* message, uint16_t offset, void* buf,
+                       uint16_t length) {
+    ot_mock_call();
+    if (offset >= message->len) {
+        return 0;
+    }
+    if (length > message->len - offset) {
+        length = message->len - offset;
+    }
+    memcpy(buf, &message->buf[offset], length);
+    return length;
+}
+
+uint16_t otMessageGetLength(const otMessage* message) {
+    ot_mock_call();
+    return message->len;
+}
+
+uint16_t otMessageGetOffset(const otMessage* message) {
+    ot_mock_call();
+    return message->offset;
+}
+
+void otMessageFree(otMessage* message) {
+    ot_mock_call();
+    configASSERT(message->used);
+    message->used = 0;
+}
+
+void otMessageGetBufferInfo(otInstance* instance, otBufferInfo* info) {
+    (void)instance;
+    ot_mock_call();
+    memset(info, 0, sizeof(*info));
+    info->mTotalBuffers = 64;
+    info->mFreeBuffers = g_ot_mock.free_buffers;
+}
+
+otMessage* otUdpNewMessage(otInstance* instance,
+                           const otMessageSettings* settings) {
+    uint32_t i;
+
+    (void)instance;
+    (void)settings;
+    ot_mock_call();
+    if (g_ot_mock.alloc_fail) {
+        return NULL;
+    }
+    for (i = 0; i < OT_MOCK_MESSAGE_MAX - 1; i++) {
+        if (!s_messages[i].used) {
+            s_messages[i].used = 1;
+            s_messages[i].len = 0;
+            s_messages[i].offset = 0;
+            return &s_messages[i];
+        }
+    }
+    return NULL;
+}
+
+otError otUdpOpen(otInstance* instance, otUdpSocket* socket,
+                  otUdpReceive callback, void* context) {
+    (void)instance;
+    ot_mock_call();
+    socket->mHandler = callback;
+    socket->mContext = context;
+    s_socket = socket;
+    return OT_ERROR_NONE;
+}
+
+otError otUdpBind(otInstance* instance, otUdpSocket* socket,
+                  const otSockAddr* name, otNetifIdentifier netif) {
+    (void)instance;
+    (void)netif;
+    ot_mock_call();
+    socket->mSockName = *name;
+    return OT_ERROR_NONE;
+}
+
+otError otUdpSend(otInstance* instance, otUdpSocket* socket,
+                  otMessage* message, const otMessageInfo* info) {
+    ot_mock_sent_t* sent;
+
+    (void)instance;
+    (void)socket;
+    ot_mock_call();
+    if (g_ot_mock.send_error != OT_ERROR_NONE) {
+        return g_ot_mock.send_error;
+    }
+    configASSERT(g_ot_mock_sent_num < OT_MOCK_SENT_MAX);
+    sent = &g_ot_mock_sent[g_ot_mock_sent_num++];
+    sent->dst = info->mPeerAddr;
+    sent->port = info->mPeerPort;
+    sent->len = message->len;
+    memcpy(sent->data, message->buf, message->len);
+    message->used = 0; /* the stack owns it now */
+    return OT_ERROR_NONE;
+}
+
+otDeviceRole otThreadGetDeviceRole(otInstance* instance) {
+    (void)instance;
+    ot_mock_call();
+    return g_ot_mock.role;
+}
+
+otError otThreadGetNextNeighborInfo(otInstance* instance,
+                                    otNeighborInfoIterator* iterator,
+                                    otNeighborInfo* info) {
+    (void)instance;
+    ot_mock_call();
+    if (*iterator < 0 || (uint32_t)*iterator >= g_ot_mock_neighbor_num) {
+        return OT_ERROR_NOT_FOUND;
+    }
+    *info = g_ot_mock_neighbor[(*iterator)++];
+    return OT_ERROR_NONE;
+}
+
+uint32_t otThreadGetChildTimeout(otInstance* instance) {
+    (void)instance;
+    ot_mock_call();
+    return g_ot_mock.child_timeout;
+}
+
+otError otLinkSetPollPeriod(otInstance* instance, uint32_t period) {
+    (void)instance;
+    ot_mock_call();
+    if (period != 0 && (period < OT_MOCK_POLL_PERIOD_MIN
+                        || period > OT_MOCK_POLL_PERIOD_MAX)) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+    g_ot_mock.poll_period = period;
+    g_ot_mock.poll_sets++;
+    return OT_ERROR_NONE;
+}
+
+void otLinkGetFactoryAssignedIeeeEui64(otInstance* instance,
+                                       otExtAddress* eui64) {
+    (void)instance;
+    ot_mock_call();
+    *eui64 = g_ot_mock.eui64;
+}
+
+otError otIp6AddressFromString(const char* string, otIp6Address* address) {
+    return inet_pton(AF_INET6, string, address->mFields.m8) == 1
+               ? OT_ERROR_NONE
+               : OT_ERROR_INVALID_ARGS;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file ot_mock.h
+ * @brief Test side of the OpenThread stand-in in ot/.
+ *
+ * The stand-in counts every stack call made without the stack lock or from
+ * a timer callback, and a stack lock taken with an application mutex held.
+ * Sent datagrams are logged, received ones are delivered as the OpenThread
+ * task would, and the neighbor table is what the test fills in. Jobs
+ * posted with app_ot_job_post() wait until the test runs them with
+ * ot_mock_run_jobs().
+ */
+
+#ifndef __OT_MOCK_H
+#define __OT_MOCK_H
+
+#include "openthread/link.h"
+#include "openthread/message.h"
+#include "openthread/thread.h"
+#include "openthread/udp.h"
+
+#define OT_MOCK_SENT_MAX    64
+#define OT_MOCK_MESSAGE_MAX 8
+#define OT_MOCK_MESSAGE_LEN 1280
+#define OT_MOCK_NEIGHBOR_MAX 64
+
+typedef struct {
+    int lock_depth;
+    uint32_t unlocked_calls; /* stack calls without the stack lock */
+    uint32_t timer_calls;    /* stack calls from a timer callback */
+    uint32_t lock_order;     /* stack lock taken with an app mutex held */
+    uint16_t free_buffers;   /* reported by otMessageGetBufferInfo() */
+    uint8_t alloc_fail;      /* otUdpNewMessage() returns NULL */
+    otError send_error;      /* returned by otUdpSend() */
+    otDeviceRole role;
+    uint32_t child_timeout;  /* seconds */
+    uint32_t poll_period;    /* last set with otLinkSetPollPeriod() */
+    uint32_t poll_sets;
+    otExtAddress eui64;      /* factory EUI-64 */
+} ot_mock_t;
+
+typedef struct {
+    otIp6Address dst;
+    uint16_t port;
+    uint16_t len;
+    uint8_t data[OT_MOCK_MESSAGE_LEN];
+} ot_mock_sent_t;
+
+extern ot_mock_t g_ot_mock;
+extern ot_mock_sent_t g_ot_mock_sent[OT_MOCK_SENT_MAX];
+extern uint32_t g_ot_mock_sent_num;
+
+/* returned by otThreadGetNextNeighborInfo() */
+extern otNeighborInfo g_ot_mock_neighbor[OT_MOCK_NEIGHBOR_MAX];
+extern uint32_t g_ot_mock_neighbor_num;
+
+/* back to an idle stack with plenty of buffers, nothing sent or pending */
+void ot_mock_reset(void);
+
+/* counted with the other stack calls */
+void ot_mock_call(void);
+
+/* hand a datagram to the bound socket, in the OpenThread task */
+void ot_mock_udp_deliver(const void* data, uint16_t len,
+                         const otIp6Address* peer, uint16_t port);
+
+/* run the posted jobs in the OpenThread task, the number run */
+uint32_t ot_mock_run_jobs(void);
+
+uint32_t ot_mock_jobs_pending(void);
+
+/* messages allocated and not yet sent or freed */
+uint32_t ot_mock_messages_used(void);
+
+#endif // __OT_MOCK_H
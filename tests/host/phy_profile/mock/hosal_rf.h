@@ -0,0 +1,29 @@
+/**
+ * @file hosal_rf.h
+ * @brief Host stand-in for the band and data rate ids of the RF driver.
+ */
+
+#ifndef __PHY_MOCK_HOSAL_RF_H
+#define __PHY_MOCK_HOSAL_RF_H
+
+#include <stdint.h>
+
+enum {
+    HOSAL_RF_BAND_SUBG_915M = 0,
+    HOSAL_RF_BAND_2P4G = 1,
+    HOSAL_RF_BAND_SUBG_868M = 2,
+    HOSAL_RF_BAND_SUBG_433M = 3,
+    HOSAL_RF_BAND_SUBG_315M = 4,
+    HOSAL_RF_BAND_SUBG_470M = 5,
+};
+
+enum {
+    HOSAL_RF_PHY_DATA_RATE_200K = 3,
+    HOSAL_RF_PHY_DATA_RATE_100K = 4,
+    HOSAL_RF_PHY_DATA_RATE_50K = 5,
+    HOSAL_RF_PHY_DATA_RATE_300K = 6,
+    HOSAL_RF_PHY_DATA_RATE_150K = 7,
+    HOSAL_RF_PHY_DATA_RATE_25K = 9,
+};
+
+#endif // __PHY_MOCK_HOSAL_RF_H
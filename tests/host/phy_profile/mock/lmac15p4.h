@@ -0,0 +1,23 @@
+/**
+ * @file lmac15p4.h
+ * @brief Host stand-in for the LMAC init and PIB calls, the test records
+ *        what was programmed.
+ */
+
+#ifndef __PHY_MOCK_LMAC15P4_H
+#define __PHY_MOCK_LMAC15P4_H
+
+#include <stdint.h>
+
+#define LMAC15P4_SUBG_FSK   1
+#define LMAC15P4_SUBG_OQPSK 2
+
+void lmac15p4_init(uint8_t modulation, uint8_t band);
+void lmac15p4_phy_pib_set(uint16_t turnaround, uint8_t cca_mode,
+                          uint8_t cca_threshold, uint16_t cca_duration);
+void lmac15p4_mac_pib_set(uint32_t backoff_period, uint32_t ack_wait,
+                          uint8_t max_be, uint8_t max_csma_backoffs,
+                          uint32_t frame_total_wait, uint8_t max_frame_retries,
+                          uint8_t min_be);
+
+#endif // __PHY_MOCK_LMAC15P4_H
@@ -0,0 +1,28 @@
+/**
+ * @file subg_ctrl.h
+ * @brief Host stand-in for the Sub-GHz modem settings, all no-ops apart
+ *        from the modem configuration, which the test records.
+ */
+
+#ifndef __PHY_MOCK_SUBG_CTRL_H
+#define __PHY_MOCK_SUBG_CTRL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SUBG_CTRL_MODU_FSK         0
+#define SUBG_CTRL_FSK_MOD_1        1
+#define SUBG_CTRL_CRC_TYPE_16      1
+#define SUBG_CTRL_WHITEN_DISABLE   0
+#define SUBG_CTRL_FILTER_TYPE_GFSK 0
+
+void subg_ctrl_modem_config_set(uint8_t modu, uint8_t data_rate, uint8_t index);
+
+#define subg_ctrl_sleep_set(_sleep)               ((void)(_sleep))
+#define subg_ctrl_idle_set()                      ((void)0)
+#define subg_ctrl_mac_set(_modu, _crc, _whiten)   ((void)(_modu))
+#define subg_ctrl_preamble_set(_modu, _len)       ((void)(_modu))
+#define subg_ctrl_sfd_set(_modu, _sfd)            ((void)(_modu))
+#define subg_ctrl_filter_set(_modu, _filter)      ((void)(_modu))
+
+#endif // __PHY_MOCK_SUBG_CTRL_H
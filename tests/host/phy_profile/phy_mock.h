@@ -0,0 +1,22 @@
+/**
+ * @file phy_mock.h
+ * @brief Task calls of the delayed profile switch, forced into
+ *        phy_profile.c. The test runs the worker task itself.
+ */
+
+#ifndef __PHY_MOCK_H
+#define __PHY_MOCK_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define E_TASK_PRIORITY_APP 1
+
+typedef void (*TaskFunction_t)(void* arg);
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char* name, uint32_t depth,
+                       void* arg, UBaseType_t prio, TaskHandle_t* handle);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t task);
+
+#endif // __PHY_MOCK_H
@@ -0,0 +1,256 @@
+/**
+ * @file test_phy_profile.c
+ * @brief PHY profiles of mesh-it-up: the timings derived from the
+ *        802.15.4g formulas against values worked out by hand, and what
+ *        an apply or a delayed switch programs into a mock LMAC, under the
+ *        stack lock once the stack runs.
+ *
+ * The source is included so the timings of the active profile and the
+ * values read by the port can be checked directly.
+ */
+
+#include <string.h>
+#include "phy_profile.c"
+#include "host_test.h"
+#include "ot_mock.h"
+
+/* CSMA-CA settings of the router and of the sleepy and sniffer apps */
+static const phy_profile_mac_t s_router = {3, 8, 4, 4};
+static const phy_profile_mac_t s_sleepy = {2, 5, 4, 4};
+
+static struct {
+    uint32_t inits;
+    uint8_t modulation;
+    uint8_t band;
+    uint16_t cca_us;
+    uint32_t backoff_us;
+    uint32_t ack_wait_us;
+    uint32_t frame_wait_us;
+    uint8_t min_be;
+    uint8_t max_be;
+    uint8_t data_rate;
+    int lock_depth;    /* stack lock depth at the last MAC PIB set */
+} s_lmac;
+
+static TaskFunction_t s_task_fn;
+static TickType_t s_delayed;
+
+void lmac15p4_init(uint8_t modulation, uint8_t band) {
+    s_lmac.inits++;
+    s_lmac.modulation = modulation;
+    s_lmac.band = band;
+}
+
+void lmac15p4_phy_pib_set(uint16_t turnaround, uint8_t cca_mode,
+                          uint8_t cca_threshold, uint16_t cca_duration) {
+    s_lmac.cca_us = cca_duration;
+}
+
+void lmac15p4_mac_pib_set(uint32_t backoff_period, uint32_t ack_wait,
+                          uint8_t max_be, uint8_t max_csma_backoffs,
+                          uint32_t frame_total_wait, uint8_t max_frame_retries,
+                          uint8_t min_be) {
+    s_lmac.backoff_us = backoff_period;
+    s_lmac.ack_wait_us = ack_wait;
+    s_lmac.frame_wait_us = frame_total_wait;
+    s_lmac.min_be = min_be;
+    s_lmac.max_be = max_be;
+    s_lmac.lock_depth = g_ot_mock.lock_depth;
+}
+
+void subg_ctrl_modem_config_set(uint8_t modu, uint8_t data_rate,
+                                uint8_t index) {
+    s_lmac.data_rate = data_rate;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char* name, uint32_t depth,
+                       void* arg, UBaseType_t prio, TaskHandle_t* handle) {
+    s_task_fn = code;
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) { s_delayed += ticks; }
+
+void vTaskDelete(TaskHandle_t task) { s_task_fn = NULL; }
+
+static void setup(const phy_profile_mac_t* mac) {
+    memset(&s_lmac, 0, sizeof(s_lmac));
+    s_current = NULL;
+    s_pending = NULL;
+    s_task_fn = NULL;
+    s_delayed = 0;
+    phy_profile_init(mac);
+}
+
+static void test_timing_by_hand(void) {
+    phy_profile_timing_t t;
+
+    /* 50 kbit/s: 20 us a bit, 96 bits of SHR and PHR, 5 octet ACK,
+     * 127 octet PSDU */
+    phy_profile_timing(phy_profile_find("fsk-50k"), &s_sleepy, &t);
+    CHECK_EQ(t.cca_us, 640);
+    CHECK_EQ(t.backoff_us, 1640);
+    CHECK_EQ(t.ack_wait_us, 1640 + 1000 + 136 * 20);
+    /* m = 3: 4 + 8 + 16 slots, then 31 for the last backoff */
+    CHECK_EQ(t.frame_wait_us, 59 * 1640 + 1112 * 20);
+
+    /* m = min(5, 4) = 4: 8 + 16 + 32 + 64 slots */
+    phy_profile_timing(phy_profile_find("fsk-50k"), &s_router, &t);
+    CHECK_EQ(t.frame_wait_us, 120 * 1640 + 1112 * 20);
+
+    /* 25 kbit/s O-QPSK: 8 symbols of 4 bits */
+    phy_profile_timing(phy_profile_find("oqpsk-25k"), &s_sleepy, &t);
+    CHECK_EQ(t.cca_us, 1280);
+    CHECK_EQ(t.backoff_us, 2280);
+    CHECK_EQ(t.ack_wait_us, 2280 + 1000 + 136 * 40);
+    CHECK_EQ(t.frame_wait_us, 59 * 2280 + 1112 * 40);
+}
+
+static void test_cca_and_backoff(void) {
+    const phy_profile_t* p;
+    phy_profile_timing_t t;
+    uint8_t i;
+
+    for (i = 0; i < phy_profile_count(); i++) {
+        p = phy_profile_get(i);
+        phy_profile_timing(p, &s_router, &t);
+        /* never shorter than aCcaTime, never below the floor */
+        CHECK((uint64_t)t.cca_us * p->bit_rate >= 32ULL * 1000000);
+        CHECK(t.cca_us >= PHY_PROFILE_CCA_MIN_US);
+        CHECK_EQ(t.backoff_us, PHY_PROFILE_TURNAROUND_US + t.cca_us);
+    }
+
+    phy_profile_timing(phy_profile_find("fsk-300k"), &s_router, &t);
+    CHECK_EQ(t.cca_us, 128);
+    phy_profile_timing(phy_profile_find("fsk-200k"), &s_router, &t);
+    CHECK_EQ(t.cca_us, 160);
+    phy_profile_timing(phy_profile_find("fsk-150k"), &s_router, &t);
+    CHECK_EQ(t.cca_us, 214);
+    phy_profile_timing(phy_profile_find("fsk-100k"), &s_router, &t);
+    CHECK_EQ(t.cca_us, 320);
+}
+
+static void test_oqpsk_ack_wait(void) {
+    phy_profile_timing_t oqpsk, t;
+    uint8_t i;
+
+    phy_profile_timing(phy_profile_find("oqpsk-25k"), &s_router, &oqpsk);
+    CHECK(oqpsk.ack_wait_us > 2000);
+    for (i = 0; i < phy_profile_count(); i++) {
+        if (phy_profile_get(i)->modulation == LMAC15P4_SUBG_FSK) {
+            phy_profile_timing(phy_profile_get(i), &s_router, &t);
+            CHECK(t.ack_wait_us < oqpsk.ack_wait_us);
+            /* the ACK has to fit after the turnaround */
+            CHECK(t.ack_wait_us > t.backoff_us + PHY_PROFILE_TURNAROUND_US);
+        }
+    }
+}
+
+static void test_frame_wait_scales(void) {
+    static const char* const by_rate[] = {"fsk-300k", "fsk-200k", "fsk-150k",
+                                          "fsk-100k", "fsk-50k", "oqpsk-25k"};
+    phy_profile_timing_t prev, t;
+    phy_profile_mac_t none = s_sleepy;
+    uint8_t i;
+
+    phy_profile_timing(phy_profile_find(by_rate[0]), &s_sleepy, &prev);
+    for (i = 1; i < sizeof(by_rate) / sizeof(by_rate[0]); i++) {
+        phy_profile_timing(phy_profile_find(by_rate[i]), &s_sleepy, &t);
+        CHECK(t.frame_wait_us > prev.frame_wait_us);
+        CHECK(t.ack_wait_us > prev.ack_wait_us);
+        prev = t;
+    }
+
+    /* wider windows wait longer, no backoffs leave the frame alone */
+    phy_profile_timing(phy_profile_find("fsk-100k"), &s_router, &prev);
+    phy_profile_timing(phy_profile_find("fsk-100k"), &s_sleepy, &t);
+    CHECK(prev.frame_wait_us > t.frame_wait_us);
+    none.max_csma_backoffs = 0;
+    phy_profile_timing(phy_profile_find("fsk-100k"), &none, &t);
+    CHECK_EQ(t.frame_wait_us, 1112 * 10);
+}
+
+static void test_apply_programs_timing(void) {
+    phy_profile_timing_t t;
+
+    setup(&s_sleepy);
+    CHECK(phy_profile_current() == phy_profile_find("fsk-300k"));
+    CHECK_EQ(s_lmac.inits, 1);
+    CHECK_EQ(s_lmac.band, HOSAL_RF_BAND_SUBG_915M);
+
+    phy_profile_timing(phy_profile_find("fsk-300k"), &s_sleepy, &t);
+    CHECK_EQ(s_lmac.cca_us, t.cca_us);
+    CHECK_EQ(s_lmac.backoff_us, t.backoff_us);
+    CHECK_EQ(s_lmac.ack_wait_us, t.ack_wait_us);
+    CHECK_EQ(s_lmac.frame_wait_us, t.frame_wait_us);
+    CHECK_EQ(s_lmac.min_be, 2);
+    CHECK_EQ(s_lmac.max_be, 5);
+    CHECK_EQ(cca_duration, t.cca_us);
+    CHECK_EQ(backof_period, t.backoff_us);
+    CHECK_EQ(frame_total_wait_time, t.frame_wait_us);
+    /* init runs before the stack, switches run under its lock */
+    CHECK_EQ(s_lmac.lock_depth, 0);
+
+    /* same modulation and band, no LMAC init */
+    CHECK_EQ(phy_profile_apply(phy_profile_find("fsk-50k"),
+                               HOSAL_RF_BAND_SUBG_915M),
+             0);
+    CHECK_EQ(s_lmac.inits, 1);
+    CHECK_EQ(s_lmac.data_rate, HOSAL_RF_PHY_DATA_RATE_50K);
+    CHECK_EQ(s_lmac.ack_wait_us, 5360);
+    CHECK_EQ(s_lmac.lock_depth, 1);
+    CHECK_EQ(g_ot_mock.lock_depth, 0);
+
+    CHECK_EQ(phy_profile_apply(phy_profile_find("oqpsk-25k"),
+                               HOSAL_RF_BAND_SUBG_915M),
+             0);
+    CHECK_EQ(s_lmac.inits, 2);
+    CHECK_EQ(s_lmac.modulation, LMAC15P4_SUBG_OQPSK);
+    CHECK_EQ(s_lmac.ack_wait_us, 8720);
+    CHECK_EQ(s_timing.ack_wait_us, 8720);
+
+    CHECK_EQ(phy_profile_apply(phy_profile_find("fsk-50k"),
+                               HOSAL_RF_BAND_2P4G),
+             -1);
+    CHECK(phy_profile_current() == phy_profile_find("oqpsk-25k"));
+}
+
+static void test_schedule(void) {
+    setup(&s_router);
+
+    CHECK_EQ(phy_profile_schedule(phy_profile_find("fsk-100k"),
+                                  HOSAL_RF_BAND_SUBG_868M, 1500),
+             0);
+    CHECK_EQ(phy_profile_schedule(phy_profile_find("fsk-50k"),
+                                  HOSAL_RF_BAND_SUBG_868M, 10),
+             -1);
+    CHECK(phy_profile_current() == phy_profile_find("fsk-300k"));
+
+    CHECK(s_task_fn != NULL);
+    s_task_fn(NULL);
+    CHECK_EQ(s_delayed, pdMS_TO_TICKS(1500));
+    CHECK(phy_profile_current() == phy_profile_find("fsk-100k"));
+    CHECK_EQ(phy_profile_band(), HOSAL_RF_BAND_SUBG_868M);
+    CHECK_EQ(s_lmac.inits, 2);
+    CHECK_EQ(s_lmac.frame_wait_us, 120 * 1320 + 1112 * 10);
+    CHECK_EQ(s_lmac.lock_depth, 1);
+
+    /* the next switch may be scheduled once the worker is done; the
+     * router frame wait of fsk-50k does not fit 16 bits */
+    CHECK_EQ(phy_profile_schedule(phy_profile_find("fsk-50k"),
+                                  HOSAL_RF_BAND_SUBG_868M, 10),
+             0);
+    s_task_fn(NULL);
+    CHECK_EQ(frame_total_wait_time, 219040);
+    CHECK_EQ(s_lmac.frame_wait_us, 219040);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_timing_by_hand);
+    HOST_TEST_RUN(test_cca_and_backoff);
+    HOST_TEST_RUN(test_oqpsk_ack_wait);
+    HOST_TEST_RUN(test_frame_wait_scales);
+    HOST_TEST_RUN(test_apply_programs_timing);
+    HOST_TEST_RUN(test_schedule);
+    return HOST_TEST_END();
+}
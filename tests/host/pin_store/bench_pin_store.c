@@ -0,0 +1,156 @@
+/**
+ * @file bench_pin_store.c
+ * @brief Door lock PIN store with 500 users: load from flash, set, hit and
+ *        miss lookups against a linear scan of all users, and the compare
+ *        time by position of the first differing byte.
+ *
+ * Host timings only compare the approaches, the target is a Cortex-M3 at
+ * 48 MHz (RT58x) or a Cortex-M33 at 64 MHz (RT584).
+ */
+
+#include <time.h>
+#include "pin_store.c"
+
+#define ROUNDS 200
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void pin_make(uint16_t user_id, uint8_t* pin, uint8_t* len) {
+    uint32_t v = user_id * 7919u + 1234u;
+    uint8_t i;
+
+    *len = 4 + (user_id % 5);
+    for (i = *len; i > 0; i--, v /= 10) {
+        pin[i - 1] = (uint8_t)('0' + v % 10);
+    }
+    pin[*len] = 0;
+}
+
+static int32_t linear_match(const uint8_t* pin, uint8_t len) {
+    uint16_t i;
+
+    for (i = 0; i < PIN_STORE_USER_MAX; i++) {
+        if (pin_used(i) && pin_equal(&pin_users[i], pin, len)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static volatile int32_t s_sink;
+
+int main(void) {
+    uint8_t pin[PIN_STORE_PIN_MAX + 1], len;
+    uint8_t miss[PIN_STORE_PIN_MAX + 1] = "987654321";
+    pin_store_user_t user = {.len = PIN_STORE_PIN_MAX};
+    uint64_t t0, t_set, t_load, t_hit, t_miss, t_lin_hit, t_lin_miss;
+    uint64_t t_pos[PIN_STORE_PIN_MAX], best;
+    uint32_t sets, r, probes_max = 0, probes;
+    uint16_t i, slot;
+
+    efd_stub_reset();
+    pin_store_init();
+    pin_store_clear_all();
+
+    sets = g_efd_stub_stats.sets;
+    t0 = now_ns();
+    for (i = 0; i < PIN_STORE_USER_MAX; i++) {
+        pin_make(i, pin, &len);
+        pin_store_set(i, PIN_STORE_USER_ENABLED, 0, pin, len);
+    }
+    t_set = now_ns() - t0;
+    sets = g_efd_stub_stats.sets - sets;
+
+    t0 = now_ns();
+    pin_store_init();
+    t_load = now_ns() - t0;
+
+    /* probe lengths of the index at this load */
+    for (i = 0; i < PIN_STORE_USER_MAX; i++) {
+        slot = (uint16_t)(pin_hash(pin_users[i].pin, pin_users[i].len)
+                          & (PIN_STORE_INDEX_SIZE - 1));
+        for (probes = 1; pin_index[slot] != i; probes++) {
+            slot = (slot + 1) & (PIN_STORE_INDEX_SIZE - 1);
+        }
+        if (probes > probes_max) {
+            probes_max = probes;
+        }
+    }
+
+    t0 = now_ns();
+    for (r = 0; r < ROUNDS; r++) {
+        for (i = 0; i < PIN_STORE_USER_MAX; i++) {
+            pin_make(i, pin, &len);
+            s_sink = pin_store_match(pin, len);
+        }
+    }
+    t_hit = now_ns() - t0;
+
+    t0 = now_ns();
+    for (r = 0; r < ROUNDS; r++) {
+        for (i = 0; i < PIN_STORE_USER_MAX; i++) {
+            pin_make(i, pin, &len);
+            s_sink = linear_match(pin, len);
+        }
+    }
+    t_lin_hit = now_ns() - t0;
+
+    t0 = now_ns();
+    for (r = 0; r < ROUNDS * PIN_STORE_USER_MAX; r++) {
+        miss[0] = (uint8_t)('0' + r % 10);
+        s_sink = pin_store_match(miss, 9);
+    }
+    t_miss = now_ns() - t0;
+
+    t0 = now_ns();
+    for (r = 0; r < ROUNDS * 10; r++) {
+        miss[0] = (uint8_t)('0' + r % 10);
+        s_sink = linear_match(miss, 9);
+    }
+    t_lin_miss = (now_ns() - t0) * (PIN_STORE_USER_MAX / 10);
+
+    /* compare time by position of the first differing byte, best of runs */
+    memset(user.pin, '5', sizeof(user.pin));
+    for (i = 0; i < PIN_STORE_PIN_MAX; i++) {
+        memset(pin, '5', PIN_STORE_PIN_MAX);
+        pin[i] = '6';
+        best = UINT64_MAX;
+        for (r = 0; r < 50; r++) {
+            uint32_t k;
+
+            t0 = now_ns();
+            for (k = 0; k < 10000; k++) {
+                s_sink = pin_equal(&user, pin, PIN_STORE_PIN_MAX);
+            }
+            t0 = now_ns() - t0;
+            if (t0 < best) {
+                best = t0;
+            }
+        }
+        t_pos[i] = best;
+    }
+
+    printf("users                 %u\n", PIN_STORE_USER_MAX);
+    printf("set, per user         %.2f us, %.2f flash writes\n",
+           t_set / 1000.0 / PIN_STORE_USER_MAX,
+           (double)sets / PIN_STORE_USER_MAX);
+    printf("load from flash       %.1f us\n", t_load / 1000.0);
+    printf("index probes, max     %lu\n", (unsigned long)probes_max);
+    printf("match hit             %.1f ns (linear scan %.1f ns)\n",
+           (double)t_hit / (ROUNDS * PIN_STORE_USER_MAX),
+           (double)t_lin_hit / (ROUNDS * PIN_STORE_USER_MAX));
+    printf("match miss            %.1f ns (linear scan %.1f ns)\n",
+           (double)t_miss / (ROUNDS * PIN_STORE_USER_MAX),
+           (double)t_lin_miss / (ROUNDS * PIN_STORE_USER_MAX));
+    printf("compare by first diff");
+    for (i = 0; i < PIN_STORE_PIN_MAX; i++) {
+        printf(" %.1f", t_pos[i] / 10000.0);
+    }
+    printf(" ns\n");
+    return 0;
+}
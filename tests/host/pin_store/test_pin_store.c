@@ -0,0 +1,309 @@
+/**
+ * @file test_pin_store.c
+ * @brief Door lock PIN store: the open addressing index, the constant time
+ *        compare, the per-user flash records and the roll back of failed
+ *        writes, against the in-memory flash dataset of stub/.
+ *
+ * The source is included so the index and compare helpers can be checked
+ * directly.
+ */
+
+#include "pin_store.c"
+#include "host_test.h"
+
+/* distinct PINs of 4 to 8 digits, 7919 is prime to every power of ten */
+static void pin_make(uint16_t user_id, uint8_t* pin, uint8_t* len) {
+    uint32_t v = user_id * 7919u + 1234u;
+    uint8_t i;
+
+    *len = 4 + (user_id % 5);
+    for (i = *len; i > 0; i--, v /= 10) {
+        pin[i - 1] = (uint8_t)('0' + v % 10);
+    }
+    pin[*len] = 0;
+}
+
+static void fill(uint16_t num) {
+    uint8_t pin[PIN_STORE_PIN_MAX + 1], len;
+    uint16_t i;
+
+    for (i = 0; i < num; i++) {
+        pin_make(i, pin, &len);
+        CHECK_EQ(pin_store_set(i, PIN_STORE_USER_ENABLED, 0, pin, len),
+                 PIN_STORE_OK);
+    }
+}
+
+/* first boot with an empty dataset, user 0 has the default PIN */
+static void boot_fresh(void) {
+    efd_stub_reset();
+    pin_store_init();
+    pin_store_clear_all();
+}
+
+static void test_equal(void) {
+    pin_store_user_t user = {.len = 8};
+    uint8_t pin[PIN_STORE_PIN_MAX] = {0};
+    uint8_t i;
+
+    memcpy(user.pin, "12345678", 8);
+    memcpy(pin, "12345678", 8);
+    CHECK(pin_equal(&user, pin, 8));
+    CHECK(!pin_equal(&user, pin, 7));
+    /* a prefix with the rest of the buffer zero is still a different PIN */
+    CHECK(!pin_equal(&user, pin, 9));
+    for (i = 0; i < 8; i++) {
+        pin[i] ^= 0x01;
+        CHECK(!pin_equal(&user, pin, 8));
+        pin[i] ^= 0x01;
+    }
+    /* bytes past the stored length must be zero to match */
+    user.pin[12] = 1;
+    CHECK(!pin_equal(&user, pin, 8));
+}
+
+static void test_default_and_legacy(void) {
+    pin_store_user_t user;
+    uint8_t legacy[PIN_STORE_LEGACY_LEN] = {4, '4', '3', '2', '1'};
+
+    efd_stub_reset();
+    pin_store_init();
+    CHECK_EQ(pin_store_count(), 1);
+    CHECK_EQ(pin_store_match((const uint8_t*)"12345678", 8), 0);
+
+    /* the single-PIN layout moves to user 0 and its record goes away */
+    efd_stub_reset();
+    efd_set_env_blob(PIN_STORE_LEGACY_KEY, legacy, sizeof(legacy));
+    pin_store_init();
+    CHECK(pin_store_get(0, &user));
+    CHECK_EQ(user.len, 4);
+    CHECK_EQ(pin_store_match((const uint8_t*)"4321", 4), 0);
+    CHECK_EQ(pin_store_match((const uint8_t*)"12345678", 8), -1);
+    CHECK(efd_stub_find(PIN_STORE_LEGACY_KEY, NULL) == NULL);
+}
+
+static void test_index_full(void) {
+    uint8_t pin[PIN_STORE_PIN_MAX + 1], len;
+    uint16_t i;
+
+    boot_fresh();
+    fill(PIN_STORE_USER_MAX);
+    CHECK_EQ(pin_store_count(), PIN_STORE_USER_MAX);
+    for (i = 0; i < PIN_STORE_USER_MAX; i++) {
+        pin_make(i, pin, &len);
+        CHECK_EQ(pin_store_match(pin, len), i);
+    }
+    CHECK_EQ(pin_store_match((const uint8_t*)"000000000", 9), -1);
+    CHECK_EQ(pin_store_set(PIN_STORE_USER_MAX, PIN_STORE_USER_ENABLED, 0,
+                           (const uint8_t*)"99999", 5),
+             PIN_STORE_FAIL);
+}
+
+static void test_duplicate_replace_disable(void) {
+    pin_store_user_t user;
+
+    boot_fresh();
+    CHECK_EQ(pin_store_set(3, PIN_STORE_USER_ENABLED, 0,
+                           (const uint8_t*)"2468", 4),
+             PIN_STORE_OK);
+    CHECK_EQ(pin_store_set(4, PIN_STORE_USER_ENABLED, 0,
+                           (const uint8_t*)"2468", 4),
+             PIN_STORE_DUPLICATE);
+    /* the owner may set the same PIN again, or change it */
+    CHECK_EQ(pin_store_set(3, PIN_STORE_USER_ENABLED, 1,
+                           (const uint8_t*)"2468", 4),
+             PIN_STORE_OK);
+    CHECK_EQ(pin_store_set(3, PIN_STORE_USER_ENABLED, 1,
+                           (const uint8_t*)"13579", 5),
+             PIN_STORE_OK);
+    CHECK_EQ(pin_store_match((const uint8_t*)"2468", 4), -1);
+    CHECK_EQ(pin_store_match((const uint8_t*)"13579", 5), 3);
+    CHECK_EQ(pin_store_count(), 1);
+
+    CHECK_EQ(pin_store_set(3, PIN_STORE_USER_DISABLED, 1,
+                           (const uint8_t*)"13579", 5),
+             PIN_STORE_OK);
+    CHECK_EQ(pin_store_match((const uint8_t*)"13579", 5), -1);
+    CHECK(pin_store_get(3, &user));
+    CHECK_EQ(user.status, PIN_STORE_USER_DISABLED);
+    CHECK_EQ(user.type, 1);
+
+    CHECK_EQ(pin_store_set(5, PIN_STORE_USER_AVAILABLE, 0,
+                           (const uint8_t*)"1111", 4),
+             PIN_STORE_FAIL);
+    CHECK_EQ(pin_store_set(5, PIN_STORE_USER_ENABLED, 0,
+                           (const uint8_t*)"12345678901234567", 17),
+             PIN_STORE_FAIL);
+}
+
+/* churn leaves tombstones, the rebuild keeps probes bounded */
+static void test_tombstones(void) {
+    uint8_t pin[PIN_STORE_PIN_MAX + 1], len;
+    uint32_t round;
+    uint16_t i, id;
+
+    boot_fresh();
+    fill(PIN_STORE_USER_MAX / 2);
+    for (round = 0; round < 4000; round++) {
+        id = (uint16_t)(round % (PIN_STORE_USER_MAX / 2));
+        CHECK_EQ(pin_store_clear(id), PIN_STORE_OK);
+        pin_make(id, pin, &len);
+        CHECK_EQ(pin_store_set(id, PIN_STORE_USER_ENABLED, 0, pin, len),
+                 PIN_STORE_OK);
+        CHECK(pin_tombstones <= PIN_STORE_INDEX_SIZE / 4);
+    }
+    for (i = 0; i < PIN_STORE_USER_MAX / 2; i++) {
+        pin_make(i, pin, &len);
+        CHECK_EQ(pin_store_match(pin, len), i);
+    }
+    CHECK_EQ(pin_store_count(), PIN_STORE_USER_MAX / 2);
+
+    /* changing the PIN of a user leaves tombstones too */
+    for (round = 0; round < 4000; round++) {
+        id = (uint16_t)(round % (PIN_STORE_USER_MAX / 2));
+        pin_make((uint16_t)(id + PIN_STORE_USER_MAX * (1 + round % 2)), pin, &len);
+        CHECK_EQ(pin_store_set(id, PIN_STORE_USER_ENABLED, 0, pin, len),
+                 PIN_STORE_OK);
+        CHECK(pin_tombstones <= PIN_STORE_INDEX_SIZE / 4);
+    }
+    CHECK_EQ(pin_store_match(pin, len), id);
+}
+
+/* a failed write leaves the user, the map and the index as they were */
+static void test_write_errors(void) {
+    pin_store_user_t user;
+    char name[12];
+
+    boot_fresh();
+    CHECK_EQ(pin_store_set(5, PIN_STORE_USER_ENABLED, 0,
+                           (const uint8_t*)"5555", 4),
+             PIN_STORE_OK);
+
+    /* a new user whose record does not fit */
+    efd_stub_fail(0, EF_ENV_FULL);
+    CHECK_EQ(pin_store_set(6, PIN_STORE_USER_ENABLED, 0,
+                           (const uint8_t*)"6666", 4),
+             PIN_STORE_FULL);
+    CHECK_EQ(pin_store_count(), 1);
+    CHECK(!pin_store_get(6, &user));
+    CHECK_EQ(pin_store_match((const uint8_t*)"6666", 4), -1);
+
+    /* record written, map not: the user does not exist after a reboot */
+    efd_stub_fail(1, EF_WRITE_ERR);
+    CHECK_EQ(pin_store_set(6, PIN_STORE_USER_ENABLED, 0,
+                           (const uint8_t*)"6666", 4),
+             PIN_STORE_FAIL);
+    CHECK_EQ(pin_store_count(), 1);
+    CHECK(!pin_store_get(6, &user));
+    CHECK_EQ(pin_store_match((const uint8_t*)"6666", 4), -1);
+    CHECK(!pin_used(6));
+
+    /* a changed PIN that is not written keeps the old one */
+    efd_stub_fail(0, EF_WRITE_ERR);
+    CHECK_EQ(pin_store_set(5, PIN_STORE_USER_DISABLED, 1,
+                           (const uint8_t*)"1234", 4),
+             PIN_STORE_FAIL);
+    CHECK_EQ(pin_store_match((const uint8_t*)"5555", 4), 5);
+    CHECK_EQ(pin_store_match((const uint8_t*)"1234", 4), -1);
+    CHECK(pin_store_get(5, &user));
+    CHECK_EQ(user.status, PIN_STORE_USER_ENABLED);
+    CHECK_EQ(user.type, 0);
+
+    /* nor is a clear */
+    CHECK_EQ(pin_store_clear(5), PIN_STORE_FAIL);
+    CHECK_EQ(pin_store_clear_all(), PIN_STORE_FAIL);
+    CHECK_EQ(pin_store_count(), 1);
+    CHECK_EQ(pin_store_match((const uint8_t*)"5555", 4), 5);
+
+    efd_stub_fail(0, EF_NO_ERR);
+    pin_store_init();
+    CHECK_EQ(pin_store_count(), 1);
+    CHECK_EQ(pin_store_match((const uint8_t*)"5555", 4), 5);
+    CHECK(!pin_store_get(6, &user));
+
+    /* the map is written first: a record left behind is not loaded */
+    efd_stub_fail(1, EF_WRITE_ERR);
+    CHECK_EQ(pin_store_clear(5), PIN_STORE_OK);
+    efd_stub_fail(0, EF_NO_ERR);
+    pin_key_name(name, 5);
+    CHECK(efd_stub_find(name, NULL) != NULL);
+    pin_store_init();
+    CHECK_EQ(pin_store_count(), 0);
+    CHECK_EQ(pin_store_set(5, PIN_STORE_USER_ENABLED, 0,
+                           (const uint8_t*)"5151", 4),
+             PIN_STORE_OK);
+    CHECK_EQ(pin_store_match((const uint8_t*)"5151", 4), 5);
+}
+
+static void test_records(void) {
+    char name[12];
+    size_t len;
+    uint8_t* rec;
+    uint32_t sets;
+
+    boot_fresh();
+    CHECK_EQ(efd_stub_count(), 1); /* the map only */
+
+    /* a new user writes its record and the map */
+    sets = g_efd_stub_stats.sets;
+    pin_store_set(42, PIN_STORE_USER_ENABLED, 0, (const uint8_t*)"4242", 4);
+    CHECK_EQ(g_efd_stub_stats.sets - sets, 2);
+    pin_key_name(name, 42);
+    rec = efd_stub_find(name, &len);
+    CHECK(rec != NULL && len == sizeof(pin_store_user_t));
+
+    /* changing a known user rewrites that record only */
+    sets = g_efd_stub_stats.sets;
+    pin_store_set(42, PIN_STORE_USER_ENABLED, 0, (const uint8_t*)"2424", 4);
+    CHECK_EQ(g_efd_stub_stats.sets - sets, 1);
+
+    CHECK_EQ(pin_store_clear(42), PIN_STORE_OK);
+    CHECK(efd_stub_find(name, NULL) == NULL);
+    CHECK_EQ(efd_stub_count(), 1);
+}
+
+static void test_reload(void) {
+    uint8_t pin[PIN_STORE_PIN_MAX + 1], len;
+    pin_store_user_t* rec;
+    char name[12];
+    uint16_t i;
+
+    boot_fresh();
+    fill(PIN_STORE_USER_MAX);
+    pin_store_set(7, PIN_STORE_USER_DISABLED, 2, (const uint8_t*)"7777", 4);
+
+    /* reboot: new hash key, same users; a corrupt record is dropped */
+    pin_key_name(name, 9);
+    rec = (pin_store_user_t*)efd_stub_find(name, NULL);
+    rec->len = PIN_STORE_PIN_MAX + 1;
+    pin_store_init();
+
+    CHECK_EQ(pin_store_count(), PIN_STORE_USER_MAX - 1);
+    for (i = 0; i < PIN_STORE_USER_MAX; i++) {
+        if (i == 7 || i == 9) {
+            continue;
+        }
+        pin_make(i, pin, &len);
+        CHECK_EQ(pin_store_match(pin, len), i);
+    }
+    CHECK_EQ(pin_store_match((const uint8_t*)"7777", 4), -1);
+    CHECK(!pin_store_get(9, &(pin_store_user_t){0}));
+
+    pin_store_clear_all();
+    CHECK_EQ(pin_store_count(), 0);
+    CHECK_EQ(efd_stub_count(), 1);
+    pin_store_init();
+    CHECK_EQ(pin_store_count(), 0);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_equal);
+    HOST_TEST_RUN(test_default_and_legacy);
+    HOST_TEST_RUN(test_index_full);
+    HOST_TEST_RUN(test_duplicate_replace_disable);
+    HOST_TEST_RUN(test_tombstones);
+    HOST_TEST_RUN(test_write_errors);
+    HOST_TEST_RUN(test_records);
+    HOST_TEST_RUN(test_reload);
+    return HOST_TEST_END();
+}
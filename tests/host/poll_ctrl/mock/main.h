@@ -0,0 +1,21 @@
+/**
+ * @file main.h
+ * @brief Host stand-in for the miu-sleepy main.h, the stack calls come from
+ *        the OpenThread stand-in of ot/
+ */
+
+#ifndef __POLL_MOCK_MAIN_H
+#define __POLL_MOCK_MAIN_H
+
+#include <miu_port.h>
+#include <openthread/link.h>
+#include <openthread/thread.h>
+
+/*app_poll.c*/
+void app_poll_init(otInstance* instance);
+void app_poll_state_changed(uint32_t flags);
+void app_poll_tx(void);
+void app_poll_rx(void);
+void app_poll_expect(uint32_t window_ms);
+
+#endif // __POLL_MOCK_MAIN_H
@@ -0,0 +1,131 @@
+/**
+ * @file test_app_poll.c
+ * @brief Poll controller glue of miu-sleepy against the OpenThread stand-in
+ *        of ot/: the period is set in the OpenThread task and a period the
+ *        stack refuses leaves the poll timer where it was.
+ *
+ * The source is included to reach the timer and the CLI handler.
+ */
+
+#include "app_poll.c"
+#include "host_test.h"
+#include "ot_mock.h"
+
+static int quiet(const char* fmt, ...) {
+    (void)fmt;
+    return 0;
+}
+
+/* the OpenThread task runs whatever was posted every tick */
+static void run_ms(uint32_t ms) {
+    while (ms--) {
+        stub_timers_advance(1);
+        ot_mock_run_jobs();
+    }
+}
+
+static void check_stack_use(void) {
+    CHECK_EQ(g_ot_mock.unlocked_calls, 0);
+    CHECK_EQ(g_ot_mock.timer_calls, 0);
+    CHECK_EQ(g_ot_mock.lock_order, 0);
+    CHECK_EQ(g_stub_mutex_held, 0);
+}
+
+static void test_init_applies_in_ot_task(void) {
+    ot_mock_reset();
+    app_ot_job_init(otrGetInstance());
+    otrLock();
+    app_poll_init(otrGetInstance());
+    otrUnlock();
+
+    /* posted, not applied yet */
+    CHECK_EQ(g_ot_mock.poll_sets, 0);
+    CHECK(!xTimerIsTimerActive(s_timer));
+    CHECK_EQ(ot_mock_run_jobs(), 1);
+    CHECK_EQ(g_ot_mock.poll_period, POLL_CTRL_FAST_MS);
+    CHECK_EQ(s_applied_ms, POLL_CTRL_FAST_MS);
+    CHECK(xTimerIsTimerActive(s_timer));
+    CHECK_EQ(s_timer->period, pdMS_TO_TICKS(POLL_CTRL_FAST_MS));
+    check_stack_use();
+}
+
+/* the poll timer decays the period from the timer daemon, the stack sees
+ * it from the OpenThread task */
+static void test_decay_from_timer(void) {
+    uint32_t sets = g_ot_mock.poll_sets;
+
+    run_ms(POLL_CTRL_HOLD_MS + POLL_CTRL_FAST_MS);
+    CHECK(g_ot_mock.poll_sets > sets);
+    CHECK(g_ot_mock.poll_period > POLL_CTRL_FAST_MS);
+    CHECK_EQ(g_ot_mock.poll_period, s_ctrl.period_ms);
+    CHECK_EQ(s_timer->period, pdMS_TO_TICKS(s_ctrl.period_ms));
+
+    run_ms(300000);
+    CHECK_EQ(g_ot_mock.poll_period, POLL_CTRL_SLOW_MS);
+    CHECK_EQ(s_timer->period, pdMS_TO_TICKS(POLL_CTRL_SLOW_MS));
+    check_stack_use();
+}
+
+/* traffic from the shell snaps back to fast without a stack call there */
+static void test_tx_from_shell(void) {
+    uint32_t sets = g_ot_mock.poll_sets;
+
+    app_poll_tx();
+    CHECK_EQ(g_ot_mock.poll_sets, sets);
+    CHECK(ot_mock_jobs_pending() != 0);
+    ot_mock_run_jobs();
+    CHECK_EQ(g_ot_mock.poll_period, POLL_CTRL_FAST_MS);
+    CHECK_EQ(s_timer->period, pdMS_TO_TICKS(POLL_CTRL_FAST_MS));
+
+    /* several events before the job runs apply once */
+    run_ms(POLL_CTRL_HOLD_MS + 20000);
+    app_poll_rx();
+    app_poll_expect(5000);
+    app_poll_tx();
+    CHECK_EQ(ot_mock_run_jobs(), 1);
+    CHECK_EQ(g_ot_mock.poll_period, POLL_CTRL_FAST_MS);
+    check_stack_use();
+}
+
+/* a child timeout learned in the OpenThread task caps the period */
+static void test_child_timeout(void) {
+    g_ot_mock.role = OT_DEVICE_ROLE_CHILD;
+    g_ot_mock.child_timeout = 40;
+    otrLock();
+    app_poll_state_changed(OT_CHANGED_THREAD_ROLE);
+    otrUnlock();
+    run_ms(300000);
+    CHECK_EQ(g_ot_mock.poll_period, 10000);
+    CHECK_EQ(s_timer->period, pdMS_TO_TICKS(10000));
+    check_stack_use();
+}
+
+/* below the stack's minimum, refused: counted and the timer unchanged */
+static void test_refused(void) {
+    static char* bad[] = {"poll", "set", "5", "5", "0"};
+    static char* good[] = {"poll", "set", "250", "30000", "2000"};
+    uint32_t period = g_ot_mock.poll_period;
+
+    CHECK_EQ(_cli_cmd_poll(5, bad, quiet, NULL), 0);
+    ot_mock_run_jobs();
+    CHECK_EQ(s_apply_failed, 1);
+    CHECK_EQ(g_ot_mock.poll_period, period);
+    CHECK_EQ(s_applied_ms, period);
+    CHECK_EQ(s_timer->period, pdMS_TO_TICKS(period));
+
+    CHECK_EQ(_cli_cmd_poll(5, good, quiet, NULL), 0);
+    ot_mock_run_jobs();
+    CHECK_EQ(s_apply_failed, 1);
+    CHECK_EQ(g_ot_mock.poll_period, 250);
+    CHECK_EQ(s_timer->period, pdMS_TO_TICKS(250));
+    check_stack_use();
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_init_applies_in_ot_task);
+    HOST_TEST_RUN(test_decay_from_timer);
+    HOST_TEST_RUN(test_tx_from_shell);
+    HOST_TEST_RUN(test_child_timeout);
+    HOST_TEST_RUN(test_refused);
+    return HOST_TEST_END();
+}
@@ -0,0 +1,181 @@
+/**
+ * @file test_poll_ctrl.c
+ * @brief Adaptive poll controller of miu-sleepy: the decay to the slow
+ *        period, the child timeout cap, traffic holds, the energy model and
+ *        the trace replay used by "poll compare".
+ */
+
+#include <string.h>
+#include "host_test.h"
+#include "poll_ctrl.h"
+
+static const poll_ctrl_cfg_t s_cfg = {250, 30000, 2000};
+static const poll_ctrl_cfg_t s_static = {1000, 1000, 0};
+
+static void test_init(void) {
+    poll_ctrl_cfg_t cfg = {0, 0, 0};
+    poll_ctrl_t ctrl;
+
+    /* fast defaults, slow never below fast */
+    poll_ctrl_init(&ctrl, &cfg, NULL, 0);
+    CHECK_EQ(ctrl.cfg.fast_ms, POLL_CTRL_FAST_MS);
+    CHECK_EQ(ctrl.cfg.slow_ms, POLL_CTRL_FAST_MS);
+    CHECK_EQ(ctrl.period_ms, POLL_CTRL_FAST_MS);
+    CHECK_EQ(ctrl.model.poll_us, POLL_CTRL_POLL_US);
+    CHECK_EQ(poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_POLL, 100000, 0),
+             POLL_CTRL_FAST_MS);
+}
+
+static void test_decay(void) {
+    static const uint32_t want[] = {500,  1000,  2000,  4000,
+                                    8000, 16000, 30000, 30000};
+    poll_ctrl_t ctrl;
+    uint32_t now = 0, i;
+
+    poll_ctrl_init(&ctrl, &s_cfg, NULL, now);
+
+    /* held fast for hold_ms */
+    while (now + 250 < 2000) {
+        now += 250;
+        CHECK_EQ(poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_POLL, now, 0), 250);
+    }
+    now = 2000;
+    for (i = 0; i < sizeof(want) / sizeof(want[0]); i++) {
+        CHECK_EQ(poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_POLL, now, 0), want[i]);
+        now += ctrl.period_ms;
+    }
+}
+
+static void test_timeout_cap(void) {
+    poll_ctrl_t ctrl;
+    uint32_t now = 0;
+
+    poll_ctrl_init(&ctrl, &s_cfg, NULL, now);
+    CHECK_EQ(poll_ctrl_slow_max(&ctrl), 30000);
+    for (now = 2000; now < 200000; now += ctrl.period_ms) {
+        poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_POLL, now, 0);
+    }
+    CHECK_EQ(ctrl.period_ms, 30000);
+
+    /* a quarter of a 40 s timeout, the period drops at once */
+    CHECK_EQ(poll_ctrl_timeout_set(&ctrl, 40), 10000);
+    CHECK_EQ(poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_POLL, now, 0), 10000);
+
+    /* a timeout below the fast period keeps the fast period */
+    CHECK_EQ(poll_ctrl_timeout_set(&ctrl, 0), 10000);
+    CHECK_EQ(poll_ctrl_slow_max(&ctrl), 30000);
+    ctrl.timeout_ms = 500;
+    CHECK_EQ(poll_ctrl_slow_max(&ctrl), 250);
+}
+
+static void test_traffic(void) {
+    poll_ctrl_t ctrl;
+
+    poll_ctrl_init(&ctrl, &s_cfg, NULL, 0);
+    ctrl.period_ms = 16000;
+    CHECK_EQ(poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_TX, 50000, 0), 250);
+    CHECK_EQ(ctrl.fast_until_ms, 52000);
+    CHECK_EQ(poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_POLL, 51999, 0), 250);
+
+    /* a longer expect window extends the hold, a shorter one does not */
+    poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_EXPECT, 51000, 5000);
+    CHECK_EQ(ctrl.fast_until_ms, 56000);
+    poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_EXPECT, 51000, 100);
+    CHECK_EQ(ctrl.fast_until_ms, 56000);
+    CHECK_EQ(poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_POLL, 55999, 0), 250);
+    CHECK_EQ(poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_POLL, 56000, 0), 500);
+
+    CHECK_EQ(poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_RX, 57000, 0), 250);
+    CHECK_EQ(ctrl.tx, 1);
+    CHECK_EQ(ctrl.rx, 1);
+    CHECK_EQ(ctrl.polls, 3);
+    CHECK_EQ(ctrl.radio_on_us,
+             3 * POLL_CTRL_POLL_US + POLL_CTRL_TX_US + POLL_CTRL_RX_US);
+}
+
+/* the hold and the doubling across the 32-bit millisecond wrap */
+static void test_wrap(void) {
+    poll_ctrl_t ctrl;
+    uint32_t now = UINT32_MAX - 1000;
+
+    poll_ctrl_init(&ctrl, &s_cfg, NULL, now);
+    CHECK_EQ(poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_POLL, now + 500, 0), 250);
+    CHECK_EQ(poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_POLL, now + 1500, 0), 250);
+    CHECK_EQ(poll_ctrl_event(&ctrl, POLL_CTRL_EVENT_POLL, now + 2000, 0), 500);
+}
+
+static void test_radio_per_hour(void) {
+    poll_ctrl_t ctrl;
+
+    poll_ctrl_init(&ctrl, &s_static, NULL, 0);
+    CHECK_EQ(poll_ctrl_radio_ms_per_hour(&ctrl), 3600 * POLL_CTRL_POLL_US / 1000);
+    ctrl.period_ms = 30000;
+    CHECK_EQ(poll_ctrl_radio_ms_per_hour(&ctrl), 120 * POLL_CTRL_POLL_US / 1000);
+}
+
+static void test_replay_static(void) {
+    static const poll_ctrl_trace_t tx[] = {{0, 0, POLL_CTRL_EVENT_TX}};
+    static const poll_ctrl_trace_t rx[] = {{0, 0, POLL_CTRL_EVENT_TX},
+                                           {500, 0, POLL_CTRL_EVENT_RX}};
+    poll_ctrl_result_t r;
+
+    poll_ctrl_replay(&s_static, NULL, 0, tx, 0, 10000, &r);
+    CHECK_EQ(r.polls, 0);
+
+    poll_ctrl_replay(&s_static, NULL, 0, tx, 1, 10000, &r);
+    CHECK_EQ(r.polls, 10);
+    CHECK_EQ(r.rx, 0);
+    CHECK_EQ(r.radio_on_ms, (10 * POLL_CTRL_POLL_US + POLL_CTRL_TX_US) / 1000);
+
+    /* the frame waits at the parent for the poll at 1000 */
+    poll_ctrl_replay(&s_static, NULL, 0, rx, 2, 2000, &r);
+    CHECK_EQ(r.polls, 2);
+    CHECK_EQ(r.rx, 1);
+    CHECK_EQ(r.latency_avg_ms, 500);
+    CHECK_EQ(r.latency_max_ms, 500);
+}
+
+/* request and reply bursts a minute apart: the adaptive controller answers
+ * about as fast as a fast static period and polls about as rarely as a
+ * slow one */
+static void test_replay_compare(void) {
+    poll_ctrl_cfg_t fast = {250, 250, 0};
+    poll_ctrl_cfg_t slow = {30000, 30000, 0};
+    poll_ctrl_trace_t trace[60];
+    poll_ctrl_result_t a, f, s;
+    uint32_t end, i;
+
+    for (i = 0; i < 20; i++) {
+        trace[3 * i] = (poll_ctrl_trace_t){i * 60000, 0, POLL_CTRL_EVENT_TX};
+        trace[3 * i + 1] = (poll_ctrl_trace_t){i * 60000 + 300, 0,
+                                               POLL_CTRL_EVENT_RX};
+        trace[3 * i + 2] = (poll_ctrl_trace_t){i * 60000 + 700, 0,
+                                               POLL_CTRL_EVENT_RX};
+    }
+    end = 20 * 60000;
+
+    poll_ctrl_replay(&s_cfg, NULL, 240, trace, 60, end, &a);
+    poll_ctrl_replay(&fast, NULL, 240, trace, 60, end, &f);
+    poll_ctrl_replay(&slow, NULL, 240, trace, 60, end, &s);
+
+    CHECK_EQ(a.rx, 40);
+    CHECK_EQ(f.rx, 40);
+    CHECK_EQ(s.rx, 40);
+    CHECK(a.latency_max_ms <= 250);
+    CHECK(f.latency_max_ms <= 250);
+    CHECK(s.latency_avg_ms > 10000);
+    CHECK(a.polls < f.polls / 10);
+    CHECK(a.radio_on_ms < f.radio_on_ms / 5);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_init);
+    HOST_TEST_RUN(test_decay);
+    HOST_TEST_RUN(test_timeout_cap);
+    HOST_TEST_RUN(test_traffic);
+    HOST_TEST_RUN(test_wrap);
+    HOST_TEST_RUN(test_radio_per_hour);
+    HOST_TEST_RUN(test_replay_static);
+    HOST_TEST_RUN(test_replay_compare);
+    return HOST_TEST_END();
+}
@@ -0,0 +1,32 @@
+/**
+ * @file host_rtos_sleep.h
+ * @brief Tickless idle of the POSIX port for the power telemetry test: a
+ *        mock of the Cortex-M sleep routine, and the hooks miu-sleepy sets
+ *        in its FreeRTOSConfig.h.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Stands in for vPortSuppressTicksAndSleep() of ARM_CM3 and ARM_CM33_NTZ */
+void host_suppress_ticks_and_sleep(uint32_t expected_idle_ticks);
+/* The sleep hook, counts the sleeps the port goes into */
+void host_pre_sleep(uint32_t expected_idle_ticks);
+/* Pending bit of a mock interrupt line */
+bool host_irq_pending(int irq);
+
+#define portSUPPRESS_TICKS_AND_SLEEP(x) host_suppress_ticks_and_sleep((uint32_t)(x))
+#define configPRE_SLEEP_PROCESSING(x)   host_pre_sleep((uint32_t)(x))
+#define PWR_TELEMETRY_IRQ_PENDING(irq)  host_irq_pending(irq)
+
+/* Power state telemetry hooks, as in miu-sleepy */
+void pwr_telemetry_task_switched_in(void* task);
+void pwr_telemetry_sleep_enter(uint32_t expected_idle_ticks);
+void pwr_telemetry_sleep_exit(void);
+void pwr_telemetry_sleep_wake(void);
+#define traceTASK_SWITCHED_IN()     pwr_telemetry_task_switched_in((void*)pxCurrentTCB)
+#define traceLOW_POWER_IDLE_BEGIN() pwr_telemetry_sleep_enter((uint32_t)xExpectedIdleTime)
+#define traceLOW_POWER_IDLE_END()   pwr_telemetry_sleep_exit()
+#define configPOST_SLEEP_PROCESSING(x) pwr_telemetry_sleep_wake()
@@ -0,0 +1,16 @@
+/**
+ * @file pwr_mock.h
+ * @brief Time base and interrupt lines of the mock sleep routine, forced
+ *        into pwr_telemetry.c in place of the RTOS tick and the NVIC.
+ */
+
+#ifndef __PWR_MOCK_H
+#define __PWR_MOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+uint32_t stub_time_us(void);
+bool stub_irq_pending(int irq);
+
+#endif // __PWR_MOCK_H
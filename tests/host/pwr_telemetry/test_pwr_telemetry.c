@@ -0,0 +1,187 @@
+/**
+ * @file test_pwr_telemetry.c
+ * @brief Power telemetry of miu-sleepy against a mock sleep routine that
+ *        calls the hooks in the order of the Cortex-M tickless idle:
+ *        sleep_enter, WFI, sleep_wake with interrupts masked, the handler
+ *        of the waking interrupt, sleep_exit.
+ */
+
+#include <string.h>
+#include "FreeRTOS.h"
+#include "host_test.h"
+#include "pwr_mock.h"
+#include "pwr_telemetry.h"
+#include "task.h"
+
+#define IRQ_RADIO 1
+#define IRQ_GPIO  2
+#define IRQ_UART  3
+#define IRQ_OTHER 9
+
+static bool s_pending[16];
+
+uint32_t stub_time_us(void) { return g_stub_tick * 1000UL; }
+
+bool stub_irq_pending(int irq) { return s_pending[irq]; }
+
+static stub_task_t s_app = {"app"};
+static stub_task_t s_ot = {"ot"};
+
+/* handler of the waking interrupt, runs after the mask is lifted */
+typedef void (*mock_isr_t)(void);
+
+static void isr_radio(void) {
+    pwr_telemetry_wakeup_mark(PWR_TELEMETRY_WAKEUP_RADIO);
+}
+
+/**
+ * Sleep for at most @p expected ticks, woken after @p ticks by @p irq
+ * (-1 for the tickless wakeup timer). Every handler clears its pending bit,
+ * like the SDK drivers do.
+ */
+static void mock_sleep(uint32_t expected, uint32_t ticks, int irq,
+                       mock_isr_t isr) {
+    pwr_telemetry_task_switched_in(&g_stub_idle_task);
+    pwr_telemetry_sleep_enter(expected);
+    g_stub_tick += ticks;
+    if (irq >= 0) {
+        s_pending[irq] = true;
+    }
+    pwr_telemetry_sleep_wake();
+    if (irq >= 0) {
+        s_pending[irq] = false;
+        if (isr) {
+            isr();
+        }
+    }
+    pwr_telemetry_sleep_exit();
+}
+
+static void setup(void) {
+    memset(s_pending, 0, sizeof(s_pending));
+    g_stub_tick = 1000;
+    pwr_telemetry_init();
+    pwr_telemetry_wakeup_irq_set(IRQ_RADIO, PWR_TELEMETRY_WAKEUP_RADIO);
+    pwr_telemetry_wakeup_irq_set(IRQ_GPIO, PWR_TELEMETRY_WAKEUP_GPIO);
+    pwr_telemetry_wakeup_irq_set(IRQ_UART, PWR_TELEMETRY_WAKEUP_UART);
+    pwr_telemetry_task_switched_in(&s_app);
+}
+
+static void test_timer_wakeup(void) {
+    pwr_telemetry_summary_t sum;
+
+    setup();
+    mock_sleep(100, 100, -1, NULL);
+    pwr_telemetry_summary_get(&sum);
+    CHECK_EQ(sum.wakeups[PWR_TELEMETRY_WAKEUP_TIMER], 1);
+    CHECK_EQ(sum.short_sleeps, 0);
+    CHECK_EQ(sum.state_us[PWR_TELEMETRY_STATE_SLEEP], 100000);
+}
+
+/* the handler clears the line before sleep_exit: only sleep_wake sees it */
+static void test_irq_sampled_before_handler(void) {
+    pwr_telemetry_summary_t sum;
+
+    setup();
+    mock_sleep(100, 30, IRQ_GPIO, NULL);
+    mock_sleep(100, 30, IRQ_UART, NULL);
+    pwr_telemetry_summary_get(&sum);
+    CHECK_EQ(sum.wakeups[PWR_TELEMETRY_WAKEUP_GPIO], 1);
+    CHECK_EQ(sum.wakeups[PWR_TELEMETRY_WAKEUP_UART], 1);
+    CHECK_EQ(sum.wakeups[PWR_TELEMETRY_WAKEUP_OTHER], 0);
+    CHECK_EQ(sum.short_sleeps, 2);
+}
+
+static void test_isr_mark_wins(void) {
+    pwr_telemetry_summary_t sum;
+
+    setup();
+    /* UART also pending, the radio handler ran first and marked */
+    s_pending[IRQ_UART] = true;
+    mock_sleep(100, 10, IRQ_RADIO, isr_radio);
+    s_pending[IRQ_UART] = false;
+    /* a mark outside of sleep is ignored */
+    pwr_telemetry_wakeup_mark(PWR_TELEMETRY_WAKEUP_GPIO);
+    mock_sleep(100, 100, -1, NULL);
+    pwr_telemetry_summary_get(&sum);
+    CHECK_EQ(sum.wakeups[PWR_TELEMETRY_WAKEUP_RADIO], 1);
+    CHECK_EQ(sum.wakeups[PWR_TELEMETRY_WAKEUP_UART], 0);
+    CHECK_EQ(sum.wakeups[PWR_TELEMETRY_WAKEUP_GPIO], 0);
+    CHECK_EQ(sum.wakeups[PWR_TELEMETRY_WAKEUP_TIMER], 1);
+}
+
+static void test_unmapped_irq(void) {
+    pwr_telemetry_summary_t sum;
+
+    setup();
+    mock_sleep(100, 5, IRQ_OTHER, NULL);
+    pwr_telemetry_summary_get(&sum);
+    CHECK_EQ(sum.wakeups[PWR_TELEMETRY_WAKEUP_OTHER], 1);
+    CHECK_EQ(sum.short_sleeps, 1);
+}
+
+static void test_residency_and_tasks(void) {
+    pwr_telemetry_summary_t sum;
+    pwr_telemetry_task_t tasks[PWR_TELEMETRY_TASK_MAX];
+    uint8_t num, i;
+    uint32_t ot_wakeups = 0, ot_breaks = 0, app_active = 0;
+
+    setup();
+    g_stub_tick += 5; /* app runs 5 ms */
+    mock_sleep(50, 50, -1, NULL);
+    pwr_telemetry_task_switched_in(&s_ot); /* first task after the wakeup */
+    g_stub_tick += 2;
+    pwr_telemetry_task_switched_in(&g_stub_idle_task);
+    g_stub_tick += 1;
+    pwr_telemetry_task_switched_in(&s_ot); /* broke idle before sleeping */
+    g_stub_tick += 3;
+    pwr_telemetry_task_switched_in(&s_app);
+    g_stub_tick += 4;
+
+    pwr_telemetry_summary_get(&sum);
+    CHECK_EQ(sum.elapsed_us, 65000);
+    CHECK_EQ(sum.state_us[PWR_TELEMETRY_STATE_ACTIVE], 14000);
+    CHECK_EQ(sum.state_us[PWR_TELEMETRY_STATE_IDLE], 1000);
+    CHECK_EQ(sum.state_us[PWR_TELEMETRY_STATE_SLEEP], 50000);
+
+    num = pwr_telemetry_task_get(tasks, PWR_TELEMETRY_TASK_MAX);
+    CHECK_EQ(num, 2);
+    for (i = 0; i < num; i++) {
+        if (!strcmp(tasks[i].name, "ot")) {
+            ot_wakeups = tasks[i].wakeups;
+            ot_breaks = tasks[i].idle_breaks;
+        } else if (!strcmp(tasks[i].name, "app")) {
+            app_active = (uint32_t)tasks[i].active_us;
+        }
+    }
+    CHECK_EQ(ot_wakeups, 1);
+    CHECK_EQ(ot_breaks, 1);
+    CHECK_EQ(app_active, 5000); /* the last 4 ms are not switched out yet */
+}
+
+static void test_radio_residency(void) {
+    pwr_telemetry_summary_t sum;
+
+    setup();
+    pwr_telemetry_radio_set(PWR_TELEMETRY_RADIO_RX);
+    g_stub_tick += 10;
+    pwr_telemetry_radio_set(PWR_TELEMETRY_RADIO_TX);
+    g_stub_tick += 2;
+    pwr_telemetry_radio_set(PWR_TELEMETRY_RADIO_OFF);
+    mock_sleep(20, 20, -1, NULL);
+
+    pwr_telemetry_summary_get(&sum);
+    CHECK_EQ(sum.radio_us[PWR_TELEMETRY_RADIO_RX], 10000);
+    CHECK_EQ(sum.radio_us[PWR_TELEMETRY_RADIO_TX], 2000);
+    CHECK_EQ(sum.radio_us[PWR_TELEMETRY_RADIO_OFF], 20000);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_timer_wakeup);
+    HOST_TEST_RUN(test_irq_sampled_before_handler);
+    HOST_TEST_RUN(test_isr_mark_wins);
+    HOST_TEST_RUN(test_unmapped_irq);
+    HOST_TEST_RUN(test_residency_and_tasks);
+    HOST_TEST_RUN(test_radio_residency);
+    return HOST_TEST_END();
+}
@@ -0,0 +1,153 @@
+/**
+ * @file test_pwr_telemetry_rtos.c
+ * @brief Power telemetry of miu-sleepy on the kernel over the POSIX port,
+ *        with tickless idle: the idle task calls portSUPPRESS_TICKS_AND_SLEEP
+ *        between traceLOW_POWER_IDLE_BEGIN and _END, the mock sleep routine
+ *        calls configPRE_SLEEP_PROCESSING and configPOST_SLEEP_PROCESSING
+ *        around the sleep, then the handler of the waking interrupt.
+ *
+ * The mock sleeps no real time. It steps the tick count like the Cortex-M
+ * ports, one short of a full sleep with the last tick left pending, so the
+ * sleep time seen by the telemetry is the one stepped here. The tick of
+ * the port keeps running but is only pended while the idle task sleeps.
+ */
+
+#include <string.h>
+#include "FreeRTOS.h"
+#include "host_test.h"
+#include "pwr_telemetry.h"
+#include "task.h"
+
+#define IRQ_RADIO 1
+#define IRQ_GPIO  2
+#define IRQ_UART  3
+#define IRQ_OTHER 9
+
+#define APP_PRIORITY  2
+#define APP_PERIOD_MS 100
+
+typedef struct {
+    int irq;        /* -1 for the tickless wakeup timer */
+    uint32_t ticks; /* into the sleep */
+    bool mark;      /* the handler marks a radio wakeup */
+} wake_t;
+
+static const wake_t s_wakes[] = {
+    {-1, 0, false},
+    {IRQ_GPIO, 30, false},
+    {IRQ_OTHER, 10, true}, /* shared line, the MAC callback marks */
+    {IRQ_OTHER, 5, false},
+};
+
+#define WAKE_NUM (sizeof(s_wakes) / sizeof(s_wakes[0]))
+
+static bool s_pending[16];
+static const wake_t* volatile s_wake;
+static TaskHandle_t s_app;
+static uint32_t s_sleeps;
+static uint64_t s_slept_us;
+
+static pwr_telemetry_summary_t s_sum;
+static pwr_telemetry_task_t s_tasks[PWR_TELEMETRY_TASK_MAX];
+static uint8_t s_task_num;
+
+bool host_irq_pending(int irq) { return s_pending[irq]; }
+
+void host_pre_sleep(uint32_t expected_idle_ticks) { s_sleeps++; }
+
+/* clears its line like the SDK drivers and hands over to the app task */
+static void mock_isr(const wake_t* w) {
+    s_pending[w->irq] = false;
+    if (w->mark) {
+        pwr_telemetry_wakeup_mark(PWR_TELEMETRY_WAKEUP_RADIO);
+    }
+    vTaskNotifyGiveFromISR(s_app, NULL);
+}
+
+void host_suppress_ticks_and_sleep(uint32_t expected_idle_ticks) {
+    const wake_t* w;
+    uint32_t slept;
+
+    portDISABLE_INTERRUPTS();
+    if (eTaskConfirmSleepModeStatus() == eAbortSleep) {
+        portENABLE_INTERRUPTS();
+        return;
+    }
+
+    configPRE_SLEEP_PROCESSING(expected_idle_ticks);
+    /* the sleep: the line of the wakeup goes pending after its ticks */
+    w = s_wake;
+    s_wake = NULL;
+    if (w != NULL && w->irq >= 0 && w->ticks < expected_idle_ticks) {
+        s_pending[w->irq] = true;
+        slept = w->ticks;
+    } else {
+        w = NULL;
+        slept = expected_idle_ticks - 1;
+    }
+    configPOST_SLEEP_PROCESSING(expected_idle_ticks);
+
+    /* the waking interrupt runs once unmasked, the tick interrupt that
+     * ended a full sleep is pended as the scheduler is suspended; the
+     * signals of the port stay masked, as in a handler */
+    if (w != NULL) {
+        mock_isr(w);
+    } else {
+        (void)xTaskIncrementTick();
+    }
+    vTaskStepTick(slept);
+    s_slept_us += slept * 1000ULL;
+
+    portENABLE_INTERRUPTS();
+}
+
+static void app_task(void* pArg) {
+    uint32_t i;
+
+    pwr_telemetry_init();
+    pwr_telemetry_wakeup_irq_set(IRQ_RADIO, PWR_TELEMETRY_WAKEUP_RADIO);
+    pwr_telemetry_wakeup_irq_set(IRQ_GPIO, PWR_TELEMETRY_WAKEUP_GPIO);
+    pwr_telemetry_wakeup_irq_set(IRQ_UART, PWR_TELEMETRY_WAKEUP_UART);
+
+    for (i = 0; i < WAKE_NUM; i++) {
+        s_wake = &s_wakes[i];
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(APP_PERIOD_MS));
+    }
+
+    pwr_telemetry_summary_get(&s_sum);
+    s_task_num = pwr_telemetry_task_get(s_tasks, PWR_TELEMETRY_TASK_MAX);
+    vTaskEndScheduler();
+}
+
+static void test_tickless_idle(void) {
+    uint32_t app_wakeups = 0;
+    uint8_t i;
+
+    CHECK_EQ(s_sleeps, WAKE_NUM);
+    CHECK_EQ(s_sum.state_entries[PWR_TELEMETRY_STATE_SLEEP], WAKE_NUM);
+    CHECK_EQ(s_sum.state_us[PWR_TELEMETRY_STATE_SLEEP], s_slept_us);
+
+    /* the GPIO line was cleared by its handler, sampled before it ran */
+    CHECK_EQ(s_sum.wakeups[PWR_TELEMETRY_WAKEUP_TIMER], 1);
+    CHECK_EQ(s_sum.wakeups[PWR_TELEMETRY_WAKEUP_GPIO], 1);
+    CHECK_EQ(s_sum.wakeups[PWR_TELEMETRY_WAKEUP_RADIO], 1);
+    CHECK_EQ(s_sum.wakeups[PWR_TELEMETRY_WAKEUP_OTHER], 1);
+    CHECK_EQ(s_sum.wakeups[PWR_TELEMETRY_WAKEUP_UART], 0);
+    CHECK_EQ(s_sum.short_sleeps, WAKE_NUM - 1);
+
+    for (i = 0; i < s_task_num; i++) {
+        if (!strcmp(s_tasks[i].name, "app")) {
+            app_wakeups = s_tasks[i].wakeups;
+        }
+    }
+    CHECK_EQ(app_wakeups, WAKE_NUM);
+}
+
+int main(void) {
+    xTaskCreate(app_task, "app", configMINIMAL_STACK_SIZE, NULL, APP_PRIORITY,
+                &s_app);
+    vTaskStartScheduler();
+
+    HOST_TEST_RUN(test_tickless_idle);
+    return HOST_TEST_END();
+}
@@ -0,0 +1,259 @@
+/**
+ * @file bench_rtos_pool.c
+ * @brief A fixed block pool shared by tasks that preempt each other, over
+ *        the POSIX port, against pvPortMalloc() of the same blocks.
+ *
+ * Two workers at one priority are time sliced by the tick, two more at
+ * higher priorities wake every tick and run a burst, so allocations and
+ * frees are preempted part way. Each worker stamps the blocks it takes and
+ * checks the stamp before giving them back: a block handed to two tasks
+ * or a free list broken by a preemption shows up as a bad stamp, a lost
+ * block or a pool that is not empty at the end.
+ *
+ * The POSIX port runs one task at a time and enters a critical section
+ * with a signal mask call, so the cost per operation here is mostly the
+ * system call and only compares the two allocators on the host, the
+ * target masks interrupts in a few instructions.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "rtos_pool.h"
+
+#define BLOCK_SIZE     64
+#define BLOCKS         24
+#define HELD_MAX       8
+#define RUN_TICKS      2000
+#define BURST          2000
+#define WORKER_MAX     4
+#define CTRL_PRIORITY  (configMAX_PRIORITIES - 1)
+
+typedef enum {
+    MODE_POOL,
+    MODE_HEAP,
+} bench_mode_t;
+
+typedef struct {
+    const char *pName;
+    bench_mode_t mode;
+    uint8_t workers;
+} run_t;
+
+typedef struct {
+    uint32_t owner;
+    uint32_t seq;
+} stamp_t;
+
+typedef struct {
+    uint64_t ops;
+    uint64_t ns;
+    uint32_t bad;
+    uint32_t empty;
+    uint16_t used;
+    uint16_t peak;
+    uint16_t free;
+} result_t;
+
+static const run_t s_runs[] = {
+    {"pool, 1 task", MODE_POOL, 1},
+    {"pool, 4 tasks", MODE_POOL, 4},
+    {"heap, 1 task", MODE_HEAP, 1},
+    {"heap, 4 tasks", MODE_HEAP, 4},
+};
+
+#define RUN_NUM (sizeof(s_runs) / sizeof(s_runs[0]))
+
+static const UBaseType_t s_worker_prio[WORKER_MAX] = {2, 2, 3, 4};
+
+static uint8_t s_storage[RTOS_POOL_STORAGE_SIZE(BLOCK_SIZE, BLOCKS)] __attribute__((aligned(RTOS_POOL_ALIGN)));
+static rtos_pool_t s_pool_buf;
+static rtos_pool_t *s_pool;
+
+static TaskHandle_t s_ctrl;
+static bench_mode_t s_mode;
+static volatile int s_stop;
+static volatile uint64_t s_ops;
+static volatile uint32_t s_bad;
+static volatile uint32_t s_empty;
+static result_t s_result[RUN_NUM];
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void *block_alloc(void) {
+    return s_mode == MODE_POOL ? rtos_pool_alloc(s_pool) : pvPortMalloc(BLOCK_SIZE);
+}
+
+static void block_free(void *pBlock) {
+    if (s_mode == MODE_POOL) {
+        rtos_pool_free(s_pool, pBlock);
+    } else {
+        vPortFree(pBlock);
+    }
+}
+
+/* the whole block carries the stamp, a second owner overwrites some of it */
+static void stamp_set(void *pBlock, uint32_t owner, uint32_t seq) {
+    stamp_t stamp = {owner, seq};
+    uint8_t *p = pBlock;
+    uint32_t i;
+
+    for (i = 0; i + sizeof(stamp) <= BLOCK_SIZE; i += sizeof(stamp)) {
+        memcpy(p + i, &stamp, sizeof(stamp));
+    }
+}
+
+static int stamp_ok(const void *pBlock, uint32_t owner, uint32_t seq) {
+    stamp_t stamp = {owner, seq};
+    const uint8_t *p = pBlock;
+    uint32_t i;
+
+    for (i = 0; i + sizeof(stamp) <= BLOCK_SIZE; i += sizeof(stamp)) {
+        if (memcmp(p + i, &stamp, sizeof(stamp)) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void worker_task(void *pArg) {
+    uint32_t owner = (uint32_t)(uintptr_t)pArg;
+    uint32_t rnd = 0x9E3779B9u * (owner + 1);
+    void *held[HELD_MAX];
+    uint32_t seq[HELD_MAX];
+    uint32_t num = 0, next = 0, ops = 0, bad = 0, empty = 0, i;
+
+    while (!s_stop) {
+        rnd ^= rnd << 13;
+        rnd ^= rnd >> 17;
+        rnd ^= rnd << 5;
+        if (num == 0 || (num < HELD_MAX && (rnd & 1))) {
+            held[num] = block_alloc();
+            if (!held[num]) {
+                empty++;
+                continue;
+            }
+            seq[num] = next++;
+            stamp_set(held[num], owner, seq[num]);
+            num++;
+        } else {
+            i = (rnd >> 8) % num;
+            if (!stamp_ok(held[i], owner, seq[i])) {
+                bad++;
+            }
+            block_free(held[i]);
+            num--;
+            held[i] = held[num];
+            seq[i] = seq[num];
+        }
+        ops++;
+
+        /* the higher workers run a burst each tick */
+        if (s_worker_prio[owner] > s_worker_prio[0] && ops % BURST == 0) {
+            vTaskDelay(1);
+        }
+    }
+
+    for (i = 0; i < num; i++) {
+        if (!stamp_ok(held[i], owner, seq[i])) {
+            bad++;
+        }
+        block_free(held[i]);
+    }
+
+    taskENTER_CRITICAL();
+    s_ops += ops;
+    s_bad += bad;
+    s_empty += empty;
+    taskEXIT_CRITICAL();
+    xTaskNotifyGive(s_ctrl);
+    vTaskSuspend(NULL);
+}
+
+static uint16_t pool_free_len(void) {
+    void *pBlock;
+    uint16_t num = 0;
+
+    for (pBlock = s_pool->free_list; pBlock && num <= BLOCKS; pBlock = *(void **)pBlock) {
+        num++;
+    }
+    return num;
+}
+
+static void ctrl_task(void *pArg) {
+    TaskHandle_t workers[WORKER_MAX];
+    rtos_pool_stats_t stats;
+    result_t *pRes;
+    uint64_t t0;
+    uint32_t i;
+    uint8_t k;
+
+    for (i = 0; i < RUN_NUM; i++) {
+        pRes = &s_result[i];
+        s_pool = rtos_pool_create_static("bench", BLOCK_SIZE, BLOCKS, s_storage, &s_pool_buf);
+        s_mode = s_runs[i].mode;
+        s_stop = 0;
+        s_ops = 0;
+        s_bad = 0;
+        s_empty = 0;
+
+        t0 = now_ns();
+        for (k = 0; k < s_runs[i].workers; k++) {
+            xTaskCreate(worker_task, "worker", configMINIMAL_STACK_SIZE, (void *)(uintptr_t)k,
+                        s_worker_prio[k], &workers[k]);
+        }
+        vTaskDelay(RUN_TICKS);
+        s_stop = 1;
+        for (k = 0; k < s_runs[i].workers; k++) {
+            ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+        }
+        pRes->ns = now_ns() - t0;
+
+        for (k = 0; k < s_runs[i].workers; k++) {
+            vTaskDelete(workers[k]);
+        }
+        /* the idle task frees the deleted tasks */
+        vTaskDelay(10);
+
+        rtos_pool_stats(s_pool, &stats);
+        pRes->ops = s_ops;
+        pRes->bad = s_bad;
+        pRes->empty = s_empty;
+        pRes->used = stats.used;
+        pRes->peak = stats.peak;
+        pRes->free = pool_free_len();
+    }
+    vTaskEndScheduler();
+}
+
+int main(void) {
+    result_t *pRes;
+    uint32_t i;
+    int fail = 0;
+
+    xTaskCreate(ctrl_task, "ctrl", configMINIMAL_STACK_SIZE, NULL, CTRL_PRIORITY, &s_ctrl);
+    vTaskStartScheduler();
+
+    printf("%u blocks of %u bytes, up to %u held per task, %u ticks per run\n", BLOCKS, BLOCK_SIZE,
+           HELD_MAX, RUN_TICKS);
+    for (i = 0; i < RUN_NUM; i++) {
+        pRes = &s_result[i];
+        printf("%-14s %.0f ns/op, %llu ops, %lu bad stamps, %lu empty", s_runs[i].pName,
+               pRes->ops ? (double)pRes->ns / pRes->ops : 0.0, (unsigned long long)pRes->ops,
+               (unsigned long)pRes->bad, (unsigned long)pRes->empty);
+        if (s_runs[i].mode == MODE_POOL) {
+            printf(", peak %u, %u used and %u free at the end", pRes->peak, pRes->used, pRes->free);
+            fail |= pRes->used != 0 || pRes->free != BLOCKS;
+        }
+        printf("\n");
+        fail |= pRes->bad != 0 || pRes->ops == 0;
+    }
+    return fail;
+}
@@ -0,0 +1,307 @@
+/**
+ * @file test_rtos_pool.c
+ * @brief Fixed block pools: creation, exhaustion and reuse, the statistics,
+ *        size-class sets and, built with RTOS_POOL_DEBUG 1, the header and
+ *        guard checks.
+ *
+ * The source is included so the free list can be walked directly. Failed
+ * assertions are counted instead of aborting, so the debug checks can be
+ * provoked.
+ */
+
+#include <stdlib.h>
+
+static int s_asserts;
+#define configASSERT(x)                                                        \
+    do {                                                                       \
+        if (!(x)) {                                                            \
+            s_asserts++;                                                       \
+        }                                                                      \
+    } while (0)
+
+#include "rtos_pool.c"
+#include "host_test.h"
+
+#define BLOCKS 16
+
+static uint8_t s_storage[RTOS_POOL_STORAGE_SIZE(40, BLOCKS)]
+    __attribute__((aligned(RTOS_POOL_ALIGN)));
+
+static uint16_t free_len(const rtos_pool_t* pool) {
+    void* block;
+    uint16_t num = 0;
+
+    for (block = pool->free_list; block; block = *(void**)block) {
+        num++;
+    }
+    return num;
+}
+
+static void test_create_static(void) {
+    rtos_pool_t pool;
+
+    CHECK(rtos_pool_create_static("p", 0, BLOCKS, s_storage, &pool) == NULL);
+    CHECK(rtos_pool_create_static("p", 40, 0, s_storage, &pool) == NULL);
+    CHECK(rtos_pool_create_static("p", 40, BLOCKS, NULL, &pool) == NULL);
+    CHECK(rtos_pool_create_static("p", 40, BLOCKS, s_storage, NULL) == NULL);
+    /* the stride has to fit 16 bits */
+    CHECK(rtos_pool_create_static("p", 0xFFFF, 1, s_storage, &pool) == NULL);
+
+    CHECK(rtos_pool_create_static("p", 40, BLOCKS, s_storage, &pool) == &pool);
+    CHECK_EQ(pool.stride, RTOS_POOL_STRIDE(40));
+    CHECK_EQ(pool.stride % RTOS_POOL_ALIGN, 0);
+    CHECK_EQ(free_len(&pool), BLOCKS);
+    CHECK(pool.end == s_storage + sizeof(s_storage));
+    CHECK_EQ(s_asserts, 0);
+}
+
+static void test_exhaust_and_reuse(void) {
+    rtos_pool_t pool;
+    rtos_pool_stats_t stats;
+    uint8_t* block[BLOCKS];
+    uint16_t i;
+
+    rtos_pool_create_static("p", 40, BLOCKS, s_storage, &pool);
+
+    /* address order, aligned, whole payload writable */
+    for (i = 0; i < BLOCKS; i++) {
+        block[i] = rtos_pool_alloc(&pool);
+        CHECK(block[i] != NULL);
+        CHECK(rtos_pool_owns(&pool, block[i]));
+        CHECK_EQ((uintptr_t)block[i] % RTOS_POOL_ALIGN, 0);
+        if (i) {
+            CHECK(block[i] == block[i - 1] + pool.stride);
+        }
+        memset(block[i], 0xA0 + i, 40);
+    }
+    CHECK(rtos_pool_alloc(&pool) == NULL);
+    CHECK(rtos_pool_alloc(&pool) == NULL);
+    rtos_pool_stats(&pool, &stats);
+    CHECK_EQ(stats.used, BLOCKS);
+    CHECK_EQ(stats.peak, BLOCKS);
+    CHECK_EQ(stats.failures, 2);
+    CHECK(strcmp(stats.name, "p") == 0);
+
+    /* last freed, first reused */
+    rtos_pool_free(&pool, block[3]);
+    rtos_pool_free(&pool, block[9]);
+    CHECK(rtos_pool_alloc(&pool) == block[9]);
+    CHECK(rtos_pool_alloc(&pool) == block[3]);
+
+    for (i = 0; i < BLOCKS; i++) {
+        rtos_pool_free(&pool, block[i]);
+    }
+    rtos_pool_free(&pool, NULL);
+    rtos_pool_stats(&pool, &stats);
+    CHECK_EQ(stats.used, 0);
+    CHECK_EQ(stats.peak, BLOCKS);
+    CHECK_EQ(free_len(&pool), BLOCKS);
+
+    rtos_pool_alloc(&pool);
+    rtos_pool_stats_reset(&pool);
+    rtos_pool_stats(&pool, &stats);
+    CHECK_EQ(stats.peak, 1);
+    CHECK_EQ(stats.failures, 0);
+    CHECK(!rtos_pool_owns(&pool, s_storage + sizeof(s_storage)));
+    CHECK(!rtos_pool_owns(&pool, &pool));
+    CHECK_EQ(s_asserts, 0);
+}
+
+/* blocks smaller than a pointer still hold the free list link */
+static void test_small_blocks(void) {
+    rtos_pool_t pool;
+    uint8_t* a;
+    uint8_t* b;
+
+    CHECK(rtos_pool_create_static("small", 1, BLOCKS, s_storage, &pool) != NULL);
+    CHECK(pool.stride >= sizeof(void*));
+    a = rtos_pool_alloc(&pool);
+    b = rtos_pool_alloc(&pool);
+    CHECK(b - a == pool.stride);
+    *a = 0x55;
+    rtos_pool_free(&pool, a);
+    CHECK_EQ(free_len(&pool), BLOCKS - 1);
+    rtos_pool_free(&pool, b);
+    CHECK_EQ(free_len(&pool), BLOCKS);
+    CHECK_EQ(s_asserts, 0);
+}
+
+static void test_dynamic(void) {
+    rtos_pool_t* pool;
+    void* block;
+
+    CHECK(rtos_pool_create("dyn", 0, 4) == NULL);
+    pool = rtos_pool_create("dyn", 100, 4);
+    CHECK(pool != NULL);
+    CHECK(pool->dynamic);
+    CHECK_EQ((uintptr_t)pool->base % RTOS_POOL_ALIGN, 0);
+    CHECK(pool->base >= (uint8_t*)(pool + 1));
+    block = rtos_pool_alloc(pool);
+    memset(block, 0xEE, 100);
+    rtos_pool_free(pool, block);
+    rtos_pool_delete(pool);
+    rtos_pool_delete(NULL);
+    CHECK_EQ(s_asserts, 0);
+}
+
+static void test_set(void) {
+    static uint8_t st16[RTOS_POOL_STORAGE_SIZE(16, 2)]
+        __attribute__((aligned(RTOS_POOL_ALIGN)));
+    static uint8_t st64[RTOS_POOL_STORAGE_SIZE(64, 2)]
+        __attribute__((aligned(RTOS_POOL_ALIGN)));
+    static uint8_t st256[RTOS_POOL_STORAGE_SIZE(256, 1)]
+        __attribute__((aligned(RTOS_POOL_ALIGN)));
+    rtos_pool_t p16, p64, p256;
+    rtos_pool_t* const pools[] = {&p16, &p64, &p256};
+    const rtos_pool_set_t set = {pools, 3};
+    void* block[6];
+
+    rtos_pool_create_static("16", 16, 2, st16, &p16);
+    rtos_pool_create_static("64", 64, 2, st64, &p64);
+    rtos_pool_create_static("256", 256, 1, st256, &p256);
+
+    /* smallest fitting class first, the next one up when it is empty */
+    block[0] = rtos_pool_set_alloc(&set, 10);
+    block[1] = rtos_pool_set_alloc(&set, 16);
+    block[2] = rtos_pool_set_alloc(&set, 1);
+    CHECK(rtos_pool_owns(&p16, block[0]));
+    CHECK(rtos_pool_owns(&p16, block[1]));
+    CHECK(rtos_pool_owns(&p64, block[2]));
+    CHECK_EQ(p16.failures, 0);
+
+    block[3] = rtos_pool_set_alloc(&set, 64);
+    block[4] = rtos_pool_set_alloc(&set, 17);
+    CHECK(rtos_pool_owns(&p64, block[3]));
+    CHECK(rtos_pool_owns(&p256, block[4]));
+
+    /* every fitting class empty, counted on the smallest that fits */
+    block[5] = rtos_pool_set_alloc(&set, 20);
+    CHECK(block[5] == NULL);
+    CHECK_EQ(p64.failures, 1);
+    CHECK_EQ(p16.failures + p256.failures, 0);
+
+    /* larger than every class, nothing to count */
+    CHECK(rtos_pool_set_alloc(&set, 257) == NULL);
+    CHECK_EQ(p16.failures + p64.failures + p256.failures, 1);
+
+    rtos_pool_set_free(&set, block[4]);
+    rtos_pool_set_free(&set, block[0]);
+    rtos_pool_set_free(&set, block[3]);
+    CHECK_EQ(p256.used, 0);
+    CHECK_EQ(p16.used, 1);
+    CHECK_EQ(p64.used, 1);
+    CHECK(rtos_pool_set_alloc(&set, 200) == block[4]);
+    rtos_pool_set_free(&set, NULL);
+    CHECK_EQ(s_asserts, 0);
+
+    /* a block of no class */
+    rtos_pool_set_free(&set, s_storage);
+    CHECK_EQ(s_asserts, 1);
+    s_asserts = 0;
+}
+
+/* random alloc and free against a list of the blocks out: no block is
+ * handed out twice and the counts add up */
+static void test_random(void) {
+    rtos_pool_t pool;
+    void* out[BLOCKS];
+    uint16_t num = 0, i, j;
+    uint32_t round;
+
+    srand(1);
+    rtos_pool_create_static("p", 40, BLOCKS, s_storage, &pool);
+    for (round = 0; round < 200000; round++) {
+        if (num == 0 || (num < BLOCKS && rand() % 2)) {
+            out[num] = rtos_pool_alloc(&pool);
+            CHECK(out[num] != NULL);
+            for (j = 0; j < num; j++) {
+                CHECK(out[j] != out[num]);
+            }
+            num++;
+        } else {
+            i = (uint16_t)(rand() % num);
+            rtos_pool_free(&pool, out[i]);
+            out[i] = out[--num];
+        }
+        if (pool.used != num) {
+            CHECK_EQ(pool.used, num);
+            break;
+        }
+    }
+    CHECK_EQ(free_len(&pool), BLOCKS - num);
+    CHECK_EQ(pool.failures, 0);
+    CHECK_EQ(s_asserts, 0);
+}
+
+/* a block that is no block of the pool */
+static void test_foreign_free(void) {
+    rtos_pool_t pool;
+    uint8_t* block;
+
+    rtos_pool_create_static("p", 40, BLOCKS, s_storage, &pool);
+    block = rtos_pool_alloc(&pool);
+    rtos_pool_free(&pool, block + 1);
+    CHECK(s_asserts > 0);
+    s_asserts = 0;
+}
+
+#if (RTOS_POOL_DEBUG == 1)
+static void test_debug_checks(void) {
+    static uint8_t other_st[RTOS_POOL_STORAGE_SIZE(40, 2)]
+        __attribute__((aligned(RTOS_POOL_ALIGN)));
+    rtos_pool_t pool, other;
+    uint8_t* block;
+    uint16_t used;
+
+    rtos_pool_create_static("p", 40, BLOCKS, s_storage, &pool);
+    rtos_pool_create_static("o", 40, 2, other_st, &other);
+
+    /* double free: caught, the free list is left alone */
+    block = rtos_pool_alloc(&pool);
+    rtos_pool_free(&pool, block);
+    used = pool.used;
+    rtos_pool_free(&pool, block);
+    CHECK_EQ(s_asserts, 1);
+    CHECK_EQ(pool.used, used);
+    CHECK_EQ(free_len(&pool), BLOCKS);
+    s_asserts = 0;
+
+    /* freed to another pool */
+    block = rtos_pool_alloc(&pool);
+    rtos_pool_free(&other, block);
+    CHECK(s_asserts > 0);
+    s_asserts = 0;
+
+    /* overrun into the guard, caught on free */
+    rtos_pool_create_static("p", 40, BLOCKS, s_storage, &pool);
+    block = rtos_pool_alloc(&pool);
+    memset(block, 0, 41);
+    rtos_pool_free(&pool, block);
+    CHECK_EQ(s_asserts, 1);
+    s_asserts = 0;
+
+    /* write after free, caught when the block is handed out again */
+    rtos_pool_create_static("p", 40, BLOCKS, s_storage, &pool);
+    block = rtos_pool_alloc(&pool);
+    rtos_pool_free(&pool, block);
+    memset(block - RTOS_POOL_HDR_SIZE, 0, RTOS_POOL_HDR_SIZE);
+    CHECK(rtos_pool_alloc(&pool) == block);
+    CHECK_EQ(s_asserts, 1);
+    s_asserts = 0;
+}
+#endif
+
+int main(void) {
+    printf("RTOS_POOL_DEBUG %d\n", RTOS_POOL_DEBUG);
+    HOST_TEST_RUN(test_create_static);
+    HOST_TEST_RUN(test_exhaust_and_reuse);
+    HOST_TEST_RUN(test_small_blocks);
+    HOST_TEST_RUN(test_dynamic);
+    HOST_TEST_RUN(test_set);
+    HOST_TEST_RUN(test_random);
+    HOST_TEST_RUN(test_foreign_free);
+#if (RTOS_POOL_DEBUG == 1)
+    HOST_TEST_RUN(test_debug_checks);
+#endif
+    return HOST_TEST_END();
+}
@@ -0,0 +1,188 @@
+/**
+ * @file bench_rtos_sched.c
+ * @brief Task selection of the kernel over the POSIX port, with the generic
+ *        walk of the ready lists and with the ready-priority bitmap.
+ *
+ * Three tasks hand a notification round a ring and block in turn, so each
+ * handoff selects the next lower ready priority, the layout of the radio
+ * examples (HOSAL 30, stack 27, application 2) being the far case. The
+ * selection is timed between the switched out and switched in trace
+ * points of vTaskSwitchContext() with the time stamp counter where there
+ * is one. The slowest 1% are left out of the mean, as signals of the port
+ * land in between now and then. The handoff from notify to wakeup includes the pthread
+ * switch of the POSIX port.
+ *
+ * Host timings only compare the two selections, the target is a Cortex-M3
+ * at 48 MHz (RT58x) or a Cortex-M33 at 64 MHz (RT584).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define STAMP()    __rdtsc()
+#define STAMP_UNIT "cycles"
+#else
+#define STAMP()    now_ns()
+#define STAMP_UNIT "ns"
+#endif
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define ROUNDS   20000
+#define RING_MAX 4
+#define SAMPLE_MAX (ROUNDS * RING_MAX)
+#define CTRL_PRIORITY (configMAX_PRIORITIES - 1)
+
+typedef struct {
+    const char *pName;
+    uint8_t num;
+    UBaseType_t prio[RING_MAX];
+} layout_t;
+
+typedef struct {
+    double select;    /* mean, in STAMP_UNIT */
+    uint32_t p99;
+    uint32_t switches;
+    uint64_t handoff_ns;
+} result_t;
+
+static const layout_t s_layouts[] = {
+    {"radio 30>27>2", 3, {30, 27, 2}},
+    {"spread 30>16>8>1", 4, {30, 16, 8, 1}},
+    {"adjacent 3>2>1", 3, {3, 2, 1}},
+};
+
+#define LAYOUT_NUM (sizeof(s_layouts) / sizeof(s_layouts[0]))
+
+static TaskHandle_t s_ring[RING_MAX];
+static TaskHandle_t s_ctrl;
+static uint8_t s_ring_num;
+static result_t s_result[LAYOUT_NUM];
+static double s_stamp_cost;
+static uint64_t s_handoff_ns;
+
+static volatile int s_tracing;
+static uint64_t s_out;
+static uint32_t s_samples[SAMPLE_MAX];
+static uint32_t s_switches;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void host_rtos_switch_out(void) {
+    if (s_tracing) {
+        s_out = STAMP();
+    }
+}
+
+void host_rtos_switch_in(void) {
+    if (s_tracing && s_switches < SAMPLE_MAX) {
+        s_samples[s_switches++] = (uint32_t)(STAMP() - s_out);
+    }
+}
+
+static int sample_cmp(const void *pA, const void *pB) {
+    uint32_t a = *(const uint32_t *)pA, b = *(const uint32_t *)pB;
+
+    return (a > b) - (a < b);
+}
+
+/* mean of the fastest 99%, and the slowest of them */
+static double samples_mean(uint32_t *pP99) {
+    uint32_t i, num = s_switches - s_switches / 100;
+    uint64_t sum = 0;
+
+    if (num == 0) {
+        *pP99 = 0;
+        return 0;
+    }
+    qsort(s_samples, s_switches, sizeof(s_samples[0]), sample_cmp);
+    for (i = 0; i < num; i++) {
+        sum += s_samples[i];
+    }
+    *pP99 = s_samples[num - 1];
+    return (double)sum / num;
+}
+
+/* the first task of the ring counts rounds and reports to the controller */
+static void ring_task(void *pArg) {
+    uintptr_t idx = (uintptr_t)pArg;
+    uint64_t t0 = 0;
+    uint32_t round;
+
+    for (round = 0;; round++) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (idx == 0 && round == 1) {
+            s_switches = 0;
+            s_tracing = 1;
+            t0 = now_ns();
+        }
+        if (idx == 0 && round == ROUNDS + 1) {
+            s_tracing = 0;
+            s_handoff_ns = now_ns() - t0;
+            xTaskNotifyGive(s_ctrl);
+            vTaskSuspend(NULL);
+        }
+        xTaskNotifyGive(s_ring[(idx + 1) % s_ring_num]);
+    }
+}
+
+static void ctrl_task(void *pArg) {
+    const layout_t *pLayout;
+    uint32_t i;
+    uint8_t k;
+
+    /* cost of the two trace points with nothing between them */
+    s_switches = 0;
+    s_tracing = 1;
+    for (i = 0; i < ROUNDS; i++) {
+        host_rtos_switch_out();
+        host_rtos_switch_in();
+    }
+    s_tracing = 0;
+    s_stamp_cost = samples_mean(&s_result[0].p99);
+
+    for (i = 0; i < LAYOUT_NUM; i++) {
+        pLayout = &s_layouts[i];
+        s_ring_num = pLayout->num;
+        for (k = 0; k < s_ring_num; k++) {
+            xTaskCreate(ring_task, "ring", configMINIMAL_STACK_SIZE, (void *)(uintptr_t)k,
+                        pLayout->prio[k], &s_ring[k]);
+        }
+        xTaskNotifyGive(s_ring[0]);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        s_result[i].switches = s_switches;
+        s_result[i].select = samples_mean(&s_result[i].p99);
+        s_result[i].handoff_ns = s_handoff_ns;
+        for (k = 0; k < s_ring_num; k++) {
+            vTaskDelete(s_ring[k]);
+        }
+        /* the idle task frees the deleted tasks */
+        vTaskDelay(10);
+    }
+    vTaskEndScheduler();
+}
+
+int main(void) {
+    uint32_t i;
+
+    xTaskCreate(ctrl_task, "ctrl", configMINIMAL_STACK_SIZE, NULL, CTRL_PRIORITY, &s_ctrl);
+    vTaskStartScheduler();
+
+    printf("selection     %s\n", configUSE_PORT_OPTIMISED_TASK_SELECTION ? "ready bitmap (CLZ)" : "generic list walk");
+    printf("trace points  %.1f %s, subtracted\n", s_stamp_cost, STAMP_UNIT);
+    for (i = 0; i < LAYOUT_NUM; i++) {
+        printf("%-18s select %.1f %s (p99 %.0f), handoff %.2f us, %lu switches\n", s_layouts[i].pName,
+               s_result[i].select - s_stamp_cost, STAMP_UNIT, s_result[i].p99 - s_stamp_cost,
+               (double)s_result[i].handoff_ns / (ROUNDS * s_layouts[i].num) / 1000.0,
+               (unsigned long)s_result[i].switches);
+    }
+    return 0;
+}
@@ -0,0 +1,26 @@
+/**
+ * @file rtos_trace_mock.h
+ * @brief Recorder settings of the host test, forced into rtos_trace.c: a
+ *        small ring, a settable timestamp in place of the DWT counter and
+ *        no interrupt mask.
+ */
+
+#ifndef __RTOS_TRACE_MOCK_H
+#define __RTOS_TRACE_MOCK_H
+
+#include <stdint.h>
+
+#define configUSE_RTOS_TRACE 1
+#define configCPU_CLOCK_HZ   1000000
+
+#define RTOS_TRACE_RECORDS  16
+#define RTOS_TRACE_TASK_MAX 4
+
+extern uint32_t g_trace_mock_cycles;
+
+#define RTOS_TRACE_TIMESTAMP()     (g_trace_mock_cycles)
+#define RTOS_TRACE_COUNTER_START() ((void)0)
+#define RTOS_TRACE_LOCK(m)         ((m) = 0)
+#define RTOS_TRACE_UNLOCK(m)       ((void)(m))
+
+#endif // __RTOS_TRACE_MOCK_H
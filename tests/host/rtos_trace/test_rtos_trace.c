@@ -0,0 +1,246 @@
+/**
+ * @file test_rtos_trace.c
+ * @brief Binary trace recorder: the ring keeping the newest records, the
+ *        task table, sync records, interrupt records and the text dump.
+ *
+ * The source is included so the ring can be checked directly. The last
+ * test writes the dump of a short schedule to the path given on the
+ * command line, for the decoder test that runs next.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "host_test.h"
+#include "rtos_trace.c"
+
+#define DUMP_TMP "rtos_trace_test.log"
+
+uint32_t g_trace_mock_cycles;
+
+/* stand-ins of TCBs, only their addresses are recorded */
+static uint32_t s_tcb[6][4];
+
+typedef struct {
+    unsigned long version, hz, tick_hz, written, count;
+    uint32_t num;
+    rtos_trace_record_t rec[RTOS_TRACE_RECORDS];
+} dump_t;
+
+static void setup(void) {
+    rtos_trace_enable(1);
+    rtos_trace_clear();
+    memset(g_trace_tasks, 0, sizeof(g_trace_tasks));
+    g_trace_task_count = 0;
+    g_trace_mock_cycles = 0;
+}
+
+/* rtos_trace_dump() prints to stdout, send it to a file meanwhile */
+static void dump_to(const char* path) {
+    int out = dup(STDOUT_FILENO);
+
+    fflush(stdout);
+    CHECK(freopen(path, "w", stdout) != NULL);
+    rtos_trace_dump();
+    fflush(stdout);
+    dup2(out, STDOUT_FILENO);
+    close(out);
+}
+
+static void dump_read(const char* path, dump_t* d) {
+    FILE* f = fopen(path, "r");
+    char word[32];
+    unsigned long ts;
+    unsigned int obj, evt, arg;
+
+    memset(d, 0, sizeof(*d));
+    CHECK(f != NULL);
+    if (f == NULL) {
+        return;
+    }
+    CHECK_EQ(fscanf(f, "#RTOS_TRACE %lu %lu %lu %lu %lu", &d->version, &d->hz,
+                    &d->tick_hz, &d->written, &d->count),
+             5);
+    while (fscanf(f, "%31s", word) == 1 && strcmp(word, "#END")) {
+        if (strlen(word) == 16 && d->num < RTOS_TRACE_RECORDS
+            && sscanf(word, "%8lx%4x%2x%2x", &ts, &obj, &evt, &arg) == 4) {
+            d->rec[d->num].timestamp = (uint32_t)ts;
+            d->rec[d->num].object = (uint16_t)obj;
+            d->rec[d->num].event = (uint8_t)evt;
+            d->rec[d->num].arg = (uint8_t)arg;
+            d->num++;
+        }
+    }
+    fclose(f);
+}
+
+static const rtos_trace_record_t* last(void) {
+    return &g_trace_records[(g_trace_head - 1) & (RTOS_TRACE_RECORDS - 1)];
+}
+
+/* the ring keeps the newest records, the dump starts at the oldest */
+static void test_ring_wrap(void) {
+    dump_t d;
+    uint32_t i;
+
+    setup();
+    for (i = 0; i < RTOS_TRACE_RECORDS + 5; i++) {
+        g_trace_mock_cycles = 100 + i;
+        rtos_trace_user(1, (uint16_t)i);
+    }
+    dump_to(DUMP_TMP);
+    dump_read(DUMP_TMP, &d);
+    remove(DUMP_TMP);
+
+    CHECK_EQ(d.version, RTOS_TRACE_DUMP_VERSION);
+    CHECK_EQ(d.hz, configCPU_CLOCK_HZ);
+    CHECK_EQ(d.tick_hz, configTICK_RATE_HZ);
+    CHECK_EQ(d.written, RTOS_TRACE_RECORDS + 5);
+    CHECK_EQ(d.count, RTOS_TRACE_RECORDS);
+    CHECK_EQ(d.num, RTOS_TRACE_RECORDS);
+    for (i = 0; i < d.num; i++) {
+        CHECK_EQ(d.rec[i].object, 5 + i);
+        CHECK_EQ(d.rec[i].timestamp, 105 + i);
+        CHECK_EQ(d.rec[i].event, RTOS_TRACE_EVT_USER);
+        CHECK_EQ(d.rec[i].arg, 1);
+    }
+}
+
+/* a TCB at the address of a deleted task takes over its entry */
+static void test_task_table(void) {
+    uint32_t i;
+
+    setup();
+    for (i = 0; i < 6; i++) {
+        rtos_trace_task_create(s_tcb[i], "task", (uint8_t)i);
+    }
+    CHECK_EQ(g_trace_task_count, RTOS_TRACE_TASK_MAX);
+    CHECK_EQ(g_trace_head, 6);
+    CHECK_EQ(last()->event, RTOS_TRACE_EVT_TASK_CREATE);
+    CHECK_EQ(last()->arg, 5);
+
+    rtos_trace_task_create(s_tcb[1], "a name longer than the table", 9);
+    CHECK_EQ(g_trace_task_count, RTOS_TRACE_TASK_MAX);
+    CHECK_EQ(g_trace_tasks[1].object, RTOS_TRACE_OBJECT_ID(s_tcb[1]));
+    CHECK_EQ(g_trace_tasks[1].priority, 9);
+    CHECK_EQ(strlen(g_trace_tasks[1].name), RTOS_TRACE_NAME_LEN - 1);
+}
+
+/* a sync record ahead of the first switch of each RTOS_TRACE_SYNC_TICKS */
+static void test_sync(void) {
+    setup();
+    rtos_trace_task_switched_in(s_tcb[0], 3, RTOS_TRACE_SYNC_TICKS - 1);
+    CHECK_EQ(g_trace_head, 1);
+    rtos_trace_task_switched_in(s_tcb[1], 2, RTOS_TRACE_SYNC_TICKS);
+    CHECK_EQ(g_trace_head, 3);
+    CHECK_EQ(g_trace_records[1].event, RTOS_TRACE_EVT_SYNC);
+    CHECK_EQ(g_trace_records[1].object, RTOS_TRACE_SYNC_TICKS);
+    CHECK_EQ(last()->event, RTOS_TRACE_EVT_TASK_SWITCHED_IN);
+    CHECK_EQ(last()->object, RTOS_TRACE_OBJECT_ID(s_tcb[1]));
+    CHECK_EQ(last()->arg, 2);
+
+    rtos_trace_task_switched_in(s_tcb[0], 3, 2 * RTOS_TRACE_SYNC_TICKS - 1);
+    CHECK_EQ(g_trace_head, 4);
+    rtos_trace_task_switched_in(s_tcb[0], 3, 0x123456);
+    CHECK_EQ(g_trace_head, 6);
+    CHECK_EQ(g_trace_records[4].object, 0x3456);
+    CHECK_EQ(g_trace_records[4].arg, 0x12);
+}
+
+static void test_isr_records(void) {
+    setup();
+    RTOS_TRACE_ISR_ENTER(5);
+    CHECK_EQ(last()->event, RTOS_TRACE_EVT_ISR_ENTER);
+    CHECK_EQ(last()->arg, 5);
+    RTOS_TRACE_ISR_EXIT(5);
+    CHECK_EQ(last()->event, RTOS_TRACE_EVT_ISR_EXIT);
+    /* the tick handler of the port, through the kernel hooks */
+    traceISR_ENTER();
+    CHECK_EQ(last()->event, RTOS_TRACE_EVT_ISR_ENTER);
+    CHECK_EQ(last()->arg, RTOS_TRACE_IRQ_TICK);
+    traceISR_EXIT_TO_SCHEDULER();
+    CHECK_EQ(last()->event, RTOS_TRACE_EVT_ISR_EXIT);
+    CHECK_EQ(g_trace_head, 4);
+}
+
+/* off keeps the ring as it is, a dump leaves recording as it found it */
+static void test_enable(void) {
+    setup();
+    rtos_trace_user(1, 1);
+    rtos_trace_enable(0);
+    rtos_trace_user(1, 2);
+    RTOS_TRACE_ISR_ENTER(5);
+    rtos_trace_task_switched_in(s_tcb[0], 1, 5000);
+    CHECK_EQ(g_trace_head, 1);
+
+    dump_to(DUMP_TMP);
+    remove(DUMP_TMP);
+    CHECK(!g_trace_enabled);
+    rtos_trace_enable(1);
+    dump_to(DUMP_TMP);
+    remove(DUMP_TMP);
+    CHECK(g_trace_enabled);
+
+    rtos_trace_clear();
+    CHECK_EQ(g_trace_head, 0);
+}
+
+/**
+ * The schedule the decoder test reads: app runs, radio is made ready and
+ * switched in 200 us later, the idle task runs across a tick interrupt.
+ * The cycle counter wraps in between.
+ */
+static void decoder_dump_write(const char* path) {
+    void* app = s_tcb[0];
+    void* radio = s_tcb[1];
+    void* idle = s_tcb[2];
+    const uint32_t base = 0xFFFFFF00UL;
+
+    setup();
+    rtos_trace_task_create(app, "app", 2);
+    rtos_trace_task_create(radio, "radio", 3);
+    rtos_trace_task_create(idle, "IDLE", 0);
+    rtos_trace_clear();
+
+    g_trace_mock_cycles = base;
+    rtos_trace_task_switched_in(app, 2, 10);
+    g_trace_mock_cycles = base + 100;
+    rtos_trace_event(RTOS_TRACE_EVT_TASK_READY, radio, 3);
+    g_trace_mock_cycles = base + 300;
+    rtos_trace_task_switched_in(radio, 3, 10);
+    g_trace_mock_cycles = base + 1000;
+    rtos_trace_event(RTOS_TRACE_EVT_QUEUE_SEND_FAILED, s_tcb[3], 4);
+    rtos_trace_task_switched_in(idle, 0, RTOS_TRACE_SYNC_TICKS);
+    g_trace_mock_cycles = base + 1100;
+    traceISR_ENTER();
+    g_trace_mock_cycles = base + 1150;
+    traceISR_EXIT();
+    g_trace_mock_cycles = base + 1200;
+    rtos_trace_user(7, 42);
+    CHECK_EQ(g_trace_head, 9);
+
+    dump_to(path);
+}
+
+static const char* s_dump_path;
+
+static void test_decoder_dump(void) {
+    dump_t d;
+
+    decoder_dump_write(s_dump_path);
+    dump_read(s_dump_path, &d);
+    CHECK_EQ(d.num, 9);
+}
+
+int main(int argc, char** argv) {
+    HOST_TEST_RUN(test_ring_wrap);
+    HOST_TEST_RUN(test_task_table);
+    HOST_TEST_RUN(test_sync);
+    HOST_TEST_RUN(test_isr_records);
+    HOST_TEST_RUN(test_enable);
+    if (argc > 1) {
+        s_dump_path = argv[1];
+        HOST_TEST_RUN(test_decoder_dump);
+    }
+    return HOST_TEST_END();
+}
@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""Decoder of tools/rtos_trace on the dump test_rtos_trace writes.
+
+Usage:
+    test_rtos_trace_decode.py <tools/rtos_trace> <dump>
+
+The dump is a short schedule: app runs 300 us, radio is made ready at
+100 us and runs from 300 us to 1000 us, the idle task from there to the
+last record at 1200 us, with a tick interrupt in between. The cycle
+counter wraps after 256 us.
+"""
+
+import io
+import sys
+
+failed = 0
+
+
+def check(cond, what):
+    global failed
+    if not cond:
+        print("CHECK ( %s ) failed" % what)
+        failed += 1
+
+
+def run(fn, *args):
+    before = failed
+    fn(*args)
+    print("%-40s %s" % (fn.__name__, "ok" if failed == before else "FAILED"))
+
+
+def rows(text):
+    """Per-task rows of the summary, by task name."""
+    out = {}
+    for line in text.splitlines():
+        f = line.split()
+        if len(f) == 5 and f[0] in ("app", "radio", "IDLE"):
+            out[f[0]] = [float(x) for x in f[1:]]
+    return out
+
+
+def test_parse(dec, capture):
+    dump = dec.parse(io.StringIO(capture))
+    check(dump is not None, "dump found")
+    check(dump.hz == 1000000, "timestamp rate")
+    check(dump.written == 9, "records written")
+    check(len(dump.records) == 9, "records read")
+    check(sorted(dump.tasks.values()) == ["IDLE", "app", "radio"], "task names")
+
+
+def test_last_of_several(dec, capture):
+    noise = "> trace dump\r\n#RTOS_TRACE 1 1000 1000 1 1\n#T 0001 1 old\n" \
+            "0000000000010501\n#END\nlog line 0123456789abcdef\n"
+    dump = dec.parse(io.StringIO(noise + capture + "#RTOS_TRACE 1 1 1 0 0\n"))
+    check(dump is not None and len(dump.records) == 9, "last complete dump used")
+
+
+def test_unwrap(dec, capture):
+    dump = dec.parse(io.StringIO(capture))
+    times = dec.unwrap(dump.records)
+    check(times[0] == 0, "starts at 0")
+    check(times == sorted(times), "monotonic across the wrap")
+    check(times[-1] == 1200, "last record at 1200 cycles")
+
+
+def test_summary(dec, capture):
+    dump = dec.parse(io.StringIO(capture))
+    out = io.StringIO()
+    dec.summary(dump, dec.unwrap(dump.records), out)
+    text = out.getvalue()
+    r = rows(text)
+    check("9 records of 9 written, 1.200 ms" in text, "span")
+    check(r.get("app") == [300.0, 25.0, 1, 0.0], "app row %s" % r.get("app"))
+    check(r.get("radio") == [700.0, 58.33, 1, 200.0], "radio row %s" % r.get("radio"))
+    check(r.get("IDLE") == [200.0, 16.67, 1, 0.0], "IDLE row %s" % r.get("IDLE"))
+    check("QUEUE_SEND_FAILED: 1" in text, "failed sends counted")
+
+
+def test_timeline(dec, capture):
+    dump = dec.parse(io.StringIO(capture))
+    out = io.StringIO()
+    dec.timeline(dump, dec.unwrap(dump.records), out)
+    lines = out.getvalue().splitlines()
+    check(len(lines) == 9, "one line a record")
+    check("SYNC" in lines[4] and "tick 1000" in lines[4], "sync record")
+    check("ISR_ENTER" in lines[6] and "irq tick" in lines[6], "tick interrupt")
+    check(lines[8].split()[0] == "1200.0", "time of the last record")
+    check("id 7 value 42" in lines[8], "user marker")
+
+
+def main():
+    sys.path.insert(0, sys.argv[1])
+    import rtos_trace_decode as dec
+
+    with open(sys.argv[2]) as f:
+        capture = f.read()
+    for fn in (test_parse, test_last_of_several, test_unwrap, test_summary,
+               test_timeline):
+        run(fn, dec, capture)
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
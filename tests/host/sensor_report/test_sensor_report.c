@@ -0,0 +1,263 @@
+/**
+ * @file test_sensor_report.c
+ * @brief Replays a day of temperature and humidity readings through the
+ *        reporting engine of the Zigbee sensors, with the defaults of the
+ *        temperature-sensor example, sleeping exactly as long as the engine
+ *        asks to.
+ *
+ * trace_day.csv holds one reading per sample period (60 s): flat with
+ * sensor noise at night, a 6 C ramp in the morning, a humidity step of an
+ * hour, flat again and a ramp back down in the evening.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "sensor_report.h"
+
+#define TRACE_MAX     2048
+#define SAMPLE_MS     60000
+#define REPORT_MAX    1024
+#define ATTR_TEMP     0
+#define ATTR_HUMIDITY 1
+
+typedef struct {
+    uint32_t t_ms;
+    int32_t value[2];
+} trace_row_t;
+
+typedef struct {
+    uint32_t t_ms;
+    int32_t value;
+} report_t;
+
+static trace_row_t s_trace[TRACE_MAX];
+static uint32_t s_trace_num;
+
+static uint32_t s_now;
+static report_t s_report[2][REPORT_MAX];
+static uint32_t s_report_num[2];
+static uint32_t s_write_calls;
+static uint32_t s_runs;
+static sensor_report_cfg_t s_remote;
+static bool s_remote_set;
+
+static sensor_report_attr_t s_attrs[] = {
+    {
+        .cfg = {.min_interval_ms = 10000, .max_interval_ms = 3600000, .delta = 50},
+        .hysteresis = 20,
+    },
+    {
+        .cfg = {.min_interval_ms = 10000, .max_interval_ms = 3600000, .delta = 100},
+        .hysteresis = 50,
+    },
+};
+
+static bool trace_load(const char* path) {
+    char line[128];
+    unsigned long t;
+    long v0, v1;
+    FILE* f = fopen(path, "r");
+
+    if (f == NULL) {
+        printf("cannot open %s\n", path);
+        return false;
+    }
+    s_trace_num = 0;
+    while (fgets(line, sizeof(line), f) && s_trace_num < TRACE_MAX) {
+        if (line[0] == '#' || sscanf(line, "%lu,%ld,%ld", &t, &v0, &v1) != 3) {
+            continue;
+        }
+        s_trace[s_trace_num].t_ms = (uint32_t)t * 1000;
+        s_trace[s_trace_num].value[0] = (int32_t)v0;
+        s_trace[s_trace_num].value[1] = (int32_t)v1;
+        s_trace_num++;
+    }
+    fclose(f);
+    return s_trace_num > 0;
+}
+
+/* the sensor returns the last reading taken at or before now */
+static bool sample_cb(uint8_t idx, int32_t* value) {
+    uint32_t i = s_now / SAMPLE_MS;
+
+    if (i >= s_trace_num) {
+        i = s_trace_num - 1;
+    }
+    *value = s_trace[i].value[idx];
+    return true;
+}
+
+static void write_cb(sensor_report_t* ctx, uint32_t mask) {
+    uint8_t i;
+
+    for (i = 0; i < ctx->attr_num; i++) {
+        if ((mask & (1UL << i)) && s_report_num[i] < REPORT_MAX) {
+            s_report[i][s_report_num[i]].t_ms = s_now;
+            s_report[i][s_report_num[i]].value = ctx->attrs[i].sample;
+            s_report_num[i]++;
+        }
+    }
+    s_write_calls++;
+}
+
+static bool cfg_cb(const sensor_report_attr_t* attr, sensor_report_cfg_t* cfg) {
+    if (!s_remote_set) {
+        return false;
+    }
+    *cfg = s_remote;
+    return true;
+}
+
+static sensor_report_t s_ctx = {
+    .attrs = s_attrs,
+    .attr_num = 2,
+    .sample_period_ms = SAMPLE_MS,
+    .sample = sample_cb,
+    .write = write_cb,
+    .cfg = cfg_cb,
+};
+
+/* run the engine over the trace like the one-shot sensor timer does */
+static void replay(void) {
+    uint32_t end = s_trace[s_trace_num - 1].t_ms;
+    uint32_t delay;
+
+    memset(s_report_num, 0, sizeof(s_report_num));
+    s_write_calls = 0;
+    s_runs = 0;
+    s_now = 0;
+    sensor_report_init(&s_ctx, s_now);
+    while (s_now <= end) {
+        delay = sensor_report_run(&s_ctx, s_now);
+        s_runs++;
+        s_now += delay ? delay : 1;
+    }
+}
+
+static uint32_t max_gap(uint8_t idx) {
+    uint32_t i, gap, max = 0;
+
+    for (i = 1; i < s_report_num[idx]; i++) {
+        gap = s_report[idx][i].t_ms - s_report[idx][i - 1].t_ms;
+        if (gap > max) {
+            max = gap;
+        }
+    }
+    return max;
+}
+
+static uint32_t min_gap(uint8_t idx) {
+    uint32_t i, gap, min = UINT32_MAX;
+
+    for (i = 1; i < s_report_num[idx]; i++) {
+        gap = s_report[idx][i].t_ms - s_report[idx][i - 1].t_ms;
+        if (gap < min) {
+            min = gap;
+        }
+    }
+    return min;
+}
+
+/* reports inside [from, to) hours */
+static uint32_t reports_between(uint8_t idx, uint32_t from_h, uint32_t to_h) {
+    uint32_t i, num = 0;
+
+    for (i = 0; i < s_report_num[idx]; i++) {
+        if (s_report[idx][i].t_ms >= from_h * 3600000UL
+            && s_report[idx][i].t_ms < to_h * 3600000UL) {
+            num++;
+        }
+    }
+    return num;
+}
+
+static void test_day_replay(void) {
+    s_remote_set = false;
+    replay();
+
+    printf("  samples %lu reports %lu batches %lu suppressed %lu held %lu "
+           "runs %lu\n",
+           (unsigned long)s_ctx.stats.samples,
+           (unsigned long)s_ctx.stats.reports,
+           (unsigned long)s_ctx.stats.batches,
+           (unsigned long)s_ctx.stats.suppressed,
+           (unsigned long)s_ctx.stats.held, (unsigned long)s_runs);
+
+    /* one wakeup per sample period, nothing in between */
+    CHECK_EQ(s_runs, s_trace_num);
+    CHECK_EQ(s_ctx.stats.samples, 2 * s_trace_num);
+    CHECK_EQ(s_ctx.stats.batches, s_write_calls);
+    CHECK_EQ(s_ctx.stats.reports, s_report_num[0] + s_report_num[1]);
+
+    /* the first run reports both, later batches carry both when allowed */
+    CHECK(s_report_num[ATTR_TEMP] > 0 && s_report[ATTR_TEMP][0].t_ms == 0);
+    CHECK(s_report_num[ATTR_HUMIDITY] > 0
+          && s_report[ATTR_HUMIDITY][0].t_ms == 0);
+
+    CHECK(min_gap(ATTR_TEMP) >= 10000);
+    CHECK(min_gap(ATTR_HUMIDITY) >= 10000);
+    CHECK(max_gap(ATTR_TEMP) <= 3600000);
+    CHECK(max_gap(ATTR_HUMIDITY) <= 3600000);
+
+    /* noise of +-0.2 C at night: the first report and hourly refreshes */
+    CHECK(reports_between(ATTR_TEMP, 0, 6) <= 7);
+    /* 6 C in 6 h at delta 0.5 C: one report per step of the ramp */
+    CHECK(reports_between(ATTR_TEMP, 6, 12) >= 10);
+    CHECK(reports_between(ATTR_TEMP, 6, 12) <= 14);
+    /* the humidity step goes out on the sample that sees it, both ways */
+    CHECK(reports_between(ATTR_HUMIDITY, 8, 9) >= 1);
+    CHECK(reports_between(ATTR_HUMIDITY, 9, 10) >= 1);
+
+    /* far fewer reports than samples */
+    CHECK(s_ctx.stats.reports * 10 < s_ctx.stats.samples);
+}
+
+static void test_remote_config(void) {
+    s_remote.min_interval_ms = 600000;
+    s_remote.max_interval_ms = 1800000;
+    s_remote.delta = 10;
+    s_remote_set = true;
+    replay();
+    s_remote_set = false;
+
+    CHECK(min_gap(ATTR_TEMP) >= 600000);
+    CHECK(max_gap(ATTR_TEMP) <= 1800000);
+    CHECK(min_gap(ATTR_HUMIDITY) >= 600000);
+    CHECK(s_ctx.stats.held > 0);
+}
+
+static void test_trigger(void) {
+    uint32_t batches;
+
+    s_remote_set = false;
+    s_now = 0;
+    memset(s_report_num, 0, sizeof(s_report_num));
+    sensor_report_init(&s_ctx, s_now);
+    sensor_report_run(&s_ctx, s_now);
+    batches = s_ctx.stats.batches;
+
+    /* noise only, the next regular sample does not report */
+    s_now = SAMPLE_MS;
+    sensor_report_run(&s_ctx, s_now);
+    CHECK_EQ(s_ctx.stats.batches, batches);
+
+    /* a trigger samples at once and reports any change below delta */
+    s_now = SAMPLE_MS + 30000;
+    sensor_report_trigger(&s_ctx);
+    CHECK_EQ(sensor_report_run(&s_ctx, s_now), SAMPLE_MS);
+    CHECK_EQ(s_ctx.stats.batches, batches + 1);
+    CHECK_EQ(s_ctx.stats.samples, 6);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || !trace_load(argv[1])) {
+        printf("usage: %s <trace.csv>\n", argv[0]);
+        return 1;
+    }
+    HOST_TEST_RUN(test_day_replay);
+    HOST_TEST_RUN(test_remote_config);
+    HOST_TEST_RUN(test_trigger);
+    return HOST_TEST_END();
+}
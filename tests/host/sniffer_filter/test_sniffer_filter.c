@@ -0,0 +1,389 @@
+/**
+ * @file test_sniffer_filter.c
+ * @brief Capture filter of miu-sniffer: spinel frames that pass unchanged,
+ *        captured frames dropped by PAN ID, kept without one, cut to the
+ *        snap length and trimmed, FCS errors, the CLI type mask, and the
+ *        vendor properties the host reads and sets the filter with.
+ *
+ * Frames are HDLC encoded here as the stack would, the output of the
+ * filter is decoded again and compared.
+ */
+
+#include <string.h>
+#include "cli.h"
+#include "host_test.h"
+#include "sniffer_filter.h"
+
+#define FLAG 0x7E
+#define ESC  0x7D
+
+extern const sh_cmd_t g_cli_cmd_snfilter;
+
+static uint8_t s_enc[1024];
+static uint8_t s_dec[1024];
+
+static uint16_t fcs16(const uint8_t* p, uint32_t len) {
+    uint16_t fcs = 0xFFFF;
+    uint32_t i;
+    uint8_t b;
+
+    for (i = 0; i < len; i++) {
+        fcs ^= p[i];
+        for (b = 0; b < 8; b++) {
+            fcs = (fcs & 1) ? (fcs >> 1) ^ 0x8408 : fcs >> 1;
+        }
+    }
+    return fcs ^ 0xFFFF;
+}
+
+static uint32_t put(uint8_t* dst, uint8_t b) {
+    if (b == FLAG || b == ESC || b == 0x11 || b == 0x13 || b == 0xF8) {
+        dst[0] = ESC;
+        dst[1] = b ^ 0x20;
+        return 2;
+    }
+    dst[0] = b;
+    return 1;
+}
+
+static uint32_t encode(uint8_t* dst, const uint8_t* p, uint32_t len) {
+    uint16_t fcs = fcs16(p, len);
+    uint32_t i, n = 0;
+
+    dst[n++] = FLAG;
+    for (i = 0; i < len; i++) {
+        n += put(&dst[n], p[i]);
+    }
+    n += put(&dst[n], (uint8_t)fcs);
+    n += put(&dst[n], (uint8_t)(fcs >> 8));
+    dst[n++] = FLAG;
+    return n;
+}
+
+/* the first frame with a good FCS, its length without the FCS or -1 */
+static int decode(const uint8_t* in, uint32_t len, uint8_t* out) {
+    uint32_t i, n = 0;
+    bool esc = false;
+
+    for (i = 0; i < len; i++) {
+        if (in[i] == FLAG) {
+            if (n >= 2 && fcs16(out, n - 2) == (out[n - 2] | out[n - 1] << 8)) {
+                return n - 2;
+            }
+            n = 0;
+        } else if (in[i] == ESC) {
+            esc = true;
+        } else {
+            out[n++] = esc ? in[i] ^ 0x20 : in[i];
+            esc = false;
+        }
+    }
+    return -1;
+}
+
+/* STREAM_RAW of a PSDU: rssi, noise, flags, a 3 byte PHY struct and a 2
+ * byte vendor struct */
+static uint32_t raw_frame(uint8_t* p, const uint8_t* psdu, uint16_t len,
+                          int8_t rssi) {
+    static const uint8_t meta_tail[] = {3, 0, 11, 200, 7, 2, 0, 0xaa, 0xbb};
+    uint32_t n = 0;
+
+    p[n++] = 0x80;
+    p[n++] = 6;
+    p[n++] = 0x71;
+    p[n++] = (uint8_t)len;
+    p[n++] = (uint8_t)(len >> 8);
+    memcpy(&p[n], psdu, len);
+    n += len;
+    p[n++] = (uint8_t)rssi;
+    p[n++] = (uint8_t)-100;
+    p[n++] = 0;
+    p[n++] = 0;
+    memcpy(&p[n], meta_tail, sizeof(meta_tail));
+    return n + sizeof(meta_tail);
+}
+
+/* 2006 data frame, PAN ID compressed, short addresses */
+static uint16_t data_psdu(uint8_t* p, uint16_t pan, uint16_t dst) {
+    uint16_t fcf = 1 | (1 << 6) | (2 << 10) | (2 << 14);
+    uint16_t n = 0, i;
+
+    p[n++] = (uint8_t)fcf;
+    p[n++] = (uint8_t)(fcf >> 8);
+    p[n++] = 0x42;
+    p[n++] = (uint8_t)pan;
+    p[n++] = (uint8_t)(pan >> 8);
+    p[n++] = (uint8_t)dst;
+    p[n++] = (uint8_t)(dst >> 8);
+    p[n++] = 0x01;
+    p[n++] = 0x00;
+    for (i = 0; i < 20; i++) {
+        p[n++] = (uint8_t)i;
+    }
+    p[n++] = 0x12;
+    p[n++] = 0x34;
+    return n;
+}
+
+static uint32_t feed(const uint8_t* frame, uint32_t len, const uint8_t** out) {
+    uint32_t n = encode(s_enc, frame, len);
+
+    return sniffer_filter_feed(s_enc, n, out);
+}
+
+static int cli(const char* a, const char* b) {
+    char arg1[16], arg2[16];
+    char* argv[] = {"snfilter", arg1, arg2};
+
+    snprintf(arg1, sizeof(arg1), "%s", a);
+    snprintf(arg2, sizeof(arg2), "%s", b);
+    return g_cli_cmd_snfilter.cmd_exec(3, argv, (cb_shell_out_t)printf, NULL);
+}
+
+static void setup(void) {
+    const uint8_t* out;
+
+    sniffer_filter_init();
+    sniffer_filter_stats_reset();
+    /* end whatever a previous test left in the decoder */
+    s_enc[0] = FLAG;
+    sniffer_filter_feed(s_enc, 1, &out);
+}
+
+static void test_pass_through(void) {
+    const uint8_t status[] = {0x81, 6, 0x00, 0x00};
+    sniffer_filter_stats_t st;
+    const uint8_t* out;
+    uint32_t n, len;
+
+    setup();
+    CHECK_EQ(cli("snap", "200"), 0);
+
+    /* split in two: nothing until the frame is whole */
+    n = encode(s_enc, status, sizeof(status));
+    CHECK_EQ(sniffer_filter_feed(s_enc, 3, &out), 0);
+    len = sniffer_filter_feed(&s_enc[3], n - 3, &out);
+    CHECK_EQ(len, n);
+    CHECK(!memcmp(out, s_enc, n));
+
+    sniffer_filter_stats(&st);
+    CHECK_EQ(st.frames, 0);
+}
+
+static void test_pan_filter(void) {
+    const uint8_t ack[] = {0x02, 0x00, 0x42, 0x00, 0x00};
+    sniffer_filter_stats_t st;
+    uint8_t psdu[64], frame[128];
+    const uint8_t* out;
+    uint32_t n, len;
+
+    setup();
+    CHECK_EQ(cli("pan", "0xface"), 0);
+    CHECK(sniffer_filter_active());
+
+    /* to the PAN: passed as it was */
+    n = raw_frame(frame, psdu, data_psdu(psdu, 0xface, 0x1234), -50);
+    len = feed(frame, n, &out);
+    CHECK_EQ(decode(out, len, s_dec), (int)n);
+    CHECK(!memcmp(s_dec, frame, n));
+
+    /* another PAN: dropped */
+    n = raw_frame(frame, psdu, data_psdu(psdu, 0x1111, 0x1234), -50);
+    CHECK_EQ(feed(frame, n, &out), 0);
+
+    /* an immediate ACK carries no PAN ID: kept */
+    n = raw_frame(frame, ack, sizeof(ack), -50);
+    len = feed(frame, n, &out);
+    CHECK_EQ(decode(out, len, s_dec), (int)n);
+
+    /* below the RSSI floor */
+    CHECK_EQ(cli("rssi", "-70"), 0);
+    n = raw_frame(frame, psdu, data_psdu(psdu, 0xface, 0x1234), -80);
+    CHECK_EQ(feed(frame, n, &out), 0);
+
+    sniffer_filter_stats(&st);
+    CHECK_EQ(st.frames, 4);
+    CHECK_EQ(st.passed, 2);
+    CHECK_EQ(st.filtered, 2);
+}
+
+static void test_snap_and_compact(void) {
+    uint8_t psdu[64], frame[128];
+    sniffer_filter_stats_t st;
+    const uint8_t* out;
+    uint16_t psdu_len;
+    uint32_t n, len;
+    int dec;
+
+    setup();
+    CHECK_EQ(cli("snap", "10"), 0);
+    psdu_len = data_psdu(psdu, 0xface, 0x1234);
+    n = raw_frame(frame, psdu, psdu_len, -50);
+    len = feed(frame, n, &out);
+    dec = decode(out, len, s_dec);
+
+    /* 10 PSDU bytes, the whole metadata after them */
+    CHECK_EQ(dec, (int)(n - (psdu_len - 10)));
+    CHECK_EQ(s_dec[3] | s_dec[4] << 8, 10);
+    CHECK(!memcmp(&s_dec[5], psdu, 10));
+    CHECK(!memcmp(&s_dec[15], &frame[5 + psdu_len], n - 5 - psdu_len));
+
+    /* compact: rssi, noise, flags and the PHY struct only */
+    CHECK_EQ(cli("snap", "0"), 0);
+    CHECK_EQ(cli("compact", "on"), 0);
+    len = feed(frame, n, &out);
+    dec = decode(out, len, s_dec);
+    CHECK_EQ(dec, 5 + psdu_len + 4 + 2 + 3);
+    CHECK_EQ(s_dec[5 + psdu_len + 6], 11);
+
+    sniffer_filter_stats(&st);
+    CHECK_EQ(st.truncated, 1);
+}
+
+static void test_bad_fcs(void) {
+    uint8_t psdu[64], frame[128];
+    sniffer_filter_stats_t st;
+    const uint8_t* out;
+    uint32_t n;
+
+    setup();
+    CHECK_EQ(cli("type", "2"), 0);
+    n = encode(s_enc, frame, raw_frame(frame, psdu, data_psdu(psdu, 1, 2), 0));
+    s_enc[10] ^= 0x01;
+    CHECK_EQ(sniffer_filter_feed(s_enc, n, &out), 0);
+    sniffer_filter_stats(&st);
+    CHECK_EQ(st.bad, 1);
+    CHECK_EQ(st.frames, 0);
+}
+
+/* the mask is decimal, as documented, or hex with 0x */
+static void test_type_mask(void) {
+    sniffer_filter_cfg_t cfg;
+
+    setup();
+    CHECK_EQ(cli("type", "10"), 0);
+    sniffer_filter_get(&cfg);
+    CHECK_EQ(cfg.type_mask, SNIFFER_FILTER_TYPE_DATA | SNIFFER_FILTER_TYPE_CMD);
+    CHECK_EQ(cli("type", "0x5"), 0);
+    sniffer_filter_get(&cfg);
+    CHECK_EQ(cfg.type_mask, SNIFFER_FILTER_TYPE_BEACON | SNIFFER_FILTER_TYPE_ACK);
+    CHECK_EQ(cli("type", "all"), 0);
+    CHECK(!sniffer_filter_active());
+}
+
+/* a property request from the host, as the stack would see it, and the
+ * reply of the filter decoded */
+static int host_request(uint8_t cmd, uint16_t prop, const uint8_t* value,
+                        uint8_t len, uint32_t chunk, bool* stack_frame) {
+    uint8_t req[32], reply[128];
+    uint32_t n, i;
+    int dec;
+
+    req[0] = 0x81;
+    req[1] = cmd;
+    req[2] = 0x80 | (prop & 0x7F);
+    req[3] = (uint8_t)(prop >> 7);
+    memcpy(&req[4], value, len);
+    n = encode(s_enc, req, 4 + len);
+
+    for (i = 0; i < n; i += chunk) {
+        sniffer_filter_host(&s_enc[i], (n - i < chunk) ? n - i : chunk);
+    }
+    *stack_frame = decode(s_enc, n, s_dec) >= 0;
+
+    n = sniffer_filter_reply(reply, sizeof(reply));
+    dec = decode(reply, n, s_dec);
+    CHECK_EQ(sniffer_filter_reply(reply, sizeof(reply)), 0);
+    if (dec >= 4) {
+        CHECK_EQ(s_dec[0], 0x81);
+        CHECK_EQ(s_dec[1], 6);
+    }
+    return dec;
+}
+
+static void test_vendor_props(void) {
+    uint8_t wire[SNIFFER_FILTER_CFG_WIRE_LEN] = {0};
+    const uint8_t status[] = {0x81, 6, 0x00, 0x00};
+    sniffer_filter_stats_t st;
+    sniffer_filter_cfg_t cfg;
+    const uint8_t* out;
+    uint32_t n;
+    bool stack;
+    int dec;
+
+    setup();
+
+    /* get: the stack never sees a whole frame */
+    dec = host_request(2, SNIFFER_FILTER_PROP_CFG, NULL, 0, 64, &stack);
+    CHECK(!stack);
+    CHECK_EQ(dec, 4 + SNIFFER_FILTER_CFG_WIRE_LEN);
+    CHECK_EQ(s_dec[2], 0x81);
+    CHECK_EQ(s_dec[3], 0x78);
+    CHECK_EQ(s_dec[4] | s_dec[5] << 8, SNIFFER_FILTER_PAN_ANY);
+    CHECK_EQ(s_dec[15], SNIFFER_FILTER_TYPE_ALL);
+    CHECK_EQ((int8_t)s_dec[16], SNIFFER_FILTER_RSSI_ANY);
+
+    /* set, the bytes coming a few at a time */
+    wire[0] = 0xce;
+    wire[1] = 0xfa;
+    wire[2] = 2;
+    wire[3] = 0x34;
+    wire[4] = 0x12;
+    wire[11] = SNIFFER_FILTER_TYPE_DATA;
+    wire[12] = (uint8_t)-90;
+    wire[13] = 64;
+    wire[15] = 1;
+    dec = host_request(3, SNIFFER_FILTER_PROP_CFG, wire, sizeof(wire), 3,
+                       &stack);
+    CHECK(!stack);
+    CHECK_EQ(dec, 4 + SNIFFER_FILTER_CFG_WIRE_LEN);
+    CHECK(!memcmp(&s_dec[4], wire, sizeof(wire)));
+    sniffer_filter_get(&cfg);
+    CHECK_EQ(cfg.pan_id, 0xface);
+    CHECK_EQ(cfg.addr_len, 2);
+    CHECK_EQ(cfg.addr[0], 0x34);
+    CHECK_EQ(cfg.type_mask, SNIFFER_FILTER_TYPE_DATA);
+    CHECK_EQ(cfg.rssi_min, -90);
+    CHECK_EQ(cfg.snap_len, 64);
+    CHECK(cfg.compact);
+
+    /* an address of 3 bytes is refused with a status */
+    wire[2] = 3;
+    dec = host_request(3, SNIFFER_FILTER_PROP_CFG, wire, sizeof(wire), 64,
+                       &stack);
+    CHECK_EQ(dec, 4);
+    CHECK_EQ(s_dec[2], 0);
+    CHECK_EQ(s_dec[3], 9);
+    sniffer_filter_get(&cfg);
+    CHECK_EQ(cfg.addr_len, 2);
+
+    /* the counters, and cleared by a set */
+    n = encode(s_enc, status, sizeof(status));
+    s_enc[2] ^= 0x01;
+    CHECK_EQ(sniffer_filter_feed(s_enc, n, &out), 0);
+    dec = host_request(2, SNIFFER_FILTER_PROP_STATS, NULL, 0, 64, &stack);
+    CHECK_EQ(dec, 4 + (int)sizeof(st));
+    memcpy(&st, &s_dec[4], sizeof(st));
+    CHECK_EQ(st.bad, 1);
+    dec = host_request(3, SNIFFER_FILTER_PROP_STATS, NULL, 0, 64, &stack);
+    memcpy(&st, &s_dec[4], sizeof(st));
+    CHECK_EQ(st.bad, 0);
+
+    /* any other request reaches the stack untouched, with no reply */
+    dec = host_request(2, 0x71, NULL, 0, 64, &stack);
+    CHECK(stack);
+    CHECK_EQ(dec, -1);
+    dec = host_request(2, SNIFFER_FILTER_PROP_CFG + 2, NULL, 0, 64, &stack);
+    CHECK(stack);
+    CHECK_EQ(dec, -1);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_pass_through);
+    HOST_TEST_RUN(test_pan_filter);
+    HOST_TEST_RUN(test_snap_and_compact);
+    HOST_TEST_RUN(test_bad_fcs);
+    HOST_TEST_RUN(test_type_mask);
+    HOST_TEST_RUN(test_vendor_props);
+    return HOST_TEST_END();
+}
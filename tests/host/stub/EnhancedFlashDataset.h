@@ -0,0 +1,48 @@
+/**
+ * @file EnhancedFlashDataset.h
+ * @brief Host stand-in for the flash key-value store: an in-memory table
+ *        that counts writes and survives a simulated reboot.
+ */
+
+#ifndef __HOST_STUB_EFD_H
+#define __HOST_STUB_EFD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    EF_NO_ERR,
+    EF_ERASE_ERR,
+    EF_READ_ERR,
+    EF_WRITE_ERR,
+    EF_ENV_NAME_ERR,
+    EF_ENV_NAME_EXIST,
+    EF_ENV_FULL,
+    EF_ENV_INIT_FAILED,
+} EfErrCode;
+
+typedef struct {
+    uint32_t sets;
+    uint32_t dels;
+    uint32_t bytes;
+} efd_stub_stats_t;
+
+extern efd_stub_stats_t g_efd_stub_stats;
+
+size_t efd_get_env_blob(const char* key, void* value_buf, size_t buf_len,
+                        size_t* saved_value_len);
+EfErrCode efd_set_env_blob(const char* key, const void* value_buf,
+                           size_t buf_len);
+EfErrCode efd_del_env(const char* key);
+
+/** Drop every record, like an erased dataset */
+void efd_stub_reset(void);
+/** Raw access to a record for corruption tests, NULL when absent */
+uint8_t* efd_stub_find(const char* key, size_t* len);
+/** Number of records */
+uint32_t efd_stub_count(void);
+/** Let the next `after` writes and deletes pass, fail the ones after with
+ *  err, EF_NO_ERR stops failing; cleared by efd_stub_reset() */
+void efd_stub_fail(uint32_t after, EfErrCode err);
+
+#endif // __HOST_STUB_EFD_H
@@ -0,0 +1,42 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the FreeRTOS types and critical sections used
+ *        by the modules under test. Single threaded, the masks are no-ops.
+ */
+
+#ifndef __HOST_STUB_FREERTOS_H
+#define __HOST_STUB_FREERTOS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+
+#define configTICK_RATE_HZ 1000
+#define portMAX_DELAY      ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+#define taskENTER_CRITICAL()             ((void)0)
+#define taskEXIT_CRITICAL()              ((void)0)
+#define taskENTER_CRITICAL_FROM_ISR()    ((UBaseType_t)0)
+#define taskEXIT_CRITICAL_FROM_ISR(mask) ((void)(mask))
+
+#define configASSERT(x)                                                        \
+    do {                                                                       \
+        if ((x) == 0) {                                                        \
+            stub_assert(#x, __FILE__, __LINE__);                               \
+        }                                                                      \
+    } while (0)
+
+void stub_assert(const char* expr, const char* file, int line);
+
+#endif // __HOST_STUB_FREERTOS_H
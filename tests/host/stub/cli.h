@@ -0,0 +1,23 @@
+/**
+ * @file cli.h
+ * @brief Host stand-in for the shell command table. Commands are kept as
+ *        plain constants, tests call the handlers through them.
+ */
+
+#ifndef __HOST_STUB_CLI_H
+#define __HOST_STUB_CLI_H
+
+#include <stdio.h>
+
+typedef int (*cb_shell_out_t)(const char* fmt, ...);
+
+typedef struct {
+    const char* pCmd_name;
+    const char* pDescription;
+    int (*cmd_exec)(int argc, char** argv, cb_shell_out_t log_out,
+                    void* pExtra);
+} sh_cmd_t;
+
+#define STATIC_CLI_CMD_ATTRIBUTE __attribute__((used))
+
+#endif // __HOST_STUB_CLI_H
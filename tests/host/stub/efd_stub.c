@@ -0,0 +1,137 @@
+/**
+ * @file efd_stub.c
+ * @brief In-memory flash key-value store of stub/EnhancedFlashDataset.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "EnhancedFlashDataset.h"
+
+#define EFD_STUB_KEY_LEN 32
+#define EFD_STUB_MAX     1024
+
+typedef struct {
+    char key[EFD_STUB_KEY_LEN];
+    uint8_t* value;
+    size_t len;
+} efd_stub_env_t;
+
+static efd_stub_env_t s_env[EFD_STUB_MAX];
+static uint32_t s_fail_after;
+static EfErrCode s_fail_err;
+efd_stub_stats_t g_efd_stub_stats;
+
+static EfErrCode fail_next(void) {
+    if (s_fail_err == EF_NO_ERR) {
+        return EF_NO_ERR;
+    }
+    if (s_fail_after) {
+        s_fail_after--;
+        return EF_NO_ERR;
+    }
+    return s_fail_err;
+}
+
+static efd_stub_env_t* env_find(const char* key) {
+    uint32_t i;
+
+    for (i = 0; i < EFD_STUB_MAX; i++) {
+        if (s_env[i].value && !strncmp(s_env[i].key, key, EFD_STUB_KEY_LEN)) {
+            return &s_env[i];
+        }
+    }
+    return NULL;
+}
+
+size_t efd_get_env_blob(const char* key, void* value_buf, size_t buf_len,
+                        size_t* saved_value_len) {
+    efd_stub_env_t* env = env_find(key);
+    size_t len;
+
+    if (saved_value_len) {
+        *saved_value_len = env ? env->len : 0;
+    }
+    if (env == NULL) {
+        return 0;
+    }
+    len = (env->len < buf_len) ? env->len : buf_len;
+    memcpy(value_buf, env->value, len);
+    return len;
+}
+
+EfErrCode efd_set_env_blob(const char* key, const void* value_buf,
+                           size_t buf_len) {
+    efd_stub_env_t* env = env_find(key);
+    EfErrCode err = fail_next();
+    uint32_t i;
+
+    if (err != EF_NO_ERR) {
+        return err;
+    }
+    if (env == NULL) {
+        for (i = 0; i < EFD_STUB_MAX && s_env[i].value; i++) {}
+        if (i == EFD_STUB_MAX) {
+            return EF_ENV_FULL;
+        }
+        env = &s_env[i];
+        strncpy(env->key, key, EFD_STUB_KEY_LEN - 1);
+    } else {
+        free(env->value);
+    }
+    env->value = malloc(buf_len ? buf_len : 1);
+    memcpy(env->value, value_buf, buf_len);
+    env->len = buf_len;
+    g_efd_stub_stats.sets++;
+    g_efd_stub_stats.bytes += buf_len;
+    return EF_NO_ERR;
+}
+
+EfErrCode efd_del_env(const char* key) {
+    efd_stub_env_t* env = env_find(key);
+    EfErrCode err = fail_next();
+
+    if (err != EF_NO_ERR) {
+        return err;
+    }
+    if (env == NULL) {
+        return EF_ENV_NAME_ERR;
+    }
+    free(env->value);
+    memset(env, 0, sizeof(*env));
+    g_efd_stub_stats.dels++;
+    return EF_NO_ERR;
+}
+
+void efd_stub_reset(void) {
+    uint32_t i;
+
+    for (i = 0; i < EFD_STUB_MAX; i++) {
+        free(s_env[i].value);
+    }
+    memset(s_env, 0, sizeof(s_env));
+    memset(&g_efd_stub_stats, 0, sizeof(g_efd_stub_stats));
+    efd_stub_fail(0, EF_NO_ERR);
+}
+
+void efd_stub_fail(uint32_t after, EfErrCode err) {
+    s_fail_after = after;
+    s_fail_err = err;
+}
+
+uint8_t* efd_stub_find(const char* key, size_t* len) {
+    efd_stub_env_t* env = env_find(key);
+
+    if (env && len) {
+        *len = env->len;
+    }
+    return env ? env->value : NULL;
+}
+
+uint32_t efd_stub_count(void) {
+    uint32_t i, num = 0;
+
+    for (i = 0; i < EFD_STUB_MAX; i++) {
+        num += (s_env[i].value != NULL);
+    }
+    return num;
+}
@@ -0,0 +1,16 @@
+/**
+ * @file hosal_trng.h
+ * @brief Host stand-in for the random number generator, seeded from the
+ *        test through g_stub_trng_seed so runs are reproducible.
+ */
+
+#ifndef __HOST_STUB_HOSAL_TRNG_H
+#define __HOST_STUB_HOSAL_TRNG_H
+
+#include <stdint.h>
+
+extern uint32_t g_stub_trng_seed;
+
+int hosal_trng_get_random_number(uint32_t* p_buffer, uint32_t number);
+
+#endif // __HOST_STUB_HOSAL_TRNG_H
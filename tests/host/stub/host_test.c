@@ -0,0 +1,8 @@
+/**
+ * @file host_test.c
+ * @brief Failure counter of host_test.h
+ */
+
+#include "host_test.h"
+
+int g_host_test_failed;
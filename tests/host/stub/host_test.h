@@ -0,0 +1,42 @@
+/**
+ * @file host_test.h
+ * @brief Minimal checks for the host tests: a failed check is reported and
+ *        counted, HOST_TEST_END() turns the count into the exit status.
+ */
+
+#ifndef __HOST_TEST_H
+#define __HOST_TEST_H
+
+#include <stdio.h>
+
+extern int g_host_test_failed;
+
+#define CHECK(x)                                                               \
+    do {                                                                       \
+        if (!(x)) {                                                            \
+            printf("%s:%d: CHECK ( %s ) failed\n", __FILE__, __LINE__, #x);    \
+            g_host_test_failed++;                                              \
+        }                                                                      \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                         \
+    do {                                                                       \
+        long long _a = (long long)(a), _b = (long long)(b);                    \
+        if (_a != _b) {                                                        \
+            printf("%s:%d: CHECK ( %s == %s ) failed: %lld != %lld\n",         \
+                   __FILE__, __LINE__, #a, #b, _a, _b);                        \
+            g_host_test_failed++;                                              \
+        }                                                                      \
+    } while (0)
+
+#define HOST_TEST_RUN(fn)                                                      \
+    do {                                                                       \
+        int _failed = g_host_test_failed;                                      \
+        fn();                                                                  \
+        printf("%-40s %s\n", #fn,                                              \
+               (g_host_test_failed == _failed) ? "ok" : "FAILED");             \
+    } while (0)
+
+#define HOST_TEST_END() (g_host_test_failed ? 1 : 0)
+
+#endif // __HOST_TEST_H
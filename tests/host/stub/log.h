@@ -0,0 +1,20 @@
+/**
+ * @file log.h
+ * @brief Host stand-in for the SDK log, silent unless HOST_STUB_LOG is set
+ */
+
+#ifndef __HOST_STUB_LOG_H
+#define __HOST_STUB_LOG_H
+
+#include <stdio.h>
+
+#ifdef HOST_STUB_LOG
+#define log_info(...)  (printf(__VA_ARGS__), printf("\n"))
+#else
+#define log_info(...)  ((void)0)
+#endif
+#define log_warn(...)  log_info(__VA_ARGS__)
+#define log_error(...) log_info(__VA_ARGS__)
+#define log_debug(...) ((void)0)
+
+#endif // __HOST_STUB_LOG_H
@@ -0,0 +1,27 @@
+/**
+ * @file queue.h
+ * @brief Host stand-in for queues. Single threaded, so a receive that
+ *        would block forever is a deadlock and asserts.
+ */
+
+#ifndef __HOST_STUB_QUEUE_H
+#define __HOST_STUB_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct {
+    uint8_t* buf;
+    uint32_t item_size;
+    uint32_t len;
+    uint32_t head;
+    uint32_t count;
+} stub_queue_t;
+
+typedef stub_queue_t* QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item_size);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+#endif // __HOST_STUB_QUEUE_H
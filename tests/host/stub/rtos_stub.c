@@ -0,0 +1,227 @@
+/**
+ * @file rtos_stub.c
+ * @brief Host stand-in for the FreeRTOS calls of stub/task.h, semphr.h,
+ *        timers.h and queue.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "task.h"
+#include "timers.h"
+
+TickType_t g_stub_tick;
+stub_task_t g_stub_idle_task = {"IDLE"};
+
+void stub_assert(const char* expr, const char* file, int line) {
+    fprintf(stderr, "ASSERT ( %s ) %s %d\n", expr, file, line);
+    abort();
+}
+
+TickType_t xTaskGetTickCount(void) { return g_stub_tick; }
+
+TickType_t xTaskGetTickCountFromISR(void) { return g_stub_tick; }
+
+TaskHandle_t xTaskGetIdleTaskHandle(void) { return &g_stub_idle_task; }
+
+char* pcTaskGetName(TaskHandle_t task) { return (char*)task->name; }
+
+void vTaskSuspendAll(void) {}
+
+BaseType_t xTaskResumeAll(void) { return pdFALSE; }
+
+/* semphr.h */
+
+#define STUB_SEM_MAX   32
+#define STUB_TIMER_MAX 32
+#define STUB_QUEUE_MAX 16
+
+int g_stub_mutex_held;
+int g_stub_in_timer;
+
+static stub_sem_t s_sems[STUB_SEM_MAX];
+static uint32_t s_sem_num;
+static stub_timer_t s_timers[STUB_TIMER_MAX];
+static uint32_t s_timer_num;
+static stub_queue_t s_queues[STUB_QUEUE_MAX];
+static uint32_t s_queue_num;
+
+static SemaphoreHandle_t sem_new(uint32_t max, uint32_t init, uint8_t mutex) {
+    stub_sem_t* sem;
+
+    if (s_sem_num == STUB_SEM_MAX) {
+        return NULL;
+    }
+    sem = &s_sems[s_sem_num++];
+    sem->count = init;
+    sem->max = max;
+    sem->mutex = mutex;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) { return sem_new(1, 1, 1); }
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) { return sem_new(1, 0, 0); }
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t init) {
+    return sem_new(max, init, 0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait) {
+    if (sem->count == 0) {
+        /* nobody else can give it */
+        configASSERT(!sem->mutex && wait != portMAX_DELAY);
+        return pdFALSE;
+    }
+    sem->count--;
+    g_stub_mutex_held += sem->mutex;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    if (sem->count == sem->max) {
+        return pdFALSE;
+    }
+    sem->count++;
+    g_stub_mutex_held -= sem->mutex;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t* woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xSemaphoreGive(sem);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) { (void)sem; }
+
+/* timers.h */
+
+TimerHandle_t xTimerCreate(const char* name, TickType_t period,
+                           UBaseType_t reload, void* id,
+                           TimerCallbackFunction_t cb) {
+    stub_timer_t* timer;
+
+    if (s_timer_num == STUB_TIMER_MAX) {
+        return NULL;
+    }
+    timer = &s_timers[s_timer_num++];
+    timer->name = name;
+    timer->period = period;
+    timer->reload = reload;
+    timer->id = id;
+    timer->cb = cb;
+    timer->active = 0;
+    return timer;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t wait) {
+    (void)wait;
+    timer->expiry = g_stub_tick + timer->period;
+    timer->active = 1;
+    return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t wait) {
+    (void)wait;
+    timer->active = 0;
+    return pdPASS;
+}
+
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t wait) {
+    return xTimerStart(timer, wait);
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period,
+                              TickType_t wait) {
+    configASSERT(period > 0);
+    timer->period = period;
+    return xTimerStart(timer, wait);
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer) { return timer->active; }
+
+void* pvTimerGetTimerID(TimerHandle_t timer) { return timer->id; }
+
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t wait) {
+    return xTimerStop(timer, wait);
+}
+
+void stub_timers_advance(TickType_t ticks) {
+    stub_timer_t* timer;
+    uint32_t i;
+
+    while (ticks--) {
+        g_stub_tick++;
+        for (i = 0; i < s_timer_num; i++) {
+            timer = &s_timers[i];
+            if (!timer->active || timer->expiry != g_stub_tick) {
+                continue;
+            }
+            if (timer->reload) {
+                timer->expiry += timer->period;
+            } else {
+                timer->active = 0;
+            }
+            g_stub_in_timer = 1;
+            timer->cb(timer);
+            g_stub_in_timer = 0;
+        }
+    }
+}
+
+/* queue.h */
+
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item_size) {
+    stub_queue_t* queue;
+
+    if (s_queue_num == STUB_QUEUE_MAX) {
+        return NULL;
+    }
+    queue = &s_queues[s_queue_num];
+    queue->buf = malloc(len * item_size);
+    if (!queue->buf) {
+        return NULL;
+    }
+    s_queue_num++;
+    queue->item_size = item_size;
+    queue->len = len;
+    queue->head = 0;
+    queue->count = 0;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t wait) {
+    uint32_t tail;
+
+    if (queue->count == queue->len) {
+        /* nobody else can take one */
+        configASSERT(wait != portMAX_DELAY);
+        return pdFALSE;
+    }
+    tail = (queue->head + queue->count) % queue->len;
+    memcpy(&queue->buf[tail * queue->item_size], item, queue->item_size);
+    queue->count++;
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait) {
+    if (queue->count == 0) {
+        /* nobody else can send one */
+        configASSERT(wait != portMAX_DELAY);
+        return pdFALSE;
+    }
+    memcpy(item, &queue->buf[queue->head * queue->item_size],
+           queue->item_size);
+    queue->head = (queue->head + 1) % queue->len;
+    queue->count--;
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    return queue->count;
+}
@@ -0,0 +1,31 @@
+/**
+ * @file semphr.h
+ * @brief Host stand-in for semaphores and mutexes. Single threaded, so a
+ *        take that would block is a deadlock and asserts.
+ */
+
+#ifndef __HOST_STUB_SEMPHR_H
+#define __HOST_STUB_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+typedef struct {
+    uint32_t count;
+    uint32_t max;
+    uint8_t mutex;
+} stub_sem_t;
+
+typedef stub_sem_t* SemaphoreHandle_t;
+
+/* mutexes held right now, for lock order checks */
+extern int g_stub_mutex_held;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t init);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t* woken);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+
+#endif // __HOST_STUB_SEMPHR_H
@@ -0,0 +1,28 @@
+/**
+ * @file task.h
+ * @brief Host stand-in for the task API. The tick count is driven by the
+ *        test through g_stub_tick, a task handle is a stub_task_t.
+ */
+
+#ifndef __HOST_STUB_TASK_H
+#define __HOST_STUB_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct {
+    const char* name;
+} stub_task_t;
+
+typedef stub_task_t* TaskHandle_t;
+
+extern TickType_t g_stub_tick;
+extern stub_task_t g_stub_idle_task;
+
+TickType_t xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+TaskHandle_t xTaskGetIdleTaskHandle(void);
+char* pcTaskGetName(TaskHandle_t task);
+void vTaskSuspendAll(void);
+BaseType_t xTaskResumeAll(void);
+
+#endif // __HOST_STUB_TASK_H
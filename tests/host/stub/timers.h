@@ -0,0 +1,45 @@
+/**
+ * @file timers.h
+ * @brief Host stand-in for software timers. stub_timers_advance() moves
+ *        g_stub_tick and runs the callbacks that come due, as the timer
+ *        daemon would.
+ */
+
+#ifndef __HOST_STUB_TIMERS_H
+#define __HOST_STUB_TIMERS_H
+
+#include "FreeRTOS.h"
+
+typedef struct stub_timer stub_timer_t;
+typedef stub_timer_t* TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+struct stub_timer {
+    const char* name;
+    TickType_t period;
+    TickType_t expiry;
+    UBaseType_t reload;
+    void* id;
+    TimerCallbackFunction_t cb;
+    uint8_t active;
+};
+
+/* set while a timer callback runs */
+extern int g_stub_in_timer;
+
+TimerHandle_t xTimerCreate(const char* name, TickType_t period,
+                           UBaseType_t reload, void* id,
+                           TimerCallbackFunction_t cb);
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t wait);
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t wait);
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t wait);
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period,
+                              TickType_t wait);
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer);
+void* pvTimerGetTimerID(TimerHandle_t timer);
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t wait);
+
+/* advance the tick one by one, running the timers that expire */
+void stub_timers_advance(TickType_t ticks);
+
+#endif // __HOST_STUB_TIMERS_H
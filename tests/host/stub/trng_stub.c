@@ -0,0 +1,21 @@
+/**
+ * @file trng_stub.c
+ * @brief Reproducible random numbers of stub/hosal_trng.h (xorshift32)
+ */
+
+#include "hosal_trng.h"
+
+uint32_t g_stub_trng_seed = 0x12345678;
+
+int hosal_trng_get_random_number(uint32_t* p_buffer, uint32_t number) {
+    uint32_t i, x = g_stub_trng_seed;
+
+    for (i = 0; i < number; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        p_buffer[i] = x;
+    }
+    g_stub_trng_seed = x;
+    return 0;
+}
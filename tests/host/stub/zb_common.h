@@ -0,0 +1,42 @@
+/**
+ * @file zb_common.h
+ * @brief Host stand-in for the ZBOSS base types and the application alarm
+ *
+ * An alarm is only recorded, the test runs it with zb_stub_alarm_run().
+ */
+
+#ifndef __HOST_STUB_ZB_COMMON_H
+#define __HOST_STUB_ZB_COMMON_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint8_t zb_uint8_t;
+typedef uint16_t zb_uint16_t;
+typedef uint32_t zb_uint32_t;
+typedef uint8_t zb_bufid_t;
+typedef void (*zb_callback_t)(zb_uint8_t param);
+
+#define ZB_TRUE  1
+#define ZB_FALSE 0
+
+#define ZB_MILLISECONDS_TO_BEACON_INTERVAL(ms) ((ms) / 15)
+
+#define ZB_SCHEDULE_APP_ALARM(func, param, delay)                              \
+    zb_stub_alarm_set((func), (param), (delay))
+
+typedef struct {
+    uint32_t set;  /* alarms scheduled */
+    uint32_t run;  /* alarms run */
+} zb_stub_stats_t;
+
+extern zb_stub_stats_t g_zb_stub_stats;
+
+void zb_stub_alarm_set(zb_callback_t func, zb_uint8_t param, uint32_t delay);
+
+/* Run the pending alarm, false when there is none */
+bool zb_stub_alarm_run(void);
+
+void zb_stub_reset(void);
+
+#endif // __HOST_STUB_ZB_COMMON_H
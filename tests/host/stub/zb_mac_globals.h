@@ -0,0 +1,11 @@
+/**
+ * @file zb_mac_globals.h
+ * @brief Host stand-in, the examples include it next to zb_common.h
+ */
+
+#ifndef __HOST_STUB_ZB_MAC_GLOBALS_H
+#define __HOST_STUB_ZB_MAC_GLOBALS_H
+
+#include "zb_common.h"
+
+#endif // __HOST_STUB_ZB_MAC_GLOBALS_H
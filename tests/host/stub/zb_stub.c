@@ -0,0 +1,36 @@
+/**
+ * @file zb_stub.c
+ * @brief Application alarm of stub/zb_common.h, one alarm at a time
+ */
+
+#include <string.h>
+#include "zb_common.h"
+
+zb_stub_stats_t g_zb_stub_stats;
+
+static zb_callback_t s_alarm;
+static zb_uint8_t s_alarm_param;
+
+void zb_stub_alarm_set(zb_callback_t func, zb_uint8_t param, uint32_t delay) {
+    (void)delay;
+    s_alarm = func;
+    s_alarm_param = param;
+    g_zb_stub_stats.set++;
+}
+
+bool zb_stub_alarm_run(void) {
+    zb_callback_t func = s_alarm;
+
+    if (func == NULL) {
+        return false;
+    }
+    s_alarm = NULL;
+    g_zb_stub_stats.run++;
+    func(s_alarm_param);
+    return true;
+}
+
+void zb_stub_reset(void) {
+    s_alarm = NULL;
+    memset(&g_zb_stub_stats, 0, sizeof(g_zb_stub_stats));
+}
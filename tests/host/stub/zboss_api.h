@@ -0,0 +1,88 @@
+/**
+ * @file zboss_api.h
+ * @brief Host stand-in for the ZBOSS API, the ZCL ids of the ZCL spec only
+ */
+
+#ifndef __HOST_STUB_ZBOSS_API_H
+#define __HOST_STUB_ZBOSS_API_H
+
+#include <stdint.h>
+#include "zb_common.h"
+
+#define ZB_ZCL_CLUSTER_ID_BASIC                     0x0000
+#define ZB_ZCL_CLUSTER_ID_ON_OFF                    0x0006
+#define ZB_ZCL_CLUSTER_ID_ALARMS                    0x0009
+#define ZB_ZCL_CLUSTER_ID_OTA_UPGRADE               0x0019
+#define ZB_ZCL_CLUSTER_ID_DOOR_LOCK                 0x0101
+#define ZB_ZCL_CLUSTER_ID_ILLUMINANCE_MEASUREMENT   0x0400
+#define ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT          0x0402
+#define ZB_ZCL_CLUSTER_ID_PRESSURE_MEASUREMENT      0x0403
+#define ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT  0x0405
+#define ZB_ZCL_CLUSTER_ID_OCCUPANCY_SENSING         0x0406
+#define ZB_ZCL_CLUSTER_ID_IAS_ZONE                  0x0500
+#define ZB_ZCL_CLUSTER_ID_IAS_ACE                   0x0501
+#define ZB_ZCL_CLUSTER_ID_IAS_WD                    0x0502
+#define ZB_ZCL_CLUSTER_ID_METERING                  0x0702
+#define ZB_ZCL_CLUSTER_ID_ELECTRICAL_MEASUREMENT    0x0b04
+
+#define ZB_ZCL_CMD_READ_ATTRIB_RESP   0x01
+#define ZB_ZCL_CMD_WRITE_ATTRIB_RESP  0x04
+#define ZB_ZCL_CMD_REPORT_ATTRIB      0x0a
+#define ZB_ZCL_CMD_DEFAULT_RESP       0x0b
+
+#define ZB_ZCL_STATUS_SUCCESS         0x00
+#define ZB_ZCL_STATUS_UNSUP_ATTRIB    0x86
+
+#define ZB_ZCL_ATTR_TYPE_8BIT              0x08
+#define ZB_ZCL_ATTR_TYPE_16BIT             0x09
+#define ZB_ZCL_ATTR_TYPE_24BIT             0x0a
+#define ZB_ZCL_ATTR_TYPE_32BIT             0x0b
+#define ZB_ZCL_ATTR_TYPE_40BIT             0x0c
+#define ZB_ZCL_ATTR_TYPE_48BIT             0x0d
+#define ZB_ZCL_ATTR_TYPE_56BIT             0x0e
+#define ZB_ZCL_ATTR_TYPE_64BIT             0x0f
+#define ZB_ZCL_ATTR_TYPE_BOOL              0x10
+#define ZB_ZCL_ATTR_TYPE_8BITMAP           0x18
+#define ZB_ZCL_ATTR_TYPE_16BITMAP          0x19
+#define ZB_ZCL_ATTR_TYPE_24BITMAP          0x1a
+#define ZB_ZCL_ATTR_TYPE_32BITMAP          0x1b
+#define ZB_ZCL_ATTR_TYPE_40BITMAP          0x1c
+#define ZB_ZCL_ATTR_TYPE_48BITMAP          0x1d
+#define ZB_ZCL_ATTR_TYPE_56BITMAP          0x1e
+#define ZB_ZCL_ATTR_TYPE_64BITMAP          0x1f
+#define ZB_ZCL_ATTR_TYPE_U8                0x20
+#define ZB_ZCL_ATTR_TYPE_U16               0x21
+#define ZB_ZCL_ATTR_TYPE_U24               0x22
+#define ZB_ZCL_ATTR_TYPE_U32               0x23
+#define ZB_ZCL_ATTR_TYPE_U40               0x24
+#define ZB_ZCL_ATTR_TYPE_U48               0x25
+#define ZB_ZCL_ATTR_TYPE_U56               0x26
+#define ZB_ZCL_ATTR_TYPE_U64               0x27
+#define ZB_ZCL_ATTR_TYPE_S8                0x28
+#define ZB_ZCL_ATTR_TYPE_S16               0x29
+#define ZB_ZCL_ATTR_TYPE_S24               0x2a
+#define ZB_ZCL_ATTR_TYPE_S32               0x2b
+#define ZB_ZCL_ATTR_TYPE_S40               0x2c
+#define ZB_ZCL_ATTR_TYPE_S48               0x2d
+#define ZB_ZCL_ATTR_TYPE_S56               0x2e
+#define ZB_ZCL_ATTR_TYPE_S64               0x2f
+#define ZB_ZCL_ATTR_TYPE_8BIT_ENUM         0x30
+#define ZB_ZCL_ATTR_TYPE_16BIT_ENUM        0x31
+#define ZB_ZCL_ATTR_TYPE_SEMI              0x38
+#define ZB_ZCL_ATTR_TYPE_SINGLE            0x39
+#define ZB_ZCL_ATTR_TYPE_DOUBLE            0x3a
+#define ZB_ZCL_ATTR_TYPE_OCTET_STRING      0x41
+#define ZB_ZCL_ATTR_TYPE_CHAR_STRING       0x42
+#define ZB_ZCL_ATTR_TYPE_LONG_OCTET_STRING 0x43
+#define ZB_ZCL_ATTR_TYPE_ARRAY             0x48
+#define ZB_ZCL_ATTR_TYPE_CUSTOM_32ARRAY    0x4a
+#define ZB_ZCL_ATTR_TYPE_TIME_OF_DAY       0xe0
+#define ZB_ZCL_ATTR_TYPE_DATE              0xe1
+#define ZB_ZCL_ATTR_TYPE_UTC_TIME          0xe2
+#define ZB_ZCL_ATTR_TYPE_CLUSTER_ID        0xe8
+#define ZB_ZCL_ATTR_TYPE_ATTRIBUTE_ID      0xe9
+#define ZB_ZCL_ATTR_TYPE_BACNET_OID        0xea
+#define ZB_ZCL_ATTR_TYPE_IEEE_ADDR         0xf0
+#define ZB_ZCL_ATTR_TYPE_128_BIT_KEY       0xf1
+
+#endif // __HOST_STUB_ZBOSS_API_H
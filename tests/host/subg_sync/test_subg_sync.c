@@ -0,0 +1,233 @@
+/**
+ * @file test_subg_sync.c
+ * @brief Beacon synchronisation of subg-sample: slots taken from the
+ *        address, offset and drift estimated from two-step beacons against
+ *        a node clock running fast, the smoothing of a drift change, lost
+ *        beacons and the next slot as seen in network time.
+ *
+ * The coordinator clock is the network time, the node clock runs
+ * s_ppm fast from an offset of 7 s. Beacons go every second.
+ */
+
+#include "host_test.h"
+#include "subg_sync.h"
+
+#define NODE_ADDR   3
+#define NODE_OFFSET 7000000ULL
+
+static const subg_sync_cfg_t s_cfg = {
+    .slot_us = 10000,
+    .slots = 10,
+    .beacon_frames = 10,
+    .lost_beacons = 3,
+    .guard_us = 500,
+};
+
+static subg_sync_t s_coord;
+static subg_sync_t s_node;
+static int32_t s_ppm;
+/* node clock at the last change of rate */
+static uint64_t s_base_net;
+static uint64_t s_base_local;
+
+static uint64_t node_local(uint64_t net) {
+    int64_t dt = (int64_t)(net - s_base_net);
+
+    return s_base_local + dt + dt * s_ppm / 1000000;
+}
+
+static void node_rate_set(uint64_t net, int32_t ppm) {
+    s_base_local = node_local(net);
+    s_base_net = net;
+    s_ppm = ppm;
+}
+
+static int64_t diff(uint64_t a, uint64_t b) { return (int64_t)(a - b); }
+
+static int64_t abs64(int64_t v) { return v < 0 ? -v : v; }
+
+static void setup(int32_t ppm) {
+    s_base_net = 0;
+    s_base_local = NODE_OFFSET;
+    s_ppm = ppm;
+    subg_sync_init(&s_coord, &s_cfg, 0, true, 0);
+    subg_sync_init(&s_node, &s_cfg, NODE_ADDR, false, node_local(0));
+}
+
+/* a beacon whose SFD is at net, heard by the node or not */
+static void beacon(uint64_t net, bool heard) {
+    uint8_t buf[SUBG_SYNC_BEACON_LEN];
+
+    CHECK_EQ(subg_sync_beacon_build(&s_coord, buf), SUBG_SYNC_BEACON_LEN);
+    if (heard) {
+        CHECK_EQ(subg_sync_beacon_rx(&s_node, buf, sizeof(buf),
+                                     node_local(net)),
+                 0);
+    }
+    subg_sync_beacon_sent(&s_coord, true, net);
+}
+
+static void test_slot_of(void) {
+    subg_sync_cfg_t cfg = s_cfg;
+    uint16_t addr;
+
+    /* consecutive addresses take consecutive slots, never slot 0 */
+    CHECK_EQ(subg_sync_slot_of(&cfg, 0), 1);
+    CHECK_EQ(subg_sync_slot_of(&cfg, 8), 9);
+    CHECK_EQ(subg_sync_slot_of(&cfg, 9), 1);
+    for (addr = 0; addr < 100; addr++) {
+        CHECK(subg_sync_slot_of(&cfg, addr) != 0);
+        CHECK(subg_sync_slot_of(&cfg, addr) < cfg.slots);
+    }
+    cfg.slots = 1;
+    CHECK_EQ(subg_sync_slot_of(&cfg, 5), 0);
+}
+
+/* the coordinator is synchronised from the start, its clock is the
+ * network time */
+static void test_next_slot(void) {
+    subg_sync_t sync;
+    uint64_t at = 0;
+
+    subg_sync_init(&sync, &s_cfg, 2, true, 0);
+    CHECK_EQ(sync.slot, 3);
+    CHECK_EQ(subg_sync_next_slot(&sync, 0, &at), 0);
+    CHECK_EQ(at, 30500);
+    CHECK_EQ(subg_sync_next_slot(&sync, 30500, &at), 0);
+    CHECK_EQ(at, 30500);
+    CHECK_EQ(subg_sync_next_slot(&sync, 30501, &at), 0);
+    CHECK_EQ(at, 130500);
+
+    /* beacons every beacon_frames slotframes */
+    CHECK_EQ(subg_sync_next_beacon(&sync, 500, &at), 0);
+    CHECK_EQ(at, 500);
+    CHECK_EQ(subg_sync_next_beacon(&sync, 501, &at), 0);
+    CHECK_EQ(at, 1000500);
+
+    /* a node waits for beacons, slot 0 never sends */
+    setup(0);
+    CHECK_EQ(subg_sync_next_slot(&s_node, node_local(0), &at), -1);
+    CHECK_EQ(subg_sync_next_beacon(&s_node, node_local(0), &at), -1);
+    sync.slot = 0;
+    CHECK_EQ(subg_sync_next_slot(&sync, 0, &at), -1);
+}
+
+static void test_offset_and_drift(void) {
+    uint64_t at = 0, now, net;
+    uint32_t k;
+
+    setup(40);
+    beacon(1000000, true);
+    CHECK(!s_node.synced); /* the first one only gives its SFD */
+    for (k = 2; k <= 10; k++) {
+        beacon(k * 1000000ULL, true);
+    }
+    CHECK(s_node.synced);
+    CHECK_EQ(s_node.samples, 9);
+    /* local runs 1 + 40e-6 times the network time */
+    CHECK(abs64(s_node.drift_ppb - (-39998)) <= 2);
+    CHECK(s_node.error_max_us <= 1);
+
+    /* half a second on from the last beacon, in both directions */
+    net = 10500000;
+    CHECK(abs64(diff(subg_sync_to_net(&s_node, node_local(net)), net)) <= 1);
+    CHECK(abs64(diff(subg_sync_to_local(&s_node, net), node_local(net))) <= 1);
+
+    /* the next slot of address 3 is slot 4 of the next slotframe */
+    now = node_local(net + 1);
+    CHECK_EQ(subg_sync_next_slot(&s_node, now, &at), 0);
+    CHECK(abs64(diff(at, node_local(10540500))) <= 1);
+}
+
+/* a drift change moves the estimate by 1/2^SUBG_SYNC_DRIFT_SHIFT a pair,
+ * from the pair after it: beacon 6 carries the SFD of beacon 5 */
+static void test_drift_smoothing(void) {
+    int32_t before, step;
+    uint32_t k;
+
+    setup(-20);
+    for (k = 1; k <= 5; k++) {
+        beacon(k * 1000000ULL, true);
+    }
+    before = s_node.drift_ppb;
+    CHECK(abs64(before - 20000) <= 2);
+
+    node_rate_set(5000000, 10);
+    beacon(6000000, true);
+    CHECK_EQ(s_node.drift_ppb, before);
+    beacon(7000000, true);
+    step = s_node.drift_ppb - before;
+    CHECK(abs64(step - (-30000 >> SUBG_SYNC_DRIFT_SHIFT)) <= 2);
+    /* the error of the prediction across the change is the 30 ppm */
+    CHECK(abs64(s_node.error_us - (-30)) <= 1);
+    CHECK(s_node.error_max_us >= 29);
+
+    for (k = 8; k <= 40; k++) {
+        beacon(k * 1000000ULL, true);
+    }
+    CHECK(abs64(s_node.drift_ppb - (-9999)) <= 2);
+}
+
+static void test_lost_beacons(void) {
+    uint64_t at;
+    uint8_t samples;
+
+    setup(40);
+    beacon(1000000, true);
+    beacon(2000000, true);
+    beacon(3000000, true);
+    samples = s_node.samples;
+
+    /* the pair of a missed beacon is skipped, not taken across two */
+    beacon(4000000, false);
+    beacon(5000000, true);
+    CHECK_EQ(s_node.samples, samples);
+    beacon(6000000, true);
+    CHECK_EQ(s_node.samples, samples + 1);
+
+    /* a beacon that did not go on air is not paired either */
+    subg_sync_beacon_sent(&s_coord, false, 0);
+    beacon(8000000, true);
+    CHECK_EQ(s_node.samples, samples + 1);
+
+    /* lost_beacons periods of silence drop the node out of sync, in
+     * local time */
+    CHECK(subg_sync_check(&s_node, node_local(8000000) + 3000000));
+    CHECK(!subg_sync_check(&s_node, node_local(8000000) + 3000001));
+    CHECK_EQ(s_node.lost, 1);
+    CHECK_EQ(s_node.samples, 0);
+    CHECK_EQ(subg_sync_next_slot(&s_node, node_local(11000000), &at), -1);
+}
+
+/* a schedule change in the beacon restarts the estimate */
+static void test_schedule_change(void) {
+    uint8_t buf[SUBG_SYNC_BEACON_LEN];
+
+    setup(0);
+    beacon(1000000, true);
+    beacon(2000000, true);
+    CHECK(s_node.synced);
+
+    s_coord.cfg.slots = 5;
+    beacon(3000000, true);
+    CHECK_EQ(s_node.cfg.slots, 5);
+    CHECK_EQ(s_node.slot, 4);
+    CHECK(!s_node.synced);
+
+    /* not a beacon */
+    subg_sync_beacon_build(&s_coord, buf);
+    buf[0] = 0;
+    CHECK_EQ(subg_sync_beacon_rx(&s_node, buf, sizeof(buf), 0), -1);
+    CHECK_EQ(subg_sync_beacon_rx(&s_node, buf, SUBG_SYNC_BEACON_LEN - 1, 0),
+             -1);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_slot_of);
+    HOST_TEST_RUN(test_next_slot);
+    HOST_TEST_RUN(test_offset_and_drift);
+    HOST_TEST_RUN(test_drift_smoothing);
+    HOST_TEST_RUN(test_lost_beacons);
+    HOST_TEST_RUN(test_schedule_change);
+    return HOST_TEST_END();
+}
@@ -0,0 +1,12 @@
+/**
+ * @file mcu.h
+ * @brief Host stand-in for the MCU header of the subg-sample main.h
+ */
+
+#ifndef __TS_MOCK_MCU_H
+#define __TS_MOCK_MCU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#endif // __TS_MOCK_MCU_H
@@ -0,0 +1,22 @@
+/**
+ * @file subg_ctrl.h
+ * @brief Host stand-in for the Sub-GHz modulations and data rates
+ */
+
+#ifndef __TS_MOCK_SUBG_CTRL_H
+#define __TS_MOCK_SUBG_CTRL_H
+
+typedef enum {
+    SUBG_CTRL_MODU_FSK,
+    SUBG_CTRL_MODU_OQPSK,
+} subg_ctrl_modulation_t;
+
+typedef enum {
+    SUBG_CTRL_DATA_RATE_6P25K,
+    SUBG_CTRL_DATA_RATE_50K,
+    SUBG_CTRL_DATA_RATE_100K,
+    SUBG_CTRL_DATA_RATE_200K,
+    SUBG_CTRL_DATA_RATE_300K,
+} subg_ctrl_data_rate_t;
+
+#endif // __TS_MOCK_SUBG_CTRL_H
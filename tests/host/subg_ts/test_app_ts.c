@@ -0,0 +1,82 @@
+/**
+ * @file test_app_ts.c
+ * @brief Timestamp glue of subg-sample: the airtime inputs and RX delay
+ *        app_ts_rate_set() hands to subg_ts, and the tx done status map.
+ *
+ * The source is included so the record can be checked directly. The cycle
+ * counter is a variable set by the test, the RX delay a build option.
+ */
+
+#include "app_ts.c"
+#include "host_test.h"
+
+uint32_t g_ts_now;
+
+static void test_rate_set(void) {
+    const subg_ts_phy_t* phy;
+
+    subg_ts_init(&s_ts, APP_TS_TIMESTAMP_HZ);
+    app_ts_rate_set(SUBG_CTRL_MODU_FSK, SUBG_CTRL_DATA_RATE_50K);
+    phy = &s_ts.current->phy;
+    CHECK_EQ(s_ts.current->rate, SUBG_CTRL_DATA_RATE_50K);
+    CHECK_EQ(phy->bit_rate, 50000);
+    CHECK_EQ(phy->shr_octets, APP_TS_FSK_SHR);
+    CHECK_EQ(phy->phr_octets, APP_TS_FSK_PHR);
+    CHECK_EQ(phy->rx_delay_us, CONFIG_APP_SUBG_TS_RX_DELAY_US);
+    CHECK(phy->rx_delay_us != 0);
+
+    app_ts_rate_set(SUBG_CTRL_MODU_OQPSK, SUBG_CTRL_DATA_RATE_6P25K);
+    phy = &s_ts.current->phy;
+    CHECK_EQ(phy->bit_rate, 6250);
+    CHECK_EQ(phy->shr_octets, APP_TS_OQPSK_SHR);
+    CHECK_EQ(phy->phr_octets, APP_TS_OQPSK_PHR);
+    CHECK_EQ(phy->rx_delay_us, CONFIG_APP_SUBG_TS_RX_DELAY_US);
+}
+
+static void test_rx_sfd(void) {
+    subg_ts_rx_t rx;
+    uint32_t us;
+
+    subg_ts_init(&s_ts, APP_TS_TIMESTAMP_HZ);
+    app_ts_rate_set(SUBG_CTRL_MODU_FSK, SUBG_CTRL_DATA_RATE_100K);
+
+    /* PHR, 30 octets and FCS at 80 us an octet, then the callback */
+    app_ts_rx(5000000, 30, &rx);
+    us = (APP_TS_FSK_PHR + 30 + APP_TS_FCS) * 80
+         + CONFIG_APP_SUBG_TS_RX_DELAY_US;
+    CHECK_EQ(app_ts_ticks_to_us(rx.done - rx.sfd), us);
+    CHECK(app_ts_rx_last()->sfd == rx.sfd);
+}
+
+static void test_tx_status(void) {
+    static const struct {
+        uint32_t status;
+        bool failed;
+    } map[] = {{0x00, false}, {0x40, false}, {0x80, false},
+               {0x10, true},  {0x20, true},  {0x01, true}};
+    const subg_ts_rate_t* r;
+    uint32_t failed = 0;
+    uint8_t i;
+
+    subg_ts_init(&s_ts, APP_TS_TIMESTAMP_HZ);
+    app_ts_rate_set(SUBG_CTRL_MODU_FSK, SUBG_CTRL_DATA_RATE_300K);
+    r = subg_ts_rate_get(&s_ts, 0);
+    for (i = 0; i < sizeof(map) / sizeof(map[0]); i++) {
+        g_ts_now = 1000;
+        app_ts_tx_enqueue(20);
+        g_ts_now += 10000 * (APP_TS_TIMESTAMP_HZ / 1000000);
+        app_ts_tx_done_isr();
+        app_ts_tx_complete(map[i].status);
+        failed += map[i].failed;
+        CHECK_EQ(r->failed, failed);
+    }
+    CHECK_EQ(r->frames, i);
+    CHECK_EQ(r->lat[SUBG_TS_LAT_TOTAL].max_us, 10000);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_rate_set);
+    HOST_TEST_RUN(test_rx_sfd);
+    HOST_TEST_RUN(test_tx_status);
+    return HOST_TEST_END();
+}
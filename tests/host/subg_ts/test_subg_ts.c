@@ -0,0 +1,170 @@
+/**
+ * @file test_subg_ts.c
+ * @brief Frame timestamps of subg-sample: latencies of marked and estimated
+ *        frames against intervals worked out by hand, and the SFD of sent
+ *        and received frames.
+ *
+ * The counter runs at 48 MHz and starts close to its wrap. At 50 kbit/s an
+ * octet is 160 us on air.
+ */
+
+#include "host_test.h"
+#include "subg_ts.h"
+
+#define HZ 48000000
+#define M  (HZ / 1000000)
+
+static const subg_ts_phy_t s_fsk_50k = {
+    .bit_rate = 50000,
+    .shr_octets = 10,
+    .phr_octets = 2,
+    .fcs_octets = 2,
+    .ack_octets = 3,
+    .turnaround_us = 1000,
+    .ack_wait_us = 16000,
+};
+
+static subg_ts_t s_ts;
+
+static const subg_ts_rate_t* setup(const subg_ts_phy_t* phy) {
+    subg_ts_init(&s_ts, HZ);
+    CHECK_EQ(subg_ts_rate_set(&s_ts, 1, phy), 0);
+    return subg_ts_rate_get(&s_ts, 0);
+}
+
+static void test_marked_frame(void) {
+    const subg_ts_rate_t* r = setup(&s_fsk_50k);
+    uint32_t t0 = 0xFFFFFF00u;
+
+    /* 100 octets: 114 on air */
+    CHECK_EQ(subg_ts_airtime_us(&s_ts, 100), 18240);
+
+    subg_ts_tx_enqueue(&s_ts, t0, 100);
+    subg_ts_tx_mark(&s_ts, SUBG_TS_CSMA, t0 + 100 * M);
+    subg_ts_tx_mark(&s_ts, SUBG_TS_TX, t0 + 3000 * M);
+    subg_ts_tx_mark(&s_ts, SUBG_TS_TX_DONE, t0 + 21240 * M);
+    subg_ts_tx_mark(&s_ts, SUBG_TS_ACK, t0 + 25000 * M);
+    subg_ts_tx_complete(&s_ts, t0 + 25100 * M, SUBG_TS_TX_ACKED);
+
+    CHECK_EQ(r->frames, 1);
+    CHECK_EQ(r->estimated, 0);
+    CHECK_EQ(r->lat[SUBG_TS_LAT_TOTAL].max_us, 25100);
+    CHECK_EQ(r->lat[SUBG_TS_LAT_QUEUE].max_us, 100);
+    CHECK_EQ(r->lat[SUBG_TS_LAT_CSMA].max_us, 2900);
+    CHECK_EQ(r->lat[SUBG_TS_LAT_AIR].max_us, 18240);
+    CHECK_EQ(r->lat[SUBG_TS_LAT_ACK].max_us, 3760);
+}
+
+static void test_estimated_frames(void) {
+    const subg_ts_rate_t* r = setup(&s_fsk_50k);
+
+    /* ACK: turnaround and 17 octets on air */
+    subg_ts_tx_enqueue(&s_ts, 1000, 100);
+    subg_ts_tx_complete(&s_ts, 1000 + 40000 * M, SUBG_TS_TX_ACKED);
+    CHECK_EQ(r->frames, 1);
+    CHECK_EQ(r->estimated, 1);
+    CHECK_EQ(r->lat[SUBG_TS_LAT_ACK].min_us, 1000 + 17 * 160);
+    CHECK_EQ(r->lat[SUBG_TS_LAT_AIR].min_us, 18240);
+    CHECK_EQ(r->lat[SUBG_TS_LAT_CSMA].max_us, 40000 - 3720 - 18240);
+    CHECK_EQ(r->lat[SUBG_TS_LAT_QUEUE].count, 0);
+
+    /* no ACK, shorter than the estimate: clamped at 0 */
+    subg_ts_tx_enqueue(&s_ts, 5, 100);
+    subg_ts_tx_complete(&s_ts, 5 + 1000 * M, SUBG_TS_TX_NO_ACK);
+    CHECK_EQ(r->failed, 1);
+    CHECK_EQ(r->lat[SUBG_TS_LAT_CSMA].min_us, 0);
+    CHECK_EQ(r->lat[SUBG_TS_LAT_AIR].min_us, 0);
+
+    /* CCA failure, nothing on air */
+    subg_ts_tx_enqueue(&s_ts, 5, 100);
+    subg_ts_tx_complete(&s_ts, 5 + 7000 * M, SUBG_TS_TX_CCA_FAIL);
+    CHECK_EQ(r->failed, 2);
+    CHECK_EQ(r->lat[SUBG_TS_LAT_CSMA].count, 3);
+    CHECK_EQ(r->lat[SUBG_TS_LAT_AIR].count, 2);
+
+    /* a completion without an enqueue */
+    subg_ts_tx_complete(&s_ts, 5, SUBG_TS_TX_SENT);
+    CHECK_EQ(s_ts.unmatched, 1);
+    CHECK_EQ(r->frames, 3);
+}
+
+static void test_tx_sfd(void) {
+    uint32_t sfd;
+
+    setup(&s_fsk_50k);
+    CHECK_EQ(subg_ts_tx_sfd(&s_ts, &sfd), -1);
+
+    /* 1 ms queued, SHR, then PHR, 26 octets and FCS */
+    subg_ts_tx_enqueue(&s_ts, 1000, 26);
+    subg_ts_tx_complete(&s_ts, 1000 + (1000 + 40 * 160) * M,
+                        SUBG_TS_TX_SENT);
+    CHECK_EQ(subg_ts_tx_sfd(&s_ts, &sfd), 0);
+    CHECK_EQ(sfd, 1000 + (1000 + 10 * 160) * M);
+
+    subg_ts_tx_enqueue(&s_ts, 1000, 26);
+    subg_ts_tx_complete(&s_ts, 5000, SUBG_TS_TX_CCA_FAIL);
+    CHECK_EQ(subg_ts_tx_sfd(&s_ts, &sfd), -1);
+}
+
+static void test_rx_sfd(void) {
+    subg_ts_phy_t phy = s_fsk_50k;
+    subg_ts_rx_t rx;
+
+    /* no rate selected: the callback time */
+    subg_ts_init(&s_ts, HZ);
+    subg_ts_rx(&s_ts, 1000000, 20, &rx);
+    CHECK_EQ(rx.sfd, 1000000);
+    CHECK_EQ(rx.rate, 0xff);
+
+    /* PHR, 20 octets and FCS before the callback */
+    setup(&phy);
+    subg_ts_rx(&s_ts, 1000000, 20, &rx);
+    CHECK_EQ(rx.rate, 1);
+    CHECK_EQ(rx.done, 1000000);
+    CHECK_EQ(rx.done - rx.sfd, 24 * 160 * M);
+
+    /* and the callback latency */
+    phy.rx_delay_us = 250;
+    setup(&phy);
+    subg_ts_rx(&s_ts, 1000000, 20, &rx);
+    CHECK_EQ(rx.done - rx.sfd, (24 * 160 + 250) * M);
+}
+
+static void test_rate_table(void) {
+    const subg_ts_rate_t* r = setup(&s_fsk_50k);
+    const subg_ts_hist_t* total = &r->lat[SUBG_TS_LAT_TOTAL];
+    uint8_t i;
+
+    subg_ts_tx_enqueue(&s_ts, 0, 10);
+    subg_ts_tx_complete(&s_ts, 3000 * M, SUBG_TS_TX_SENT);
+    subg_ts_tx_enqueue(&s_ts, 0, 10);
+    subg_ts_tx_complete(&s_ts, 5000 * M, SUBG_TS_TX_SENT);
+    CHECK_EQ(subg_ts_hist_percentile(total, 50), 4095);
+    CHECK_EQ(subg_ts_hist_percentile(total, 90), 5000);
+
+    /* a rate beyond the table tracks nothing until one known is selected */
+    for (i = 2; i <= SUBG_TS_RATES; i++) {
+        CHECK_EQ(subg_ts_rate_set(&s_ts, i, &s_fsk_50k), 0);
+    }
+    CHECK_EQ(subg_ts_rate_set(&s_ts, 9, &s_fsk_50k), -1);
+    CHECK(s_ts.current == NULL);
+    subg_ts_tx_enqueue(&s_ts, 0, 10);
+    subg_ts_tx_complete(&s_ts, 100, SUBG_TS_TX_SENT);
+    CHECK_EQ(subg_ts_rate_set(&s_ts, 1, &s_fsk_50k), 0);
+    CHECK(s_ts.current == &s_ts.rates[0]);
+    CHECK_EQ(r->frames, 2);
+
+    subg_ts_reset(&s_ts);
+    CHECK_EQ(r->frames, 0);
+    CHECK(r->used);
+    CHECK_EQ(subg_ts_hist_percentile(total, 50), 0);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_marked_frame);
+    HOST_TEST_RUN(test_estimated_frames);
+    HOST_TEST_RUN(test_tx_sfd);
+    HOST_TEST_RUN(test_rx_sfd);
+    HOST_TEST_RUN(test_rate_table);
+    return HOST_TEST_END();
+}
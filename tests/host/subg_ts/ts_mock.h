@@ -0,0 +1,17 @@
+/**
+ * @file ts_mock.h
+ * @brief Frame timestamp source of app_ts.c, forced into it: a variable the
+ *        test sets instead of the DWT cycle counter.
+ */
+
+#ifndef __TS_MOCK_H
+#define __TS_MOCK_H
+
+#include <stdint.h>
+
+#define APP_TS_TIMESTAMP()  g_ts_now
+#define APP_TS_TIMESTAMP_HZ 48000000
+
+extern uint32_t g_ts_now;
+
+#endif // __TS_MOCK_H
@@ -0,0 +1,218 @@
+/**
+ * @file test_thermostat_ctrl.c
+ * @brief Closes the control loop of the Zigbee thermostat over the first
+ *        order room model of the example for 48 h, in PI and hysteresis
+ *        mode, and checks the band around the setpoint, the duty cycle, the
+ *        minimum on/off times and the calibrated temperature.
+ */
+
+#include <string.h>
+#include "host_test.h"
+#include "thermostat_ctrl.h"
+
+/* room model and loop settings of examples/zigbee/thermostat/src/zigbee_api.c */
+#define PERIOD_MS      10000
+#define OUTDOOR_TEMP   50000 /* 0.0001 degC */
+#define ROOM_TAU_S     7200
+#define HEAT_RATE      45    /* 0.0001 degC/s with the heater on */
+#define COOL_RATE      45
+#define START_TEMP     180000
+
+#define SIM_HOURS   48
+#define SETTLE_H    6
+#define STEPS_H     (3600000 / PERIOD_MS)
+
+#define SYSTEM_MODE_OFF  0x00
+#define SYSTEM_MODE_AUTO 0x01
+#define SYSTEM_MODE_HEAT 0x04
+
+static const thermostat_ctrl_cfg_t s_pi_cfg = {
+    .mode = THERMOSTAT_CTRL_MODE_PI,
+    .hysteresis = 50,
+    .kp = 40,
+    .ki = 20,
+    .cycle_ms = 600000,
+    .min_on_ms = 120000,
+    .min_off_ms = 120000,
+};
+
+typedef struct {
+    int16_t min_temp;
+    int16_t max_temp;
+    uint32_t heat_on_steps;
+    uint32_t steps;
+    uint32_t min_on_ms;
+    uint32_t min_off_ms;
+    uint32_t switches;
+    bool cooled;
+    bool published_calibrated;
+} sim_result_t;
+
+/* ZCL defaults of the thermostat cluster */
+static void input_defaults(thermostat_ctrl_input_t* in) {
+    memset(in, 0, sizeof(*in));
+    in->occupied = true;
+    in->system_mode = SYSTEM_MODE_AUTO;
+    in->control_seq = 0x04;
+    in->occupied_heat = 2000;
+    in->occupied_cool = 2600;
+    in->unoccupied_heat = 2000;
+    in->unoccupied_cool = 2600;
+    in->min_heat_limit = 700;
+    in->max_heat_limit = 3000;
+    in->min_cool_limit = 1600;
+    in->max_cool_limit = 3200;
+    in->min_dead_band = 25;
+}
+
+static void simulate(const thermostat_ctrl_cfg_t* cfg,
+                     const thermostat_ctrl_input_t* base, sim_result_t* res) {
+    thermostat_ctrl_t ctx;
+    thermostat_ctrl_input_t in = *base;
+    thermostat_ctrl_output_t out;
+    int32_t room = START_TEMP, rate;
+    uint32_t step, held_ms = 0;
+    bool on = false;
+
+    memset(res, 0, sizeof(*res));
+    res->min_temp = INT16_MAX;
+    res->max_temp = INT16_MIN;
+    res->min_on_ms = UINT32_MAX;
+    res->min_off_ms = UINT32_MAX;
+    res->published_calibrated = true;
+
+    thermostat_ctrl_init(&ctx, cfg);
+    for (step = 0; step < SIM_HOURS * STEPS_H; step++) {
+        in.local_temperature = (int16_t)(room / 100);
+        thermostat_ctrl_step(&ctx, &in, PERIOD_MS, &out);
+        if (out.temperature != in.local_temperature + in.calibration * 10) {
+            res->published_calibrated = false;
+        }
+
+        /* room model of the example */
+        rate = (OUTDOOR_TEMP - room) / ROOM_TAU_S;
+        if (out.heat_on) {
+            rate += HEAT_RATE;
+        }
+        if (out.cool_on) {
+            rate -= COOL_RATE;
+            res->cooled = true;
+        }
+        room += rate * (PERIOD_MS / 1000);
+
+        /* relay run lengths, the first one starts from init */
+        if (out.heat_on != on) {
+            if (step != 0) {
+                if (on && held_ms < res->min_on_ms) {
+                    res->min_on_ms = held_ms;
+                }
+                if (!on && held_ms < res->min_off_ms) {
+                    res->min_off_ms = held_ms;
+                }
+            }
+            on = out.heat_on;
+            held_ms = 0;
+            res->switches++;
+        }
+        held_ms += PERIOD_MS;
+
+        if (step >= SETTLE_H * STEPS_H) {
+            if (out.temperature < res->min_temp) {
+                res->min_temp = out.temperature;
+            }
+            if (out.temperature > res->max_temp) {
+                res->max_temp = out.temperature;
+            }
+            res->heat_on_steps += out.heat_on;
+            res->steps++;
+        }
+    }
+}
+
+/* heat loss at the setpoint over the heater power: the duty the loop needs */
+static uint32_t expected_duty_pct(int16_t setpoint) {
+    return (uint32_t)((setpoint * 100 - OUTDOOR_TEMP) * 100
+                      / ROOM_TAU_S / HEAT_RATE);
+}
+
+static void test_pi_48h(void) {
+    thermostat_ctrl_input_t in;
+    sim_result_t res;
+    uint32_t duty;
+
+    input_defaults(&in);
+    simulate(&s_pi_cfg, &in, &res);
+    duty = res.heat_on_steps * 100 / res.steps;
+    printf("  PI: %d..%d, duty %lu%% (model %lu%%), %lu switches\n",
+           res.min_temp, res.max_temp, (unsigned long)duty,
+           (unsigned long)expected_duty_pct(2000),
+           (unsigned long)res.switches);
+
+    CHECK(res.min_temp >= 2000 - 50);
+    CHECK(res.max_temp <= 2000 + 50);
+    CHECK(duty + 5 >= expected_duty_pct(2000));
+    CHECK(duty <= expected_duty_pct(2000) + 5);
+    CHECK(res.min_on_ms >= s_pi_cfg.min_on_ms);
+    CHECK(res.min_off_ms >= s_pi_cfg.min_off_ms);
+    CHECK(!res.cooled);
+}
+
+static void test_hysteresis_48h(void) {
+    thermostat_ctrl_cfg_t cfg = s_pi_cfg;
+    thermostat_ctrl_input_t in;
+    sim_result_t res;
+
+    cfg.mode = THERMOSTAT_CTRL_MODE_HYSTERESIS;
+    input_defaults(&in);
+    simulate(&cfg, &in, &res);
+    printf("  hysteresis: %d..%d, %lu switches\n", res.min_temp, res.max_temp,
+           (unsigned long)res.switches);
+
+    /* the band plus the overshoot of one minimum on/off time */
+    CHECK(res.min_temp >= 2000 - 25 - 10);
+    CHECK(res.max_temp <= 2000 + 25 + 60);
+    CHECK(res.min_on_ms >= cfg.min_on_ms);
+    CHECK(res.min_off_ms >= cfg.min_off_ms);
+    /* at most one on and one off per minimum on + off time */
+    CHECK(res.switches <= 2 * SIM_HOURS * 3600000UL
+                              / (cfg.min_on_ms + cfg.min_off_ms) + 1);
+}
+
+/* the sensor reads 1 degC low: the loop and LocalTemperature use the
+ * calibrated value, so the room settles 1 degC lower */
+static void test_calibration(void) {
+    thermostat_ctrl_input_t in;
+    sim_result_t res;
+
+    input_defaults(&in);
+    in.calibration = 10;
+    simulate(&s_pi_cfg, &in, &res);
+    CHECK(res.published_calibrated);
+    CHECK(res.min_temp >= 2000 - 50);
+    CHECK(res.max_temp <= 2000 + 50);
+}
+
+static void test_heat_only_off(void) {
+    thermostat_ctrl_input_t in;
+    sim_result_t res;
+
+    input_defaults(&in);
+    in.system_mode = SYSTEM_MODE_HEAT;
+    in.occupied_heat = 2800;
+    simulate(&s_pi_cfg, &in, &res);
+    CHECK(!res.cooled);
+    CHECK(res.min_temp >= 2800 - 60);
+
+    in.system_mode = SYSTEM_MODE_OFF;
+    simulate(&s_pi_cfg, &in, &res);
+    CHECK_EQ(res.heat_on_steps, 0);
+    CHECK(!res.cooled);
+}
+
+int main(void) {
+    HOST_TEST_RUN(test_pi_48h);
+    HOST_TEST_RUN(test_hysteresis_48h);
+    HOST_TEST_RUN(test_calibration);
+    HOST_TEST_RUN(test_heat_only_off);
+    return HOST_TEST_END();
+}
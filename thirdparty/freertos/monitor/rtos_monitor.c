@@ -0,0 +1,316 @@
+/**
+ * @file rtos_monitor.c
+ * @brief System monitor, see rtos_monitor.h
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+//=============================================================================
+//                Include
+//=============================================================================
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+#ifndef configUSE_RTOS_MONITOR
+#define configUSE_RTOS_MONITOR 0
+#endif
+
+#if (configUSE_RTOS_MONITOR == 1)
+
+#include "rtos_monitor.h"
+
+//=============================================================================
+//                Private Definitions of const value
+//=============================================================================
+#if (configGENERATE_RUN_TIME_STATS != 1) || (configUSE_TRACE_FACILITY != 1)
+#error "rtos_monitor needs configGENERATE_RUN_TIME_STATS and configUSE_TRACE_FACILITY"
+#endif
+
+#if (INCLUDE_xTaskGetIdleTaskHandle != 1)
+#error "rtos_monitor needs INCLUDE_xTaskGetIdleTaskHandle"
+#endif
+
+#define DEMCR        (*(volatile uint32_t*)0xE000EDFCUL)
+#define DEMCR_TRCENA (1UL << 24)
+#define DWT_CTRL     (*(volatile uint32_t*)0xE0001000UL)
+#define DWT_CYCCNTENA (1UL << 0)
+
+#define MONITOR_COUNTER_KHZ (RTOS_MONITOR_COUNTER_HZ / 1000)
+
+//=============================================================================
+//                Private Struct
+//=============================================================================
+typedef struct {
+    UBaseType_t number;
+    uint32_t run_time;
+} monitor_prev_t;
+
+//=============================================================================
+//                Private Global Variables
+//=============================================================================
+static TaskStatus_t g_mon_status[RTOS_MONITOR_TASK_MAX];
+static monitor_prev_t g_mon_prev[RTOS_MONITOR_TASK_MAX];
+static rtos_monitor_task_t g_mon_tasks[RTOS_MONITOR_TASK_MAX];
+static rtos_monitor_summary_t g_mon_summary;
+static uint32_t g_mon_prev_total;
+static uint8_t g_mon_prev_count;
+static uint8_t g_mon_baseline;        /* previous counters valid */
+static TimerHandle_t g_mon_timer;
+static rtos_monitor_cb_t g_mon_cb;
+
+//=============================================================================
+//                Private Function
+//=============================================================================
+static uint32_t monitor_period_clamp(uint32_t period_ms) {
+    /* deltas are taken mod 2^32, stay well inside one counter wrap */
+    uint32_t max_ms = (0xFFFFFFFFUL / 2) / MONITOR_COUNTER_KHZ;
+
+    if (period_ms < RTOS_MONITOR_PERIOD_MIN_MS) {
+        period_ms = RTOS_MONITOR_PERIOD_MIN_MS;
+    }
+    return period_ms > max_ms ? max_ms : period_ms;
+}
+
+static uint32_t monitor_cycles_to_us(uint32_t cycles) {
+    if (RTOS_MONITOR_COUNTER_HZ >= 1000000UL) {
+        return cycles / (RTOS_MONITOR_COUNTER_HZ / 1000000UL);
+    }
+    return cycles * (1000000UL / RTOS_MONITOR_COUNTER_HZ);
+}
+
+static uint32_t monitor_prev_run_time(UBaseType_t number, uint8_t hint) {
+    uint8_t i;
+
+    /* kernel list order rarely changes between samples, try the same slot */
+    if (hint < g_mon_prev_count && g_mon_prev[hint].number == number) {
+        return g_mon_prev[hint].run_time;
+    }
+    for (i = 0; i < g_mon_prev_count; i++) {
+        if (g_mon_prev[i].number == number) {
+            return g_mon_prev[i].run_time;
+        }
+    }
+    return 0; /* created during the period */
+}
+
+static inline void monitor_put16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void monitor_put32(uint8_t* p, uint32_t v) {
+    monitor_put16(p, (uint16_t)v);
+    monitor_put16(p + 2, (uint16_t)(v >> 16));
+}
+
+static void monitor_sample(TimerHandle_t timer) {
+    TaskStatus_t* status;
+    rtos_monitor_task_t* task;
+    TaskHandle_t idle = xTaskGetIdleTaskHandle();
+    uint32_t start = RTOS_MONITOR_COUNTER();
+    uint32_t total, total_delta, delta, cost, period_cycles;
+    uint16_t busy = 0;
+    UBaseType_t count, i;
+
+    (void)timer;
+
+    count = uxTaskGetSystemState(g_mon_status, RTOS_MONITOR_TASK_MAX, &total);
+    if (count == 0) {
+        /* more tasks than slots, counters are rebased on the next sample */
+        g_mon_summary.skipped++;
+        g_mon_baseline = 0;
+        return;
+    }
+
+    total_delta = total - g_mon_prev_total;
+
+    /* readers run at lower priority and copy a row in a critical section,
+     * rows are not torn */
+    for (i = 0; i < count; i++) {
+        status = &g_mon_status[i];
+        task = &g_mon_tasks[i];
+
+        delta = status->ulRunTimeCounter - monitor_prev_run_time(status->xTaskNumber, i);
+
+        strncpy(task->name, status->pcTaskName, RTOS_MONITOR_NAME_LEN - 1);
+        task->name[RTOS_MONITOR_NAME_LEN - 1] = '\0';
+        task->number = (uint8_t)status->xTaskNumber;
+        task->priority = (uint8_t)status->uxCurrentPriority;
+        task->cpu_permille = 0;
+        if (g_mon_baseline && total_delta >= 1000) {
+            delta /= total_delta / 1000;
+            task->cpu_permille = delta > 1000 ? 1000 : (uint16_t)delta;
+        }
+        task->stack_free = (uint16_t)status->usStackHighWaterMark;
+#if (configRECORD_STACK_HIGH_ADDRESS == 1)
+        task->stack_size = (uint16_t)(status->pxEndOfStack - status->pxStackBase + 1);
+#else
+        task->stack_size = 0;
+#endif
+        if (g_mon_baseline && status->xHandle == idle) {
+            busy = 1000 - task->cpu_permille;
+        }
+
+        g_mon_prev[i].number = status->xTaskNumber;
+        g_mon_prev[i].run_time = status->ulRunTimeCounter;
+    }
+    g_mon_prev_count = (uint8_t)count;
+    g_mon_prev_total = total;
+
+    cost = RTOS_MONITOR_COUNTER() - start;
+    period_cycles = g_mon_summary.period_ms * MONITOR_COUNTER_KHZ;
+
+    taskENTER_CRITICAL();
+    g_mon_summary.samples += g_mon_baseline;
+    g_mon_summary.task_count = (uint8_t)count;
+    g_mon_summary.busy_permille = busy;
+    g_mon_summary.heap_free = xPortGetFreeHeapSize();
+    g_mon_summary.heap_min = xPortGetMinimumEverFreeHeapSize();
+    g_mon_summary.sample_cycles = cost;
+    if (cost > g_mon_summary.sample_cycles_max) {
+        g_mon_summary.sample_cycles_max = cost;
+    }
+    g_mon_summary.overhead_permille = (uint16_t)(cost / (period_cycles / 1000 + 1));
+    taskEXIT_CRITICAL();
+
+    if (!g_mon_baseline) {
+        g_mon_baseline = 1;
+        return;
+    }
+
+    /* keep the cost bounded, slow down rather than eat the CPU */
+    if (g_mon_summary.overhead_permille > RTOS_MONITOR_OVERHEAD_MAX) {
+        rtos_monitor_period_set(g_mon_summary.period_ms * 2);
+    }
+
+    if (g_mon_cb) {
+        g_mon_cb();
+    }
+}
+
+//=============================================================================
+//                Public Function
+//=============================================================================
+void rtos_monitor_counter_start(void) {
+    if ((DWT_CTRL & DWT_CYCCNTENA) == 0) {
+        DEMCR |= DEMCR_TRCENA;
+        DWT_CTRL |= DWT_CYCCNTENA;
+    }
+}
+
+int rtos_monitor_init(uint32_t period_ms, rtos_monitor_cb_t cb) {
+    if (g_mon_timer) {
+        return -1;
+    }
+
+    g_mon_cb = cb;
+    g_mon_summary.period_ms = monitor_period_clamp(period_ms);
+
+    g_mon_timer = xTimerCreate("sysmon", pdMS_TO_TICKS(g_mon_summary.period_ms),
+                               pdTRUE, NULL, monitor_sample);
+    if (!g_mon_timer) {
+        return -1;
+    }
+    xTimerStart(g_mon_timer, 0);
+    return 0;
+}
+
+void rtos_monitor_period_set(uint32_t period_ms) {
+    period_ms = monitor_period_clamp(period_ms);
+
+    taskENTER_CRITICAL();
+    g_mon_summary.period_ms = period_ms;
+    taskEXIT_CRITICAL();
+
+    if (g_mon_timer) {
+        xTimerChangePeriod(g_mon_timer, pdMS_TO_TICKS(period_ms), 0);
+    }
+}
+
+void rtos_monitor_summary(rtos_monitor_summary_t* summary) {
+    taskENTER_CRITICAL();
+    *summary = g_mon_summary;
+    taskEXIT_CRITICAL();
+}
+
+int rtos_monitor_task(uint8_t idx, rtos_monitor_task_t* task) {
+    int rval = -1;
+
+    taskENTER_CRITICAL();
+    if (idx < g_mon_summary.task_count) {
+        *task = g_mon_tasks[idx];
+        rval = 0;
+    }
+    taskEXIT_CRITICAL();
+    return rval;
+}
+
+uint16_t rtos_monitor_record(uint8_t* buf, uint16_t size) {
+    const rtos_monitor_task_t* task;
+    uint8_t* p;
+    uint8_t count, i;
+
+    if (size < RTOS_MONITOR_RECORD_HDR_LEN) {
+        return 0;
+    }
+
+    taskENTER_CRITICAL();
+    count = g_mon_summary.task_count;
+    if (RTOS_MONITOR_RECORD_LEN(count) > size) {
+        count = (size - RTOS_MONITOR_RECORD_HDR_LEN) / RTOS_MONITOR_RECORD_TASK_LEN;
+    }
+
+    buf[0] = RTOS_MONITOR_RECORD_VERSION;
+    buf[1] = count;
+    monitor_put16(&buf[2], (uint16_t)g_mon_summary.period_ms);
+    monitor_put32(&buf[4], g_mon_summary.heap_free);
+    monitor_put32(&buf[8], g_mon_summary.heap_min);
+    monitor_put16(&buf[12], g_mon_summary.busy_permille);
+    monitor_put16(&buf[14], (uint16_t)monitor_cycles_to_us(g_mon_summary.sample_cycles));
+
+    p = &buf[RTOS_MONITOR_RECORD_HDR_LEN];
+    for (i = 0; i < count; i++, p += RTOS_MONITOR_RECORD_TASK_LEN) {
+        task = &g_mon_tasks[i];
+        p[0] = task->number;
+        p[1] = task->priority;
+        monitor_put16(&p[2], task->cpu_permille);
+        monitor_put16(&p[4], task->stack_free);
+        monitor_put16(&p[6], task->stack_size);
+    }
+    taskEXIT_CRITICAL();
+
+    return RTOS_MONITOR_RECORD_LEN(count);
+}
+
+void rtos_monitor_print(void) {
+    rtos_monitor_summary_t summary;
+    rtos_monitor_task_t task;
+    uint8_t i;
+
+    rtos_monitor_summary(&summary);
+
+    printf("period %lu ms, busy %u.%u%%, heap free %lu min %lu\n",
+           (unsigned long)summary.period_ms, summary.busy_permille / 10,
+           summary.busy_permille % 10, (unsigned long)summary.heap_free,
+           (unsigned long)summary.heap_min);
+    printf("sample %lu us, max %lu us, overhead %u.%u%%, skipped %u\n",
+           (unsigned long)monitor_cycles_to_us(summary.sample_cycles),
+           (unsigned long)monitor_cycles_to_us(summary.sample_cycles_max),
+           summary.overhead_permille / 10, summary.overhead_permille % 10,
+           summary.skipped);
+
+    printf("%-16s %3s %4s %6s %12s\n", "task", "num", "prio", "cpu %", "stack free");
+    for (i = 0; rtos_monitor_task(i, &task) == 0; i++) {
+        printf("%-16s %3u %4u %4u.%u %6u/%-5u\n", task.name, task.number,
+               task.priority, task.cpu_permille / 10, task.cpu_permille % 10,
+               task.stack_free, task.stack_size);
+    }
+}
+
+#endif /* configUSE_RTOS_MONITOR */
@@ -0,0 +1,166 @@
+/**
+ * @file rtos_monitor.h
+ * @brief System monitor, per-task CPU load, stack high-water mark and
+ *        heap usage sampled at a fixed period.
+ *
+ * The kernel run-time stats are clocked by the DWT cycle counter, a free
+ * running 32-bit counter read in a single load at each context switch.
+ * A software timer samples uxTaskGetSystemState() every period and turns
+ * the run-time deltas into per-mille CPU shares; the stack figures are the
+ * kernel's high-water marks and the heap figures those of heap_5.
+ *
+ * The cost of every sample is measured with the same counter. When it
+ * exceeds RTOS_MONITOR_OVERHEAD_MAX per-mille of the period the period is
+ * doubled, so the monitor stays within that bound in production builds.
+ *
+ * Enable it with configUSE_RTOS_MONITOR 1, configGENERATE_RUN_TIME_STATS 1
+ * and configUSE_TRACE_FACILITY 1, and include this file at the end of
+ * FreeRTOSConfig.h; the run-time counter macros are then defined unless
+ * the application already defines them.
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+
+#ifndef __RTOS_MONITOR_H
+#define __RTOS_MONITOR_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Tasks sampled, a sample is skipped when more tasks exist */
+#ifndef RTOS_MONITOR_TASK_MAX
+#define RTOS_MONITOR_TASK_MAX 24
+#endif
+
+#define RTOS_MONITOR_NAME_LEN 16
+
+#ifndef RTOS_MONITOR_PERIOD_MS
+#define RTOS_MONITOR_PERIOD_MS 5000
+#endif
+
+#define RTOS_MONITOR_PERIOD_MIN_MS 100
+
+/* Sample cost limit, per-mille of the period */
+#ifndef RTOS_MONITOR_OVERHEAD_MAX
+#define RTOS_MONITOR_OVERHEAD_MAX 5
+#endif
+
+/* Run-time counter, the DWT cycle counter by default. The counter stops
+ * in sleep so the shares are of the time awake, override with a free
+ * running timer on sleepy devices and set RTOS_MONITOR_COUNTER_HZ to its
+ * rate. The period is kept below half the counter wrap time. */
+#ifndef RTOS_MONITOR_COUNTER
+#define RTOS_MONITOR_COUNTER() (*(volatile uint32_t*)0xE0001004UL)
+#endif
+
+#ifndef RTOS_MONITOR_COUNTER_HZ
+#define RTOS_MONITOR_COUNTER_HZ configCPU_CLOCK_HZ
+#endif
+
+/* Binary record, little endian:
+ *   0  version            u8
+ *   1  task count         u8
+ *   2  period ms          u16
+ *   4  heap free          u32
+ *   8  heap minimum ever  u32
+ *  12  busy per-mille     u16   1000 - idle task share
+ *  14  sample cost us     u16
+ *  then per task:
+ *   0  task number        u8
+ *   1  priority           u8
+ *   2  cpu per-mille      u16
+ *   4  stack free words   u16   high-water mark
+ *   6  stack size words   u16   0 when unknown
+ */
+#define RTOS_MONITOR_RECORD_VERSION 1
+#define RTOS_MONITOR_RECORD_HDR_LEN 16
+#define RTOS_MONITOR_RECORD_TASK_LEN 8
+#define RTOS_MONITOR_RECORD_LEN(tasks)                                         \
+    (RTOS_MONITOR_RECORD_HDR_LEN + (tasks) * RTOS_MONITOR_RECORD_TASK_LEN)
+
+typedef struct {
+    char name[RTOS_MONITOR_NAME_LEN];
+    uint8_t number;
+    uint8_t priority;
+    uint16_t cpu_permille;
+    uint16_t stack_free;   /* words */
+    uint16_t stack_size;   /* words, 0 when unknown */
+} rtos_monitor_task_t;
+
+typedef struct {
+    uint32_t samples;
+    uint32_t period_ms;
+    uint32_t heap_free;
+    uint32_t heap_min;
+    uint32_t sample_cycles;      /* cost of the last sample */
+    uint32_t sample_cycles_max;
+    uint16_t busy_permille;
+    uint16_t overhead_permille;  /* last sample cost over its period */
+    uint8_t task_count;
+    uint8_t skipped;             /* samples skipped, more tasks than RTOS_MONITOR_TASK_MAX */
+} rtos_monitor_summary_t;
+
+/**
+ * @brief Called in the timer task after every sample
+ */
+typedef void (*rtos_monitor_cb_t)(void);
+
+/**
+ * @brief Start sampling
+ * @param period_ms sample period, clamped to the counter range
+ * @param cb called after each sample, may be NULL
+ * @return 0 on success, -1 when the timer cannot be created
+ */
+int rtos_monitor_init(uint32_t period_ms, rtos_monitor_cb_t cb);
+
+void rtos_monitor_period_set(uint32_t period_ms);
+
+/**
+ * @brief Copy the figures of the last sample
+ */
+void rtos_monitor_summary(rtos_monitor_summary_t* summary);
+
+/**
+ * @brief Copy task idx of the last sample, in kernel list order
+ * @return 0 on success, -1 when idx is past the task count
+ */
+int rtos_monitor_task(uint8_t idx, rtos_monitor_task_t* task);
+
+/**
+ * @brief Encode the last sample as a binary record, tasks that do not fit
+ *        in size are left out
+ * @return record length, 0 when size is below the header
+ */
+uint16_t rtos_monitor_record(uint8_t* buf, uint16_t size);
+
+/**
+ * @brief Print the last sample with printf
+ */
+void rtos_monitor_print(void);
+
+void rtos_monitor_counter_start(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#if (configUSE_RTOS_MONITOR == 1)
+
+/* The macros expand inside tasks.c */
+#ifndef portCONFIGURE_TIMER_FOR_RUN_TIME_STATS
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() rtos_monitor_counter_start()
+#endif
+
+#ifndef portGET_RUN_TIME_COUNTER_VALUE
+#define portGET_RUN_TIME_COUNTER_VALUE() RTOS_MONITOR_COUNTER()
+#endif
+
+#endif /* configUSE_RTOS_MONITOR */
+
+#endif // __RTOS_MONITOR_H
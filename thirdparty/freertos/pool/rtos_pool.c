@@ -0,0 +1,300 @@
+/**
+ * @file rtos_pool.c
+ * @brief Fixed block memory pools, see rtos_pool.h
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+//=============================================================================
+//                Include
+//=============================================================================
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "rtos_pool.h"
+
+//=============================================================================
+//                Private Definitions of const value
+//=============================================================================
+#define POOL_MAGIC_FREE  0xF4EEB10CUL
+#define POOL_MAGIC_USED  0xA110CA7EUL
+#define POOL_GUARD       0x6A4D6A4DUL
+
+/* Usable from tasks and interrupts alike, the previous mask is restored
+ * so a call inside a critical section leaves it intact */
+#ifndef RTOS_POOL_LOCK
+#define RTOS_POOL_LOCK()         portSET_INTERRUPT_MASK_FROM_ISR()
+#define RTOS_POOL_UNLOCK(mask)   portCLEAR_INTERRUPT_MASK_FROM_ISR(mask)
+#endif
+
+#define POOL_LOCK()         RTOS_POOL_LOCK()
+#define POOL_UNLOCK(mask)   RTOS_POOL_UNLOCK(mask)
+
+//=============================================================================
+//                Private Struct
+//=============================================================================
+typedef struct {
+    uint32_t magic;
+    uint32_t owner;     /* low address bits of the pool */
+} pool_hdr_t;
+
+//=============================================================================
+//                Private Function
+//=============================================================================
+#if (RTOS_POOL_DEBUG == 1)
+static inline uint32_t pool_owner_tag(const rtos_pool_t* pool) {
+    return (uint32_t)(uintptr_t)pool;
+}
+
+static inline uint8_t* pool_guard(const rtos_pool_t* pool, uint8_t* payload) {
+    /* past the free list link in blocks smaller than a pointer */
+    return payload + RTOS_POOL_PAYLOAD(pool->block_size);
+}
+
+static void pool_guard_set(const rtos_pool_t* pool, uint8_t* payload) {
+    uint32_t guard = POOL_GUARD;
+
+    memcpy(pool_guard(pool, payload), &guard, sizeof(guard));
+}
+
+static int pool_guard_ok(const rtos_pool_t* pool, uint8_t* payload) {
+    uint32_t guard;
+
+    memcpy(&guard, pool_guard(pool, payload), sizeof(guard));
+    return guard == POOL_GUARD;
+}
+#endif
+
+static rtos_pool_t* pool_init(rtos_pool_t* pool, const char* name,
+                              uint16_t block_size, uint16_t count,
+                              uint8_t* storage) {
+    uint8_t* block;
+    void** link;
+    uint16_t i;
+
+    memset(pool, 0, sizeof(*pool));
+    pool->name = name;
+    pool->block_size = block_size;
+    pool->stride = (uint16_t)RTOS_POOL_STRIDE(block_size);
+    pool->count = count;
+    pool->base = storage;
+    pool->end = storage + (size_t)pool->stride * count;
+
+    /* thread the blocks in address order, the first allocation is the
+     * lowest block */
+    link = &pool->free_list;
+    for (i = 0, block = storage; i < count; i++, block += pool->stride) {
+#if (RTOS_POOL_DEBUG == 1)
+        pool_hdr_t* hdr = (pool_hdr_t*)block;
+
+        hdr->magic = POOL_MAGIC_FREE;
+        hdr->owner = pool_owner_tag(pool);
+        pool_guard_set(pool, block + RTOS_POOL_HDR_SIZE);
+#endif
+        *link = block + RTOS_POOL_HDR_SIZE;
+        link = (void**)*link;
+    }
+    *link = NULL;
+
+    return pool;
+}
+
+static int pool_args_ok(uint16_t block_size, uint16_t count) {
+    return block_size != 0 && count != 0
+           && RTOS_POOL_STRIDE((uint32_t)block_size) <= 0xFFFFU;
+}
+
+//=============================================================================
+//                Public Function
+//=============================================================================
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+rtos_pool_t* rtos_pool_create_static(const char* name, uint16_t block_size,
+                                     uint16_t count, void* storage,
+                                     rtos_pool_t* pool) {
+    if (!pool || !storage || !pool_args_ok(block_size, count)) {
+        return NULL;
+    }
+    configASSERT(((uintptr_t)storage & (RTOS_POOL_ALIGN - 1)) == 0);
+
+    return pool_init(pool, name, block_size, count, (uint8_t*)storage);
+}
+#endif
+
+#if (configSUPPORT_DYNAMIC_ALLOCATION == 1)
+rtos_pool_t* rtos_pool_create(const char* name, uint16_t block_size,
+                              uint16_t count) {
+    size_t ctrl = (sizeof(rtos_pool_t) + RTOS_POOL_ALIGN - 1)
+                  & ~(size_t)(RTOS_POOL_ALIGN - 1);
+    rtos_pool_t* pool;
+
+    if (!pool_args_ok(block_size, count)) {
+        return NULL;
+    }
+
+    pool = pvPortMalloc(ctrl + RTOS_POOL_STORAGE_SIZE((size_t)block_size, count));
+    if (!pool) {
+        return NULL;
+    }
+    pool_init(pool, name, block_size, count, (uint8_t*)pool + ctrl);
+    pool->dynamic = 1;
+
+    return pool;
+}
+
+void rtos_pool_delete(rtos_pool_t* pool) {
+    if (!pool) {
+        return;
+    }
+    configASSERT(pool->dynamic && pool->used == 0);
+    vPortFree(pool);
+}
+#endif
+
+void* rtos_pool_alloc(rtos_pool_t* pool) {
+    UBaseType_t mask;
+    void* block;
+
+    mask = POOL_LOCK();
+    block = pool->free_list;
+    if (block) {
+        pool->free_list = *(void**)block;
+        if (++pool->used > pool->peak) {
+            pool->peak = pool->used;
+        }
+    } else {
+        pool->failures++;
+    }
+    POOL_UNLOCK(mask);
+
+#if (RTOS_POOL_DEBUG == 1)
+    if (block) {
+        pool_hdr_t* hdr = (pool_hdr_t*)((uint8_t*)block - RTOS_POOL_HDR_SIZE);
+
+        /* a write after free clobbers the header or the guard */
+        configASSERT(hdr->magic == POOL_MAGIC_FREE);
+        configASSERT(pool_guard_ok(pool, block));
+        hdr->magic = POOL_MAGIC_USED;
+    }
+#endif
+
+    return block;
+}
+
+void rtos_pool_free(rtos_pool_t* pool, void* block) {
+    UBaseType_t mask;
+
+    if (!block) {
+        return;
+    }
+
+    configASSERT(rtos_pool_owns(pool, block));
+    configASSERT(((uint8_t*)block - RTOS_POOL_HDR_SIZE - pool->base)
+                 % pool->stride == 0);
+
+#if (RTOS_POOL_DEBUG == 1)
+    {
+        pool_hdr_t* hdr = (pool_hdr_t*)((uint8_t*)block - RTOS_POOL_HDR_SIZE);
+        UBaseType_t was_used;
+
+        configASSERT(hdr->owner == pool_owner_tag(pool));
+        configASSERT(pool_guard_ok(pool, block));
+
+        /* test and set under the lock, two racing frees of one block are
+         * caught as well */
+        mask = POOL_LOCK();
+        was_used = hdr->magic == POOL_MAGIC_USED;
+        hdr->magic = POOL_MAGIC_FREE;
+        POOL_UNLOCK(mask);
+        configASSERT(was_used);
+        if (!was_used) {
+            return;
+        }
+    }
+#endif
+
+    mask = POOL_LOCK();
+    *(void**)block = pool->free_list;
+    pool->free_list = block;
+    pool->used--;
+    POOL_UNLOCK(mask);
+}
+
+int rtos_pool_owns(const rtos_pool_t* pool, const void* block) {
+    const uint8_t* p = (const uint8_t*)block;
+
+    return p >= pool->base + RTOS_POOL_HDR_SIZE && p < pool->end;
+}
+
+void rtos_pool_stats(const rtos_pool_t* pool, rtos_pool_stats_t* stats) {
+    UBaseType_t mask;
+
+    mask = POOL_LOCK();
+    stats->name = pool->name;
+    stats->failures = pool->failures;
+    stats->block_size = pool->block_size;
+    stats->count = pool->count;
+    stats->used = pool->used;
+    stats->peak = pool->peak;
+    POOL_UNLOCK(mask);
+}
+
+void rtos_pool_stats_reset(rtos_pool_t* pool) {
+    UBaseType_t mask;
+
+    mask = POOL_LOCK();
+    pool->peak = pool->used;
+    pool->failures = 0;
+    POOL_UNLOCK(mask);
+}
+
+void* rtos_pool_set_alloc(const rtos_pool_set_t* set, size_t size) {
+    rtos_pool_t* fit = NULL;
+    rtos_pool_t* pool;
+    void* block;
+    uint8_t i;
+
+    for (i = 0; i < set->count; i++) {
+        pool = set->pools[i];
+        if (pool->block_size < size) {
+            continue;
+        }
+        if (!fit) {
+            fit = pool;
+        }
+        /* unlocked peek, an empty class is skipped without a failure */
+        if (!pool->free_list) {
+            continue;
+        }
+        block = rtos_pool_alloc(pool);
+        if (block) {
+            return block;
+        }
+    }
+
+    if (fit) {
+        UBaseType_t mask = POOL_LOCK();
+        fit->failures++;
+        POOL_UNLOCK(mask);
+    }
+    return NULL;
+}
+
+void rtos_pool_set_free(const rtos_pool_set_t* set, void* block) {
+    uint8_t i;
+
+    if (!block) {
+        return;
+    }
+
+    for (i = 0; i < set->count; i++) {
+        if (rtos_pool_owns(set->pools[i], block)) {
+            rtos_pool_free(set->pools[i], block);
+            return;
+        }
+    }
+    configASSERT(0);
+}
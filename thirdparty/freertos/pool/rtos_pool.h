@@ -0,0 +1,169 @@
+/**
+ * @file rtos_pool.h
+ * @brief Fixed block memory pools, allocate and free in constant time from
+ *        tasks and interrupts.
+ *
+ * A pool is one array of equal blocks threaded on a free list. Allocate
+ * and free pop and push the list head with interrupts masked up to
+ * configMAX_SYSCALL_INTERRUPT_PRIORITY, a handful of instructions, so a
+ * pool can be shared by a driver interrupt and the task draining it. The
+ * blocks never fragment and a pool never touches the heap after creation.
+ *
+ * Pools of increasing block size form a size-class set, a request is
+ * served by the smallest class that has a free block.
+ *
+ * A port whose interrupt mask from ISR does not mask the tick in task
+ * context, as the POSIX simulator, defines RTOS_POOL_LOCK() and
+ * RTOS_POOL_UNLOCK(mask) in FreeRTOSConfig.h.
+ *
+ * With RTOS_POOL_DEBUG 1 every block carries a header word, checked for
+ * double frees and frees to the wrong pool, and a trailing guard word
+ * checked for overruns; failures hit configASSERT.
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+
+#ifndef __RTOS_POOL_H
+#define __RTOS_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef RTOS_POOL_DEBUG
+#define RTOS_POOL_DEBUG 0
+#endif
+
+/* Blocks are 8 byte aligned when the storage is */
+#define RTOS_POOL_ALIGN 8
+
+#if (RTOS_POOL_DEBUG == 1)
+#define RTOS_POOL_HDR_SIZE   8  /* magic, owner pool */
+#define RTOS_POOL_GUARD_SIZE 4
+#else
+#define RTOS_POOL_HDR_SIZE   0
+#define RTOS_POOL_GUARD_SIZE 0
+#endif
+
+/* A free block holds the free list link */
+#define RTOS_POOL_PAYLOAD(size)                                                \
+    ((size) < sizeof(void*) ? sizeof(void*) : (size))
+
+/* Distance between two blocks for a payload of size bytes */
+#define RTOS_POOL_STRIDE(size)                                                 \
+    ((RTOS_POOL_PAYLOAD(size) + RTOS_POOL_HDR_SIZE + RTOS_POOL_GUARD_SIZE      \
+      + RTOS_POOL_ALIGN - 1) & ~(RTOS_POOL_ALIGN - 1))
+
+/* Storage for count blocks of size bytes, for rtos_pool_create_static() */
+#define RTOS_POOL_STORAGE_SIZE(size, count) (RTOS_POOL_STRIDE(size) * (count))
+
+typedef struct rtos_pool {
+    void* free_list;
+    uint8_t* base;
+    uint8_t* end;
+    const char* name;
+    uint32_t failures;     /* allocations that found the pool empty */
+    uint16_t block_size;   /* payload bytes */
+    uint16_t stride;
+    uint16_t count;
+    uint16_t used;
+    uint16_t peak;
+    uint8_t dynamic;
+} rtos_pool_t;
+
+typedef struct {
+    const char* name;
+    uint32_t failures;
+    uint16_t block_size;
+    uint16_t count;
+    uint16_t used;
+    uint16_t peak;
+} rtos_pool_stats_t;
+
+/* Size classes, pools sorted by increasing block size */
+typedef struct {
+    rtos_pool_t* const* pools;
+    uint8_t count;
+} rtos_pool_set_t;
+
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+/**
+ * @brief Build a pool on caller storage
+ * @param name shown in the statistics, kept by reference
+ * @param block_size payload bytes of a block
+ * @param count blocks
+ * @param storage RTOS_POOL_STORAGE_SIZE(block_size, count) bytes, 8 byte
+ *        aligned
+ * @param pool control block
+ * @return pool, NULL when the arguments are invalid
+ */
+rtos_pool_t* rtos_pool_create_static(const char* name, uint16_t block_size,
+                                     uint16_t count, void* storage,
+                                     rtos_pool_t* pool);
+#endif
+
+#if (configSUPPORT_DYNAMIC_ALLOCATION == 1)
+/**
+ * @brief Build a pool with one heap allocation for the control block and
+ *        the blocks
+ * @return pool, NULL when out of heap
+ */
+rtos_pool_t* rtos_pool_create(const char* name, uint16_t block_size,
+                              uint16_t count);
+
+/**
+ * @brief Release a pool from rtos_pool_create(), all blocks must be free
+ */
+void rtos_pool_delete(rtos_pool_t* pool);
+#endif
+
+/**
+ * @brief Take a block, callable from tasks and from interrupts at or below
+ *        configMAX_SYSCALL_INTERRUPT_PRIORITY
+ * @return block, NULL when the pool is empty
+ */
+void* rtos_pool_alloc(rtos_pool_t* pool);
+
+/**
+ * @brief Return a block to the pool it came from, same contexts as
+ *        rtos_pool_alloc()
+ */
+void rtos_pool_free(rtos_pool_t* pool, void* block);
+
+/**
+ * @brief Whether block lies in the pool storage
+ */
+int rtos_pool_owns(const rtos_pool_t* pool, const void* block);
+
+void rtos_pool_stats(const rtos_pool_t* pool, rtos_pool_stats_t* stats);
+
+/**
+ * @brief Clear the peak and failure counts
+ */
+void rtos_pool_stats_reset(rtos_pool_t* pool);
+
+/**
+ * @brief Take a block of at least size bytes from the smallest class with
+ *        a free block; the failure is counted on the class that fits
+ * @return block, NULL when every class that fits is empty
+ */
+void* rtos_pool_set_alloc(const rtos_pool_set_t* set, size_t size);
+
+/**
+ * @brief Return a block from rtos_pool_set_alloc()
+ */
+void rtos_pool_set_free(const rtos_pool_set_t* set, void* block);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __RTOS_POOL_H
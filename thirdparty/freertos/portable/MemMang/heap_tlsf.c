@@ -0,0 +1,706 @@
+/*
+ * FreeRTOS Kernel V11.2.0
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * A two-level segregated fit (TLSF) implementation of pvPortMalloc(), a drop
+ * in replacement for heap_5.c with the same vPortDefineHeapRegions() usage.
+ *
+ * Free blocks are kept in segregated lists indexed by two levels: the first
+ * level is the power of two of the block size, the second level splits each
+ * power of two into heapTLSF_SL_COUNT linear classes.  A bitmap per level
+ * records which lists are non-empty, so pvPortMalloc() finds a fitting list
+ * with two count-leading/trailing-zeros instructions and vPortFree() merges
+ * with the physical neighbours through the previous-block pointer kept in
+ * each block header.  Both run in constant time whatever the heap state,
+ * heap_5.c walks its free list.
+ *
+ * The search rounds a request up to the start of the next size class so any
+ * block of the list it picks fits, at the cost of at most 1 / heapTLSF_SL_COUNT
+ * of internal waste.  Blocks carry the same 8 byte header as heap_5.c.
+ *
+ * vPortDefineHeapRegions() ***must*** be called before pvPortMalloc(), with the
+ * regions in increasing address order and terminated by a NULL zero sized
+ * region, exactly as for heap_5.c.  A region must be smaller than
+ * 2 ^ heapTLSF_FL_INDEX_MAX bytes.
+ *
+ * configENABLE_HEAP_PROTECTOR is not supported.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+ * all the API functions to use the MPU wrappers.  That should only be done when
+ * task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "heap_tlsf.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if ( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+    #error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
+#endif
+
+#if ( configENABLE_HEAP_PROTECTOR == 1 )
+    #error heap_tlsf.c does not support configENABLE_HEAP_PROTECTOR
+#endif
+
+#ifndef configHEAP_CLEAR_MEMORY_ON_FREE
+    #define configHEAP_CLEAR_MEMORY_ON_FREE    0
+#endif
+
+/* log2 of the second level classes per power of two, 3 bounds the internal
+ * waste to 12.5% and keeps the list table small. */
+#ifndef heapTLSF_SL_INDEX_COUNT_LOG2
+    #define heapTLSF_SL_INDEX_COUNT_LOG2    3
+#endif
+
+/* Blocks are smaller than 2 ^ heapTLSF_FL_INDEX_MAX bytes. */
+#ifndef heapTLSF_FL_INDEX_MAX
+    #define heapTLSF_FL_INDEX_MAX    20
+#endif
+
+#define heapTLSF_ALIGN_LOG2          3
+#define heapTLSF_ALIGN               ( ( size_t ) 1 << heapTLSF_ALIGN_LOG2 )
+#define heapTLSF_SL_COUNT            ( 1 << heapTLSF_SL_INDEX_COUNT_LOG2 )
+
+/* Sizes below heapTLSF_SMALL_BLOCK_SIZE share first level 0, split linearly
+ * in heapTLSF_ALIGN steps. */
+#define heapTLSF_FL_INDEX_SHIFT      ( heapTLSF_SL_INDEX_COUNT_LOG2 + heapTLSF_ALIGN_LOG2 )
+#define heapTLSF_FL_COUNT            ( heapTLSF_FL_INDEX_MAX - heapTLSF_FL_INDEX_SHIFT + 1 )
+#define heapTLSF_SMALL_BLOCK_SIZE    ( ( size_t ) 1 << heapTLSF_FL_INDEX_SHIFT )
+
+#if ( portBYTE_ALIGNMENT > 8 )
+    #error heap_tlsf.c supports portBYTE_ALIGNMENT up to 8
+#endif
+
+#if ( heapTLSF_FL_COUNT > 32 )
+    #error heapTLSF_FL_INDEX_MAX is too large for the first level bitmap
+#endif
+
+/* The two low bits of xSize are flags, sizes are multiples of 8. */
+#define heapBLOCK_FREE               ( ( size_t ) 1 )
+#define heapBLOCK_PREV_FREE          ( ( size_t ) 2 )
+#define heapBLOCK_FLAGS              ( heapBLOCK_FREE | heapBLOCK_PREV_FREE )
+
+#define heapBLOCK_SIZE( pxBlock )    ( ( pxBlock )->xSize & ~heapBLOCK_FLAGS )
+#define heapBLOCK_NEXT( pxBlock )    ( ( BlockHeader_t * ) ( ( ( uint8_t * ) ( pxBlock ) ) + heapBLOCK_SIZE( pxBlock ) ) )
+
+/* Max value that fits in a size_t type. */
+#define heapSIZE_MAX                 ( ~( ( size_t ) 0 ) )
+
+/* Check if adding a and b will result in overflow. */
+#define heapADD_WILL_OVERFLOW( a, b )        ( ( a ) > ( heapSIZE_MAX - ( b ) ) )
+
+/* Check if multiplying a and b will result in overflow. */
+#define heapMULTIPLY_WILL_OVERFLOW( a, b )   ( ( ( a ) > 0 ) && ( ( b ) > ( heapSIZE_MAX / ( a ) ) ) )
+
+/*-----------------------------------------------------------*/
+
+/* Block header.  pxPrevPhys and xSize are always valid; the free list links
+ * live in the payload and are only valid while the block is free. */
+typedef struct A_BLOCK_HEADER
+{
+    struct A_BLOCK_HEADER * pxPrevPhys; /**< The block physically before this one, NULL for the first block of a region. */
+    size_t xSize;                       /**< The size of the block, header included, and the flags. */
+    struct A_BLOCK_HEADER * pxNextFree; /**< The next block in the same free list. */
+    struct A_BLOCK_HEADER * pxPrevFree; /**< The previous block in the same free list. */
+} BlockHeader_t;
+
+/*-----------------------------------------------------------*/
+
+void vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions ) PRIVILEGED_FUNCTION;
+
+/*-----------------------------------------------------------*/
+
+/* Bytes in front of the payload of an allocated block. */
+#define heapHEADER_SIZE              ( ( size_t ) offsetof( BlockHeader_t, pxNextFree ) )
+
+/* A free block must hold its list links. */
+#define heapMINIMUM_BLOCK_SIZE       ( ( size_t ) sizeof( BlockHeader_t ) )
+
+PRIVILEGED_DATA static BlockHeader_t * pxFreeLists[ heapTLSF_FL_COUNT ][ heapTLSF_SL_COUNT ];
+PRIVILEGED_DATA static uint32_t ulFlBitmap = 0U;
+PRIVILEGED_DATA static uint32_t ulSlBitmap[ heapTLSF_FL_COUNT ];
+PRIVILEGED_DATA static BaseType_t xHeapDefined = pdFALSE;
+
+/* Keeps track of the number of calls to allocate and free memory as well as the
+ * number of free bytes remaining. */
+PRIVILEGED_DATA static size_t xFreeBytesRemaining = ( size_t ) 0U;
+PRIVILEGED_DATA static size_t xMinimumEverFreeBytesRemaining = ( size_t ) 0U;
+PRIVILEGED_DATA static size_t xNumberOfSuccessfulAllocations = ( size_t ) 0U;
+PRIVILEGED_DATA static size_t xNumberOfSuccessfulFrees = ( size_t ) 0U;
+PRIVILEGED_DATA static size_t xNumberOfFreeBlocks = ( size_t ) 0U;
+PRIVILEGED_DATA static size_t xNumberOfFailedAllocations = ( size_t ) 0U;
+PRIVILEGED_DATA static size_t xAllocationHistogram[ heapTLSF_HISTOGRAM_BUCKETS ];
+
+/*-----------------------------------------------------------*/
+
+static inline uint32_t prvFls( size_t x )
+{
+    /* Index of the most significant set bit, x is not 0. */
+    return ( uint32_t ) ( 31 - __builtin_clz( ( unsigned int ) x ) );
+}
+
+static inline uint32_t prvFfs( uint32_t x )
+{
+    /* Index of the least significant set bit, x is not 0. */
+    return ( uint32_t ) __builtin_ctz( x );
+}
+/*-----------------------------------------------------------*/
+
+static inline void prvMappingInsert( size_t xSize,
+                                     uint32_t * pulFl,
+                                     uint32_t * pulSl )
+{
+    uint32_t ulFls;
+
+    if( xSize < heapTLSF_SMALL_BLOCK_SIZE )
+    {
+        *pulFl = 0;
+        *pulSl = ( uint32_t ) ( xSize >> heapTLSF_ALIGN_LOG2 );
+    }
+    else
+    {
+        ulFls = prvFls( xSize );
+        *pulSl = ( uint32_t ) ( xSize >> ( ulFls - heapTLSF_SL_INDEX_COUNT_LOG2 ) ) ^ heapTLSF_SL_COUNT;
+        *pulFl = ulFls - ( heapTLSF_FL_INDEX_SHIFT - 1 );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static inline size_t prvClassStart( uint32_t ulFl,
+                                    uint32_t ulSl )
+{
+    uint32_t ulFls;
+
+    if( ulFl == 0 )
+    {
+        return ( size_t ) ulSl << heapTLSF_ALIGN_LOG2;
+    }
+
+    ulFls = ulFl + ( heapTLSF_FL_INDEX_SHIFT - 1 );
+    return ( ( size_t ) 1 << ulFls ) + ( ( size_t ) ulSl << ( ulFls - heapTLSF_SL_INDEX_COUNT_LOG2 ) );
+}
+/*-----------------------------------------------------------*/
+
+static BlockHeader_t * prvFindSuitableBlock( size_t xSize,
+                                             uint32_t * pulFl,
+                                             uint32_t * pulSl )
+{
+    uint32_t ulFl, ulSl, ulSlMap, ulFlMap;
+
+    /* Round up to the next class so the head of the list found fits. */
+    if( xSize >= heapTLSF_SMALL_BLOCK_SIZE )
+    {
+        xSize += ( ( size_t ) 1 << ( prvFls( xSize ) - heapTLSF_SL_INDEX_COUNT_LOG2 ) ) - 1;
+    }
+
+    prvMappingInsert( xSize, &ulFl, &ulSl );
+
+    if( ulFl >= heapTLSF_FL_COUNT )
+    {
+        return NULL;
+    }
+
+    ulSlMap = ulSlBitmap[ ulFl ] & ( ~( uint32_t ) 0U << ulSl );
+
+    if( ulSlMap == 0U )
+    {
+        ulFlMap = ( ulFl + 1 < 32 ) ? ( ulFlBitmap & ( ~( uint32_t ) 0U << ( ulFl + 1 ) ) ) : 0U;
+
+        if( ulFlMap == 0U )
+        {
+            return NULL;
+        }
+
+        ulFl = prvFfs( ulFlMap );
+        ulSlMap = ulSlBitmap[ ulFl ];
+    }
+
+    ulSl = prvFfs( ulSlMap );
+
+    *pulFl = ulFl;
+    *pulSl = ulSl;
+
+    return pxFreeLists[ ulFl ][ ulSl ];
+}
+/*-----------------------------------------------------------*/
+
+static void prvRemoveFreeBlock( BlockHeader_t * pxBlock,
+                                uint32_t ulFl,
+                                uint32_t ulSl )
+{
+    BlockHeader_t * pxPrev = pxBlock->pxPrevFree;
+    BlockHeader_t * pxNext = pxBlock->pxNextFree;
+
+    if( pxNext != NULL )
+    {
+        pxNext->pxPrevFree = pxPrev;
+    }
+
+    if( pxPrev != NULL )
+    {
+        pxPrev->pxNextFree = pxNext;
+    }
+    else
+    {
+        pxFreeLists[ ulFl ][ ulSl ] = pxNext;
+
+        if( pxNext == NULL )
+        {
+            ulSlBitmap[ ulFl ] &= ~( ( uint32_t ) 1U << ulSl );
+
+            if( ulSlBitmap[ ulFl ] == 0U )
+            {
+                ulFlBitmap &= ~( ( uint32_t ) 1U << ulFl );
+            }
+        }
+    }
+
+    xNumberOfFreeBlocks--;
+}
+/*-----------------------------------------------------------*/
+
+static void prvUnlinkFreeBlock( BlockHeader_t * pxBlock )
+{
+    uint32_t ulFl, ulSl;
+
+    prvMappingInsert( heapBLOCK_SIZE( pxBlock ), &ulFl, &ulSl );
+    prvRemoveFreeBlock( pxBlock, ulFl, ulSl );
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertFreeBlock( BlockHeader_t * pxBlock )
+{
+    BlockHeader_t * pxNext = heapBLOCK_NEXT( pxBlock );
+    uint32_t ulFl, ulSl;
+
+    /* Tell the physical neighbour, it merges backwards on its own free. */
+    pxBlock->xSize |= heapBLOCK_FREE;
+    pxNext->pxPrevPhys = pxBlock;
+    pxNext->xSize |= heapBLOCK_PREV_FREE;
+
+    prvMappingInsert( heapBLOCK_SIZE( pxBlock ), &ulFl, &ulSl );
+
+    pxBlock->pxPrevFree = NULL;
+    pxBlock->pxNextFree = pxFreeLists[ ulFl ][ ulSl ];
+
+    if( pxBlock->pxNextFree != NULL )
+    {
+        pxBlock->pxNextFree->pxPrevFree = pxBlock;
+    }
+
+    pxFreeLists[ ulFl ][ ulSl ] = pxBlock;
+    ulSlBitmap[ ulFl ] |= ( uint32_t ) 1U << ulSl;
+    ulFlBitmap |= ( uint32_t ) 1U << ulFl;
+
+    xNumberOfFreeBlocks++;
+}
+/*-----------------------------------------------------------*/
+
+static inline uint32_t prvHistogramBucket( size_t xWantedSize )
+{
+    uint32_t ulBucket = 0;
+
+    if( xWantedSize > 16 )
+    {
+        ulBucket = prvFls( xWantedSize - 1 ) - 3;
+    }
+
+    return ( ulBucket < heapTLSF_HISTOGRAM_BUCKETS ) ? ulBucket : heapTLSF_HISTOGRAM_BUCKETS - 1;
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortMalloc( size_t xWantedSize )
+{
+    BlockHeader_t * pxBlock;
+    BlockHeader_t * pxRemainder;
+    void * pvReturn = NULL;
+    size_t xBlockSize = 0;
+    size_t xAllocatedBlockSize = 0;
+    uint32_t ulFl, ulSl;
+
+    /* The heap must be initialised before the first call to
+     * pvPortMalloc(). */
+    configASSERT( xHeapDefined );
+
+    if( ( xWantedSize > 0 ) &&
+        ( heapADD_WILL_OVERFLOW( xWantedSize, heapHEADER_SIZE + heapTLSF_ALIGN ) == 0 ) )
+    {
+        /* Room for the header, rounded up to the alignment. */
+        xBlockSize = ( xWantedSize + heapHEADER_SIZE + ( heapTLSF_ALIGN - 1 ) ) & ~( heapTLSF_ALIGN - 1 );
+
+        if( xBlockSize < heapMINIMUM_BLOCK_SIZE )
+        {
+            xBlockSize = heapMINIMUM_BLOCK_SIZE;
+        }
+    }
+
+    vTaskSuspendAll();
+    {
+        if( ( xBlockSize > 0 ) && ( xBlockSize <= xFreeBytesRemaining ) )
+        {
+            pxBlock = prvFindSuitableBlock( xBlockSize, &ulFl, &ulSl );
+
+            if( pxBlock != NULL )
+            {
+                prvRemoveFreeBlock( pxBlock, ulFl, ulSl );
+
+                /* Split off the tail when it can make a free block. */
+                if( ( heapBLOCK_SIZE( pxBlock ) - xBlockSize ) >= heapMINIMUM_BLOCK_SIZE )
+                {
+                    pxRemainder = ( BlockHeader_t * ) ( ( ( uint8_t * ) pxBlock ) + xBlockSize );
+                    pxRemainder->pxPrevPhys = pxBlock;
+                    pxRemainder->xSize = heapBLOCK_SIZE( pxBlock ) - xBlockSize;
+                    pxBlock->xSize = xBlockSize | ( pxBlock->xSize & heapBLOCK_PREV_FREE );
+                    prvInsertFreeBlock( pxRemainder );
+                }
+                else
+                {
+                    heapBLOCK_NEXT( pxBlock )->xSize &= ~heapBLOCK_PREV_FREE;
+                }
+
+                pxBlock->xSize &= ~heapBLOCK_FREE;
+                xAllocatedBlockSize = heapBLOCK_SIZE( pxBlock );
+
+                xFreeBytesRemaining -= xAllocatedBlockSize;
+
+                if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+                {
+                    xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+                }
+
+                xNumberOfSuccessfulAllocations++;
+                pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + heapHEADER_SIZE );
+            }
+        }
+
+        if( xWantedSize > 0 )
+        {
+            xAllocationHistogram[ prvHistogramBucket( xWantedSize ) ]++;
+
+            if( pvReturn == NULL )
+            {
+                xNumberOfFailedAllocations++;
+            }
+        }
+
+        traceMALLOC( pvReturn, xAllocatedBlockSize );
+
+        /* Prevent compiler warnings when trace macros are not used. */
+        ( void ) xAllocatedBlockSize;
+    }
+    ( void ) xTaskResumeAll();
+
+    #if ( configUSE_MALLOC_FAILED_HOOK == 1 )
+    {
+        if( pvReturn == NULL )
+        {
+            vApplicationMallocFailedHook();
+        }
+    }
+    #endif /* if ( configUSE_MALLOC_FAILED_HOOK == 1 ) */
+
+    configASSERT( ( ( ( size_t ) pvReturn ) & ( size_t ) portBYTE_ALIGNMENT_MASK ) == 0 );
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void * pv )
+{
+    BlockHeader_t * pxBlock;
+    BlockHeader_t * pxNeighbour;
+    size_t xBlockSize;
+
+    if( pv != NULL )
+    {
+        pxBlock = ( BlockHeader_t * ) ( ( ( uint8_t * ) pv ) - heapHEADER_SIZE );
+
+        configASSERT( ( pxBlock->xSize & heapBLOCK_FREE ) == 0 );
+
+        if( ( pxBlock->xSize & heapBLOCK_FREE ) == 0 )
+        {
+            xBlockSize = heapBLOCK_SIZE( pxBlock );
+
+            #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 1 )
+            {
+                ( void ) memset( pv, 0, xBlockSize - heapHEADER_SIZE );
+            }
+            #endif
+
+            vTaskSuspendAll();
+            {
+                xFreeBytesRemaining += xBlockSize;
+                traceFREE( pv, xBlockSize );
+
+                /* Merge with the free block physically before. */
+                if( ( pxBlock->xSize & heapBLOCK_PREV_FREE ) != 0 )
+                {
+                    pxNeighbour = pxBlock->pxPrevPhys;
+                    prvUnlinkFreeBlock( pxNeighbour );
+                    pxNeighbour->xSize += heapBLOCK_SIZE( pxBlock );
+                    pxBlock = pxNeighbour;
+                }
+
+                /* Merge with the free block physically after, the region end
+                 * marker is never free. */
+                pxNeighbour = heapBLOCK_NEXT( pxBlock );
+
+                if( ( pxNeighbour->xSize & heapBLOCK_FREE ) != 0 )
+                {
+                    prvUnlinkFreeBlock( pxNeighbour );
+                    pxBlock->xSize += heapBLOCK_SIZE( pxNeighbour );
+                }
+
+                prvInsertFreeBlock( pxBlock );
+                xNumberOfSuccessfulFrees++;
+            }
+            ( void ) xTaskResumeAll();
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+    return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+    return xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+void xPortResetHeapMinimumEverFreeHeapSize( void )
+{
+    xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortCalloc( size_t xNum,
+                     size_t xSize )
+{
+    void * pv = NULL;
+
+    if( heapMULTIPLY_WILL_OVERFLOW( xNum, xSize ) == 0 )
+    {
+        pv = pvPortMalloc( xNum * xSize );
+
+        if( pv != NULL )
+        {
+            ( void ) memset( pv, 0, xNum * xSize );
+        }
+    }
+
+    return pv;
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+    /* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+void vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions ) /* PRIVILEGED_FUNCTION */
+{
+    BlockHeader_t * pxFirstBlock;
+    BlockHeader_t * pxEndMarker;
+    portPOINTER_SIZE_TYPE xAddress, xEndAddress;
+    size_t xTotalHeapSize = 0;
+    BaseType_t xDefinedRegions = 0;
+    const HeapRegion_t * pxHeapRegion;
+
+    /* Can only call once! */
+    configASSERT( xHeapDefined == pdFALSE );
+
+    pxHeapRegion = &( pxHeapRegions[ xDefinedRegions ] );
+
+    while( pxHeapRegion->xSizeInBytes > 0 )
+    {
+        /* Align both ends of the region. */
+        xAddress = ( portPOINTER_SIZE_TYPE ) pxHeapRegion->pucStartAddress;
+        xEndAddress = xAddress + ( portPOINTER_SIZE_TYPE ) pxHeapRegion->xSizeInBytes;
+        xAddress = ( xAddress + ( heapTLSF_ALIGN - 1 ) ) & ~( ( portPOINTER_SIZE_TYPE ) heapTLSF_ALIGN - 1 );
+        xEndAddress &= ~( ( portPOINTER_SIZE_TYPE ) heapTLSF_ALIGN - 1 );
+
+        /* The end marker takes a header at the top of the region; it is a
+         * permanently allocated zero sized block that stops the merging. */
+        xEndAddress -= ( portPOINTER_SIZE_TYPE ) heapHEADER_SIZE;
+
+        configASSERT( ( xEndAddress > xAddress ) && ( ( size_t ) ( xEndAddress - xAddress ) >= heapMINIMUM_BLOCK_SIZE ) );
+        configASSERT( ( size_t ) ( xEndAddress - xAddress ) < ( ( size_t ) 1 << heapTLSF_FL_INDEX_MAX ) );
+
+        pxFirstBlock = ( BlockHeader_t * ) xAddress;
+        pxFirstBlock->pxPrevPhys = NULL;
+        pxFirstBlock->xSize = ( size_t ) ( xEndAddress - xAddress );
+
+        pxEndMarker = ( BlockHeader_t * ) xEndAddress;
+        pxEndMarker->pxPrevPhys = pxFirstBlock;
+        pxEndMarker->xSize = 0;
+
+        prvInsertFreeBlock( pxFirstBlock );
+        xTotalHeapSize += heapBLOCK_SIZE( pxFirstBlock );
+
+        /* Move onto the next HeapRegion_t structure. */
+        xDefinedRegions++;
+        pxHeapRegion = &( pxHeapRegions[ xDefinedRegions ] );
+    }
+
+    xMinimumEverFreeBytesRemaining = xTotalHeapSize;
+    xFreeBytesRemaining = xTotalHeapSize;
+    xHeapDefined = pdTRUE;
+
+    /* Check something was actually defined before it is accessed. */
+    configASSERT( xTotalHeapSize );
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapStats( HeapStats_t * pxHeapStats )
+{
+    BlockHeader_t * pxBlock;
+    size_t xMaxSize = 0, xMinSize = portMAX_DELAY; /* portMAX_DELAY used as a portable way of getting the maximum value. */
+    uint32_t ulFl, ulSl;
+
+    vTaskSuspendAll();
+    {
+        /* The largest block is in the highest non-empty list and the
+         * smallest in the lowest one, only those two lists are walked. */
+        if( ulFlBitmap != 0U )
+        {
+            ulFl = prvFls( ulFlBitmap );
+            ulSl = prvFls( ulSlBitmap[ ulFl ] );
+
+            for( pxBlock = pxFreeLists[ ulFl ][ ulSl ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFree )
+            {
+                if( heapBLOCK_SIZE( pxBlock ) > xMaxSize )
+                {
+                    xMaxSize = heapBLOCK_SIZE( pxBlock );
+                }
+            }
+
+            ulFl = prvFfs( ulFlBitmap );
+            ulSl = prvFfs( ulSlBitmap[ ulFl ] );
+
+            for( pxBlock = pxFreeLists[ ulFl ][ ulSl ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFree )
+            {
+                if( heapBLOCK_SIZE( pxBlock ) < xMinSize )
+                {
+                    xMinSize = heapBLOCK_SIZE( pxBlock );
+                }
+            }
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    pxHeapStats->xSizeOfLargestFreeBlockInBytes = xMaxSize;
+    pxHeapStats->xSizeOfSmallestFreeBlockInBytes = xMinSize;
+
+    taskENTER_CRITICAL();
+    {
+        pxHeapStats->xNumberOfFreeBlocks = xNumberOfFreeBlocks;
+        pxHeapStats->xAvailableHeapSpaceInBytes = xFreeBytesRemaining;
+        pxHeapStats->xNumberOfSuccessfulAllocations = xNumberOfSuccessfulAllocations;
+        pxHeapStats->xNumberOfSuccessfulFrees = xNumberOfSuccessfulFrees;
+        pxHeapStats->xMinimumEverFreeBytesRemaining = xMinimumEverFreeBytesRemaining;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetTlsfHeapStats( TlsfHeapStats_t * pxStats )
+{
+    uint32_t ulFl;
+    size_t xLargest = 0;
+
+    taskENTER_CRITICAL();
+    {
+        if( ulFlBitmap != 0U )
+        {
+            /* Every block of the highest non-empty class is at least the
+             * class start, and a request up to it rounds to that class or
+             * below. */
+            ulFl = prvFls( ulFlBitmap );
+            xLargest = prvClassStart( ulFl, prvFls( ulSlBitmap[ ulFl ] ) );
+        }
+
+        pxStats->xFreeBytes = xFreeBytesRemaining;
+        pxStats->xLargestAllocatableBlock = xLargest;
+        pxStats->xFreeBlocks = xNumberOfFreeBlocks;
+        pxStats->xFailedAllocations = xNumberOfFailedAllocations;
+        ( void ) memcpy( pxStats->xAllocationHistogram, xAllocationHistogram, sizeof( xAllocationHistogram ) );
+    }
+    taskEXIT_CRITICAL();
+
+    pxStats->usFragmentationPermille = 0;
+
+    if( pxStats->xFreeBytes > 0 )
+    {
+        /* Blocks are below 2 ^ heapTLSF_FL_INDEX_MAX, no overflow. */
+        pxStats->usFragmentationPermille = ( uint16_t ) ( 1000U - ( xLargest * 1000U ) / pxStats->xFreeBytes );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vPortResetTlsfHeapHistogram( void )
+{
+    taskENTER_CRITICAL();
+    {
+        ( void ) memset( xAllocationHistogram, 0, sizeof( xAllocationHistogram ) );
+        xNumberOfFailedAllocations = 0;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Reset the state in this file. This state is normally initialized at start up.
+ * This function must be called by the application before restarting the
+ * scheduler.
+ */
+void vPortHeapResetState( void )
+{
+    ( void ) memset( pxFreeLists, 0, sizeof( pxFreeLists ) );
+    ( void ) memset( ulSlBitmap, 0, sizeof( ulSlBitmap ) );
+    ulFlBitmap = 0U;
+    xHeapDefined = pdFALSE;
+
+    xFreeBytesRemaining = ( size_t ) 0U;
+    xMinimumEverFreeBytesRemaining = ( size_t ) 0U;
+    xNumberOfSuccessfulAllocations = ( size_t ) 0U;
+    xNumberOfSuccessfulFrees = ( size_t ) 0U;
+    xNumberOfFreeBlocks = ( size_t ) 0U;
+    xNumberOfFailedAllocations = ( size_t ) 0U;
+    ( void ) memset( xAllocationHistogram, 0, sizeof( xAllocationHistogram ) );
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,37 @@
+/*
+ * Two-level segregated fit heap, see heap_tlsf.c.
+ *
+ * Extra statistics on top of vPortGetHeapStats(): fragmentation of the free
+ * space and a histogram of the requested allocation sizes.
+ */
+
+#ifndef HEAP_TLSF_H
+#define HEAP_TLSF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Histogram buckets of requested sizes: <= 16, 17..32, ..., > 1024 bytes */
+#define heapTLSF_HISTOGRAM_BUCKETS    8
+
+typedef struct xTLSF_HEAP_STATS
+{
+    size_t xFreeBytes;                 /* Free bytes, block headers included. */
+    size_t xLargestAllocatableBlock;   /* Largest block pvPortMalloc() is sure to find, header included. */
+    size_t xFreeBlocks;                /* Number of free blocks. */
+    size_t xFailedAllocations;         /* pvPortMalloc() calls that returned NULL. */
+    uint16_t usFragmentationPermille;  /* 1000 - 1000 * largest allocatable block / free bytes. */
+    size_t xAllocationHistogram[ heapTLSF_HISTOGRAM_BUCKETS ];
+} TlsfHeapStats_t;
+
+/*
+ * Fill pxStats in constant time, the free lists are not walked.
+ */
+void vPortGetTlsfHeapStats( TlsfHeapStats_t * pxStats );
+
+/*
+ * Clear the allocation histogram and the failed allocation count.
+ */
+void vPortResetTlsfHeapHistogram( void );
+
+#endif /* HEAP_TLSF_H */
@@ -0,0 +1,204 @@
+/**
+ * @file rtos_trace.c
+ * @brief Binary trace recorder, see rtos_trace.h
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+//=============================================================================
+//                Include
+//=============================================================================
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef configUSE_RTOS_TRACE
+#define configUSE_RTOS_TRACE 0
+#endif
+
+#if (configUSE_RTOS_TRACE == 1)
+
+#include "rtos_trace.h"
+
+//=============================================================================
+//                Private Definitions of const value
+//=============================================================================
+#if (RTOS_TRACE_RECORDS & (RTOS_TRACE_RECORDS - 1)) != 0
+#error "RTOS_TRACE_RECORDS must be a power of two"
+#endif
+
+#define RTOS_TRACE_DUMP_VERSION 1
+
+#define DEMCR        (*(volatile uint32_t*)0xE000EDFCUL)
+#define DEMCR_TRCENA (1UL << 24)
+#define DWT_CTRL     (*(volatile uint32_t*)0xE0001000UL)
+#define DWT_CYCCNTENA (1UL << 0)
+
+/* PRIMASK rather than BASEPRI, interrupts above the syscall priority
+ * may record too */
+#ifndef RTOS_TRACE_LOCK
+#define RTOS_TRACE_LOCK(m)                                                     \
+    __asm volatile("mrs %0, primask\n cpsid i" : "=r"(m)::"memory")
+#define RTOS_TRACE_UNLOCK(m) __asm volatile("msr primask, %0" ::"r"(m) : "memory")
+#endif
+
+#ifndef RTOS_TRACE_COUNTER_START
+#define RTOS_TRACE_COUNTER_START()                                             \
+    do {                                                                       \
+        if ((DWT_CTRL & DWT_CYCCNTENA) == 0) {                                 \
+            DEMCR |= DEMCR_TRCENA;                                             \
+            DWT_CTRL |= DWT_CYCCNTENA;                                         \
+        }                                                                      \
+    } while (0)
+#endif
+
+//=============================================================================
+//                Private Struct
+//=============================================================================
+typedef struct {
+    uint16_t object;
+    uint8_t priority;
+    char name[RTOS_TRACE_NAME_LEN];
+} rtos_trace_task_t;
+
+//=============================================================================
+//                Private Global Variables
+//=============================================================================
+static rtos_trace_record_t g_trace_records[RTOS_TRACE_RECORDS];
+static rtos_trace_task_t g_trace_tasks[RTOS_TRACE_TASK_MAX];
+static uint32_t g_trace_head;        /* records written since the last clear */
+static uint32_t g_trace_sync_tick;
+static uint8_t g_trace_task_count;
+static volatile uint8_t g_trace_enabled = 1;
+
+//=============================================================================
+//                Private Function
+//=============================================================================
+static inline void trace_write(uint8_t event, uint16_t object, uint8_t arg) {
+    rtos_trace_record_t* rec;
+    uint32_t mask;
+
+    RTOS_TRACE_LOCK(mask);
+    rec = &g_trace_records[g_trace_head++ & (RTOS_TRACE_RECORDS - 1)];
+    rec->timestamp = RTOS_TRACE_TIMESTAMP();
+    rec->object = object;
+    rec->event = event;
+    rec->arg = arg;
+    RTOS_TRACE_UNLOCK(mask);
+}
+
+//=============================================================================
+//                Public Function
+//=============================================================================
+void rtos_trace_event(uint8_t event, const void* object, uint8_t arg) {
+    if (g_trace_enabled) {
+        trace_write(event, RTOS_TRACE_OBJECT_ID(object), arg);
+    }
+}
+
+void rtos_trace_task_create(const void* task, const char* name, uint8_t priority) {
+    rtos_trace_task_t* entry = NULL;
+    uint16_t object = RTOS_TRACE_OBJECT_ID(task);
+    uint8_t i;
+
+    /* first task is created before the scheduler, counter on from here */
+    RTOS_TRACE_COUNTER_START();
+
+    /* a new TCB at the address of a deleted one takes its entry */
+    for (i = 0; i < g_trace_task_count; i++) {
+        if (g_trace_tasks[i].object == object) {
+            entry = &g_trace_tasks[i];
+            break;
+        }
+    }
+    if (!entry && g_trace_task_count < RTOS_TRACE_TASK_MAX) {
+        entry = &g_trace_tasks[g_trace_task_count++];
+    }
+    if (entry) {
+        entry->object = object;
+        entry->priority = priority;
+        strncpy(entry->name, name, RTOS_TRACE_NAME_LEN - 1);
+        entry->name[RTOS_TRACE_NAME_LEN - 1] = '\0';
+    }
+
+    if (g_trace_enabled) {
+        trace_write(RTOS_TRACE_EVT_TASK_CREATE, object, priority);
+    }
+}
+
+void rtos_trace_task_switched_in(const void* task, uint8_t priority, uint32_t tick) {
+    if (!g_trace_enabled) {
+        return;
+    }
+    if ((uint32_t)(tick - g_trace_sync_tick) >= RTOS_TRACE_SYNC_TICKS) {
+        g_trace_sync_tick = tick;
+        trace_write(RTOS_TRACE_EVT_SYNC, (uint16_t)tick, (uint8_t)(tick >> 16));
+    }
+    trace_write(RTOS_TRACE_EVT_TASK_SWITCHED_IN, RTOS_TRACE_OBJECT_ID(task), priority);
+}
+
+void rtos_trace_isr_enter(uint8_t irq) {
+    if (g_trace_enabled) {
+        trace_write(RTOS_TRACE_EVT_ISR_ENTER, 0, irq);
+    }
+}
+
+void rtos_trace_isr_exit(uint8_t irq) {
+    if (g_trace_enabled) {
+        trace_write(RTOS_TRACE_EVT_ISR_EXIT, 0, irq);
+    }
+}
+
+void rtos_trace_user(uint8_t id, uint16_t value) {
+    if (g_trace_enabled) {
+        trace_write(RTOS_TRACE_EVT_USER, value, id);
+    }
+}
+
+void rtos_trace_enable(uint8_t enable) {
+    g_trace_enabled = enable ? 1 : 0;
+}
+
+void rtos_trace_clear(void) {
+    uint32_t mask;
+
+    RTOS_TRACE_LOCK(mask);
+    g_trace_head = 0;
+    g_trace_sync_tick = 0;
+    RTOS_TRACE_UNLOCK(mask);
+}
+
+void rtos_trace_dump(void) {
+    const rtos_trace_record_t* rec;
+    uint32_t head, count, i;
+    uint8_t enabled = g_trace_enabled;
+
+    g_trace_enabled = 0;
+
+    head = g_trace_head;
+    count = head < RTOS_TRACE_RECORDS ? head : RTOS_TRACE_RECORDS;
+
+    /* header: version, timestamp rate, tick rate, written, dumped */
+    printf("#RTOS_TRACE %d %lu %lu %lu %lu\n", RTOS_TRACE_DUMP_VERSION,
+           (unsigned long)RTOS_TRACE_TIMESTAMP_HZ, (unsigned long)configTICK_RATE_HZ,
+           (unsigned long)head, (unsigned long)count);
+    for (i = 0; i < g_trace_task_count; i++) {
+        printf("#T %04x %u %s\n", g_trace_tasks[i].object, g_trace_tasks[i].priority,
+               g_trace_tasks[i].name);
+    }
+
+    for (i = 0; i < count; i++) {
+        rec = &g_trace_records[(head - count + i) & (RTOS_TRACE_RECORDS - 1)];
+        printf("%08lx%04x%02x%02x%c", (unsigned long)rec->timestamp, rec->object,
+               rec->event, rec->arg, ((i & 7) == 7 || i + 1 == count) ? '\n' : ' ');
+    }
+    printf("#END\n");
+
+    g_trace_enabled = enabled;
+}
+
+#endif /* configUSE_RTOS_TRACE */
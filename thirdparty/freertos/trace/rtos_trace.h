@@ -0,0 +1,277 @@
+/**
+ * @file rtos_trace.h
+ * @brief Binary trace recorder for FreeRTOS scheduling, queue and
+ *        interrupt events.
+ *
+ * Each event is an 8 byte record, cycle timestamp, object id, event and
+ * one byte argument, written to a RAM ring that keeps the newest
+ * RTOS_TRACE_RECORDS events. A record costs a few tens of cycles with
+ * interrupts masked, so the recorder can stay enabled in the field.
+ *
+ * Enable it with configUSE_RTOS_TRACE 1 and include this file at the end
+ * of FreeRTOSConfig.h, the kernel hooks below are then defined unless the
+ * application already defines them; a hook the application needs for
+ * itself calls the matching rtos_trace_ function from its own definition.
+ *
+ * rtos_trace_dump() prints the ring as text, decode the capture with
+ * tools/rtos_trace/rtos_trace_decode.py.
+ *
+ * @version 0.1
+ *
+ * @date
+ *
+ */
+
+#ifndef __RTOS_TRACE_H
+#define __RTOS_TRACE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Records kept, a power of two */
+#ifndef RTOS_TRACE_RECORDS
+#define RTOS_TRACE_RECORDS 512
+#endif
+
+/* Tasks whose name is kept for the dump */
+#ifndef RTOS_TRACE_TASK_MAX
+#define RTOS_TRACE_TASK_MAX 24
+#endif
+
+#define RTOS_TRACE_NAME_LEN 16
+
+/* Ticks between two sync records, they map cycles to the tick count */
+#ifndef RTOS_TRACE_SYNC_TICKS
+#define RTOS_TRACE_SYNC_TICKS 1000
+#endif
+
+/* Record timestamp, the DWT cycle counter by default. The counter stops
+ * in sleep, override with a free running timer on sleepy devices and set
+ * RTOS_TRACE_TIMESTAMP_HZ to its rate; RTOS_TRACE_COUNTER_START() then
+ * starts that timer, or is left empty. */
+#ifndef RTOS_TRACE_TIMESTAMP
+#define RTOS_TRACE_TIMESTAMP() (*(volatile uint32_t*)0xE0001004UL)
+#endif
+
+#ifndef RTOS_TRACE_TIMESTAMP_HZ
+#define RTOS_TRACE_TIMESTAMP_HZ configCPU_CLOCK_HZ
+#endif
+
+/* Record the kernel tick interrupt, two records a tick: set to 0 for a
+ * longer window in the ring */
+#ifndef RTOS_TRACE_TICK_ISR
+#define RTOS_TRACE_TICK_ISR 1
+#endif
+
+/* Interrupt number of the tick in the ISR records, SysTick_IRQn is -1 */
+#define RTOS_TRACE_IRQ_TICK 0xFF
+
+/* Objects are word aligned RAM addresses, kept as address bits 2..17 */
+#define RTOS_TRACE_OBJECT_ID(p) ((uint16_t)((uintptr_t)(p) >> 2))
+
+typedef enum {
+    RTOS_TRACE_EVT_SYNC = 0,           /* object: tick bits 0..15, arg: tick bits 16..23 */
+    RTOS_TRACE_EVT_TASK_CREATE,        /* arg: priority */
+    RTOS_TRACE_EVT_TASK_DELETE,
+    RTOS_TRACE_EVT_TASK_SWITCHED_IN,   /* arg: priority */
+    RTOS_TRACE_EVT_TASK_READY,         /* arg: priority */
+    RTOS_TRACE_EVT_TASK_DELAY,
+    RTOS_TRACE_EVT_TASK_NOTIFY,        /* arg: notification index */
+    RTOS_TRACE_EVT_TASK_NOTIFY_FROM_ISR,
+    RTOS_TRACE_EVT_QUEUE_SEND,         /* arg: messages waiting before the call */
+    RTOS_TRACE_EVT_QUEUE_SEND_FAILED,
+    RTOS_TRACE_EVT_QUEUE_SEND_FROM_ISR,
+    RTOS_TRACE_EVT_QUEUE_SEND_FROM_ISR_FAILED,
+    RTOS_TRACE_EVT_QUEUE_RECEIVE,
+    RTOS_TRACE_EVT_QUEUE_RECEIVE_FAILED,
+    RTOS_TRACE_EVT_QUEUE_RECEIVE_FROM_ISR,
+    RTOS_TRACE_EVT_QUEUE_BLOCK_SEND,
+    RTOS_TRACE_EVT_QUEUE_BLOCK_RECEIVE,
+    RTOS_TRACE_EVT_ISR_ENTER,          /* arg: interrupt number */
+    RTOS_TRACE_EVT_ISR_EXIT,           /* arg: interrupt number */
+    RTOS_TRACE_EVT_USER,               /* object: value, arg: user id */
+    RTOS_TRACE_EVT_MAX,
+} rtos_trace_event_t;
+
+typedef struct {
+    uint32_t timestamp;
+    uint16_t object;
+    uint8_t event;
+    uint8_t arg;
+} rtos_trace_record_t;
+
+/**
+ * @brief Write one record, callable from any context
+ */
+void rtos_trace_event(uint8_t event, const void* object, uint8_t arg);
+
+/**
+ * @brief Kernel hooks
+ */
+void rtos_trace_task_create(const void* task, const char* name, uint8_t priority);
+void rtos_trace_task_switched_in(const void* task, uint8_t priority, uint32_t tick);
+
+/**
+ * @brief Interrupt entry and exit, called by the drivers whose latency is
+ *        of interest, through the macros below so the calls go away with
+ *        the recorder
+ */
+void rtos_trace_isr_enter(uint8_t irq);
+void rtos_trace_isr_exit(uint8_t irq);
+
+/**
+ * @brief Application marker, shown as USER id value in the timeline
+ */
+void rtos_trace_user(uint8_t id, uint16_t value);
+
+/**
+ * @brief Stop or resume recording, the ring is kept
+ */
+void rtos_trace_enable(uint8_t enable);
+
+void rtos_trace_clear(void);
+
+/**
+ * @brief Print the task table and the ring, oldest record first, with
+ *        printf; recording is paused meanwhile
+ */
+void rtos_trace_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#if (configUSE_RTOS_TRACE == 1)
+#define RTOS_TRACE_ISR_ENTER(irq) rtos_trace_isr_enter((uint8_t)(irq))
+#define RTOS_TRACE_ISR_EXIT(irq)  rtos_trace_isr_exit((uint8_t)(irq))
+#else
+#define RTOS_TRACE_ISR_ENTER(irq)
+#define RTOS_TRACE_ISR_EXIT(irq)
+#endif
+
+#if (configUSE_RTOS_TRACE == 1)
+
+/* The macros expand inside tasks.c and queue.c, the ISR ones inside the
+ * tick handler of the port */
+#ifndef traceTASK_CREATE
+#define traceTASK_CREATE(pxNewTCB)                                             \
+    rtos_trace_task_create((pxNewTCB), (pxNewTCB)->pcTaskName,                 \
+                           (uint8_t)(pxNewTCB)->uxPriority)
+#endif
+
+#ifndef traceTASK_DELETE
+#define traceTASK_DELETE(pxTCB)                                                \
+    rtos_trace_event(RTOS_TRACE_EVT_TASK_DELETE, (pxTCB), 0)
+#endif
+
+#ifndef traceTASK_SWITCHED_IN
+#define traceTASK_SWITCHED_IN()                                                \
+    rtos_trace_task_switched_in(pxCurrentTCB,                                  \
+                                (uint8_t)pxCurrentTCB->uxPriority, xTickCount)
+#endif
+
+#ifndef traceMOVED_TASK_TO_READY_STATE
+#define traceMOVED_TASK_TO_READY_STATE(pxTCB)                                  \
+    rtos_trace_event(RTOS_TRACE_EVT_TASK_READY, (pxTCB),                       \
+                     (uint8_t)(pxTCB)->uxPriority)
+#endif
+
+#ifndef traceTASK_DELAY
+#define traceTASK_DELAY()                                                      \
+    rtos_trace_event(RTOS_TRACE_EVT_TASK_DELAY, pxCurrentTCB, 0)
+#endif
+
+#ifndef traceTASK_DELAY_UNTIL
+#define traceTASK_DELAY_UNTIL(xTimeToWake)                                     \
+    rtos_trace_event(RTOS_TRACE_EVT_TASK_DELAY, pxCurrentTCB, 0)
+#endif
+
+#ifndef traceTASK_NOTIFY
+#define traceTASK_NOTIFY(uxIndexToNotify)                                      \
+    rtos_trace_event(RTOS_TRACE_EVT_TASK_NOTIFY, pxTCB,                        \
+                     (uint8_t)(uxIndexToNotify))
+#endif
+
+#ifndef traceTASK_NOTIFY_FROM_ISR
+#define traceTASK_NOTIFY_FROM_ISR(uxIndexToNotify)                             \
+    rtos_trace_event(RTOS_TRACE_EVT_TASK_NOTIFY_FROM_ISR, pxTCB,               \
+                     (uint8_t)(uxIndexToNotify))
+#endif
+
+#ifndef traceTASK_NOTIFY_GIVE_FROM_ISR
+#define traceTASK_NOTIFY_GIVE_FROM_ISR(uxIndexToNotify)                        \
+    rtos_trace_event(RTOS_TRACE_EVT_TASK_NOTIFY_FROM_ISR, pxTCB,               \
+                     (uint8_t)(uxIndexToNotify))
+#endif
+
+#ifndef traceQUEUE_SEND
+#define traceQUEUE_SEND(pxQueue)                                               \
+    rtos_trace_event(RTOS_TRACE_EVT_QUEUE_SEND, (pxQueue),                     \
+                     (uint8_t)(pxQueue)->uxMessagesWaiting)
+#endif
+
+#ifndef traceQUEUE_SEND_FAILED
+#define traceQUEUE_SEND_FAILED(pxQueue)                                        \
+    rtos_trace_event(RTOS_TRACE_EVT_QUEUE_SEND_FAILED, (pxQueue),              \
+                     (uint8_t)(pxQueue)->uxMessagesWaiting)
+#endif
+
+#ifndef traceQUEUE_SEND_FROM_ISR
+#define traceQUEUE_SEND_FROM_ISR(pxQueue)                                      \
+    rtos_trace_event(RTOS_TRACE_EVT_QUEUE_SEND_FROM_ISR, (pxQueue),            \
+                     (uint8_t)(pxQueue)->uxMessagesWaiting)
+#endif
+
+#ifndef traceQUEUE_SEND_FROM_ISR_FAILED
+#define traceQUEUE_SEND_FROM_ISR_FAILED(pxQueue)                               \
+    rtos_trace_event(RTOS_TRACE_EVT_QUEUE_SEND_FROM_ISR_FAILED, (pxQueue),     \
+                     (uint8_t)(pxQueue)->uxMessagesWaiting)
+#endif
+
+#ifndef traceQUEUE_RECEIVE
+#define traceQUEUE_RECEIVE(pxQueue)                                            \
+    rtos_trace_event(RTOS_TRACE_EVT_QUEUE_RECEIVE, (pxQueue),                  \
+                     (uint8_t)(pxQueue)->uxMessagesWaiting)
+#endif
+
+#ifndef traceQUEUE_RECEIVE_FAILED
+#define traceQUEUE_RECEIVE_FAILED(pxQueue)                                     \
+    rtos_trace_event(RTOS_TRACE_EVT_QUEUE_RECEIVE_FAILED, (pxQueue), 0)
+#endif
+
+#ifndef traceQUEUE_RECEIVE_FROM_ISR
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue)                                   \
+    rtos_trace_event(RTOS_TRACE_EVT_QUEUE_RECEIVE_FROM_ISR, (pxQueue),         \
+                     (uint8_t)(pxQueue)->uxMessagesWaiting)
+#endif
+
+#ifndef traceBLOCKING_ON_QUEUE_SEND
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue)                                   \
+    rtos_trace_event(RTOS_TRACE_EVT_QUEUE_BLOCK_SEND, (pxQueue), 0)
+#endif
+
+#ifndef traceBLOCKING_ON_QUEUE_RECEIVE
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue)                                \
+    rtos_trace_event(RTOS_TRACE_EVT_QUEUE_BLOCK_RECEIVE, (pxQueue), 0)
+#endif
+
+#if (RTOS_TRACE_TICK_ISR == 1)
+#ifndef traceISR_ENTER
+#define traceISR_ENTER() rtos_trace_isr_enter(RTOS_TRACE_IRQ_TICK)
+#endif
+
+#ifndef traceISR_EXIT
+#define traceISR_EXIT() rtos_trace_isr_exit(RTOS_TRACE_IRQ_TICK)
+#endif
+
+#ifndef traceISR_EXIT_TO_SCHEDULER
+#define traceISR_EXIT_TO_SCHEDULER() rtos_trace_isr_exit(RTOS_TRACE_IRQ_TICK)
+#endif
+#endif /* RTOS_TRACE_TICK_ISR */
+
+#endif /* configUSE_RTOS_TRACE */
+
+#endif // __RTOS_TRACE_H
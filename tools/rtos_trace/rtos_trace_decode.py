@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+"""Decode the output of the `trace dump` CLI command into a timeline.
+
+Usage:
+    rtos_trace_decode.py capture.log             timeline, then summary
+    rtos_trace_decode.py --summary capture.log   per-task summary only
+
+The capture may contain other console output, everything between the
+#RTOS_TRACE header and #END is decoded. When several dumps are captured the
+last one is used.
+"""
+
+import argparse
+import sys
+
+EVENTS = [
+    "SYNC",
+    "TASK_CREATE",
+    "TASK_DELETE",
+    "SWITCHED_IN",
+    "READY",
+    "DELAY",
+    "NOTIFY",
+    "NOTIFY_FROM_ISR",
+    "QUEUE_SEND",
+    "QUEUE_SEND_FAILED",
+    "QUEUE_SEND_FROM_ISR",
+    "QUEUE_SEND_FROM_ISR_FAILED",
+    "QUEUE_RECEIVE",
+    "QUEUE_RECEIVE_FAILED",
+    "QUEUE_RECEIVE_FROM_ISR",
+    "QUEUE_BLOCK_SEND",
+    "QUEUE_BLOCK_RECEIVE",
+    "ISR_ENTER",
+    "ISR_EXIT",
+    "USER",
+]
+
+EVT_SYNC = 0
+EVT_SWITCHED_IN = 3
+EVT_READY = 4
+EVT_ISR_ENTER = 17
+EVT_ISR_EXIT = 18
+EVT_USER = 19
+
+IRQ_TICK = 0xFF
+
+
+class Dump:
+    def __init__(self):
+        self.hz = 1
+        self.tick_hz = 1000
+        self.written = 0
+        self.tasks = {}
+        self.records = []
+
+
+def parse(lines):
+    dump = None
+    last = None
+    for line in lines:
+        line = line.strip()
+        if line.startswith("#RTOS_TRACE"):
+            f = line.split()
+            dump = Dump()
+            dump.hz = int(f[2]) or 1
+            dump.tick_hz = int(f[3]) or 1000
+            dump.written = int(f[4])
+        elif dump is None:
+            continue
+        elif line.startswith("#T "):
+            f = line.split(None, 3)
+            dump.tasks[int(f[1], 16)] = f[3] if len(f) > 3 else "?"
+        elif line.startswith("#END"):
+            last = dump
+            dump = None
+        else:
+            for word in line.split():
+                if len(word) != 16:
+                    continue
+                try:
+                    dump.records.append((int(word[0:8], 16), int(word[8:12], 16),
+                                         int(word[12:14], 16), int(word[14:16], 16)))
+                except ValueError:
+                    pass
+    return last
+
+
+def unwrap(records):
+    """Cycle timestamps of consecutive records, made monotonic."""
+    times = []
+    now = 0
+    prev = None
+    for rec in records:
+        if prev is not None:
+            now += (rec[0] - prev) & 0xFFFFFFFF
+        prev = rec[0]
+        times.append(now)
+    return times
+
+
+def name(dump, obj):
+    return dump.tasks.get(obj, "0x%04x" % obj)
+
+
+def timeline(dump, times, out):
+    for t, (_, obj, evt, arg) in zip(times, dump.records):
+        us = t * 1000000.0 / dump.hz
+        evt_name = EVENTS[evt] if evt < len(EVENTS) else "EVT_%d" % evt
+        if evt == EVT_SYNC:
+            tick = obj | (arg << 16)
+            desc = "tick %d, %.0f ms (low 24 bits)" % (tick, tick * 1000.0 / dump.tick_hz)
+        elif evt in (EVT_ISR_ENTER, EVT_ISR_EXIT):
+            desc = "irq tick" if arg == IRQ_TICK else "irq %d" % arg
+        elif evt == EVT_USER:
+            desc = "id %d value %d" % (arg, obj)
+        else:
+            desc = "%s %d" % (name(dump, obj), arg)
+        out.write("%12.1f us  %-26s %s\n" % (us, evt_name, desc))
+
+
+def summary(dump, times, out):
+    run = {}
+    switches = {}
+    latency = {}
+    ready_at = {}
+    counts = {}
+    current = None
+    start = None
+
+    for t, (_, obj, evt, _) in zip(times, dump.records):
+        counts[evt] = counts.get(evt, 0) + 1
+        if evt == EVT_READY:
+            ready_at.setdefault(obj, t)
+        elif evt == EVT_SWITCHED_IN:
+            if current is not None:
+                run[current] = run.get(current, 0) + t - start
+            current, start = obj, t
+            switches[obj] = switches.get(obj, 0) + 1
+            if obj in ready_at:
+                wait = t - ready_at.pop(obj)
+                latency[obj] = max(latency.get(obj, 0), wait)
+    if current is not None and times:
+        run[current] = run.get(current, 0) + times[-1] - start
+
+    span = times[-1] if times else 0
+    out.write("\n%d records of %d written, %.3f ms\n" %
+              (len(dump.records), dump.written, span * 1000.0 / dump.hz))
+    out.write("%-24s %10s %7s %9s %16s\n" %
+              ("task", "run us", "cpu %", "switches", "max ready us"))
+    for obj in sorted(run, key=run.get, reverse=True):
+        out.write("%-24s %10.1f %7.2f %9d %16.1f\n" % (
+            name(dump, obj),
+            run[obj] * 1000000.0 / dump.hz,
+            100.0 * run[obj] / span if span else 0.0,
+            switches.get(obj, 0),
+            latency.get(obj, 0) * 1000000.0 / dump.hz))
+    for evt in sorted(counts):
+        if evt < len(EVENTS) and EVENTS[evt].endswith("FAILED"):
+            out.write("%s: %d\n" % (EVENTS[evt], counts[evt]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture", nargs="?", help="console capture, stdin when omitted")
+    parser.add_argument("--summary", action="store_true", help="per-task summary only")
+    args = parser.parse_args()
+
+    if args.capture:
+        with open(args.capture, errors="replace") as f:
+            dump = parse(f)
+    else:
+        dump = parse(sys.stdin)
+
+    if dump is None:
+        sys.exit("no complete #RTOS_TRACE ... #END block found")
+
+    times = unwrap(dump.records)
+    if not args.summary:
+        timeline(dump, times, sys.stdout)
+    summary(dump, times, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
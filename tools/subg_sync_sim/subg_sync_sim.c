@@ -0,0 +1,464 @@
+/**
+ * @file subg_sync_sim.c
+ * @brief Host simulation of a Sub-GHz star: nodes reporting on free
+ *        running timers with unslotted CSMA-CA, against the same reports
+ *        deferred to the slots of subg_sync.
+ *
+ * The coordinator hears every node; node pairs hidden from each other
+ * do not see each other on CCA. Each node clock has its own offset and
+ * drift, timestamps and timer starts have jitter. Frames are not
+ * acknowledged or retried, a frame overlapping another one at the
+ * coordinator is collided.
+ *
+ * Build and run from the repository root:
+ *   cc -O2 -Iexamples/sub-g/subg-sample/subg-sample/Include \
+ *      tools/subg_sync_sim/subg_sync_sim.c \
+ *      examples/sub-g/subg-sample/subg-sample/subg_sync.c -o subg_sync_sim -lm
+ *   ./subg_sync_sim [-n nodes] [-t seconds] [-p period ms] [-l length]
+ *                   [-h hidden %] [-r] [-S slots] [-L slot ms] [-s seed]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "subg_sync.h"
+
+#define NODE_MAX  128
+#define QUEUE_MAX 4
+
+/* 50 kbit/s FSK as in the sample */
+#define BIT_RATE      50000
+#define OVERHEAD      14 /* preamble, SFD, PHR, FCS */
+#define SHR_OCTETS    10
+#define CCA_US        640
+#define TURNAROUND_US 1000
+#define UNIT_BACKOFF  (CCA_US + TURNAROUND_US)
+#define MIN_BE        3
+#define MAX_BE        5
+#define MAX_BACKOFFS  4
+#define BEACON_MAC    7 /* beacon FCF, DSN, source PAN and address */
+
+#define DRIFT_PPM    40
+#define STAMP_JITTER 20   /* us, TX and RX SFD timestamps */
+#define TIMER_JITTER 1000 /* us, one RTOS tick */
+
+typedef enum { MODE_CSMA = 0, MODE_SLOTTED } mode_t_;
+
+typedef enum { ST_IDLE = 0, ST_SLOT, ST_BACKOFF } state_t;
+
+typedef struct {
+    double start;
+    double end;
+    int src; /* -1 the coordinator */
+    double report;
+    int collided;
+} tx_t;
+
+typedef struct {
+    uint16_t addr;
+    double offset; /* us */
+    double ppm;
+    double phase;  /* local us of the first report */
+    uint64_t reports;
+
+    double queue[QUEUE_MAX];
+    int queued;
+
+    state_t state;
+    double next; /* true time of the next state machine step */
+    int nb;
+    int be;
+
+    subg_sync_t sync;
+} node_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t collided;
+    uint32_t cca_fail;
+    uint32_t overflow;
+    uint32_t beacons;
+    uint32_t beacons_lost;
+    double* latency;
+    uint32_t delivered;
+} result_t;
+
+static int s_nodes = 30;
+static double s_seconds = 600;
+static double s_period_us = 1000000;
+static int s_len = 60;
+static int s_hidden = 20;
+static int s_random_addr;
+static uint32_t s_seed = 1;
+
+static subg_sync_cfg_t s_cfg = {
+    .slot_us = 30000,
+    .slots = 32,
+    .beacon_frames = 4,
+    .lost_beacons = 3,
+    .guard_us = 2000,
+};
+
+static uint8_t s_hear[NODE_MAX][NODE_MAX];
+static node_t s_node[NODE_MAX];
+static tx_t* s_tx;
+static uint32_t s_tx_num;
+static uint32_t s_tx_max;
+static uint32_t s_rng;
+
+static uint32_t rng(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static double rng_unit(void) { return (rng() & 0xffffff) / (double)0x1000000; }
+
+static double airtime_us(int octets) {
+    return (double)(octets + OVERHEAD) * 8 * 1000000 / BIT_RATE;
+}
+
+static uint64_t local_of(const node_t* node, double t) {
+    return (uint64_t)llround(node->offset + t * (1 + node->ppm * 1e-6));
+}
+
+static double true_of(const node_t* node, double local) {
+    return (local - node->offset) / (1 + node->ppm * 1e-6);
+}
+
+static double jitter(double us) { return (rng_unit() * 2 - 1) * us; }
+
+static void tx_add(double start, double end, int src, double report) {
+    if (s_tx_num == s_tx_max) {
+        s_tx_max = s_tx_max ? s_tx_max * 2 : 4096;
+        s_tx = realloc(s_tx, s_tx_max * sizeof(tx_t));
+    }
+    s_tx[s_tx_num++] = (tx_t){start, end, src, report, 0};
+}
+
+/* a transmission audible to node i on air during [t, t + CCA_US] */
+static int channel_busy(int i, double t) {
+    uint32_t k = s_tx_num;
+    double horizon = t - airtime_us(2047);
+
+    while (k--) {
+        const tx_t* tx = &s_tx[k];
+
+        if (tx->start < horizon) {
+            break;
+        }
+        if (tx->start < t + CCA_US && tx->end > t
+            && (tx->src < 0 || s_hear[i][tx->src])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void csma_start(node_t* node, double t) {
+    node->state = ST_BACKOFF;
+    node->nb = 0;
+    node->be = MIN_BE;
+    node->next = t + (rng() % (1U << node->be)) * (double)UNIT_BACKOFF;
+}
+
+static double report_next(const node_t* node) {
+    return true_of(node, node->phase + node->reports * s_period_us);
+}
+
+/* next frame of the queue: now, or at the slot of the node */
+static void frame_start(node_t* node, double t, mode_t_ mode) {
+    uint64_t at;
+
+    if (mode == MODE_SLOTTED
+        && subg_sync_next_slot(&node->sync, local_of(node, t), &at) == 0) {
+        node->state = ST_SLOT;
+        node->next = true_of(node, (double)at) + rng_unit() * TIMER_JITTER;
+        return;
+    }
+    csma_start(node, t);
+}
+
+static int cmp_tx(const void* a, const void* b) {
+    const tx_t* x = a;
+    const tx_t* y = b;
+
+    return x->start < y->start ? -1 : x->start > y->start;
+}
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void beacon_send(subg_sync_t* coord, double t, result_t* res) {
+    uint8_t payload[SUBG_SYNC_BEACON_LEN];
+    double end = t + airtime_us(BEACON_MAC + SUBG_SYNC_BEACON_LEN);
+    double sfd = t + (double)SHR_OCTETS * 8 * 1000000 / BIT_RATE;
+    int busy;
+    int i;
+
+    subg_sync_beacon_build(coord, payload);
+    res->beacons++;
+
+    /* collisions are judged once the run is over, a beacon overlapped by
+     * a frame already on air is missed here */
+    busy = channel_busy(NODE_MAX - 1, t);
+    tx_add(t, end, -1, t);
+    if (busy) {
+        res->beacons_lost++;
+    } else {
+        for (i = 0; i < s_nodes; i++) {
+            subg_sync_beacon_rx(&s_node[i].sync, payload, sizeof(payload),
+                                local_of(&s_node[i], sfd)
+                                    + (uint64_t)llround(
+                                        STAMP_JITTER + jitter(STAMP_JITTER)));
+        }
+    }
+    subg_sync_beacon_sent(coord, true,
+                          (uint64_t)llround(sfd + STAMP_JITTER
+                                            + jitter(STAMP_JITTER)));
+}
+
+static void run(mode_t_ mode, result_t* res) {
+    subg_sync_t coord;
+    double end = s_seconds * 1000000;
+    double t;
+    double beacon_at;
+    uint64_t at;
+    node_t* node;
+    int i, n;
+    uint32_t k;
+
+    memset(res, 0, sizeof(*res));
+    s_tx_num = 0;
+    s_rng = s_seed;
+
+    /* same nodes, clocks and hidden pairs in both modes */
+    for (i = 0; i < s_nodes; i++) {
+        node = &s_node[i];
+        memset(node, 0, sizeof(*node));
+        node->addr = s_random_addr ? (uint16_t)rng() : (uint16_t)(i + 1);
+        node->offset = rng_unit() * 1e9;
+        node->ppm = jitter(DRIFT_PPM);
+        node->phase = node->offset + rng_unit() * s_period_us;
+        node->next = report_next(node);
+        subg_sync_init(&node->sync, &s_cfg, node->addr, false,
+                       local_of(node, 0));
+        for (n = 0; n < i; n++) {
+            s_hear[i][n] = s_hear[n][i] = (int)(rng() % 100) >= s_hidden;
+        }
+        s_hear[i][i] = 1;
+    }
+    /* the coordinator column, heard by all */
+    for (i = 0; i < NODE_MAX; i++) {
+        s_hear[NODE_MAX - 1][i] = 1;
+    }
+
+    subg_sync_init(&coord, &s_cfg, 0, true, 0);
+    subg_sync_next_beacon(&coord, 0, &at);
+    beacon_at = mode == MODE_SLOTTED ? (double)at : end;
+
+    for (;;) {
+        /* earliest event: a report, a CSMA step or a beacon */
+        t = beacon_at;
+        n = -1;
+        for (i = 0; i < s_nodes; i++) {
+            double r = report_next(&s_node[i]);
+            double e = s_node[i].state != ST_IDLE && s_node[i].next < r
+                           ? s_node[i].next
+                           : r;
+
+            if (e < t) {
+                t = e;
+                n = i;
+            }
+        }
+        if (t >= end) {
+            break;
+        }
+
+        if (n < 0) {
+            beacon_send(&coord, t, res);
+            subg_sync_next_beacon(&coord, (uint64_t)t + 1, &at);
+            beacon_at = (double)at;
+            continue;
+        }
+
+        node = &s_node[n];
+        subg_sync_check(&node->sync, local_of(node, t));
+
+        if (report_next(node) <= t) {
+            node->reports++;
+            if (node->queued == QUEUE_MAX) {
+                res->overflow++;
+                continue;
+            }
+            node->queue[node->queued++] = t;
+            if (node->state == ST_IDLE) {
+                frame_start(node, t, mode);
+            }
+            continue;
+        }
+
+        /* CSMA from the slot start, then one CCA after each backoff */
+        if (node->state == ST_SLOT) {
+            csma_start(node, t);
+            continue;
+        }
+        if (!channel_busy(n, t)) {
+            double start = t + CCA_US + TURNAROUND_US;
+
+            tx_add(start, start + airtime_us(s_len), n, node->queue[0]);
+            res->frames++;
+            node->state = ST_IDLE;
+        } else if (++node->nb > MAX_BACKOFFS) {
+            res->frames++;
+            res->cca_fail++;
+            node->state = ST_IDLE;
+        } else {
+            node->be = node->be < MAX_BE ? node->be + 1 : MAX_BE;
+            node->next = t + (rng() % (1U << node->be)) * (double)UNIT_BACKOFF;
+            continue;
+        }
+
+        memmove(&node->queue[0], &node->queue[1],
+                --node->queued * sizeof(node->queue[0]));
+        if (node->queued) {
+            /* the next one waits for the end of this frame */
+            frame_start(node, t + CCA_US + TURNAROUND_US + airtime_us(s_len),
+                        mode);
+        }
+    }
+
+    /* overlaps at the coordinator */
+    qsort(s_tx, s_tx_num, sizeof(tx_t), cmp_tx);
+    for (k = 0; k < s_tx_num; k++) {
+        uint32_t j;
+
+        for (j = k + 1; j < s_tx_num && s_tx[j].start < s_tx[k].end; j++) {
+            s_tx[k].collided = s_tx[j].collided = 1;
+        }
+    }
+
+    res->latency = malloc((s_tx_num + 1) * sizeof(double));
+    for (k = 0; k < s_tx_num; k++) {
+        if (s_tx[k].src < 0) {
+            continue;
+        }
+        if (s_tx[k].collided) {
+            res->collided++;
+        } else {
+            res->latency[res->delivered++] = s_tx[k].end - s_tx[k].report;
+        }
+    }
+    qsort(res->latency, res->delivered, sizeof(double), cmp_double);
+
+    if (mode == MODE_SLOTTED) {
+        int32_t error_max = 0;
+        uint32_t unsynced = 0;
+        uint32_t lost = 0;
+
+        for (i = 0; i < s_nodes; i++) {
+            if (!s_node[i].sync.synced) {
+                unsynced++;
+            }
+            lost += s_node[i].sync.lost;
+            if ((int32_t)s_node[i].sync.error_max_us > error_max) {
+                error_max = s_node[i].sync.error_max_us;
+            }
+        }
+        printf("sync: %lu beacons, %lu missed, worst error %ld us, "
+               "%lu nodes unsynchronised at the end, %lu losses\n",
+               (unsigned long)res->beacons, (unsigned long)res->beacons_lost,
+               (long)error_max, (unsigned long)unsynced, (unsigned long)lost);
+    }
+}
+
+static double pct(const result_t* res, int p) {
+    uint32_t k;
+
+    if (!res->delivered) {
+        return 0;
+    }
+    k = (uint32_t)((uint64_t)res->delivered * p / 100);
+    return res->latency[k < res->delivered ? k : res->delivered - 1] / 1000;
+}
+
+static void print_result(const char* name, const result_t* res) {
+    double sum = 0;
+    uint32_t k;
+
+    for (k = 0; k < res->delivered; k++) {
+        sum += res->latency[k];
+    }
+    printf("%-8s %7lu %8.2f%% %8.2f%% %8lu %8.1f %8.1f %8.1f %8.1f\n", name,
+           (unsigned long)res->frames,
+           res->frames ? 100.0 * res->collided / res->frames : 0,
+           res->frames ? 100.0 * res->cca_fail / res->frames : 0,
+           (unsigned long)res->overflow,
+           res->delivered ? sum / res->delivered / 1000 : 0, pct(res, 50),
+           pct(res, 99),
+           res->delivered ? res->latency[res->delivered - 1] / 1000 : 0);
+}
+
+int main(int argc, char** argv) {
+    result_t csma;
+    result_t slotted;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:t:p:l:h:rS:L:s:")) != -1) {
+        switch (opt) {
+            case 'n': s_nodes = atoi(optarg); break;
+            case 't': s_seconds = atof(optarg); break;
+            case 'p': s_period_us = atof(optarg) * 1000; break;
+            case 'l': s_len = atoi(optarg); break;
+            case 'h': s_hidden = atoi(optarg); break;
+            case 'r': s_random_addr = 1; break;
+            case 'S': s_cfg.slots = (uint16_t)atoi(optarg); break;
+            case 'L': s_cfg.slot_us = (uint32_t)(atof(optarg) * 1000); break;
+            case 's': s_seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr,
+                        "usage: %s [-n nodes] [-t seconds] [-p period ms] "
+                        "[-l length] [-h hidden %%] [-r] [-S slots] "
+                        "[-L slot ms] [-s seed]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+    if (s_nodes < 1 || s_nodes >= NODE_MAX || s_seed == 0 || s_cfg.slots < 2
+        || s_cfg.slot_us == 0) {
+        fprintf(stderr, "1 to %d nodes, 2 slots or more, seed not 0\n",
+                NODE_MAX - 1);
+        return 1;
+    }
+
+    printf("%d nodes, %d byte frames every %.0f ms for %.0f s, %d%% hidden "
+           "pairs, %s addresses\n",
+           s_nodes, s_len, s_period_us / 1000, s_seconds, s_hidden,
+           s_random_addr ? "random" : "consecutive");
+    printf("slots: %lu x %lu us, beacon every %u slotframes, guard %u us\n",
+           (unsigned long)s_cfg.slots, (unsigned long)s_cfg.slot_us,
+           s_cfg.beacon_frames, s_cfg.guard_us);
+
+    run(MODE_CSMA, &csma);
+    run(MODE_SLOTTED, &slotted);
+
+    printf("%-8s %7s %9s %9s %8s %8s %8s %8s %8s\n", "mode", "frames",
+           "collided", "cca fail", "overflow", "avg ms", "p50 ms", "p99 ms",
+           "max ms");
+    print_result("csma", &csma);
+    print_result("slotted", &slotted);
+
+    free(csma.latency);
+    free(slotted.latency);
+    free(s_tx);
+    return 0;
+}